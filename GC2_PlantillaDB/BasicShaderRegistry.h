@@ -0,0 +1,441 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "ShaderPack.h"
+
+// Handle a un programa (VS + PS + input layout) guardado en el registro.
+using ShaderProgramHandle = uint32_t;
+static const ShaderProgramHandle INVALID_SHADER_PROGRAM = 0xFFFFFFFFu;
+
+// Contadores para comprobar que no se duplican lecturas ni objetos del dispositivo.
+struct ShaderRegistryStats
+{
+    int packLookups = 0; // Blobs servidos desde Shaders.pack
+    int blobReads = 0;   // .cso sueltos leidos del disco (si no hay paquete)
+    int vertexShadersCreated = 0;
+    int pixelShadersCreated = 0;
+    int inputLayoutsCreated = 0;
+    int constantBuffersCreated = 0;
+    int programsCreated = 0;
+    int programRequests = 0;
+};
+
+// FNV-1a de 64 bits sobre el contenido de un input layout (la semantica por sus caracteres, no por
+// su puntero). InputElement tiene los campos de D3D11_INPUT_ELEMENT_DESC.
+template <typename InputElement>
+uint64_t HashInputLayoutElements(const InputElement* elements, uint32_t elementCount)
+{
+    uint64_t hash = 14695981039346656037ull;
+    auto hashBytes = [&hash](const void* data, size_t size)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+    };
+    auto hashValue = [&hashBytes](const auto& value) { hashBytes(&value, sizeof(value)); };
+
+    hashValue(elementCount);
+    for (uint32_t i = 0; i < elementCount; ++i)
+    {
+        const InputElement& e = elements[i];
+        if (e.SemanticName) hashBytes(e.SemanticName, strlen(e.SemanticName));
+        hashValue(e.SemanticIndex);
+        hashValue(e.Format);
+        hashValue(e.InputSlot);
+        hashValue(e.AlignedByteOffset);
+        hashValue(e.InputSlotClass);
+        hashValue(e.InstanceDataStepRate);
+    }
+    return hash;
+}
+
+// Lo que el registro necesita del dispositivo, como tipos y miembros de 'Device':
+//   VertexShader, PixelShader, InputLayout, Buffer   objetos del dispositivo
+//   Ref<T>                                           referencia que los mantiene vivos, con Get()
+//   InputElement                                     campos de D3D11_INPUT_ELEMENT_DESC
+//   bool CreateVertexShader(const void* bytecode, size_t size, Ref<VertexShader>& out)
+//   bool CreatePixelShader(const void* bytecode, size_t size, Ref<PixelShader>& out)
+//   bool CreateInputLayout(const InputElement*, uint32_t count, const void* vsBytecode, size_t vsSize, Ref<InputLayout>& out)
+//   bool CreateConstantBuffer(uint32_t byteWidth, Ref<Buffer>& out)
+//   void ReportError(const std::wstring& message)
+// ShaderRegistry lo instancia con ID3D11Device; las pruebas, con un dispositivo que solo cuenta.
+template <typename Device>
+struct BasicShaderProgram
+{
+    typename Device::template Ref<typename Device::VertexShader> vertexShader;
+    typename Device::template Ref<typename Device::PixelShader> pixelShader; // Puede ser nullptr (solo profundidad)
+    typename Device::template Ref<typename Device::InputLayout> inputLayout;
+};
+
+// Registro compartido de shaders.
+// Los shaders se piden por nombre ("EvolvingVS"). Se buscan primero en Shaders.pack y,
+// si no hay paquete, en el .cso suelto del directorio de shaders; cada blob se lee una
+// sola vez y cada VS/PS se crea una sola vez por bytecode distinto (dos nombres con el mismo
+// blob comparten objeto). Los input layouts se reutilizan por el hash de sus elementos, y los
+// modelos guardan un ShaderProgramHandle en lugar de sus propias copias.
+template <typename Device>
+class BasicShaderRegistry
+{
+public:
+    template <typename T> using Ref = typename Device::template Ref<T>;
+    using VertexShader = typename Device::VertexShader;
+    using PixelShader = typename Device::PixelShader;
+    using InputLayout = typename Device::InputLayout;
+    using Buffer = typename Device::Buffer;
+    using InputElement = typename Device::InputElement;
+    using Program = BasicShaderProgram<Device>;
+
+    BasicShaderRegistry(Device device, std::filesystem::path shaderDirectory) :
+        m_device(std::move(device)),
+        m_shaderDirectory(std::move(shaderDirectory))
+    {
+    }
+
+    // Carga el paquete de shaders con una sola lectura. false si no existe (se usan los .cso sueltos).
+    bool LoadShaderPack(const std::filesystem::path& packPath)
+    {
+        if (!m_shaderPack.LoadFromFile(packPath))
+        {
+            m_device.ReportError(L"SHADER_REGISTRY::Shader pack not found or invalid, using loose .cso files: " + packPath.wstring());
+            return false;
+        }
+        return true;
+    }
+
+    // Directorio de los .cso sueltos.
+    void SetShaderDirectory(const std::filesystem::path& directory) { m_shaderDirectory = directory; }
+
+    // Devuelve el programa ya existente si coincide (VS, PS y layout) o crea uno nuevo.
+    // psName vacio = programa sin pixel shader. INVALID_SHADER_PROGRAM si algo falla.
+    ShaderProgramHandle LoadProgram(const std::wstring& vsName, const std::wstring& psName,
+        const InputElement* elements, uint32_t elementCount)
+    {
+        m_stats.programRequests++;
+
+        // La clave incluye el hash del layout para que el mismo par VS/PS con otro layout sea otro programa
+        std::wstring key = vsName + L"|" + psName + L"|" + std::to_wstring(HashInputLayout(elements, elementCount));
+        auto it = m_programLookup.find(key);
+        if (it != m_programLookup.end()) return it->second;
+
+        Program program;
+        const Ref<VertexShader>* vertexShader = FindVertexShader(vsName);
+        if (!vertexShader) return INVALID_SHADER_PROGRAM;
+        program.vertexShader = *vertexShader;
+
+        const Ref<InputLayout>* inputLayout = FindInputLayout(elements, elementCount, vsName);
+        if (!inputLayout) return INVALID_SHADER_PROGRAM;
+        program.inputLayout = *inputLayout;
+
+        if (!psName.empty())
+        {
+            const Ref<PixelShader>* pixelShader = FindPixelShader(psName);
+            if (!pixelShader) return INVALID_SHADER_PROGRAM;
+            program.pixelShader = *pixelShader;
+        }
+
+        ShaderProgramHandle handle = static_cast<ShaderProgramHandle>(m_programs.size());
+        m_programs.push_back(std::move(program));
+        m_programLookup.emplace(std::move(key), handle);
+        m_stats.programsCreated++;
+        return handle;
+    }
+
+    const Program* GetProgram(ShaderProgramHandle handle) const
+    {
+        if (handle >= m_programs.size()) return nullptr;
+        return &m_programs[handle];
+    }
+
+    VertexShader* GetVertexShader(const std::wstring& name)
+    {
+        const Ref<VertexShader>* shader = FindVertexShader(name);
+        return shader ? shader->Get() : nullptr;
+    }
+
+    PixelShader* GetPixelShader(const std::wstring& name)
+    {
+        const Ref<PixelShader>* shader = FindPixelShader(name);
+        return shader ? shader->Get() : nullptr;
+    }
+
+    // El layout se valida contra la firma de entrada del VS indicado la primera vez que se crea.
+    InputLayout* GetInputLayout(const InputElement* elements, uint32_t elementCount, const std::wstring& vsName)
+    {
+        const Ref<InputLayout>* layout = FindInputLayout(elements, elementCount, vsName);
+        return layout ? layout->Get() : nullptr;
+    }
+
+    // Constant buffer dinamico compartido por nombre (se actualiza con MAP_WRITE_DISCARD antes de cada draw).
+    Buffer* GetConstantBuffer(const std::string& name, uint32_t byteWidth)
+    {
+        auto it = m_constantBuffers.find(name);
+        if (it != m_constantBuffers.end())
+        {
+            if (it->second.byteWidth != byteWidth)
+            {
+                m_device.ReportError(L"ERROR::SHADER_REGISTRY::Constant buffer requested with a different size.");
+                return nullptr;
+            }
+            return it->second.buffer.Get();
+        }
+
+        ConstantBufferEntry entry;
+        entry.byteWidth = byteWidth;
+        if (!m_device.CreateConstantBuffer(byteWidth, entry.buffer))
+        {
+            m_device.ReportError(L"ERROR::SHADER_REGISTRY::Failed to create constant buffer.");
+            return nullptr;
+        }
+
+        m_stats.constantBuffersCreated++;
+        Buffer* result = entry.buffer.Get();
+        m_constantBuffers.emplace(name, std::move(entry));
+        return result;
+    }
+
+    // Libera todo (p.ej. al perder el dispositivo). Los handles anteriores dejan de ser validos.
+    void Clear()
+    {
+        m_programs.clear();
+        m_programLookup.clear();
+        m_constantBuffers.clear();
+        m_inputLayouts.clear();
+        m_pixelShaders.clear();
+        m_vertexShaders.clear();
+        m_blobs.clear();
+        m_stats = ShaderRegistryStats();
+    }
+
+    const ShaderRegistryStats& GetStats() const { return m_stats; }
+    Device& GetDevice() { return m_device; }
+
+    static uint64_t HashInputLayout(const InputElement* elements, uint32_t elementCount)
+    {
+        return HashInputLayoutElements(elements, elementCount);
+    }
+
+private:
+    // Bytecode de un shader: apunta dentro del paquete o a los bytes leidos del .cso
+    struct ShaderBlob
+    {
+        const void* data = nullptr;
+        size_t size = 0;
+        uint64_t contentHash = 0;
+        std::vector<uint8_t> fileData;
+    };
+
+    // Un objeto por bytecode distinto; el blob de referencia sirve para descartar colisiones del hash
+    template <typename T>
+    struct ShaderEntry
+    {
+        const ShaderBlob* blob = nullptr;
+        Ref<T> shader;
+    };
+
+    template <typename T>
+    struct ShaderCache
+    {
+        std::unordered_map<std::wstring, Ref<T>> byName;
+        std::unordered_map<uint64_t, std::vector<ShaderEntry<T>>> byContent;
+
+        void clear()
+        {
+            byName.clear();
+            byContent.clear();
+        }
+    };
+
+    // Copia de un elemento con el nombre de la semantica guardado (el desc solo tiene el puntero)
+    struct LayoutElement
+    {
+        std::string semanticName;
+        InputElement desc;
+    };
+
+    struct LayoutEntry
+    {
+        std::vector<LayoutElement> elements;
+        Ref<InputLayout> layout;
+    };
+
+    struct ConstantBufferEntry
+    {
+        Ref<Buffer> buffer;
+        uint32_t byteWidth = 0;
+    };
+
+    static uint64_t HashBytes(const void* data, size_t size)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    static bool SameLayout(const LayoutEntry& entry, const InputElement* elements, uint32_t elementCount)
+    {
+        if (entry.elements.size() != elementCount) return false;
+
+        for (uint32_t i = 0; i < elementCount; ++i)
+        {
+            const InputElement& a = entry.elements[i].desc;
+            const InputElement& b = elements[i];
+            if (entry.elements[i].semanticName != (b.SemanticName ? b.SemanticName : "") ||
+                a.SemanticIndex != b.SemanticIndex || a.Format != b.Format ||
+                a.InputSlot != b.InputSlot || a.AlignedByteOffset != b.AlignedByteOffset ||
+                a.InputSlotClass != b.InputSlotClass || a.InstanceDataStepRate != b.InstanceDataStepRate)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const ShaderBlob* LoadBlob(const std::wstring& name)
+    {
+        auto it = m_blobs.find(name);
+        if (it != m_blobs.end()) return &it->second;
+
+        ShaderBlob blob;
+        if (m_shaderPack.IsLoaded() && m_shaderPack.Find(name, blob.data, blob.size))
+        {
+            m_stats.packLookups++;
+        }
+        else
+        {
+            // Sin paquete (o shader nuevo aun no empaquetado): leer el .cso suelto
+            std::filesystem::path filePath = m_shaderDirectory / (name + L".cso");
+            std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+            std::streamoff fileSize = file ? static_cast<std::streamoff>(file.tellg()) : std::streamoff(-1);
+            if (fileSize > 0)
+            {
+                blob.fileData.resize(static_cast<size_t>(fileSize));
+                file.seekg(0, std::ios::beg);
+                if (!file.read(reinterpret_cast<char*>(blob.fileData.data()), fileSize)) blob.fileData.clear();
+            }
+            if (blob.fileData.empty())
+            {
+                m_device.ReportError(L"ERROR::SHADER_REGISTRY::Failed to load shader: " + filePath.wstring());
+                return nullptr;
+            }
+            m_stats.blobReads++;
+        }
+
+        ShaderBlob& stored = m_blobs.emplace(name, std::move(blob)).first->second;
+        if (!stored.fileData.empty())
+        {
+            stored.data = stored.fileData.data();
+            stored.size = stored.fileData.size();
+        }
+        stored.contentHash = HashBytes(stored.data, stored.size);
+        return &stored;
+    }
+
+    template <typename T, typename Create>
+    const Ref<T>* FindShader(ShaderCache<T>& cache, const std::wstring& name, Create create, int& createdCount,
+        const wchar_t* kind)
+    {
+        auto it = cache.byName.find(name);
+        if (it != cache.byName.end()) return &it->second;
+
+        const ShaderBlob* blob = LoadBlob(name);
+        if (!blob) return nullptr;
+
+        std::vector<ShaderEntry<T>>& bucket = cache.byContent[blob->contentHash];
+        for (const ShaderEntry<T>& entry : bucket)
+        {
+            if (entry.blob->size == blob->size && memcmp(entry.blob->data, blob->data, blob->size) == 0)
+            {
+                return &cache.byName.emplace(name, entry.shader).first->second;
+            }
+        }
+
+        ShaderEntry<T> entry;
+        entry.blob = blob;
+        if (!create(blob->data, blob->size, entry.shader))
+        {
+            m_device.ReportError(std::wstring(L"ERROR::SHADER_REGISTRY::Failed to create ") + kind + L": " + name);
+            return nullptr;
+        }
+
+        createdCount++;
+        bucket.push_back(entry);
+        return &cache.byName.emplace(name, entry.shader).first->second;
+    }
+
+    const Ref<VertexShader>* FindVertexShader(const std::wstring& name)
+    {
+        return FindShader(m_vertexShaders, name,
+            [this](const void* data, size_t size, Ref<VertexShader>& out) { return m_device.CreateVertexShader(data, size, out); },
+            m_stats.vertexShadersCreated, L"Vertex Shader");
+    }
+
+    const Ref<PixelShader>* FindPixelShader(const std::wstring& name)
+    {
+        return FindShader(m_pixelShaders, name,
+            [this](const void* data, size_t size, Ref<PixelShader>& out) { return m_device.CreatePixelShader(data, size, out); },
+            m_stats.pixelShadersCreated, L"Pixel Shader");
+    }
+
+    const Ref<InputLayout>* FindInputLayout(const InputElement* elements, uint32_t elementCount, const std::wstring& vsName)
+    {
+        uint64_t hash = HashInputLayout(elements, elementCount);
+        std::vector<LayoutEntry>& bucket = m_inputLayouts[hash];
+        for (const LayoutEntry& entry : bucket)
+        {
+            if (SameLayout(entry, elements, elementCount)) return &entry.layout;
+        }
+
+        // Primera vez: se necesita el bytecode del VS para validar la firma de entrada
+        const ShaderBlob* vsBlob = LoadBlob(vsName);
+        if (!vsBlob) return nullptr;
+
+        LayoutEntry entry;
+        if (!m_device.CreateInputLayout(elements, elementCount, vsBlob->data, vsBlob->size, entry.layout))
+        {
+            m_device.ReportError(L"ERROR::SHADER_REGISTRY::Failed to create Input Layout for: " + vsName);
+            return nullptr;
+        }
+
+        entry.elements.resize(elementCount);
+        for (uint32_t i = 0; i < elementCount; ++i)
+        {
+            entry.elements[i].semanticName = elements[i].SemanticName ? elements[i].SemanticName : "";
+            entry.elements[i].desc = elements[i];
+            entry.elements[i].desc.SemanticName = nullptr; // El nombre vive en semanticName
+        }
+
+        m_stats.inputLayoutsCreated++;
+        bucket.push_back(std::move(entry));
+        return &bucket.back().layout;
+    }
+
+    Device m_device;
+    ShaderPack m_shaderPack;
+    std::filesystem::path m_shaderDirectory;
+
+    std::unordered_map<std::wstring, ShaderBlob> m_blobs;
+    ShaderCache<VertexShader> m_vertexShaders;
+    ShaderCache<PixelShader> m_pixelShaders;
+    std::unordered_map<uint64_t, std::vector<LayoutEntry>> m_inputLayouts;
+    std::unordered_map<std::string, ConstantBufferEntry> m_constantBuffers;
+
+    std::vector<Program> m_programs;
+    std::unordered_map<std::wstring, ShaderProgramHandle> m_programLookup;
+
+    ShaderRegistryStats m_stats;
+};
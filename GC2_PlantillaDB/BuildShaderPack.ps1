@@ -0,0 +1,74 @@
+# BuildShaderPack.ps1
+# Junta todos los .cso compilados de $InputDir en un solo Shaders.pack (ver ShaderPack.h).
+# Se ejecuta como evento posterior a la compilacion del proyecto.
+
+param(
+    [Parameter(Mandatory = $true)][string]$InputDir,
+    [Parameter(Mandatory = $true)][string]$Output
+)
+
+$ErrorActionPreference = 'Stop'
+Add-Type -AssemblyName System.Numerics
+
+$fnvOffset = [System.Numerics.BigInteger]::Parse('14695981039346656037')
+$fnvPrime = [System.Numerics.BigInteger]::Parse('1099511628211')
+$mod64 = [System.Numerics.BigInteger]::Pow(2, 64)
+
+# FNV-1a de 64 bits sobre el nombre en minusculas (igual que ShaderPack::HashName)
+function Get-NameHash([string]$name) {
+    $hash = $fnvOffset
+    foreach ($b in [System.Text.Encoding]::ASCII.GetBytes($name.ToLowerInvariant())) {
+        $hash = $hash -bxor $b
+        $hash = [System.Numerics.BigInteger]::Remainder($hash * $fnvPrime, $mod64)
+    }
+    return [uint64]$hash
+}
+
+$files = Get-ChildItem -Path $InputDir -Filter '*.cso' -File
+if ($files.Count -eq 0) {
+    Write-Error "No se encontraron .cso en $InputDir"
+}
+
+$entries = foreach ($f in $files) {
+    [pscustomobject]@{
+        Name = $f.BaseName
+        Hash = Get-NameHash $f.BaseName
+        Data = [System.IO.File]::ReadAllBytes($f.FullName)
+    }
+}
+$entries = @($entries | Sort-Object -Property Hash)
+
+for ($i = 1; $i -lt $entries.Count; $i++) {
+    if ($entries[$i].Hash -eq $entries[$i - 1].Hash) {
+        Write-Error "Hash repetido entre $($entries[$i - 1].Name) y $($entries[$i].Name)"
+    }
+}
+
+$headerSize = 16
+$entrySize = 16
+$offset = $headerSize + $entrySize * $entries.Count
+
+$stream = [System.IO.File]::Create($Output)
+$writer = New-Object System.IO.BinaryWriter($stream)
+try {
+    $writer.Write([uint32]0x4B415053) # 'SPAK'
+    $writer.Write([uint32]1)
+    $writer.Write([uint32]$entries.Count)
+    $writer.Write([uint32]0)
+
+    foreach ($e in $entries) {
+        $writer.Write([uint64]$e.Hash)
+        $writer.Write([uint32]$offset)
+        $writer.Write([uint32]$e.Data.Length)
+        $offset += $e.Data.Length
+    }
+
+    foreach ($e in $entries) {
+        $writer.Write($e.Data)
+    }
+}
+finally {
+    $writer.Close()
+}
+
+Write-Host "Shader pack: $($entries.Count) shaders -> $Output"
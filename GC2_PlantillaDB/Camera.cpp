@@ -1,11 +1,35 @@
 // Camera.cpp
-#include "pch.h" 
 #include "Camera.h"
 #include <algorithm> 
+#include <cmath>
 
-// Usar DirectX::SimpleMath directamente para evitar ambigedades si hay otros Vector3, etc.
-using DirectX::SimpleMath::Vector3;
-using DirectX::SimpleMath::Matrix;
+using DirectX::XMFLOAT3;
+using DirectX::XMFLOAT4;
+using DirectX::XMFLOAT4X4;
+
+namespace
+{
+    float Dot(const XMFLOAT3& a, const XMFLOAT3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+    XMFLOAT3 MultiplyAdd(const XMFLOAT3& a, const XMFLOAT3& b, float s)
+    {
+        return XMFLOAT3(a.x + b.x * s, a.y + b.y * s, a.z + b.z * s);
+    }
+
+    XMFLOAT4X4 Multiply(const XMFLOAT4X4& a, const XMFLOAT4X4& b)
+    {
+        XMFLOAT4X4 r;
+        for (int row = 0; row < 4; ++row)
+        {
+            for (int column = 0; column < 4; ++column)
+            {
+                r.m[row][column] = a.m[row][0] * b.m[0][column] + a.m[row][1] * b.m[1][column] +
+                    a.m[row][2] * b.m[2][column] + a.m[row][3] * b.m[3][column];
+            }
+        }
+        return r;
+    }
+}
 
 // Constructor
 Camera::Camera(int screenWidth, int screenHeight)
@@ -14,17 +38,19 @@ Camera::Camera(int screenWidth, int screenHeight)
     m_pitch(0.0f),
     m_fieldOfView(DirectX::XM_PIDIV4), // 45 grados
     m_nearPlane(1.0f),
-    m_farPlane(5000.0f)
+    m_farPlane(5000.0f),
+    m_reversedZ(false)
 {
     UpdateProjectionMatrix(screenWidth, screenHeight);
-    UpdateViewMatrix(); // Calcula m_forward, m_right, m_up y m_viewMatrix iniciales
+    UpdateOrientation(); // Calcula m_forward, m_right, m_up iniciales
+    InvalidateView();
 }
 
 // Establecer posicin
-void Camera::SetPosition(const Vector3& position)
+void Camera::SetPosition(const XMFLOAT3& position)
 {
     m_position = position;
-    UpdateViewMatrix();
+    InvalidateView();
 }
 
 // Establecer rotacin (yaw y pitch en radianes)
@@ -36,27 +62,26 @@ void Camera::SetRotation(float yaw, float pitch)
     // Restringir pitch para evitar que la cmara se voltee
     m_pitch = std::clamp(m_pitch, -DirectX::XM_PIDIV2 + 0.001f, DirectX::XM_PIDIV2 - 0.001f);
 
-    UpdateViewMatrix();
+    UpdateOrientation();
+    InvalidateView();
 }
 
 // Mover en coordenadas del mundo
-void Camera::Move(const Vector3& translation)
+void Camera::Move(const XMFLOAT3& translation)
 {
-    m_position += translation;
-    UpdateViewMatrix();
+    m_position = MultiplyAdd(m_position, translation, 1.0f);
+    InvalidateView();
 }
 
 // Moverse relativo a la orientacin de la cmara
-void Camera::MoveRelative(const Vector3& translation)
+void Camera::MoveRelative(const XMFLOAT3& translation)
 {
-    // Nota: m_forward, m_right, y m_up deben estar actualizados por UpdateViewMatrix
-    // antes de que se llame a esta funcin si la rotacin ha cambiado justo antes.
-    // Sin embargo, como UpdateViewMatrix se llama al final de Rotate(), esto est bien.
+    // m_forward, m_right y m_up se actualizan en cuanto cambia la rotacin (UpdateOrientation)
 
-    m_position += translation.x * m_right;
-    m_position += translation.y * m_up;     // Movimiento vertical local
-    m_position += translation.z * m_forward;
-    UpdateViewMatrix();
+    m_position = MultiplyAdd(m_position, m_right, translation.x);
+    m_position = MultiplyAdd(m_position, m_up, translation.y);     // Movimiento vertical local
+    m_position = MultiplyAdd(m_position, m_forward, translation.z);
+    InvalidateView();
 }
 
 // Rotar la cmara (deltas en radianes)
@@ -74,30 +99,28 @@ void Camera::Rotate(float yawDelta, float pitchDelta)
     // Restringir pitch para evitar que la cmara se voltee
     m_pitch = std::clamp(m_pitch, -DirectX::XM_PIDIV2 + 0.001f, DirectX::XM_PIDIV2 - 0.001f);
 
-    UpdateViewMatrix();
+    UpdateOrientation();
+    InvalidateView();
 }
 
-// Actualizar la matriz de vista
-void Camera::UpdateViewMatrix()
+// Vectores de direccin a partir de yaw y pitch (MoveRelative y los getters los usan directamente)
+void Camera::UpdateOrientation()
 {
-    // 1. Crear la matriz de rotacin a partir de yaw y pitch.
-    Matrix rotationMatrix = Matrix::CreateFromYawPitchRoll(m_yaw, m_pitch, 0.0f);
-
-    // 2. An es necesario actualizar los vectores m_forward, m_right, m_up
-    //    porque otras partes del cdigo (como MoveRelative) los usan.
-    m_forward = Vector3::TransformNormal(WORLD_FORWARD, rotationMatrix);
-    m_right = Vector3::TransformNormal(WORLD_RIGHT, rotationMatrix);
-    m_up = Vector3::TransformNormal(WORLD_UP, rotationMatrix);
-
-    // 3. Construir la matriz de mundo de la cmara (su posicin y orientacin en el mundo).
-    //    El orden es Rotacin * Traslacin.
-    Matrix translationMatrix = Matrix::CreateTranslation(m_position);
-    Matrix cameraWorldMatrix = rotationMatrix * translationMatrix;
+    // Filas de Matrix::CreateFromYawPitchRoll(yaw, pitch, 0) = RotationX(pitch) * RotationY(yaw):
+    // los ejes X, Y y Z del mundo girados. Otras partes del cdigo (como MoveRelative) los usan.
+    const float sy = std::sin(m_yaw), cy = std::cos(m_yaw);
+    const float sp = std::sin(m_pitch), cp = std::cos(m_pitch);
+    m_right = XMFLOAT3(cy, 0.0f, -sy);
+    m_up = XMFLOAT3(sp * sy, cp, sp * cy);
+    m_forward = XMFLOAT3(cp * sy, -sp, cp * cy);
+}
 
-    // 4. La matriz de vista es la INVERSA de la matriz de mundo de la cmara.
-    //    Esto transforma todo el mundo para que la cmara est en el origen, mirando hacia adelante.
-    //    Este mtodo es el ms estable y directo.
-    m_viewMatrix = cameraWorldMatrix.Invert();
+void Camera::InvalidateView()
+{
+    m_viewDirty = true;
+    m_viewProjectionDirty = true;
+    m_inverseViewDirty = true;
+    m_frustumDirty = true;
 }
 
 // Actualizar la matriz de proyeccin
@@ -108,42 +131,135 @@ void Camera::UpdateProjectionMatrix(int screenWidth, int screenHeight)
         screenHeight = 1;
     }
     m_aspectRatio = static_cast<float>(screenWidth) / static_cast<float>(screenHeight);
+    RebuildProjection();
+}
 
-    m_projectionMatrix = Matrix::CreatePerspectiveFieldOfView(
-        m_fieldOfView,
-        m_aspectRatio,
-        m_nearPlane,
-        m_farPlane
-    );
+void Camera::RebuildProjection()
+{
+    // Como Matrix::CreatePerspectiveFieldOfView (mano derecha, z de D3D en [0, 1])
+    const float yScale = 1.0f / std::tan(0.5f * m_fieldOfView);
+    m_cullProjectionMatrix = XMFLOAT4X4();
+    m_cullProjectionMatrix._11 = yScale / m_aspectRatio;
+    m_cullProjectionMatrix._22 = yScale;
+    m_cullProjectionMatrix._33 = m_farPlane / (m_nearPlane - m_farPlane);
+    m_cullProjectionMatrix._34 = -1.0f;
+    m_cullProjectionMatrix._43 = m_nearPlane * m_farPlane / (m_nearPlane - m_farPlane);
+
+    m_projectionMatrix = m_cullProjectionMatrix;
+    if (m_reversedZ)
+    {
+        // Limite de la perspectiva RH con far -> infinito e intercambiando cerca/lejos:
+        // z_clip = near, w_clip = -z_vista, asi que profundidad = near / distancia
+        m_projectionMatrix._33 = 0.0f;
+        m_projectionMatrix._43 = m_nearPlane;
+    }
+    m_viewProjectionDirty = true;
+    m_frustumDirty = true;
+}
+
+void Camera::SetReversedZ(bool enabled)
+{
+    m_reversedZ = enabled;
+    RebuildProjection();
 }
 
 // Getters
-const Matrix& Camera::GetViewMatrix() const
+const XMFLOAT4X4& Camera::GetViewMatrix() const
 {
+    if (m_viewDirty)
+    {
+        // La cmara es rgida: la inversa de (rotacin * traslacin) es la traspuesta de la rotacin
+        // (columnas = ejes de la cmara) con la posicin proyectada sobre esos ejes
+        m_viewMatrix = XMFLOAT4X4(
+            m_right.x, m_up.x, m_forward.x, 0.0f,
+            m_right.y, m_up.y, m_forward.y, 0.0f,
+            m_right.z, m_up.z, m_forward.z, 0.0f,
+            -Dot(m_position, m_right), -Dot(m_position, m_up), -Dot(m_position, m_forward), 1.0f);
+        m_viewDirty = false;
+    }
     return m_viewMatrix;
 }
 
-const Matrix& Camera::GetProjectionMatrix() const
+const XMFLOAT4X4& Camera::GetViewProjectionMatrix() const
+{
+    if (m_viewProjectionDirty)
+    {
+        m_viewProjectionMatrix = Multiply(GetViewMatrix(), m_projectionMatrix);
+        m_viewProjectionDirty = false;
+    }
+    return m_viewProjectionMatrix;
+}
+
+const XMFLOAT4X4& Camera::GetInverseViewMatrix() const
+{
+    if (m_inverseViewDirty)
+    {
+        m_inverseViewMatrix = XMFLOAT4X4(
+            m_right.x, m_right.y, m_right.z, 0.0f,
+            m_up.x, m_up.y, m_up.z, 0.0f,
+            m_forward.x, m_forward.y, m_forward.z, 0.0f,
+            m_position.x, m_position.y, m_position.z, 1.0f);
+        m_inverseViewDirty = false;
+    }
+    return m_inverseViewMatrix;
+}
+
+const XMFLOAT4* Camera::GetFrustumPlanes() const
+{
+    if (m_frustumDirty)
+    {
+        // Planos de la vista-proyeccin normal (Gribb-Hartmann, vector fila: recorte = v * M)
+        const XMFLOAT4X4 m = Multiply(GetViewMatrix(), m_cullProjectionMatrix);
+        auto combine = [&m](int a, float sign, int b)
+        {
+            return XMFLOAT4(m.m[0][a] + sign * m.m[0][b], m.m[1][a] + sign * m.m[1][b],
+                m.m[2][a] + sign * m.m[2][b], m.m[3][a] + sign * m.m[3][b]);
+        };
+        m_frustumPlanes[0] = combine(3, 1.0f, 0);
+        m_frustumPlanes[1] = combine(3, -1.0f, 0);
+        m_frustumPlanes[2] = combine(3, 1.0f, 1);
+        m_frustumPlanes[3] = combine(3, -1.0f, 1);
+        m_frustumPlanes[4] = XMFLOAT4(m._13, m._23, m._33, m._43); // z >= 0 (D3D)
+        m_frustumPlanes[5] = combine(3, -1.0f, 2);
+        m_frustumDirty = false;
+    }
+    return m_frustumPlanes;
+}
+
+bool Camera::IsVisible(const XMFLOAT3& center, const XMFLOAT3& extents) const
+{
+    const XMFLOAT4* planes = GetFrustumPlanes();
+    for (int i = 0; i < 6; ++i)
+    {
+        const XMFLOAT3 normal(planes[i].x, planes[i].y, planes[i].z);
+        float distance = Dot(normal, center) + planes[i].w;
+        float radius = std::fabs(normal.x) * extents.x + std::fabs(normal.y) * extents.y + std::fabs(normal.z) * extents.z;
+        if (distance + radius < 0.0f) return false; // Entera detrs de un plano
+    }
+    return true;
+}
+
+const XMFLOAT4X4& Camera::GetProjectionMatrix() const
 {
     return m_projectionMatrix;
 }
 
-const Vector3& Camera::GetPosition() const
+const XMFLOAT3& Camera::GetPosition() const
 {
     return m_position;
 }
 
-Vector3 Camera::GetForward() const
+XMFLOAT3 Camera::GetForward() const
 {
     return m_forward;
 }
 
-Vector3 Camera::GetRight() const
+XMFLOAT3 Camera::GetRight() const
 {
     return m_right;
 }
 
-Vector3 Camera::GetUp() const
+XMFLOAT3 Camera::GetUp() const
 {
     return m_up; // Devuelve el vector "arriba" local de la cmara
 }
@@ -163,10 +279,25 @@ float Camera::GetFarPlane() const
     return m_farPlane;
 }
 
-DirectX::SimpleMath::Quaternion Camera::GetRotation() const
+float Camera::GetNearPlane() const
 {
-    // DirectX::SimpleMath::Quaternion::CreateFromYawPitchRoll espera los ngulos en radianes.
-    // Asumimos que tus miembros Yaw y Pitch ya estn en radianes.
-    // Si estn en grados, necesitaras convertirlos: DirectX::XMConvertToRadians(this->Yaw)
-    return DirectX::SimpleMath::Quaternion::CreateFromYawPitchRoll(this->m_yaw, this->m_pitch, 0.0f); // Roll es 0.0
-}
\ No newline at end of file
+    return m_nearPlane;
+}
+
+float Camera::GetFieldOfView() const
+{
+    return m_fieldOfView;
+}
+
+float Camera::GetAspectRatio() const
+{
+    return m_aspectRatio;
+}
+
+XMFLOAT4 Camera::GetRotation() const
+{
+    // Como Quaternion::CreateFromYawPitchRoll(m_yaw, m_pitch, 0) (ngulos en radianes, roll 0)
+    const float sy = std::sin(0.5f * m_yaw), cy = std::cos(0.5f * m_yaw);
+    const float sp = std::sin(0.5f * m_pitch), cp = std::cos(0.5f * m_pitch);
+    return XMFLOAT4(sp * cy, cp * sy, -sp * sy, cp * cy);
+}
@@ -1,7 +1,10 @@
 #pragma once // O usa #ifndef CAMERA_H / #define CAMERA_H / #endif
 
-#include <SimpleMath.h> // De DirectX ToolKit
+#include <DirectXMath.h>
 
+// Cmara en primera persona. Guarda y devuelve tipos de almacenamiento de DirectXMath (Game los
+// recibe como SimpleMath::Vector3 y Matrix, que se construyen a partir de ellos) y hace las
+// cuentas en escalar en la convencin de SimpleMath: fila-mayor, v * M, mano derecha.
 class Camera
 {
 public:
@@ -9,52 +12,74 @@ public:
     Camera(int screenWidth, int screenHeight);
 
     // Mtodos para actualizar la cmara
-    void SetPosition(const DirectX::SimpleMath::Vector3& position);
+    void SetPosition(const DirectX::XMFLOAT3& position);
     void SetRotation(float yaw, float pitch); // Yaw en radianes, Pitch en radianes
 
-    void Move(const DirectX::SimpleMath::Vector3& translation); // Moverse en coordenadas del mundo
-    void MoveRelative(const DirectX::SimpleMath::Vector3& translation); // Moverse relativo a la orientacin de la cmara
+    void Move(const DirectX::XMFLOAT3& translation); // Moverse en coordenadas del mundo
+    void MoveRelative(const DirectX::XMFLOAT3& translation); // Moverse relativo a la orientacin de la cmara
     void Rotate(float yawDelta, float pitchDelta); // Rotar en radianes
 
-    void UpdateViewMatrix();
     void UpdateProjectionMatrix(int screenWidth, int screenHeight);
 
-    // Mtodos para obtener matrices y propiedades
-    const DirectX::SimpleMath::Matrix& GetViewMatrix() const;
-    const DirectX::SimpleMath::Matrix& GetProjectionMatrix() const;
-    const DirectX::SimpleMath::Vector3& GetPosition() const;
-    DirectX::SimpleMath::Vector3 GetForward() const;
-    DirectX::SimpleMath::Vector3 GetRight() const;
-    DirectX::SimpleMath::Vector3 GetUp() const; // El vector "arriba" local de la cmara
+    // Z invertida con plano lejano en el infinito: profundidad 1 en el plano cercano y 0 en el
+    // infinito. Quien la active tiene que borrar la profundidad a 0 y usar GREATER_EQUAL.
+    void SetReversedZ(bool enabled);
+    bool IsReversedZ() const { return m_reversedZ; }
+
+    // Mtodos para obtener matrices y propiedades. Vista, vista-proyeccin, inversa y frustum se
+    // calculan al pedirlos, como mucho una vez por cada cambio de posicin u orientacin.
+    const DirectX::XMFLOAT4X4& GetViewMatrix() const;
+    const DirectX::XMFLOAT4X4& GetProjectionMatrix() const;
+    const DirectX::XMFLOAT4X4& GetViewProjectionMatrix() const;
+    const DirectX::XMFLOAT4X4& GetInverseViewMatrix() const; // Mundo de la cmara
+    // AABB de mundo (centro y semiejes, como BoundingBox) contra el frustum (siempre hasta
+    // m_farPlane, tambin con Z invertida).
+    bool IsVisible(const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents) const;
+    const DirectX::XMFLOAT3& GetPosition() const;
+    DirectX::XMFLOAT3 GetForward() const;
+    DirectX::XMFLOAT3 GetRight() const;
+    DirectX::XMFLOAT3 GetUp() const; // El vector "arriba" local de la cmara
 
     float GetYaw() const;
     float GetPitch() const;
     float GetFarPlane() const;
-    DirectX::SimpleMath::Quaternion GetRotation() const;
+    float GetNearPlane() const;
+    float GetFieldOfView() const;
+    float GetAspectRatio() const;
+    DirectX::XMFLOAT4 GetRotation() const; // Cuaternin (x, y, z, w) de yaw y pitch
 
 private:
+    void UpdateOrientation(); // m_forward, m_right, m_up a partir de yaw y pitch
+    void InvalidateView();
+    void RebuildProjection();
+    const DirectX::XMFLOAT4* GetFrustumPlanes() const;
+
     // Propiedades de la cmara
-    DirectX::SimpleMath::Vector3 m_position;
+    DirectX::XMFLOAT3 m_position;
     float m_yaw;   // Rotacin alrededor del eje Y global (radianes)
     float m_pitch; // Rotacin alrededor del eje X local (radianes)
 
     // Vectores de direccin (calculados a partir de yaw y pitch)
-    DirectX::SimpleMath::Vector3 m_forward;
-    DirectX::SimpleMath::Vector3 m_right;
-    DirectX::SimpleMath::Vector3 m_up; // Vector "arriba" local de la cmara
+    DirectX::XMFLOAT3 m_forward;
+    DirectX::XMFLOAT3 m_right;
+    DirectX::XMFLOAT3 m_up; // Vector "arriba" local de la cmara
 
-    // Matrices de transformacin
-    DirectX::SimpleMath::Matrix m_viewMatrix;
-    DirectX::SimpleMath::Matrix m_projectionMatrix;
+    // Matrices de transformacin (las derivadas de la posicin y orientacin se calculan al pedirlas)
+    mutable DirectX::XMFLOAT4X4 m_viewMatrix;
+    mutable DirectX::XMFLOAT4X4 m_viewProjectionMatrix;
+    mutable DirectX::XMFLOAT4X4 m_inverseViewMatrix;
+    mutable DirectX::XMFLOAT4 m_frustumPlanes[6]; // Hacia dentro: izquierda, derecha, abajo, arriba, cerca, lejos
+    mutable bool m_viewDirty;
+    mutable bool m_viewProjectionDirty;
+    mutable bool m_inverseViewDirty;
+    mutable bool m_frustumDirty;
+    DirectX::XMFLOAT4X4 m_projectionMatrix;
+    DirectX::XMFLOAT4X4 m_cullProjectionMatrix; // Perspectiva normal hasta m_farPlane, para el frustum
 
     // Propiedades de la proyeccin
     float m_fieldOfView;  // Campo de visin en radianes
     float m_aspectRatio;
     float m_nearPlane;
     float m_farPlane;
-
-    // Constantes
-    const DirectX::SimpleMath::Vector3 WORLD_UP = DirectX::SimpleMath::Vector3(0.0f, 1.0f, 0.0f);
-    const DirectX::SimpleMath::Vector3 WORLD_FORWARD = DirectX::SimpleMath::Vector3(0.0f, 0.0f, 1.0f);
-    const DirectX::SimpleMath::Vector3 WORLD_RIGHT = DirectX::SimpleMath::Vector3(1.0f, 0.0f, 0.0f);
+    bool m_reversedZ;
 };
\ No newline at end of file
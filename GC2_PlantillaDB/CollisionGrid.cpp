@@ -0,0 +1,185 @@
+#include "CollisionGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+    // Mismo criterio que BoundingBox::Intersects(BoundingSphere): distancia al punto mas cercano de la caja
+    bool SphereIntersectsBox(const XMFLOAT3& center, float radius, const XMFLOAT3& boxCenter, const XMFLOAT3& boxExtents)
+    {
+        float dx = std::max(std::fabs(center.x - boxCenter.x) - boxExtents.x, 0.0f);
+        float dy = std::max(std::fabs(center.y - boxCenter.y) - boxExtents.y, 0.0f);
+        float dz = std::max(std::fabs(center.z - boxCenter.z) - boxExtents.z, 0.0f);
+        return dx * dx + dy * dy + dz * dz <= radius * radius;
+    }
+}
+
+CollisionGrid::CollisionGrid(float cellSize) :
+    m_cellSize(1.0f),
+    m_inverseCellSize(1.0f),
+    m_objectCount(0),
+    m_queryMark(0)
+{
+    SetCellSize(cellSize);
+}
+
+void CollisionGrid::SetCellSize(float cellSize)
+{
+    m_cellSize = std::max(cellSize, 1.0e-3f);
+    m_inverseCellSize = 1.0f / m_cellSize;
+
+    m_cells.clear();
+    m_oversized.clear();
+    for (uint32_t id = 0; id < m_entries.size(); ++id)
+    {
+        if (m_entries[id].present) Link(id);
+    }
+}
+
+void CollisionGrid::Clear()
+{
+    m_entries.clear();
+    m_cells.clear();
+    m_oversized.clear();
+    m_queryMarks.clear();
+    m_objectCount = 0;
+}
+
+int CollisionGrid::CellCoord(float value) const
+{
+    return static_cast<int>(std::floor(value * m_inverseCellSize));
+}
+
+uint64_t CollisionGrid::CellKey(int x, int z)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(z);
+}
+
+void CollisionGrid::Link(uint32_t id)
+{
+    Entry& entry = m_entries[id];
+    entry.minX = CellCoord(entry.center.x - entry.radius);
+    entry.maxX = CellCoord(entry.center.x + entry.radius);
+    entry.minZ = CellCoord(entry.center.z - entry.radius);
+    entry.maxZ = CellCoord(entry.center.z + entry.radius);
+    entry.oversized = entry.maxX - entry.minX >= MAX_CELL_SPAN || entry.maxZ - entry.minZ >= MAX_CELL_SPAN;
+
+    if (entry.oversized)
+    {
+        m_oversized.push_back(id);
+        return;
+    }
+    for (int z = entry.minZ; z <= entry.maxZ; ++z)
+    {
+        for (int x = entry.minX; x <= entry.maxX; ++x)
+        {
+            m_cells[CellKey(x, z)].push_back(id);
+        }
+    }
+}
+
+void CollisionGrid::Unlink(uint32_t id)
+{
+    auto eraseFrom = [id](std::vector<uint32_t>& list)
+    {
+        auto it = std::find(list.begin(), list.end(), id);
+        if (it == list.end()) return;
+        *it = list.back();
+        list.pop_back();
+    };
+
+    const Entry& entry = m_entries[id];
+    if (entry.oversized)
+    {
+        eraseFrom(m_oversized);
+        return;
+    }
+    for (int z = entry.minZ; z <= entry.maxZ; ++z)
+    {
+        for (int x = entry.minX; x <= entry.maxX; ++x)
+        {
+            auto cell = m_cells.find(CellKey(x, z));
+            if (cell == m_cells.end()) continue;
+            eraseFrom(cell->second);
+            if (cell->second.empty()) m_cells.erase(cell);
+        }
+    }
+}
+
+void CollisionGrid::Set(uint32_t id, const XMFLOAT3& center, float radius)
+{
+    if (id >= m_entries.size())
+    {
+        m_entries.resize(static_cast<size_t>(id) + 1);
+        m_queryMarks.resize(m_entries.size(), 0);
+    }
+
+    Entry& entry = m_entries[id];
+    if (entry.present)
+    {
+        // Mientras no cambie de rango de celdas basta con guardar la esfera nueva
+        bool sameCells = CellCoord(center.x - radius) == entry.minX && CellCoord(center.x + radius) == entry.maxX &&
+            CellCoord(center.z - radius) == entry.minZ && CellCoord(center.z + radius) == entry.maxZ;
+        entry.center = center;
+        entry.radius = radius;
+        if (sameCells) return;
+        Unlink(id);
+    }
+    else
+    {
+        entry.center = center;
+        entry.radius = radius;
+        entry.present = true;
+        m_objectCount++;
+    }
+    Link(id);
+}
+
+void CollisionGrid::Remove(uint32_t id)
+{
+    if (id >= m_entries.size() || !m_entries[id].present) return;
+    Unlink(id);
+    m_entries[id].present = false;
+    m_objectCount--;
+}
+
+void CollisionGrid::Query(const XMFLOAT3& boxCenter, const XMFLOAT3& boxExtents, std::vector<uint32_t>& outIds) const
+{
+    outIds.clear();
+    if (m_objectCount == 0) return;
+
+    if (++m_queryMark == 0)
+    {
+        std::fill(m_queryMarks.begin(), m_queryMarks.end(), 0);
+        m_queryMark = 1;
+    }
+
+    auto test = [&](uint32_t id)
+    {
+        if (m_queryMarks[id] == m_queryMark) return;
+        m_queryMarks[id] = m_queryMark;
+        const Entry& entry = m_entries[id];
+        if (SphereIntersectsBox(entry.center, entry.radius, boxCenter, boxExtents)) outIds.push_back(id);
+    };
+
+    const int minX = CellCoord(boxCenter.x - boxExtents.x);
+    const int maxX = CellCoord(boxCenter.x + boxExtents.x);
+    const int minZ = CellCoord(boxCenter.z - boxExtents.z);
+    const int maxZ = CellCoord(boxCenter.z + boxExtents.z);
+    for (int z = minZ; z <= maxZ; ++z)
+    {
+        for (int x = minX; x <= maxX; ++x)
+        {
+            auto cell = m_cells.find(CellKey(x, z));
+            if (cell == m_cells.end()) continue;
+            for (uint32_t id : cell->second) test(id);
+        }
+    }
+    for (uint32_t id : m_oversized) test(id);
+
+    // El llamador recorre en el orden de sus instancias (el primer choque gana)
+    std::sort(outIds.begin(), outIds.end());
+}
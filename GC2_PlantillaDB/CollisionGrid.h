@@ -0,0 +1,61 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Broadphase de colisiones: esferas de mundo en una rejilla uniforme sobre XZ (el mundo es un
+// terreno, casi plano). Cada objeto se apunta en las celdas que toca su esfera y solo se vuelve a
+// repartir cuando Set() lo saca de ese rango de celdas. Los que tocarian mas de MAX_CELL_SPAN celdas
+// por eje van a una lista aparte que se prueba siempre. Los ids son los del llamador (en Game, el
+// indice en m_worldInstances).
+class CollisionGrid
+{
+public:
+    static constexpr int MAX_CELL_SPAN = 8;
+
+    explicit CollisionGrid(float cellSize = 64.0f);
+
+    // Cambiar el tamano de celda reparte de nuevo todo lo que hay.
+    void SetCellSize(float cellSize);
+    float GetCellSize() const { return m_cellSize; }
+
+    void Clear();
+
+    // Anade el objeto o actualiza su esfera.
+    void Set(uint32_t id, const DirectX::XMFLOAT3& center, float radius);
+    void Remove(uint32_t id);
+
+    // Ids, de menor a mayor, cuya esfera corta la AABB (centro, semiejes). outIds se vacia antes.
+    void Query(const DirectX::XMFLOAT3& boxCenter, const DirectX::XMFLOAT3& boxExtents, std::vector<uint32_t>& outIds) const;
+
+    size_t GetObjectCount() const { return m_objectCount; }
+
+private:
+    struct Entry
+    {
+        DirectX::XMFLOAT3 center;
+        float radius = 0.0f;
+        int minX = 0, minZ = 0, maxX = 0, maxZ = 0; // Celdas en las que esta apuntado
+        bool present = false;
+        bool oversized = false;
+    };
+
+    int CellCoord(float value) const;
+    static uint64_t CellKey(int x, int z);
+    void Link(uint32_t id);
+    void Unlink(uint32_t id);
+
+    float m_cellSize;
+    float m_inverseCellSize;
+    size_t m_objectCount;
+    std::vector<Entry> m_entries; // Por id
+    std::unordered_map<uint64_t, std::vector<uint32_t>> m_cells;
+    std::vector<uint32_t> m_oversized;
+
+    // Marca de consulta por id para no probar dos veces un objeto que esta en varias celdas
+    mutable std::vector<uint32_t> m_queryMarks;
+    mutable uint32_t m_queryMark;
+};
@@ -0,0 +1,566 @@
+#include "CollisionMesh.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+    struct Vec3
+    {
+        float x, y, z;
+    };
+
+    Vec3 operator+(const Vec3& a, const Vec3& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+    Vec3 operator-(const Vec3& a, const Vec3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+    Vec3 operator*(const Vec3& a, float s) { return { a.x * s, a.y * s, a.z * s }; }
+    float Dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    Vec3 Cross(const Vec3& a, const Vec3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+    Vec3 Min(const Vec3& a, const Vec3& b) { return { std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z) }; }
+    Vec3 Max(const Vec3& a, const Vec3& b) { return { std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z) }; }
+    float Component(const Vec3& v, int axis) { return axis == 0 ? v.x : (axis == 1 ? v.y : v.z); }
+    float Clamp01(float v) { return std::min(std::max(v, 0.0f), 1.0f); }
+    Vec3 ToVec3(const XMFLOAT3& v) { return { v.x, v.y, v.z }; }
+    XMFLOAT3 ToFloat3(const Vec3& v) { return XMFLOAT3(v.x, v.y, v.z); }
+
+    Vec3 TransformPoint(const Vec3& v, const XMFLOAT4X4& m)
+    {
+        return { v.x * m._11 + v.y * m._21 + v.z * m._31 + m._41,
+                 v.x * m._12 + v.y * m._22 + v.z * m._32 + m._42,
+                 v.x * m._13 + v.y * m._23 + v.z * m._33 + m._43 };
+    }
+
+    Vec3 TransformVector(const Vec3& v, const XMFLOAT4X4& m)
+    {
+        return { v.x * m._11 + v.y * m._21 + v.z * m._31,
+                 v.x * m._12 + v.y * m._22 + v.z * m._32,
+                 v.x * m._13 + v.y * m._23 + v.z * m._33 };
+    }
+
+    // Inversa de una matriz afin (la 3x3 por adjuntos y la traslacion deshecha)
+    XMFLOAT4X4 InverseAffine(const XMFLOAT4X4& m)
+    {
+        const float c00 = m._22 * m._33 - m._23 * m._32;
+        const float c01 = m._23 * m._31 - m._21 * m._33;
+        const float c02 = m._21 * m._32 - m._22 * m._31;
+        const float determinant = m._11 * c00 + m._12 * c01 + m._13 * c02;
+        const float inverse = std::fabs(determinant) > 1.0e-20f ? 1.0f / determinant : 0.0f;
+
+        XMFLOAT4X4 r = {};
+        r._11 = c00 * inverse;
+        r._12 = (m._13 * m._32 - m._12 * m._33) * inverse;
+        r._13 = (m._12 * m._23 - m._13 * m._22) * inverse;
+        r._21 = c01 * inverse;
+        r._22 = (m._11 * m._33 - m._13 * m._31) * inverse;
+        r._23 = (m._13 * m._21 - m._11 * m._23) * inverse;
+        r._31 = c02 * inverse;
+        r._32 = (m._12 * m._31 - m._11 * m._32) * inverse;
+        r._33 = (m._11 * m._22 - m._12 * m._21) * inverse;
+        Vec3 t = TransformVector({ m._41, m._42, m._43 }, r);
+        r._41 = -t.x;
+        r._42 = -t.y;
+        r._43 = -t.z;
+        r._44 = 1.0f;
+        return r;
+    }
+
+    // AABB de modelo que contiene una AABB de mundo (centro, semiejes) pasada por la inversa
+    void WorldBoxToModel(const Vec3& center, const Vec3& extents, const XMFLOAT4X4& inverse, float outMin[3], float outMax[3])
+    {
+        Vec3 c = TransformPoint(center, inverse);
+        Vec3 e = {
+            std::fabs(inverse._11) * extents.x + std::fabs(inverse._21) * extents.y + std::fabs(inverse._31) * extents.z,
+            std::fabs(inverse._12) * extents.x + std::fabs(inverse._22) * extents.y + std::fabs(inverse._32) * extents.z,
+            std::fabs(inverse._13) * extents.x + std::fabs(inverse._23) * extents.y + std::fabs(inverse._33) * extents.z };
+        outMin[0] = c.x - e.x; outMin[1] = c.y - e.y; outMin[2] = c.z - e.z;
+        outMax[0] = c.x + e.x; outMax[1] = c.y + e.y; outMax[2] = c.z + e.z;
+    }
+
+    // Triangulo contra AABB por ejes separadores (Akenine-Moller): 3 ejes de la caja, la normal
+    // del triangulo y los 9 productos de aristas por ejes
+    bool TriangleIntersectsBox(const Vec3& a, const Vec3& b, const Vec3& c, const Vec3& center, const Vec3& extents)
+    {
+        const Vec3 v0 = a - center, v1 = b - center, v2 = c - center;
+        const Vec3 edges[3] = { v1 - v0, v2 - v1, v0 - v2 };
+        const Vec3 axes[3] = { { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } };
+
+        for (const Vec3& edge : edges)
+        {
+            for (const Vec3& boxAxis : axes)
+            {
+                Vec3 axis = Cross(boxAxis, edge);
+                float p0 = Dot(v0, axis), p1 = Dot(v1, axis), p2 = Dot(v2, axis);
+                float r = extents.x * std::fabs(axis.x) + extents.y * std::fabs(axis.y) + extents.z * std::fabs(axis.z);
+                if (std::min({ p0, p1, p2 }) > r || std::max({ p0, p1, p2 }) < -r) return false;
+            }
+        }
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float e = Component(extents, axis);
+            float p0 = Component(v0, axis), p1 = Component(v1, axis), p2 = Component(v2, axis);
+            if (std::min({ p0, p1, p2 }) > e || std::max({ p0, p1, p2 }) < -e) return false;
+        }
+
+        Vec3 normal = Cross(edges[0], edges[1]);
+        float distance = Dot(normal, v0);
+        float r = extents.x * std::fabs(normal.x) + extents.y * std::fabs(normal.y) + extents.z * std::fabs(normal.z);
+        return std::fabs(distance) <= r;
+    }
+
+    // Punto del triangulo abc mas cercano a p (Ericson, Real-Time Collision Detection 5.1.5)
+    Vec3 ClosestPointOnTriangle(const Vec3& p, const Vec3& a, const Vec3& b, const Vec3& c)
+    {
+        Vec3 ab = b - a;
+        Vec3 ac = c - a;
+        Vec3 ap = p - a;
+        float d1 = Dot(ab, ap);
+        float d2 = Dot(ac, ap);
+        if (d1 <= 0.0f && d2 <= 0.0f) return a;
+
+        Vec3 bp = p - b;
+        float d3 = Dot(ab, bp);
+        float d4 = Dot(ac, bp);
+        if (d3 >= 0.0f && d4 <= d3) return b;
+
+        float vc = d1 * d4 - d3 * d2;
+        if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) return a + ab * (d1 / (d1 - d3));
+
+        Vec3 cp = p - c;
+        float d5 = Dot(ab, cp);
+        float d6 = Dot(ac, cp);
+        if (d6 >= 0.0f && d5 <= d6) return c;
+
+        float vb = d5 * d2 - d1 * d6;
+        if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) return a + ac * (d2 / (d2 - d6));
+
+        float va = d3 * d6 - d5 * d4;
+        if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+        float denominator = 1.0f / (va + vb + vc);
+        return a + ab * (vb * denominator) + ac * (vc * denominator);
+    }
+
+    // Distancia al cuadrado entre los segmentos p1q1 y p2q2 (Ericson 5.1.9)
+    float SegmentSegmentDistanceSquared(const Vec3& p1, const Vec3& q1, const Vec3& p2, const Vec3& q2)
+    {
+        const float epsilon = 1.0e-12f;
+        Vec3 d1 = q1 - p1;
+        Vec3 d2 = q2 - p2;
+        Vec3 r = p1 - p2;
+        float a = Dot(d1, d1);
+        float e = Dot(d2, d2);
+        float f = Dot(d2, r);
+        float s = 0.0f;
+        float t = 0.0f;
+
+        if (a <= epsilon && e <= epsilon)
+        {
+            s = t = 0.0f;
+        }
+        else if (a <= epsilon)
+        {
+            t = Clamp01(f / e);
+        }
+        else
+        {
+            float c = Dot(d1, r);
+            if (e <= epsilon)
+            {
+                s = Clamp01(-c / a);
+            }
+            else
+            {
+                float b = Dot(d1, d2);
+                float denominator = a * e - b * b;
+                s = denominator != 0.0f ? Clamp01((b * f - c * e) / denominator) : 0.0f;
+                t = (b * s + f) / e;
+                if (t < 0.0f) { t = 0.0f; s = Clamp01(-c / a); }
+                else if (t > 1.0f) { t = 1.0f; s = Clamp01((b - c) / a); }
+            }
+        }
+        Vec3 difference = (p1 + d1 * s) - (p2 + d2 * t);
+        return Dot(difference, difference);
+    }
+
+    bool SegmentCrossesTriangle(const Vec3& p, const Vec3& q, const Vec3& a, const Vec3& b, const Vec3& c)
+    {
+        Vec3 normal = Cross(b - a, c - a);
+        float dp = Dot(p - a, normal), dq = Dot(q - a, normal);
+        if ((dp > 0.0f && dq > 0.0f) || (dp < 0.0f && dq < 0.0f) || dp == dq) return false;
+        Vec3 x = p + (q - p) * (dp / (dp - dq));
+        return Dot(Cross(b - a, x - a), normal) >= 0.0f && Dot(Cross(c - b, x - b), normal) >= 0.0f &&
+            Dot(Cross(a - c, x - c), normal) >= 0.0f;
+    }
+
+    bool TriangleIntersectsCapsule(const Vec3& a, const Vec3& b, const Vec3& c, const Vec3& p, const Vec3& q, float radius)
+    {
+        if (SegmentCrossesTriangle(p, q, a, b, c)) return true;
+        const float radiusSquared = radius * radius;
+        Vec3 onTriangle = ClosestPointOnTriangle(p, a, b, c);
+        if (Dot(p - onTriangle, p - onTriangle) <= radiusSquared) return true;
+        onTriangle = ClosestPointOnTriangle(q, a, b, c);
+        if (Dot(q - onTriangle, q - onTriangle) <= radiusSquared) return true;
+        return SegmentSegmentDistanceSquared(p, q, a, b) <= radiusSquared ||
+            SegmentSegmentDistanceSquared(p, q, b, c) <= radiusSquared ||
+            SegmentSegmentDistanceSquared(p, q, c, a) <= radiusSquared;
+    }
+
+    // Moller-Trumbore por las dos caras; t en unidades de direction
+    bool RayTriangle(const Vec3& origin, const Vec3& direction, const Vec3& a, const Vec3& b, const Vec3& c, float& outT)
+    {
+        Vec3 ab = b - a, ac = c - a;
+        Vec3 p = Cross(direction, ac);
+        float determinant = Dot(ab, p);
+        if (std::fabs(determinant) < 1.0e-12f) return false;
+        float inverse = 1.0f / determinant;
+        Vec3 s = origin - a;
+        float u = Dot(s, p) * inverse;
+        if (u < 0.0f || u > 1.0f) return false;
+        Vec3 qv = Cross(s, ab);
+        float v = Dot(direction, qv) * inverse;
+        if (v < 0.0f || u + v > 1.0f) return false;
+        outT = Dot(ac, qv) * inverse;
+        return true;
+    }
+
+    bool Overlaps(const float minA[3], const float maxA[3], const float minB[3], const float maxB[3])
+    {
+        return minA[0] <= maxB[0] && maxA[0] >= minB[0] && minA[1] <= maxB[1] && maxA[1] >= minB[1] &&
+            minA[2] <= maxB[2] && maxA[2] >= minB[2];
+    }
+
+    float HalfArea(const Vec3& mn, const Vec3& mx)
+    {
+        Vec3 d = mx - mn;
+        return d.x * d.y + d.y * d.z + d.z * d.x;
+    }
+
+    // Pruebas de un rango de triangulos ya en el orden del BVH, para las hojas
+    struct WorldBoxTest
+    {
+        const XMFLOAT3* vertices;
+        const XMFLOAT4X4* world;
+        Vec3 center, extents;
+        bool operator()(uint32_t first, uint32_t count) const
+        {
+            for (uint32_t t = first; t < first + count; ++t)
+            {
+                Vec3 a = TransformPoint(ToVec3(vertices[3 * t]), *world);
+                Vec3 b = TransformPoint(ToVec3(vertices[3 * t + 1]), *world);
+                Vec3 c = TransformPoint(ToVec3(vertices[3 * t + 2]), *world);
+                if (TriangleIntersectsBox(a, b, c, center, extents)) return true;
+            }
+            return false;
+        }
+    };
+
+    struct WorldCapsuleTest
+    {
+        const XMFLOAT3* vertices;
+        const XMFLOAT4X4* world;
+        Vec3 p, q;
+        float radius;
+        bool operator()(uint32_t first, uint32_t count) const
+        {
+            for (uint32_t t = first; t < first + count; ++t)
+            {
+                Vec3 a = TransformPoint(ToVec3(vertices[3 * t]), *world);
+                Vec3 b = TransformPoint(ToVec3(vertices[3 * t + 1]), *world);
+                Vec3 c = TransformPoint(ToVec3(vertices[3 * t + 2]), *world);
+                if (TriangleIntersectsCapsule(a, b, c, p, q, radius)) return true;
+            }
+            return false;
+        }
+    };
+
+    // Rayo en espacio del modelo sobre un rango de triangulos; se queda con el t menor
+    void RayRange(const XMFLOAT3* vertices, uint32_t first, uint32_t count, const Vec3& origin, const Vec3& direction,
+        float& bestT, int64_t& bestTriangle)
+    {
+        for (uint32_t t = first; t < first + count; ++t)
+        {
+            float hitT;
+            if (RayTriangle(origin, direction, ToVec3(vertices[3 * t]), ToVec3(vertices[3 * t + 1]), ToVec3(vertices[3 * t + 2]), hitT) &&
+                hitT >= 0.0f && hitT <= bestT)
+            {
+                bestT = hitT;
+                bestTriangle = t;
+            }
+        }
+    }
+
+    void FillRayHit(const XMFLOAT3* vertices, int64_t triangle, float t, const Vec3& origin, const Vec3& direction,
+        const XMFLOAT4X4& world, CollisionRayHit& outHit)
+    {
+        Vec3 a = TransformPoint(ToVec3(vertices[3 * triangle]), world);
+        Vec3 b = TransformPoint(ToVec3(vertices[3 * triangle + 1]), world);
+        Vec3 c = TransformPoint(ToVec3(vertices[3 * triangle + 2]), world);
+        Vec3 normal = Cross(b - a, c - a);
+        float length = std::sqrt(Dot(normal, normal));
+        normal = length > 0.0f ? normal * (1.0f / length) : Vec3{ 0.0f, 1.0f, 0.0f };
+        if (Dot(normal, direction) > 0.0f) normal = normal * -1.0f;
+
+        outHit.t = t;
+        outHit.point = ToFloat3(origin + direction * t);
+        outHit.normal = ToFloat3(normal);
+    }
+}
+
+void CollisionMesh::Clear()
+{
+    m_nodes.clear();
+    m_vertices.clear();
+}
+
+void CollisionMesh::Build(const XMFLOAT3* positions, size_t vertexCount, const uint32_t* indices, size_t indexCount)
+{
+    Clear();
+
+    struct BuildTriangle
+    {
+        Vec3 minBounds, maxBounds, centroid;
+        uint32_t a, b, c;
+    };
+    std::vector<BuildTriangle> triangles;
+    triangles.reserve(indexCount / 3);
+    for (size_t i = 0; i + 2 < indexCount; i += 3)
+    {
+        if (indices[i] >= vertexCount || indices[i + 1] >= vertexCount || indices[i + 2] >= vertexCount) continue;
+        BuildTriangle triangle;
+        triangle.a = indices[i];
+        triangle.b = indices[i + 1];
+        triangle.c = indices[i + 2];
+        Vec3 a = ToVec3(positions[triangle.a]), b = ToVec3(positions[triangle.b]), c = ToVec3(positions[triangle.c]);
+        Vec3 normal = Cross(b - a, c - a);
+        if (Dot(normal, normal) == 0.0f) continue; // Degenerado: no bloquea nada
+        triangle.minBounds = Min(a, Min(b, c));
+        triangle.maxBounds = Max(a, Max(b, c));
+        triangle.centroid = (a + b + c) * (1.0f / 3.0f);
+        triangles.push_back(triangle);
+    }
+    if (triangles.empty()) return;
+
+    m_nodes.reserve(2 * triangles.size());
+    m_nodes.push_back(Node{});
+
+    // Division por SAH con 12 cubetas sobre el eje que mas abarataria; la pila evita la recursion
+    const int BIN_COUNT = 12;
+    const int MAX_DEPTH = 60;
+    struct Task { uint32_t node, first, count; int depth; };
+    std::vector<Task> tasks = { { 0, 0, static_cast<uint32_t>(triangles.size()), 0 } };
+    while (!tasks.empty())
+    {
+        Task task = tasks.back();
+        tasks.pop_back();
+
+        Vec3 nodeMin = triangles[task.first].minBounds, nodeMax = triangles[task.first].maxBounds;
+        Vec3 centroidMin = triangles[task.first].centroid, centroidMax = centroidMin;
+        for (uint32_t i = task.first; i < task.first + task.count; ++i)
+        {
+            nodeMin = Min(nodeMin, triangles[i].minBounds);
+            nodeMax = Max(nodeMax, triangles[i].maxBounds);
+            centroidMin = Min(centroidMin, triangles[i].centroid);
+            centroidMax = Max(centroidMax, triangles[i].centroid);
+        }
+        Node& node = m_nodes[task.node];
+        node.minBounds[0] = nodeMin.x; node.minBounds[1] = nodeMin.y; node.minBounds[2] = nodeMin.z;
+        node.maxBounds[0] = nodeMax.x; node.maxBounds[1] = nodeMax.y; node.maxBounds[2] = nodeMax.z;
+        node.leftOrFirst = task.first;
+        node.triangleCount = task.count;
+        if (task.count <= MAX_LEAF_TRIANGLES || task.depth >= MAX_DEPTH) continue;
+
+        int bestAxis = -1;
+        int bestSplit = 0;
+        float bestCost = HalfArea(nodeMin, nodeMax) * static_cast<float>(task.count);
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float low = Component(centroidMin, axis), high = Component(centroidMax, axis);
+            if (high <= low) continue;
+            float scale = BIN_COUNT / (high - low);
+
+            struct Bin { Vec3 mn, mx; uint32_t count = 0; } bins[BIN_COUNT];
+            for (uint32_t i = task.first; i < task.first + task.count; ++i)
+            {
+                int bin = std::min(static_cast<int>((Component(triangles[i].centroid, axis) - low) * scale), BIN_COUNT - 1);
+                Bin& target = bins[bin];
+                target.mn = target.count ? Min(target.mn, triangles[i].minBounds) : triangles[i].minBounds;
+                target.mx = target.count ? Max(target.mx, triangles[i].maxBounds) : triangles[i].maxBounds;
+                target.count++;
+            }
+
+            // Coste de cada plano entre cubetas: barrido de izquierda a derecha y al reves
+            float leftArea[BIN_COUNT - 1], rightArea[BIN_COUNT - 1];
+            uint32_t leftCount[BIN_COUNT - 1], rightCount[BIN_COUNT - 1];
+            Vec3 mn = {}, mx = {};
+            uint32_t running = 0;
+            for (int i = 0; i < BIN_COUNT - 1; ++i)
+            {
+                if (bins[i].count)
+                {
+                    mn = running ? Min(mn, bins[i].mn) : bins[i].mn;
+                    mx = running ? Max(mx, bins[i].mx) : bins[i].mx;
+                    running += bins[i].count;
+                }
+                leftCount[i] = running;
+                leftArea[i] = running ? HalfArea(mn, mx) : 0.0f;
+            }
+            running = 0;
+            for (int i = BIN_COUNT - 1; i > 0; --i)
+            {
+                if (bins[i].count)
+                {
+                    mn = running ? Min(mn, bins[i].mn) : bins[i].mn;
+                    mx = running ? Max(mx, bins[i].mx) : bins[i].mx;
+                    running += bins[i].count;
+                }
+                rightCount[i - 1] = running;
+                rightArea[i - 1] = running ? HalfArea(mn, mx) : 0.0f;
+            }
+            for (int i = 0; i < BIN_COUNT - 1; ++i)
+            {
+                if (leftCount[i] == 0 || rightCount[i] == 0) continue;
+                float cost = leftArea[i] * leftCount[i] + rightArea[i] * rightCount[i];
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = i;
+                }
+            }
+        }
+        if (bestAxis < 0) continue; // Partir no sale mas barato que la hoja
+
+        const float low = Component(centroidMin, bestAxis);
+        const float scale = BIN_COUNT / (Component(centroidMax, bestAxis) - low);
+        auto middle = std::partition(triangles.begin() + task.first, triangles.begin() + task.first + task.count,
+            [&](const BuildTriangle& triangle)
+            {
+                int bin = std::min(static_cast<int>((Component(triangle.centroid, bestAxis) - low) * scale), BIN_COUNT - 1);
+                return bin <= bestSplit;
+            });
+        uint32_t leftCountFinal = static_cast<uint32_t>(middle - triangles.begin()) - task.first;
+
+        uint32_t leftChild = static_cast<uint32_t>(m_nodes.size());
+        m_nodes[task.node].leftOrFirst = leftChild;
+        m_nodes[task.node].triangleCount = 0;
+        m_nodes.push_back(Node{});
+        m_nodes.push_back(Node{});
+        tasks.push_back({ leftChild, task.first, leftCountFinal, task.depth + 1 });
+        tasks.push_back({ leftChild + 1, task.first + leftCountFinal, task.count - leftCountFinal, task.depth + 1 });
+    }
+    m_nodes.shrink_to_fit();
+
+    m_vertices.resize(triangles.size() * 3);
+    for (size_t i = 0; i < triangles.size(); ++i)
+    {
+        m_vertices[3 * i] = positions[triangles[i].a];
+        m_vertices[3 * i + 1] = positions[triangles[i].b];
+        m_vertices[3 * i + 2] = positions[triangles[i].c];
+    }
+}
+
+template <typename LeafTest>
+bool CollisionMesh::Traverse(const float queryMin[3], const float queryMax[3], LeafTest&& leaf) const
+{
+    if (m_nodes.empty()) return false;
+
+    uint32_t stack[64];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0)
+    {
+        const Node& node = m_nodes[stack[--stackSize]];
+        if (!Overlaps(node.minBounds, node.maxBounds, queryMin, queryMax)) continue;
+        if (node.triangleCount > 0)
+        {
+            if (leaf(node.leftOrFirst, node.triangleCount)) return true;
+            continue;
+        }
+        stack[stackSize++] = node.leftOrFirst;
+        stack[stackSize++] = node.leftOrFirst + 1;
+    }
+    return false;
+}
+
+bool CollisionMesh::IntersectsBox(const XMFLOAT3& center, const XMFLOAT3& extents, const XMFLOAT4X4& world) const
+{
+    if (m_nodes.empty()) return false;
+    float queryMin[3], queryMax[3];
+    WorldBoxToModel(ToVec3(center), ToVec3(extents), InverseAffine(world), queryMin, queryMax);
+    return Traverse(queryMin, queryMax, WorldBoxTest{ m_vertices.data(), &world, ToVec3(center), ToVec3(extents) });
+}
+
+bool CollisionMesh::IntersectsCapsule(const XMFLOAT3& a, const XMFLOAT3& b, float radius, const XMFLOAT4X4& world) const
+{
+    if (m_nodes.empty()) return false;
+    Vec3 p = ToVec3(a), q = ToVec3(b);
+    Vec3 boxMin = Min(p, q) - Vec3{ radius, radius, radius };
+    Vec3 boxMax = Max(p, q) + Vec3{ radius, radius, radius };
+    float queryMin[3], queryMax[3];
+    WorldBoxToModel((boxMin + boxMax) * 0.5f, (boxMax - boxMin) * 0.5f, InverseAffine(world), queryMin, queryMax);
+    return Traverse(queryMin, queryMax, WorldCapsuleTest{ m_vertices.data(), &world, p, q, radius });
+}
+
+bool CollisionMesh::Raycast(const XMFLOAT3& origin, const XMFLOAT3& direction, float maxT, const XMFLOAT4X4& world,
+    CollisionRayHit& outHit) const
+{
+    if (m_nodes.empty()) return false;
+
+    // La parametrizacion se conserva al pasar origen y direccion al modelo: el t vale en los dos espacios
+    const XMFLOAT4X4 inverse = InverseAffine(world);
+    const Vec3 modelOrigin = TransformPoint(ToVec3(origin), inverse);
+    const Vec3 modelDirection = TransformVector(ToVec3(direction), inverse);
+    const float inverseDirection[3] = {
+        modelDirection.x != 0.0f ? 1.0f / modelDirection.x : INFINITY,
+        modelDirection.y != 0.0f ? 1.0f / modelDirection.y : INFINITY,
+        modelDirection.z != 0.0f ? 1.0f / modelDirection.z : INFINITY };
+    const float rayOrigin[3] = { modelOrigin.x, modelOrigin.y, modelOrigin.z };
+
+    // Entrada del rayo en la caja, o infinito si no la corta antes de bestT
+    auto enter = [&](const Node& node, float bestT)
+    {
+        float tNear = 0.0f, tFar = bestT;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float t0 = (node.minBounds[axis] - rayOrigin[axis]) * inverseDirection[axis];
+            float t1 = (node.maxBounds[axis] - rayOrigin[axis]) * inverseDirection[axis];
+            if (std::isnan(t0) || std::isnan(t1)) continue; // Rayo paralelo sobre el plano de la caja
+            tNear = std::max(tNear, std::min(t0, t1));
+            tFar = std::min(tFar, std::max(t0, t1));
+        }
+        return tNear <= tFar ? tNear : INFINITY;
+    };
+
+    float bestT = maxT;
+    int64_t bestTriangle = -1;
+    uint32_t stack[64];
+    int stackSize = 0;
+    if (enter(m_nodes[0], bestT) != INFINITY) stack[stackSize++] = 0;
+    while (stackSize > 0)
+    {
+        const Node& node = m_nodes[stack[--stackSize]];
+        if (enter(node, bestT) == INFINITY) continue;
+        if (node.triangleCount > 0)
+        {
+            RayRange(m_vertices.data(), node.leftOrFirst, node.triangleCount, modelOrigin, modelDirection, bestT, bestTriangle);
+            continue;
+        }
+
+        // El hijo mas cercano se apila el ultimo para visitarlo primero
+        uint32_t nearChild = node.leftOrFirst, farChild = node.leftOrFirst + 1;
+        float nearT = enter(m_nodes[nearChild], bestT), farT = enter(m_nodes[farChild], bestT);
+        if (farT < nearT)
+        {
+            std::swap(nearChild, farChild);
+            std::swap(nearT, farT);
+        }
+        if (farT != INFINITY) stack[stackSize++] = farChild;
+        if (nearT != INFINITY) stack[stackSize++] = nearChild;
+    }
+
+    if (bestTriangle < 0) return false;
+    FillRayHit(m_vertices.data(), bestTriangle, bestT, ToVec3(origin), ToVec3(direction), world, outHit);
+    return true;
+}
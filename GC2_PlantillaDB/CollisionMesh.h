@@ -0,0 +1,58 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct CollisionRayHit
+{
+    float t = 0.0f;                                 // En unidades de la direccion pasada a Raycast
+    DirectX::XMFLOAT3 point = { 0.0f, 0.0f, 0.0f }; // Mundo
+    DirectX::XMFLOAT3 normal = { 0.0f, 1.0f, 0.0f }; // Mundo, unitaria, hacia el origen del rayo
+};
+
+// Malla de colision de un modelo: triangulos en espacio del modelo (ya con la transformacion de
+// cada nodo) reordenados por un BVH binario construido con SAH por cubetas. Los nodos ocupan
+// 32 bytes y los triangulos se guardan como tres vertices seguidos, sin indices.
+// Las consultas se hacen en mundo con la matriz de la instancia (vector fila: mundo = modelo * M):
+// el volumen de la consulta se lleva al modelo para recorrer el BVH y los triangulos de las hojas
+// se llevan al mundo para el test exacto, asi que vale cualquier matriz afin (escala no uniforme incluida).
+class CollisionMesh
+{
+public:
+    static constexpr uint32_t MAX_LEAF_TRIANGLES = 4;
+
+    void Build(const DirectX::XMFLOAT3* positions, size_t vertexCount, const uint32_t* indices, size_t indexCount);
+    void Clear();
+
+    bool IsEmpty() const { return m_nodes.empty(); }
+    size_t GetTriangleCount() const { return m_vertices.size() / 3; }
+    size_t GetNodeCount() const { return m_nodes.size(); }
+
+    // AABB de mundo (centro, semiejes) contra los triangulos de la instancia.
+    bool IntersectsBox(const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents, const DirectX::XMFLOAT4X4& world) const;
+
+    // Capsula de mundo: segmento ab engordado por radius.
+    bool IntersectsCapsule(const DirectX::XMFLOAT3& a, const DirectX::XMFLOAT3& b, float radius, const DirectX::XMFLOAT4X4& world) const;
+
+    // Primer corte de origin + t * direction con t en [0, maxT].
+    bool Raycast(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction, float maxT,
+        const DirectX::XMFLOAT4X4& world, CollisionRayHit& outHit) const;
+
+private:
+    struct Node
+    {
+        float minBounds[3];
+        uint32_t leftOrFirst; // Interior: hijo izquierdo (el derecho va detras). Hoja: primer triangulo
+        float maxBounds[3];
+        uint32_t triangleCount; // 0 en los nodos interiores
+    };
+
+    // Recorre el BVH con la AABB de modelo y llama a leaf(primer triangulo, cuantos) hasta que devuelva true.
+    template <typename LeafTest>
+    bool Traverse(const float queryMin[3], const float queryMax[3], LeafTest&& leaf) const;
+
+    std::vector<Node> m_nodes;
+    std::vector<DirectX::XMFLOAT3> m_vertices; // 3 por triangulo, en el orden de las hojas
+};
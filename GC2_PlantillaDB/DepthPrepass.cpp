@@ -0,0 +1,57 @@
+#include "DepthPrepass.h"
+
+MaterialAlphaMode ClassifyAlphaTexels(const uint8_t* texels, int width, int height, size_t rowPitch,
+    size_t texelStride, size_t channelOffset)
+{
+    for (int y = 0; y < height; ++y)
+    {
+        const uint8_t* row = texels + static_cast<size_t>(y) * rowPitch + channelOffset;
+        for (int x = 0; x < width; ++x)
+        {
+            if (row[static_cast<size_t>(x) * texelStride] < ALPHA_CLIP_THRESHOLD) return MaterialAlphaMode::Masked;
+        }
+    }
+    return MaterialAlphaMode::Opaque;
+}
+
+void ScenePassPlan::Build(bool depthPrepass, uint8_t visibleAlphaModes)
+{
+    passes.clear();
+
+    // Antes del terreno para que este tambien se beneficie del early-Z donde lo tapan casas y arboles.
+    // Opacas y Masked por separado: el pixel shader cambia una vez por pasada, no por parte.
+    if (depthPrepass)
+    {
+        const struct { MaterialAlphaMode mode; ScenePixelShader pixelShader; } prepasses[] = {
+            { MaterialAlphaMode::Opaque, ScenePixelShader::None },
+            { MaterialAlphaMode::Masked, ScenePixelShader::DepthAlphaClip } };
+        for (const auto& prepass : prepasses)
+        {
+            if ((visibleAlphaModes & MaterialAlphaBit(prepass.mode)) == 0) continue;
+            ScenePass pass;
+            pass.kind = ScenePassKind::DepthPrepass;
+            pass.alphaModes = MaterialAlphaBit(prepass.mode);
+            pass.pixelShader = prepass.pixelShader;
+            pass.depthTest = SceneDepthTest::LessWrite;
+            passes.push_back(pass);
+        }
+    }
+
+    ScenePass terrain;
+    terrain.kind = ScenePassKind::Terrain;
+    terrain.alphaModes = 0;
+    terrain.pixelShader = ScenePixelShader::Terrain;
+    terrain.depthTest = SceneDepthTest::LessWrite;
+    terrain.cullNone = false;
+    passes.push_back(terrain);
+
+    if (visibleAlphaModes == 0) return;
+
+    // La profundidad ya esta escrita: solo se sombrea el fragmento que quedo delante
+    ScenePass models;
+    models.kind = ScenePassKind::Models;
+    models.alphaModes = visibleAlphaModes;
+    models.pixelShader = depthPrepass ? ScenePixelShader::EvolvingNoClip : ScenePixelShader::Evolving;
+    models.depthTest = depthPrepass ? SceneDepthTest::EqualNoWrite : SceneDepthTest::LessWrite;
+    passes.push_back(models);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Como trata un material el alfa de su textura difusa.
+// Masked: la textura tiene huecos (hojas, flores) y necesita clip() en la pre-pasada.
+enum class MaterialAlphaMode : uint8_t
+{
+    Opaque,
+    Masked
+};
+
+// Bit de un modo en la mascara de un modelo o de las instancias visibles.
+inline uint8_t MaterialAlphaBit(MaterialAlphaMode mode) { return static_cast<uint8_t>(1u << static_cast<unsigned>(mode)); }
+
+// Umbral de clip() en EvolvingPS, DepthPrepassPS_AlphaClip y ShadowPS_AlphaClip (alfa de 8 bits).
+constexpr uint8_t ALPHA_CLIP_THRESHOLD = 128;
+
+// Recorre un canal de 8 bits de los texeles: Masked si algun texel queda por debajo del umbral
+// de clip(). Con todos por encima el filtrado (bilineal, mips) tampoco baja de el y clip() no
+// descartaria nada. 'channelOffset' es el byte del canal dentro de cada texel.
+MaterialAlphaMode ClassifyAlphaTexels(const uint8_t* texels, int width, int height, size_t rowPitch,
+    size_t texelStride, size_t channelOffset);
+
+// Estado que pide cada pasada del render de la escena opaca.
+enum class ScenePassKind : uint8_t
+{
+    DepthPrepass, // Modelos solo profundidad (EvolvingVS)
+    Terrain,
+    Models        // Pasada principal de los modelos (EvolvingDraw)
+};
+
+enum class ScenePixelShader : uint8_t
+{
+    None,           // Solo profundidad
+    DepthAlphaClip, // DepthPrepassPS_AlphaClip
+    Terrain,        // TerrainPS
+    Evolving,       // EvolvingPS con clip()
+    EvolvingNoClip  // EvolvingPS_NoClip: sin clip(), la GPU puede usar early-Z
+};
+
+enum class SceneDepthTest : uint8_t
+{
+    LessWrite,   // DepthDefault
+    EqualNoWrite // m_depthEqualState
+};
+
+struct ScenePass
+{
+    ScenePassKind kind = ScenePassKind::Models;
+    uint8_t alphaModes = 0; // MaterialAlphaBit de las partes que dibuja (0 en el terreno)
+    ScenePixelShader pixelShader = ScenePixelShader::Evolving;
+    SceneDepthTest depthTest = SceneDepthTest::LessWrite;
+    bool cullNone = true;   // Los modelos van sin culling (hojas de dos caras)
+};
+
+// Orden y estado de las pasadas de la escena opaca. Game::Render recorre 'passes' y solo traduce
+// cada entrada a estados D3D, asi que el orden que comprueba DepthPrepassTest es el que se dibuja:
+// pre-pasada (opacas sin pixel shader, luego Masked con clip) -> terreno -> modelos con EQUAL y
+// EvolvingPS_NoClip. Sin pre-pasada: terreno -> modelos con EvolvingPS y LESS.
+struct ScenePassPlan
+{
+    std::vector<ScenePass> passes;
+
+    // visibleAlphaModes: MaterialAlphaBit de las partes de las instancias visibles; una pasada de
+    // pre-pasada sin partes de su modo no se emite.
+    void Build(bool depthPrepass, uint8_t visibleAlphaModes);
+};
@@ -0,0 +1,22 @@
+// DepthPrepassPS_AlphaClip.hlsl
+// Pre-pasada de profundidad para materiales Masked (hojas, flores) con EvolvingVS.
+
+Texture2D diffuseTexture : register(t0);
+SamplerState textureSampler : register(s0);
+
+// Debe coincidir con la salida de EvolvingVS
+struct PixelInputType_Evolving
+{
+    float4 clipSpacePosition : SV_POSITION;
+    float2 texCoord : TEXCOORD0;
+    float3 worldNormal : NORMAL;
+    float3 worldPosition : WORLDPOS;
+    float4 positionInLightSpace : TEXCOORD1;
+};
+
+// No escribe color: solo descarta los pixeles transparentes para que no dejen profundidad.
+void main(PixelInputType_Evolving input)
+{
+    float alpha = diffuseTexture.Sample(textureSampler, input.texCoord).a;
+    clip(alpha - 0.5f);
+}
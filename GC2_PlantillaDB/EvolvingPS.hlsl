@@ -5,6 +5,8 @@ SamplerState textureSampler : register(s0);
 Texture2D shadowMap : register(t1);
 SamplerComparisonState shadowSampler : register(s1);
 
+#include "ShadowCascades.hlsli"
+
 // Constant Buffer para las propiedades globales de la luz (desde Game.cpp)
 cbuffer LightProperties : register(b1) // Asegrate que este slot (b1) se use en C++
 {
@@ -53,44 +55,19 @@ float ApplyShadowFalloff(float currentShadowFactor, float2 shadowUV)
     return lerp(1.0f, currentShadowFactor, smoothFactor);
 }
 
-float CalculatePCFShadowFactor(Texture2D shadowTex, SamplerComparisonState shadowSamp, float4 lightSpacePos, float bias)
-{
-    // 1. Proyeccin perspectiva y coordenadas de textura
-    lightSpacePos.xyz /= lightSpacePos.w;
-    float2 shadowTexCoord = float2(lightSpacePos.x * 0.5f + 0.5f, lightSpacePos.y * -0.5f + 0.5f);
-
-    float shadowFactor = 0.0f;
-    float2 texelSize;
-    uint width, height;
-    shadowTex.GetDimensions(width, height);
-    texelSize = float2(1.0f / width, 1.0f / height);
-
-    // 2. Bucle del kernel 5x5
-    for (int y = -2; y <= 2; y++)
-    {
-        for (int x = -2; x <= 2; x++)
-        {
-            // Muestrear y comparar la profundidad
-            shadowFactor += shadowTex.SampleCmpLevelZero(
-                shadowSamp,
-                shadowTexCoord + float2(x, y) * texelSize, // Coordenada de la muestra actual
-                lightSpacePos.z - bias // Profundidad del pxel actual con bias
-            );
-        }
-    }
-
-    // 3. Promediar los resultados
-    return shadowFactor / 25.0f; // Dividir por el nmero total de muestras (5*5=25)
-}
-
 float4 main(PixelInputType_Evolving input) : SV_TARGET
 {
     // Obtener el color base de la textura
     float4 albedo = diffuseTexture.Sample(textureSampler, input.texCoord); 
 
     // Alpha clipping para las hojas de los rboles
+    // Con la pre-pasada de profundidad el recorte ya se hizo y la prueba EQUAL descarta
+    // los huecos; sin clip() la GPU puede usar early-Z (ver EvolvingPS_NoClip.hlsl).
+#ifndef EVOLVING_NO_ALPHA_CLIP
     float alphaClipThreshold = 0.5f;
     clip(albedo.a - alphaClipThreshold);
+#endif
+
 
     // Clculos de vectores de iluminacin
     float3 N = normalize(input.worldNormal);
@@ -112,24 +89,9 @@ float4 main(PixelInputType_Evolving input) : SV_TARGET
     // 1. Empezamos con el color base siendo solo la luz ambiental.
     float4 finalColor = ambient;
     
-    float4 lightSpacePos = input.positionInLightSpace; // Copiamos para claridad
-    lightSpacePos.xyz /= lightSpacePos.w;
-    float2 shadowTexCoord = float2(lightSpacePos.x * 0.5f + 0.5f, -lightSpacePos.y * 0.5f + 0.5f);
-
-    // 3. Calculamos la visibilidad de la luz (el desvanecimiento en los bordes)
-    float2 fromCenter = abs(shadowTexCoord - 0.5f) * 2.0f;
-    float dist = max(fromCenter.x, fromCenter.y);
-    float falloffStart = 0.85f;
-    float falloffEnd = 0.98f;
-    float lightVisibility = 1.0 - smoothstep(falloffStart, falloffEnd, dist);
-
-    // 4. Calculamos el factor de sombra (si el pxel est tapado o no)
+    // 3. Sombra de la cascada que contiene el pixel (ver ShadowCascades.hlsli)
     float bias = 0.0005f;
-    float shadowFactor = CalculatePCFShadowFactor(shadowMap, shadowSampler, input.positionInLightSpace, bias);
-    
-    // 5. COMBINACIN FINAL:
-    // El factor de luz final es el producto de la visibilidad Y si est en sombra.
-    float finalLightFactor = lightVisibility * shadowFactor;
+    float finalLightFactor = CalculateCascadedShadow(shadowMap, shadowSampler, input.worldPosition, bias);
     
     // 6. Aadimos la luz direccional y especular, modulada por nuestro factor final.
     finalColor = materialEmissiveColor + ambient + (diffuse + specular) * finalLightFactor;
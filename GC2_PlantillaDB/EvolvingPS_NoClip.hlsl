@@ -0,0 +1,7 @@
+// EvolvingPS_NoClip.hlsl
+// Variante de EvolvingPS sin clip() para la pasada principal tras la pre-pasada de profundidad.
+// Las hojas ya se recortaron en DepthPrepassPS_AlphaClip y la prueba de profundidad EQUAL
+// descarta los huecos, asi que la iluminacion y el PCF solo corren una vez por pixel visible.
+
+#define EVOLVING_NO_ALPHA_CLIP
+#include "EvolvingPS.hlsl"
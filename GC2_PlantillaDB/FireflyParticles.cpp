@@ -0,0 +1,236 @@
+#include "FireflyParticles.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define FIREFLY_USE_SSE2 1
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+    const float TWO_PI = XM_2PI;
+    const float BLINK_SPEED = 3.0f;       // Radianes de parpadeo por segundo
+    const float WOBBLE_AMPLITUDE = 0.2f;  // Velocidad vertical del vaiven: sin(2 * blink) * 0.2
+
+    uint64_t Mix64(uint64_t z)
+    {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    float UnitFloat(uint32_t bits)
+    {
+        return static_cast<float>(bits >> 8) * (1.0f / 16777216.0f); // [0, 1)
+    }
+
+    // Los 8 valores en [0, 1) de una reaparicion. Solo dependen de la semilla, el indice y el numero
+    // de reaparicion (SplitMix64 sobre esa clave), asi que cualquier hilo puede pedirlos sin estado comun.
+    void SpawnValues(uint32_t seed, size_t index, uint32_t spawn, float out[8])
+    {
+        const uint64_t golden = 0x9E3779B97F4A7C15ull;
+        uint64_t state = Mix64(((static_cast<uint64_t>(index) << 32) | spawn) ^ (static_cast<uint64_t>(seed) * golden));
+        for (int k = 0; k < 4; ++k)
+        {
+            uint64_t bits = Mix64(state += golden);
+            out[2 * k] = UnitFloat(static_cast<uint32_t>(bits));
+            out[2 * k + 1] = UnitFloat(static_cast<uint32_t>(bits >> 32));
+        }
+    }
+
+    // Brillo a partir del seno ya calculado
+    float BrightnessFromSin(float s)
+    {
+        float blink = (s + 1.0f) * 0.5f;
+        return blink * blink * blink;
+    }
+
+#ifdef FIREFLY_USE_SSE2
+    // Seno y coseno de 4 angulos: reduccion a [-pi, pi], reflejo a [-pi/2, pi/2] y los polinomios
+    // minimax de XMScalarSinCos (error ~1e-7).
+    void SinCos4(__m128 x, __m128& outSin, __m128& outCos)
+    {
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+        __m128 quotient = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.0f / TWO_PI))));
+        x = _mm_sub_ps(x, _mm_mul_ps(quotient, _mm_set1_ps(TWO_PI)));
+
+        // sin(x) = sin(+-pi - x) y cos(x) = -cos(+-pi - x)
+        __m128 sign = _mm_and_ps(x, signMask);
+        __m128 reflect = _mm_cmpgt_ps(_mm_andnot_ps(signMask, x), _mm_set1_ps(XM_PIDIV2));
+        __m128 reflected = _mm_sub_ps(_mm_or_ps(_mm_set1_ps(XM_PI), sign), x);
+        x = _mm_or_ps(_mm_and_ps(reflect, reflected), _mm_andnot_ps(reflect, x));
+        __m128 cosSign = _mm_or_ps(_mm_and_ps(reflect, _mm_set1_ps(-1.0f)), _mm_andnot_ps(reflect, _mm_set1_ps(1.0f)));
+
+        __m128 x2 = _mm_mul_ps(x, x);
+        __m128 s = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-2.3889859e-08f), x2), _mm_set1_ps(2.7525562e-06f));
+        s = _mm_add_ps(_mm_mul_ps(s, x2), _mm_set1_ps(-0.00019840874f));
+        s = _mm_add_ps(_mm_mul_ps(s, x2), _mm_set1_ps(0.0083333310f));
+        s = _mm_add_ps(_mm_mul_ps(s, x2), _mm_set1_ps(-0.16666667f));
+        s = _mm_add_ps(_mm_mul_ps(s, x2), _mm_set1_ps(1.0f));
+        outSin = _mm_mul_ps(s, x);
+
+        __m128 c = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-2.6051615e-07f), x2), _mm_set1_ps(2.4760495e-05f));
+        c = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(-0.0013888378f));
+        c = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(0.041666638f));
+        c = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(-0.5f));
+        c = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(1.0f));
+        outCos = _mm_mul_ps(c, cosSign);
+    }
+#endif
+}
+
+float FireflyBrightness(float blinkTimer)
+{
+    return BrightnessFromSin(std::sin(blinkTimer));
+}
+
+void FireflyParticles::Reset(size_t count, const XMFLOAT3& volumeCenter, const XMFLOAT3& volumeExtents, uint32_t seed)
+{
+    m_count = count;
+    m_simulatedCount = (count + 3) & ~size_t(3);
+    m_volumeCenter = volumeCenter;
+    m_volumeExtents = volumeExtents;
+    m_seed = seed;
+
+    for (std::vector<float>* array : { &m_positionX, &m_positionY, &m_positionZ, &m_velocityX, &m_velocityY, &m_velocityZ,
+        &m_lifetime, &m_blinkTimer, &m_brightness })
+    {
+        array->assign(m_simulatedCount, 0.0f);
+    }
+    m_spawnCount.assign(m_simulatedCount, 0);
+
+    for (size_t i = 0; i < m_simulatedCount; ++i) Respawn(i);
+}
+
+void FireflyParticles::Respawn(size_t i)
+{
+    float u[8];
+    SpawnValues(m_seed, i, m_spawnCount[i]++, u);
+
+    // Posicion aleatoria dentro del volumen y velocidad suave para que floten
+    m_positionX[i] = m_volumeCenter.x + (u[0] * 2.0f - 1.0f) * m_volumeExtents.x;
+    m_positionY[i] = m_volumeCenter.y + (u[1] * 2.0f - 1.0f) * m_volumeExtents.y;
+    m_positionZ[i] = m_volumeCenter.z + (u[2] * 2.0f - 1.0f) * m_volumeExtents.z;
+    m_velocityX[i] = (u[3] * 2.0f - 1.0f) * 0.5f;
+    m_velocityY[i] = (u[4] * 2.0f - 1.0f) * 0.3f;
+    m_velocityZ[i] = (u[5] * 2.0f - 1.0f) * 0.5f;
+
+    // Entre 4 y 9 segundos, para que no desaparezcan todas a la vez, y parpadeo con desfase aleatorio
+    m_lifetime[i] = 4.0f + u[6] * 5.0f;
+    m_blinkTimer[i] = u[7] * TWO_PI;
+    m_brightness[i] = FireflyBrightness(m_blinkTimer[i]);
+}
+
+void FireflyParticles::Update(float elapsedTime, ThreadPool* pool)
+{
+    if (m_simulatedCount == 0) return;
+
+    // El parpadeo avanza lo mismo en todas: su seno nuevo sale del actual girando este angulo
+    const float blinkStep = elapsedTime * BLINK_SPEED;
+    const float sinStep = std::sin(blinkStep);
+    const float cosStep = std::cos(blinkStep);
+
+    auto updateChunk = [&](int chunk)
+    {
+        size_t first = static_cast<size_t>(chunk) * CHUNK_SIZE;
+        size_t last = std::min(first + CHUNK_SIZE, m_simulatedCount);
+        UpdateRange(first, last, elapsedTime, sinStep, cosStep);
+    };
+
+    const int chunkCount = static_cast<int>((m_simulatedCount + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    if (pool && chunkCount > 1) pool->ParallelFor(chunkCount, updateChunk);
+    else for (int chunk = 0; chunk < chunkCount; ++chunk) updateChunk(chunk);
+}
+
+void FireflyParticles::UpdateRange(size_t first, size_t last, float elapsedTime, float sinStep, float cosStep)
+{
+    const float blinkStep = elapsedTime * BLINK_SPEED;
+    // sin(2 * blink) = 2 * sin(blink) * cos(blink)
+    const float wobble = 2.0f * WOBBLE_AMPLITUDE * elapsedTime;
+
+#ifdef FIREFLY_USE_SSE2
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 twoPi = _mm_set1_ps(TWO_PI);
+    const __m128 dt = _mm_set1_ps(elapsedTime);
+    const __m128 wobble4 = _mm_set1_ps(wobble);
+    const __m128 step4 = _mm_set1_ps(blinkStep);
+    const __m128 sinStep4 = _mm_set1_ps(sinStep);
+    const __m128 cosStep4 = _mm_set1_ps(cosStep);
+
+    for (size_t i = first; i < last; i += 4)
+    {
+        __m128 lifetime = _mm_sub_ps(_mm_loadu_ps(&m_lifetime[i]), dt);
+        _mm_storeu_ps(&m_lifetime[i], lifetime);
+        int expired = _mm_movemask_ps(_mm_cmple_ps(lifetime, zero));
+        if (expired)
+        {
+            for (int k = 0; k < 4; ++k)
+            {
+                if (expired & (1 << k)) Respawn(i + k);
+            }
+        }
+
+        __m128 blink = _mm_loadu_ps(&m_blinkTimer[i]);
+        __m128 s, c;
+        SinCos4(blink, s, c);
+
+        _mm_storeu_ps(&m_positionX[i], _mm_add_ps(_mm_loadu_ps(&m_positionX[i]), _mm_mul_ps(_mm_loadu_ps(&m_velocityX[i]), dt)));
+        _mm_storeu_ps(&m_positionZ[i], _mm_add_ps(_mm_loadu_ps(&m_positionZ[i]), _mm_mul_ps(_mm_loadu_ps(&m_velocityZ[i]), dt)));
+        __m128 y = _mm_add_ps(_mm_loadu_ps(&m_positionY[i]), _mm_mul_ps(_mm_loadu_ps(&m_velocityY[i]), dt));
+        _mm_storeu_ps(&m_positionY[i], _mm_add_ps(y, _mm_mul_ps(_mm_mul_ps(s, c), wobble4)));
+
+        // sin(blink + step) = sin(blink) cos(step) + cos(blink) sin(step)
+        __m128 blinkSin = _mm_add_ps(_mm_mul_ps(s, cosStep4), _mm_mul_ps(c, sinStep4));
+        __m128 brightness = _mm_mul_ps(_mm_add_ps(blinkSin, one), half);
+        _mm_storeu_ps(&m_brightness[i], _mm_mul_ps(_mm_mul_ps(brightness, brightness), brightness));
+
+        blink = _mm_add_ps(blink, step4);
+        blink = _mm_sub_ps(blink, _mm_and_ps(_mm_cmpge_ps(blink, twoPi), twoPi));
+        _mm_storeu_ps(&m_blinkTimer[i], blink);
+    }
+#else
+    for (size_t i = first; i < last; ++i)
+    {
+        m_lifetime[i] -= elapsedTime;
+        if (m_lifetime[i] <= 0.0f) Respawn(i);
+
+        float blink = m_blinkTimer[i];
+        float s = std::sin(blink);
+        float c = std::cos(blink);
+
+        m_positionX[i] += m_velocityX[i] * elapsedTime;
+        m_positionZ[i] += m_velocityZ[i] * elapsedTime;
+        m_positionY[i] = (m_positionY[i] + m_velocityY[i] * elapsedTime) + s * c * wobble;
+
+        m_brightness[i] = BrightnessFromSin(s * cosStep + c * sinStep);
+
+        blink += blinkStep;
+        if (blink >= TWO_PI) blink -= TWO_PI;
+        m_blinkTimer[i] = blink;
+    }
+#endif
+}
+
+size_t FireflyParticles::Pack(float size, const XMFLOAT4& baseColor, FireflyInstance* outInstances, size_t capacity) const
+{
+    size_t written = 0;
+    for (size_t i = 0; i < m_count && written < capacity; ++i)
+    {
+        const float brightness = m_brightness[i];
+        if (m_lifetime[i] <= 0.0f || brightness < FIREFLY_MIN_BRIGHTNESS) continue;
+
+        FireflyInstance& instance = outInstances[written++];
+        instance.position = XMFLOAT3(m_positionX[i], m_positionY[i], m_positionZ[i]);
+        instance.size = size;
+        instance.color = XMFLOAT4(baseColor.x * brightness, baseColor.y * brightness,
+            baseColor.z * brightness, baseColor.w * brightness);
+    }
+    return written;
+}
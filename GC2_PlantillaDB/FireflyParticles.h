@@ -0,0 +1,68 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+// Un elemento del buffer de instancias de FireflyVS (slot 1, D3D11_INPUT_PER_INSTANCE_DATA).
+struct FireflyInstance
+{
+    DirectX::XMFLOAT3 position;
+    float size;
+    DirectX::XMFLOAT4 color;
+};
+static_assert(sizeof(FireflyInstance) == 8 * sizeof(float), "FireflyInstance must match the FireflyVS instance layout");
+
+// Brillo del parpadeo: ((sin(t) + 1) / 2)^3, como hacia el bucle de dibujado.
+float FireflyBrightness(float blinkTimer);
+
+// Las que por debajo de esto no aportan nada con mezcla aditiva (menos de medio nivel de 8 bits
+// con el color base mas intenso) no se suben.
+constexpr float FIREFLY_MIN_BRIGHTNESS = 1.0f / 1024.0f;
+
+// Luciernagas en arrays separados por componente (SoA). Update avanza 4 particulas por instruccion
+// SSE2: un solo seno/coseno polinomico por particula (el del vaiven) y el del parpadeo sale de el
+// girando el angulo lo que avanza el temporizador, igual para todas. Al reaparecer, los valores
+// aleatorios salen de un hash de (semilla, indice, numero de reaparicion), sin estado compartido:
+// los bloques de CHUNK_SIZE particulas se reparten en el pool y el resultado no depende del numero
+// de hilos.
+class FireflyParticles
+{
+public:
+    static const size_t CHUNK_SIZE = 16384; // Particulas por tarea del pool (multiplo de 4)
+
+    // Coloca count particulas aleatorias dentro del volumen (centro, semiejes).
+    void Reset(size_t count, const DirectX::XMFLOAT3& volumeCenter, const DirectX::XMFLOAT3& volumeExtents, uint32_t seed);
+
+    // Avanza elapsedTime segundos. Sin pool, o con un solo bloque, en el hilo que llama.
+    void Update(float elapsedTime, ThreadPool* pool);
+
+    // Escribe en outInstances (hasta capacity) las particulas visibles, en su orden, con color
+    // baseColor * brillo y tamano size. Devuelve cuantas escribio. Solo CPU: sirve sobre la
+    // memoria mapeada del buffer dinamico o sobre un vector.
+    size_t Pack(float size, const DirectX::XMFLOAT4& baseColor, FireflyInstance* outInstances, size_t capacity) const;
+
+    size_t GetCount() const { return m_count; }
+    DirectX::XMFLOAT3 GetPosition(size_t i) const { return DirectX::XMFLOAT3(m_positionX[i], m_positionY[i], m_positionZ[i]); }
+    float GetBrightness(size_t i) const { return m_brightness[i]; }
+
+private:
+    void Respawn(size_t i);
+    void UpdateRange(size_t first, size_t last, float elapsedTime, float sinStep, float cosStep);
+
+    size_t m_count = 0;
+    size_t m_simulatedCount = 0; // m_count redondeado a 4; las del relleno se simulan pero no se dibujan
+    DirectX::XMFLOAT3 m_volumeCenter = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+    DirectX::XMFLOAT3 m_volumeExtents = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+    uint32_t m_seed = 0;
+
+    std::vector<float> m_positionX, m_positionY, m_positionZ;
+    std::vector<float> m_velocityX, m_velocityY, m_velocityZ;
+    std::vector<float> m_lifetime;
+    std::vector<float> m_blinkTimer;  // En [0, 2*pi): el seno del parpadeo y el del vaiven tienen ese periodo
+    std::vector<float> m_brightness;  // Parpadeo ya evaluado (0..1)
+    std::vector<uint32_t> m_spawnCount;
+};
@@ -8,19 +8,14 @@ cbuffer PerFrameConstants : register(b0)
     float3 CameraRight_World; // El vector "derecha" de la cmara en el mundo
 };
 
-// Datos que cambian por cada partcula
-cbuffer PerParticleConstants : register(b1)
-{
-    float3 ParticleCenter_World; // Posicin de la lucirnaga en el mundo
-    float2 ParticleSize; // Ancho y alto de la lucirnaga
-    float2 _padding;
-    float4 ParticleColor;
-};
-
+// Una instancia por luciernaga (buffer dinamico en el slot 1, ver FireflyInstance en FireflyParticles.h)
 struct VertexInputType
 {
     float3 localPosition : POSITION; // Coordenadas del vrtice del quad (-0.5 a 0.5)
     float2 texCoord : TEXCOORD0;
+    float3 particleCenter_World : INSTANCEPOSITION; // Posicion de la luciernaga en el mundo
+    float particleSize : INSTANCESIZE;              // Ancho y alto del quad
+    float4 particleColor : INSTANCECOLOR;           // Color con el parpadeo ya aplicado
 };
 
 struct PixelInputType
@@ -36,18 +31,18 @@ PixelInputType main(VertexInputType input)
 
     // 1. Calcula el desplazamiento del vrtice desde el centro usando los ejes de la cmara
     // Esto asegura que el quad siempre est orientado hacia la cmara.
-    float3 worldOffset = (input.localPosition.x * CameraRight_World * ParticleSize.x) +
-                         (input.localPosition.y * CameraUp_World * ParticleSize.y);
+    float3 worldOffset = (input.localPosition.x * CameraRight_World * input.particleSize) +
+                         (input.localPosition.y * CameraUp_World * input.particleSize);
     
     // 2. Calcula la posicin final del vrtice en el mundo
-    float3 finalWorldPos = ParticleCenter_World + worldOffset;
+    float3 finalWorldPos = input.particleCenter_World + worldOffset;
     
     // 3. Transforma a espacio de recorte
     output.clipSpacePosition = mul(float4(finalWorldPos, 1.0f), transpose(ViewProjection));
     
     // 4. Pasa los datos al Pixel Shader
     output.texCoord = input.texCoord;
-    output.color = ParticleColor;
+    output.color = input.particleColor;
     
     return output;
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 
 #include "pch.h"
 #include "Game.h"
+#include "TerrainScatter.h"
 #include <VertexTypes.h>
 #include <d3dcompiler.h>
 using namespace DirectX::SimpleMath;
@@ -24,10 +25,13 @@ Game::Game() noexcept(false) :
     m_wTapCount(0),
     m_wTapTimer(0.0f),
     m_wKeyWasPressedInPreviousFrame(false),
+    m_cameraFallSpeed(0.0f),
     m_drawDebugCollisions(true),
     m_timeOfDay(0.25f),
     m_dayNightCycleSpeed(0.003f),
-    m_sunPower(0.0f)
+    m_sunPower(0.0f),
+    m_occlusionCullingEnabled(true),
+    m_depthPrepassEnabled(true)
 {
 
     m_deviceResources = std::make_unique<DX::DeviceResources>();
@@ -37,6 +41,10 @@ Game::Game() noexcept(false) :
     m_deviceResources->RegisterDeviceNotify(this);
     m_currentSpeed = m_normalSpeed;
 
+    m_threadPool = std::make_unique<ThreadPool>();
+    m_occlusionCuller = std::make_unique<OcclusionCuller>(256, 128);
+    m_occlusionCuller->SetThreadPool(m_threadPool.get());
+
     m_fireflyVolume = DirectX::BoundingBox(
         DirectX::SimpleMath::Vector3(50.f, -5.f, -150.f),
         DirectX::SimpleMath::Vector3(150.f, 20.f, 200.f)
@@ -108,6 +116,27 @@ void Game::Update(DX::StepTimer const& timer)
         ExitGame();
     }
 
+    if (m_kbTracker.pressed.O)
+    {
+        m_occlusionCullingEnabled = !m_occlusionCullingEnabled;
+    }
+
+    if (m_kbTracker.pressed.P)
+    {
+        m_depthPrepassEnabled = !m_depthPrepassEnabled;
+    }
+
+    if (m_kbTracker.pressed.L && m_terrain)
+    {
+        m_terrain->SetLodEnabled(!m_terrain->IsLodEnabled());
+    }
+
+    // Heightfields paginados: mantener cargadas las teselas alrededor de la camara
+    if (m_terrain)
+    {
+        m_terrain->UpdateHeightStreaming(m_camera->GetPosition());
+    }
+
     bool wKeyIsCurrentlyPressed = m_kbState.W;
 
 
@@ -216,39 +245,37 @@ void Game::Update(DX::StepTimer const& timer)
             float cameraRadius = 0.4f;
             DirectX::BoundingBox cameraFutureBox(nextCamPos, DirectX::SimpleMath::Vector3(cameraRadius, cameraHeight / 2.0f, cameraRadius));
 
+            // Se vaca siempre: sin depuracin no se llena, pero tampoco debe quedar lo del ltimo frame con ella
+            m_modelPartBoxesToDraw.clear();
             if (m_drawDebugCollisions) {
                 m_cameraBoxToDraw = cameraFutureBox;
-                m_modelPartBoxesToDraw.clear();
             }
 
-            for (const auto& instance : m_worldInstances)
+            // Broadphase: solo las instancias cuya esfera de mundo corta la caja (de menor a mayor indice)
+            m_collisionGrid.Query(cameraFutureBox.Center, cameraFutureBox.Extents, m_collisionCandidates);
+            for (uint32_t index : m_collisionCandidates)
             {
+                const GameObjectInstance& instance = m_worldInstances[index];
                 if (!instance.baseModel) continue;
 
-                DirectX::BoundingSphere localSphere = instance.baseModel->GetOverallLocalBoundingSphere();
-                DirectX::BoundingSphere instanceWorldSphere;
-
-                localSphere.Transform(instanceWorldSphere, instance.worldTransform);
-
-                // Opcional: si quieres seguir viendo las esferas de debug que se calculan aqu en Update
-                // if (m_drawDebugCollisions) {
-                //     m_modelSpheresToDraw.push_back(instanceWorldSphere); // PERO RECUERDA que m_modelSpheresToDraw se limpia y llena en Render
-                // }                                                     // para el dibujado final. Esto sera para un debug ms inmediato en Update.
+                // Las cajas de sus partes ya estan en el mundo (ninguna instancia se mueve tras colocarla)
+                if (m_drawDebugCollisions) {
+                    for (size_t part = 0; part < m_worldPartBounds.GetPartCount(instance.partBoundsSlot); ++part) {
+                        DirectX::BoundingBox& box = m_modelPartBoxesToDraw.emplace_back();
+                        m_worldPartBounds.GetPartBox(instance.partBoundsSlot, part, box.Center, box.Extents);
+                    }
+                }
+                const CollisionMesh& mesh = instance.baseModel->GetCollisionMesh();
+                const bool hit = m_worldPartBounds.Overlaps(instance.partBoundsSlot, cameraFutureBox.Center, cameraFutureBox.Extents) &&
+                    (mesh.IsEmpty() || mesh.IntersectsBox(cameraFutureBox.Center, cameraFutureBox.Extents, instance.worldTransform));
 
-                if (cameraFutureBox.Intersects(instanceWorldSphere))
+                if (hit)
                 {
-
-                    if (instance.baseModel->CheckCollisionAgainstParts(cameraFutureBox,
-                        instance.worldTransform, 
-                        m_modelPartBoxesToDraw,
-                        m_drawDebugCollisions))
-                    {
-                        collisionHappened = true;
-                        wchar_t msg[128];
-                        swprintf_s(msg, L"COLISIN DETECTADA (Update) con instancia de modelo %p!\n", instance.baseModel);
-                        OutputDebugString(msg);
-                        break;
-                    }
+                    collisionHappened = true;
+                    wchar_t msg[128];
+                    swprintf_s(msg, L"COLISIN DETECTADA (Update) con instancia de modelo %p!\n", instance.baseModel);
+                    OutputDebugString(msg);
+                    break;
                 }
             }
             // --- FIN DEL NUEVO BUCLE DE COLISIN ---
@@ -259,29 +286,54 @@ void Game::Update(DX::StepTimer const& timer)
         }
 
         // Aplicar movimiento final o revertir
-        if (collisionHappened) {
-            // No mover la cmara, se queda en currentCamPos
-        }
-        else {
-            m_camera->SetPosition(nextCamPos);
-        }
-
-        // --- Ajuste de Altura del Terreno (despus de colisiones con modelos) ---
-        DirectX::SimpleMath::Vector3 finalAttemptCamPos = m_camera->GetPosition();
-        float terrainHeight;
-        if (m_terrain && m_terrain->GetWorldHeightAt(finalAttemptCamPos.x, finalAttemptCamPos.z, terrainHeight)) {
+        DirectX::SimpleMath::Vector3 modelCheckedMovement = collisionHappened ? DirectX::SimpleMath::Vector3::Zero : intendedMovementVector;
+
+        // --- Terreno: capsula del jugador barrida contra el heightfield (despus de colisiones con modelos) ---
+        // Los ojos quedan a cameraHeightAboveTerrain del suelo; la capsula llega de los pies a los ojos.
+        const float cameraHeightAboveTerrain = 15.0f;
+        const float playerRadius = 3.0f;
+        const float maxWalkableSlopeCos = 0.64f; // ~50 grados
+        const float gravity = 90.0f;             // Unidades/s^2 (15 unidades ~ 1.7 m)
+
+        const TerrainCapsuleSweep* capsuleSweep = m_terrain ? &m_terrain->GetCapsuleSweep() : nullptr;
+        if (capsuleSweep && capsuleSweep->IsReady()) {
+            TerrainCapsule capsule;
+            capsule.radius = playerRadius;
+            capsule.height = cameraHeightAboveTerrain - 2.0f * playerRadius;
+            capsule.base = currentCamPos - DirectX::SimpleMath::Vector3(0.0f, cameraHeightAboveTerrain - playerRadius, 0.0f);
+
+            // Se camina en horizontal: las pendientes caminables suben la capsula y las demas la frenan como paredes
+            DirectX::SimpleMath::Vector3 walk(modelCheckedMovement.x, 0.0f, modelCheckedMovement.z);
+            TerrainMoveResult move = capsuleSweep->Move(capsule, walk, maxWalkableSlopeCos);
+            capsule.base = move.base;
+
+            // Pegarse al suelo al bajar una cuesta, o caer con gravedad si no hay suelo cerca
+            float fallDistance = m_cameraFallSpeed * elapsedTime;
+            float snapDistance = fallDistance + walk.Length() * 1.2f + TerrainCapsuleSweep::SKIN;
+            TerrainSweepHit groundHit;
+            if (capsuleSweep->Sweep(capsule, DirectX::XMFLOAT3(0.0f, -snapDistance, 0.0f), groundHit)) {
+                if (groundHit.penetration > 0.0f) capsule.base.y += groundHit.penetration + TerrainCapsuleSweep::SKIN;
+                else capsule.base.y -= std::max(groundHit.t * snapDistance - TerrainCapsuleSweep::SKIN, 0.0f);
+                m_cameraFallSpeed = 0.0f;
+            }
+            else {
+                capsule.base.y -= fallDistance;
+                m_cameraFallSpeed += gravity * elapsedTime;
+            }
 
-            // Esta es la altura de los "ojos" sobre el suelo. Un valor como 2.0f es ms realista.
-            float cameraHeightAboveTerrain = 15.0f;
+            DirectX::SimpleMath::Vector3 eye(capsule.base.x, capsule.base.y + cameraHeightAboveTerrain - playerRadius, capsule.base.z);
 
-            // LA LGICA CORRECTA: Para estar SOBRE el terreno, SUMAMOS la altura.
-            m_camera->SetPosition(DirectX::SimpleMath::Vector3(finalAttemptCamPos.x, terrainHeight + cameraHeightAboveTerrain, finalAttemptCamPos.z));
+            // Red de seguridad: nunca por debajo de la superficie interpolada
+            float terrainHeight;
+            if (m_terrain->GetWorldHeightAt(eye.x, eye.z, terrainHeight) && eye.y < terrainHeight + playerRadius) {
+                eye.y = terrainHeight + playerRadius;
+                m_cameraFallSpeed = 0.0f;
+            }
+            m_camera->SetPosition(eye);
         }
-        else {
-            // Fuera del terreno, podras mantener la Y o aplicar lgica de cada/lmite
+        else if (!collisionHappened) {
+            m_camera->SetPosition(nextCamPos);
         }
-
-        m_camera->UpdateViewMatrix(); // Actualizar la matriz de vista UNA VEZ despus de todos los ajustes de posicin y rotacin
     }
 
 
@@ -352,6 +404,10 @@ void Game::Render()
     // --- Renderizado principal de la escena ---
     DirectX::SimpleMath::Matrix viewMatrix = m_camera->GetViewMatrix();
     DirectX::SimpleMath::Matrix projectionMatrix = m_camera->GetProjectionMatrix();
+    DirectX::SimpleMath::Matrix viewProjectionMatrix = m_camera->GetViewProjectionMatrix();
+
+    // Decidir qu instancias quedan ocultas detrs del terreno o de las casas
+    UpdateOcclusionCulling(viewProjectionMatrix);
 
     // Configurar estados comunes para los objetos opacos
     if (m_states)
@@ -361,44 +417,83 @@ void Game::Render()
         context->RSSetState(m_states->CullCounterClockwise());
     }
 
-    // Dibujar Terreno
-    if (m_terrain)
+    // Pasadas de la escena opaca en el orden de ScenePassPlan (pre-pasada -> terreno -> modelos);
+    // aqu solo se traduce cada una a estados D3D.
+    bool useDepthPrepass = m_depthPrepassEnabled && m_depthPrepassPS_AlphaClip && m_evolvingPS_NoClip && m_depthEqualState;
+    uint8_t visibleAlphaModes = 0;
+    for (size_t i = 0; i < m_worldInstances.size(); ++i)
     {
-        m_terrain->SetViewMatrix(viewMatrix);
-        m_terrain->SetProjectionMatrix(projectionMatrix);
-        m_terrain->Render(context, m_lightPropertiesCB.Get(), m_samplerState.Get(), m_camera->GetPosition(),
-            m_lightViewMatrix * m_lightProjectionMatrix, m_shadowMapSRV.Get(), m_shadowSamplerState.Get());
+        const auto& instance = m_worldInstances[i];
+        if (instance.baseModel && m_instanceVisible[i]) visibleAlphaModes |= instance.baseModel->GetAlphaModeMask();
     }
+    m_scenePasses.Build(useDepthPrepass, visibleAlphaModes);
 
-    // Dibujar Modelos
-    context->RSSetState(m_states->CullNone());
-
-    // Dibujar Modelos
-    for (const auto& instance : m_worldInstances)
+    for (const ScenePass& pass : m_scenePasses.passes)
     {
-        if (instance.baseModel)
-        {
-            // 1. Establecer la matriz de mundo
-            instance.baseModel->SetWorldMatrix(instance.worldTransform);
-
-            // 2. Ya no cambiamos el estado aqu dentro, porque es el mismo para todos
+        context->OMSetDepthStencilState(pass.depthTest == SceneDepthTest::EqualNoWrite ?
+            m_depthEqualState.Get() : m_states->DepthDefault(), 0);
+        context->RSSetState(pass.cullNone ? m_states->CullNone() : m_states->CullCounterClockwise());
 
-            // 3. Dibujar
-            instance.baseModel->EvolvingDraw(
-                context,
-                viewMatrix,
-                projectionMatrix,
-                m_lightPropertiesCB.Get(),
-                m_samplerState.Get(),
-                m_lightViewMatrix,
-                m_lightProjectionMatrix,
-                m_shadowMapSRV.Get(),
-                m_shadowSamplerState.Get()
-            );
+        switch (pass.kind)
+        {
+        case ScenePassKind::DepthPrepass:
+        {
+            const MaterialAlphaMode mode = pass.alphaModes == MaterialAlphaBit(MaterialAlphaMode::Masked) ?
+                MaterialAlphaMode::Masked : MaterialAlphaMode::Opaque;
+            m_deviceResources->PIXBeginEvent(mode == MaterialAlphaMode::Masked ? L"Depth Pre-Pass (Masked)" : L"Depth Pre-Pass");
+            // Sin pixel shader solo se escribe profundidad
+            context->PSSetShader(pass.pixelShader == ScenePixelShader::DepthAlphaClip ? m_depthPrepassPS_AlphaClip.Get() : nullptr, nullptr, 0);
+            context->PSSetSamplers(0, 1, m_samplerState.GetAddressOf());
+            for (size_t i = 0; i < m_worldInstances.size(); ++i)
+            {
+                const auto& instance = m_worldInstances[i];
+                if (instance.baseModel && m_instanceVisible[i])
+                {
+                    instance.baseModel->SetWorldMatrix(instance.worldTransform);
+                    instance.baseModel->DepthPrepassDraw(context, viewMatrix, projectionMatrix, mode);
+                }
+            }
+            m_deviceResources->PIXEndEvent();
+            break;
+        }
+        case ScenePassKind::Terrain:
+            if (m_terrain)
+            {
+                m_terrain->SetViewMatrix(viewMatrix);
+                m_terrain->SetProjectionMatrix(projectionMatrix);
+                m_terrain->Render(context, m_lightPropertiesCB.Get(), m_samplerState.Get(), m_camera->GetPosition(),
+                    m_lightViewMatrix * m_lightProjectionMatrix, m_shadowMapSRV.Get(), m_shadowSamplerState.Get());
+            }
+            break;
+        case ScenePassKind::Models:
+            // Tras la pre-pasada la profundidad ya est escrita: con EQUAL solo se sombrea el
+            // fragmento que qued delante, y sin clip() la GPU lo descarta antes del shader.
+            for (size_t i = 0; i < m_worldInstances.size(); ++i)
+            {
+                const auto& instance = m_worldInstances[i];
+                if (instance.baseModel && m_instanceVisible[i])
+                {
+                    instance.baseModel->SetWorldMatrix(instance.worldTransform);
+                    instance.baseModel->EvolvingDraw(
+                        context,
+                        viewMatrix,
+                        projectionMatrix,
+                        m_lightPropertiesCB.Get(),
+                        m_samplerState.Get(),
+                        m_lightViewMatrix,
+                        m_lightProjectionMatrix,
+                        m_shadowMapSRV.Get(),
+                        m_shadowSamplerState.Get(),
+                        pass.pixelShader == ScenePixelShader::EvolvingNoClip ? m_evolvingPS_NoClip.Get() : nullptr
+                    );
+                }
+            }
+            break;
         }
     }
     // Restaurar el estado por defecto despus del bucle
     context->RSSetState(m_states->CullCounterClockwise());
+    context->OMSetDepthStencilState(m_states->DepthDefault(), 0);
 
     if (m_drawDebugCollisions)
     {
@@ -608,10 +703,11 @@ void Game::Render()
         context->PSSetShader(m_fireflyPS.Get(), nullptr, 0);
         context->IASetInputLayout(m_fireflyInputLayout.Get());
 
-        // Geometra del quad (la misma para todas las partculas)
-        UINT stride = sizeof(DirectX::VertexPositionTexture);
-        UINT offset = 0;
-        context->IASetVertexBuffers(0, 1, m_fireflyVertexBuffer.GetAddressOf(), &stride, &offset);
+        // Slot 0: geometria del quad (la misma para todas las particulas); slot 1: una instancia por particula
+        ID3D11Buffer* fireflyBuffers[2] = { m_fireflyVertexBuffer.Get(), m_fireflyInstanceBuffer.Get() };
+        UINT strides[2] = { sizeof(DirectX::VertexPositionTexture), sizeof(FireflyInstance) };
+        UINT offsets[2] = { 0, 0 };
+        context->IASetVertexBuffers(0, 2, fireflyBuffers, strides, offsets);
         context->IASetIndexBuffer(m_fireflyIndexBuffer.Get(), DXGI_FORMAT_R16_UINT, 0);
         context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
@@ -624,7 +720,7 @@ void Game::Render()
         D3D11_MAPPED_SUBRESOURCE mappedResource;
         context->Map(m_cbFireflyPerFrame.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
         auto perFrameData = reinterpret_cast<CB_Firefly_PerFrame*>(mappedResource.pData);
-        perFrameData->ViewProjection = m_camera->GetViewMatrix() * m_camera->GetProjectionMatrix();
+        perFrameData->ViewProjection = m_camera->GetViewProjectionMatrix();
         perFrameData->CameraRight_World = m_camera->GetRight();
         perFrameData->CameraUp_World = m_camera->GetUp();
         context->Unmap(m_cbFireflyPerFrame.Get(), 0);
@@ -634,25 +730,17 @@ void Game::Render()
         context->PSSetShaderResources(0, 1, m_fireflyTexture.GetAddressOf());
         context->PSSetSamplers(0, 1, m_samplerState.GetAddressOf());
 
-        // 4. Bucle para dibujar cada partcula
-        for (const auto& firefly : m_fireflies)
+        // 4. Subir todas las particulas visibles de una vez y dibujarlas con una sola llamada
+        size_t fireflyCount = 0;
+        if (SUCCEEDED(context->Map(m_fireflyInstanceBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource)))
         {
-            // Actualizar el Constant Buffer "PerParticle" para esta lucirnaga
-            context->Map(m_cbFireflyPerParticle.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-            auto perParticleData = reinterpret_cast<CB_Firefly_PerParticle*>(mappedResource.pData);
-
-            float blink = (sin(firefly.blinkTimer) + 1.0f) / 2.0f;
-            blink = pow(blink, 3.0f);
-
-            perParticleData->ParticleCenter_World = firefly.position;
-            perParticleData->ParticleColor = DirectX::SimpleMath::Vector4(1.5f, 2.0f, 1.0f, 1.0f) * blink;
-            perParticleData->ParticleSize = { 0.5f, 0.5f }; // <--- JUEGA CON ESTE TAMAO!
-
-            context->Unmap(m_cbFireflyPerParticle.Get(), 0);
-            context->VSSetConstantBuffers(1, 1, m_cbFireflyPerParticle.GetAddressOf());
-
-            // Dibujar el quad
-            context->DrawIndexed(6, 0, 0);
+            fireflyCount = m_fireflies.Pack(0.5f, // <--- JUEGA CON ESTE TAMANO!
+                DirectX::XMFLOAT4(1.5f, 2.0f, 1.0f, 1.0f), reinterpret_cast<FireflyInstance*>(mappedResource.pData), NUM_FIREFLIES);
+            context->Unmap(m_fireflyInstanceBuffer.Get(), 0);
+        }
+        if (fireflyCount > 0)
+        {
+            context->DrawIndexedInstanced(6, static_cast<UINT>(fireflyCount), 0, 0, 0);
         }
 
         // MUY IMPORTANTE: Restaurar el estado de profundidad por defecto despus de terminar
@@ -667,17 +755,25 @@ void Game::Render()
         m_spriteBatchUI->Begin(SpriteSortMode_Deferred, m_states->AlphaBlend());
         wchar_t buffer[256];
         // Mostramos Posicin X, Y, Z y Rotacin Yaw, Pitch en grados para facilitar la lectura
-        swprintf_s(buffer, L"Pos: (%.2f, %.2f, %.2f)\nYaw: %.1f deg\nPitch: %.1f deg",
+        const OcclusionStats& occlusionStats = m_occlusionCuller->GetStats();
+        swprintf_s(buffer, L"Pos: (%.2f, %.2f, %.2f)\nYaw: %.1f deg\nPitch: %.1f deg\nOclusion [O]: %ls %d/%d ocultos (%.2f + %.2f ms)\nPre-pasada Z [P]: %ls\nTerreno LOD [L]: %ls %d tris, %d bloques",
             m_camera->GetPosition().x, m_camera->GetPosition().y, m_camera->GetPosition().z,
             DirectX::XMConvertToDegrees(m_camera->GetYaw()),
-            DirectX::XMConvertToDegrees(m_camera->GetPitch()));
+            DirectX::XMConvertToDegrees(m_camera->GetPitch()),
+            m_occlusionCullingEnabled ? L"ON" : L"OFF",
+            occlusionStats.culledBoxes, occlusionStats.testedBoxes,
+            occlusionStats.rasterizeMs, occlusionStats.testMs,
+            m_depthPrepassEnabled ? L"ON" : L"OFF",
+            m_terrain->IsLodEnabled() ? L"ON" : L"OFF",
+            m_terrain->GetLastDrawnTriangleCount(), m_terrain->GetLastVisibleChunkCount());
 
         DirectX::SimpleMath::Vector2 textPosition(10.0f, 10.0f);
         DirectX::SimpleMath::Vector4 textColor(1.0f, 1.0f, 0.0f, 1.0f);
 
         m_font->DrawString(m_spriteBatchUI.get(), buffer, textPosition, textColor);
 
-        RECT minimapRect = { 10, 150, 10 + MINIMAP_SIZE, 150 + MINIMAP_SIZE };
+        RECT minimapRect = { 10, 215, 10 + MINIMAP_SIZE, 215 + MINIMAP_SIZE };
+
         m_spriteBatchUI->Draw(m_minimapSRV.Get(), minimapRect);
 
         // 2. Dibuja el icono del jugador en el centro del minimapa
@@ -847,6 +943,11 @@ void Game::CreateDeviceDependentResources()
     m_states = std::make_unique<DirectX::CommonStates>(device);
     m_samplerState = m_states->LinearWrap();
 
+    // Un solo registro de shaders para todo el juego. Shaders.pack se genera al compilar
+    // (BuildShaderPack.ps1) junto al ejecutable; si falta se leen los .cso sueltos de esa carpeta.
+    m_shaderRegistry = std::make_unique<ShaderRegistry>(device);
+    m_shaderRegistry->LoadShaderPack(ShaderRegistry::GetExecutableDirectory() / L"Shaders.pack");
+
     D3D11_BUFFER_DESC cbd_lights = {};
     cbd_lights.Usage = D3D11_USAGE_DYNAMIC;
     cbd_lights.ByteWidth = sizeof(PSLightPropertiesData); 
@@ -887,7 +988,6 @@ void Game::CreateDeviceDependentResources()
     m_camera = std::make_unique<Camera>(width, height);
     m_camera->SetPosition(DirectX::SimpleMath::Vector3(11.2f, 5.0f, -72.0f));
     // m_camera->SetRotation(yaw, pitch); // Opcional si quieres una rotacin inicial especfica
-    m_camera->UpdateViewMatrix(); // Asegura que la matriz de vista se calcule inicialmente
     
 
     m_spriteBatch3D = std::make_unique<DirectX::SpriteBatch>(context);
@@ -962,6 +1062,8 @@ void Game::CreateDeviceDependentResources()
     }
     
     m_terrain = std::make_unique<Terrain>();
+    m_terrain->SetThreadPool(m_threadPool.get());
+    m_terrain->SetVertexStream(TerrainVertexStream::Compact); // Solo alturas de 16 bits en la GPU
     // ASEGRATE DE QUE ESTOS NOMBRES DE ARCHIVO Y RUTAS SEAN CORRECTOS:
     // 1. Que los archivos existan en "GameAssets/Textures/" en tu proyecto.
     // 2. Que su propiedad "Copiar en el directorio de salida" est en "Copiar si es posterior".
@@ -970,8 +1072,9 @@ void Game::CreateDeviceDependentResources()
         L"GameAssets\\Textures\\dirt.jpg",                       
         L"GameAssets\\Textures\\terrain\\tilable-IMG_0044-grey.png",  
         L"GameAssets\\Textures\\terrain\\tilable-IMG_0044-grey1.png",               
-        L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\TerrainVS.cso",
-        L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\TerrainPS.cso"))
+        *m_shaderRegistry,
+        L"TerrainVS",
+        L"TerrainPS"))
     {
         OutputDebugString(L"ERROR: Fall la inicializacin del terreno desde Game.cpp\n");
         throw std::runtime_error("Failed to initialize terrain.");
@@ -1025,6 +1128,8 @@ void Game::CreateDeviceDependentResources()
 
 
         m_terrain->SetWorldMatrix(terrainWorld);
+        m_terrain->LogLodReport();
+
     }
     
     // 3D Models
@@ -1039,7 +1144,7 @@ void Game::CreateDeviceDependentResources()
     if (m_blacksmith) // Asegrate de que el modelo principal se carg
     {
         // Asegrate de que DebugVS.cso y DebugPS.cso estn en tu directorio de salida
-        if (!m_blacksmith->LoadEvolvingShaders(device, L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingVS.cso", L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingPS.cso"))
+        if (!m_blacksmith->LoadEvolvingShaders(*m_shaderRegistry, L"EvolvingVS", L"EvolvingPS"))
         {
             throw std::runtime_error("Failed to load debug shaders for m_blacksmith!");
         }
@@ -1059,7 +1164,7 @@ void Game::CreateDeviceDependentResources()
 
     if (m_green_tree1)
     {
-        if (!m_green_tree1->LoadEvolvingShaders(device, L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingVS.cso", L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingPS.cso"))
+        if (!m_green_tree1->LoadEvolvingShaders(*m_shaderRegistry, L"EvolvingVS", L"EvolvingPS"))
         {
             throw std::runtime_error("Failed to load debug shaders for m_green_tree1!");
         }
@@ -1078,7 +1183,7 @@ void Game::CreateDeviceDependentResources()
 
     if (m_forest_pine1)
     {
-        if (!m_forest_pine1->LoadEvolvingShaders(device, L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingVS.cso", L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingPS.cso"))
+        if (!m_forest_pine1->LoadEvolvingShaders(*m_shaderRegistry, L"EvolvingVS", L"EvolvingPS"))
         {
             throw std::runtime_error("Failed to load debug shaders for m_forest_pine1!");
         }
@@ -1097,7 +1202,7 @@ void Game::CreateDeviceDependentResources()
 
     if (m_forest_pine2)
     {
-        if (!m_forest_pine2->LoadEvolvingShaders(device, L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingVS.cso", L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingPS.cso"))
+        if (!m_forest_pine2->LoadEvolvingShaders(*m_shaderRegistry, L"EvolvingVS", L"EvolvingPS"))
         {
             throw std::runtime_error("Failed to load debug shaders for m_forest_pine2!");
         }
@@ -1116,7 +1221,7 @@ void Game::CreateDeviceDependentResources()
 
     if (m_forest_pine3)
     {
-        if (!m_forest_pine3->LoadEvolvingShaders(device, L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingVS.cso", L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingPS.cso"))
+        if (!m_forest_pine3->LoadEvolvingShaders(*m_shaderRegistry, L"EvolvingVS", L"EvolvingPS"))
         {
             throw std::runtime_error("Failed to load debug shaders for m_forest_pine3!");
         }
@@ -1137,7 +1242,7 @@ void Game::CreateDeviceDependentResources()
 
     if (m_cart)
     {
-        if (!m_cart->LoadEvolvingShaders(device, L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingVS.cso", L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingPS.cso"))
+        if (!m_cart->LoadEvolvingShaders(*m_shaderRegistry, L"EvolvingVS", L"EvolvingPS"))
         {
             throw std::runtime_error("Failed to load debug shaders for m_cart!");
         }
@@ -1155,7 +1260,7 @@ void Game::CreateDeviceDependentResources()
 
     if (m_windmill)
     {
-        if (!m_windmill->LoadEvolvingShaders(device, L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingVS.cso", L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingPS.cso"))
+        if (!m_windmill->LoadEvolvingShaders(*m_shaderRegistry, L"EvolvingVS", L"EvolvingPS"))
         {
             throw std::runtime_error("Failed to load debug shaders for m_windmill!");
         }
@@ -1173,7 +1278,7 @@ void Game::CreateDeviceDependentResources()
 
     if (m_rock1)
     {
-        if (!m_rock1->LoadEvolvingShaders(device, L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingVS.cso", L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingPS.cso"))
+        if (!m_rock1->LoadEvolvingShaders(*m_shaderRegistry, L"EvolvingVS", L"EvolvingPS"))
         {
             throw std::runtime_error("Failed to load debug shaders for m_rock1!");
         }
@@ -1191,7 +1296,7 @@ void Game::CreateDeviceDependentResources()
 
     if (m_rock2)
     {
-        if (!m_rock2->LoadEvolvingShaders(device, L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingVS.cso", L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingPS.cso"))
+        if (!m_rock2->LoadEvolvingShaders(*m_shaderRegistry, L"EvolvingVS", L"EvolvingPS"))
         {
             throw std::runtime_error("Failed to load debug shaders for m_rock2!");
         }
@@ -1209,7 +1314,7 @@ void Game::CreateDeviceDependentResources()
 
     if (m_rock3)
     {
-        if (!m_rock3->LoadEvolvingShaders(device, L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingVS.cso", L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingPS.cso"))
+        if (!m_rock3->LoadEvolvingShaders(*m_shaderRegistry, L"EvolvingVS", L"EvolvingPS"))
         {
             throw std::runtime_error("Failed to load debug shaders for m_rock3!");
         }
@@ -1227,7 +1332,7 @@ void Game::CreateDeviceDependentResources()
 
     if (m_rock4)
     {
-        if (!m_rock1->LoadEvolvingShaders(device, L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingVS.cso", L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingPS.cso"))
+        if (!m_rock4->LoadEvolvingShaders(*m_shaderRegistry, L"EvolvingVS", L"EvolvingPS"))
         {
             throw std::runtime_error("Failed to load debug shaders for m_rock4!");
         }
@@ -1245,7 +1350,7 @@ void Game::CreateDeviceDependentResources()
 
     if (m_rock5)
     {
-        if (!m_rock5->LoadEvolvingShaders(device, L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingVS.cso", L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingPS.cso"))
+        if (!m_rock5->LoadEvolvingShaders(*m_shaderRegistry, L"EvolvingVS", L"EvolvingPS"))
         {
             throw std::runtime_error("Failed to load debug shaders for m_rock5!");
         }
@@ -1263,7 +1368,7 @@ void Game::CreateDeviceDependentResources()
 
     if (m_rock6)
     {
-        if (!m_rock6->LoadEvolvingShaders(device, L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingVS.cso", L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingPS.cso"))
+        if (!m_rock6->LoadEvolvingShaders(*m_shaderRegistry, L"EvolvingVS", L"EvolvingPS"))
         {
             throw std::runtime_error("Failed to load debug shaders for m_rock6!");
         }
@@ -1282,7 +1387,7 @@ void Game::CreateDeviceDependentResources()
 
     if (m_house1)
     {
-        if (!m_house1->LoadEvolvingShaders(device, L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingVS.cso", L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingPS.cso"))
+        if (!m_house1->LoadEvolvingShaders(*m_shaderRegistry, L"EvolvingVS", L"EvolvingPS"))
         {
             throw std::runtime_error("Failed to load debug shaders for m_house1!");
         }
@@ -1302,7 +1407,7 @@ void Game::CreateDeviceDependentResources()
 
     if (m_house2)
     {
-        if (!m_house2->LoadEvolvingShaders(device, L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingVS.cso", L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingPS.cso"))
+        if (!m_house2->LoadEvolvingShaders(*m_shaderRegistry, L"EvolvingVS", L"EvolvingPS"))
         {
             throw std::runtime_error("Failed to load debug shaders for m_house2!");
         }
@@ -1321,7 +1426,7 @@ void Game::CreateDeviceDependentResources()
 
     if (m_house3)
     {
-        if (!m_house3->LoadEvolvingShaders(device, L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingVS.cso", L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingPS.cso"))
+        if (!m_house3->LoadEvolvingShaders(*m_shaderRegistry, L"EvolvingVS", L"EvolvingPS"))
         {
             throw std::runtime_error("Failed to load debug shaders for m_house3!");
         }
@@ -1340,7 +1445,7 @@ void Game::CreateDeviceDependentResources()
 
     if (m_house4)
     {
-        if (!m_house4->LoadEvolvingShaders(device, L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingVS.cso", L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingPS.cso"))
+        if (!m_house4->LoadEvolvingShaders(*m_shaderRegistry, L"EvolvingVS", L"EvolvingPS"))
         {
             throw std::runtime_error("Failed to load debug shaders for m_house4!");
         }
@@ -1357,7 +1462,7 @@ void Game::CreateDeviceDependentResources()
     }
     if (m_knight)
     {
-        if (!m_knight->LoadEvolvingShaders(device, L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingVS.cso", L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\EvolvingPS.cso"))
+        if (!m_knight->LoadEvolvingShaders(*m_shaderRegistry, L"EvolvingVS", L"EvolvingPS"))
         {
             throw std::runtime_error("Failed to load debug shaders for m_knight!");
         }
@@ -1372,6 +1477,8 @@ void Game::CreateDeviceDependentResources()
     InitializeFireflies();
 
     m_worldInstances.clear();
+    m_collisionGrid.Clear();
+    m_worldPartBounds.Clear();
 
     const float offsetY_pine1 = -7.0f;
     const float offsetY_pine2 = -1.0f;
@@ -1381,77 +1488,118 @@ void Game::CreateDeviceDependentResources()
 
     DirectX::SimpleMath::Matrix baseTransform;
 
-    if (m_forest_pine1 && m_terrain) {
-        baseTransform = m_forest_pine1->GetWorldMatrix(); 
-        const std::vector<std::tuple<float, float, float>> pine1_data = {
-            {222.93f, -102.9f,  -7.0f}, {196.91f, -241.45f, -2.0f}, {81.28f,  -103.99f, -2.0f},
-            {83.29f,  -216.94f, -7.0f}, {114.82f, -83.19f,  -3.0f}, {146.82f, -244.59f, -9.90f},
-            {-151.1f, -96.5f,   -7.0f}, {-238.7f, -49.85f,  -7.0f}, {-215.8f, 42.1f,    -7.0f},
-            {-1.93f,  34.34f,    8.0f}, {-24.93f, -135.34f, -7.0f}
+    // Vegetacion: disco de Poisson sobre el terreno con reglas de altura y pendiente por especie,
+    // sin arboles alrededor de los edificios. Misma semilla = mismo bosque.
+    if (m_terrain) {
+        struct ScatterSpecies { Model* model; float offsetY; };
+        const ScatterSpecies species[] = {
+            { m_forest_pine1.get(), offsetY_pine1 },
+            { m_forest_pine2.get(), offsetY_pine2 },
+            { m_forest_pine3.get(), offsetY_pine3 },
+            { m_green_tree1.get(), offsetY_green_tree1 }
         };
-        for (const auto& data : pine1_data) {
-            AddInstancedObject(m_forest_pine1.get(), baseTransform, std::get<0>(data), std::get<1>(data), std::get<2>(data), offsetY_pine1);
-        }
-    }
 
-    // === Instancias de m_forest_pine2 ===
-    if (m_forest_pine2 && m_terrain) {
-        baseTransform = m_forest_pine2->GetWorldMatrix();
-        const std::vector<std::tuple<float, float, float>> pine2_data = {
-            {-78.17f, -9.94f,    5.0f}, {-86.17f, -117.03f,  5.0f}, {-178.17f, -133.03f, 1.0f},
-            {132.84f, -106.03f, 1.0f}, {48.45f,  -185.03f,  1.0f}, {151.50f, 13.02f,    1.0f}
-        };
-        for (const auto& data : pine2_data) {
-            AddInstancedObject(m_forest_pine2.get(), baseTransform, std::get<0>(data), std::get<1>(data), std::get<2>(data), offsetY_pine2);
+        TerrainScatterRule rules[4];
+        rules[0].density = 0.25f; // Pinos grandes: laderas y alturas medias
+        rules[0].minHeight = -15.0f;
+        rules[0].maxHeight = 200.0f;
+        rules[0].heightFade = 10.0f;
+        rules[0].minNormalY = 0.75f;
+        rules[0].normalFade = 0.1f;
+        rules[0].minScale = 0.85f;
+        rules[0].maxScale = 1.15f;
+        rules[1] = rules[0];      // Pinos medianos y pequenos: un poco mas abajo
+        rules[1].density = 0.2f;
+        rules[1].maxHeight = 120.0f;
+        rules[2] = rules[1];
+        rules[2].density = 0.15f;
+        rules[3].density = 0.3f;  // Arboles de hoja: solo en el valle y en terreno llano
+        rules[3].maxHeight = 40.0f;
+        rules[3].heightFade = 15.0f;
+        rules[3].minNormalY = 0.9f;
+        rules[3].normalFade = 0.05f;
+        rules[3].minScale = 0.9f;
+        rules[3].maxScale = 1.1f;
+        for (int i = 0; i < 4; ++i) {
+            if (!species[i].model) rules[i].density = 0.0f;
         }
-    }
-    
-    // === Instancias de m_forest_pine3 ===
-    if (m_forest_pine3 && m_terrain) {
-        baseTransform = m_forest_pine3->GetWorldMatrix();
-        const std::vector<std::tuple<float, float, float>> pine3_data = {
-            {96.50f, 125.02f,  1.0f}, {-221.11f, -75.25f,1.0f}, {-0.57f, -28.85f,  3.0f}
+
+        const TerrainScatterExclusion buildingZones[] = {
+            { 215.7f, -177.07f, 35.0f }, // Herrero
+            { 188.0f, 100.0f, 35.0f },   // Casas
+            { -97.2f, 161.0f, 35.0f },
+            { -88.2f, -209.0f, 35.0f },
+            { 243.79f, -32.0f, 35.0f },
+            { -203.6f, -23.9f, 30.0f },  // Molino
+            { 154.8f, -137.55f, 15.0f }, // Carreta
+            { 6.15f, -256.0f, 10.0f },   // Caballero
+            { -79.10f, -118.56f, 10.0f } // Roca
         };
-        for (const auto& data : pine3_data) {
-            AddInstancedObject(m_forest_pine3.get(), baseTransform, std::get<0>(data), std::get<1>(data), std::get<2>(data), offsetY_pine3);
+
+        TerrainScatterSettings settings;
+        settings.seed = 7;
+        settings.minX = -260.0f;
+        settings.minZ = -260.0f;
+        settings.maxX = 260.0f;
+        settings.maxZ = 260.0f;
+        settings.minDistance = 28.0f;
+
+        std::vector<TerrainScatterInstance> trees;
+        TerrainScatterStats scatterStats;
+        if (!TerrainScatter::Scatter(m_terrain->GetHeightSampler(), settings, rules, 4,
+            buildingZones, sizeof(buildingZones) / sizeof(buildingZones[0]), trees, m_threadPool.get(), &scatterStats))
+        {
+            wchar_t line[160];
+            if (scatterStats.regionTooLarge)
+            {
+                swprintf_s(line, L"Vegetacion: la region pide %.0f celdas (limite %zu) para minDistance %.1f\n",
+                    scatterStats.cellCount, TerrainScatter::MAX_CELLS, settings.minDistance);
+            }
+            else
+            {
+                swprintf_s(line, L"Vegetacion: parametros de TerrainScatter no validos\n");
+            }
+            OutputDebugString(line);
         }
-    }
-    
-    // === Instancias de m_green_tree1 ===
-    if (m_green_tree1 && m_terrain) {
-        baseTransform = m_green_tree1->GetWorldMatrix();
-        const std::vector<std::tuple<float, float, float>> green_tree1_data = {
-            {62.2f, 25.8f,  12.0f}, {-24.2f, -70.8f, 13.0f}, {-103.2f, -61.01f,6.0f}
-        };
-        for (const auto& data : green_tree1_data) {
-            AddInstancedObject(m_green_tree1.get(), baseTransform, std::get<0>(data), std::get<1>(data), std::get<2>(data), offsetY_green_tree1);
+        else
+        {
+            for (const auto& tree : trees) {
+                const ScatterSpecies& treeSpecies = species[tree.rule];
+                baseTransform = DirectX::SimpleMath::Matrix::CreateScale(tree.scale) * treeSpecies.model->GetWorldMatrix() *
+                    DirectX::SimpleMath::Matrix::CreateRotationY(tree.yaw);
+                AddInstancedObject(treeSpecies.model, baseTransform, tree.x, tree.z, tree.y, treeSpecies.offsetY);
+            }
+            wchar_t line[96];
+            swprintf_s(line, L"Vegetacion: %zu arboles\n", trees.size());
+            OutputDebugString(line);
         }
     }
 
+    // Los edificios son macizos y grandes: se usan tambin como oclusores
     if (m_blacksmith && m_terrain) { // El herrero tambin podra necesitar ajuste al terreno
         baseTransform = m_blacksmith->GetWorldMatrix();
         // Decide una posicin X, Z, Y-fallback y offsetY para el herrero
-        AddInstancedObject(m_blacksmith.get(), baseTransform, 215.7f, -177.07f, -9.0f, 0.0f); // offsetY=0 si su origen est bien
+        AddInstancedObject(m_blacksmith.get(), baseTransform, 215.7f, -177.07f, -9.0f, 0.0f, true); // offsetY=0 si su origen est bien
     }
 
     if (m_house1 && m_terrain) { 
         baseTransform = m_house1->GetWorldMatrix();
-        AddInstancedObject(m_house1.get(), baseTransform, 188.0f, 100.0f,-9.0f, 0.0f);
+        AddInstancedObject(m_house1.get(), baseTransform, 188.0f, 100.0f,-9.0f, 0.0f, true);
     }
 
     if (m_house2 && m_terrain) {
         baseTransform = m_house2->GetWorldMatrix();
-        AddInstancedObject(m_house2.get(), baseTransform, -97.2f, 161.0f, -9.0f, 0.0f);
+        AddInstancedObject(m_house2.get(), baseTransform, -97.2f, 161.0f, -9.0f, 0.0f, true);
     }
 
     if (m_house3 && m_terrain) {
         baseTransform = m_house3->GetWorldMatrix();
-        AddInstancedObject(m_house3.get(), baseTransform, -88.2f, -209.0f, -9.0f, 0.0f);
+        AddInstancedObject(m_house3.get(), baseTransform, -88.2f, -209.0f, -9.0f, 0.0f, true);
     }
 
     if (m_house4 && m_terrain) {
         baseTransform = m_house4->GetWorldMatrix();
-        AddInstancedObject(m_house4.get(), baseTransform, 243.79f, -32.0f, -9.0f, 0.0f);
+        AddInstancedObject(m_house4.get(), baseTransform, 243.79f, -32.0f, -9.0f, 0.0f, true);
     }
 
     if (m_knight && m_terrain) {
@@ -1476,6 +1624,8 @@ void Game::CreateDeviceDependentResources()
         AddInstancedObject(m_rock1.get(), baseTransform, -79.10f, -118.56f, 5.0f, offsetY_rock);
     }
 
+    BuildShadowCasterBatches();
+
     DirectX::VertexPositionTexture quadVertices[] =
     {
         { DirectX::SimpleMath::Vector3(-0.5f,  0.5f, 0.f), DirectX::SimpleMath::Vector2(0, 0) }, // Top-Left
@@ -1503,44 +1653,48 @@ void Game::CreateDeviceDependentResources()
     if (FAILED(hr)) throw std::runtime_error("Fallo al crear el index buffer de las lucirnagas.");
 
     // 2. Cargar y crear los shaders de las lucirnagas
-    Microsoft::WRL::ComPtr<ID3DBlob> vsBlob, psBlob;
-    hr = D3DReadFileToBlob(L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\FireflyVS.cso", vsBlob.GetAddressOf());
-    if (FAILED(hr)) throw std::runtime_error("Fallo al cargar FireflyVS.cso.");
-    hr = device->CreateVertexShader(vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), nullptr, m_fireflyVS.ReleaseAndGetAddressOf());
-    if (FAILED(hr)) throw std::runtime_error("Fallo al crear el Firefly Vertex Shader.");
+    m_fireflyVS = m_shaderRegistry->GetVertexShader(L"FireflyVS");
+    if (!m_fireflyVS) throw std::runtime_error("Fallo al crear el Firefly Vertex Shader.");
 
-    hr = D3DReadFileToBlob(L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\FireflyPS.cso", psBlob.GetAddressOf());
-    if (FAILED(hr)) throw std::runtime_error("Fallo al cargar FireflyPS.cso.");
-    hr = device->CreatePixelShader(psBlob->GetBufferPointer(), psBlob->GetBufferSize(), nullptr, m_fireflyPS.ReleaseAndGetAddressOf());
-    if (FAILED(hr)) throw std::runtime_error("Fallo al crear el Firefly Pixel Shader.");
+    m_fireflyPS = m_shaderRegistry->GetPixelShader(L"FireflyPS");
+    if (!m_fireflyPS) throw std::runtime_error("Fallo al crear el Firefly Pixel Shader.");
 
     // 3. Crear el Input Layout para los vrtices del quad
     const D3D11_INPUT_ELEMENT_DESC fireflyLayoutDesc[] =
     {
         { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
         { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT,    0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "INSTANCEPOSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT,    1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+        { "INSTANCESIZE",     0, DXGI_FORMAT_R32_FLOAT,          1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+        { "INSTANCECOLOR",    0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
     };
 
-    hr = device->CreateInputLayout(
-        fireflyLayoutDesc,
-        ARRAYSIZE(fireflyLayoutDesc),
-        vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(),
-        m_fireflyInputLayout.ReleaseAndGetAddressOf());
-
-    if (FAILED(hr)) throw std::runtime_error("Fallo al crear el input layout de las lucirnagas.");
+    m_fireflyInputLayout = m_shaderRegistry->GetInputLayout(fireflyLayoutDesc, ARRAYSIZE(fireflyLayoutDesc), L"FireflyVS");
+    if (!m_fireflyInputLayout) throw std::runtime_error("Fallo al crear el input layout de las lucirnagas.");
     // 4. Crear los Constant Buffers
     CD3D11_BUFFER_DESC cbd(sizeof(CB_Firefly_PerFrame), D3D11_BIND_CONSTANT_BUFFER, D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
     hr = device->CreateBuffer(&cbd, nullptr, m_cbFireflyPerFrame.ReleaseAndGetAddressOf());
     if (FAILED(hr)) throw std::runtime_error("Fallo al crear el CB PerFrame de las lucirnagas.");
 
-    cbd.ByteWidth = sizeof(CB_Firefly_PerParticle);
-    hr = device->CreateBuffer(&cbd, nullptr, m_cbFireflyPerParticle.ReleaseAndGetAddressOf());
-    if (FAILED(hr)) throw std::runtime_error("Fallo al crear el CB PerParticle de las lucirnagas.");
+    // 5. Buffer de instancias: se reescribe entero cada frame con las particulas visibles
+    CD3D11_BUFFER_DESC instanceDesc(sizeof(FireflyInstance) * NUM_FIREFLIES, D3D11_BIND_VERTEX_BUFFER, D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
+    hr = device->CreateBuffer(&instanceDesc, nullptr, m_fireflyInstanceBuffer.ReleaseAndGetAddressOf());
+    if (FAILED(hr)) throw std::runtime_error("Fallo al crear el buffer de instancias de las lucirnagas.");
 
 
+    // Atlas 2x2: un cuadrante de SHADOW_MAP_SIZE por cascada
+    m_shadowCascades.SetCascadeCount(ShadowCascades::MAX_CASCADES);
+    m_shadowCascades.SetResolution(SHADOW_MAP_SIZE);
+    // Shadow map cacheado: origen en teselas de 128 texeles, re-render si la luz gira mas de 0.25 grados
+    // (unos 0.23 s del ciclo de dia), como mucho dos cascadas por frame
+    m_shadowCascades.SetSnapTexels(128);
+    m_shadowCache.SetLightAngleThreshold(DirectX::XMConvertToRadians(0.25f));
+    m_shadowCache.SetCascadesPerFrame(2);
+    m_shadowCache.Invalidate();
+
     D3D11_TEXTURE2D_DESC texDesc = {};
-    texDesc.Width = SHADOW_MAP_SIZE;
-    texDesc.Height = SHADOW_MAP_SIZE;
+    texDesc.Width = SHADOW_MAP_SIZE * 2;
+    texDesc.Height = SHADOW_MAP_SIZE * 2;
     texDesc.MipLevels = 1;
     texDesc.ArraySize = 1;
     texDesc.Format = DXGI_FORMAT_R32_TYPELESS; 
@@ -1567,6 +1721,17 @@ void Game::CreateDeviceDependentResources()
     hr = device->CreateShaderResourceView(m_shadowMapTexture.Get(), &srvDesc, m_shadowMapSRV.ReleaseAndGetAddressOf());
     if (FAILED(hr)) throw std::runtime_error("Fallo al crear el SRV del shadow map.");
 
+    D3D11_DEPTH_STENCIL_DESC tileClearDesc = {};
+    tileClearDesc.DepthEnable = TRUE;
+    tileClearDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
+    tileClearDesc.DepthFunc = D3D11_COMPARISON_ALWAYS;
+    hr = device->CreateDepthStencilState(&tileClearDesc, m_shadowTileClearState.ReleaseAndGetAddressOf());
+    if (FAILED(hr)) throw std::runtime_error("Fallo al crear el estado para borrar cuadrantes del shadow map.");
+
+    CD3D11_BUFFER_DESC cascadeCBDesc(sizeof(CB_ShadowCascades), D3D11_BIND_CONSTANT_BUFFER, D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
+    hr = device->CreateBuffer(&cascadeCBDesc, nullptr, m_shadowCascadeCB.ReleaseAndGetAddressOf());
+    if (FAILED(hr)) throw std::runtime_error("Fallo al crear el constant buffer de las cascadas de sombra.");
+
     D3D11_SAMPLER_DESC samplerDesc = {};
     samplerDesc.Filter = D3D11_FILTER_COMPARISON_MIN_MAG_MIP_LINEAR;
     samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_BORDER;
@@ -1595,35 +1760,20 @@ void Game::CreateDeviceDependentResources()
     if (FAILED(hr)) throw std::runtime_error("Fallo al crear el estado de rasterizador para sombras.");
 
 
-    hr = D3DReadFileToBlob(L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\ShadowVS.cso", vsBlob.GetAddressOf());
-    if (FAILED(hr))
-    {
-        throw std::runtime_error("Fallo al cargar ShadowVS.cso. Revisa la ruta y asegrate de que compila.");
-    }
-
-    hr = device->CreateVertexShader(vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), nullptr, m_shadowVertexShader.ReleaseAndGetAddressOf());
-    if (FAILED(hr))
+    m_shadowVertexShader = m_shaderRegistry->GetVertexShader(L"ShadowVS");
+    if (!m_shadowVertexShader)
     {
         throw std::runtime_error("Fallo al crear el vertex shader de sombras.");
     }
 
-    hr = D3DReadFileToBlob(L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\ShadowPS.cso", psBlob.GetAddressOf()); // O la ruta completa si es necesario
-    if (FAILED(hr))
-    {
-        throw std::runtime_error("Fallo al cargar ShadowPS.cso.");
-    }
-
-    hr = device->CreatePixelShader(psBlob->GetBufferPointer(), psBlob->GetBufferSize(), nullptr, m_shadowPixelShader.ReleaseAndGetAddressOf());
-    if (FAILED(hr))
+    m_shadowPixelShader = m_shaderRegistry->GetPixelShader(L"ShadowPS");
+    if (!m_shadowPixelShader)
     {
         throw std::runtime_error("Fallo al crear el pixel shader de sombras.");
     }
 
-    Microsoft::WRL::ComPtr<ID3DBlob> vsAlphaBlob;
-    hr = D3DReadFileToBlob(L"C:\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\ShadowVS_AlphaClip.cso", vsAlphaBlob.GetAddressOf());
-    if (FAILED(hr)) throw std::runtime_error("Fallo al cargar ShadowVS_AlphaClip.cso.");
-    hr = device->CreateVertexShader(vsAlphaBlob->GetBufferPointer(), vsAlphaBlob->GetBufferSize(), nullptr, m_shadowVertexShader_AlphaClip.ReleaseAndGetAddressOf());
-    if (FAILED(hr)) throw std::runtime_error("Fallo al crear el vertex shader de sombras con alfa.");
+    m_shadowVertexShader_AlphaClip = m_shaderRegistry->GetVertexShader(L"ShadowVS_AlphaClip");
+    if (!m_shadowVertexShader_AlphaClip) throw std::runtime_error("Fallo al crear el vertex shader de sombras con alfa.");
 
     // CREAMOS EL NICO INPUT LAYOUT QUE NECESITAMOS USANDO EL BLOB CORRECTO
     const D3D11_INPUT_ELEMENT_DESC shadowLayoutDesc[] =
@@ -1633,23 +1783,32 @@ void Game::CreateDeviceDependentResources()
         { "NORMAL",   0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 }
     };
 
-    hr = device->CreateInputLayout(
-        shadowLayoutDesc,
-        ARRAYSIZE(shadowLayoutDesc),
-        vsAlphaBlob->GetBufferPointer(), // <-- Ahora usa el blob correcto
-        vsAlphaBlob->GetBufferSize(),
-        m_shadowInputLayout.ReleaseAndGetAddressOf()
-    );
-    if (FAILED(hr))
+    // Se valida contra ShadowVS_AlphaClip; tiene los mismos elementos que ModelVertex,
+    // asi que el registro devuelve el mismo layout que ya usan los modelos
+    m_shadowInputLayout = m_shaderRegistry->GetInputLayout(shadowLayoutDesc, ARRAYSIZE(shadowLayoutDesc), L"ShadowVS_AlphaClip");
+    if (!m_shadowInputLayout)
     {
         throw std::runtime_error("Fallo al crear el input layout de sombras unificado.");
     }
 
-    Microsoft::WRL::ComPtr<ID3DBlob> psAlphaBlob;
-    hr = D3DReadFileToBlob(L"\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\ShadowPS_AlphaClip.cso", psAlphaBlob.GetAddressOf());
-    if (FAILED(hr)) throw std::runtime_error("Fallo al cargar ShadowPS_AlphaClip.cso.");
-    hr = device->CreatePixelShader(psAlphaBlob->GetBufferPointer(), psAlphaBlob->GetBufferSize(), nullptr, m_shadowPixelShader_AlphaClip.ReleaseAndGetAddressOf());
-    if (FAILED(hr)) throw std::runtime_error("Fallo al crear el pixel shader de sombras con alfa.");
+    m_shadowPixelShader_AlphaClip = m_shaderRegistry->GetPixelShader(L"ShadowPS_AlphaClip");
+    if (!m_shadowPixelShader_AlphaClip) throw std::runtime_error("Fallo al crear el pixel shader de sombras con alfa.");
+
+    // --- Pre-pasada de profundidad ---
+    m_depthPrepassPS_AlphaClip = m_shaderRegistry->GetPixelShader(L"DepthPrepassPS_AlphaClip");
+    if (!m_depthPrepassPS_AlphaClip) throw std::runtime_error("Fallo al cargar DepthPrepassPS_AlphaClip.cso.");
+
+    m_evolvingPS_NoClip = m_shaderRegistry->GetPixelShader(L"EvolvingPS_NoClip");
+    if (!m_evolvingPS_NoClip) throw std::runtime_error("Fallo al cargar EvolvingPS_NoClip.cso.");
+
+    // Pasada principal tras la pre-pasada: solo pasa el fragmento con la misma profundidad y no escribe
+    D3D11_DEPTH_STENCIL_DESC equalDepthDesc = {};
+    equalDepthDesc.DepthEnable = TRUE;
+    equalDepthDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+    equalDepthDesc.DepthFunc = D3D11_COMPARISON_EQUAL;
+    hr = device->CreateDepthStencilState(&equalDepthDesc, m_depthEqualState.ReleaseAndGetAddressOf());
+    if (FAILED(hr)) throw std::runtime_error("Fallo al crear el estado de profundidad EQUAL.");
+
 
     // --- Crear el Input Layout para el Pase de Sombras ---
     // Aunque el shader solo usa la posicin, el layout debe describir la estructura completa del buffer
@@ -1671,30 +1830,20 @@ void Game::CreateDeviceDependentResources()
         throw std::runtime_error("Fallo al crear el estado de profundidad para sombras.");
     }
 
-    hr = D3DReadFileToBlob(L"\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\FullscreenQuadVS.cso", vsBlob.GetAddressOf());
-    if (FAILED(hr)) throw std::runtime_error("Fallo al cargar FullscreenQuadVS.cso");
-    hr = device->CreateVertexShader(vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), nullptr, m_fullscreenQuadVS.ReleaseAndGetAddressOf());
-    if (FAILED(hr)) throw std::runtime_error("Fallo al crear FullscreenQuadVS");
+    m_fullscreenQuadVS = m_shaderRegistry->GetVertexShader(L"FullscreenQuadVS");
+    if (!m_fullscreenQuadVS) throw std::runtime_error("Fallo al crear FullscreenQuadVS");
 
-    hr = D3DReadFileToBlob(L"\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\BloomExtractPS.cso", psBlob.GetAddressOf());
-    if (FAILED(hr)) throw std::runtime_error("Fallo al cargar BloomExtractPS.cso");
-    hr = device->CreatePixelShader(psBlob->GetBufferPointer(), psBlob->GetBufferSize(), nullptr, m_bloomExtractPS.ReleaseAndGetAddressOf());
-    if (FAILED(hr)) throw std::runtime_error("Fallo al crear BloomExtractPS");
-    
-    hr = D3DReadFileToBlob(L"\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\GaussianBlurHorizontalPS.cso", psBlob.GetAddressOf());
-    if (FAILED(hr)) throw std::runtime_error("Fallo al cargar GaussianBlurHorizontalPS.cso");
-    hr = device->CreatePixelShader(psBlob->GetBufferPointer(), psBlob->GetBufferSize(), nullptr, m_gaussianBlurHorizontalPS.ReleaseAndGetAddressOf());
-    if (FAILED(hr)) throw std::runtime_error("Fallo al crear GaussianBlurHorizontalPS");
-
-    hr = D3DReadFileToBlob(L"\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\GaussianBlurVerticalPS.cso", psBlob.GetAddressOf());
-    if (FAILED(hr)) throw std::runtime_error("Fallo al cargar GaussianBlurVerticalPS.cso");
-    hr = device->CreatePixelShader(psBlob->GetBufferPointer(), psBlob->GetBufferSize(), nullptr, m_gaussianBlurVerticalPS.ReleaseAndGetAddressOf());
-    if (FAILED(hr)) throw std::runtime_error("Fallo al crear GaussianBlurVerticalPS");
-    
-    hr = D3DReadFileToBlob(L"\\Users\\rebeq\\source\\repos\\GC2_PlantillaDB\\x64\\Debug\\BloomCompositePS.cso", psBlob.GetAddressOf());
-    if (FAILED(hr)) throw std::runtime_error("Fallo al cargar BloomCompositePS.cso");
-    hr = device->CreatePixelShader(psBlob->GetBufferPointer(), psBlob->GetBufferSize(), nullptr, m_bloomCompositePS.ReleaseAndGetAddressOf());
-    if (FAILED(hr)) throw std::runtime_error("Fallo al crear BloomCompositePS");
+    m_bloomExtractPS = m_shaderRegistry->GetPixelShader(L"BloomExtractPS");
+    if (!m_bloomExtractPS) throw std::runtime_error("Fallo al crear BloomExtractPS");
+
+    m_gaussianBlurHorizontalPS = m_shaderRegistry->GetPixelShader(L"GaussianBlurHorizontalPS");
+    if (!m_gaussianBlurHorizontalPS) throw std::runtime_error("Fallo al crear GaussianBlurHorizontalPS");
+
+    m_gaussianBlurVerticalPS = m_shaderRegistry->GetPixelShader(L"GaussianBlurVerticalPS");
+    if (!m_gaussianBlurVerticalPS) throw std::runtime_error("Fallo al crear GaussianBlurVerticalPS");
+
+    m_bloomCompositePS = m_shaderRegistry->GetPixelShader(L"BloomCompositePS");
+    if (!m_bloomCompositePS) throw std::runtime_error("Fallo al crear BloomCompositePS");
 
     // --- NUEVO: CREAR CONSTANT BUFFERS DE POST-PROCESAMIENTO ---
     CD3D11_BUFFER_DESC cbDesc(sizeof(CB_BloomParameters), D3D11_BIND_CONSTANT_BUFFER, D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
@@ -1727,6 +1876,12 @@ void Game::CreateWindowSizeDependentResources()
 
     if (width == 0 || height == 0) return;
 
+    // El rango del LOD del terreno depende de cuantos pixeles ocupa el error de cada nivel
+    if (m_terrain && m_camera)
+    {
+        m_terrain->SetLodViewport(static_cast<float>(height), m_camera->GetFieldOfView());
+    }
+
     auto device = m_deviceResources->GetD3DDevice();
     HRESULT hr;
 
@@ -1765,8 +1920,10 @@ void Game::CreateWindowSizeDependentResources()
 void Game::OnDeviceLost()
 {
     // TODO: Add Direct3D resource cleanup here.
+    if (m_shaderRegistry) m_shaderRegistry->Clear();
 }
 
+
 void Game::OnDeviceRestored()
 {
     CreateDeviceDependentResources();
@@ -1783,7 +1940,8 @@ void Game::AddInstancedObject(
     float instanceX,
     float instanceZ,
     float fallbackY,
-    float modelSpecificOffsetY)
+    float modelSpecificOffsetY,
+    bool isOccluder)
 {
     if (!modelPtr || !m_terrain) { 
         return;
@@ -1803,73 +1961,234 @@ void Game::AddInstancedObject(
     // Establece la posicin de esta instancia
     instanceWorldMatrix.Translation(DirectX::SimpleMath::Vector3(instanceX, finalInstanceY, instanceZ));
 
-    m_worldInstances.emplace_back(modelPtr, instanceWorldMatrix);
+    GameObjectInstance& instance = m_worldInstances.emplace_back(modelPtr, instanceWorldMatrix);
+    modelPtr->GetLocalBoundingBox().Transform(instance.worldBounds, instanceWorldMatrix);
+    modelPtr->GetOverallLocalBoundingSphere().Transform(instance.worldSphere, instanceWorldMatrix);
+    instance.isOccluder = isOccluder;
+    m_collisionGrid.Set(static_cast<uint32_t>(m_worldInstances.size() - 1), instance.worldSphere.Center, instance.worldSphere.Radius);
+
+    std::vector<PartBox> partBoxes;
+    modelPtr->GetPartBoxes(partBoxes);
+    instance.partBoundsSlot = m_worldPartBounds.AddInstance(partBoxes.data(), partBoxes.size(), instanceWorldMatrix);
 }
 
 #pragma endregion
 
+#pragma region Occlusion Culling
+
+void Game::UpdateOcclusionCulling(const Matrix& viewProjection)
+{
+    // Primero el frustum de la camara (planos cacheados en Camera); lo de fuera ni se prueba
+    m_instanceVisible.assign(m_worldInstances.size(), 0);
+    for (size_t i = 0; i < m_worldInstances.size(); ++i)
+    {
+        const DirectX::BoundingBox& bounds = m_worldInstances[i].worldBounds;
+        m_instanceVisible[i] = m_camera->IsVisible(bounds.Center, bounds.Extents) ? 1 : 0;
+    }
+    if (!m_occlusionCullingEnabled || !m_occlusionCuller) return;
+
+    m_occlusionCuller->BeginFrame(viewProjection);
+
+    // 1. Oclusores: la malla gruesa del terreno (colinas) y los edificios
+    if (m_terrain)
+    {
+        const auto& positions = m_terrain->GetOccluderPositions();
+        const auto& indices = m_terrain->GetOccluderIndices();
+        m_occlusionCuller->AddOccluder(positions.data(), positions.size(),
+            indices.data(), indices.size(), m_terrain->GetWorldMatrix());
+    }
+
+    for (const auto& instance : m_worldInstances)
+    {
+        if (!instance.isOccluder || !instance.baseModel) continue;
+
+        const auto& positions = instance.baseModel->GetModelSpacePositions();
+        const auto& indices = instance.baseModel->GetModelSpaceIndices();
+        m_occlusionCuller->AddOccluder(positions.data(), positions.size(),
+            indices.data(), indices.size(), instance.worldTransform);
+    }
+
+    m_occlusionCuller->RasterizeOccluders();
+
+    // 2. Probar la AABB de cada instancia contra el buffer de profundidad
+    for (size_t i = 0; i < m_worldInstances.size(); ++i)
+    {
+        if (!m_instanceVisible[i]) continue;
+        const DirectX::BoundingBox& bounds = m_worldInstances[i].worldBounds;
+        Vector3 boxMin = Vector3(bounds.Center) - Vector3(bounds.Extents);
+        Vector3 boxMax = Vector3(bounds.Center) + Vector3(bounds.Extents);
+        m_instanceVisible[i] = m_occlusionCuller->IsVisible(boxMin, boxMax) ? 1 : 0;
+    }
+}
+
+#pragma endregion
+
+
 #pragma region Shadow Mapping
 
+void Game::BuildShadowCasterBatches()
+{
+    // Se parte por los modos de sombra de los materiales de cada modelo (decididos al importarlo)
+    std::vector<uint8_t> masks(m_worldInstances.size(), 0);
+    for (size_t i = 0; i < m_worldInstances.size(); ++i)
+    {
+        const GameObjectInstance& instance = m_worldInstances[i];
+        if (instance.baseModel) masks[i] = instance.baseModel->GetShadowCasterMask();
+    }
+    m_shadowBatches.Build(masks.data(), masks.size());
+    m_shadowCache.Invalidate();
+
+    wchar_t line[96];
+    swprintf_s(line, L"Shadow casters: %zu opaque, %zu alpha-tested\n",
+        m_shadowBatches.opaque.size(), m_shadowBatches.alphaTested.size());
+    OutputDebugString(line);
+}
+
 void Game::RenderShadowPass()
 {
     auto context = m_deviceResources->GetD3DDeviceContext();
     if (!m_shadowDepthState) return;
 
-    // 1. Configurar la pipeline una sola vez para TODOS los objetos
-    context->OMSetRenderTargets(0, nullptr, m_shadowMapDSV.Get());
-    context->OMSetDepthStencilState(m_shadowDepthState.Get(), 0);
-    context->ClearDepthStencilView(m_shadowMapDSV.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
-
-    D3D11_VIEWPORT shadowViewport = { 0.0f, 0.0f, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, 0.0f, 1.0f };
-    context->RSSetViewports(1, &shadowViewport);
+    // 1. Ajustar las cascadas al frustum de la camara (la camara mira hacia -GetForward())
+    ShadowCameraDesc cameraDesc;
+    cameraDesc.position = m_camera->GetPosition();
+    cameraDesc.viewDirection = -Vector3(m_camera->GetForward());
+    cameraDesc.up = m_camera->GetUp();
+    cameraDesc.fieldOfViewY = m_camera->GetFieldOfView();
+    cameraDesc.aspectRatio = m_camera->GetAspectRatio();
+    cameraDesc.nearPlane = m_camera->GetNearPlane();
+    cameraDesc.farPlane = m_camera->GetFarPlane();
+    m_shadowCascades.Update(cameraDesc, m_lightData.directionalLightVector);
+
+    // 2. Solo las cascadas que la politica da por caducadas (cambio de tesela o
+    //    luz girada mas que el umbral), repartidas entre frames
+    int staleCascades[ShadowCascades::MAX_CASCADES];
+    const int staleCount = m_shadowCache.Update(m_shadowCascades, staleCascades);
+    const int cascadeCount = m_shadowCache.GetCascadeCount();
+
+    auto setCascadeViewport = [&](int c)
+    {
+        D3D11_VIEWPORT shadowViewport = { static_cast<float>((c & 1) * SHADOW_MAP_SIZE), static_cast<float>((c >> 1) * SHADOW_MAP_SIZE),
+            SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, 0.0f, 1.0f };
+        context->RSSetViewports(1, &shadowViewport);
+    };
 
-    // Usamos el VS potente y el Input Layout correcto para todo
-    context->VSSetShader(m_shadowVertexShader_AlphaClip.Get(), nullptr, 0);
-    context->IASetInputLayout(m_shadowInputLayout.Get());
+    // El pase de sombras de un lote sobre el contexto (ver ShadowCasterBatches::Draw): las
+    // instancias cuya AABB toca el volumen de la cascada (incluido el margen hacia la luz), el
+    // estado del modo una vez por lote y cada instancia solo con sus partes de ese modo
+    struct ShadowCasterDevice
+    {
+        Game& game;
+        ID3D11DeviceContext* context;
+        const ShadowCascade& cascade;
+        Matrix cascadeView;
+        Matrix cascadeProjection;
 
-    // 2. Calcular matrices de la luz
-    Vector3 shadowFocusPoint = m_camera->GetPosition();
-    Vector3 lightPosition = shadowFocusPoint - (m_lightData.directionalLightVector * 400.0f); 
+        bool IsShadowCasterVisible(uint32_t index) const
+        {
+            const DirectX::BoundingBox& bounds = game.m_worldInstances[index].worldBounds;
+            return ShadowCascades::IntersectsBox(cascade, bounds.Center, bounds.Extents);
+        }
 
-    Vector3 lightUp = Vector3::Up;
+        void BindShadowCasterState(ShadowCasterMode mode)
+        {
+            if (mode == ShadowCasterMode::AlphaTested)
+            {
+                context->VSSetShader(game.m_shadowVertexShader_AlphaClip.Get(), nullptr, 0);
+                context->PSSetShader(game.m_shadowPixelShader_AlphaClip.Get(), nullptr, 0);
+                context->PSSetSamplers(0, 1, game.m_samplerState.GetAddressOf());
+            }
+            else
+            {
+                // Solo profundidad: el VS sin UV y sin pixel shader
+                context->VSSetShader(game.m_shadowVertexShader.Get(), nullptr, 0);
+                context->PSSetShader(nullptr, nullptr, 0);
+            }
+        }
 
-    m_lightViewMatrix = Matrix::CreateLookAt(lightPosition, shadowFocusPoint, lightUp);
+        void DrawShadowCaster(uint32_t index, ShadowCasterMode mode)
+        {
+            const auto& instance = game.m_worldInstances[index];
+            instance.baseModel->ShadowDrawBatch(context, instance.worldTransform, cascadeView, cascadeProjection, mode);
+        }
+    };
 
-    m_lightProjectionMatrix = Matrix::CreateOrthographic(500.f, 500.f, 1.0f, 800.0f);
+    auto drawCasters = [&](const ShadowCasterBatches& batches, const ShadowCascade& cascade)
+    {
+        context->IASetInputLayout(m_shadowInputLayout.Get());
+        context->RSSetState(m_shadowRasterizerState.Get());
+        context->OMSetDepthStencilState(m_shadowDepthState.Get(), 0);
+        ShadowCasterDevice device = { *this, context, cascade, Matrix(cascade.view), Matrix(cascade.projection) };
+        batches.Draw(device, m_shadowCasters);
+    };
 
-    // 3. Dibujar los modelos
-    for (const auto& instance : m_worldInstances)
+    if (staleCount > 0)
     {
-        if (instance.baseModel)
+        context->OMSetRenderTargets(0, nullptr, m_shadowMapDSV.Get());
+        if (staleCount == cascadeCount)
         {
-            context->RSSetState(m_shadowRasterizerState.Get());
+            context->ClearDepthStencilView(m_shadowMapDSV.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
+        }
 
-            bool usesAlphaClip = (instance.baseModel == m_green_tree1.get() ||
-                instance.baseModel == m_forest_pine1.get() ||
-                instance.baseModel == m_forest_pine2.get() ||
-                instance.baseModel == m_forest_pine3.get());
+        for (int s = 0; s < staleCount; ++s)
+        {
+            const int c = staleCascades[s];
+            const ShadowCascade& cascade = m_shadowCache.GetCachedCascade(c);
+            const Matrix cascadeView(cascade.view);
+            const Matrix cascadeProjection(cascade.projection);
 
-            if (usesAlphaClip)
+            // Borrar solo este cuadrante: triangulo de pantalla completa con el viewport en profundidad 1
+            if (staleCount != cascadeCount)
             {
-                context->PSSetShader(m_shadowPixelShader_AlphaClip.Get(), nullptr, 0);
+                D3D11_VIEWPORT clearViewport = { static_cast<float>((c & 1) * SHADOW_MAP_SIZE), static_cast<float>((c >> 1) * SHADOW_MAP_SIZE),
+                    SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, 1.0f, 1.0f };
+                context->RSSetViewports(1, &clearViewport);
+                context->RSSetState(m_states->CullNone());
+                context->OMSetDepthStencilState(m_shadowTileClearState.Get(), 0);
+                context->VSSetShader(m_fullscreenQuadVS.Get(), nullptr, 0);
+                context->PSSetShader(nullptr, nullptr, 0);
+                context->IASetInputLayout(nullptr);
+                context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+                context->Draw(3, 0);
             }
-            else
+
+            setCascadeViewport(c);
+            drawCasters(m_shadowBatches, cascade);
+
+            // Dibujar el terreno (slido, no necesita alfa)
+            // Con mapas de horizonte el terreno se sombrea a si mismo en TerrainPS y no hace falta aqui
+            if (m_terrain && !m_terrain->UsesHorizonShadows())
             {
                 context->PSSetShader(nullptr, nullptr, 0);
+                m_terrain->ShadowDraw(context, cascadeView, cascadeProjection);
             }
-
-            // Usamos siempre la funcin de dibujado ms completa
-            instance.baseModel->ShadowDrawAlphaClip(context, instance.worldTransform, m_lightViewMatrix, m_lightProjectionMatrix, m_samplerState.Get());
         }
     }
 
-    // 4. Dibujar el terreno (slido, no necesita alfa)
-    if (m_terrain)
+    // 3. La escena muestrea con las cascadas cacheadas, no con las de este frame
+    CB_ShadowCascades cascadeData = {};
+    cascadeData.cascadeCount = static_cast<float>(cascadeCount);
+    cascadeData.atlasScale = 0.5f;
+    cascadeData.border = 3.0f / SHADOW_MAP_SIZE; // Radio del PCF (2 texeles) + filtrado bilineal
+    for (int c = 0; c < cascadeCount; ++c)
     {
-        context->RSSetState(m_shadowRasterizerState.Get());
-        context->PSSetShader(nullptr, nullptr, 0);
-        m_terrain->ShadowDraw(context, m_lightViewMatrix, m_lightProjectionMatrix);
+        const ShadowCascade& cascade = m_shadowCache.GetCachedCascade(c);
+        cascadeData.viewProjection[c] = Matrix(cascade.view) * Matrix(cascade.projection);
+        cascadeData.atlasOffset[c] = Vector4(0.5f * (c & 1), 0.5f * (c >> 1), 0.0f, 0.0f);
+    }
+
+    // Los VS siguen recibiendo una matriz de luz: la de la cascada mas cercana
+    m_lightViewMatrix = Matrix(m_shadowCache.GetCachedCascade(0).view);
+    m_lightProjectionMatrix = Matrix(m_shadowCache.GetCachedCascade(0).projection);
+
+    // 4. Subir las cascadas para los PS de la escena y del minimapa
+    D3D11_MAPPED_SUBRESOURCE mappedResource;
+    if (SUCCEEDED(context->Map(m_shadowCascadeCB.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource)))
+    {
+        memcpy(mappedResource.pData, &cascadeData, sizeof(CB_ShadowCascades));
+        context->Unmap(m_shadowCascadeCB.Get(), 0);
     }
+    context->PSSetConstantBuffers(3, 1, m_shadowCascadeCB.GetAddressOf());
 }
 
 #pragma endregion
@@ -2028,34 +2347,10 @@ void Game::UpdateDayNightCycle(float elapsedTime)
     }
 }
 
-void Game::ResetFirefly(FireflyParticle& particle)
-{
-    // Posicin aleatoria dentro del volumen definido
-    particle.position.x = m_fireflyVolume.Center.x + (((float)rand() / RAND_MAX) * 2.f - 1.f) * m_fireflyVolume.Extents.x;
-    particle.position.y = m_fireflyVolume.Center.y + (((float)rand() / RAND_MAX) * 2.f - 1.f) * m_fireflyVolume.Extents.y;
-    particle.position.z = m_fireflyVolume.Center.z + (((float)rand() / RAND_MAX) * 2.f - 1.f) * m_fireflyVolume.Extents.z;
-
-    // Velocidad aleatoria suave para que floten
-    particle.velocity.x = (((float)rand() / RAND_MAX) * 2.f - 1.f) * 0.5f; // Movimiento lento en X
-    particle.velocity.y = (((float)rand() / RAND_MAX) * 2.f - 1.f) * 0.3f; // Movimiento lento en Y
-    particle.velocity.z = (((float)rand() / RAND_MAX) * 2.f - 1.f) * 0.5f; // Movimiento lento en Z
-
-    // Tiempo de vida aleatorio para que no desaparezcan todas a la vez
-    particle.maxLifetime = 4.0f + ((float)rand() / RAND_MAX) * 5.f; // Entre 4 y 9 segundos
-    particle.lifetime = particle.maxLifetime;
-
-    // Temporizador de parpadeo con un desfase aleatorio
-    particle.blinkTimer = ((float)rand() / RAND_MAX) * 2.0f * DirectX::XM_PI;
-    particle.rotation = ((float)rand() / RAND_MAX) * DirectX::XM_2PI;
-}
-
 void Game::InitializeFireflies()
 {
-    m_fireflies.resize(NUM_FIREFLIES);
-    for (auto& firefly : m_fireflies)
-    {
-        ResetFirefly(firefly);
-    }
+    // Semilla fija: la misma nube en cada ejecucin, como haca rand() sin srand
+    m_fireflies.Reset(NUM_FIREFLIES, m_fireflyVolume.Center, m_fireflyVolume.Extents, 1);
 }
 
 void Game::UpdateFireflies(float elapsedTime)
@@ -2066,23 +2361,8 @@ void Game::UpdateFireflies(float elapsedTime)
         return;
     }
 
-    for (auto& firefly : m_fireflies)
-    {
-        firefly.lifetime -= elapsedTime;
-        if (firefly.lifetime <= 0.f)
-        {
-            ResetFirefly(firefly);
-        }
-
-        // Actualizar posicin
-        firefly.position += firefly.velocity * elapsedTime;
-
-        // Aadir un movimiento suave y ondulante
-        firefly.position.y += sin(firefly.blinkTimer * 2.0f) * 0.2f * elapsedTime;
-
-        // Actualizar temporizador de parpadeo
-        firefly.blinkTimer += elapsedTime * 3.0f;
-    }
+    // Reaparicin, movimiento, vaivn y parpadeo; con NUM_FIREFLIES cabe en un bloque y no usa el pool
+    m_fireflies.Update(elapsedTime, m_threadPool.get());
 }
 
 #pragma endregion
\ No newline at end of file
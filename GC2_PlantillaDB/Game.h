@@ -14,6 +14,11 @@
 #include <Effects.h>
 #include "Terrain.h"
 #include "Model.h"
+#include "OcclusionCuller.h"
+#include "CollisionGrid.h"
+#include "FireflyParticles.h"
+#include "ShadowCache.h"
+#include "ThreadPool.h"
 #include <vector>   
 #include <string>   
 #include <memory> 
@@ -22,22 +27,16 @@ struct GameObjectInstance
 {
     Model* baseModel = nullptr;
     DirectX::SimpleMath::Matrix worldTransform;
+    DirectX::BoundingBox worldBounds; // AABB del modelo ya transformada al mundo
+    DirectX::BoundingSphere worldSphere; // Esfera del modelo en el mundo (la que usa m_collisionGrid)
+    uint32_t partBoundsSlot = 0;      // Cajas de sus partes en m_worldPartBounds
+    bool isOccluder = false;          // Se rasteriza en el buffer de oclusin
 
     GameObjectInstance(Model* model, const DirectX::SimpleMath::Matrix& transform)
         : baseModel(model), worldTransform(transform) {
     }
 };
 
-struct FireflyParticle
-{
-    DirectX::SimpleMath::Vector3 position;
-    DirectX::SimpleMath::Vector3 velocity;
-    float lifetime;
-    float maxLifetime;
-    float blinkTimer;
-    float rotation;
-};
-
 // A basic game implementation that creates a D3D11 device and
 // provides a game loop.
 class Game final : public DX::IDeviceNotify
@@ -93,11 +92,14 @@ private:
         float instanceX,
         float instanceZ,
         float fallbackY,
-        float modelSpecificOffsetY
+        float modelSpecificOffsetY,
+        bool isOccluder = false
     );
 
     void RenderShadowPass();
+    void BuildShadowCasterBatches();
     void RenderMinimapPass();
+    void UpdateOcclusionCulling(const DirectX::SimpleMath::Matrix& viewProjection);
     // Device resources.
     std::unique_ptr<DX::DeviceResources> m_deviceResources;
 
@@ -117,6 +119,7 @@ private:
     float m_wTapTimer; 
     const float m_doubleTapTimeLimit = 0.3f; 
     bool m_wKeyWasPressedInPreviousFrame;
+    float m_cameraFallSpeed; // Velocidad de caida de la capsula del jugador (sin suelo bajo ella)
 
     //--- KEYBOARD AND MOUSE STATES / TRACKERS
     DirectX::Keyboard::State m_kbState;          
@@ -140,13 +143,13 @@ private:
     // Recursos para el Sistema de Partculas de Lucirnagas
     Microsoft::WRL::ComPtr<ID3D11Buffer> m_fireflyVertexBuffer;
     Microsoft::WRL::ComPtr<ID3D11Buffer> m_fireflyIndexBuffer;
+    Microsoft::WRL::ComPtr<ID3D11Buffer> m_fireflyInstanceBuffer; // FireflyInstance, dinmico, NUM_FIREFLIES elementos
 
     Microsoft::WRL::ComPtr<ID3D11VertexShader> m_fireflyVS;
     Microsoft::WRL::ComPtr<ID3D11PixelShader>  m_fireflyPS;
     Microsoft::WRL::ComPtr<ID3D11InputLayout>  m_fireflyInputLayout;
 
     Microsoft::WRL::ComPtr<ID3D11Buffer> m_cbFireflyPerFrame;
-    Microsoft::WRL::ComPtr<ID3D11Buffer> m_cbFireflyPerParticle;
 
     // Estructuras de Constant Buffers para las lucirnagas
     struct CB_Firefly_PerFrame
@@ -158,15 +161,6 @@ private:
         float _pad1;
     };
 
-    struct CB_Firefly_PerParticle
-    {
-        DirectX::SimpleMath::Vector3 ParticleCenter_World;
-        float _pad0;
-        DirectX::SimpleMath::Vector2 ParticleSize;
-        float _pad1[2];
-        DirectX::SimpleMath::Vector4 ParticleColor;
-    };
-
     // SkyDome
     std::unique_ptr<DirectX::GeometricPrimitive>    m_skySphere;
     Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_skyTextureSRV;
@@ -184,9 +178,8 @@ private:
 	// Fireflies
     void InitializeFireflies();
     void UpdateFireflies(float elapsedTime);
-    void ResetFirefly(FireflyParticle& particle);
 
-    std::vector<FireflyParticle> m_fireflies;
+    FireflyParticles m_fireflies;
     Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_fireflyTexture;
     DirectX::BoundingBox m_fireflyVolume;
     static const int NUM_FIREFLIES = 300;
@@ -228,22 +221,51 @@ private:
 
     // Model instances
     std::vector<GameObjectInstance> m_worldInstances;
+    CollisionGrid                   m_collisionGrid;       // Esferas de m_worldInstances, por indice
+    std::vector<uint32_t>           m_collisionCandidates; // Resultado de la consulta de cada frame
+    WorldPartBounds                 m_worldPartBounds;     // Cajas de mundo de las partes, fijas al colocar la instancia
+
+    // Occlusion culling (tecla O para activar/desactivar)
+    std::unique_ptr<ThreadPool>      m_threadPool;
+    std::unique_ptr<ShaderRegistry>  m_shaderRegistry; // Shaders compartidos por todos los modelos
+    std::unique_ptr<OcclusionCuller> m_occlusionCuller;
+
+    std::vector<uint8_t>             m_instanceVisible; // Paralelo a m_worldInstances
+    bool                             m_occlusionCullingEnabled;
+
 
     // Iluminacin exclusiva para el minimapa
     Microsoft::WRL::ComPtr<ID3D11Buffer> m_minimapLightPropertiesCB;
     PSLightPropertiesData m_minimapLightData;
 
     // Shadow mapping
-    Microsoft::WRL::ComPtr<ID3D11Texture2D>           m_shadowMapTexture;
+    Microsoft::WRL::ComPtr<ID3D11Texture2D>           m_shadowMapTexture;  // Cacheada entre frames (ver m_shadowCache)
     Microsoft::WRL::ComPtr<ID3D11DepthStencilView>  m_shadowMapDSV;
     Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_shadowMapSRV;
+    Microsoft::WRL::ComPtr<ID3D11DepthStencilState> m_shadowTileClearState; // Escribe siempre: borra un cuadrante
     Microsoft::WRL::ComPtr<ID3D11SamplerState>      m_shadowSamplerState; 
     Microsoft::WRL::ComPtr<ID3D11RasterizerState>   m_shadowRasterizerState; 
     Microsoft::WRL::ComPtr<ID3D11DepthStencilState> m_shadowDepthState;
 
-    DirectX::SimpleMath::Matrix m_lightViewMatrix;
+    DirectX::SimpleMath::Matrix m_lightViewMatrix;       // Cascada 0 (la mas cercana a la camara)
     DirectX::SimpleMath::Matrix m_lightProjectionMatrix;
 
+    // Cascadas: cada una ocupa un cuadrante de m_shadowMapTexture (SHADOW_MAP_SIZE x SHADOW_MAP_SIZE por cascada)
+    struct CB_ShadowCascades
+    {
+        DirectX::SimpleMath::Matrix viewProjection[ShadowCascades::MAX_CASCADES];
+        DirectX::SimpleMath::Vector4 atlasOffset[ShadowCascades::MAX_CASCADES];
+        float cascadeCount;
+        float atlasScale;
+        float border;
+        float _padding;
+    };
+    ShadowCascades                       m_shadowCascades;
+    ShadowCachePolicy                    m_shadowCache;     // Que cascadas del shadow map se re-renderizan
+    Microsoft::WRL::ComPtr<ID3D11Buffer> m_shadowCascadeCB; // Slot b3 del PS
+    std::vector<uint32_t>                m_shadowCasters;   // Instancias del lote dentro de la cascada que se esta dibujando
+    ShadowCasterBatches                  m_shadowBatches;   // Por modo de sombra de sus materiales
+
     Microsoft::WRL::ComPtr<ID3D11VertexShader> m_shadowVertexShader;
     Microsoft::WRL::ComPtr<ID3D11PixelShader>  m_shadowPixelShader;
     Microsoft::WRL::ComPtr<ID3D11InputLayout>  m_shadowInputLayout;
@@ -251,6 +273,14 @@ private:
     Microsoft::WRL::ComPtr<ID3D11VertexShader> m_shadowVertexShader_AlphaClip; 
     Microsoft::WRL::ComPtr<ID3D11PixelShader>  m_shadowPixelShader_AlphaClip;
 
+    // Pre-pasada de profundidad: recorta las hojas una vez y la pasada principal usa EQUAL
+    Microsoft::WRL::ComPtr<ID3D11PixelShader>       m_depthPrepassPS_AlphaClip;
+    Microsoft::WRL::ComPtr<ID3D11PixelShader>       m_evolvingPS_NoClip;
+    Microsoft::WRL::ComPtr<ID3D11DepthStencilState> m_depthEqualState;
+    bool                                            m_depthPrepassEnabled;
+    ScenePassPlan                                   m_scenePasses;     // Orden y estado de las pasadas opacas del frame
+
+
     static const int SHADOW_MAP_SIZE = 2048;
 
     // Minimap Resources
@@ -0,0 +1,103 @@
+#include "HeightfieldFormats.h"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+size_t GetHeightSampleSize(HeightSampleFormat format)
+{
+    switch (format)
+    {
+    case HeightSampleFormat::UNorm8:  return 1;
+    case HeightSampleFormat::UNorm16: return 2;
+    case HeightSampleFormat::Float16: return 2;
+    case HeightSampleFormat::Float32: return 4;
+    }
+    return 0;
+}
+
+float HalfToFloat(uint16_t half)
+{
+    const uint32_t sign = (half >> 15) & 0x1;
+    const uint32_t exponent = (half >> 10) & 0x1F;
+    const uint32_t mantissa = half & 0x3FF;
+
+    float value;
+    if (exponent == 0)
+    {
+        value = std::ldexp(static_cast<float>(mantissa), -24); // Subnormal
+    }
+    else if (exponent == 31)
+    {
+        value = mantissa == 0 ? INFINITY : NAN;
+    }
+    else
+    {
+        value = std::ldexp(static_cast<float>(mantissa | 0x400), static_cast<int>(exponent) - 25);
+    }
+    return sign ? -value : value;
+}
+
+void DecodeHeightSamples(const uint8_t* source, HeightSampleFormat format, size_t pixelStride,
+    size_t count, float* destination)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        const uint8_t* pixel = source + i * pixelStride;
+        switch (format)
+        {
+        case HeightSampleFormat::UNorm8:
+            destination[i] = static_cast<float>(pixel[0]) / 255.0f;
+            break;
+        case HeightSampleFormat::UNorm16:
+        {
+            uint16_t value;
+            memcpy(&value, pixel, sizeof(value));
+            destination[i] = static_cast<float>(value) / 65535.0f;
+            break;
+        }
+        case HeightSampleFormat::Float16:
+        {
+            uint16_t value;
+            memcpy(&value, pixel, sizeof(value));
+            destination[i] = HalfToFloat(value);
+            break;
+        }
+        case HeightSampleFormat::Float32:
+            memcpy(&destination[i], pixel, sizeof(float));
+            break;
+        }
+    }
+}
+
+bool LoadRawHeightfield(const std::filesystem::path& path, HeightSampleFormat format,
+    int& width, int& height, std::vector<float>& outHeights)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) return false;
+
+    const size_t sampleSize = GetHeightSampleSize(format);
+    const std::streamoff fileSize = file.tellg();
+    if (fileSize <= 0 || sampleSize == 0) return false;
+
+    const size_t sampleCount = static_cast<size_t>(fileSize) / sampleSize;
+    if (width <= 0 || height <= 0)
+    {
+        int side = static_cast<int>(std::lround(std::sqrt(static_cast<double>(sampleCount))));
+        if (static_cast<size_t>(side) * side != sampleCount) return false; // No es cuadrado
+        width = side;
+        height = side;
+    }
+    if (static_cast<size_t>(width) * height > sampleCount) return false;
+
+    // Se decodifica por filas para no duplicar en memoria un heightfield grande
+    std::vector<uint8_t> row(static_cast<size_t>(width) * sampleSize);
+    outHeights.resize(static_cast<size_t>(width) * height);
+    file.seekg(0, std::ios::beg);
+    for (int y = 0; y < height; ++y)
+    {
+        if (!file.read(reinterpret_cast<char*>(row.data()), row.size())) return false;
+        DecodeHeightSamples(row.data(), format, sampleSize, width, &outHeights[static_cast<size_t>(y) * width]);
+    }
+    return true;
+}
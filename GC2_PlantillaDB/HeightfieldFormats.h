@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+// Formatos de muestra de un heightmap. Los enteros se normalizan a [0, 1];
+// los float se devuelven tal cual (se espera que ya esten en [0, 1]).
+enum class HeightSampleFormat : uint32_t
+{
+    UNorm8 = 0,
+    UNorm16 = 1,
+    Float16 = 2,
+    Float32 = 3
+};
+
+size_t GetHeightSampleSize(HeightSampleFormat format);
+
+float HalfToFloat(uint16_t half);
+
+// Convierte 'count' muestras a float. Cada pixel ocupa pixelStride bytes y la altura
+// es su primer canal (R en imagenes RGBA, el unico canal en escala de grises).
+void DecodeHeightSamples(const uint8_t* source, HeightSampleFormat format, size_t pixelStride,
+    size_t count, float* destination);
+
+// Heightmap RAW sin cabecera (little-endian, filas de arriba a abajo), p.ej. .r16 / .r32.
+// Si width y height son 0 se supone cuadrado y se deducen del tamano del archivo.
+bool LoadRawHeightfield(const std::filesystem::path& path, HeightSampleFormat format,
+    int& width, int& height, std::vector<float>& outHeights);
@@ -0,0 +1,133 @@
+#include "pch.h"
+#include "HeightfieldPages.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+HeightfieldPageFile::HeightfieldPageFile() :
+    m_header()
+{
+}
+
+bool HeightfieldPageFile::Write(const std::filesystem::path& path, const float* heights, int width, int height,
+    int tileSize, HeightSampleFormat format)
+{
+    if (!heights || width < 1 || height < 1 || tileSize < 1) return false;
+    if (format != HeightSampleFormat::UNorm16 && format != HeightSampleFormat::Float32) return false;
+
+    Header header = {};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.width = static_cast<uint32_t>(width);
+    header.height = static_cast<uint32_t>(height);
+    header.tileSize = static_cast<uint32_t>(tileSize);
+    header.tilesX = static_cast<uint32_t>((width + tileSize - 1) / tileSize);
+    header.tilesZ = static_cast<uint32_t>((height + tileSize - 1) / tileSize);
+    header.format = static_cast<uint32_t>(format);
+
+    const size_t tileCount = static_cast<size_t>(header.tilesX) * header.tilesZ;
+    const size_t sampleSize = GetHeightSampleSize(format);
+    const size_t tileBytes = static_cast<size_t>(tileSize) * tileSize * sampleSize;
+
+    std::vector<uint64_t> offsets(tileCount);
+    uint64_t offset = sizeof(Header) + tileCount * sizeof(uint64_t);
+    for (size_t i = 0; i < tileCount; ++i)
+    {
+        offsets[i] = offset;
+        offset += tileBytes;
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint64_t));
+
+    std::vector<uint8_t> tile(tileBytes);
+    for (uint32_t tileZ = 0; tileZ < header.tilesZ; ++tileZ)
+    {
+        for (uint32_t tileX = 0; tileX < header.tilesX; ++tileX)
+        {
+            for (int z = 0; z < tileSize; ++z)
+            {
+                int sourceZ = std::min(static_cast<int>(tileZ) * tileSize + z, height - 1);
+                for (int x = 0; x < tileSize; ++x)
+                {
+                    int sourceX = std::min(static_cast<int>(tileX) * tileSize + x, width - 1);
+                    float h = heights[static_cast<size_t>(sourceZ) * width + sourceX];
+                    uint8_t* destination = tile.data() + (static_cast<size_t>(z) * tileSize + x) * sampleSize;
+
+                    if (format == HeightSampleFormat::UNorm16)
+                    {
+                        float clamped = std::min(std::max(h, 0.0f), 1.0f);
+                        uint16_t value = static_cast<uint16_t>(std::lround(clamped * 65535.0f));
+                        memcpy(destination, &value, sizeof(value));
+                    }
+                    else
+                    {
+                        memcpy(destination, &h, sizeof(h));
+                    }
+                }
+            }
+            file.write(reinterpret_cast<const char*>(tile.data()), tile.size());
+        }
+    }
+    return static_cast<bool>(file);
+}
+
+bool HeightfieldPageFile::Open(const std::filesystem::path& path)
+{
+    m_tileOffsets.clear();
+    m_header = Header();
+
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) return false;
+    const uint64_t fileSize = static_cast<uint64_t>(file.tellg());
+    file.seekg(0, std::ios::beg);
+
+    Header header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+    if (header.magic != MAGIC || header.version != VERSION) return false;
+    if (header.width == 0 || header.height == 0 || header.tileSize == 0) return false;
+    if (header.tilesX != (header.width + header.tileSize - 1) / header.tileSize ||
+        header.tilesZ != (header.height + header.tileSize - 1) / header.tileSize) return false;
+
+    const HeightSampleFormat format = static_cast<HeightSampleFormat>(header.format);
+    if (format != HeightSampleFormat::UNorm16 && format != HeightSampleFormat::Float32) return false;
+
+    std::vector<uint64_t> offsets(static_cast<size_t>(header.tilesX) * header.tilesZ);
+    if (!file.read(reinterpret_cast<char*>(offsets.data()), offsets.size() * sizeof(uint64_t))) return false;
+
+    // Cada tesela tiene que caber en el archivo
+    const uint64_t tileBytes = static_cast<uint64_t>(header.tileSize) * header.tileSize * GetHeightSampleSize(format);
+    for (uint64_t offset : offsets)
+    {
+        if (offset + tileBytes > fileSize) return false;
+    }
+
+    m_path = path;
+    m_header = header;
+    m_tileOffsets = std::move(offsets);
+    return true;
+}
+
+bool HeightfieldPageFile::ReadTile(int tileX, int tileZ, std::vector<float>& outSamples) const
+{
+    if (!IsOpen() || tileX < 0 || tileZ < 0 || tileX >= GetTilesX() || tileZ >= GetTilesZ()) return false;
+
+    const HeightSampleFormat format = GetFormat();
+    const size_t sampleSize = GetHeightSampleSize(format);
+    const size_t sampleCount = static_cast<size_t>(m_header.tileSize) * m_header.tileSize;
+
+    std::ifstream file(m_path, std::ios::binary);
+    if (!file) return false;
+    file.seekg(static_cast<std::streamoff>(m_tileOffsets[static_cast<size_t>(tileZ) * m_header.tilesX + tileX]));
+
+    std::vector<uint8_t> raw(sampleCount * sampleSize);
+    if (!file.read(reinterpret_cast<char*>(raw.data()), raw.size())) return false;
+
+    outSamples.resize(sampleCount);
+    DecodeHeightSamples(raw.data(), format, sampleSize, sampleCount, outSamples.data());
+    return true;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+#include "HeightfieldFormats.h"
+
+// Heightfield grande guardado por teselas (paginas) para cargarlo a trozos.
+//
+// Formato (little-endian):
+//   Header { uint32 magic 'HFPG'; uint32 version; uint32 width; uint32 height;
+//            uint32 tileSize; uint32 tilesX; uint32 tilesZ; uint32 format; }
+//   uint64 offset[tilesX * tilesZ]   (por filas de teselas, relativo al inicio del archivo)
+//   Teselas de tileSize x tileSize muestras (UNorm16 o Float32). Las del borde se
+//   rellenan repitiendo la ultima fila/columna, asi todas miden lo mismo.
+//
+// Cada ReadTile abre su propio stream, asi que se puede leer desde varios hilos.
+class HeightfieldPageFile
+{
+public:
+    static const uint32_t MAGIC = 0x47504648; // "HFPG"
+    static const uint32_t VERSION = 1;
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t width;
+        uint32_t height;
+        uint32_t tileSize;
+        uint32_t tilesX;
+        uint32_t tilesZ;
+        uint32_t format; // HeightSampleFormat
+    };
+
+    HeightfieldPageFile();
+
+    // Escribe un heightfield completo (alturas en [0, 1] para UNorm16).
+    static bool Write(const std::filesystem::path& path, const float* heights, int width, int height,
+        int tileSize, HeightSampleFormat format);
+
+    // Lee solo la cabecera y la tabla de teselas.
+    bool Open(const std::filesystem::path& path);
+
+    // tileSize * tileSize alturas de la tesela (tileX, tileZ).
+    bool ReadTile(int tileX, int tileZ, std::vector<float>& outSamples) const;
+
+    bool IsOpen() const { return !m_tileOffsets.empty(); }
+    int GetWidth() const { return static_cast<int>(m_header.width); }
+    int GetHeight() const { return static_cast<int>(m_header.height); }
+    int GetTileSize() const { return static_cast<int>(m_header.tileSize); }
+    int GetTilesX() const { return static_cast<int>(m_header.tilesX); }
+    int GetTilesZ() const { return static_cast<int>(m_header.tilesZ); }
+    HeightSampleFormat GetFormat() const { return static_cast<HeightSampleFormat>(m_header.format); }
+
+private:
+    std::filesystem::path m_path;
+    Header m_header;
+    std::vector<uint64_t> m_tileOffsets;
+};
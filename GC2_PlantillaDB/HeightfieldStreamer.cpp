@@ -0,0 +1,259 @@
+#include "pch.h"
+#include "HeightfieldStreamer.h"
+
+#include <algorithm>
+#include <cmath>
+
+HeightfieldStreamer::HeightfieldStreamer() :
+    m_budgetBytes(0),
+    m_frame(0),
+    m_loadsInFlight(0),
+    m_stopLoader(false)
+{
+}
+
+HeightfieldStreamer::~HeightfieldStreamer()
+{
+    Close();
+}
+
+bool HeightfieldStreamer::Open(const std::filesystem::path& path, size_t memoryBudgetBytes)
+{
+    Close();
+    if (!m_file.Open(path)) return false;
+
+    m_budgetBytes = memoryBudgetBytes;
+    m_stats = HeightfieldStreamerStats();
+    m_stats.budgetBytes = memoryBudgetBytes;
+    m_stopLoader = false;
+    m_loaderThread = std::thread(&HeightfieldStreamer::LoaderLoop, this);
+    return true;
+}
+
+void HeightfieldStreamer::Close()
+{
+    if (m_loaderThread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_queueMutex);
+            m_stopLoader = true;
+            m_requests.clear();
+        }
+        m_queueCondition.notify_all();
+        m_loaderThread.join();
+    }
+
+    m_completed.clear();
+    m_loadsInFlight = 0;
+    m_residentTiles.clear();
+    m_pendingTiles.clear();
+    m_frame = 0;
+}
+
+size_t HeightfieldStreamer::GetTileBytes() const
+{
+    return static_cast<size_t>(m_file.GetTileSize()) * m_file.GetTileSize() * sizeof(float);
+}
+
+void HeightfieldStreamer::LoaderLoop()
+{
+    for (;;)
+    {
+        int key;
+        {
+            std::unique_lock<std::mutex> lock(m_queueMutex);
+            m_queueCondition.wait(lock, [this] { return m_stopLoader || !m_requests.empty(); });
+            if (m_stopLoader) return;
+
+            key = m_requests.front();
+            m_requests.pop_front();
+            m_loadsInFlight++;
+        }
+
+        std::vector<float> samples;
+        if (!m_file.ReadTile(key % m_file.GetTilesX(), key / m_file.GetTilesX(), samples)) samples.clear();
+
+        {
+            std::lock_guard<std::mutex> lock(m_queueMutex);
+            m_completed.emplace_back(key, std::move(samples));
+            m_loadsInFlight--;
+            if (m_requests.empty() && m_loadsInFlight == 0) m_idleCondition.notify_all();
+        }
+    }
+}
+
+void HeightfieldStreamer::IntegrateCompletedTiles()
+{
+    std::vector<std::pair<int, std::vector<float>>> completed;
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        completed.swap(m_completed);
+    }
+
+    for (auto& tile : completed)
+    {
+        m_pendingTiles.erase(tile.first);
+        if (tile.second.empty())
+        {
+            m_stats.loadFailures++;
+            continue;
+        }
+
+        ResidentTile& resident = m_residentTiles[tile.first];
+        resident.samples = std::move(tile.second);
+        resident.lastUsedFrame = m_frame;
+        m_stats.tilesLoaded++;
+    }
+}
+
+void HeightfieldStreamer::Update(float centerX, float centerZ, float radius)
+{
+    if (!m_file.IsOpen()) return;
+
+    IntegrateCompletedTiles();
+    m_frame++;
+
+    const int tileSize = m_file.GetTileSize();
+    const int lastX = m_file.GetWidth() - 1;
+    const int lastZ = m_file.GetHeight() - 1;
+
+    // Teselas que tocan el circulo, de la mas cercana a la mas lejana
+    struct Candidate
+    {
+        int key;
+        float distanceSq;
+    };
+    std::vector<Candidate> candidates;
+
+    const int firstTileX = std::max(0, static_cast<int>(std::floor((centerX - radius) / tileSize)));
+    const int lastTileX = std::min(m_file.GetTilesX() - 1, static_cast<int>(std::floor((centerX + radius) / tileSize)));
+    const int firstTileZ = std::max(0, static_cast<int>(std::floor((centerZ - radius) / tileSize)));
+    const int lastTileZ = std::min(m_file.GetTilesZ() - 1, static_cast<int>(std::floor((centerZ + radius) / tileSize)));
+
+    for (int tileZ = firstTileZ; tileZ <= lastTileZ; ++tileZ)
+    {
+        for (int tileX = firstTileX; tileX <= lastTileX; ++tileX)
+        {
+            float minX = static_cast<float>(tileX * tileSize);
+            float maxX = static_cast<float>(std::min((tileX + 1) * tileSize - 1, lastX));
+            float minZ = static_cast<float>(tileZ * tileSize);
+            float maxZ = static_cast<float>(std::min((tileZ + 1) * tileSize - 1, lastZ));
+            float dx = std::max(std::max(minX - centerX, 0.0f), centerX - maxX);
+            float dz = std::max(std::max(minZ - centerZ, 0.0f), centerZ - maxZ);
+            float distanceSq = dx * dx + dz * dz;
+            if (distanceSq <= radius * radius) candidates.push_back({ TileKey(tileX, tileZ), distanceSq });
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(),
+        [](const Candidate& a, const Candidate& b) { return a.distanceSq < b.distanceSq; });
+
+    // Con el presupuesto solo caben las mas cercanas
+    const size_t maxTiles = std::max<size_t>(1, m_budgetBytes / GetTileBytes());
+    if (candidates.size() > maxTiles) candidates.resize(maxTiles);
+
+    std::unordered_set<int> desired;
+    for (const Candidate& candidate : candidates)
+    {
+        desired.insert(candidate.key);
+        auto it = m_residentTiles.find(candidate.key);
+        if (it != m_residentTiles.end()) it->second.lastUsedFrame = m_frame;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+
+        // Las peticiones que aun no empezaron se rehacen con las prioridades de este frame
+        for (int key : m_requests) m_pendingTiles.erase(key);
+        m_requests.clear();
+
+        std::vector<int> missing;
+        for (const Candidate& candidate : candidates)
+        {
+            if (!m_residentTiles.count(candidate.key) && !m_pendingTiles.count(candidate.key)) missing.push_back(candidate.key);
+        }
+
+        // Expulsar las teselas no deseadas menos usadas hasta que quepa lo que falta
+        while (m_residentTiles.size() + m_pendingTiles.size() + missing.size() > maxTiles)
+        {
+            auto victim = m_residentTiles.end();
+            for (auto it = m_residentTiles.begin(); it != m_residentTiles.end(); ++it)
+            {
+                if (desired.count(it->first)) continue;
+                if (victim == m_residentTiles.end() || it->second.lastUsedFrame < victim->second.lastUsedFrame) victim = it;
+            }
+            if (victim == m_residentTiles.end()) break;
+            m_residentTiles.erase(victim);
+            m_stats.tilesEvicted++;
+        }
+
+        size_t used = m_residentTiles.size() + m_pendingTiles.size();
+        for (int key : missing)
+        {
+            if (used >= maxTiles) break;
+            m_requests.push_back(key);
+            m_pendingTiles.insert(key);
+            used++;
+        }
+    }
+    m_queueCondition.notify_one();
+
+    m_stats.residentTiles = static_cast<int>(m_residentTiles.size());
+    m_stats.pendingTiles = static_cast<int>(m_pendingTiles.size());
+    m_stats.residentBytes = m_residentTiles.size() * GetTileBytes();
+}
+
+void HeightfieldStreamer::WaitForPendingLoads()
+{
+    if (!m_loaderThread.joinable()) return;
+    {
+        std::unique_lock<std::mutex> lock(m_queueMutex);
+        m_idleCondition.wait(lock, [this] { return m_requests.empty() && m_loadsInFlight == 0; });
+    }
+    IntegrateCompletedTiles();
+
+    m_stats.residentTiles = static_cast<int>(m_residentTiles.size());
+    m_stats.pendingTiles = static_cast<int>(m_pendingTiles.size());
+    m_stats.residentBytes = m_residentTiles.size() * GetTileBytes();
+}
+
+bool HeightfieldStreamer::IsTileResident(int tileX, int tileZ) const
+{
+    if (tileX < 0 || tileZ < 0 || tileX >= m_file.GetTilesX() || tileZ >= m_file.GetTilesZ()) return false;
+    return m_residentTiles.count(TileKey(tileX, tileZ)) != 0;
+}
+
+bool HeightfieldStreamer::GetSample(int x, int z, float& outHeight) const
+{
+    const int tileSize = m_file.GetTileSize();
+    auto it = m_residentTiles.find(TileKey(x / tileSize, z / tileSize));
+    if (it == m_residentTiles.end()) return false;
+
+    outHeight = it->second.samples[static_cast<size_t>(z % tileSize) * tileSize + (x % tileSize)];
+    return true;
+}
+
+bool HeightfieldStreamer::TryGetHeight(float x, float z, float& outHeight) const
+{
+    if (!m_file.IsOpen()) return false;
+
+    const int lastX = m_file.GetWidth() - 1;
+    const int lastZ = m_file.GetHeight() - 1;
+    x = std::min(std::max(x, 0.0f), static_cast<float>(lastX));
+    z = std::min(std::max(z, 0.0f), static_cast<float>(lastZ));
+
+    int x0 = static_cast<int>(x);
+    int z0 = static_cast<int>(z);
+    int x1 = std::min(x0 + 1, lastX);
+    int z1 = std::min(z0 + 1, lastZ);
+    float fx = x - x0;
+    float fz = z - z0;
+
+    float h00, h10, h01, h11;
+    if (!GetSample(x0, z0, h00) || !GetSample(x1, z0, h10) ||
+        !GetSample(x0, z1, h01) || !GetSample(x1, z1, h11)) return false;
+
+    float top = h00 + (h10 - h00) * fx;
+    float bottom = h01 + (h11 - h01) * fx;
+    outHeight = top + (bottom - top) * fz;
+    return true;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "HeightfieldPages.h"
+
+struct HeightfieldStreamerStats
+{
+    int residentTiles = 0;
+    int pendingTiles = 0;   // Pedidas y aun no integradas
+    size_t residentBytes = 0;
+    size_t budgetBytes = 0;
+    int tilesLoaded = 0;
+    int tilesEvicted = 0;
+    int loadFailures = 0;
+};
+
+// Carga asincrona de las teselas de un HeightfieldPageFile alrededor de un punto.
+// Un hilo propio lee las teselas del disco; Update (hilo principal) integra las que
+// terminaron, pide las que faltan por orden de distancia y expulsa las menos usadas
+// cuando se supera el presupuesto de memoria. Las consultas de altura solo se hacen
+// desde el hilo principal, asi que las teselas residentes no necesitan candado.
+// Las coordenadas son de muestra del heightfield (x en [0, width - 1], z en [0, height - 1]).
+class HeightfieldStreamer
+{
+public:
+    HeightfieldStreamer();
+    ~HeightfieldStreamer();
+
+    HeightfieldStreamer(const HeightfieldStreamer&) = delete;
+    HeightfieldStreamer& operator=(const HeightfieldStreamer&) = delete;
+
+    bool Open(const std::filesystem::path& path, size_t memoryBudgetBytes);
+    void Close();
+
+    // Mantiene cargadas (dentro del presupuesto) las teselas a menos de 'radius' muestras del centro.
+    void Update(float centerX, float centerZ, float radius);
+
+    // Altura bilineal; false si alguna de las teselas necesarias no esta cargada.
+    bool TryGetHeight(float x, float z, float& outHeight) const;
+
+    bool IsTileResident(int tileX, int tileZ) const;
+
+    // Bloquea hasta que el hilo de carga termina lo pedido y lo integra (pruebas / pantalla de carga).
+    void WaitForPendingLoads();
+
+    const HeightfieldPageFile& GetFile() const { return m_file; }
+    const HeightfieldStreamerStats& GetStats() const { return m_stats; }
+
+private:
+    struct ResidentTile
+    {
+        std::vector<float> samples;
+        uint64_t lastUsedFrame = 0;
+    };
+
+    void LoaderLoop();
+    void IntegrateCompletedTiles();
+    bool GetSample(int x, int z, float& outHeight) const;
+    size_t GetTileBytes() const;
+
+    int TileKey(int tileX, int tileZ) const { return tileZ * m_file.GetTilesX() + tileX; }
+
+    HeightfieldPageFile m_file;
+    size_t m_budgetBytes;
+    uint64_t m_frame;
+
+    // Solo hilo principal
+    std::unordered_map<int, ResidentTile> m_residentTiles;
+    std::unordered_set<int> m_pendingTiles;
+
+    // Compartido con el hilo de carga
+    std::mutex m_queueMutex;
+    std::condition_variable m_queueCondition;
+    std::condition_variable m_idleCondition;
+    std::deque<int> m_requests;
+    std::vector<std::pair<int, std::vector<float>>> m_completed; // Vector vacio = fallo
+    int m_loadsInFlight;
+    bool m_stopLoader;
+    std::thread m_loaderThread;
+
+    HeightfieldStreamerStats m_stats;
+};
@@ -0,0 +1,568 @@
+#include "HeightmapDecoder.h"
+#include "HeightfieldFormats.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cwctype>
+#include <fstream>
+#include <string>
+
+namespace
+{
+    uint32_t ReadBigEndian32(const uint8_t* p)
+    {
+        return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+            (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+    }
+
+    uint32_t ReadLittleEndian32(const uint8_t* p)
+    {
+        return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+            (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+
+    uint16_t ReadLittleEndian16(const uint8_t* p)
+    {
+        return static_cast<uint16_t>(p[0] | (p[1] << 8));
+    }
+
+    // --- Inflate (RFC 1951) ---
+
+    // Lector de bits LSB primero. Pasado el final rellena con ceros; Overrun indica si se ha llegado a usar el relleno.
+    class BitReader
+    {
+    public:
+        BitReader(const uint8_t* data, size_t size) : m_data(data), m_size(size), m_position(0), m_buffer(0), m_count(0), m_padding(0) {}
+
+        uint32_t Peek(int bits)
+        {
+            if (m_count < bits) Refill();
+            return static_cast<uint32_t>(m_buffer & ((1ull << bits) - 1));
+        }
+
+        void Consume(int bits)
+        {
+            m_buffer >>= bits;
+            m_count -= bits;
+        }
+
+        uint32_t Read(int bits)
+        {
+            if (bits == 0) return 0;
+            uint32_t value = Peek(bits);
+            Consume(bits);
+            return value;
+        }
+
+        // Siempre se cargan bytes enteros, asi que lo que sobra de 8 es el resto del byte actual
+        void AlignToByte() { Consume(m_count % 8); }
+
+        // El relleno esta siempre en la parte alta del buffer
+        bool Overrun() const { return m_count < m_padding; }
+
+    private:
+        void Refill()
+        {
+            while (m_count <= 56)
+            {
+                if (m_position < m_size) m_buffer |= static_cast<uint64_t>(m_data[m_position++]) << m_count;
+                else m_padding += 8;
+                m_count += 8;
+            }
+        }
+
+        const uint8_t* m_data;
+        size_t m_size;
+        size_t m_position;
+        uint64_t m_buffer;
+        int m_count;
+        int m_padding;
+    };
+
+    // Codigo Huffman canonico: tabla directa para codigos de hasta FAST_BITS y busqueda por longitud para el resto
+    class Huffman
+    {
+    public:
+        static const int MAX_BITS = 15;
+        static const int FAST_BITS = 9;
+
+        bool Build(const uint8_t* lengths, int count)
+        {
+            std::fill(std::begin(m_counts), std::end(m_counts), static_cast<uint16_t>(0));
+            for (int symbol = 0; symbol < count; ++symbol) m_counts[lengths[symbol]]++;
+            m_counts[0] = 0;
+
+            // Un codigo sobresuscrito no es valido (uno incompleto si, p.ej. con un solo simbolo)
+            int left = 1;
+            for (int length = 1; length <= MAX_BITS; ++length)
+            {
+                left = (left << 1) - m_counts[length];
+                if (left < 0) return false;
+            }
+
+            uint16_t offsets[MAX_BITS + 2] = {};
+            for (int length = 1; length <= MAX_BITS; ++length) offsets[length + 1] = offsets[length] + m_counts[length];
+            m_symbols.assign(count, 0);
+            for (int symbol = 0; symbol < count; ++symbol)
+            {
+                if (lengths[symbol]) m_symbols[offsets[lengths[symbol]]++] = static_cast<uint16_t>(symbol);
+            }
+
+            // Tabla rapida indexada con los bits tal como llegan (invertidos respecto al codigo)
+            std::fill(std::begin(m_fast), std::end(m_fast), static_cast<uint16_t>(0));
+            int code = 0;
+            int index = 0;
+            for (int length = 1; length <= FAST_BITS; ++length)
+            {
+                for (int k = 0; k < m_counts[length]; ++k, ++code, ++index)
+                {
+                    int reversed = 0;
+                    for (int bit = 0; bit < length; ++bit) reversed |= ((code >> bit) & 1) << (length - 1 - bit);
+                    for (int fill = reversed; fill < (1 << FAST_BITS); fill += 1 << length)
+                    {
+                        m_fast[fill] = static_cast<uint16_t>((length << 12) | m_symbols[index]);
+                    }
+                }
+                code <<= 1;
+            }
+            return true;
+        }
+
+        // -1 si el codigo no existe
+        int Decode(BitReader& reader) const
+        {
+            uint16_t entry = m_fast[reader.Peek(FAST_BITS)];
+            if (entry)
+            {
+                reader.Consume(entry >> 12);
+                return entry & 0x0FFF;
+            }
+
+            // Codigos largos, bit a bit (puff)
+            int code = 0;
+            int first = 0;
+            int index = 0;
+            for (int length = 1; length <= MAX_BITS; ++length)
+            {
+                code |= static_cast<int>(reader.Read(1));
+                int count = m_counts[length];
+                if (code - count < first) return m_symbols[index + (code - first)];
+                index += count;
+                first = (first + count) << 1;
+                code <<= 1;
+            }
+            return -1;
+        }
+
+    private:
+        uint16_t m_counts[MAX_BITS + 1] = {};
+        std::vector<uint16_t> m_symbols;
+        uint16_t m_fast[1 << FAST_BITS] = {};
+    };
+
+    const uint16_t LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    const uint8_t LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    const uint16_t DISTANCE_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537,
+        2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    const uint8_t DISTANCE_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+    bool InflateCodes(BitReader& reader, const Huffman& literals, const Huffman& distances, std::vector<uint8_t>& out)
+    {
+        for (;;)
+        {
+            int symbol = literals.Decode(reader);
+            if (symbol < 0 || reader.Overrun()) return false;
+            if (symbol < 256)
+            {
+                out.push_back(static_cast<uint8_t>(symbol));
+                continue;
+            }
+            if (symbol == 256) return true;
+
+            symbol -= 257;
+            if (symbol >= 29) return false;
+            size_t length = LENGTH_BASE[symbol] + reader.Read(LENGTH_EXTRA[symbol]);
+
+            int distanceSymbol = distances.Decode(reader);
+            if (distanceSymbol < 0 || distanceSymbol >= 30) return false;
+            size_t distance = DISTANCE_BASE[distanceSymbol] + reader.Read(DISTANCE_EXTRA[distanceSymbol]);
+            if (distance > out.size() || reader.Overrun()) return false;
+
+            // Byte a byte: la copia puede solaparse con lo que escribe
+            size_t from = out.size() - distance;
+            size_t to = out.size();
+            out.resize(to + length);
+            for (size_t k = 0; k < length; ++k) out[to + k] = out[from + k];
+        }
+    }
+
+    bool Inflate(const uint8_t* data, size_t size, std::vector<uint8_t>& out)
+    {
+        BitReader reader(data, size);
+
+        Huffman fixedLiterals;
+        Huffman fixedDistances;
+        bool fixedBuilt = false;
+
+        bool last = false;
+        while (!last)
+        {
+            last = reader.Read(1) != 0;
+            uint32_t type = reader.Read(2);
+            if (type == 0)
+            {
+                // Bloque sin comprimir
+                reader.AlignToByte();
+                uint32_t length = reader.Read(16);
+                uint32_t inverse = reader.Read(16);
+                if ((length ^ 0xFFFF) != inverse) return false;
+                for (uint32_t k = 0; k < length; ++k) out.push_back(static_cast<uint8_t>(reader.Read(8)));
+                if (reader.Overrun()) return false;
+            }
+            else if (type == 1)
+            {
+                if (!fixedBuilt)
+                {
+                    uint8_t lengths[288];
+                    std::fill(lengths, lengths + 144, static_cast<uint8_t>(8));
+                    std::fill(lengths + 144, lengths + 256, static_cast<uint8_t>(9));
+                    std::fill(lengths + 256, lengths + 280, static_cast<uint8_t>(7));
+                    std::fill(lengths + 280, lengths + 288, static_cast<uint8_t>(8));
+                    fixedLiterals.Build(lengths, 288);
+                    std::fill(lengths, lengths + 30, static_cast<uint8_t>(5));
+                    fixedDistances.Build(lengths, 30);
+                    fixedBuilt = true;
+                }
+                if (!InflateCodes(reader, fixedLiterals, fixedDistances, out)) return false;
+            }
+            else if (type == 2)
+            {
+                static const uint8_t ORDER[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+                int literalCount = static_cast<int>(reader.Read(5)) + 257;
+                int distanceCount = static_cast<int>(reader.Read(5)) + 1;
+                int codeLengthCount = static_cast<int>(reader.Read(4)) + 4;
+                if (literalCount > 286 || distanceCount > 30) return false;
+
+                uint8_t codeLengthLengths[19] = {};
+                for (int k = 0; k < codeLengthCount; ++k) codeLengthLengths[ORDER[k]] = static_cast<uint8_t>(reader.Read(3));
+                Huffman codeLengths;
+                if (!codeLengths.Build(codeLengthLengths, 19)) return false;
+
+                uint8_t lengths[286 + 30] = {};
+                int index = 0;
+                while (index < literalCount + distanceCount)
+                {
+                    int symbol = codeLengths.Decode(reader);
+                    if (symbol < 0 || reader.Overrun()) return false;
+                    if (symbol < 16)
+                    {
+                        lengths[index++] = static_cast<uint8_t>(symbol);
+                        continue;
+                    }
+
+                    uint8_t value = 0;
+                    int repeat;
+                    if (symbol == 16)
+                    {
+                        if (index == 0) return false;
+                        value = lengths[index - 1];
+                        repeat = 3 + static_cast<int>(reader.Read(2));
+                    }
+                    else if (symbol == 17) repeat = 3 + static_cast<int>(reader.Read(3));
+                    else repeat = 11 + static_cast<int>(reader.Read(7));
+
+                    if (index + repeat > literalCount + distanceCount) return false;
+                    while (repeat--) lengths[index++] = value;
+                }
+                if (lengths[256] == 0) return false; // Sin codigo de fin de bloque
+
+                Huffman literals;
+                Huffman distances;
+                if (!literals.Build(lengths, literalCount) || !distances.Build(lengths + literalCount, distanceCount)) return false;
+                if (!InflateCodes(reader, literals, distances, out)) return false;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return !reader.Overrun();
+    }
+
+    // Flujo zlib (RFC 1950): cabecera de 2 bytes, deflate y Adler-32
+    bool ZlibDecompress(const uint8_t* data, size_t size, std::vector<uint8_t>& out)
+    {
+        if (size < 6) return false;
+        if ((data[0] & 0x0F) != 8 || ((data[0] << 8) | data[1]) % 31 != 0 || (data[1] & 0x20)) return false;
+        if (!Inflate(data + 2, size - 6, out)) return false;
+
+        uint32_t a = 1;
+        uint32_t b = 0;
+        for (size_t i = 0; i < out.size(); ++i)
+        {
+            a += out[i];
+            b += a;
+            if ((i & 0xFFF) == 0xFFF) { a %= 65521; b %= 65521; } // Antes de que b desborde
+        }
+        a %= 65521;
+        b %= 65521;
+        return ((b << 16) | a) == ReadBigEndian32(data + size - 4);
+    }
+
+    uint8_t Paeth(uint8_t a, uint8_t b, uint8_t c)
+    {
+        int p = static_cast<int>(a) + b - c;
+        int pa = std::abs(p - a);
+        int pb = std::abs(p - b);
+        int pc = std::abs(p - c);
+        if (pa <= pb && pa <= pc) return a;
+        return pb <= pc ? b : c;
+    }
+
+    std::vector<uint8_t> ReadFile(const std::filesystem::path& path)
+    {
+        std::vector<uint8_t> bytes;
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file) return bytes;
+        std::streamoff size = file.tellg();
+        if (size <= 0) return bytes;
+        bytes.resize(static_cast<size_t>(size));
+        file.seekg(0, std::ios::beg);
+        if (!file.read(reinterpret_cast<char*>(bytes.data()), size)) bytes.clear();
+        return bytes;
+    }
+
+    std::wstring LowercaseExtension(const std::filesystem::path& path)
+    {
+        std::wstring extension = path.extension().wstring();
+        for (wchar_t& c : extension) c = static_cast<wchar_t>(towlower(c));
+        return extension;
+    }
+}
+
+bool DecodePngHeightmap(const uint8_t* data, size_t size, int& width, int& height, std::vector<float>& outHeights)
+{
+    static const uint8_t SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    if (size < 8 || memcmp(data, SIGNATURE, 8) != 0) return false;
+
+    uint32_t imageWidth = 0;
+    uint32_t imageHeight = 0;
+    int bitDepth = 0;
+    int colorType = -1;
+    std::vector<uint8_t> paletteRed;
+    std::vector<uint8_t> compressed;
+
+    // Trozos: IHDR, PLTE e IDAT (concatenados); el resto se ignora. No se comprueba el CRC.
+    size_t position = 8;
+    while (position + 12 <= size)
+    {
+        uint32_t length = ReadBigEndian32(data + position);
+        const uint8_t* type = data + position + 4;
+        const uint8_t* chunk = data + position + 8;
+        if (length > size - position - 12) return false;
+
+        if (memcmp(type, "IHDR", 4) == 0)
+        {
+            if (length < 13) return false;
+            imageWidth = ReadBigEndian32(chunk);
+            imageHeight = ReadBigEndian32(chunk + 4);
+            bitDepth = chunk[8];
+            colorType = chunk[9];
+            if (chunk[10] != 0 || chunk[11] != 0) return false; // Compresion y filtro estandar
+            if (chunk[12] != 0) return false;                   // Entrelazado Adam7 no soportado
+        }
+        else if (memcmp(type, "PLTE", 4) == 0)
+        {
+            for (uint32_t k = 0; k + 2 < length; k += 3) paletteRed.push_back(chunk[k]);
+        }
+        else if (memcmp(type, "IDAT", 4) == 0)
+        {
+            compressed.insert(compressed.end(), chunk, chunk + length);
+        }
+        else if (memcmp(type, "IEND", 4) == 0)
+        {
+            break;
+        }
+        position += 12 + static_cast<size_t>(length);
+    }
+
+    int channels;
+    switch (colorType)
+    {
+    case 0: channels = 1; break; // Gris
+    case 2: channels = 3; break; // RGB
+    case 3: channels = 1; break; // Paleta
+    case 4: channels = 2; break; // Gris + alfa
+    case 6: channels = 4; break; // RGBA
+    default: return false;
+    }
+    if (bitDepth != 8 && !(bitDepth == 16 && colorType != 3)) return false;
+    if (colorType == 3 && paletteRed.empty()) return false;
+    if (imageWidth == 0 || imageHeight == 0 || imageWidth > 65536 || imageHeight > 65536) return false;
+
+    const size_t bytesPerPixel = static_cast<size_t>(channels) * (bitDepth / 8);
+    const size_t rowBytes = bytesPerPixel * imageWidth;
+
+    std::vector<uint8_t> raw;
+    raw.reserve((rowBytes + 1) * imageHeight);
+    if (!ZlibDecompress(compressed.data(), compressed.size(), raw)) return false;
+    if (raw.size() < (rowBytes + 1) * imageHeight) return false;
+
+    width = static_cast<int>(imageWidth);
+    height = static_cast<int>(imageHeight);
+    outHeights.resize(static_cast<size_t>(width) * height);
+
+    // Filtros por fila sobre el propio buffer descomprimido
+    std::vector<uint8_t> zeroRow(rowBytes, 0);
+    for (uint32_t y = 0; y < imageHeight; ++y)
+    {
+        uint8_t filter = raw[y * (rowBytes + 1)];
+        uint8_t* row = &raw[y * (rowBytes + 1) + 1];
+        const uint8_t* previous = y > 0 ? &raw[(y - 1) * (rowBytes + 1) + 1] : zeroRow.data();
+
+        switch (filter)
+        {
+        case 0: break;
+        case 1: for (size_t k = bytesPerPixel; k < rowBytes; ++k) row[k] = static_cast<uint8_t>(row[k] + row[k - bytesPerPixel]); break;
+        case 2: for (size_t k = 0; k < rowBytes; ++k) row[k] = static_cast<uint8_t>(row[k] + previous[k]); break;
+        case 3:
+            for (size_t k = 0; k < rowBytes; ++k)
+            {
+                int left = k >= bytesPerPixel ? row[k - bytesPerPixel] : 0;
+                row[k] = static_cast<uint8_t>(row[k] + ((left + previous[k]) >> 1));
+            }
+            break;
+        case 4:
+            for (size_t k = 0; k < rowBytes; ++k)
+            {
+                uint8_t left = k >= bytesPerPixel ? row[k - bytesPerPixel] : 0;
+                uint8_t upperLeft = k >= bytesPerPixel ? previous[k - bytesPerPixel] : 0;
+                row[k] = static_cast<uint8_t>(row[k] + Paeth(left, previous[k], upperLeft));
+            }
+            break;
+        default:
+            return false;
+        }
+
+        float* destination = &outHeights[static_cast<size_t>(y) * width];
+        if (colorType == 3)
+        {
+            for (uint32_t x = 0; x < imageWidth; ++x)
+            {
+                uint8_t index = row[x];
+                destination[x] = static_cast<float>(index < paletteRed.size() ? paletteRed[index] : 0) / 255.0f;
+            }
+        }
+        else if (bitDepth == 8)
+        {
+            DecodeHeightSamples(row, HeightSampleFormat::UNorm8, bytesPerPixel, imageWidth, destination);
+        }
+        else
+        {
+            // PNG guarda las muestras de 16 bits en big-endian
+            for (uint32_t x = 0; x < imageWidth; ++x)
+            {
+                const uint8_t* pixel = row + x * bytesPerPixel;
+                destination[x] = static_cast<float>((pixel[0] << 8) | pixel[1]) / 65535.0f;
+            }
+        }
+    }
+    return true;
+}
+
+bool DecodeBmpHeightmap(const uint8_t* data, size_t size, int& width, int& height, std::vector<float>& outHeights)
+{
+    if (size < 54 || data[0] != 'B' || data[1] != 'M') return false;
+
+    const uint32_t pixelOffset = ReadLittleEndian32(data + 10);
+    const uint32_t headerSize = ReadLittleEndian32(data + 14);
+    if (headerSize < 40 || 14 + static_cast<size_t>(headerSize) > size) return false;
+
+    const int32_t signedWidth = static_cast<int32_t>(ReadLittleEndian32(data + 18));
+    const int32_t signedHeight = static_cast<int32_t>(ReadLittleEndian32(data + 22));
+    const uint16_t bitCount = ReadLittleEndian16(data + 28);
+    const uint32_t compression = ReadLittleEndian32(data + 30);
+    uint32_t paletteCount = ReadLittleEndian32(data + 46);
+
+    // BI_RGB, o BI_BITFIELDS a 32 bits (se usa la mascara del rojo)
+    uint32_t redShift = 16;
+    if (compression == 3 && bitCount == 32)
+    {
+        if (size < 58) return false; // Las mascaras van justo detras de los 40 bytes de BITMAPINFOHEADER
+        uint32_t redMask = ReadLittleEndian32(data + 54);
+        if (redMask == 0) return false;
+        redShift = 0;
+        while (((redMask >> redShift) & 1) == 0) redShift++;
+    }
+    else if (compression != 0)
+    {
+        return false;
+    }
+    if (bitCount != 8 && bitCount != 24 && bitCount != 32) return false;
+    if (signedWidth <= 0 || signedHeight == 0 || signedWidth > 65536 || std::abs(signedHeight) > 65536) return false;
+
+    const bool topDown = signedHeight < 0;
+    width = signedWidth;
+    height = std::abs(signedHeight);
+    const size_t rowStride = ((static_cast<size_t>(width) * bitCount + 31) / 32) * 4;
+    if (pixelOffset + rowStride * height > size) return false;
+
+    // Paleta BGRA detras de la cabecera
+    const uint8_t* palette = data + 14 + headerSize;
+    if (bitCount == 8)
+    {
+        if (paletteCount == 0 || paletteCount > 256) paletteCount = 256;
+        if (14 + static_cast<size_t>(headerSize) + paletteCount * 4 > size) return false;
+    }
+
+    outHeights.resize(static_cast<size_t>(width) * height);
+    for (int y = 0; y < height; ++y)
+    {
+        const uint8_t* row = data + pixelOffset + rowStride * (topDown ? y : height - 1 - y);
+        float* destination = &outHeights[static_cast<size_t>(y) * width];
+        for (int x = 0; x < width; ++x)
+        {
+            uint8_t red;
+            if (bitCount == 8)
+            {
+                uint8_t index = row[x];
+                red = index < paletteCount ? palette[index * 4 + 2] : 0;
+            }
+            else if (bitCount == 24)
+            {
+                red = row[x * 3 + 2]; // BGR
+            }
+            else
+            {
+                red = static_cast<uint8_t>(ReadLittleEndian32(row + x * 4) >> redShift);
+            }
+            destination[x] = static_cast<float>(red) / 255.0f;
+        }
+    }
+    return true;
+}
+
+bool CanDecodeHeightmapFile(const std::filesystem::path& path)
+{
+    std::wstring extension = LowercaseExtension(path);
+    return extension == L".png" || extension == L".bmp" || extension == L".r16" || extension == L".raw" || extension == L".r32";
+}
+
+bool LoadHeightmapFile(const std::filesystem::path& path, int& width, int& height, std::vector<float>& outHeights)
+{
+    std::wstring extension = LowercaseExtension(path);
+    if (extension == L".r16" || extension == L".raw" || extension == L".r32")
+    {
+        width = 0;
+        height = 0;
+        HeightSampleFormat format = extension == L".r32" ? HeightSampleFormat::Float32 : HeightSampleFormat::UNorm16;
+        return LoadRawHeightfield(path, format, width, height, outHeights);
+    }
+
+    std::vector<uint8_t> bytes = ReadFile(path);
+    if (bytes.empty()) return false;
+    if (extension == L".png") return DecodePngHeightmap(bytes.data(), bytes.size(), width, height, outHeights);
+    if (extension == L".bmp") return DecodeBmpHeightmap(bytes.data(), bytes.size(), width, height, outHeights);
+    return false;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+// Decodificacion de heightmaps en CPU, sin dispositivo D3D ni WIC: se puede llamar desde
+// cualquier hilo y compila fuera de Windows. La altura es el primer canal de cada pixel
+// (gris, o R en RGB/RGBA/paleta), normalizada a [0, 1] igual que DecodeHeightSamples.
+// Filas de arriba a abajo, como en la textura que devolvia WIC.
+
+// PNG sin entrelazar: gris, gris + alfa, RGB, RGBA (8 o 16 bits) y paleta de 8 bits.
+bool DecodePngHeightmap(const uint8_t* data, size_t size, int& width, int& height, std::vector<float>& outHeights);
+
+// BMP sin comprimir de 8 (paleta), 24 o 32 bits.
+bool DecodeBmpHeightmap(const uint8_t* data, size_t size, int& width, int& height, std::vector<float>& outHeights);
+
+// Elige el decodificador por la extension: .png, .bmp y RAW (.r16 / .raw a 16 bits, .r32 float, cuadrados).
+bool CanDecodeHeightmapFile(const std::filesystem::path& path);
+bool LoadHeightmapFile(const std::filesystem::path& path, int& width, int& height, std::vector<float>& outHeights);
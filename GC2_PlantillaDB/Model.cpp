@@ -38,7 +38,10 @@ Model::Model() :
     m_worldMatrix(Matrix::Identity),
     m_position(Vector3::Zero),              
     m_rotation(Quaternion::Identity),       
-    m_scale(Vector3(1.0f, 1.0f, 1.0f))
+    m_scale(Vector3(1.0f, 1.0f, 1.0f)),
+    m_shaderRegistry(nullptr),
+    m_evolvingProgram(INVALID_SHADER_PROGRAM)
+
     // m_effect y m_inputLayout se inicializarn en Load()
 {
     UpdateWorldMatrix();
@@ -191,6 +194,30 @@ bool Model::Load(ID3D11Device* device, ID3D11DeviceContext* context, const std::
 
     // El mensaje de xito ya no mencionar "using custom shaders" porque esta funcin ya no los carga.
     CalculateOverallBoundingSphere();
+
+    m_shadowCasterMask = 0;
+    for (size_t i = 0; i < m_meshParts.size(); ++i)
+    {
+        ShadowCasterMode mode = GetPartShadowMode(i);
+        if (mode != ShadowCasterMode::None && m_meshParts[i].indexCount > 0) m_shadowCasterMask |= ShadowCasterBit(mode);
+    }
+    m_alphaModeMask = 0;
+    for (size_t i = 0; i < m_meshParts.size(); ++i)
+    {
+        if (m_meshParts[i].indexCount > 0) m_alphaModeMask |= MaterialAlphaBit(GetPartAlphaMode(i));
+    }
+
+    if (!m_modelSpacePositions.empty())
+    {
+        DirectX::BoundingBox::CreateFromPoints(m_localBoundingBox,
+            m_modelSpacePositions.size(),
+            m_modelSpacePositions.data(),
+            sizeof(DirectX::SimpleMath::Vector3));
+    }
+
+    m_collisionMesh.Build(m_modelSpacePositions.data(), m_modelSpacePositions.size(),
+        m_modelSpaceIndices.data(), m_modelSpaceIndices.size());
+
     OutputDebugStringA("Model geometry and materials loaded successfully: ");
     OutputDebugStringA(filename.c_str()); OutputDebugStringA("\n");
     return true;
@@ -319,6 +346,7 @@ void Model::ProcessMesh(ID3D11Device* device, ID3D11DeviceContext* context, aiMe
         // vertex.bitangent.x = mesh->mBitangents[i].x; ...
 
         verticesForRendering.push_back(vertex);
+        positionsForAABB.push_back(vertex.position);
     }
 
     // Extraer ndices de las caras (asumimos que son tringulos debido a aiProcess_Triangulate)
@@ -331,37 +359,42 @@ void Model::ProcessMesh(ID3D11Device* device, ID3D11DeviceContext* context, aiMe
         }
     }
 
-    // Crear y almacenar el MeshPart
-    MeshPart newMeshPart;
-    newMeshPart.localNodeTransform = currentFullNodeTransform; // Esta es la transformacin acumulada hasta este nodo/malla
-    newMeshPart.materialIndex = mesh->mMaterialIndex;
-    if (newMeshPart.InitializeBuffers(device, verticesForRendering, indices))
+    // Copia en CPU en espacio del modelo: las posiciones se llevan por la transformacin del nodo
+    const uint32_t baseVertex = static_cast<uint32_t>(m_modelSpacePositions.size());
+    for (const auto& vertex : verticesForRendering)
     {
-        m_meshParts.push_back(std::move(newMeshPart)); // Usar std::move para eficiencia
+        m_modelSpacePositions.push_back(Vector3::Transform(vertex.position, currentFullNodeTransform));
     }
-    else
+    for (uint32_t index : indices)
     {
-        OutputDebugString(L"ERROR::MODEL::PROCESS_MESH::Failed to initialize buffers for a mesh part.\n");
+        m_modelSpaceIndices.push_back(baseVertex + index);
     }
 
+    // Crear y almacenar el MeshPart
+    MeshPart newMeshPart;
+
+    newMeshPart.localNodeTransform = currentFullNodeTransform; // Esta es la transformacin acumulada hasta este nodo/malla
+    newMeshPart.materialIndex = mesh->mMaterialIndex;
+
+    // La AABB (en el espacio del nodo) tiene que estar antes de mover la parte al vector
     if (!positionsForAABB.empty()) {
         DirectX::BoundingBox::CreateFromPoints(newMeshPart.localAABB,
             positionsForAABB.size(),
             positionsForAABB.data(),
             sizeof(DirectX::SimpleMath::Vector3));
     }
-
     else {
         newMeshPart.localAABB.Center = DirectX::SimpleMath::Vector3::Zero;
         newMeshPart.localAABB.Extents = DirectX::SimpleMath::Vector3::Zero; // Caja invlida
     }
 
-    if (newMeshPart.InitializeBuffers(device, verticesForRendering, indices)) {
-        m_meshParts.push_back(std::move(newMeshPart));
+    if (newMeshPart.InitializeBuffers(device, verticesForRendering, indices))
+    {
+        m_meshParts.push_back(std::move(newMeshPart)); // Usar std::move para eficiencia
     }
-    else { 
-    
-        OutputDebugString(L"ERROR::MODEL::PROCESS_MESH::Failed to store vertices for collision.\n");
+    else
+    {
+        OutputDebugString(L"ERROR::MODEL::PROCESS_MESH::Failed to initialize buffers for a mesh part.\n");
     }
 }
 
@@ -412,11 +445,176 @@ void Model::LoadMaterials(ID3D11Device* device, ID3D11DeviceContext* context, co
             currentMaterial.emissiveColor = Vector4(color.r, color.g, color.b, color.a);
         }
 
+        // Opacidad del material (map_d / d en los .mtl)
+        float opacity = 1.0f;
+        aiGetMaterialFloat(pMaterial, AI_MATKEY_OPACITY, &opacity);
+        bool hasOpacityTexture = pMaterial->GetTextureCount(aiTextureType_OPACITY) > 0;
+
+        // El modo sale de los texeles, no de la extensin: un png sin huecos es opaco
+        MaterialAlphaMode diffuseTexels = ReadTextureAlphaMode(device, context, currentMaterial.diffuseTextureSRV.Get(), false);
+        MaterialAlphaMode opacityTexels = MaterialAlphaMode::Opaque;
+        if (hasOpacityTexture)
+        {
+            opacityTexels = MaterialAlphaMode::Masked;
+            if (pMaterial->GetTexture(aiTextureType_OPACITY, 0, &texturePathAi) == AI_SUCCESS)
+            {
+                ComPtr<ID3D11ShaderResourceView> opacitySRV = LoadTextureFromFile(device, context, std::string(texturePathAi.C_Str()));
+                opacityTexels = ReadTextureAlphaMode(device, context, opacitySRV.Get(), true);
+            }
+        }
+
+        currentMaterial.alphaMode = ClassifyMaterialAlpha(currentMaterial.diffuseTextureSRV != nullptr, diffuseTexels,
+            opacity, opacityTexels);
+        if (currentMaterial.alphaMode == MaterialAlphaMode::Masked)
+        {
+            OutputDebugString((L"Material con alpha clip: " + currentMaterial.diffuseTexturePath + L"\n").c_str());
+        }
+        currentMaterial.shadowMode = ClassifyShadowCaster(currentMaterial.alphaMode,
+            currentMaterial.diffuseTextureSRV != nullptr, opacity, hasOpacityTexture);
+
+
         m_materials[i] = std::move(currentMaterial);
     }
     OutputDebugString(L"Materials processed.\n");
 }
 
+MaterialAlphaMode Model::ClassifyMaterialAlpha(bool hasDiffuseTexture, MaterialAlphaMode diffuseTexels,
+    float opacity, MaterialAlphaMode opacityTexels)
+{
+    if (opacity < 1.0f || opacityTexels == MaterialAlphaMode::Masked)
+    {
+        return MaterialAlphaMode::Masked;
+    }
+
+    // Sin textura el shader muestrea alfa 0 y el clip original descartaba la malla entera;
+    // se mantiene ese resultado tratndola como Masked.
+    if (!hasDiffuseTexture)
+    {
+        return MaterialAlphaMode::Masked;
+    }
+    return diffuseTexels;
+}
+
+MaterialAlphaMode Model::ReadTextureAlphaMode(ID3D11Device* device, ID3D11DeviceContext* context,
+    ID3D11ShaderResourceView* textureSRV, bool opacityMap)
+{
+    if (!device || !context || !textureSRV) return MaterialAlphaMode::Masked;
+
+    ComPtr<ID3D11Resource> resource;
+    textureSRV->GetResource(resource.GetAddressOf());
+    ComPtr<ID3D11Texture2D> texture;
+    if (FAILED(resource.As(&texture))) return MaterialAlphaMode::Masked;
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    texture->GetDesc(&desc);
+
+    // Formatos que devuelve CreateWICTextureFromFile con 8 bits por canal
+    size_t texelStride = 0;
+    bool hasAlpha = false;
+    bool hasColor = false;
+    switch (desc.Format)
+    {
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+    case DXGI_FORMAT_B8G8R8A8_UNORM:
+    case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+        texelStride = 4; hasAlpha = true; hasColor = true;
+        break;
+    case DXGI_FORMAT_B8G8R8X8_UNORM:
+    case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+        texelStride = 4; hasColor = true;
+        break;
+    case DXGI_FORMAT_R8_UNORM:
+        texelStride = 1; hasColor = true;
+        break;
+    case DXGI_FORMAT_A8_UNORM:
+        texelStride = 1; hasAlpha = true;
+        break;
+    default:
+        return MaterialAlphaMode::Masked;
+    }
+    // Una textura difusa sin canal de alfa muestrea alfa 1: clip() nunca descarta
+    if (!hasAlpha && !opacityMap) return MaterialAlphaMode::Opaque;
+
+    D3D11_TEXTURE2D_DESC stagingDesc = {};
+    stagingDesc.Width = desc.Width;
+    stagingDesc.Height = desc.Height;
+    stagingDesc.MipLevels = 1;
+    stagingDesc.ArraySize = 1;
+    stagingDesc.Format = desc.Format;
+    stagingDesc.SampleDesc.Count = 1;
+    stagingDesc.Usage = D3D11_USAGE_STAGING;
+    stagingDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+
+    ComPtr<ID3D11Texture2D> staging;
+    if (FAILED(device->CreateTexture2D(&stagingDesc, nullptr, staging.GetAddressOf()))) return MaterialAlphaMode::Masked;
+    context->CopySubresourceRegion(staging.Get(), 0, 0, 0, 0, texture.Get(), 0, nullptr);
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    if (FAILED(context->Map(staging.Get(), 0, D3D11_MAP_READ, 0, &mapped))) return MaterialAlphaMode::Masked;
+
+    const uint8_t* texels = static_cast<const uint8_t*>(mapped.pData);
+    const int width = static_cast<int>(desc.Width);
+    const int height = static_cast<int>(desc.Height);
+    MaterialAlphaMode mode = MaterialAlphaMode::Opaque;
+    if (hasAlpha)
+    {
+        mode = ClassifyAlphaTexels(texels, width, height, mapped.RowPitch, texelStride, texelStride - 1);
+    }
+    // Un mapa de opacidad en gris (map_d de los .mtl) guarda la opacidad en el color
+    if (opacityMap && hasColor && mode == MaterialAlphaMode::Opaque)
+    {
+        mode = ClassifyAlphaTexels(texels, width, height, mapped.RowPitch, texelStride, 0);
+    }
+    context->Unmap(staging.Get(), 0);
+    return mode;
+}
+
+MaterialAlphaMode Model::GetPartAlphaMode(size_t partIndex) const
+{
+    if (partIndex >= m_meshParts.size()) return MaterialAlphaMode::Opaque;
+
+    UINT materialIndex = m_meshParts[partIndex].materialIndex;
+    if (materialIndex >= m_materials.size()) return MaterialAlphaMode::Masked;
+    return m_materials[materialIndex].alphaMode;
+}
+
+ShadowCasterMode Model::ClassifyShadowCaster(MaterialAlphaMode alphaMode, bool hasDiffuseTexture,
+    float opacity, bool hasOpacityTexture)
+{
+    if (!hasOpacityTexture && opacity <= 0.01f)
+    {
+        return ShadowCasterMode::None;
+    }
+
+    // ShadowPS_AlphaClip recorta con el alfa de la textura difusa: sin ella se descartaria todo
+    if (alphaMode == MaterialAlphaMode::Masked && hasDiffuseTexture)
+    {
+        return ShadowCasterMode::AlphaTested;
+    }
+    return ShadowCasterMode::Opaque;
+}
+
+ShadowCasterMode Model::GetPartShadowMode(size_t partIndex) const
+{
+    if (partIndex >= m_meshParts.size()) return ShadowCasterMode::None;
+
+    UINT materialIndex = m_meshParts[partIndex].materialIndex;
+    if (materialIndex >= m_materials.size()) return ShadowCasterMode::Opaque;
+    return m_materials[materialIndex].shadowMode;
+}
+
+void Model::GetPartBoxes(std::vector<PartBox>& outBoxes) const
+{
+    outBoxes.clear();
+    for (const auto& meshPart : m_meshParts)
+    {
+        const DirectX::BoundingBox& box = meshPart.localAABB;
+        if (box.Extents.x == 0.0f && box.Extents.y == 0.0f && box.Extents.z == 0.0f) continue;
+        outBoxes.push_back({ box.Center, box.Extents, meshPart.localNodeTransform });
+    }
+}
+
 ComPtr<ID3D11ShaderResourceView> Model::LoadTextureFromFile(ID3D11Device* device, ID3D11DeviceContext* context, const std::string& textureFilenameInModel)
 {
     if (textureFilenameInModel.empty()) return nullptr;
@@ -599,9 +797,11 @@ void Model::EvolvingDraw(ID3D11DeviceContext* context,
     const Matrix& lightViewMatrix,
     const Matrix& lightProjectionMatrix,
     ID3D11ShaderResourceView* shadowMapSRV,
-    ID3D11SamplerState* shadowSampler)
+    ID3D11SamplerState* shadowSampler,
+    ID3D11PixelShader* pixelShaderOverride)
 {
-    if (!m_evolvingVertexShader || !m_evolvingPixelShader || !m_evolvingInputLayout || m_meshParts.empty() ||
+    const ShaderProgram* program = GetEvolvingProgram();
+    if (!program || !program->pixelShader || m_meshParts.empty() ||
         !m_cbVS_Evolving_WVP || !m_cbPS_MaterialProperties)
     {
         if (!m_cbVS_Evolving_WVP) OutputDebugString(L"EvolvingDraw: m_cbVS_Evolving_WVP es nullptr! No se dibujar nada.\n");
@@ -609,9 +809,9 @@ void Model::EvolvingDraw(ID3D11DeviceContext* context,
         return;
     }
 
-    context->IASetInputLayout(m_evolvingInputLayout.Get());
-    context->VSSetShader(m_evolvingVertexShader.Get(), nullptr, 0);
-    context->PSSetShader(m_evolvingPixelShader.Get(), nullptr, 0);
+    context->IASetInputLayout(program->inputLayout.Get());
+    context->VSSetShader(program->vertexShader.Get(), nullptr, 0);
+    context->PSSetShader(pixelShaderOverride ? pixelShaderOverride : program->pixelShader.Get(), nullptr, 0);
 
     if (samplerState) context->PSSetSamplers(0, 1, &samplerState);
     if (lightPropertiesCB) context->PSSetConstantBuffers(1, 1, &lightPropertiesCB); 
@@ -684,8 +884,58 @@ void Model::EvolvingDraw(ID3D11DeviceContext* context,
     }
 }
 
+void Model::DepthPrepassDraw(ID3D11DeviceContext* context,
+    const Matrix& viewMatrix,
+    const Matrix& projectionMatrix,
+    MaterialAlphaMode mode)
+{
+    const ShaderProgram* program = GetEvolvingProgram();
+    if (!program || !m_cbVS_Evolving_WVP || (m_alphaModeMask & MaterialAlphaBit(mode)) == 0)
+    {
+        return;
+    }
+
+    context->IASetInputLayout(program->inputLayout.Get());
+    context->VSSetShader(program->vertexShader.Get(), nullptr, 0);
+
+    Matrix vpMatrix = viewMatrix * projectionMatrix;
+
+    for (size_t i = 0; i < m_meshParts.size(); ++i)
+    {
+        auto& meshPart = m_meshParts[i];
+        if (meshPart.indexCount == 0 || GetPartAlphaMode(i) != mode) continue;
+
+        // Mismo contenido que en EvolvingDraw para que la posicin sea idntica y la prueba EQUAL pase
+        D3D11_MAPPED_SUBRESOURCE mappedResourceVS;
+        HRESULT hr = context->Map(m_cbVS_Evolving_WVP.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResourceVS);
+        if (FAILED(hr)) continue;
+
+        CB_VS_Evolving_Data* vsDataPtr = (CB_VS_Evolving_Data*)mappedResourceVS.pData;
+        Matrix world = meshPart.localNodeTransform * m_worldMatrix;
+        vsDataPtr->World = world;
+        vsDataPtr->ViewProjection = vpMatrix;
+        vsDataPtr->LightViewProjection = Matrix::Identity;
+        vsDataPtr->WorldInverseTranspose = world.Invert().Transpose();
+        context->Unmap(m_cbVS_Evolving_WVP.Get(), 0);
+        context->VSSetConstantBuffers(0, 1, m_cbVS_Evolving_WVP.GetAddressOf());
+
+        if (mode == MaterialAlphaMode::Masked)
+        {
+            ID3D11ShaderResourceView* diffuseSRV = nullptr;
+            if (meshPart.materialIndex < m_materials.size())
+            {
+                diffuseSRV = m_materials[meshPart.materialIndex].diffuseTextureSRV.Get();
+            }
+            context->PSSetShaderResources(0, 1, &diffuseSRV);
+        }
+
+        meshPart.DrawPrim(context);
+    }
+}
+
 
 void Model::UpdateWorldMatrix()
+
 {
     Matrix scaleMatrix = Matrix::CreateScale(m_scale);
     Matrix rotationMatrix = Matrix::CreateFromQuaternion(m_rotation);
@@ -888,30 +1138,10 @@ void Model::DebugDraw(ID3D11DeviceContext* context,
     }
 }
 
-bool Model::LoadEvolvingShaders(ID3D11Device * device, const wchar_t* vsFilename, const wchar_t* psFilename)
+bool Model::LoadEvolvingShaders(ShaderRegistry& registry, const wchar_t* vsFilename, const wchar_t* psFilename)
 {
-    // --- 1. CARGAR Y CREAR EVOLVING VERTEX SHADER ---
-    Microsoft::WRL::ComPtr<ID3DBlob> vsBlob;
-    HRESULT hr = D3DReadFileToBlob(vsFilename, vsBlob.GetAddressOf());
-    if (FAILED(hr))
-    {
-        OutputDebugString(L"ERROR::MODEL::LOAD_EVOLVING_SHADERS::Failed to load Evolving Vertex Shader file: ");
-        OutputDebugString(vsFilename);
-        OutputDebugString(L"\n");
-        return false;
-    }
-
-    hr = device->CreateVertexShader(vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), nullptr, m_evolvingVertexShader.ReleaseAndGetAddressOf());
-    if (FAILED(hr))
-    {
-        OutputDebugString(L"ERROR::MODEL::LOAD_EVOLVING_SHADERS::Failed to create Evolving Vertex Shader.\n");
-        return false;
-    }
-
-    // --- 2. CREAR INPUT LAYOUT PARA EL EVOLVING VERTEX SHADER ---
-    // Este Input Layout debe describir la estructura de ModelVertex,
-    // ya que los buffers de tus MeshParts contienen ModelVertex, y
-    // VertexInputType_Evolving en EvolvingVS.hlsl (Paso 1) coincide con ModelVertex.
+    // El input layout describe ModelVertex, que coincide con VertexInputType_Evolving en EvolvingVS.hlsl.
+    // El registro lo reutiliza para todos los modelos con los mismos elementos.
     const D3D11_INPUT_ELEMENT_DESC modelVertexLayoutDesc[] =
     {
         { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
@@ -919,62 +1149,25 @@ bool Model::LoadEvolvingShaders(ID3D11Device * device, const wchar_t* vsFilename
         { "NORMAL",   0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 }
     };
 
-    hr = device->CreateInputLayout(
-        modelVertexLayoutDesc, ARRAYSIZE(modelVertexLayoutDesc),
-        vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), // Usar el bytecode del EvolvingVS
-        m_evolvingInputLayout.ReleaseAndGetAddressOf()
-    );
-    if (FAILED(hr))
+    // Los .cso se leen y se crean una sola vez; aqu solo se guarda el handle
+    m_evolvingProgram = registry.LoadProgram(vsFilename, psFilename, modelVertexLayoutDesc, ARRAYSIZE(modelVertexLayoutDesc));
+    if (m_evolvingProgram == INVALID_SHADER_PROGRAM)
     {
-        OutputDebugString(L"ERROR::MODEL::LOAD_EVOLVING_SHADERS::Failed to create Evolving Input Layout.\n");
+        OutputDebugString(L"ERROR::MODEL::LOAD_EVOLVING_SHADERS::Failed to load Evolving shader program.\n");
         return false;
     }
+    m_shaderRegistry = &registry;
 
-    // El blob del VS ya no es necesario despus de crear el shader y el layout
-    // vsBlob se liberar automticamente aqu por ComPtr
-
-    // --- 3. CARGAR Y CREAR EVOLVING PIXEL SHADER ---
-    Microsoft::WRL::ComPtr<ID3DBlob> psBlob;
-    hr = D3DReadFileToBlob(psFilename, psBlob.GetAddressOf());
-    if (FAILED(hr))
-    {
-        OutputDebugString(L"ERROR::MODEL::LOAD_EVOLVING_SHADERS::Failed to load Evolving Pixel Shader file: ");
-        OutputDebugString(psFilename);
-        OutputDebugString(L"\n");
-        return false;
-    }
-
-    hr = device->CreatePixelShader(psBlob->GetBufferPointer(), psBlob->GetBufferSize(), nullptr, m_evolvingPixelShader.ReleaseAndGetAddressOf());
-    if (FAILED(hr))
-    {
-        OutputDebugString(L"ERROR::MODEL::LOAD_EVOLVING_SHADERS::Failed to create Evolving Pixel Shader.\n");
-        return false;
-    }
-
-    D3D11_BUFFER_DESC cbd_ps_material = {};
-    cbd_ps_material.Usage = D3D11_USAGE_DYNAMIC;
-    cbd_ps_material.ByteWidth = sizeof(PSMaterialPropertiesData); // Tu struct de C++
-    cbd_ps_material.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-    cbd_ps_material.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-    HRESULT hr_mat_cb = device->CreateBuffer(&cbd_ps_material, nullptr, m_cbPS_MaterialProperties.ReleaseAndGetAddressOf());
-    if (FAILED(hr_mat_cb)) {
+    // Los constant buffers se sobrescriben con MAP_WRITE_DISCARD antes de cada draw,
+    // as que todos los modelos pueden compartir los mismos
+    m_cbPS_MaterialProperties = registry.GetConstantBuffer("Evolving.PSMaterialProperties", sizeof(PSMaterialPropertiesData));
+    if (!m_cbPS_MaterialProperties) {
         OutputDebugString(L"ERROR::MODEL::LOAD_EVOLVING_SHADERS::Failed to create PS Material Properties CB.\n");
         return false;
     }
 
-    D3D11_BUFFER_DESC cbd_vs_evolving = {};
-    cbd_vs_evolving.Usage = D3D11_USAGE_DYNAMIC;
-    // Asegrate que el tamao coincida con lo que espera tu EvolvingVS.hlsl en b0
-    // Si es la struct CB_VS_Evolving_Data (World y ViewProjection):
-    cbd_vs_evolving.ByteWidth = sizeof(CB_VS_Evolving_Data);
-    // Si solo era una matriz WorldViewProjection:
-    // cbd_vs_evolving.ByteWidth = sizeof(DirectX::SimpleMath::Matrix); 
-    cbd_vs_evolving.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-    cbd_vs_evolving.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-
-    // Usa el miembro m_cbVS_Evolving_WVP que deberas tener declarado en Model.h
-    HRESULT hr_vs_cb = device->CreateBuffer(&cbd_vs_evolving, nullptr, m_cbVS_Evolving_WVP.ReleaseAndGetAddressOf());
-    if (FAILED(hr_vs_cb)) {
+    m_cbVS_Evolving_WVP = registry.GetConstantBuffer("Evolving.VSPerObject", sizeof(CB_VS_Evolving_Data));
+    if (!m_cbVS_Evolving_WVP) {
         OutputDebugString(L"ERROR::MODEL::LOAD_EVOLVING_SHADERS::Failed to create Evolving VS PerObject CB.\n");
         return false;
     }
@@ -983,6 +1176,11 @@ bool Model::LoadEvolvingShaders(ID3D11Device * device, const wchar_t* vsFilename
     return true;
 }
 
+const ShaderProgram* Model::GetEvolvingProgram() const
+{
+    return m_shaderRegistry ? m_shaderRegistry->GetProgram(m_evolvingProgram) : nullptr;
+}
+
 const DirectX::BoundingSphere& Model::GetOverallLocalBoundingSphere() const { return m_overallLocalBoundingSphere; }
 DirectX::BoundingSphere Model::GetOverallWorldBoundingSphere() const {
     DirectX::BoundingSphere worldSphere;
@@ -1027,12 +1225,10 @@ bool Model::CheckCollisionAgainstParts(
 
         if (worldSpaceQueryBox.Intersects(worldMeshPartBox))
         {
-            // Opcional: Aadir un OutputDebugString aqu si quieres saber con qu parte especfica hubo colisin
-            // wchar_t msg[256];
-            // swprintf_s(msg, L"    Colisin de Narrow Phase con MeshPart (Centro AABB: %.2f, %.2f, %.2f)\n", 
-            //    worldMeshPartBox.Center.x, worldMeshPartBox.Center.y, worldMeshPartBox.Center.z);
-            // OutputDebugString(msg);
-            return true; // Se detect colisin con esta parte
+            // La caja de la parte solo descarta: la colisin la deciden los tringulos (BVH del modelo
+            // entero, as que no hace falta seguir con las dems partes). Sin malla de colisin, la caja.
+            if (m_collisionMesh.IsEmpty()) return true;
+            return m_collisionMesh.IntersectsBox(worldSpaceQueryBox.Center, worldSpaceQueryBox.Extents, instanceWorldMatrix);
         }
     }
     return false; // No se detect colisin con ninguna parte de esta instancia
@@ -1156,4 +1352,35 @@ void Model::ShadowDrawAlphaClip(
         }
         meshPart.DrawPrim(context);
     }
+}
+
+void Model::ShadowDrawBatch(
+    ID3D11DeviceContext* context,
+    const DirectX::SimpleMath::Matrix& worldMatrix,
+    const DirectX::SimpleMath::Matrix& lightViewMatrix,
+    const DirectX::SimpleMath::Matrix& lightProjectionMatrix,
+    ShadowCasterMode mode)
+{
+    if (!m_cbVS_Shadow || (m_shadowCasterMask & ShadowCasterBit(mode)) == 0) return;
+
+    D3D11_MAPPED_SUBRESOURCE mappedResource;
+    if (FAILED(context->Map(m_cbVS_Shadow.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource))) return;
+    CB_VS_Shadow_Data* dataPtr = (CB_VS_Shadow_Data*)mappedResource.pData;
+    dataPtr->World = worldMatrix;
+    dataPtr->LightViewProjection = lightViewMatrix * lightProjectionMatrix;
+    context->Unmap(m_cbVS_Shadow.Get(), 0);
+
+    context->VSSetConstantBuffers(0, 1, m_cbVS_Shadow.GetAddressOf());
+
+    for (size_t i = 0; i < m_meshParts.size(); ++i)
+    {
+        auto& meshPart = m_meshParts[i];
+        if (meshPart.indexCount == 0 || GetPartShadowMode(i) != mode) continue;
+
+        if (mode == ShadowCasterMode::AlphaTested)
+        {
+            context->PSSetShaderResources(0, 1, m_materials[meshPart.materialIndex].diffuseTextureSRV.GetAddressOf());
+        }
+        meshPart.DrawPrim(context);
+    }
 }
\ No newline at end of file
@@ -15,6 +15,11 @@
 #include <Effects.h>
 #include <DirectXCollision.h>
 #include <vector>
+#include "ShaderRegistry.h"
+#include "ShadowCasterBatches.h"
+#include "DepthPrepass.h"
+#include "CollisionMesh.h"
+#include "WorldPartBounds.h"
 
 
 // Estructura de vrtice para nuestros modelos.
@@ -64,7 +69,6 @@ struct CB_VS_Shadow_Data {
     DirectX::SimpleMath::Matrix LightViewProjection;
 };
 
-
 class Model
 {
 public:
@@ -95,9 +99,40 @@ public:
         const DirectX::SimpleMath::Matrix& lightViewMatrix,
         const DirectX::SimpleMath::Matrix& lightProjectionMatrix,
         ID3D11ShaderResourceView* shadowMapSRV,
-        ID3D11SamplerState* shadowSampler
+        ID3D11SamplerState* shadowSampler,
+        ID3D11PixelShader* pixelShaderOverride = nullptr // p.ej. EvolvingPS_NoClip tras la pre-pasada
+    );
+
+    // Pre-pasada de solo profundidad con EvolvingVS (misma posicin que EvolvingDraw), solo las partes
+    // con ese modo. El pixel shader y el sampler los pone quien recorre el ScenePassPlan: ninguno para
+    // las opacas, DepthPrepassPS_AlphaClip para las Masked (aqu solo se pone su textura difusa).
+    void DepthPrepassDraw(ID3D11DeviceContext* context,
+        const DirectX::SimpleMath::Matrix& viewMatrix,
+        const DirectX::SimpleMath::Matrix& projectionMatrix,
+        MaterialAlphaMode mode
     );
 
+    // Clasificacin del material al importarlo, con el alfa que se ley de sus texturas
+    // (ReadTextureAlphaMode; Opaque si no tiene mapa de opacidad). Sin textura difusa, Masked.
+    static MaterialAlphaMode ClassifyMaterialAlpha(bool hasDiffuseTexture, MaterialAlphaMode diffuseTexels,
+        float opacity, MaterialAlphaMode opacityTexels);
+    // Copia el mip 0 a una textura staging y recorre su alfa (en un mapa de opacidad, tambin el
+    // canal rojo). Un formato que no se sabe leer cuenta como Masked.
+    static MaterialAlphaMode ReadTextureAlphaMode(ID3D11Device* device, ID3D11DeviceContext* context,
+        ID3D11ShaderResourceView* textureSRV, bool opacityMap);
+    size_t GetMeshPartCount() const { return m_meshParts.size(); }
+    MaterialAlphaMode GetPartAlphaMode(size_t partIndex) const;
+
+    // Sombra del material al importarlo: sin textura difusa no hay nada que recortar y la parte
+    // proyecta sombra entera; un material invisible (opacidad ~0) no proyecta.
+    static ShadowCasterMode ClassifyShadowCaster(MaterialAlphaMode alphaMode, bool hasDiffuseTexture,
+        float opacity, bool hasOpacityTexture);
+    ShadowCasterMode GetPartShadowMode(size_t partIndex) const;
+    // Cajas de las partes con extensin (espacio del nodo + localNodeTransform), para WorldPartBounds.
+    void GetPartBoxes(std::vector<PartBox>& outBoxes) const;
+    uint8_t GetShadowCasterMask() const { return m_shadowCasterMask; } // ShadowCasterBit de los modos de sus partes
+    uint8_t GetAlphaModeMask() const { return m_alphaModeMask; }       // MaterialAlphaBit de los modos de sus partes
+
     // --- MTODOS PARA GESTIONAR TRANSFORMACIONES INDIVIDUALES ---
     void SetPosition(const DirectX::SimpleMath::Vector3& position);
     void SetPosition(float x, float y, float z);
@@ -125,7 +160,9 @@ public:
         const DirectX::SimpleMath::Matrix& viewMatrix,
         const DirectX::SimpleMath::Matrix& projectionMatrix);
 
-    bool LoadEvolvingShaders(ID3D11Device* device, const wchar_t* vsFilename, const wchar_t* psFilename);
+    // Pide el programa Evolving al registro compartido; el modelo solo guarda el handle.
+    bool LoadEvolvingShaders(ShaderRegistry& registry, const wchar_t* vsFilename, const wchar_t* psFilename);
+    const ShaderProgram* GetEvolvingProgram() const;
     void CalculateOverallBoundingSphere();
     bool CheckCollisionAgainstParts(
         const DirectX::BoundingBox& worldSpaceQueryBox,
@@ -133,6 +170,14 @@ public:
         std::vector<DirectX::BoundingBox>& boxesToDrawDebug,
         bool shouldAddDebugBox) const;
     const DirectX::BoundingSphere& GetOverallLocalBoundingSphere() const;
+    const DirectX::BoundingBox& GetLocalBoundingBox() const { return m_localBoundingBox; }
+
+    // Copia en CPU de la geometra en espacio del modelo (ya con localNodeTransform),
+    // para el culling por oclusin y consultas en CPU.
+    const std::vector<DirectX::SimpleMath::Vector3>& GetModelSpacePositions() const { return m_modelSpacePositions; }
+    const std::vector<uint32_t>& GetModelSpaceIndices() const { return m_modelSpaceIndices; }
+    // Tringulos de m_modelSpaceIndices con su BVH; consultas de caja, cpsula y rayo por instancia.
+    const CollisionMesh& GetCollisionMesh() const { return m_collisionMesh; }
     DirectX::BoundingSphere GetOverallWorldBoundingSphere() const;
 
     void ShadowDraw(
@@ -149,6 +194,16 @@ public:
         const DirectX::SimpleMath::Matrix& lightProjectionMatrix,
         ID3D11SamplerState* sampler
     );
+
+    // Solo las partes con ese modo de sombra. Shaders, input layout y sampler los pone quien
+    // recorre el lote (ShadowCasterBatches); aqui solo el constant buffer y, en AlphaTested, la textura.
+    void ShadowDrawBatch(
+        ID3D11DeviceContext* context,
+        const DirectX::SimpleMath::Matrix& worldMatrix,
+        const DirectX::SimpleMath::Matrix& lightViewMatrix,
+        const DirectX::SimpleMath::Matrix& lightProjectionMatrix,
+        ShadowCasterMode mode
+    );
 private:
     // Estructura para representar una parte de la malla (sub-malla) de un modelo
     struct MeshPart
@@ -174,8 +229,11 @@ private:
         DirectX::SimpleMath::Vector4 specularColor = DirectX::SimpleMath::Vector4(0.2f, 0.2f, 0.2f, 1.0f);
         float specularPower = 32.0f;
         DirectX::SimpleMath::Vector4 emissiveColor = DirectX::SimpleMath::Vector4(0, 0, 0, 1);
+        MaterialAlphaMode alphaMode = MaterialAlphaMode::Opaque;
+        ShadowCasterMode shadowMode = ShadowCasterMode::Opaque;
     };
 
+
     // Funciones de ayuda para procesar la escena de Assimp (sern privadas)
     void ProcessNode(ID3D11Device* device, ID3D11DeviceContext* context, aiNode* node, const aiScene* scene, const DirectX::SimpleMath::Matrix& parentTransform);
     void ProcessMesh(ID3D11Device* device, ID3D11DeviceContext* context, aiMesh* mesh, const aiScene* scene, const DirectX::SimpleMath::Matrix& transform);
@@ -185,6 +243,8 @@ private:
 
     std::vector<MeshPart> m_meshParts;   // Todas las mallas que componen este modelo
     std::vector<Material> m_materials; // Todos los materiales usados por este modelo
+    uint8_t m_shadowCasterMask = 0;    // Modos de sombra presentes en m_meshParts
+    uint8_t m_alphaModeMask = 0;       // Modos de alfa presentes en m_meshParts
     std::string m_modelDirectory;      // Directorio base del archivo del modelo, para resolver rutas relativas de texturas
 
     // Para renderizado simple inicial, usaremos un BasicEffect para todas las mallas.
@@ -210,14 +270,21 @@ private:
     Microsoft::WRL::ComPtr<ID3D11InputLayout>  m_debugInputLayout;
     Microsoft::WRL::ComPtr<ID3D11Buffer>       m_cbVS_Debug_WVP;
 
-    Microsoft::WRL::ComPtr<ID3D11VertexShader> m_evolvingVertexShader;
-    Microsoft::WRL::ComPtr<ID3D11PixelShader>  m_evolvingPixelShader;
-    Microsoft::WRL::ComPtr<ID3D11InputLayout>  m_evolvingInputLayout;
+    // Programa Evolving compartido (VS, PS e input layout viven en el ShaderRegistry)
+    ShaderRegistry*     m_shaderRegistry;
+    ShaderProgramHandle m_evolvingProgram;
+
+    Microsoft::WRL::ComPtr<ID3D11Buffer> m_cbVS_Evolving_WVP; // Compartido entre modelos
 
-    Microsoft::WRL::ComPtr<ID3D11Buffer> m_cbVS_Evolving_WVP;
 
     DirectX::BoundingSphere m_localBoundingSphere;
     DirectX::BoundingSphere m_overallLocalBoundingSphere;
+    DirectX::BoundingBox m_localBoundingBox;
+
+    std::vector<DirectX::SimpleMath::Vector3> m_modelSpacePositions;
+    std::vector<uint32_t> m_modelSpaceIndices;
+    CollisionMesh m_collisionMesh;
+
 
     Microsoft::WRL::ComPtr<ID3D11Buffer> m_cbVS_Shadow;
 
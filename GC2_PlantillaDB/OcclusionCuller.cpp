@@ -0,0 +1,388 @@
+#include "OcclusionCuller.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <utility>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define OCCLUSION_USE_SSE2 1
+#endif
+
+using DirectX::XMFLOAT3;
+using DirectX::XMFLOAT4;
+using DirectX::XMFLOAT4X4;
+
+namespace
+{
+    // Producto fila * matriz como en SimpleMath (vectores fila, v * M).
+    XMFLOAT4X4 MultiplyRowMajor(const XMFLOAT4X4& a, const XMFLOAT4X4& b)
+    {
+        XMFLOAT4X4 r;
+        for (int i = 0; i < 4; ++i)
+        {
+            for (int j = 0; j < 4; ++j)
+            {
+                r.m[i][j] = a.m[i][0] * b.m[0][j] + a.m[i][1] * b.m[1][j] +
+                    a.m[i][2] * b.m[2][j] + a.m[i][3] * b.m[3][j];
+            }
+        }
+        return r;
+    }
+
+    inline XMFLOAT4 TransformPoint(const XMFLOAT3& p, const XMFLOAT4X4& m)
+    {
+        return XMFLOAT4(
+            p.x * m._11 + p.y * m._21 + p.z * m._31 + m._41,
+            p.x * m._12 + p.y * m._22 + p.z * m._32 + m._42,
+            p.x * m._13 + p.y * m._23 + p.z * m._33 + m._43,
+            p.x * m._14 + p.y * m._24 + p.z * m._34 + m._44);
+    }
+
+    // Un vertice con w o z negativos esta detras del plano cercano.
+    inline bool BehindNearPlane(const XMFLOAT4& c)
+    {
+        return c.w <= 1e-5f || c.z < 0.0f;
+    }
+
+    // Pixeles (x hacia la derecha, y hacia abajo) y z/w. La referencia de OcclusionCullerTest
+    // repite esta misma cuenta para que los vertices en pantalla sean identicos.
+    inline void ToScreen(const XMFLOAT4& clip, float halfWidth, float halfHeight, float& x, float& y, float& depth)
+    {
+        const float invW = 1.0f / clip.w;
+        x = (clip.x * invW + 1.0f) * halfWidth;
+        y = (1.0f - clip.y * invW) * halfHeight;
+        depth = clip.z * invW;
+    }
+
+    // Bits de las columnas [first, last] (0..7) de una fila de subtesela
+    inline uint32_t RowBits(int first, int last)
+    {
+        return (0xFFu >> (7 - (last - first))) << first;
+    }
+
+    double MillisecondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+OcclusionCuller::OcclusionCuller(int width, int height) :
+    m_threadPool(nullptr)
+{
+    // Subteselas completas: ancho multiplo de 8 y alto multiplo de 4
+    m_width = std::max(SUBTILE_WIDTH, (width + SUBTILE_WIDTH - 1) / SUBTILE_WIDTH * SUBTILE_WIDTH);
+    m_height = std::max(SUBTILE_HEIGHT, (height + SUBTILE_HEIGHT - 1) / SUBTILE_HEIGHT * SUBTILE_HEIGHT);
+    m_subtilesX = m_width / SUBTILE_WIDTH;
+    m_subtilesY = m_height / SUBTILE_HEIGHT;
+
+    const size_t subtileCount = static_cast<size_t>(m_subtilesX) * m_subtilesY;
+    m_coverageMask.assign(subtileCount, 0u);
+    m_maskDepth.assign(subtileCount, 0.0f);
+    m_farDepth.assign(subtileCount, 1.0f);
+
+    for (int i = 0; i < 4; ++i)
+        for (int j = 0; j < 4; ++j)
+            m_viewProjection.m[i][j] = (i == j) ? 1.0f : 0.0f;
+}
+
+void OcclusionCuller::BeginFrame(const XMFLOAT4X4& viewProjection)
+{
+    m_viewProjection = viewProjection;
+    m_triangles.clear();
+    std::fill(m_coverageMask.begin(), m_coverageMask.end(), 0u);
+    std::fill(m_maskDepth.begin(), m_maskDepth.end(), 0.0f);
+    std::fill(m_farDepth.begin(), m_farDepth.end(), 1.0f);
+    m_stats = OcclusionStats();
+}
+
+void OcclusionCuller::AddOccluder(const XMFLOAT3* positions, size_t vertexCount,
+    const uint32_t* indices, size_t indexCount,
+    const XMFLOAT4X4& world)
+{
+    if (!positions || !indices || vertexCount == 0 || indexCount < 3) return;
+
+    const XMFLOAT4X4 worldViewProj = MultiplyRowMajor(world, m_viewProjection);
+
+    // Cada vertice se transforma una sola vez aunque lo compartan varios triangulos
+    m_clipScratch.resize(vertexCount);
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        m_clipScratch[i] = TransformPoint(positions[i], worldViewProj);
+    }
+
+    const float halfW = 0.5f * static_cast<float>(m_width);
+    const float halfH = 0.5f * static_cast<float>(m_height);
+
+    for (size_t t = 0; t + 2 < indexCount; t += 3)
+    {
+        ++m_stats.occluderTriangles;
+
+        const uint32_t i0 = indices[t], i1 = indices[t + 1], i2 = indices[t + 2];
+        if (i0 >= vertexCount || i1 >= vertexCount || i2 >= vertexCount) continue;
+
+        const XMFLOAT4* clip[3] = { &m_clipScratch[i0], &m_clipScratch[i1], &m_clipScratch[i2] };
+
+        // Sin recorte contra el plano cercano: descartar el triangulo sigue siendo conservador
+        if (BehindNearPlane(*clip[0]) || BehindNearPlane(*clip[1]) || BehindNearPlane(*clip[2])) continue;
+
+        ScreenTriangle tri;
+        float z[3];
+        for (int v = 0; v < 3; ++v) ToScreen(*clip[v], halfW, halfH, tri.x[v], tri.y[v], z[v]);
+        tri.depth = std::max(z[0], std::max(z[1], z[2]));
+        if (tri.depth >= 1.0f) continue; // Toca el plano lejano, no tapa nada
+
+        // Orientacion antihoraria en pantalla; no hay backface culling
+        float area = (tri.x[1] - tri.x[0]) * (tri.y[2] - tri.y[0]) - (tri.y[1] - tri.y[0]) * (tri.x[2] - tri.x[0]);
+        if (std::fabs(area) < 1e-6f) continue;
+        if (area < 0.0f)
+        {
+            std::swap(tri.x[1], tri.x[2]);
+            std::swap(tri.y[1], tri.y[2]);
+            std::swap(z[1], z[2]);
+        }
+
+        // z/w es lineal en pantalla. El gradiente en double: en triangulos muy finos es grande y
+        // la cota de cada subtesela sale de el.
+        const double dx1 = double(tri.x[1]) - tri.x[0], dy1 = double(tri.y[1]) - tri.y[0];
+        const double dx2 = double(tri.x[2]) - tri.x[0], dy2 = double(tri.y[2]) - tri.y[0];
+        const double dz1 = double(z[1]) - z[0], dz2 = double(z[2]) - z[0];
+        const double determinant = dx1 * dy2 - dx2 * dy1;
+        tri.planeDepth = z[0];
+        tri.planeDx = static_cast<float>((dz1 * dy2 - dz2 * dy1) / determinant);
+        tri.planeDy = static_cast<float>((dz2 * dx1 - dz1 * dx2) / determinant);
+        tri.planeBias = 1e-6f * (1.0f + std::fabs(tri.planeDx) * m_width + std::fabs(tri.planeDy) * m_height);
+
+        // Pixeles cuyo centro puede caer dentro del triangulo
+        const float minXf = std::min(tri.x[0], std::min(tri.x[1], tri.x[2]));
+        const float maxXf = std::max(tri.x[0], std::max(tri.x[1], tri.x[2]));
+        const float minYf = std::min(tri.y[0], std::min(tri.y[1], tri.y[2]));
+        const float maxYf = std::max(tri.y[0], std::max(tri.y[1], tri.y[2]));
+
+        tri.minX = std::max(0, static_cast<int>(std::ceil(minXf - 0.5f)));
+        tri.maxX = std::min(m_width - 1, static_cast<int>(std::floor(maxXf - 0.5f)));
+        tri.minY = std::max(0, static_cast<int>(std::ceil(minYf - 0.5f)));
+        tri.maxY = std::min(m_height - 1, static_cast<int>(std::floor(maxYf - 0.5f)));
+        if (tri.minX > tri.maxX || tri.minY > tri.maxY) continue;
+
+        m_triangles.push_back(tri);
+    }
+}
+
+void OcclusionCuller::RasterizeOccluders()
+{
+    auto start = std::chrono::steady_clock::now();
+
+    // Una franja por fila de subteselas: cada hilo escribe en subteselas distintas
+    if (m_threadPool && m_subtilesY > 1)
+    {
+        m_threadPool->ParallelFor(m_subtilesY, [this](int band) { RasterizeBand(band); });
+    }
+    else
+    {
+        for (int band = 0; band < m_subtilesY; ++band) RasterizeBand(band);
+    }
+
+    m_stats.rasterizedTriangles = static_cast<int>(m_triangles.size());
+    m_stats.rasterizeMs = MillisecondsSince(start);
+}
+
+void OcclusionCuller::RasterizeBand(int band)
+{
+    const int bandMinY = band * SUBTILE_HEIGHT;
+    const int bandMaxY = bandMinY + SUBTILE_HEIGHT - 1;
+
+    for (const ScreenTriangle& tri : m_triangles)
+    {
+        if (tri.maxY < bandMinY || tri.minY > bandMaxY) continue;
+
+        // Funciones de arista E(p) = A*px + B*py + C, positivas dentro del triangulo
+        float edgeA[3], edgeB[3], edgeC[3];
+        for (int e = 0; e < 3; ++e)
+        {
+            const int n = (e + 1) % 3;
+            edgeA[e] = -(tri.y[n] - tri.y[e]);
+            edgeB[e] = tri.x[n] - tri.x[e];
+            edgeC[e] = -(edgeA[e] * tri.x[e] + edgeB[e] * tri.y[e]);
+        }
+
+        const int y0 = std::max(tri.minY, bandMinY);
+        const int y1 = std::min(tri.maxY, bandMaxY);
+        const int firstSubtile = tri.minX / SUBTILE_WIDTH;
+        const int lastSubtile = tri.maxX / SUBTILE_WIDTH;
+
+        // Maximo del plano en los centros de pixel de una subtesela: en el centro de la subtesela
+        // mas la mitad del recorrido (3.5 y 1.5 pixeles) en cada eje
+        const float depthSpan = std::fabs(tri.planeDx) * 3.5f + std::fabs(tri.planeDy) * 1.5f + tri.planeBias;
+        const float subtileCenterY = static_cast<float>(bandMinY) + 0.5f * SUBTILE_HEIGHT;
+
+#ifdef OCCLUSION_USE_SSE2
+        const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+        const __m128 a0 = _mm_set1_ps(edgeA[0]), a1 = _mm_set1_ps(edgeA[1]), a2 = _mm_set1_ps(edgeA[2]);
+        const __m128 zero = _mm_setzero_ps();
+#endif
+
+        for (int subtile = firstSubtile; subtile <= lastSubtile; ++subtile)
+        {
+            const int x0 = subtile * SUBTILE_WIDTH;
+
+            // Mascara de los centros de pixel cubiertos, fila a fila
+            uint32_t coverage = 0;
+            for (int y = y0; y <= y1; ++y)
+            {
+                const float py = static_cast<float>(y) + 0.5f;
+                const int shift = (y - bandMinY) * SUBTILE_WIDTH;
+#ifdef OCCLUSION_USE_SSE2
+                const __m128 rowC0 = _mm_set1_ps(edgeB[0] * py + edgeC[0]);
+                const __m128 rowC1 = _mm_set1_ps(edgeB[1] * py + edgeC[1]);
+                const __m128 rowC2 = _mm_set1_ps(edgeB[2] * py + edgeC[2]);
+                for (int half = 0; half < 2; ++half)
+                {
+                    const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x0 + 4 * half)), laneOffsets);
+                    const __m128 e0 = _mm_add_ps(_mm_mul_ps(a0, px), rowC0);
+                    const __m128 e1 = _mm_add_ps(_mm_mul_ps(a1, px), rowC1);
+                    const __m128 e2 = _mm_add_ps(_mm_mul_ps(a2, px), rowC2);
+                    const __m128 inside = _mm_and_ps(_mm_cmpge_ps(e0, zero),
+                        _mm_and_ps(_mm_cmpge_ps(e1, zero), _mm_cmpge_ps(e2, zero)));
+                    coverage |= static_cast<uint32_t>(_mm_movemask_ps(inside)) << (shift + 4 * half);
+                }
+#else
+                for (int i = 0; i < SUBTILE_WIDTH; ++i)
+                {
+                    const float px = static_cast<float>(x0 + i) + 0.5f;
+                    if (edgeA[0] * px + (edgeB[0] * py + edgeC[0]) >= 0.0f &&
+                        edgeA[1] * px + (edgeB[1] * py + edgeC[1]) >= 0.0f &&
+                        edgeA[2] * px + (edgeB[2] * py + edgeC[2]) >= 0.0f)
+                    {
+                        coverage |= 1u << (shift + i);
+                    }
+                }
+#endif
+            }
+            if (coverage == 0) continue;
+
+            const float subtileCenterX = static_cast<float>(x0) + 0.5f * SUBTILE_WIDTH;
+            const float planeMax = tri.planeDepth + tri.planeDx * (subtileCenterX - tri.x[0]) +
+                tri.planeDy * (subtileCenterY - tri.y[0]) + depthSpan;
+            UpdateSubtile(static_cast<size_t>(band) * m_subtilesX + subtile, coverage, std::min(planeMax, tri.depth));
+        }
+    }
+}
+
+void OcclusionCuller::UpdateSubtile(size_t index, uint32_t coverage, float depth)
+{
+    float& farDepth = m_farDepth[index];
+    float& maskDepth = m_maskDepth[index];
+    uint32_t& mask = m_coverageMask[index];
+
+    // Detras de la capa de referencia: no tapa nada que no estuviera ya tapado
+    if (depth >= farDepth) return;
+
+    // El triangulo esta mas lejos de la capa de trabajo que esta de la de referencia: se
+    // descarta la capa de trabajo (sus pixeles vuelven a la de referencia, que es mas lejana)
+    // y el triangulo empieza una nueva. Si no, se funde con ella.
+    if (mask != 0 && maskDepth - depth > farDepth - maskDepth)
+    {
+        mask = coverage;
+        maskDepth = depth;
+    }
+    else
+    {
+        mask |= coverage;
+        maskDepth = std::max(maskDepth, depth);
+    }
+
+    // Subtesela cubierta entera: la capa de trabajo pasa a ser la de referencia
+    if (mask == 0xFFFFFFFFu)
+    {
+        farDepth = maskDepth;
+        maskDepth = 0.0f;
+        mask = 0;
+    }
+}
+
+float OcclusionCuller::GetDepth(int x, int y) const
+{
+    const size_t index = static_cast<size_t>(y / SUBTILE_HEIGHT) * m_subtilesX + x / SUBTILE_WIDTH;
+    const uint32_t bit = 1u << ((y % SUBTILE_HEIGHT) * SUBTILE_WIDTH + x % SUBTILE_WIDTH);
+    return (m_coverageMask[index] & bit) ? m_maskDepth[index] : m_farDepth[index];
+}
+
+bool OcclusionCuller::IsVisible(const XMFLOAT3& boxMin, const XMFLOAT3& boxMax)
+{
+    auto start = std::chrono::steady_clock::now();
+    ++m_stats.testedBoxes;
+
+    auto finish = [&](bool visible)
+    {
+        if (!visible) ++m_stats.culledBoxes;
+        m_stats.testMs += MillisecondsSince(start);
+        return visible;
+    };
+
+    const float halfW = 0.5f * static_cast<float>(m_width);
+    const float halfH = 0.5f * static_cast<float>(m_height);
+    float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+    float minDepth = FLT_MAX;
+
+    for (int c = 0; c < 8; ++c)
+    {
+        const XMFLOAT3 corner(
+            (c & 1) ? boxMax.x : boxMin.x,
+            (c & 2) ? boxMax.y : boxMin.y,
+            (c & 4) ? boxMax.z : boxMin.z);
+        const XMFLOAT4 clip = TransformPoint(corner, m_viewProjection);
+
+        // La caja cruza el plano cercano: la camara esta practicamente dentro
+        if (BehindNearPlane(clip)) return finish(true);
+
+        float sx, sy, depth;
+        ToScreen(clip, halfW, halfH, sx, sy, depth);
+        minX = std::min(minX, sx); maxX = std::max(maxX, sx);
+        minY = std::min(minY, sy); maxY = std::max(maxY, sy);
+        minDepth = std::min(minDepth, depth);
+    }
+
+    // Fuera de la pantalla o mas alla del plano lejano
+    if (maxX < 0.0f || maxY < 0.0f || minX >= m_width || minY >= m_height || minDepth > 1.0f)
+    {
+        return finish(false);
+    }
+
+    // Todos los pixeles que toca el rectangulo de la caja (no solo los centros)
+    const int px0 = std::max(0, static_cast<int>(std::floor(minX)));
+    const int py0 = std::max(0, static_cast<int>(std::floor(minY)));
+    const int px1 = std::min(m_width - 1, static_cast<int>(std::floor(maxX)));
+    const int py1 = std::min(m_height - 1, static_cast<int>(std::floor(maxY)));
+
+    for (int sy = py0 / SUBTILE_HEIGHT; sy <= py1 / SUBTILE_HEIGHT; ++sy)
+    {
+        for (int sx = px0 / SUBTILE_WIDTH; sx <= px1 / SUBTILE_WIDTH; ++sx)
+        {
+            const size_t index = static_cast<size_t>(sy) * m_subtilesX + sx;
+
+            // Las dos capas estan mas cerca que la caja: nada que mirar aqui
+            if (minDepth > m_farDepth[index]) continue;
+
+            // Pixeles del rectangulo dentro de la subtesela
+            const int originX = sx * SUBTILE_WIDTH;
+            const int originY = sy * SUBTILE_HEIGHT;
+            const uint32_t row = RowBits(std::max(px0, originX) - originX, std::min(px1, originX + SUBTILE_WIDTH - 1) - originX);
+            uint32_t rectangle = 0;
+            for (int y = std::max(py0, originY); y <= std::min(py1, originY + SUBTILE_HEIGHT - 1); ++y)
+            {
+                rectangle |= row << ((y - originY) * SUBTILE_WIDTH);
+            }
+
+            // Algun pixel solo tiene la capa de referencia, y esa no tapa la caja
+            const uint32_t mask = m_coverageMask[index];
+            if ((rectangle & ~mask) != 0) return finish(true);
+            if (minDepth <= m_maskDepth[index]) return finish(true);
+        }
+    }
+
+    return finish(false);
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+// Estadisticas del ultimo frame del culler (para la UI y para medir).
+struct OcclusionStats
+{
+    int occluderTriangles = 0;   // Triangulos enviados como oclusores
+    int rasterizedTriangles = 0; // Los que sobrevivieron al recorte y se dibujaron
+    int testedBoxes = 0;
+    int culledBoxes = 0;
+    double rasterizeMs = 0.0;
+    double testMs = 0.0;
+};
+
+// Culling por oclusion en CPU.
+// Se rasteriza un buffer de profundidad de baja resolucion con unos pocos oclusores
+// (malla gruesa del terreno, casas) y despues se prueban las AABB de las instancias
+// contra el. La profundidad es z/w de D3D (0 = cerca, 1 = lejos).
+//
+// El buffer no guarda una profundidad por pixel: como en el masked occlusion culling, cada
+// subtesela de 8x4 pixeles tiene una mascara de cobertura de 32 bits y dos capas, la de
+// referencia (toda la subtesela) y la de trabajo (los pixeles de la mascara). Un triangulo se
+// funde en la capa de trabajo, o la sustituye si esta mucho mas cerca que ella; cuando la
+// mascara se llena, la capa de trabajo pasa a ser la de referencia. La cobertura se calcula en
+// los centros de los pixeles con funciones de arista, 4 pixeles por instruccion SSE2.
+//
+// Es conservador: cada triangulo oclusor escribe en cada subtesela una cota superior de su
+// profundidad (su plano en las esquinas, como mucho su vertice mas lejano) y los triangulos
+// que cruzan el plano cercano se descartan, asi que una caja solo se marca oculta si de verdad
+// queda detras de un oclusor.
+class OcclusionCuller
+{
+public:
+    OcclusionCuller(int width = 256, int height = 128);
+
+    // Opcional: reparte la rasterizacion por franjas entre los hilos del pool.
+    void SetThreadPool(ThreadPool* pool) { m_threadPool = pool; }
+
+    // Limpia el buffer y la lista de oclusores para la camara de este frame.
+    void BeginFrame(const DirectX::XMFLOAT4X4& viewProjection);
+
+    // Malla oclusora en su espacio local; 'world' la lleva al mundo.
+    void AddOccluder(const DirectX::XMFLOAT3* positions, size_t vertexCount,
+        const uint32_t* indices, size_t indexCount,
+        const DirectX::XMFLOAT4X4& world);
+
+    // Rasteriza todos los oclusores recibidos en las mascaras de las subteselas.
+    void RasterizeOccluders();
+
+    // true si alguna parte de la AABB (en mundo) puede verse.
+    bool IsVisible(const DirectX::XMFLOAT3& boxMin, const DirectX::XMFLOAT3& boxMax);
+
+    // Profundidad oclusora de un pixel (la de su capa); 1 si nada lo tapa.
+    float GetDepth(int x, int y) const;
+
+    const OcclusionStats& GetStats() const { return m_stats; }
+    int GetWidth() const { return m_width; }
+    int GetHeight() const { return m_height; }
+
+    static constexpr int SUBTILE_WIDTH = 8;
+    static constexpr int SUBTILE_HEIGHT = 4;
+
+private:
+    struct ScreenTriangle
+    {
+        float x[3];
+        float y[3];
+        float depth;      // Profundidad conservadora (la mayor de los tres vertices)
+        float planeDepth; // Plano de profundidad: planeDepth + planeDx * (x - x[0]) + planeDy * (y - y[0])
+        float planeDx;
+        float planeDy;
+        float planeBias;  // Margen del redondeo al evaluar el plano en float
+        int minX, maxX;   // Rectangulo de pixeles que cubre (inclusivo)
+        int minY, maxY;
+    };
+
+    void RasterizeBand(int band);
+    void UpdateSubtile(size_t index, uint32_t coverage, float depth);
+
+    int m_width;
+    int m_height;
+    int m_subtilesX;
+    int m_subtilesY;
+
+    // Una entrada por subtesela de 8x4; bit (y * 8 + x) de la mascara = pixel (x, y) de la subtesela
+    std::vector<uint32_t> m_coverageMask; // Pixeles de la capa de trabajo
+    std::vector<float> m_maskDepth;       // Profundidad de la capa de trabajo (<= m_farDepth)
+    std::vector<float> m_farDepth;        // Profundidad de la capa de referencia (toda la subtesela)
+
+    std::vector<ScreenTriangle> m_triangles;
+    std::vector<DirectX::XMFLOAT4> m_clipScratch;
+
+    DirectX::XMFLOAT4X4 m_viewProjection;
+    ThreadPool* m_threadPool;
+    OcclusionStats m_stats;
+};
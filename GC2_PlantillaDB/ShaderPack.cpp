@@ -0,0 +1,222 @@
+#include "ShaderPack.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+namespace
+{
+    const uint64_t FNV_OFFSET = 14695981039346656037ull;
+    const uint64_t FNV_PRIME = 1099511628211ull;
+
+    uint64_t HashLowercaseChar(uint64_t hash, uint32_t c)
+    {
+        if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+        hash ^= static_cast<uint8_t>(c);
+        hash *= FNV_PRIME;
+        return hash;
+    }
+
+    void AppendUint32(std::vector<uint8_t>& out, uint32_t value)
+    {
+        for (int i = 0; i < 4; ++i) out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+
+    void AppendUint64(std::vector<uint8_t>& out, uint64_t value)
+    {
+        for (int i = 0; i < 8; ++i) out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+
+    bool ReadWholeFile(const std::filesystem::path& path, std::vector<uint8_t>& outData)
+    {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file) return false;
+
+        std::streamoff fileSize = file.tellg();
+        if (fileSize < 0) return false;
+
+        outData.resize(static_cast<size_t>(fileSize));
+        file.seekg(0, std::ios::beg);
+        return fileSize == 0 || static_cast<bool>(file.read(reinterpret_cast<char*>(outData.data()), fileSize));
+    }
+}
+
+ShaderPack::ShaderPack() :
+    m_entryCount(0)
+{
+}
+
+uint64_t ShaderPack::HashName(const std::string& name)
+{
+    uint64_t hash = FNV_OFFSET;
+    for (char c : name) hash = HashLowercaseChar(hash, static_cast<unsigned char>(c));
+    return hash;
+}
+
+uint64_t ShaderPack::HashName(const std::wstring& name)
+{
+    // Los nombres de shader son ASCII; el hash coincide con la version de std::string
+    uint64_t hash = FNV_OFFSET;
+    for (wchar_t c : name) hash = HashLowercaseChar(hash, static_cast<uint32_t>(c));
+    return hash;
+}
+
+bool ShaderPack::Build(const std::vector<SourceBlob>& blobs, std::vector<uint8_t>& outData, std::string* outError)
+{
+    outData.clear();
+
+    std::vector<std::pair<uint64_t, const SourceBlob*>> sorted;
+    sorted.reserve(blobs.size());
+    for (const SourceBlob& blob : blobs) sorted.emplace_back(HashName(blob.name), &blob);
+    std::sort(sorted.begin(), sorted.end(),
+        [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    // La busqueda es solo por hash: dos nombres con el mismo no pueden convivir
+    for (size_t i = 1; i < sorted.size(); ++i)
+    {
+        if (sorted[i].first == sorted[i - 1].first)
+        {
+            if (outError) *outError = "Hash repetido entre " + sorted[i - 1].second->name + " y " + sorted[i].second->name;
+            return false;
+        }
+    }
+
+    uint64_t offset = sizeof(Header) + static_cast<uint64_t>(sorted.size()) * sizeof(Entry);
+    uint64_t totalSize = offset;
+    for (const auto& item : sorted) totalSize += item.second->data.size();
+    if (sorted.size() > std::numeric_limits<uint32_t>::max() || totalSize > std::numeric_limits<uint32_t>::max())
+    {
+        if (outError) *outError = "El paquete no cabe en offsets de 32 bits";
+        return false;
+    }
+
+    outData.reserve(static_cast<size_t>(totalSize));
+    AppendUint32(outData, MAGIC);
+    AppendUint32(outData, VERSION);
+    AppendUint32(outData, static_cast<uint32_t>(sorted.size()));
+    AppendUint32(outData, 0);
+    for (const auto& item : sorted)
+    {
+        AppendUint64(outData, item.first);
+        AppendUint32(outData, static_cast<uint32_t>(offset));
+        AppendUint32(outData, static_cast<uint32_t>(item.second->data.size()));
+        offset += item.second->data.size();
+    }
+    for (const auto& item : sorted)
+    {
+        outData.insert(outData.end(), item.second->data.begin(), item.second->data.end());
+    }
+    return true;
+}
+
+bool ShaderPack::WriteToFile(const std::vector<SourceBlob>& blobs, const std::filesystem::path& path, std::string* outError)
+{
+    std::vector<uint8_t> data;
+    if (!Build(blobs, data, outError)) return false;
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file || !file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size())))
+    {
+        if (outError) *outError = "No se pudo escribir " + path.string();
+        return false;
+    }
+    return true;
+}
+
+bool ShaderPack::CollectDirectory(const std::filesystem::path& directory, std::vector<SourceBlob>& outBlobs)
+{
+    outBlobs.clear();
+
+    std::error_code error;
+    for (const auto& item : std::filesystem::directory_iterator(directory, error))
+    {
+        if (!item.is_regular_file() || item.path().extension() != ".cso") continue;
+
+        SourceBlob blob;
+        blob.name = item.path().stem().string();
+        if (!ReadWholeFile(item.path(), blob.data)) return false;
+        outBlobs.push_back(std::move(blob));
+    }
+    return !error;
+}
+
+bool ShaderPack::LoadFromFile(const std::filesystem::path& path)
+{
+    // Sin archivo queda vacio, igual que con un paquete corrupto
+    std::vector<uint8_t> data;
+    if (!ReadWholeFile(path, data)) data.clear();
+
+    return LoadFromMemory(std::move(data));
+}
+
+bool ShaderPack::LoadFromMemory(std::vector<uint8_t> data)
+{
+    m_data.clear();
+    m_entryCount = 0;
+
+    if (data.size() < sizeof(Header)) return false;
+
+    Header header;
+    memcpy(&header, data.data(), sizeof(Header));
+    if (header.magic != MAGIC || header.version != VERSION) return false;
+
+    // Antes de multiplicar: con size_t de 32 bits un entryCount enorme daria la vuelta
+    if (header.entryCount > (data.size() - sizeof(Header)) / sizeof(Entry)) return false;
+    size_t tableEnd = sizeof(Header) + static_cast<size_t>(header.entryCount) * sizeof(Entry);
+
+    // Validar que la tabla esta ordenada y que cada blob cae dentro del archivo
+    const uint8_t* table = data.data() + sizeof(Header);
+    for (uint32_t i = 0; i < header.entryCount; ++i)
+    {
+        Entry entry;
+        memcpy(&entry, table + i * sizeof(Entry), sizeof(Entry));
+        if (entry.offset < tableEnd || static_cast<uint64_t>(entry.offset) + entry.size > data.size()) return false;
+
+        if (i > 0)
+        {
+            Entry previous;
+            memcpy(&previous, table + (i - 1) * sizeof(Entry), sizeof(Entry));
+            if (previous.nameHash >= entry.nameHash) return false; // Desordenada o hash repetido
+        }
+    }
+
+    m_data = std::move(data);
+    m_entryCount = header.entryCount;
+    return true;
+}
+
+bool ShaderPack::FindByHash(uint64_t hash, const void*& outData, size_t& outSize) const
+{
+    const uint8_t* table = m_data.data() + sizeof(Header);
+
+    // Busqueda binaria sobre la tabla ordenada
+    size_t low = 0;
+    size_t high = m_entryCount;
+    while (low < high)
+    {
+        size_t mid = low + (high - low) / 2;
+        Entry entry;
+        memcpy(&entry, table + mid * sizeof(Entry), sizeof(Entry));
+
+        if (entry.nameHash == hash)
+        {
+            outData = m_data.data() + entry.offset;
+            outSize = entry.size;
+            return true;
+        }
+        if (entry.nameHash < hash) low = mid + 1;
+        else high = mid;
+    }
+    return false;
+}
+
+bool ShaderPack::Find(const std::string& name, const void*& outData, size_t& outSize) const
+{
+    return FindByHash(HashName(name), outData, outSize);
+}
+
+bool ShaderPack::Find(const std::wstring& name, const void*& outData, size_t& outSize) const
+{
+    return FindByHash(HashName(name), outData, outSize);
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Paquete con todos los shaders compilados (.cso) en un solo archivo.
+// Lo genera BuildShaderPack.ps1 como paso posterior a la compilacion (o ShaderPack::Build, con
+// el mismo formato) y se carga con una sola lectura secuencial. Los blobs se buscan por el hash
+// de su nombre. Solo C++ estandar: se prueba tambien fuera de Windows.
+//
+// Formato (little-endian):
+//   Header  { uint32 magic 'SPAK'; uint32 version; uint32 entryCount; uint32 reserved; }
+//   Entry[entryCount] { uint64 nameHash; uint32 offset; uint32 size; } ordenadas por nameHash
+//   Datos de los blobs (offset relativo al inicio del archivo)
+//
+// El nombre es el del archivo sin extension ("EvolvingVS") y el hash es FNV-1a de 64 bits
+// sobre el nombre en minusculas (ASCII).
+class ShaderPack
+{
+public:
+    static const uint32_t MAGIC = 0x4B415053; // "SPAK"
+    static const uint32_t VERSION = 1;
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t entryCount;
+        uint32_t reserved;
+    };
+
+    struct Entry
+    {
+        uint64_t nameHash;
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    // Blob de entrada del escritor: nombre sin extension y bytecode.
+    struct SourceBlob
+    {
+        std::string name;
+        std::vector<uint8_t> data;
+    };
+
+    ShaderPack();
+
+    // Escribe el paquete en memoria: tabla ordenada por hash y blobs en ese orden. false (con el
+    // motivo en outError) si dos nombres dan el mismo hash, incluidos los que solo cambian en
+    // mayusculas, o si el paquete no cabe en offsets de 32 bits.
+    static bool Build(const std::vector<SourceBlob>& blobs, std::vector<uint8_t>& outData, std::string* outError = nullptr);
+    static bool WriteToFile(const std::vector<SourceBlob>& blobs, const std::filesystem::path& path, std::string* outError = nullptr);
+
+    // Todos los .cso de un directorio, como los recoge BuildShaderPack.ps1.
+    static bool CollectDirectory(const std::filesystem::path& directory, std::vector<SourceBlob>& outBlobs);
+
+    // Lee el archivo completo de una vez y valida la tabla. false si no existe o esta corrupto
+    // (y el paquete queda vacio, aunque antes hubiera otro cargado).
+    bool LoadFromFile(const std::filesystem::path& path);
+
+    // Toma posesion de un paquete ya en memoria (mismas validaciones que LoadFromFile).
+    bool LoadFromMemory(std::vector<uint8_t> data);
+
+    // Busca un blob por nombre. Los punteros son validos mientras viva el paquete.
+    bool Find(const std::string& name, const void*& outData, size_t& outSize) const;
+    bool Find(const std::wstring& name, const void*& outData, size_t& outSize) const;
+
+    bool IsLoaded() const { return m_entryCount > 0; }
+    size_t GetEntryCount() const { return m_entryCount; }
+
+    static uint64_t HashName(const std::string& name);
+    static uint64_t HashName(const std::wstring& name);
+
+private:
+    bool FindByHash(uint64_t hash, const void*& outData, size_t& outSize) const;
+
+    std::vector<uint8_t> m_data;
+    size_t m_entryCount;
+};
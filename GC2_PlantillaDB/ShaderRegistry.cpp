@@ -0,0 +1,46 @@
+#include "pch.h"
+#include "ShaderRegistry.h"
+
+bool D3D11ShaderDevice::CreateVertexShader(const void* bytecode, size_t size, Ref<VertexShader>& out)
+{
+    return SUCCEEDED(device->CreateVertexShader(bytecode, size, nullptr, out.ReleaseAndGetAddressOf()));
+}
+
+bool D3D11ShaderDevice::CreatePixelShader(const void* bytecode, size_t size, Ref<PixelShader>& out)
+{
+    return SUCCEEDED(device->CreatePixelShader(bytecode, size, nullptr, out.ReleaseAndGetAddressOf()));
+}
+
+bool D3D11ShaderDevice::CreateInputLayout(const InputElement* elements, uint32_t elementCount,
+    const void* vsBytecode, size_t vsSize, Ref<InputLayout>& out)
+{
+    return SUCCEEDED(device->CreateInputLayout(elements, elementCount, vsBytecode, vsSize, out.ReleaseAndGetAddressOf()));
+}
+
+bool D3D11ShaderDevice::CreateConstantBuffer(uint32_t byteWidth, Ref<Buffer>& out)
+{
+    D3D11_BUFFER_DESC cbd = {};
+    cbd.Usage = D3D11_USAGE_DYNAMIC;
+    cbd.ByteWidth = byteWidth;
+    cbd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    cbd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    return SUCCEEDED(device->CreateBuffer(&cbd, nullptr, out.ReleaseAndGetAddressOf()));
+}
+
+void D3D11ShaderDevice::ReportError(const std::wstring& message)
+{
+    OutputDebugString((message + L"\n").c_str());
+}
+
+ShaderRegistry::ShaderRegistry(ID3D11Device* device) :
+    BasicShaderRegistry<D3D11ShaderDevice>(D3D11ShaderDevice(device), GetExecutableDirectory())
+{
+}
+
+std::filesystem::path ShaderRegistry::GetExecutableDirectory()
+{
+    wchar_t modulePath[MAX_PATH] = {};
+    DWORD length = GetModuleFileNameW(nullptr, modulePath, MAX_PATH);
+    if (length == 0 || length == MAX_PATH) return std::filesystem::current_path();
+    return std::filesystem::path(modulePath).parent_path();
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl.h>
+#include <filesystem>
+#include <string>
+#include "BasicShaderRegistry.h"
+
+// Dispositivo de BasicShaderRegistry sobre ID3D11Device: solo crea los objetos y escribe los
+// errores en la salida del depurador.
+struct D3D11ShaderDevice
+{
+    template <typename T> using Ref = Microsoft::WRL::ComPtr<T>;
+    using VertexShader = ID3D11VertexShader;
+    using PixelShader = ID3D11PixelShader;
+    using InputLayout = ID3D11InputLayout;
+    using Buffer = ID3D11Buffer;
+    using InputElement = D3D11_INPUT_ELEMENT_DESC;
+
+    D3D11ShaderDevice(ID3D11Device* device) : device(device) {}
+
+    bool CreateVertexShader(const void* bytecode, size_t size, Ref<VertexShader>& out);
+    bool CreatePixelShader(const void* bytecode, size_t size, Ref<PixelShader>& out);
+    bool CreateInputLayout(const InputElement* elements, uint32_t elementCount,
+        const void* vsBytecode, size_t vsSize, Ref<InputLayout>& out);
+    bool CreateConstantBuffer(uint32_t byteWidth, Ref<Buffer>& out);
+    void ReportError(const std::wstring& message);
+
+    ID3D11Device* device;
+};
+
+using ShaderProgram = BasicShaderProgram<D3D11ShaderDevice>;
+
+// Registro de shaders del juego: los .cso sueltos se buscan junto al ejecutable.
+class ShaderRegistry : public BasicShaderRegistry<D3D11ShaderDevice>
+{
+public:
+    explicit ShaderRegistry(ID3D11Device* device);
+
+    static std::filesystem::path GetExecutableDirectory();
+};
@@ -0,0 +1,134 @@
+#include "ShadowCache.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+    float Dot(const XMFLOAT3& a, const XMFLOAT3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+    // Ejes de la vista de la luz con la que se ajusto la cascada (columnas de view)
+    XMFLOAT3 LightAxis(const ShadowCascade& cascade, int axis)
+    {
+        const XMFLOAT4X4& v = cascade.view;
+        if (axis == 0) return XMFLOAT3(v._11, v._21, v._31);
+        if (axis == 1) return XMFLOAT3(v._12, v._22, v._32);
+        return XMFLOAT3(v._13, v._23, v._33);
+    }
+}
+
+ShadowCachePolicy::ShadowCachePolicy() :
+    m_cosLightThreshold(std::cos(0.25f * XM_PI / 180.0f)),
+    m_cascadesPerFrame(1),
+    m_cascadeCount(0)
+{
+    Invalidate();
+}
+
+void ShadowCachePolicy::SetLightAngleThreshold(float radians)
+{
+    m_cosLightThreshold = std::cos(std::max(radians, 0.0f));
+}
+
+void ShadowCachePolicy::SetCascadesPerFrame(int count)
+{
+    m_cascadesPerFrame = std::max(count, 1);
+}
+
+void ShadowCachePolicy::Invalidate()
+{
+    for (bool& valid : m_valid) valid = false;
+}
+
+ShadowCachePolicy::Staleness ShadowCachePolicy::Classify(const ShadowCascade& current, int index, float& outLightError) const
+{
+    outLightError = 0.0f;
+    if (!m_valid[index]) return Staleness::Missing;
+
+    // Otro reparto de cortes, resolucion o paso de ajuste: lo cacheado no sirve
+    const ShadowCascade& cached = m_cached[index];
+    if (cached.splitNear != current.splitNear || cached.splitFar != current.splitFar ||
+        cached.sphereRadius != current.sphereRadius || cached.snapSize != current.snapSize)
+    {
+        return Staleness::Missing;
+    }
+
+    // Esfera del trozo actual en la vista de la luz cacheada. Si ya no cabe en la caja (en z, dejando
+    // el margen de casters hacia la luz) no puede esperar; si cabe pero cambio de tesela, se ira
+    // saliendo del margen de un paso y se re-renderiza dentro del reparto
+    const int cachedOrigin[3] = { cached.originX, cached.originY, cached.originZ };
+    const float mins[3] = { cached.minX, cached.minY, cached.minZ };
+    const float maxs[3] = { cached.maxX, cached.maxY, cached.maxZ - cached.casterMargin };
+    bool originChanged = false;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        float projected = Dot(current.sphereCenter, LightAxis(cached, axis));
+        if (projected - current.sphereRadius < mins[axis] || projected + current.sphereRadius > maxs[axis]) return Staleness::Uncovered;
+        if (static_cast<int>(std::floor(projected / cached.snapSize)) != cachedOrigin[axis]) originChanged = true;
+    }
+    if (originChanged) return Staleness::Origin;
+
+    float cosError = Dot(cached.towardsLight, current.towardsLight);
+    outLightError = 1.0f - cosError;
+    return cosError < m_cosLightThreshold ? Staleness::Light : Staleness::Fresh;
+}
+
+int ShadowCachePolicy::Update(const ShadowCascades& cascades, int* outCascades)
+{
+    const int count = cascades.GetCascadeCount();
+    if (count != m_cascadeCount)
+    {
+        m_cascadeCount = count;
+        Invalidate();
+    }
+
+    Staleness staleness[ShadowCascades::MAX_CASCADES];
+    float lightError[ShadowCascades::MAX_CASCADES];
+    for (int i = 0; i < count; ++i)
+    {
+        staleness[i] = Classify(cascades.GetCascade(i), i, lightError[i]);
+    }
+
+    int renderCount = 0;
+    auto render = [&](int i)
+    {
+        m_cached[i] = cascades.GetCascade(i);
+        m_valid[i] = true;
+        staleness[i] = Staleness::Fresh;
+        outCascades[renderCount++] = i;
+    };
+
+    // 1. Sin nada cacheado, o con el trozo fuera de lo cacheado, no hay sombra correcta que mostrar:
+    //    no esperan al reparto
+    for (int i = 0; i < count; ++i)
+    {
+        if (staleness[i] == Staleness::Missing || staleness[i] == Staleness::Uncovered) render(i);
+    }
+
+    // 2. Cambio de tesela, de la cascada mas cercana a la mas lejana
+    int budget = m_cascadesPerFrame;
+    for (int i = 0; i < count && budget > 0; ++i)
+    {
+        if (staleness[i] == Staleness::Origin)
+        {
+            render(i);
+            --budget;
+        }
+    }
+
+    // 3. Luz girada por encima del umbral, la de mas error primero
+    while (budget > 0)
+    {
+        int worst = -1;
+        for (int i = 0; i < count; ++i)
+        {
+            if (staleness[i] == Staleness::Light && (worst < 0 || lightError[i] > lightError[worst])) worst = i;
+        }
+        if (worst < 0) break;
+        render(worst);
+        --budget;
+    }
+    return renderCount;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "ShadowCascades.h"
+#include <cstddef>
+#include <cstdint>
+
+// Politica del shadow map cacheado: cada cascada guarda el ajuste con el que se renderizo
+// y solo se vuelve a renderizar cuando su origen (en pasos de ajuste, ver ShadowCascades::SetSnapTexels)
+// cambia o cuando la luz ha girado mas que el umbral. Las re-renderizaciones se reparten entre frames:
+// como mucho cascadesPerFrame por frame, primero las que cambiaron de origen (de la mas cercana a la
+// mas lejana) y despues las de luz con mas error. No esperan las que nunca se renderizaron ni aquellas
+// cuya caja cacheada ya no contiene la esfera del trozo actual mas el margen de casters (p.ej. tras
+// un giro brusco de la camara): esperar dejaria receptores o casters fuera del shadow map.
+// No toca la GPU: Game dibuja las cascadas que devuelve Update y muestrea con GetCachedCascade.
+class ShadowCachePolicy
+{
+public:
+    ShadowCachePolicy();
+
+    void SetLightAngleThreshold(float radians);
+    void SetCascadesPerFrame(int count);
+
+    // Descarta todo lo cacheado (p.ej. si se mueve o se anade un caster estatico).
+    void Invalidate();
+
+    // Compara las cascadas ajustadas este frame con las cacheadas. Escribe en outCascades (hasta
+    // ShadowCascades::MAX_CASCADES) las que hay que re-renderizar y las da por cacheadas.
+    int Update(const ShadowCascades& cascades, int* outCascades);
+
+    int GetCascadeCount() const { return m_cascadeCount; }
+    const ShadowCascade& GetCachedCascade(int index) const { return m_cached[index]; }
+
+private:
+    enum class Staleness { Fresh, Light, Origin, Uncovered, Missing };
+    Staleness Classify(const ShadowCascade& current, int index, float& outLightError) const;
+
+    float m_cosLightThreshold;
+    int m_cascadesPerFrame;
+    int m_cascadeCount;
+    bool m_valid[ShadowCascades::MAX_CASCADES];
+    ShadowCascade m_cached[ShadowCascades::MAX_CASCADES];
+};
@@ -0,0 +1,218 @@
+#include "ShadowCascades.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+    float Dot(const XMFLOAT3& a, const XMFLOAT3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+    XMFLOAT3 Cross(const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+    }
+
+    XMFLOAT3 Normalize(const XMFLOAT3& v)
+    {
+        float length = std::sqrt(Dot(v, v));
+        return length > 0.0f ? XMFLOAT3(v.x / length, v.y / length, v.z / length) : v;
+    }
+
+    XMFLOAT3 MultiplyAdd(const XMFLOAT3& a, const XMFLOAT3& b, float s)
+    {
+        return XMFLOAT3(a.x + b.x * s, a.y + b.y * s, a.z + b.z * s);
+    }
+
+    XMFLOAT4X4 Identity()
+    {
+        XMFLOAT4X4 m = {};
+        m._11 = m._22 = m._33 = m._44 = 1.0f;
+        return m;
+    }
+
+    // Las 8 esquinas del trozo [splitNear, splitFar] del frustum de la camara
+    void SliceCorners(const ShadowCameraDesc& camera, float splitNear, float splitFar, XMFLOAT3 outCorners[8])
+    {
+        XMFLOAT3 direction = Normalize(camera.viewDirection);
+        XMFLOAT3 right = Normalize(Cross(direction, camera.up));
+        XMFLOAT3 up = Cross(right, direction);
+        const float tanHalfFov = std::tan(0.5f * camera.fieldOfViewY);
+
+        const float distances[2] = { splitNear, splitFar };
+        for (int d = 0; d < 2; ++d)
+        {
+            XMFLOAT3 center = MultiplyAdd(camera.position, direction, distances[d]);
+            float halfHeight = distances[d] * tanHalfFov;
+            float halfWidth = halfHeight * camera.aspectRatio;
+            for (int corner = 0; corner < 4; ++corner)
+            {
+                float sx = (corner & 1) ? 1.0f : -1.0f;
+                float sy = (corner & 2) ? 1.0f : -1.0f;
+                outCorners[d * 4 + corner] = MultiplyAdd(MultiplyAdd(center, right, sx * halfWidth), up, sy * halfHeight);
+            }
+        }
+    }
+}
+
+ShadowCascades::ShadowCascades() :
+    m_cascadeCount(MAX_CASCADES),
+    m_resolution(2048),
+    m_snapTexels(1),
+    m_splitLambda(0.75f),
+    m_shadowDistance(600.0f),
+    m_casterDistance(400.0f),
+    m_lightX(1.0f, 0.0f, 0.0f),
+    m_lightY(0.0f, 1.0f, 0.0f),
+    m_lightZ(0.0f, 0.0f, 1.0f)
+{
+    for (ShadowCascade& cascade : m_cascades)
+    {
+        cascade.view = Identity();
+        cascade.projection = Identity();
+    }
+}
+
+void ShadowCascades::SetCascadeCount(int count)
+{
+    m_cascadeCount = std::min(std::max(count, 1), static_cast<int>(MAX_CASCADES));
+}
+
+void ShadowCascades::SetSnapTexels(int texels)
+{
+    m_snapTexels = std::min(std::max(texels, 1), std::max(m_resolution / 8, 1));
+}
+
+void ShadowCascades::ComputeSplits(float nearPlane, float farPlane, int count, float lambda, float* outSplitFar)
+{
+    for (int i = 1; i <= count; ++i)
+    {
+        float fraction = static_cast<float>(i) / count;
+        float logarithmic = nearPlane * std::pow(farPlane / nearPlane, fraction);
+        float uniform = nearPlane + (farPlane - nearPlane) * fraction;
+        outSplitFar[i - 1] = lambda * logarithmic + (1.0f - lambda) * uniform;
+    }
+    outSplitFar[count - 1] = farPlane;
+}
+
+void ShadowCascades::GetSliceCorners(const ShadowCameraDesc& camera, float splitNear, float splitFar, XMFLOAT3 outCorners[8])
+{
+    SliceCorners(camera, splitNear, splitFar, outCorners);
+}
+
+void ShadowCascades::Update(const ShadowCameraDesc& camera, const XMFLOAT3& towardsLight)
+{
+    // Vista de la luz con origen en el del mundo: solo depende de la direccion de la luz,
+    // asi que la rejilla de texels no se mueve con la camara
+    m_lightZ = Normalize(towardsLight);
+    XMFLOAT3 up = std::fabs(m_lightZ.y) > 0.99f ? XMFLOAT3(0.0f, 0.0f, 1.0f) : XMFLOAT3(0.0f, 1.0f, 0.0f);
+    m_lightX = Normalize(Cross(up, m_lightZ));
+    m_lightY = Cross(m_lightZ, m_lightX);
+
+    float splitFar[MAX_CASCADES];
+    const float farPlane = std::min(camera.farPlane, m_shadowDistance);
+    ComputeSplits(camera.nearPlane, farPlane, m_cascadeCount, m_splitLambda, splitFar);
+
+    float splitNear = camera.nearPlane;
+    for (int i = 0; i < m_cascadeCount; ++i)
+    {
+        FitCascade(camera, splitNear, splitFar[i], m_cascades[i]);
+        splitNear = splitFar[i];
+    }
+}
+
+void ShadowCascades::FitCascade(const ShadowCameraDesc& camera, float splitNear, float splitFar, ShadowCascade& outCascade) const
+{
+    // Esfera minima del trozo: centro en el eje de vista, equidistante de las esquinas cercanas
+    // y lejanas (k2 = tan^2(fov/2) * (1 + aspecto^2) es la semidiagonal al cuadrado por unidad de distancia)
+    const float tanHalfFov = std::tan(0.5f * camera.fieldOfViewY);
+    const float k2 = tanHalfFov * tanHalfFov * (1.0f + camera.aspectRatio * camera.aspectRatio);
+    float centerDistance = 0.5f * (splitFar + splitNear) * (1.0f + k2);
+    float radius;
+    if (centerDistance >= splitFar)
+    {
+        centerDistance = splitFar;
+        radius = splitFar * std::sqrt(k2);
+    }
+    else
+    {
+        radius = std::sqrt((splitFar - centerDistance) * (splitFar - centerDistance) + splitFar * splitFar * k2);
+    }
+    radius = std::ceil(radius * 16.0f) / 16.0f; // Sin ruido de coma flotante entre frames
+
+    XMFLOAT3 center = MultiplyAdd(camera.position, Normalize(camera.viewDirection), centerDistance);
+
+    // Un paso de ajuste de margen: el ajuste a la rejilla mueve el centro menos de un paso
+    const float halfSize = radius * m_resolution / (m_resolution - 2.0f * m_snapTexels);
+    const float texelSize = 2.0f * halfSize / m_resolution;
+    const float snapSize = texelSize * m_snapTexels;
+    const float originX = std::floor(Dot(center, m_lightX) / snapSize);
+    const float originY = std::floor(Dot(center, m_lightY) / snapSize);
+    const float originZ = std::floor(Dot(center, m_lightZ) / snapSize);
+    // Caja centrada en la tesela del centro: el centro puede salirse medio paso por cada lado
+    // antes de que la esfera toque el borde
+    const float lightX = (originX + 0.5f) * snapSize;
+    const float lightY = (originY + 0.5f) * snapSize;
+    const float lightZ = (originZ + 0.5f) * snapSize;
+
+    outCascade.splitNear = splitNear;
+    outCascade.splitFar = splitFar;
+    outCascade.sphereCenter = center;
+    outCascade.sphereRadius = radius;
+    outCascade.texelSize = texelSize;
+    outCascade.snapSize = snapSize;
+    outCascade.towardsLight = m_lightZ;
+    outCascade.originX = static_cast<int>(originX);
+    outCascade.originY = static_cast<int>(originY);
+    outCascade.originZ = static_cast<int>(originZ);
+    outCascade.minX = lightX - halfSize;
+    outCascade.maxX = lightX + halfSize;
+    outCascade.minY = lightY - halfSize;
+    outCascade.maxY = lightY + halfSize;
+    // En z el mismo margen que en x, y
+    outCascade.minZ = lightZ - snapSize - radius;
+    outCascade.maxZ = lightZ + snapSize + radius + m_casterDistance;
+    outCascade.casterMargin = m_casterDistance;
+
+    // Filas = ejes de la luz en columnas: v * view = (dot(v, X), dot(v, Y), dot(v, Z))
+    XMFLOAT4X4& view = outCascade.view;
+    view = Identity();
+    view._11 = m_lightX.x; view._12 = m_lightY.x; view._13 = m_lightZ.x;
+    view._21 = m_lightX.y; view._22 = m_lightY.y; view._23 = m_lightZ.y;
+    view._31 = m_lightX.z; view._32 = m_lightY.z; view._33 = m_lightZ.z;
+
+    // Como XMMatrixOrthographicOffCenterRH; la vista mira hacia -Z, asi que near = -maxZ
+    const float nearZ = -outCascade.maxZ;
+    const float farZ = -outCascade.minZ;
+    const float reciprocalWidth = 1.0f / (outCascade.maxX - outCascade.minX);
+    const float reciprocalHeight = 1.0f / (outCascade.maxY - outCascade.minY);
+    const float range = 1.0f / (nearZ - farZ);
+    XMFLOAT4X4& projection = outCascade.projection;
+    projection = Identity();
+    projection._11 = 2.0f * reciprocalWidth;
+    projection._22 = 2.0f * reciprocalHeight;
+    projection._33 = range;
+    projection._41 = -(outCascade.minX + outCascade.maxX) * reciprocalWidth;
+    projection._42 = -(outCascade.minY + outCascade.maxY) * reciprocalHeight;
+    projection._43 = range * nearZ;
+}
+
+bool ShadowCascades::IntersectsBox(const ShadowCascade& c, const XMFLOAT3& center, const XMFLOAT3& extents)
+{
+    // Columnas de la vista: ejes x, y, z de la luz en mundo
+    const XMFLOAT3 axes[3] = {
+        XMFLOAT3(c.view._11, c.view._21, c.view._31),
+        XMFLOAT3(c.view._12, c.view._22, c.view._32),
+        XMFLOAT3(c.view._13, c.view._23, c.view._33) };
+    const float mins[3] = { c.minX, c.minY, c.minZ };
+    const float maxs[3] = { c.maxX, c.maxY, c.maxZ };
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        const XMFLOAT3& a = axes[axis];
+        float projectedCenter = Dot(center, a);
+        float projectedExtent = std::fabs(a.x) * extents.x + std::fabs(a.y) * extents.y + std::fabs(a.z) * extents.z;
+        if (projectedCenter + projectedExtent < mins[axis] || projectedCenter - projectedExtent > maxs[axis]) return false;
+    }
+    return true;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+
+// Lo que las cascadas necesitan de la camara (mundo).
+struct ShadowCameraDesc
+{
+    DirectX::XMFLOAT3 position = { 0.0f, 0.0f, 0.0f };
+    DirectX::XMFLOAT3 viewDirection = { 0.0f, 0.0f, -1.0f }; // Hacia donde mira (normalizado)
+    DirectX::XMFLOAT3 up = { 0.0f, 1.0f, 0.0f };
+    float fieldOfViewY = 0.785398f; // Radianes
+    float aspectRatio = 1.0f;
+    float nearPlane = 1.0f;
+    float farPlane = 1000.0f;
+};
+
+struct ShadowCascade
+{
+    DirectX::XMFLOAT4X4 view;       // Vista de la luz (fila-mayor, RH como SimpleMath::Matrix::CreateLookAt)
+    DirectX::XMFLOAT4X4 projection; // Ortografica fuera de centro (RH)
+    float splitNear = 0.0f;         // Trozo del frustum de la camara (distancias de vista)
+    float splitFar = 0.0f;
+    DirectX::XMFLOAT3 sphereCenter = { 0.0f, 0.0f, 0.0f }; // Esfera que envuelve el trozo (mundo)
+    float sphereRadius = 0.0f;
+    float texelSize = 0.0f;         // Unidades de mundo por texel del shadow map
+    float snapSize = 0.0f;          // Paso de ajuste del origen (texelSize * snapTexels)
+    DirectX::XMFLOAT3 towardsLight = { 0.0f, 1.0f, 0.0f }; // Direccion de la luz con la que se ajusto
+    int originX = 0, originY = 0, originZ = 0; // Origen en espacio de luz, en pasos de ajuste (ver SetSnapTexels)
+    // Caja de la cascada en espacio de luz (x, y ajustadas a texel; z hacia la luz)
+    float minX = 0.0f, maxX = 0.0f;
+    float minY = 0.0f, maxY = 0.0f;
+    float minZ = 0.0f, maxZ = 0.0f;
+    float casterMargin = 0.0f;      // Parte de maxZ reservada a los que proyectan sombra desde fuera del trozo
+};
+
+// Cascadas de sombras direccionales: cortes con el esquema practico (mezcla de reparto
+// logaritmico y uniforme), una esfera por corte (el radio solo depende de los cortes y de la
+// proyeccion, asi que no cambia al girar ni al mover la camara) y el centro ajustado a la rejilla
+// de texels en una vista de la luz que solo depende de su direccion. Al moverse la camara la
+// proyeccion se desplaza texels enteros y los bordes de las sombras no tiemblan.
+class ShadowCascades
+{
+public:
+    static const int MAX_CASCADES = 4;
+
+    ShadowCascades();
+
+    void SetCascadeCount(int count);
+    void SetResolution(int texels) { m_resolution = texels; }   // Lado del shadow map de cada cascada
+    void SetSplitLambda(float lambda) { m_splitLambda = lambda; } // 0 = uniforme, 1 = logaritmico
+    void SetShadowDistance(float distance) { m_shadowDistance = distance; } // Final de la ultima cascada
+    void SetCasterDistance(float distance) { m_casterDistance = distance; } // Margen hacia la luz para los que proyectan sombra
+    // Paso (en texeles) con el que se ajusta el origen de cada cascada. 1 = el minimo; con pasos
+    // mayores la cascada cubre un margen de ese tamano y su origen cambia con menos frecuencia,
+    // lo que permite reutilizar el shadow map mientras la camara se mueve dentro de una tesela.
+    void SetSnapTexels(int texels);
+
+    int GetCascadeCount() const { return m_cascadeCount; }
+    int GetResolution() const { return m_resolution; }
+    int GetSnapTexels() const { return m_snapTexels; }
+    const ShadowCascade& GetCascade(int index) const { return m_cascades[index]; }
+
+    // towardsLight: direccion de mundo hacia la luz (normalizada).
+    void Update(const ShadowCameraDesc& camera, const DirectX::XMFLOAT3& towardsLight);
+
+    // AABB de mundo contra el volumen de la cascada (incluido el margen hacia la luz). Usa la vista
+    // de la propia cascada, asi que vale tambien para cascadas cacheadas con otra direccion de luz.
+    static bool IntersectsBox(const ShadowCascade& cascade, const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents);
+
+    // Distancias de vista del final de cada corte (outSplitFar[count - 1] = farPlane).
+    static void ComputeSplits(float nearPlane, float farPlane, int count, float lambda, float* outSplitFar);
+
+    // Las 8 esquinas (mundo) del trozo [splitNear, splitFar] del frustum de la camara.
+    static void GetSliceCorners(const ShadowCameraDesc& camera, float splitNear, float splitFar, DirectX::XMFLOAT3 outCorners[8]);
+
+private:
+    void FitCascade(const ShadowCameraDesc& camera, float splitNear, float splitFar, ShadowCascade& outCascade) const;
+
+    int m_cascadeCount;
+    int m_resolution;
+    int m_snapTexels;
+    float m_splitLambda;
+    float m_shadowDistance;
+    float m_casterDistance;
+
+    // Base de la vista de la luz (filas: x, y, z en mundo)
+    DirectX::XMFLOAT3 m_lightX;
+    DirectX::XMFLOAT3 m_lightY;
+    DirectX::XMFLOAT3 m_lightZ;
+
+    ShadowCascade m_cascades[MAX_CASCADES];
+};
@@ -0,0 +1,59 @@
+// ShadowCascades.hlsli
+// Sombras direccionales en cascadas (ver ShadowCascades.h). Las cascadas comparten un atlas:
+// cada una ocupa un cuadrante del shadow map. Game sube este buffer una vez por frame al slot b3 del PS.
+
+cbuffer ShadowCascadeData : register(b3)
+{
+    matrix cascadeViewProjection[4];
+    float4 cascadeAtlasOffset[4]; // xy: esquina de la cascada en el atlas (UV)
+    float cascadeCount;
+    float cascadeAtlasScale;      // Fraccion del atlas que ocupa cada cascada
+    float cascadeBorder;          // Margen (UV de la cascada) para que el PCF no lea la cascada vecina
+    float _cascadePadding;
+};
+
+float SampleCascadePCF(Texture2D shadowTex, SamplerComparisonState shadowSamp, float2 atlasCoord, float depth)
+{
+    uint width, height;
+    shadowTex.GetDimensions(width, height);
+    float2 texelSize = float2(1.0f / width, 1.0f / height);
+
+    float shadowFactor = 0.0f;
+    for (int y = -2; y <= 2; y++)
+    {
+        for (int x = -2; x <= 2; x++)
+        {
+            shadowFactor += shadowTex.SampleCmpLevelZero(shadowSamp, atlasCoord + float2(x, y) * texelSize, depth);
+        }
+    }
+    return shadowFactor / 25.0f;
+}
+
+// Luz directa que llega a worldPosition (1 = iluminado). Se usa la primera cascada (la mas fina)
+// que contiene el punto; la ultima se desvanece hacia su borde y mas alla no hay sombra.
+float CalculateCascadedShadow(Texture2D shadowTex, SamplerComparisonState shadowSamp, float3 worldPosition, float bias)
+{
+    int count = (int)cascadeCount;
+    for (int i = 0; i < count; i++)
+    {
+        float4 lightSpacePos = mul(float4(worldPosition, 1.0f), transpose(cascadeViewProjection[i]));
+        lightSpacePos.xyz /= lightSpacePos.w;
+        float2 shadowTexCoord = float2(lightSpacePos.x * 0.5f + 0.5f, -lightSpacePos.y * 0.5f + 0.5f);
+
+        if (all(shadowTexCoord > cascadeBorder) && all(shadowTexCoord < 1.0f - cascadeBorder) &&
+            lightSpacePos.z >= 0.0f && lightSpacePos.z <= 1.0f)
+        {
+            float2 atlasCoord = cascadeAtlasOffset[i].xy + shadowTexCoord * cascadeAtlasScale;
+            float shadowFactor = SampleCascadePCF(shadowTex, shadowSamp, atlasCoord, lightSpacePos.z - bias);
+
+            if (i == count - 1)
+            {
+                float2 fromCenter = abs(shadowTexCoord - 0.5f) * 2.0f;
+                float dist = max(fromCenter.x, fromCenter.y);
+                shadowFactor = lerp(shadowFactor, 1.0f, smoothstep(0.85f, 0.98f, dist));
+            }
+            return shadowFactor;
+        }
+    }
+    return 1.0f;
+}
@@ -0,0 +1,12 @@
+#include "ShadowCasterBatches.h"
+
+void ShadowCasterBatches::Build(const uint8_t* casterMasks, size_t count)
+{
+    opaque.clear();
+    alphaTested.clear();
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (casterMasks[i] & ShadowCasterBit(ShadowCasterMode::Opaque)) opaque.push_back(static_cast<uint32_t>(i));
+        if (casterMasks[i] & ShadowCasterBit(ShadowCasterMode::AlphaTested)) alphaTested.push_back(static_cast<uint32_t>(i));
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Como proyecta sombra un material; se decide al importarlo (Model::ClassifyShadowCaster).
+enum class ShadowCasterMode : uint8_t
+{
+    None,        // No entra en el shadow map
+    Opaque,      // Solo profundidad, sin pixel shader
+    AlphaTested  // ShadowPS_AlphaClip con la textura difusa
+};
+
+// Bit de un modo en la mascara de un modelo o instancia (las partes de cada modo que tiene).
+inline uint8_t ShadowCasterBit(ShadowCasterMode mode) { return static_cast<uint8_t>(1u << static_cast<unsigned>(mode)); }
+
+// Instancias que proyectan sombra repartidas por el estado que necesitan. Se construye una vez al
+// cargar la escena; el pase de sombras recorre cada lote con su estado puesto una sola vez y dibuja
+// de cada instancia solo las partes de ese modo. Una instancia con partes de los dos modos esta en
+// ambos lotes; una sin partes que proyecten sombra no esta en ninguno.
+struct ShadowCasterBatches
+{
+    std::vector<uint32_t> opaque;
+    std::vector<uint32_t> alphaTested;
+
+    // casterMasks[i]: ShadowCasterBit de los modos de la instancia i (0 = no proyecta sombra).
+    void Build(const uint8_t* casterMasks, size_t count);
+
+    // Dibuja los dos lotes en una cascada. De cada lote se quedan en 'visible' las instancias que
+    // el dispositivo da por visibles; si queda alguna, se pone el estado del modo una sola vez y se
+    // dibuja cada instancia con sus partes de ese modo. Lo que se necesita de 'Device':
+    //   bool IsShadowCasterVisible(uint32_t instance)   la AABB toca el volumen de la cascada
+    //   void BindShadowCasterState(ShadowCasterMode mode)
+    //   void DrawShadowCaster(uint32_t instance, ShadowCasterMode mode)
+    template <typename Device>
+    void Draw(Device& device, std::vector<uint32_t>& visible) const;
+};
+
+template <typename Device>
+void ShadowCasterBatches::Draw(Device& device, std::vector<uint32_t>& visible) const
+{
+    const struct { const std::vector<uint32_t>* batch; ShadowCasterMode mode; } passes[] = {
+        { &opaque, ShadowCasterMode::Opaque },
+        { &alphaTested, ShadowCasterMode::AlphaTested } };
+    for (const auto& pass : passes)
+    {
+        visible.clear();
+        for (uint32_t index : *pass.batch)
+        {
+            if (device.IsShadowCasterVisible(index)) visible.push_back(index);
+        }
+        if (visible.empty()) continue;
+
+        device.BindShadowCasterState(pass.mode);
+        for (uint32_t index : visible) device.DrawShadowCaster(index, pass.mode);
+    }
+}
@@ -1,9 +1,13 @@
 #include "pch.h" // O tu encabezado precompilado
 #include "Terrain.h"
+#include "HeightmapDecoder.h"
 #include <WICTextureLoader.h> // Para CreateWICTextureFromFile y operaciones con texturas WIC
 #include <Effects.h>          // Para BasicEffect
 #include <VertexTypes.h>      // Para VertexPositionNormalTexture
 #include <d3dcompiler.h>
+#include <chrono>
+#include <cwctype>
+#include <filesystem>
 
 #pragma comment(lib, "d3dcompiler.lib")
 
@@ -11,9 +15,10 @@ using namespace DirectX;
 using namespace DirectX::SimpleMath;
 using Microsoft::WRL::ComPtr;
 
-float Lerp(float a, float b, float t) {
-    return a + t * (b - a);
-}
+// TerrainMeshBuilder escribe directamente en el vector de TerrainVertex
+static_assert(sizeof(TerrainMeshVertex) == sizeof(TerrainVertex), "TerrainMeshVertex must match TerrainVertex");
+static_assert(offsetof(TerrainMeshVertex, normal) == offsetof(TerrainVertex, normal), "TerrainMeshVertex must match TerrainVertex");
+static_assert(offsetof(TerrainMeshVertex, textureCoordinate) == offsetof(TerrainVertex, textureCoordinate), "TerrainMeshVertex must match TerrainVertex");
 
 Terrain::Terrain() :
     m_terrainWidth(0),
@@ -22,7 +27,19 @@ Terrain::Terrain() :
     m_textureTilingFactor(8.0f),
     m_vertexCount(0),
     m_indexCount(0),
-    m_worldMatrix(Matrix::Identity)
+    m_lastVisibleChunks(0),
+    m_lodEnabled(true),
+    m_lodViewportHeight(1080.0f),
+    m_lodFieldOfView(XM_PIDIV4),
+    m_heightSampleStride(1),
+    m_threadPool(nullptr),
+    m_vertexStream(TerrainVertexStream::Full),
+    m_lastDrawnTriangles(0),
+    m_splatDirty(false),
+    m_horizonShadows(true),
+    m_horizonDirty(false),
+    m_worldMatrix(Matrix::Identity),
+    m_worldInverse(Matrix::Identity)
 {
 }
 
@@ -32,6 +49,37 @@ Terrain::~Terrain()
 
 bool Terrain::LoadHeightmap(ID3D11Device* device, ID3D11DeviceContext* context, const wchar_t* filename)
 {
+    // Heightfields de 16 bits / float sin imagen: RAW (.r16, .raw, .r32) o paginado (.hfp)
+    std::wstring extension = std::filesystem::path(filename).extension().wstring();
+    for (wchar_t& c : extension) c = towlower(c);
+
+    if (extension == L".hfp") return LoadHeightmapPages(filename);
+
+    // PNG (8/16 bits), BMP y RAW se decodifican directamente en CPU, sin pasar por una textura y su copia de staging
+    if (CanDecodeHeightmapFile(filename))
+    {
+        auto decodeStart = std::chrono::steady_clock::now();
+        int decodedWidth = 0;
+        int decodedHeight = 0;
+        std::vector<float> decodedHeights;
+        if (LoadHeightmapFile(filename, decodedWidth, decodedHeight, decodedHeights))
+        {
+            wchar_t line[128];
+            swprintf_s(line, L"Heightmap %dx%d decoded on the CPU in %.2f ms\n", decodedWidth, decodedHeight,
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - decodeStart).count());
+            OutputDebugString(line);
+            return SetHeightData(decodedHeights, decodedWidth, decodedHeight);
+        }
+        if (extension == L".r16" || extension == L".raw" || extension == L".r32")
+        {
+            OutputDebugString(L"Failed to load RAW heightmap (must be square).\n");
+            return false;
+        }
+        OutputDebugString(L"CPU heightmap decode failed (interlaced or unusual format?), falling back to WIC.\n");
+    }
+
+    // Resto de formatos (JPEG, TIFF, DDS...): WIC en la GPU y copia a una textura de staging
+
     ComPtr<ID3D11Resource> sourceTextureResource;
     HRESULT hr = CreateWICTextureFromFile(device, context, filename,
         sourceTextureResource.GetAddressOf(),
@@ -53,8 +101,31 @@ bool Terrain::LoadHeightmap(ID3D11Device* device, ID3D11DeviceContext* context,
     D3D11_TEXTURE2D_DESC texDesc;
     sourceTexture->GetDesc(&texDesc);
 
-    m_terrainWidth = texDesc.Width;
-    m_terrainHeight = texDesc.Height;
+    // Altura = primer canal; los 8 bits solo dan 256 niveles, mejor PNG de 16 bits o float
+    HeightSampleFormat sampleFormat;
+    size_t pixelStride;
+    switch (texDesc.Format)
+    {
+    case DXGI_FORMAT_R8_UNORM:
+    case DXGI_FORMAT_A8_UNORM:              sampleFormat = HeightSampleFormat::UNorm8;  pixelStride = 1; break;
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+    case DXGI_FORMAT_B8G8R8A8_UNORM:
+    case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+    case DXGI_FORMAT_B8G8R8X8_UNORM:        sampleFormat = HeightSampleFormat::UNorm8;  pixelStride = 4; break;
+    case DXGI_FORMAT_R16_UNORM:             sampleFormat = HeightSampleFormat::UNorm16; pixelStride = 2; break;
+    case DXGI_FORMAT_R16G16B16A16_UNORM:    sampleFormat = HeightSampleFormat::UNorm16; pixelStride = 8; break;
+    case DXGI_FORMAT_R16_FLOAT:             sampleFormat = HeightSampleFormat::Float16; pixelStride = 2; break;
+    case DXGI_FORMAT_R16G16B16A16_FLOAT:    sampleFormat = HeightSampleFormat::Float16; pixelStride = 8; break;
+    case DXGI_FORMAT_R32_FLOAT:             sampleFormat = HeightSampleFormat::Float32; pixelStride = 4; break;
+    case DXGI_FORMAT_R32G32B32A32_FLOAT:    sampleFormat = HeightSampleFormat::Float32; pixelStride = 16; break;
+    default:
+        OutputDebugString(L"Unsupported heightmap pixel format.\n");
+        return false;
+    }
+
+    const int imageWidth = static_cast<int>(texDesc.Width);
+    const int imageHeight = static_cast<int>(texDesc.Height);
 
     // Crear una textura de "staging" para copiar los datos de la GPU a la CPU
     D3D11_TEXTURE2D_DESC stagingDesc = texDesc;
@@ -83,87 +154,114 @@ bool Terrain::LoadHeightmap(ID3D11Device* device, ID3D11DeviceContext* context,
         return false;
     }
 
-    m_heightData.resize(m_terrainWidth * m_terrainHeight);
+    std::vector<float> heights(static_cast<size_t>(imageWidth) * imageHeight);
     const BYTE* pPixels = reinterpret_cast<const BYTE*>(mappedResource.pData);
 
-    for (int y = 0; y < m_terrainHeight; ++y)
+    // El RowPitch es el numero de bytes por fila (puede tener relleno)
+    for (int y = 0; y < imageHeight; ++y)
     {
-        for (int x = 0; x < m_terrainWidth; ++x)
-        {
-            // Asumimos formato R8G8B8A8_UNORM o similar (4 bytes por pxel)
-            // Puedes necesitar ajustar esto basado en el formato real de tu imagen
-            // El RowPitch es el nmero de bytes por fila
-            UINT pixelOffset = (y * mappedResource.RowPitch) + (x * 4); // Asume 4 bytes/pxel (RGBA)
-
-            // Usamos el canal Rojo como valor de altura (0-255)
-            // Si es una imagen en escala de grises, R, G y B deberan ser iguales.
-            BYTE heightValue = pPixels[pixelOffset];
-            m_heightData[y * m_terrainWidth + x] = static_cast<float>(heightValue) / 255.0f; // Normalizado a 0.0 - 1.0
-        }
+        DecodeHeightSamples(pPixels + static_cast<size_t>(y) * mappedResource.RowPitch, sampleFormat, pixelStride,
+            imageWidth, &heights[static_cast<size_t>(y) * imageWidth]);
     }
 
     context->Unmap(stagingTexture.Get(), 0);
 
-    OutputDebugString(L"Heightmap loaded successfully.\n");
-    return true;
+    return SetHeightData(heights, imageWidth, imageHeight);
 }
 
-void Terrain::CalculateNormals()
+bool Terrain::SetHeightData(const std::vector<float>& heights, int width, int height)
 {
-    if (m_vertices.empty() || m_indices.empty()) return;
-
-    // 1. Inicializa todas las normales a cero.
-    for (size_t i = 0; i < m_vertices.size(); ++i)
+    // La malla (y el LOD) usa como mucho MAX_MESH_SAMPLES por lado; si el mapa es mayor se toma una muestra de cada 'stride'
+    int stride = 1;
+    while ((std::max(width, height) - 1) / stride + 1 > MAX_MESH_SAMPLES) stride++;
+
+    m_heightSampleStride = stride;
+    m_terrainWidth = (width - 1) / stride + 1;
+    m_terrainHeight = (height - 1) / stride + 1;
+    m_heightData.resize(static_cast<size_t>(m_terrainWidth) * m_terrainHeight);
+    for (int j = 0; j < m_terrainHeight; ++j)
     {
-        m_vertices[i].normal = Vector3::Zero;
+        for (int i = 0; i < m_terrainWidth; ++i)
+        {
+            m_heightData[static_cast<size_t>(j) * m_terrainWidth + i] = heights[static_cast<size_t>(j) * stride * width + static_cast<size_t>(i) * stride];
+        }
     }
+    if (stride > 1) OutputDebugString(L"Heightmap larger than the terrain mesh: using a downsampled copy (use .hfp to stream full resolution).\n");
 
-    // 2. Itera sobre cada tringulo para acumular las normales de las caras.
-    for (size_t i = 0; i < m_indexCount / 3; ++i)
-    {
-        unsigned long i0 = m_indices[i * 3 + 0];
-        unsigned long i1 = m_indices[i * 3 + 1];
-        unsigned long i2 = m_indices[i * 3 + 2];
-
-        Vector3 v0 = m_vertices[i0].position;
-        Vector3 v1 = m_vertices[i1].position;
-        Vector3 v2 = m_vertices[i2].position;
-
-        Vector3 edge1 = v1 - v0;
-        Vector3 edge2 = v2 - v0;
+    OutputDebugString(L"Heightmap loaded successfully.\n");
+    return true;
+}
 
-        // --- LA CORRECCIN EST AQU ---
-        // Se invierte el producto cruz para el sistema de mano izquierda de DirectX.
-        Vector3 faceNormal = edge2.Cross(edge1);
+bool Terrain::LoadHeightmapPages(const wchar_t* filename)
+{
+    HeightfieldPageFile pageFile;
+    if (!pageFile.Open(filename))
+    {
+        OutputDebugString(L"Failed to open paged heightmap.\n");
+        return false;
+    }
 
-        Vector3 tempNormal;
+    const int width = pageFile.GetWidth();
+    const int height = pageFile.GetHeight();
+    const int tileSize = pageFile.GetTileSize();
 
-        // Vrtice 0
-        tempNormal = m_vertices[i0].normal;
-        tempNormal += faceNormal;
-        m_vertices[i0].normal = tempNormal;
+    int stride = 1;
+    while ((std::max(width, height) - 1) / stride + 1 > MAX_MESH_SAMPLES) stride++;
 
-        // Vrtice 1
-        tempNormal = m_vertices[i1].normal;
-        tempNormal += faceNormal;
-        m_vertices[i1].normal = tempNormal;
+    m_heightSampleStride = stride;
+    m_terrainWidth = (width - 1) / stride + 1;
+    m_terrainHeight = (height - 1) / stride + 1;
+    m_heightData.resize(static_cast<size_t>(m_terrainWidth) * m_terrainHeight);
 
-        // Vrtice 2
-        tempNormal = m_vertices[i2].normal;
-        tempNormal += faceNormal;
-        m_vertices[i2].normal = tempNormal;
+    // Malla de vista general: se recorre tesela a tesela para no tener el mapa completo en memoria
+    std::vector<float> tile;
+    for (int tileZ = 0; tileZ < pageFile.GetTilesZ(); ++tileZ)
+    {
+        for (int tileX = 0; tileX < pageFile.GetTilesX(); ++tileX)
+        {
+            if (!pageFile.ReadTile(tileX, tileZ, tile))
+            {
+                OutputDebugString(L"Failed to read paged heightmap tile.\n");
+                return false;
+            }
+
+            const int firstJ = (tileZ * tileSize + stride - 1) / stride;
+            const int firstI = (tileX * tileSize + stride - 1) / stride;
+            for (int j = firstJ; j < m_terrainHeight && j * stride < (tileZ + 1) * tileSize; ++j)
+            {
+                for (int i = firstI; i < m_terrainWidth && i * stride < (tileX + 1) * tileSize; ++i)
+                {
+                    int localX = i * stride - tileX * tileSize;
+                    int localZ = j * stride - tileZ * tileSize;
+                    m_heightData[static_cast<size_t>(j) * m_terrainWidth + i] = tile[static_cast<size_t>(localZ) * tileSize + localX];
+                }
+            }
+        }
     }
 
-    // 3. Normaliza el resultado para obtener vectores unitarios.
-    for (size_t i = 0; i < m_vertices.size(); ++i)
+    // Si la malla es mas gruesa que el mapa, las alturas a resolucion completa se cargan alrededor de la camara
+    if (stride > 1)
     {
-        Vector3 tempNormal = m_vertices[i].normal;
-        tempNormal.Normalize();
-        m_vertices[i].normal = tempNormal;
+        m_heightStreamer = std::make_unique<HeightfieldStreamer>();
+        if (!m_heightStreamer->Open(filename, HEIGHT_STREAMING_BUDGET_BYTES))
+        {
+            OutputDebugString(L"Failed to start heightmap streaming.\n");
+            m_heightStreamer.reset();
+        }
     }
-    OutputDebugString(L"Normals calculated.\n");
+
+    OutputDebugString(L"Paged heightmap loaded successfully.\n");
+    return true;
 }
 
+void Terrain::UpdateHeightStreaming(const Vector3& cameraPositionWorld)
+{
+    if (!m_heightStreamer) return;
+
+    // Posicion de la camara en la rejilla de la malla -> muestras del heightfield completo
+    Vector3 local = Vector3::Transform(cameraPositionWorld, m_worldMatrix.Invert());
+    m_heightStreamer->Update(local.x * m_heightSampleStride, local.z * m_heightSampleStride, HEIGHT_STREAMING_RADIUS);
+}
 
 bool Terrain::InitializeBuffers(ID3D11Device* device)
 {
@@ -175,82 +273,233 @@ bool Terrain::InitializeBuffers(ID3D11Device* device)
     }
 
     m_vertexCount = m_terrainWidth * m_terrainHeight;
-    m_indexCount = (m_terrainWidth - 1) * (m_terrainHeight - 1) * 6; // 2 tringulos por quad, 3 ndices por tringulo
 
     m_vertices.resize(m_vertexCount);
-    m_indices.resize(m_indexCount);
 
-    // Crear vrtices
-    for (int j = 0; j < m_terrainHeight; ++j)
+    // Posiciones, normales (diferencias centrales) y UVs por bandas de filas en el pool
+    auto buildStart = std::chrono::steady_clock::now();
+    TerrainMeshBuilder::BuildVertices(m_heightData.data(), m_terrainWidth, m_terrainHeight, m_heightScale, m_textureTilingFactor,
+        reinterpret_cast<TerrainMeshVertex*>(m_vertices.data()), m_threadPool);
+    double vertexMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+
+    // Indices por trozos: cada trozo queda contiguo en el index buffer para poder descartarlo
+    buildStart = std::chrono::steady_clock::now();
+    if (!m_chunkGrid.Build(m_heightData.data(), m_terrainWidth, m_terrainHeight, m_heightScale, CHUNK_CELLS, m_threadPool))
     {
-        for (int i = 0; i < m_terrainWidth; ++i)
-        {
-            int index = j * m_terrainWidth + i;
-            float height = m_heightData[index] * m_heightScale;
-
-            m_vertices[index].position = Vector3(static_cast<float>(i), height, static_cast<float>(j));
-            m_vertices[index].textureCoordinate = Vector2(
-                (static_cast<float>(i) / (m_terrainWidth - 1)) * m_textureTilingFactor,
-                (static_cast<float>(j) / (m_terrainHeight - 1)) * m_textureTilingFactor
-            );
-            // La normal se calcular despus
-        }
+        OutputDebugString(L"Failed to build terrain chunks.\n");
+        return false;
     }
+    double indexMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+    m_chunkGrid.UpdateWorldBounds(m_worldMatrix);
+    m_indexCount = static_cast<int>(m_chunkGrid.GetIndices().size());
+
+    m_heightSampler.SetHeights(m_heightData.data(), m_terrainWidth, m_terrainHeight, m_heightScale);
+    m_heightSampler.SetTransform(m_worldMatrix);
+
+    buildStart = std::chrono::steady_clock::now();
+    m_raycaster.Build(m_heightData.data(), m_terrainWidth, m_terrainHeight, m_heightScale);
+    double raycastMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+
+    wchar_t buildLog[160];
+    swprintf_s(buildLog, L"Terrain mesh %dx%d: vertices %.2f ms, indices %.2f ms, raycast pyramid %.2f ms\n",
+        m_terrainWidth, m_terrainHeight, vertexMs, indexMs, raycastMs);
+    OutputDebugString(buildLog);
+
+    // Vertex buffer: completo, solo normales empaquetadas o ninguno (modo compacto)
+    HRESULT hr = S_OK;
+    m_vertexBuffer.Reset();
+    if (m_vertexStream == TerrainVertexStream::Full)
+    {
+        D3D11_BUFFER_DESC vertexBufferDesc = {};
+        vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
+        vertexBufferDesc.ByteWidth = sizeof(TerrainVertex) * m_vertexCount;
+        vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 
+        D3D11_SUBRESOURCE_DATA vertexData = {};
+        vertexData.pSysMem = m_vertices.data();
 
-    int k = 0;
-    for (int j = 0; j < m_terrainHeight - 1; ++j)
-    {
-        for (int i = 0; i < m_terrainWidth - 1; ++i)
-        {
-            int topLeft = j * m_terrainWidth + i;
-            int topRight = topLeft + 1;
-            int bottomLeft = (j + 1) * m_terrainWidth + i;
-            int bottomRight = bottomLeft + 1;
-
-            // Tringulo 1
-            m_indices[k++] = topLeft;
-            m_indices[k++] = topRight;
-            m_indices[k++] = bottomLeft;
-
-            // Tringulo 2
-            m_indices[k++] = bottomLeft;
-            m_indices[k++] = topRight;
-            m_indices[k++] = bottomRight;
-        }
+        hr = device->CreateBuffer(&vertexBufferDesc, &vertexData, m_vertexBuffer.ReleaseAndGetAddressOf());
+        if (FAILED(hr)) { OutputDebugString(L"Failed to create terrain vertex buffer.\n"); return false; }
     }
+    else if (m_vertexStream == TerrainVertexStream::CompactPackedNormal)
+    {
+        std::vector<TerrainPackedNormal> packedNormals(m_vertexCount);
+        TerrainMeshBuilder::PackNormals(reinterpret_cast<const TerrainMeshVertex*>(m_vertices.data()), m_vertices.size(), packedNormals.data());
 
-    CalculateNormals(); // Calcular normales despus de tener todas las posiciones de los vrtices
-
-    // Crear Vertex Buffer
-    D3D11_BUFFER_DESC vertexBufferDesc = {};
-    vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-    vertexBufferDesc.ByteWidth = sizeof(TerrainVertex) * m_vertexCount;
-    vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+        D3D11_BUFFER_DESC normalBufferDesc = {};
+        normalBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+        normalBufferDesc.ByteWidth = static_cast<UINT>(sizeof(TerrainPackedNormal) * packedNormals.size());
+        normalBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 
-    D3D11_SUBRESOURCE_DATA vertexData = {};
-    vertexData.pSysMem = m_vertices.data();
+        D3D11_SUBRESOURCE_DATA normalData = {};
+        normalData.pSysMem = packedNormals.data();
 
-    HRESULT hr = device->CreateBuffer(&vertexBufferDesc, &vertexData, m_vertexBuffer.ReleaseAndGetAddressOf());
-    if (FAILED(hr)) { OutputDebugString(L"Failed to create terrain vertex buffer.\n"); return false; }
+        hr = device->CreateBuffer(&normalBufferDesc, &normalData, m_vertexBuffer.ReleaseAndGetAddressOf());
+        if (FAILED(hr)) { OutputDebugString(L"Failed to create terrain packed normal buffer.\n"); return false; }
+    }
 
     // Crear Index Buffer
     D3D11_BUFFER_DESC indexBufferDesc = {};
     indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-    indexBufferDesc.ByteWidth = sizeof(unsigned long) * m_indexCount;
+    indexBufferDesc.ByteWidth = sizeof(uint32_t) * m_indexCount;
     indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
 
     D3D11_SUBRESOURCE_DATA indexData = {};
-    indexData.pSysMem = m_indices.data();
+    indexData.pSysMem = m_chunkGrid.GetIndices().data();
 
     hr = device->CreateBuffer(&indexBufferDesc, &indexData, m_indexBuffer.ReleaseAndGetAddressOf());
     if (FAILED(hr)) { OutputDebugString(L"Failed to create terrain index buffer.\n"); return false; }
 
+    // Quadtree del LOD continuo: otro index buffer sobre los mismos vertices
+    if (!m_lodTree.Build(m_heightData.data(), m_terrainWidth, m_terrainHeight, m_heightScale, CHUNK_CELLS))
+    {
+        OutputDebugString(L"Failed to build terrain LOD tree.\n");
+        return false;
+    }
+    m_lodTree.UpdateWorldBounds(m_worldMatrix);
+    UpdateLodRanges();
+
+    D3D11_BUFFER_DESC lodIndexBufferDesc = {};
+    lodIndexBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+    lodIndexBufferDesc.ByteWidth = static_cast<UINT>(sizeof(uint32_t) * m_lodTree.GetIndices().size());
+    lodIndexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+
+    D3D11_SUBRESOURCE_DATA lodIndexData = {};
+    lodIndexData.pSysMem = m_lodTree.GetIndices().data();
+
+    hr = device->CreateBuffer(&lodIndexBufferDesc, &lodIndexData, m_lodIndexBuffer.ReleaseAndGetAddressOf());
+    if (FAILED(hr)) { OutputDebugString(L"Failed to create terrain LOD index buffer.\n"); return false; }
+
+    if (!CreateHeightBuffer(device)) return false;
+
+    // En modo compacto la GPU ya tiene todo lo necesario; la copia completa solo servia de origen
+    if (m_vertexStream != TerrainVertexStream::Full)
+    {
+        m_vertices.clear();
+        m_vertices.shrink_to_fit();
+    }
+
     OutputDebugString(L"Terrain buffers initialized.\n");
     return true;
 }
 
+bool Terrain::CreateHeightBuffer(ID3D11Device* device)
+{
+    // Alturas para el vertex shader (Buffer<float>): float en el modo completo, R16_UNORM en el compacto
+    const bool compact = m_vertexStream != TerrainVertexStream::Full;
+    std::vector<uint16_t> quantizedHeights;
+    if (compact)
+    {
+        quantizedHeights.resize((m_heightData.size() + 1) & ~static_cast<size_t>(1)); // ByteWidth multiplo de 4
+        TerrainMeshBuilder::QuantizeHeights(m_heightData.data(), m_heightData.size(), quantizedHeights.data());
+
+#ifdef _DEBUG
+        // Referencia en CPU del shader compacto frente a los vertices completos. Coinciden bit a bit
+        // si las alturas caben en 16 bits (heightmaps de 8/16 bits); con .r32 difieren por la cuantizacion.
+        if (!m_vertices.empty())
+        {
+            size_t mismatches = TerrainMeshBuilder::CountCompactMismatches(quantizedHeights.data(), m_terrainWidth, m_terrainHeight,
+                m_heightScale, m_textureTilingFactor, reinterpret_cast<const TerrainMeshVertex*>(m_vertices.data()));
+            wchar_t line[160];
+            swprintf_s(line, L"Compact terrain vertices: %zu of %d differ from the full vertex buffer\n", mismatches, m_vertexCount);
+            OutputDebugString(line);
+        }
+#endif
+    }
+
+    D3D11_BUFFER_DESC heightBufferDesc = {};
+    heightBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+    heightBufferDesc.ByteWidth = compact ? static_cast<UINT>(sizeof(uint16_t) * quantizedHeights.size())
+                                         : static_cast<UINT>(sizeof(float) * m_heightData.size());
+    heightBufferDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+    D3D11_SUBRESOURCE_DATA heightInitData = {};
+    heightInitData.pSysMem = compact ? static_cast<const void*>(quantizedHeights.data()) : static_cast<const void*>(m_heightData.data());
+
+    HRESULT hr = device->CreateBuffer(&heightBufferDesc, &heightInitData, m_heightBuffer.ReleaseAndGetAddressOf());
+    if (FAILED(hr)) { OutputDebugString(L"Failed to create terrain height buffer.\n"); return false; }
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC heightSRVDesc = {};
+    heightSRVDesc.Format = compact ? DXGI_FORMAT_R16_UNORM : DXGI_FORMAT_R32_FLOAT;
+    heightSRVDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+    heightSRVDesc.Buffer.FirstElement = 0;
+    heightSRVDesc.Buffer.NumElements = static_cast<UINT>(m_heightData.size());
+
+    hr = device->CreateShaderResourceView(m_heightBuffer.Get(), &heightSRVDesc, m_heightBufferSRV.ReleaseAndGetAddressOf());
+    if (FAILED(hr)) { OutputDebugString(L"Failed to create terrain height SRV.\n"); return false; }
+
+    // Memoria por vertice en la GPU (sin contar indices)
+    size_t bytesPerVertex = compact ? sizeof(uint16_t) : sizeof(TerrainVertex) + sizeof(float);
+    if (m_vertexStream == TerrainVertexStream::CompactPackedNormal) bytesPerVertex += sizeof(TerrainPackedNormal);
+    wchar_t line[160];
+    swprintf_s(line, L"Terrain vertex data: %zu bytes per vertex, %.2f MB\n",
+        bytesPerVertex, bytesPerVertex * static_cast<double>(m_vertexCount) / (1024.0 * 1024.0));
+    OutputDebugString(line);
+    return true;
+}
+
+void Terrain::BuildOccluderMesh(int step)
+{
+    m_occluderPositions.clear();
+    m_occluderIndices.clear();
+    if (m_heightData.empty() || m_terrainWidth < 2 || m_terrainHeight < 2 || step < 1) return;
+
+    // Columnas/filas de la malla gruesa; la ltima siempre cae en el borde del heightmap
+    std::vector<int> columns, rows;
+    for (int i = 0; i < m_terrainWidth - 1; i += step) columns.push_back(i);
+    columns.push_back(m_terrainWidth - 1);
+    for (int j = 0; j < m_terrainHeight - 1; j += step) rows.push_back(j);
+    rows.push_back(m_terrainHeight - 1);
+
+    const int cols = static_cast<int>(columns.size());
+    const int rowCount = static_cast<int>(rows.size());
+    m_occluderPositions.reserve(cols * rowCount);
+
+    for (int r = 0; r < rowCount; ++r)
+    {
+        for (int c = 0; c < cols; ++c)
+        {
+            const int gi = columns[c];
+            const int gj = rows[r];
+
+            // Mnimo en la ventana que cubre las celdas vecinas: la malla gruesa queda
+            // siempre por debajo de la real y no puede tapar algo que se ve.
+            float minHeight = 1.0f;
+            for (int j = std::max(0, gj - step); j <= std::min(m_terrainHeight - 1, gj + step); ++j)
+            {
+                for (int i = std::max(0, gi - step); i <= std::min(m_terrainWidth - 1, gi + step); ++i)
+                {
+                    minHeight = std::min(minHeight, m_heightData[j * m_terrainWidth + i]);
+                }
+            }
+
+            m_occluderPositions.emplace_back(static_cast<float>(gi), minHeight * m_heightScale, static_cast<float>(gj));
+        }
+    }
+
+    m_occluderIndices.reserve((cols - 1) * (rowCount - 1) * 6);
+    for (int r = 0; r < rowCount - 1; ++r)
+    {
+        for (int c = 0; c < cols - 1; ++c)
+        {
+            uint32_t topLeft = r * cols + c;
+            uint32_t topRight = topLeft + 1;
+            uint32_t bottomLeft = (r + 1) * cols + c;
+            uint32_t bottomRight = bottomLeft + 1;
+
+            m_occluderIndices.push_back(topLeft);
+            m_occluderIndices.push_back(topRight);
+            m_occluderIndices.push_back(bottomLeft);
+
+            m_occluderIndices.push_back(bottomLeft);
+            m_occluderIndices.push_back(topRight);
+            m_occluderIndices.push_back(bottomRight);
+        }
+    }
+}
+
 bool Terrain::LoadTexture(ID3D11Device* device, const wchar_t* filename, ComPtr<ID3D11ShaderResourceView>& textureSRV)
+
 {
     HRESULT hr = CreateWICTextureFromFile(device, filename, nullptr, textureSRV.ReleaseAndGetAddressOf());
     if (FAILED(hr))
@@ -263,54 +512,166 @@ bool Terrain::LoadTexture(ID3D11Device* device, const wchar_t* filename, ComPtr<
 }
 
 
+void Terrain::BakeSplatMap(std::vector<uint32_t>& texels) const
+{
+    TerrainSplatMaterial material;
+    material.dirtMaxHeight = m_terrainMaterialData.dirtMaxHeight;
+    material.grassMaxHeight = m_terrainMaterialData.grassMaxHeight;
+    material.blendRange = m_terrainMaterialData.blendRange;
+    material.rockSlopeThreshold = m_terrainMaterialData.rockSlopeThreshold;
+
+    texels.resize(m_heightData.size());
+    TerrainSplatBaker::Bake(m_heightData.data(), m_terrainWidth, m_terrainHeight, m_heightScale, m_worldMatrix,
+        material, texels.data(), m_threadPool);
+}
+
+bool Terrain::CreateSplatMap(ID3D11Device* device)
+{
+    auto bakeStart = std::chrono::steady_clock::now();
+    std::vector<uint32_t> texels;
+    BakeSplatMap(texels);
+    double bakeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - bakeStart).count();
+
+    // Un texel por vertice de la rejilla; DEFAULT para poder rehornearlo con UpdateSubresource
+    D3D11_TEXTURE2D_DESC splatDesc = {};
+    splatDesc.Width = static_cast<UINT>(m_terrainWidth);
+    splatDesc.Height = static_cast<UINT>(m_terrainHeight);
+    splatDesc.MipLevels = 1;
+    splatDesc.ArraySize = 1;
+    splatDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    splatDesc.SampleDesc.Count = 1;
+    splatDesc.Usage = D3D11_USAGE_DEFAULT;
+    splatDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+    D3D11_SUBRESOURCE_DATA splatInitData = {};
+    splatInitData.pSysMem = texels.data();
+    splatInitData.SysMemPitch = static_cast<UINT>(m_terrainWidth * sizeof(uint32_t));
+
+    HRESULT hr = device->CreateTexture2D(&splatDesc, &splatInitData, m_splatTexture.ReleaseAndGetAddressOf());
+    if (FAILED(hr)) { OutputDebugString(L"Failed to create terrain splat map.\n"); return false; }
+
+    hr = device->CreateShaderResourceView(m_splatTexture.Get(), nullptr, m_splatSRV.ReleaseAndGetAddressOf());
+    if (FAILED(hr)) { OutputDebugString(L"Failed to create terrain splat map SRV.\n"); return false; }
+
+    wchar_t line[128];
+    swprintf_s(line, L"Terrain splat map %dx%d baked in %.2f ms\n", m_terrainWidth, m_terrainHeight, bakeMs);
+    OutputDebugString(line);
+    return true;
+}
+
+bool Terrain::BakeHorizonMap(ID3D11DeviceContext* context)
+{
+    // El terreno solo se escala y traslada: tamano de celda y altura en unidades de mundo
+    TerrainHorizonGrid grid;
+    grid.heights = m_heightData.data();
+    grid.width = m_terrainWidth;
+    grid.height = m_terrainHeight;
+    grid.cellSizeX = std::fabs(m_worldMatrix._11);
+    grid.cellSizeZ = std::fabs(m_worldMatrix._33);
+    grid.heightScale = m_heightScale * m_worldMatrix._22;
+    if (grid.cellSizeX <= 0.0f || grid.cellSizeZ <= 0.0f) return false;
+
+    const float maxDistance = std::sqrt(std::pow(grid.cellSizeX * m_terrainWidth, 2.0f) + std::pow(grid.cellSizeZ * m_terrainHeight, 2.0f));
+    const int azimuthCount = TerrainHorizonBaker::DEFAULT_AZIMUTHS;
+    const size_t sliceSize = m_heightData.size();
+
+    auto bakeStart = std::chrono::steady_clock::now();
+    std::vector<uint8_t> horizons(sliceSize * azimuthCount);
+    TerrainHorizonBaker::Bake(grid, azimuthCount, maxDistance, horizons.data(), m_threadPool);
+    double bakeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - bakeStart).count();
+
+    D3D11_TEXTURE2D_DESC horizonDesc = {};
+    horizonDesc.Width = static_cast<UINT>(m_terrainWidth);
+    horizonDesc.Height = static_cast<UINT>(m_terrainHeight);
+    horizonDesc.MipLevels = 1;
+    horizonDesc.ArraySize = azimuthCount;
+    horizonDesc.Format = DXGI_FORMAT_R8_UNORM;
+    horizonDesc.SampleDesc.Count = 1;
+    horizonDesc.Usage = D3D11_USAGE_IMMUTABLE;
+    horizonDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+    std::vector<D3D11_SUBRESOURCE_DATA> slices(azimuthCount);
+    for (int k = 0; k < azimuthCount; ++k)
+    {
+        slices[k].pSysMem = horizons.data() + sliceSize * k;
+        slices[k].SysMemPitch = static_cast<UINT>(m_terrainWidth);
+    }
+
+    ComPtr<ID3D11Device> device;
+    context->GetDevice(device.GetAddressOf());
+    HRESULT hr = device->CreateTexture2D(&horizonDesc, slices.data(), m_horizonTexture.ReleaseAndGetAddressOf());
+    if (FAILED(hr)) { OutputDebugString(L"Failed to create terrain horizon map.\n"); return false; }
+
+    hr = device->CreateShaderResourceView(m_horizonTexture.Get(), nullptr, m_horizonSRV.ReleaseAndGetAddressOf());
+    if (FAILED(hr)) { OutputDebugString(L"Failed to create terrain horizon map SRV.\n"); return false; }
+
+    wchar_t line[128];
+    swprintf_s(line, L"Terrain horizon map %dx%d x %d azimuths baked in %.2f ms\n", m_terrainWidth, m_terrainHeight, azimuthCount, bakeMs);
+    OutputDebugString(line);
+    return true;
+}
+
 bool Terrain::Initialize(ID3D11Device* device, ID3D11DeviceContext* contextForHeightmapLoad,
     const wchar_t* heightmapFilename,
     const wchar_t* textureFilename1, const wchar_t* textureFilename2, const wchar_t* textureFilename3,
-    const wchar_t* terrainVS_path, const wchar_t* terrainPS_path)
+    ShaderRegistry& shaderRegistry, const wchar_t* terrainVS_name, const wchar_t* terrainPS_name)
 {
     if (!LoadHeightmap(device, contextForHeightmapLoad, heightmapFilename)) return false;
     if (!InitializeBuffers(device)) return false; // Crea vrtices e ndices, calcula normales
+    BuildOccluderMesh(4); // Malla gruesa para el culling por oclusin (64x64 celdas con heightmap1)
 
     if (!LoadTexture(device, textureFilename1, m_textureSRV1)) return false; // Textura base
     if (!LoadTexture(device, textureFilename2, m_textureSRV2)) return false; // Textura baja altitud
     if (!LoadTexture(device, textureFilename3, m_textureSRV3)) return false; // Textura alta altitud
     if (!LoadTexture(device, L"GameAssets\\Textures\\terrain\\rock.jpg", m_textureSRV_Rock)) return false;
+    if (!CreateSplatMap(device)) return false; // Pesos de las capas, en lugar de calcularlos por pixel
 
     // --- Cargar Shaders del Terreno ---
-    ComPtr<ID3DBlob> vsBlob;
-    HRESULT hr = D3DReadFileToBlob(terrainVS_path, vsBlob.GetAddressOf());
-    if (FAILED(hr)) { OutputDebugString(L"ERROR: Failed to load Terrain VS file.\n"); return false; }
-    hr = device->CreateVertexShader(vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), nullptr, m_terrainVS.ReleaseAndGetAddressOf());
-    if (FAILED(hr)) { OutputDebugString(L"ERROR: Failed to create Terrain VS.\n"); return false; }
+    // En modo compacto el VS reconstruye la rejilla desde SV_VertexID (TerrainCompactVS.hlsl)
+    const wchar_t* vertexShaderName = terrainVS_name;
+    if (m_vertexStream == TerrainVertexStream::Compact) vertexShaderName = L"TerrainCompactVS";
+    else if (m_vertexStream == TerrainVertexStream::CompactPackedNormal) vertexShaderName = L"TerrainCompactNormalVS";
+
+    m_terrainVS = shaderRegistry.GetVertexShader(vertexShaderName);
+    if (!m_terrainVS) { OutputDebugString(L"ERROR: Failed to create Terrain VS.\n"); return false; }
 
-    const D3D11_INPUT_ELEMENT_DESC terrainVertexLayoutDesc[] =
+    if (m_vertexStream == TerrainVertexStream::Full)
     {
-        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-        { "NORMAL",   0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-        { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT,    0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 }
-    };
-    UINT numElements = ARRAYSIZE(terrainVertexLayoutDesc);
-
-    hr = device->CreateInputLayout(
-        terrainVertexLayoutDesc,    // Usar nuestra descripcin explcita
-        numElements,                // Nmero de elementos en nuestra descripcin
-        vsBlob->GetBufferPointer(), // Bytecode del shader
-        vsBlob->GetBufferSize(),    // Tamao del bytecode
-        m_inputLayout.ReleaseAndGetAddressOf() // Puntero al Input Layout
-    );
-    if (FAILED(hr)) {
-        OutputDebugString(L"ERROR: Failed to create Terrain Input Layout with explicit descriptor.\n");
-        // vsBlob->Release(); // ComPtr lo maneja si la funcin retorna
-        return false;
+        const D3D11_INPUT_ELEMENT_DESC terrainVertexLayoutDesc[] =
+        {
+            { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+            { "NORMAL",   0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+            { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT,    0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 }
+        };
+
+        m_inputLayout = shaderRegistry.GetInputLayout(terrainVertexLayoutDesc, ARRAYSIZE(terrainVertexLayoutDesc), vertexShaderName);
+        if (!m_inputLayout) {
+            OutputDebugString(L"ERROR: Failed to create Terrain Input Layout with explicit descriptor.\n");
+            return false;
+        }
     }
-    // vsBlob ya no se necesita
+    else
+    {
+        if (m_vertexStream == TerrainVertexStream::CompactPackedNormal)
+        {
+            const D3D11_INPUT_ELEMENT_DESC packedNormalLayoutDesc[] =
+            {
+                { "NORMAL", 0, DXGI_FORMAT_R8G8_SNORM, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 }
+            };
 
-    ComPtr<ID3DBlob> psBlob;
-    hr = D3DReadFileToBlob(terrainPS_path, psBlob.GetAddressOf());
-    if (FAILED(hr)) { OutputDebugString(L"ERROR: Failed to load Terrain PS file.\n"); return false; }
-    hr = device->CreatePixelShader(psBlob->GetBufferPointer(), psBlob->GetBufferSize(), nullptr, m_terrainPS.ReleaseAndGetAddressOf());
-    if (FAILED(hr)) { OutputDebugString(L"ERROR: Failed to create Terrain PS.\n"); return false; }
-    // psBlob ya no se necesita
+            m_inputLayout = shaderRegistry.GetInputLayout(packedNormalLayoutDesc, ARRAYSIZE(packedNormalLayoutDesc), vertexShaderName);
+            if (!m_inputLayout) { OutputDebugString(L"ERROR: Failed to create compact Terrain Input Layout.\n"); return false; }
+        }
+
+        // Las sombras tampoco tienen POSITION que leer
+        m_terrainShadowVS = shaderRegistry.GetVertexShader(L"TerrainShadowCompactVS");
+        if (!m_terrainShadowVS) { OutputDebugString(L"ERROR: Failed to create Terrain shadow VS.\n"); return false; }
+    }
+
+    m_terrainPS = shaderRegistry.GetPixelShader(terrainPS_name);
+    if (!m_terrainPS) { OutputDebugString(L"ERROR: Failed to create Terrain PS.\n"); return false; }
+
+    HRESULT hr;
 
     // --- Crear Constant Buffer para el Vertex Shader del Terreno ---
     D3D11_BUFFER_DESC cbd_vs_terrain = {};
@@ -321,17 +682,6 @@ bool Terrain::Initialize(ID3D11Device* device, ID3D11DeviceContext* contextForHe
     hr = device->CreateBuffer(&cbd_vs_terrain, nullptr, m_cbVSTerrainData.ReleaseAndGetAddressOf());
     if (FAILED(hr)) { OutputDebugString(L"ERROR: Failed to create Terrain VS CB.\n"); return false; }
 
-    D3D11_BUFFER_DESC cbd_ps_terrain = {};
-    cbd_ps_terrain.Usage = D3D11_USAGE_DYNAMIC;
-    cbd_ps_terrain.ByteWidth = sizeof(CBTerrainPSMaterialData);
-    cbd_ps_terrain.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-    cbd_ps_terrain.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-    hr = device->CreateBuffer(&cbd_ps_terrain, nullptr, m_cbPSTerrainMaterial.ReleaseAndGetAddressOf());
-    if (FAILED(hr)) {
-        OutputDebugString(L"ERROR: Failed to create Terrain PS Material CB.\n");
-        return false;
-    }
-
     D3D11_BUFFER_DESC cbd_shadow_pass = {};
     cbd_shadow_pass.Usage = D3D11_USAGE_DYNAMIC;
     cbd_shadow_pass.ByteWidth = sizeof(CB_VS_Shadow_Data); 
@@ -348,7 +698,33 @@ bool Terrain::Initialize(ID3D11Device* device, ID3D11DeviceContext* contextForHe
     return true;
 }
 
-void Terrain::SetWorldMatrix(const Matrix& world) { m_worldMatrix = world; }
+void Terrain::SetWorldMatrix(const Matrix& world)
+{
+    m_worldMatrix = world;
+    m_worldInverse = world.Invert();
+    m_splatDirty = m_splatTexture != nullptr;
+    m_horizonDirty = true;
+    m_heightSampler.SetTransform(world);
+    m_chunkGrid.UpdateWorldBounds(world);
+    m_lodTree.UpdateWorldBounds(world);
+    UpdateLodRanges();
+
+    // La capsula trabaja directamente en mundo: escala y traslacion de la matriz (el terreno no rota)
+    if (!m_heightData.empty())
+    {
+        TerrainCollisionGrid grid;
+        grid.heights = m_heightData.data();
+        grid.width = m_terrainWidth;
+        grid.height = m_terrainHeight;
+        grid.originX = world._41;
+        grid.originY = world._42;
+        grid.originZ = world._43;
+        grid.cellSizeX = world._11;
+        grid.cellSizeZ = world._33;
+        grid.heightScale = m_heightScale * world._22;
+        m_capsuleSweep.SetGrid(grid);
+    }
+}
 void Terrain::SetViewMatrix(const Matrix& view) { m_viewMatrix = view; }
 void Terrain::SetProjectionMatrix(const Matrix& projection) { m_projectionMatrix = projection; }
 
@@ -361,39 +737,52 @@ void Terrain::Render(ID3D11DeviceContext* context,
     ID3D11SamplerState* shadowSampler
 )
 {
-    if (!m_vertexBuffer || !m_indexBuffer || !m_terrainVS || !m_terrainPS || !m_inputLayout ||
-        !m_textureSRV1 || !m_textureSRV2 || !m_textureSRV3 || !m_cbVSTerrainData ||
+    const bool needsVertexBuffer = m_vertexStream != TerrainVertexStream::Compact;
+    if ((needsVertexBuffer && (!m_vertexBuffer || !m_inputLayout)) || !m_indexBuffer || !m_terrainVS || !m_terrainPS ||
+        !m_textureSRV1 || !m_textureSRV2 || !m_textureSRV3 || !m_splatSRV || !m_cbVSTerrainData ||
         !lightPropertiesCB || !samplerState)
     {
         OutputDebugString(L"Terrain::Render - Missing resources for custom shader rendering.\n");
         return;
     }
 
-    context->IASetInputLayout(m_inputLayout.Get());
     context->VSSetShader(m_terrainVS.Get(), nullptr, 0);
     context->PSSetShader(m_terrainPS.Get(), nullptr, 0);
 
-    // Actualizar Constant Buffer del Vertex Shader
-    D3D11_MAPPED_SUBRESOURCE mappedResourceVS;
-    context->Map(m_cbVSTerrainData.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResourceVS);
-    CBTerrainVSData* vsDataPtr = (CBTerrainVSData*)mappedResourceVS.pData;
-    vsDataPtr->World = m_worldMatrix;
-    vsDataPtr->ViewProjection = m_viewMatrix * m_projectionMatrix;
-    vsDataPtr->LightViewProjection = lightViewProjMatrix; 
-    vsDataPtr->WorldInverseTranspose = m_worldMatrix.Invert().Transpose();
-    vsDataPtr->maxTerrainHeightLocal = m_heightScale;
-    context->Unmap(m_cbVSTerrainData.Get(), 0);
+    // Datos del Vertex Shader (el morph se rellena por nivel al dibujar)
+    CBTerrainVSData vsData = {};
+    vsData.World = m_worldMatrix;
+    vsData.ViewProjection = m_viewMatrix * m_projectionMatrix;
+    vsData.LightViewProjection = lightViewProjMatrix; 
+    vsData.WorldInverseTranspose = m_worldMatrix.Invert().Transpose();
+    vsData.maxTerrainHeightLocal = m_heightScale;
+    vsData.morphStart = 0.0f;
+    vsData.morphInvRange = 0.0f;
+    vsData.lodStep = 1.0f;
+    vsData.cameraPosition = cameraPositionWorld;
+    vsData.gridMaxX = static_cast<float>(m_terrainWidth - 1);
+    vsData.gridMaxZ = static_cast<float>(m_terrainHeight - 1);
+    vsData.heightmapWidth = static_cast<float>(m_terrainWidth);
+    vsData.textureTiling = m_textureTilingFactor;
     context->VSSetConstantBuffers(0, 1, m_cbVSTerrainData.GetAddressOf());
+    context->VSSetShaderResources(0, 1, m_heightBufferSRV.GetAddressOf());
 
     // Vincular Constant Buffer de Luces (al Pixel Shader)
     context->PSSetConstantBuffers(1, 1, &lightPropertiesCB); // slot b1
 
-    D3D11_MAPPED_SUBRESOURCE mappedResourcePS;
-    context->Map(m_cbPSTerrainMaterial.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResourcePS);
-    memcpy(mappedResourcePS.pData, &m_terrainMaterialData, sizeof(CBTerrainPSMaterialData));
-    context->Unmap(m_cbPSTerrainMaterial.Get(), 0);
-    context->PSSetConstantBuffers(2, 1, m_cbPSTerrainMaterial.GetAddressOf()); 
-
+    // La matriz de mundo cambio desde el ultimo horneado: la pendiente de mundo es otra
+    if (m_splatDirty)
+    {
+        std::vector<uint32_t> texels;
+        BakeSplatMap(texels);
+        context->UpdateSubresource(m_splatTexture.Get(), 0, nullptr, texels.data(), m_terrainWidth * sizeof(uint32_t), 0);
+        m_splatDirty = false;
+    }
+    if (m_horizonShadows && m_horizonDirty && !m_heightData.empty())
+    {
+        BakeHorizonMap(context);
+        m_horizonDirty = false;
+    }
 
     // Vincular Texturas al Pixel Shader
     ID3D11ShaderResourceView* terrainTextures[] = {
@@ -406,20 +795,33 @@ void Terrain::Render(ID3D11DeviceContext* context,
     context->PSSetShaderResources(0, 4, terrainTextures);
 
     context->PSSetShaderResources(4, 1, &shadowMapSRV);
+    context->PSSetShaderResources(5, 1, m_splatSRV.GetAddressOf());
+    ID3D11ShaderResourceView* horizonSRV = m_horizonShadows ? m_horizonSRV.Get() : nullptr; // Sin mapa, el PS no aplica horizonte
+    context->PSSetShaderResources(6, 1, &horizonSRV);
     context->PSSetSamplers(1, 1, &shadowSampler);
 
-    // Configurar Buffers y Dibujar (como antes)
-    UINT stride = sizeof(TerrainVertex);
-    UINT offset = 0;
-    context->IASetVertexBuffers(0, 1, m_vertexBuffer.GetAddressOf(), &stride, &offset);
-    context->IASetIndexBuffer(m_indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+    // Configurar Buffers y Dibujar
+    BindVertexStream(context);
     context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-    context->DrawIndexed(m_indexCount, 0, 0);
+    if (m_lodEnabled && m_lodIndexBuffer)
+    {
+        m_lodTree.Select(cameraPositionWorld, vsData.ViewProjection, m_lodSelection);
+        context->IASetIndexBuffer(m_lodIndexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+        DrawLodSelection(context, vsData);
+    }
+    else
+    {
+        UploadVSData(context, vsData);
+        context->IASetIndexBuffer(m_indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+        DrawVisibleChunks(context, vsData.ViewProjection);
+    }
 
     // (Opcional) Desvincular texturas para no afectar otros dibujados
     ID3D11ShaderResourceView* nullSRVs[4] = { nullptr, nullptr, nullptr, nullptr };
     context->PSSetShaderResources(0, 4, nullSRVs);
+    context->PSSetShaderResources(5, 2, nullSRVs);
+    context->VSSetShaderResources(0, 1, nullSRVs);
 }
 
 int Terrain::GetTerrainWidth() const { return m_terrainWidth; }
@@ -446,83 +848,92 @@ void Terrain::UpdateGlobalLighting(
 
 bool Terrain::GetWorldHeightAt(float worldX, float worldZ, float& outHeight) const
 {
-    if (m_heightData.empty() || m_terrainWidth <= 1 || m_terrainHeight <= 1) {
-        return false; // No hay datos de terreno o es demasiado pequeo
+    // Mundo -> rejilla con la inversa XZ de m_worldMatrix (precalculada en SetWorldMatrix) e interpolacin bilineal
+    if (!m_heightSampler.SampleHeight(worldX, worldZ, outHeight)) return false;
+
+    // Con un heightfield paginado, la altura a resolucion completa si su tesela ya esta cargada
+    float streamedHeight;
+    float gridI, gridJ;
+    if (m_heightStreamer && m_heightSampler.WorldToGrid(worldX, worldZ, gridI, gridJ) &&
+        m_heightStreamer->TryGetHeight(gridI * m_heightSampleStride, gridJ * m_heightSampleStride, streamedHeight))
+    {
+        outHeight = m_heightSampler.GridToWorldHeight(gridI, streamedHeight, gridJ);
     }
+    return true;
+}
 
-    // Para transformar de coordenadas del mundo (worldX, worldZ) a coordenadas de la cuadrcula del heightmap (gridI, gridJ)
-    // necesitamos resolver el sistema:
-    // worldX = gridI * m_worldMatrix._11 + gridJ * m_worldMatrix._31 + m_worldMatrix._41 
-    // worldZ = gridI * m_worldMatrix._13 + gridJ * m_worldMatrix._33 + m_worldMatrix._43
-    // (Asumiendo que la componente Y de la posicin local del grid es 0 para este mapeo XZ)
-
-    // Despejamos las componentes de traslacin
-    float tx = worldX - m_worldMatrix._41;
-    float tz = worldZ - m_worldMatrix._43;
-
-    // Coeficientes de la matriz para XZ
-    float m11 = m_worldMatrix._11;
-    float m13 = m_worldMatrix._13; // Corresponde a cmo la J de la cuadrcula afecta a worldX
-    float m31 = m_worldMatrix._31; // Corresponde a cmo la I de la cuadrcula afecta a worldZ
-    float m33 = m_worldMatrix._33;
-
-    // Calculamos el determinante de la submatriz 2x2 de XZ
-    float determinant = m11 * m33 - m31 * m13;
+size_t Terrain::GetWorldHeightsAt(const XMFLOAT2* positions, size_t count, float* outHeights, uint8_t* outValid,
+    XMFLOAT3* outNormals) const
+{
+    size_t validCount = m_heightSampler.SampleHeights(positions, count, outHeights, outValid, outNormals);
 
-    if (abs(determinant) < 0.0001f) { // El determinante es cero o muy pequeo, la matriz no es invertible para XZ
-        return false;
+    // Las teselas a resolucion completa solo mejoran la altura; las normales salen de la malla
+    if (m_heightStreamer)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (outValid[i]) GetWorldHeightAt(positions[i].x, positions[i].y, outHeights[i]);
+        }
     }
+    return validCount;
+}
 
-    float invDeterminant = 1.0f / determinant;
-    float gridI = (tx * m33 - tz * m31) * invDeterminant;
-    float gridJ = (m11 * tz - m13 * tx) * invDeterminant;
-
-    // --- Comprobacin de Lmites ---
-    if (gridI < 0 || gridI >= m_terrainWidth - 1 || gridJ < 0 || gridJ >= m_terrainHeight - 1) {
-        // El punto est fuera de los lmites del heightmap definidos
-        // Puedes devolver una altura por defecto o la altura del borde ms cercano
-        // Por simplicidad, retornamos false indicando que est fuera.
-        return false;
+namespace
+{
+    // Impacto en espacio local -> mundo (la normal con la inversa traspuesta)
+    void HitToWorld(TerrainRayHit& hit, const Matrix& world, const Matrix& worldInverse)
+    {
+        if (!hit.hit) return;
+        Vector3 position = Vector3::Transform(Vector3(hit.position.x, hit.position.y, hit.position.z), world);
+        Vector3 normal = Vector3::TransformNormal(Vector3(hit.normal.x, hit.normal.y, hit.normal.z), worldInverse.Transpose());
+        normal.Normalize();
+        hit.position = XMFLOAT3(position.x, position.y, position.z);
+        hit.normal = XMFLOAT3(normal.x, normal.y, normal.z);
     }
 
-    // --- Interpolacin Bilineal ---
-    int x0 = static_cast<int>(floor(gridI));
-    int z0 = static_cast<int>(floor(gridJ)); // Usamos z0 para la dimensin J de la cuadrcula
-
-    // Asegurarnos de no salirnos de los lmites al acceder a x0+1, z0+1
-    int x1 = std::min(x0 + 1, m_terrainWidth - 1);
-    int z1 = std::min(z0 + 1, m_terrainHeight - 1);
-
-    // Fracciones para la interpolacin
-    float fracI = gridI - x0;
-    float fracJ = gridJ - z0;
+    // La transformacion es afin, asi que t no cambia al pasar el rayo a espacio local
+    TerrainRay RayToLocal(const TerrainRay& worldRay, const Matrix& worldInverse)
+    {
+        TerrainRay localRay;
+        Vector3 origin = Vector3::Transform(Vector3(worldRay.origin.x, worldRay.origin.y, worldRay.origin.z), worldInverse);
+        Vector3 direction = Vector3::TransformNormal(Vector3(worldRay.direction.x, worldRay.direction.y, worldRay.direction.z), worldInverse);
+        localRay.origin = XMFLOAT3(origin.x, origin.y, origin.z);
+        localRay.direction = XMFLOAT3(direction.x, direction.y, direction.z);
+        localRay.maxT = worldRay.maxT;
+        return localRay;
+    }
+}
 
-    // Obtener las alturas normalizadas (0-1) de los 4 puntos de la cuadrcula circundantes
-    float h00 = m_heightData[z0 * m_terrainWidth + x0];
-    float h10 = m_heightData[z0 * m_terrainWidth + x1]; // Altura en (x0+1, z0)
-    float h01 = m_heightData[z1 * m_terrainWidth + x0]; // Altura en (x0, z0+1)
-    float h11 = m_heightData[z1 * m_terrainWidth + x1]; // Altura en (x0+1, z0+1)
+bool Terrain::RaycastWorld(const Vector3& origin, const Vector3& direction, float maxDistance, TerrainRayHit& outHit) const
+{
+    outHit = TerrainRayHit();
+    float directionLength = direction.Length();
+    if (!m_raycaster.IsBuilt() || directionLength <= 0.0f) return false;
 
-    // Interpolar en I (o X de la cuadrcula)
-    float interpBottom = Lerp(h00, h10, fracI);
-    float interpTop = Lerp(h01, h11, fracI);
+    TerrainRay worldRay;
+    worldRay.origin = XMFLOAT3(origin.x, origin.y, origin.z);
+    worldRay.direction = XMFLOAT3(direction.x, direction.y, direction.z);
+    worldRay.maxT = maxDistance / directionLength;
+    if (!m_raycaster.Raycast(RayToLocal(worldRay, m_worldInverse), outHit)) return false;
 
-    // Interpolar en J (o Z de la cuadrcula)
-    float interpolatedNormalizedHeight = Lerp(interpBottom, interpTop, fracJ); // Altura normalizada (0-1)
+    HitToWorld(outHit, m_worldMatrix, m_worldInverse);
+    return true;
+}
 
-    // --- Aplicar m_heightScale y la transformacin Y de la matriz del mundo ---
-    // Esta es la altura Y en el espacio local del mesh del terreno, despus de m_heightScale
-    float localScaledHeightY = interpolatedNormalizedHeight * m_heightScale;
+size_t Terrain::RaycastWorldBatch(const TerrainRay* worldRays, size_t count, TerrainRayHit* outHits) const
+{
+    if (!m_raycaster.IsBuilt())
+    {
+        for (size_t i = 0; i < count; ++i) outHits[i] = TerrainRayHit();
+        return 0;
+    }
 
-    // Ahora, transformamos esta altura Y al espacio del mundo usando la matriz del mundo.
-    // La altura final Y = gridI_original * M._12 + localScaledHeightY * M._22 + gridJ_original * M._32 + M._42
-    // Donde gridI y gridJ son las coordenadas locales que ya calculamos.
-    outHeight = gridI * m_worldMatrix._12 +
-        localScaledHeightY * m_worldMatrix._22 +
-        gridJ * m_worldMatrix._32 +
-        m_worldMatrix._42;
+    std::vector<TerrainRay> localRays(count);
+    for (size_t i = 0; i < count; ++i) localRays[i] = RayToLocal(worldRays[i], m_worldInverse);
 
-    return true;
+    size_t hitCount = m_raycaster.RaycastBatch(localRays.data(), count, outHits, m_threadPool);
+    for (size_t i = 0; i < count; ++i) HitToWorld(outHits[i], m_worldMatrix, m_worldInverse);
+    return hitCount;
 }
 
 void Terrain::ShadowDraw(
@@ -532,6 +943,12 @@ void Terrain::ShadowDraw(
 {
     // Asegurarse de que los recursos necesarios para el dibujado de sombras existan.
     // Para el terreno, solo necesitamos su vertex buffer, index buffer y el cbuffer del VS.
+    if (m_vertexStream != TerrainVertexStream::Full)
+    {
+        ShadowDrawCompact(context, lightViewMatrix * lightProjectionMatrix);
+        return;
+    }
+
     if (!m_vertexBuffer || !m_indexBuffer || !m_cbVS_ShadowPass)
     {
         return;
@@ -561,5 +978,193 @@ void Terrain::ShadowDraw(
     context->IASetIndexBuffer(m_indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
     context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-    context->DrawIndexed(m_indexCount, 0, 0);
+    DrawVisibleChunks(context, lightViewMatrix * lightProjectionMatrix);
+}
+
+void Terrain::ShadowDrawCompact(ID3D11DeviceContext* context, const Matrix& lightViewProjection)
+{
+    if (!m_indexBuffer || !m_terrainShadowVS || !m_cbVSTerrainData || !m_heightBufferSRV) return;
+
+    // Sin POSITION en el vertex buffer: VS propio que lee las alturas, con la luz como ViewProjection
+    CBTerrainVSData vsData = {};
+    vsData.World = m_worldMatrix;
+    vsData.ViewProjection = lightViewProjection;
+    vsData.LightViewProjection = lightViewProjection;
+    vsData.WorldInverseTranspose = m_worldMatrix.Invert().Transpose();
+    vsData.maxTerrainHeightLocal = m_heightScale;
+    vsData.lodStep = 1.0f;
+    vsData.gridMaxX = static_cast<float>(m_terrainWidth - 1);
+    vsData.gridMaxZ = static_cast<float>(m_terrainHeight - 1);
+    vsData.heightmapWidth = static_cast<float>(m_terrainWidth);
+    vsData.textureTiling = m_textureTilingFactor;
+    UploadVSData(context, vsData);
+
+    context->VSSetShader(m_terrainShadowVS.Get(), nullptr, 0);
+    context->VSSetConstantBuffers(0, 1, m_cbVSTerrainData.GetAddressOf());
+    context->VSSetShaderResources(0, 1, m_heightBufferSRV.GetAddressOf());
+    context->IASetInputLayout(nullptr);
+    ID3D11Buffer* nullBuffer = nullptr;
+    UINT stride = 0;
+    UINT offset = 0;
+    context->IASetVertexBuffers(0, 1, &nullBuffer, &stride, &offset);
+    context->IASetIndexBuffer(m_indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+    context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+    DrawVisibleChunks(context, lightViewProjection);
+
+    ID3D11ShaderResourceView* nullSRV = nullptr;
+    context->VSSetShaderResources(0, 1, &nullSRV);
+}
+
+void Terrain::BindVertexStream(ID3D11DeviceContext* context)
+{
+    UINT offset = 0;
+    switch (m_vertexStream)
+    {
+    case TerrainVertexStream::Full:
+    {
+        UINT stride = sizeof(TerrainVertex);
+        context->IASetInputLayout(m_inputLayout.Get());
+        context->IASetVertexBuffers(0, 1, m_vertexBuffer.GetAddressOf(), &stride, &offset);
+        break;
+    }
+    case TerrainVertexStream::CompactPackedNormal:
+    {
+        UINT stride = sizeof(TerrainPackedNormal);
+        context->IASetInputLayout(m_inputLayout.Get());
+        context->IASetVertexBuffers(0, 1, m_vertexBuffer.GetAddressOf(), &stride, &offset);
+        break;
+    }
+    case TerrainVertexStream::Compact:
+    {
+        // Todo sale de SV_VertexID y de HeightData
+        ID3D11Buffer* nullBuffer = nullptr;
+        UINT stride = 0;
+        context->IASetInputLayout(nullptr);
+        context->IASetVertexBuffers(0, 1, &nullBuffer, &stride, &offset);
+        break;
+    }
+    }
+}
+
+void Terrain::DrawVisibleChunks(ID3D11DeviceContext* context, const Matrix& viewProjection)
+{
+    // Solo los trozos dentro del frustum de esta pasada; los contiguos salen en un mismo DrawIndexed
+    m_lastVisibleChunks = static_cast<int>(m_chunkGrid.CullAndBuildRanges(viewProjection, m_drawRanges));
+    m_lastDrawnTriangles = 0;
+    for (const TerrainDrawRange& range : m_drawRanges)
+    {
+        context->DrawIndexed(range.indexCount, range.indexStart, 0);
+        m_lastDrawnTriangles += static_cast<int>(range.indexCount / 3);
+    }
+}
+
+void Terrain::DrawLodSelection(ID3D11DeviceContext* context, CBTerrainVSData& vsData)
+{
+    // Agrupado por nivel: los parametros de morph solo cambian una vez por nivel
+    const std::vector<TerrainLodNode>& nodes = m_lodTree.GetNodes();
+    m_lastVisibleChunks = static_cast<int>(m_lodSelection.size());
+    m_lastDrawnTriangles = 0;
+
+    for (int level = 0; level < m_lodTree.GetLevelCount(); ++level)
+    {
+        bool levelUploaded = false;
+        for (const TerrainLodSelection& selection : m_lodSelection)
+        {
+            if (selection.level != level) continue;
+
+            if (!levelUploaded)
+            {
+                m_lodTree.GetMorphParameters(level, vsData.morphStart, vsData.morphInvRange);
+                vsData.lodStep = static_cast<float>(1 << level);
+                UploadVSData(context, vsData);
+                levelUploaded = true;
+            }
+
+            // Los cuadrantes de un nodo estan seguidos: los consecutivos van en el mismo DrawIndexed
+            const TerrainLodNode& node = nodes[selection.node];
+            uint32_t runStart = 0;
+            uint32_t runCount = 0;
+            for (int quadrant = 0; quadrant < 4; ++quadrant)
+            {
+                if (!(selection.quadrantMask & (1 << quadrant)) || node.quadrantCount[quadrant] == 0) continue;
+
+                if (runCount > 0 && runStart + runCount == node.quadrantStart[quadrant])
+                {
+                    runCount += node.quadrantCount[quadrant];
+                    continue;
+                }
+                if (runCount > 0) context->DrawIndexed(runCount, runStart, 0);
+                m_lastDrawnTriangles += static_cast<int>(runCount / 3);
+                runStart = node.quadrantStart[quadrant];
+                runCount = node.quadrantCount[quadrant];
+            }
+            if (runCount > 0) context->DrawIndexed(runCount, runStart, 0);
+            m_lastDrawnTriangles += static_cast<int>(runCount / 3);
+        }
+    }
+}
+
+void Terrain::UploadVSData(ID3D11DeviceContext* context, const CBTerrainVSData& vsData)
+{
+    D3D11_MAPPED_SUBRESOURCE mappedResourceVS;
+    if (FAILED(context->Map(m_cbVSTerrainData.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResourceVS))) return;
+    memcpy(mappedResourceVS.pData, &vsData, sizeof(CBTerrainVSData));
+    context->Unmap(m_cbVSTerrainData.Get(), 0);
+}
+
+void Terrain::SetLodViewport(float viewportHeight, float fieldOfViewY)
+{
+    m_lodViewportHeight = viewportHeight;
+    m_lodFieldOfView = fieldOfViewY;
+    UpdateLodRanges();
+}
+
+void Terrain::UpdateLodRanges()
+{
+    // El error de cada nivel depende de las alturas y de la matriz de mundo; el de pantalla, de la camara.
+    // En mapas de 8 bits con escalones el rango puede salirse del mapa y todo queda en el nivel 0.
+    if (m_lodTree.GetLevelCount() == 0) return;
+    m_lodTree.SetLodRanges(m_lodTree.ComputeLevel0Range(LOD_MAX_PIXEL_ERROR, m_lodViewportHeight, m_lodFieldOfView, LOD_MORPH_START_RATIO),
+        LOD_MORPH_START_RATIO);
+}
+
+void Terrain::LogLodReport()
+{
+    if (m_lodTree.GetNodes().empty()) return;
+
+    // Camara en el centro del mapa, 50 unidades sobre el terreno, mirando en horizontal;
+    // solo cambia la distancia del plano lejano
+    const TerrainLodNode& root = m_lodTree.GetNodes()[0];
+    Vector3 center = (Vector3(root.worldMin) + Vector3(root.worldMax)) * 0.5f;
+    float groundHeight = center.y;
+    GetWorldHeightAt(center.x, center.z, groundHeight);
+    Vector3 eye(center.x, groundHeight + 50.0f, center.z);
+    Matrix view = Matrix::CreateLookAt(eye, eye + Vector3::UnitX, Vector3::Up);
+
+    const float viewDistances[] = { 250.0f, 500.0f, 1000.0f, 2000.0f, 5000.0f };
+    const int iterations = 1000;
+    wchar_t line[256];
+    swprintf_s(line, L"Terrain LOD: rango del nivel 0 %.0f para %.0f px de error\n", m_lodTree.GetLevelRange(0), LOD_MAX_PIXEL_ERROR);
+    OutputDebugString(line);
+    OutputDebugString(L"Terrain LOD: distancia | triangulos LOD | triangulos trozos | seleccion (us)\n");
+    for (float viewDistance : viewDistances)
+    {
+        Matrix viewProjection = view * Matrix::CreatePerspectiveFieldOfView(XM_PIDIV4, 16.0f / 9.0f, 0.1f, viewDistance);
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i)
+        {
+            m_lodTree.Select(eye, viewProjection, m_lodSelection);
+        }
+        double selectUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / iterations;
+
+        size_t lodTriangles = TerrainLodTree::CountSelectedIndices(m_lodSelection, m_lodTree.GetNodes()) / 3;
+        m_chunkGrid.CullAndBuildRanges(viewProjection, m_drawRanges);
+        size_t chunkTriangles = 0;
+        for (const TerrainDrawRange& range : m_drawRanges) chunkTriangles += range.indexCount / 3;
+
+        swprintf_s(line, L"  %6.0f | %7zu | %7zu | %.2f\n", viewDistance, lodTriangles, chunkTriangles, selectUs);
+        OutputDebugString(line);
+    }
 }
\ No newline at end of file
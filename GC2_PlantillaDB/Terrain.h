@@ -8,10 +8,30 @@
 #include <VertexTypes.h>
 #include <Effects.h>
 #include "Model.h"
+#include "ShaderRegistry.h"
+#include "TerrainChunks.h"
+#include "TerrainLod.h"
+#include "HeightfieldStreamer.h"
+#include "TerrainMeshBuilder.h"
+#include "TerrainHeightSampler.h"
+#include "TerrainRaycaster.h"
+#include "TerrainSplatBaker.h"
+#include "TerrainHorizonBaker.h"
+#include "TerrainCapsuleSweep.h"
+
+class ThreadPool;
 
 // Estructura de vrtice para el terreno (puedes expandirla despus)
 using TerrainVertex = DirectX::VertexPositionNormalTexture;
 
+// Que guarda la GPU por vertice del terreno
+enum class TerrainVertexStream
+{
+    Full,                // VertexPositionNormalTexture (32 bytes) + alturas R32_FLOAT para el morph
+    Compact,             // Sin vertex buffer: alturas R16_UNORM (2 bytes); posicion/UV desde SV_VertexID, normal en el shader
+    CompactPackedNormal  // Como Compact + normal x/z en R8G8_SNORM (4 bytes en total)
+};
+
 struct CBTerrainPSMaterialData
 {
     // Control de Altura
@@ -35,8 +55,9 @@ public:
         const wchar_t* textureFilename1, 
         const wchar_t* textureFilename2, 
         const wchar_t* textureFilename3, 
-        const wchar_t* terrainVS_path,   
-        const wchar_t* terrainPS_path);
+        ShaderRegistry& shaderRegistry,
+        const wchar_t* terrainVS_name,
+        const wchar_t* terrainPS_name);
 
     void Render(ID3D11DeviceContext* context,
         ID3D11Buffer* lightPropertiesCB,
@@ -54,7 +75,15 @@ public:
         DirectX::SimpleMath::Matrix LightViewProjection;
         DirectX::SimpleMath::Matrix WorldInverseTranspose;
         float maxTerrainHeightLocal;
-        DirectX::SimpleMath::Vector3 padding;
+        float morphStart;     // LOD continuo (ver TerrainVS.hlsl)
+        float morphInvRange;  // 0 = sin morph
+        float lodStep;
+        DirectX::SimpleMath::Vector3 cameraPosition;
+        float gridMaxX;
+        float gridMaxZ;
+        float heightmapWidth;
+        float textureTiling;
+        float padding;
     };
 
 
@@ -72,17 +101,96 @@ public:
     );
 
     bool GetWorldHeightAt(float worldX, float worldZ, float& outHeight) const;
+
+    // Varias consultas a la vez (x, z de mundo) con SIMD; outNormals es opcional.
+    // outValid[i] = 0 si el punto cae fuera del terreno. Devuelve cuantos puntos son validos.
+    size_t GetWorldHeightsAt(const DirectX::XMFLOAT2* positions, size_t count, float* outHeights, uint8_t* outValid,
+        DirectX::XMFLOAT3* outNormals = nullptr) const;
+    const TerrainHeightSampler& GetHeightSampler() const { return m_heightSampler; }
+
+    // Rayo de mundo contra la malla del terreno (quadtree min-max). Con la direccion normalizada,
+    // t y maxDistance son distancias de mundo. El impacto se devuelve en mundo.
+    bool RaycastWorld(const DirectX::SimpleMath::Vector3& origin, const DirectX::SimpleMath::Vector3& direction,
+        float maxDistance, TerrainRayHit& outHit) const;
+    // Lote de rayos de mundo (maxT en unidades de la direccion), repartido en el pool si hay uno.
+    size_t RaycastWorldBatch(const TerrainRay* worldRays, size_t count, TerrainRayHit* outHits) const;
+    const DirectX::SimpleMath::Matrix& GetWorldMatrix() const { return m_worldMatrix; }
+
+    // Barrido de capsulas de mundo contra la malla del terreno (movimiento del jugador/camara).
+    const TerrainCapsuleSweep& GetCapsuleSweep() const { return m_capsuleSweep; }
+
+    // Malla gruesa (espacio local) para el culling por oclusion. Cada vertice toma la
+    // altura minima de su vecindario, asi que nunca sobresale del terreno real.
+    const std::vector<DirectX::SimpleMath::Vector3>& GetOccluderPositions() const { return m_occluderPositions; }
+    const std::vector<uint32_t>& GetOccluderIndices() const { return m_occluderIndices; }
+
     void ShadowDraw(
+
         ID3D11DeviceContext* context,
         const DirectX::SimpleMath::Matrix& lightViewMatrix,
         const DirectX::SimpleMath::Matrix& lightProjectionMatrix
     );
 
+    // Trozos del terreno (AABB en mundo) y cuantos pasaron el culling en la ultima pasada dibujada
+    const TerrainChunkGrid& GetChunkGrid() const { return m_chunkGrid; }
+    int GetLastVisibleChunkCount() const { return m_lastVisibleChunks; }
+
+    // LOD continuo (CDLOD) en Render; sin el, se dibujan los trozos a resolucion completa.
+    // La pasada de sombras siempre usa los trozos completos.
+    void SetLodEnabled(bool enabled) { m_lodEnabled = enabled; }
+    bool IsLodEnabled() const { return m_lodEnabled; }
+    const TerrainLodTree& GetLodTree() const { return m_lodTree; }
+    // Altura del viewport en pixeles y campo de vision vertical de la camara: con LOD_MAX_PIXEL_ERROR
+    // deciden el rango del nivel 0 (ver TerrainLodTree::ComputeLevel0Range).
+    void SetLodViewport(float viewportHeight, float fieldOfViewY);
+    int GetLastDrawnTriangleCount() const { return m_lastDrawnTriangles; }
+
+    // Heightfield paginado (.hfp) mayor que la malla: carga las teselas a resolucion completa
+    // alrededor de la camara para GetWorldHeightAt. No hace nada con heightmaps normales.
+    void UpdateHeightStreaming(const DirectX::SimpleMath::Vector3& cameraPositionWorld);
+    const HeightfieldStreamer* GetHeightStreamer() const { return m_heightStreamer.get(); }
+
+    // Formato de vertice; hay que elegirlo antes de Initialize.
+    void SetVertexStream(TerrainVertexStream stream) { m_vertexStream = stream; }
+    TerrainVertexStream GetVertexStream() const { return m_vertexStream; }
+
+    // Autosombra del terreno con mapas de horizonte (TerrainHorizonBaker) en lugar del shadow map.
+    // Activado, el terreno no hace falta en la pasada de sombras (ver Game::RenderShadowPass).
+    void SetHorizonShadows(bool enabled) { m_horizonShadows = enabled; }
+    bool UsesHorizonShadows() const { return m_horizonShadows; }
+
+    // Pool para construir la malla en paralelo (antes de Initialize); nullptr = un solo hilo.
+    void SetThreadPool(ThreadPool* pool) { m_threadPool = pool; }
+
+    static const int MAX_MESH_SAMPLES = 2049; // Lado maximo de la malla del terreno
+    static constexpr float HEIGHT_STREAMING_RADIUS = 1024.0f; // En muestras del heightfield
+    static const size_t HEIGHT_STREAMING_BUDGET_BYTES = 64ull * 1024 * 1024;
+
+    // Escribe en la salida de depuracion triangulos y tiempo de seleccion frente a la distancia de vision.
+    void LogLodReport();
+
+    static constexpr float LOD_MAX_PIXEL_ERROR = 2.0f; // Error vertical maximo de un nivel grueso en pantalla
+    static constexpr float LOD_MORPH_START_RATIO = 0.7f;
+
+    static const int CHUNK_CELLS = 32; // Celdas por lado de cada trozo (8x8 trozos con heightmap1)
+
 private:
     bool LoadHeightmap(ID3D11Device* device, ID3D11DeviceContext* context, const wchar_t* filename);
-    void CalculateNormals();
+    bool LoadHeightmapPages(const wchar_t* filename);
+    bool SetHeightData(const std::vector<float>& heights, int width, int height);
     bool InitializeBuffers(ID3D11Device* device);
+    void BuildOccluderMesh(int step);
+    void DrawVisibleChunks(ID3D11DeviceContext* context, const DirectX::SimpleMath::Matrix& viewProjection);
+    void DrawLodSelection(ID3D11DeviceContext* context, CBTerrainVSData& vsData);
+    void UpdateLodRanges();
+    void UploadVSData(ID3D11DeviceContext* context, const CBTerrainVSData& vsData);
+    void BindVertexStream(ID3D11DeviceContext* context);
+    void ShadowDrawCompact(ID3D11DeviceContext* context, const DirectX::SimpleMath::Matrix& lightViewProjection);
+    bool CreateHeightBuffer(ID3D11Device* device);
     bool LoadTexture(ID3D11Device* device, const wchar_t* filename, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>& textureSRV);
+    bool CreateSplatMap(ID3D11Device* device);
+    bool BakeHorizonMap(ID3D11DeviceContext* context);
+    void BakeSplatMap(std::vector<uint32_t>& texels) const;
     float m_textureTilingFactor;
 
     int m_terrainWidth;
@@ -94,9 +202,38 @@ private:
     int m_vertexCount;
     int m_indexCount;
 
+    std::unique_ptr<HeightfieldStreamer> m_heightStreamer;
+    int m_heightSampleStride; // Muestras del heightfield original entre dos vertices de la malla
+
     std::vector<float> m_heightData; // Almacenar los valores de altura
     std::vector<TerrainVertex> m_vertices;
-    std::vector<unsigned long> m_indices;
+    TerrainHeightSampler m_heightSampler; // Sobre m_heightData con la inversa de m_worldMatrix precalculada
+    TerrainRaycaster m_raycaster;         // Piramide min-max de m_heightData en espacio local
+    TerrainCapsuleSweep m_capsuleSweep;   // m_heightData en mundo; la rejilla se fija en SetWorldMatrix
+    ThreadPool* m_threadPool;
+    TerrainVertexStream m_vertexStream;
+
+    // Indices agrupados por trozo; un solo index buffer para todas las pasadas
+    TerrainChunkGrid m_chunkGrid;
+    std::vector<TerrainDrawRange> m_drawRanges;
+    int m_lastVisibleChunks;
+
+    // Quadtree del LOD continuo con su propio index buffer sobre el mismo vertex buffer
+    TerrainLodTree m_lodTree;
+    Microsoft::WRL::ComPtr<ID3D11Buffer> m_lodIndexBuffer;
+    std::vector<TerrainLodSelection> m_lodSelection;
+    bool m_lodEnabled;
+    float m_lodViewportHeight;
+    float m_lodFieldOfView;
+    int m_lastDrawnTriangles;
+
+    // Alturas del heightmap para el vertex shader (el morph recalcula la altura)
+    Microsoft::WRL::ComPtr<ID3D11Buffer> m_heightBuffer;
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_heightBufferSRV;
+
+    std::vector<DirectX::SimpleMath::Vector3> m_occluderPositions;
+    std::vector<uint32_t> m_occluderIndices;
+
 
     // Recursos para el renderizado (empezaremos con BasicEffect)
     std::unique_ptr<DirectX::BasicEffect> m_effect;
@@ -105,19 +242,33 @@ private:
     Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_textureSRV2; 
     Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_textureSRV3;
     Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_textureSRV_Rock;
+
+    // Pesos de las cuatro capas por vertice (RGBA8), horneados en CPU con m_terrainMaterialData.
+    // La pendiente depende de la matriz de mundo: SetWorldMatrix marca el mapa para rehornearlo en Render.
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> m_splatTexture;
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_splatSRV;
+    bool m_splatDirty;
+
+    // Horizonte por azimut (Texture2DArray R8, un corte por azimut). Depende de la escala de mundo,
+    // asi que se hornea (o rehornea) en el primer Render tras SetWorldMatrix.
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> m_horizonTexture;
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_horizonSRV;
+    bool m_horizonShadows;
+    bool m_horizonDirty;
     Microsoft::WRL::ComPtr<ID3D11Buffer> m_cbVSTerrainData;
 
     Microsoft::WRL::ComPtr<ID3D11InputLayout> m_inputLayout;
 
     DirectX::SimpleMath::Matrix m_worldMatrix;
+    DirectX::SimpleMath::Matrix m_worldInverse; // Para pasar rayos de mundo a espacio local
     DirectX::SimpleMath::Matrix m_viewMatrix;       
     DirectX::SimpleMath::Matrix m_projectionMatrix; 
 
     Microsoft::WRL::ComPtr<ID3D11VertexShader> m_terrainVS;
     Microsoft::WRL::ComPtr<ID3D11PixelShader>  m_terrainPS;
+    Microsoft::WRL::ComPtr<ID3D11VertexShader> m_terrainShadowVS; // Solo en modo compacto (sin POSITION)
 
     Microsoft::WRL::ComPtr<ID3D11Buffer> m_cbVS_ShadowPass;
 
-    Microsoft::WRL::ComPtr<ID3D11Buffer> m_cbPSTerrainMaterial; 
-    CBTerrainPSMaterialData m_terrainMaterialData;
+    CBTerrainPSMaterialData m_terrainMaterialData; // Solo para hornear el splat map
 };
\ No newline at end of file
@@ -0,0 +1,373 @@
+#include "TerrainCapsuleSweep.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+    struct Vec3
+    {
+        float x, y, z;
+    };
+
+    Vec3 operator+(const Vec3& a, const Vec3& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+    Vec3 operator-(const Vec3& a, const Vec3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+    Vec3 operator*(const Vec3& a, float s) { return { a.x * s, a.y * s, a.z * s }; }
+    float Dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    Vec3 Cross(const Vec3& a, const Vec3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+    float Clamp01(float v) { return std::min(std::max(v, 0.0f), 1.0f); }
+    Vec3 ToVec3(const XMFLOAT3& v) { return { v.x, v.y, v.z }; }
+    XMFLOAT3 ToFloat3(const Vec3& v) { return XMFLOAT3(v.x, v.y, v.z); }
+
+    // Punto del triangulo abc mas cercano a p (Ericson, Real-Time Collision Detection 5.1.5)
+    Vec3 ClosestPointOnTriangle(const Vec3& p, const Vec3& a, const Vec3& b, const Vec3& c)
+    {
+        Vec3 ab = b - a;
+        Vec3 ac = c - a;
+        Vec3 ap = p - a;
+        float d1 = Dot(ab, ap);
+        float d2 = Dot(ac, ap);
+        if (d1 <= 0.0f && d2 <= 0.0f) return a;
+
+        Vec3 bp = p - b;
+        float d3 = Dot(ab, bp);
+        float d4 = Dot(ac, bp);
+        if (d3 >= 0.0f && d4 <= d3) return b;
+
+        float vc = d1 * d4 - d3 * d2;
+        if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) return a + ab * (d1 / (d1 - d3));
+
+        Vec3 cp = p - c;
+        float d5 = Dot(ab, cp);
+        float d6 = Dot(ac, cp);
+        if (d6 >= 0.0f && d5 <= d6) return c;
+
+        float vb = d5 * d2 - d1 * d6;
+        if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) return a + ac * (d2 / (d2 - d6));
+
+        float va = d3 * d6 - d5 * d4;
+        if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+        float denominator = 1.0f / (va + vb + vc);
+        return a + ab * (vb * denominator) + ac * (vc * denominator);
+    }
+
+    // Puntos mas cercanos entre los segmentos p1q1 y p2q2 (Ericson 5.1.9)
+    void ClosestPointsSegmentSegment(const Vec3& p1, const Vec3& q1, const Vec3& p2, const Vec3& q2, Vec3& outOn1, Vec3& outOn2)
+    {
+        const float epsilon = 1.0e-12f;
+        Vec3 d1 = q1 - p1;
+        Vec3 d2 = q2 - p2;
+        Vec3 r = p1 - p2;
+        float a = Dot(d1, d1);
+        float e = Dot(d2, d2);
+        float f = Dot(d2, r);
+        float s;
+        float t;
+
+        if (a <= epsilon && e <= epsilon)
+        {
+            s = t = 0.0f;
+        }
+        else if (a <= epsilon)
+        {
+            s = 0.0f;
+            t = Clamp01(f / e);
+        }
+        else
+        {
+            float c = Dot(d1, r);
+            if (e <= epsilon)
+            {
+                t = 0.0f;
+                s = Clamp01(-c / a);
+            }
+            else
+            {
+                float b = Dot(d1, d2);
+                float denominator = a * e - b * b;
+                s = denominator > epsilon ? Clamp01((b * f - c * e) / denominator) : 0.0f;
+                t = (b * s + f) / e;
+                if (t < 0.0f)
+                {
+                    t = 0.0f;
+                    s = Clamp01(-c / a);
+                }
+                else if (t > 1.0f)
+                {
+                    t = 1.0f;
+                    s = Clamp01((b - c) / a);
+                }
+            }
+        }
+        outOn1 = p1 + d1 * s;
+        outOn2 = p2 + d2 * t;
+    }
+
+    struct ClosestPair
+    {
+        float distanceSquared;
+        Vec3 onSegment;
+        Vec3 onTriangle;
+    };
+
+    // Distancia entre el segmento pq y el triangulo abc
+    ClosestPair SegmentTriangle(const Vec3& p, const Vec3& q, const Vec3& a, const Vec3& b, const Vec3& c)
+    {
+        // El segmento atraviesa el triangulo: distancia 0
+        Vec3 direction = q - p;
+        Vec3 edge1 = b - a;
+        Vec3 edge2 = c - a;
+        Vec3 pvec = Cross(direction, edge2);
+        float determinant = Dot(edge1, pvec);
+        if (std::fabs(determinant) > 1.0e-12f)
+        {
+            float invDeterminant = 1.0f / determinant;
+            Vec3 tvec = p - a;
+            float u = Dot(tvec, pvec) * invDeterminant;
+            Vec3 qvec = Cross(tvec, edge1);
+            float v = Dot(direction, qvec) * invDeterminant;
+            float t = Dot(edge2, qvec) * invDeterminant;
+            if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t >= 0.0f && t <= 1.0f)
+            {
+                Vec3 point = p + direction * t;
+                return { 0.0f, point, point };
+            }
+        }
+
+        // Si no, el minimo esta en un extremo del segmento o entre el segmento y una arista
+        ClosestPair best;
+        auto consider = [&best](const Vec3& onSegment, const Vec3& onTriangle)
+        {
+            Vec3 delta = onSegment - onTriangle;
+            float distanceSquared = Dot(delta, delta);
+            if (distanceSquared < best.distanceSquared) best = { distanceSquared, onSegment, onTriangle };
+        };
+        best.distanceSquared = 3.4e38f;
+        consider(p, ClosestPointOnTriangle(p, a, b, c));
+        consider(q, ClosestPointOnTriangle(q, a, b, c));
+
+        const Vec3 edges[3][2] = { { a, b }, { b, c }, { c, a } };
+        for (const auto& edge : edges)
+        {
+            Vec3 onSegment;
+            Vec3 onEdge;
+            ClosestPointsSegmentSegment(p, q, edge[0], edge[1], onSegment, onEdge);
+            consider(onSegment, onEdge);
+        }
+        return best;
+    }
+
+    Vec3 UpFacingNormal(const Vec3& a, const Vec3& b, const Vec3& c)
+    {
+        Vec3 normal = Cross(c - a, b - a);
+        if (normal.y < 0.0f) normal = normal * -1.0f;
+        float length = std::sqrt(Dot(normal, normal));
+        return length > 0.0f ? normal * (1.0f / length) : Vec3{ 0.0f, 1.0f, 0.0f };
+    }
+
+    // Primer contacto de la capsula que se traslada con un triangulo, en [0, maxT].
+    // La distancia es convexa en t, asi que el paso de Newton desde la izquierda nunca se pasa
+    // y, si deja de disminuir, ya no disminuira mas adelante.
+    bool SweepTriangle(const Vec3& base, float capsuleHeight, float radius, const Vec3& displacement,
+        const Vec3& a, const Vec3& b, const Vec3& c, float maxT, TerrainSweepHit& outHit)
+    {
+        const float tolerance = TerrainCapsuleSweep::CONTACT_TOLERANCE;
+        const float displacementLength = std::sqrt(Dot(displacement, displacement));
+        float t = 0.0f;
+
+        for (int iteration = 0; iteration < 32; ++iteration)
+        {
+            Vec3 p = base + displacement * t;
+            Vec3 q = { p.x, p.y + capsuleHeight, p.z };
+            ClosestPair closest = SegmentTriangle(p, q, a, b, c);
+            float distance = std::sqrt(closest.distanceSquared);
+
+            Vec3 normal = distance > 1.0e-6f ? (closest.onSegment - closest.onTriangle) * (1.0f / distance) : UpFacingNormal(a, b, c);
+            if (t == 0.0f && distance < radius - tolerance)
+            {
+                outHit.hit = true;
+                outHit.t = 0.0f;
+                outHit.penetration = radius - distance;
+                outHit.normal = ToFloat3(normal);
+                outHit.point = ToFloat3(closest.onTriangle);
+                return true;
+            }
+
+            float closingSpeed = -Dot(normal, displacement);
+            if (closingSpeed <= 1.0e-6f * displacementLength) return false; // Se aleja o va en paralelo
+
+            if (distance <= radius + tolerance)
+            {
+                outHit.hit = true;
+                outHit.t = t;
+                outHit.penetration = 0.0f;
+                outHit.normal = ToFloat3(normal);
+                outHit.point = ToFloat3(closest.onTriangle);
+                return true;
+            }
+
+            t += (distance - radius) / closingSpeed;
+            if (t > maxT) return false;
+        }
+
+        // Sin converger: se informa del t alcanzado, que nunca esta detras del contacto real
+        Vec3 p = base + displacement * t;
+        ClosestPair closest = SegmentTriangle(p, { p.x, p.y + capsuleHeight, p.z }, a, b, c);
+        float distance = std::sqrt(closest.distanceSquared);
+        outHit.hit = true;
+        outHit.t = t;
+        outHit.penetration = 0.0f;
+        outHit.normal = ToFloat3(distance > 1.0e-6f ? (closest.onSegment - closest.onTriangle) * (1.0f / distance) : UpFacingNormal(a, b, c));
+        outHit.point = ToFloat3(closest.onTriangle);
+        return true;
+    }
+
+}
+
+TerrainCapsuleSweep::TerrainCapsuleSweep()
+{
+}
+
+XMFLOAT3 TerrainCapsuleSweep::GetVertex(int i, int j) const
+{
+    return XMFLOAT3(m_grid.originX + i * m_grid.cellSizeX,
+        m_grid.originY + m_grid.heights[static_cast<size_t>(j) * m_grid.width + i] * m_grid.heightScale,
+        m_grid.originZ + j * m_grid.cellSizeZ);
+}
+
+bool TerrainCapsuleSweep::GetCellRange(const TerrainCapsule& capsule, const XMFLOAT3& displacement,
+    int& firstX, int& lastX, int& firstZ, int& lastZ, float& minY, float& maxY) const
+{
+    // Caja de la capsula en todo el barrido
+    float minX = std::min(capsule.base.x, capsule.base.x + displacement.x) - capsule.radius;
+    float maxX = std::max(capsule.base.x, capsule.base.x + displacement.x) + capsule.radius;
+    float minZ = std::min(capsule.base.z, capsule.base.z + displacement.z) - capsule.radius;
+    float maxZ = std::max(capsule.base.z, capsule.base.z + displacement.z) + capsule.radius;
+    minY = std::min(capsule.base.y, capsule.base.y + displacement.y) - capsule.radius;
+    maxY = std::max(capsule.base.y, capsule.base.y + displacement.y) + capsule.height + capsule.radius;
+
+    // Celdas (en coordenadas de rejilla) que toca la caja; fuera del heightfield no hay suelo
+    const int cellsX = m_grid.width - 1;
+    const int cellsZ = m_grid.height - 1;
+    float gridMinX = (minX - m_grid.originX) / m_grid.cellSizeX;
+    float gridMaxX = (maxX - m_grid.originX) / m_grid.cellSizeX;
+    float gridMinZ = (minZ - m_grid.originZ) / m_grid.cellSizeZ;
+    float gridMaxZ = (maxZ - m_grid.originZ) / m_grid.cellSizeZ;
+    if (gridMinX > gridMaxX) std::swap(gridMinX, gridMaxX);
+    if (gridMinZ > gridMaxZ) std::swap(gridMinZ, gridMaxZ);
+    if (gridMaxX < 0.0f || gridMaxZ < 0.0f || gridMinX > static_cast<float>(cellsX) || gridMinZ > static_cast<float>(cellsZ)) return false;
+
+    firstX = std::max(static_cast<int>(std::floor(gridMinX)), 0);
+    lastX = std::min(static_cast<int>(std::floor(gridMaxX)), cellsX - 1);
+    firstZ = std::max(static_cast<int>(std::floor(gridMinZ)), 0);
+    lastZ = std::min(static_cast<int>(std::floor(gridMaxZ)), cellsZ - 1);
+    return firstX <= lastX && firstZ <= lastZ;
+}
+
+bool TerrainCapsuleSweep::Sweep(const TerrainCapsule& capsule, const XMFLOAT3& displacement, TerrainSweepHit& outHit) const
+{
+    outHit = TerrainSweepHit();
+    if (!IsReady()) return false;
+
+    int firstX, lastX, firstZ, lastZ;
+    float minY, maxY;
+    if (!GetCellRange(capsule, displacement, firstX, lastX, firstZ, lastZ, minY, maxY)) return false;
+
+    const Vec3 base = ToVec3(capsule.base);
+    const Vec3 move = ToVec3(displacement);
+    float bestT = 1.0f;
+
+    for (int cellZ = firstZ; cellZ <= lastZ; ++cellZ)
+    {
+        for (int cellX = firstX; cellX <= lastX; ++cellX)
+        {
+            const Vec3 topLeft = ToVec3(GetVertex(cellX, cellZ));
+            const Vec3 topRight = ToVec3(GetVertex(cellX + 1, cellZ));
+            const Vec3 bottomLeft = ToVec3(GetVertex(cellX, cellZ + 1));
+            const Vec3 bottomRight = ToVec3(GetVertex(cellX + 1, cellZ + 1));
+
+            // Celda entera por debajo o por encima de todo el barrido
+            float cellMin = std::min(std::min(topLeft.y, topRight.y), std::min(bottomLeft.y, bottomRight.y));
+            float cellMax = std::max(std::max(topLeft.y, topRight.y), std::max(bottomLeft.y, bottomRight.y));
+            if (cellMax < minY - CONTACT_TOLERANCE || cellMin > maxY + CONTACT_TOLERANCE) continue;
+
+            const Vec3 triangles[2][3] = { { topLeft, topRight, bottomLeft }, { bottomLeft, topRight, bottomRight } };
+            for (const auto& triangle : triangles)
+            {
+                TerrainSweepHit candidate;
+                if (!SweepTriangle(base, capsule.height, capsule.radius, move, triangle[0], triangle[1], triangle[2], bestT, candidate)) continue;
+
+                // Primer contacto; a igual t, el de mas penetracion
+                if (!outHit.hit || candidate.t < outHit.t || (candidate.t == outHit.t && candidate.penetration > outHit.penetration))
+                {
+                    outHit = candidate;
+                    outHit.cellX = cellX;
+                    outHit.cellZ = cellZ;
+                    bestT = candidate.t;
+                }
+            }
+        }
+    }
+    return outHit.hit;
+}
+
+TerrainMoveResult TerrainCapsuleSweep::Move(const TerrainCapsule& capsule, const XMFLOAT3& displacement,
+    float minGroundNormalY, int maxIterations) const
+{
+    TerrainMoveResult result;
+    Vec3 position = ToVec3(capsule.base);
+    Vec3 remaining = ToVec3(displacement);
+
+    TerrainCapsule moving = capsule;
+    for (int iteration = 0; iteration < maxIterations; ++iteration)
+    {
+        float length = std::sqrt(Dot(remaining, remaining));
+        if (length < 1.0e-6f) break;
+
+        moving.base = ToFloat3(position);
+        TerrainSweepHit hit;
+        result.iterations++;
+        if (!Sweep(moving, ToFloat3(remaining), hit))
+        {
+            position = position + remaining;
+            break;
+        }
+
+        Vec3 normal = ToVec3(hit.normal);
+        if (hit.penetration > 0.0f)
+        {
+            // Ya estaba dentro (p.ej. el terreno subio bajo la capsula): primero sacarla
+            position = position + normal * (hit.penetration + SKIN);
+        }
+        else
+        {
+            // Hasta el contacto, dejando SKIN de separacion
+            float travel = std::max(length * hit.t - SKIN, 0.0f);
+            position = position + remaining * (travel / length);
+            remaining = remaining * (1.0f - hit.t);
+        }
+
+        if (normal.y >= minGroundNormalY)
+        {
+            result.grounded = true;
+            result.groundNormal = ToFloat3(normal);
+        }
+        else
+        {
+            // Pendiente demasiado fuerte: es una pared, se desliza en horizontal sin subir por ella
+            Vec3 wall = { normal.x, 0.0f, normal.z };
+            float wallLength = std::sqrt(Dot(wall, wall));
+            if (wallLength > 1.0e-6f) normal = wall * (1.0f / wallLength);
+        }
+
+        // Deslizar: quitar la componente que va contra la superficie
+        float into = Dot(remaining, normal);
+        if (into < 0.0f) remaining = remaining - normal * into;
+    }
+
+    result.base = ToFloat3(position);
+    return result;
+}
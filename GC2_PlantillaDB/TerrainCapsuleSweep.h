@@ -0,0 +1,79 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+
+// Heightfield en coordenadas de mundo, para un terreno que solo se escala y traslada (sin rotacion):
+// el vertice (i, j) esta en (originX + i * cellSizeX, originY + altura * heightScale, originZ + j * cellSizeZ).
+// Los triangulos son los de la malla: (i, j), (i+1, j), (i, j+1) y (i, j+1), (i+1, j), (i+1, j+1).
+struct TerrainCollisionGrid
+{
+    const float* heights = nullptr; // width * height alturas normalizadas (no se copian)
+    int width = 0;
+    int height = 0;
+    float originX = 0.0f;
+    float originY = 0.0f;
+    float originZ = 0.0f;
+    float cellSizeX = 1.0f;
+    float cellSizeZ = 1.0f;
+    float heightScale = 1.0f;
+};
+
+// Capsula vertical: segmento de base a base + (0, height, 0) engordado por radius.
+struct TerrainCapsule
+{
+    DirectX::XMFLOAT3 base = { 0.0f, 0.0f, 0.0f }; // Centro de la esfera inferior
+    float height = 0.0f;                           // Distancia entre los centros de las esferas
+    float radius = 0.5f;
+};
+
+struct TerrainSweepHit
+{
+    bool hit = false;
+    float t = 1.0f;           // Fraccion del desplazamiento hasta el contacto
+    float penetration = 0.0f; // > 0 si la capsula ya atravesaba el terreno al empezar (t = 0)
+    DirectX::XMFLOAT3 normal = { 0.0f, 1.0f, 0.0f }; // Del terreno hacia la capsula
+    DirectX::XMFLOAT3 point = { 0.0f, 0.0f, 0.0f };  // Punto de contacto sobre el terreno
+    int cellX = -1;
+    int cellZ = -1;
+};
+
+struct TerrainMoveResult
+{
+    DirectX::XMFLOAT3 base = { 0.0f, 0.0f, 0.0f }; // Nueva posicion de la capsula
+    bool grounded = false;                         // Algun contacto con pendiente caminable
+    DirectX::XMFLOAT3 groundNormal = { 0.0f, 1.0f, 0.0f };
+    int iterations = 0;
+};
+
+// Barrido continuo de una capsula contra el heightfield. Se recorren solo las celdas bajo la caja
+// del barrido (descartando las que no llegan por altura) y cada triangulo se resuelve con avance
+// conservador: como la distancia entre dos convexos que se trasladan es convexa en t, avanzar con
+// la tangente nunca se pasa del primer contacto. Move encadena barridos y desliza por el terreno.
+// Solo C++ estandar; mismo resultado en cualquier plataforma para la misma entrada.
+class TerrainCapsuleSweep
+{
+public:
+    static constexpr float CONTACT_TOLERANCE = 1.0e-3f; // Holgura del contacto (unidades de mundo)
+    static constexpr float SKIN = 1.0e-2f;              // Distancia que Move deja entre capsula y terreno
+
+    TerrainCapsuleSweep();
+
+    void SetGrid(const TerrainCollisionGrid& grid) { m_grid = grid; }
+    const TerrainCollisionGrid& GetGrid() const { return m_grid; }
+    bool IsReady() const { return m_grid.heights != nullptr && m_grid.width >= 2 && m_grid.height >= 2; }
+
+    bool Sweep(const TerrainCapsule& capsule, const DirectX::XMFLOAT3& displacement, TerrainSweepHit& outHit) const;
+
+    // Desplaza la capsula deslizando por los contactos. Las pendientes con normal.y menor que
+    // minGroundNormalY se tratan como paredes (se desliza en horizontal, sin subir por ellas).
+    TerrainMoveResult Move(const TerrainCapsule& capsule, const DirectX::XMFLOAT3& displacement,
+        float minGroundNormalY, int maxIterations = 4) const;
+
+private:
+    DirectX::XMFLOAT3 GetVertex(int i, int j) const;
+    bool GetCellRange(const TerrainCapsule& capsule, const DirectX::XMFLOAT3& displacement,
+        int& firstX, int& lastX, int& firstZ, int& lastZ, float& minY, float& maxY) const;
+
+    TerrainCollisionGrid m_grid;
+};
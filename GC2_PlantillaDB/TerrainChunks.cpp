@@ -0,0 +1,183 @@
+#include "TerrainChunks.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+using namespace DirectX;
+
+TerrainChunkGrid::TerrainChunkGrid() :
+    m_chunksX(0),
+    m_chunksZ(0)
+{
+}
+
+bool TerrainChunkGrid::Build(const float* heights, int width, int height, float heightScale, int chunkCells, ThreadPool* pool)
+{
+    m_indices.clear();
+    m_chunks.clear();
+    m_chunksX = 0;
+    m_chunksZ = 0;
+    if (!heights || width < 2 || height < 2 || chunkCells < 1) return false;
+
+    const int cellsX = width - 1;
+    const int cellsZ = height - 1;
+    m_chunksX = (cellsX + chunkCells - 1) / chunkCells;
+    m_chunksZ = (cellsZ + chunkCells - 1) / chunkCells;
+
+    // Primero los rectangulos y donde empieza cada trozo en el index buffer;
+    // asi cada trozo se rellena despues sin depender de los demas
+    m_chunks.resize(static_cast<size_t>(m_chunksX) * m_chunksZ);
+    uint32_t indexStart = 0;
+    for (int cz = 0; cz < m_chunksZ; ++cz)
+    {
+        for (int cx = 0; cx < m_chunksX; ++cx)
+        {
+            TerrainChunk& chunk = m_chunks[static_cast<size_t>(cz) * m_chunksX + cx];
+            chunk.cellX = cx * chunkCells;
+            chunk.cellZ = cz * chunkCells;
+            chunk.cellCountX = std::min(chunkCells, cellsX - chunk.cellX);
+            chunk.cellCountZ = std::min(chunkCells, cellsZ - chunk.cellZ);
+            chunk.indexStart = indexStart;
+            chunk.indexCount = static_cast<uint32_t>(chunk.cellCountX * chunk.cellCountZ * 6);
+            indexStart += chunk.indexCount;
+        }
+    }
+    m_indices.resize(indexStart);
+
+    auto fillChunk = [&](int chunkIndex)
+    {
+        TerrainChunk& chunk = m_chunks[chunkIndex];
+
+        // Misma triangulacion que la malla completa del terreno
+        uint32_t* out = m_indices.data() + chunk.indexStart;
+        for (int j = chunk.cellZ; j < chunk.cellZ + chunk.cellCountZ; ++j)
+        {
+            for (int i = chunk.cellX; i < chunk.cellX + chunk.cellCountX; ++i)
+            {
+                uint32_t topLeft = static_cast<uint32_t>(j * width + i);
+                uint32_t topRight = topLeft + 1;
+                uint32_t bottomLeft = static_cast<uint32_t>((j + 1) * width + i);
+                uint32_t bottomRight = bottomLeft + 1;
+
+                *out++ = topLeft;
+                *out++ = topRight;
+                *out++ = bottomLeft;
+
+                *out++ = bottomLeft;
+                *out++ = topRight;
+                *out++ = bottomRight;
+            }
+        }
+
+        // Altura minima y maxima de los vertices del trozo (incluye el borde compartido)
+        float minHeight = heights[chunk.cellZ * width + chunk.cellX];
+        float maxHeight = minHeight;
+        for (int j = chunk.cellZ; j <= chunk.cellZ + chunk.cellCountZ; ++j)
+        {
+            for (int i = chunk.cellX; i <= chunk.cellX + chunk.cellCountX; ++i)
+            {
+                float h = heights[j * width + i];
+                minHeight = std::min(minHeight, h);
+                maxHeight = std::max(maxHeight, h);
+            }
+        }
+
+        chunk.localMin = XMFLOAT3(static_cast<float>(chunk.cellX), minHeight * heightScale, static_cast<float>(chunk.cellZ));
+        chunk.localMax = XMFLOAT3(static_cast<float>(chunk.cellX + chunk.cellCountX), maxHeight * heightScale,
+            static_cast<float>(chunk.cellZ + chunk.cellCountZ));
+        if (heightScale < 0.0f) std::swap(chunk.localMin.y, chunk.localMax.y);
+
+        chunk.worldMin = chunk.localMin;
+        chunk.worldMax = chunk.localMax;
+    };
+
+    const int chunkCount = static_cast<int>(m_chunks.size());
+    if (pool && chunkCount > 1) pool->ParallelFor(chunkCount, fillChunk);
+    else for (int chunkIndex = 0; chunkIndex < chunkCount; ++chunkIndex) fillChunk(chunkIndex);
+    return true;
+}
+
+void TerrainChunkGrid::UpdateWorldBounds(const XMFLOAT4X4& world)
+{
+    // AABB transformada: por cada eje de salida se suma la menor/mayor contribucion de cada eje de entrada
+    for (TerrainChunk& chunk : m_chunks)
+    {
+        const float localMin[3] = { chunk.localMin.x, chunk.localMin.y, chunk.localMin.z };
+        const float localMax[3] = { chunk.localMax.x, chunk.localMax.y, chunk.localMax.z };
+        float worldMin[3] = { world._41, world._42, world._43 };
+        float worldMax[3] = { world._41, world._42, world._43 };
+
+        for (int row = 0; row < 3; ++row)
+        {
+            for (int column = 0; column < 3; ++column)
+            {
+                float a = world.m[row][column] * localMin[row];
+                float b = world.m[row][column] * localMax[row];
+                worldMin[column] += std::min(a, b);
+                worldMax[column] += std::max(a, b);
+            }
+        }
+
+        chunk.worldMin = XMFLOAT3(worldMin[0], worldMin[1], worldMin[2]);
+        chunk.worldMax = XMFLOAT3(worldMax[0], worldMax[1], worldMax[2]);
+    }
+}
+
+void TerrainChunkGrid::ExtractFrustumPlanes(const XMFLOAT4X4& m, XMFLOAT4 outPlanes[6])
+{
+    // Fila-mayor (v * M): clip = (dot(v, col0), dot(v, col1), dot(v, col2), dot(v, col3))
+    const XMFLOAT4 col0(m._11, m._21, m._31, m._41);
+    const XMFLOAT4 col1(m._12, m._22, m._32, m._42);
+    const XMFLOAT4 col2(m._13, m._23, m._33, m._43);
+    const XMFLOAT4 col3(m._14, m._24, m._34, m._44);
+
+    outPlanes[0] = XMFLOAT4(col3.x + col0.x, col3.y + col0.y, col3.z + col0.z, col3.w + col0.w); // x >= -w
+    outPlanes[1] = XMFLOAT4(col3.x - col0.x, col3.y - col0.y, col3.z - col0.z, col3.w - col0.w); // x <= w
+    outPlanes[2] = XMFLOAT4(col3.x + col1.x, col3.y + col1.y, col3.z + col1.z, col3.w + col1.w); // y >= -w
+    outPlanes[3] = XMFLOAT4(col3.x - col1.x, col3.y - col1.y, col3.z - col1.z, col3.w - col1.w); // y <= w
+    outPlanes[4] = col2;                                                                         // z >= 0
+    outPlanes[5] = XMFLOAT4(col3.x - col2.x, col3.y - col2.y, col3.z - col2.z, col3.w - col2.w); // z <= w
+}
+
+bool TerrainChunkGrid::AabbIntersectsFrustum(const XMFLOAT4 planes[6], const XMFLOAT3& boxMin, const XMFLOAT3& boxMax)
+{
+    for (int p = 0; p < 6; ++p)
+    {
+        const XMFLOAT4& plane = planes[p];
+        // Esquina mas adentro segun la normal del plano; si ni esa lo cruza, la caja esta fuera
+        float x = plane.x >= 0.0f ? boxMax.x : boxMin.x;
+        float y = plane.y >= 0.0f ? boxMax.y : boxMin.y;
+        float z = plane.z >= 0.0f ? boxMax.z : boxMin.z;
+        if (plane.x * x + plane.y * y + plane.z * z + plane.w < 0.0f) return false;
+    }
+    return true;
+}
+
+size_t TerrainChunkGrid::CullAndBuildRanges(const XMFLOAT4X4& viewProjection, std::vector<TerrainDrawRange>& outRanges) const
+{
+    outRanges.clear();
+
+    XMFLOAT4 planes[6];
+    ExtractFrustumPlanes(viewProjection, planes);
+
+    size_t visibleChunks = 0;
+    for (const TerrainChunk& chunk : m_chunks)
+    {
+        if (!AabbIntersectsFrustum(planes, chunk.worldMin, chunk.worldMax)) continue;
+        visibleChunks++;
+
+        // Trozos consecutivos en el index buffer se unen en un solo rango
+        if (!outRanges.empty() && outRanges.back().indexStart + outRanges.back().indexCount == chunk.indexStart)
+        {
+            outRanges.back().indexCount += chunk.indexCount;
+        }
+        else
+        {
+            TerrainDrawRange range;
+            range.indexStart = chunk.indexStart;
+            range.indexCount = chunk.indexCount;
+            outRanges.push_back(range);
+        }
+    }
+    return visibleChunks;
+}
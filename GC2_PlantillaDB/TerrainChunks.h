@@ -0,0 +1,75 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+// Un trozo del terreno: un rectangulo de celdas del heightmap cuyos indices estan
+// contiguos en el index buffer compartido.
+struct TerrainChunk
+{
+    int cellX = 0;      // Primera celda (columna) del trozo
+    int cellZ = 0;      // Primera celda (fila) del trozo
+    int cellCountX = 0;
+    int cellCountZ = 0;
+
+    uint32_t indexStart = 0;
+    uint32_t indexCount = 0;
+
+    DirectX::XMFLOAT3 localMin = { 0.0f, 0.0f, 0.0f }; // AABB en el espacio de la malla
+    DirectX::XMFLOAT3 localMax = { 0.0f, 0.0f, 0.0f };
+    DirectX::XMFLOAT3 worldMin = { 0.0f, 0.0f, 0.0f }; // AABB en mundo (tras UpdateWorldBounds)
+    DirectX::XMFLOAT3 worldMax = { 0.0f, 0.0f, 0.0f };
+};
+
+// Rango continuo del index buffer listo para un DrawIndexed.
+struct TerrainDrawRange
+{
+    uint32_t indexStart = 0;
+    uint32_t indexCount = 0;
+};
+
+// Divide la rejilla del terreno en trozos de tamano fijo con un solo index buffer.
+// Los indices de cada trozo quedan juntos y los trozos van por filas, asi que varios
+// trozos visibles seguidos se dibujan con un unico DrawIndexed.
+// No depende de D3D: solo genera indices, AABBs y el culling contra un frustum.
+//
+// La malla es la del terreno: el vertice (i, j) esta en (i, altura, j) y su indice es j * width + i.
+class TerrainChunkGrid
+{
+public:
+    TerrainChunkGrid();
+
+    // heights: width * height alturas normalizadas (se multiplican por heightScale).
+    // chunkCells: celdas por lado de cada trozo (el ultimo de cada fila/columna puede ser menor).
+    // Con pool, los indices y AABBs de cada trozo se rellenan en paralelo.
+    bool Build(const float* heights, int width, int height, float heightScale, int chunkCells, ThreadPool* pool = nullptr);
+
+    // Recalcula las AABB en mundo con la matriz del terreno (fila-mayor, como SimpleMath).
+    void UpdateWorldBounds(const DirectX::XMFLOAT4X4& world);
+
+    // Trozos cuya AABB en mundo toca el frustum de viewProjection (z de D3D en [0, 1]).
+    // Devuelve cuantos trozos son visibles; outRanges recibe los rangos ya fusionados.
+    size_t CullAndBuildRanges(const DirectX::XMFLOAT4X4& viewProjection, std::vector<TerrainDrawRange>& outRanges) const;
+
+    const std::vector<uint32_t>& GetIndices() const { return m_indices; }
+    const std::vector<TerrainChunk>& GetChunks() const { return m_chunks; }
+    int GetChunksX() const { return m_chunksX; }
+    int GetChunksZ() const { return m_chunksZ; }
+
+    // Planos (a, b, c, d) del frustum con la normal hacia dentro: izquierda, derecha, abajo, arriba, cerca, lejos.
+    static void ExtractFrustumPlanes(const DirectX::XMFLOAT4X4& viewProjection, DirectX::XMFLOAT4 outPlanes[6]);
+
+    // true si la AABB queda al menos en parte del lado interior de los seis planos.
+    static bool AabbIntersectsFrustum(const DirectX::XMFLOAT4 planes[6],
+        const DirectX::XMFLOAT3& boxMin, const DirectX::XMFLOAT3& boxMax);
+
+private:
+    std::vector<uint32_t> m_indices;
+    std::vector<TerrainChunk> m_chunks;
+    int m_chunksX;
+    int m_chunksZ;
+};
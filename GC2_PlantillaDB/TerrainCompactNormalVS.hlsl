@@ -0,0 +1,3 @@
+// Variante de TerrainCompactVS con la normal comprimida en un vertex buffer de 2 bytes por vertice
+#define TERRAIN_PACKED_NORMALS
+#include "TerrainCompactVS.hlsl"
@@ -0,0 +1,24 @@
+// Terreno sin posiciones en el vertex buffer: la rejilla sale de SV_VertexID y la altura de HeightData.
+// Con TERRAIN_PACKED_NORMALS la normal llega comprimida (x, z en R8G8_SNORM); si no, se calcula de las alturas.
+#include "TerrainVSCommon.hlsli"
+
+struct VertexInputType
+{
+    uint vertexId : SV_VertexID;
+#ifdef TERRAIN_PACKED_NORMALS
+    float2 packedNormal : NORMAL;
+#endif
+};
+
+PixelInputType main(VertexInputType input)
+{
+    int2 gridPoint = GridPointFromVertexId(input.vertexId);
+
+#ifdef TERRAIN_PACKED_NORMALS
+    float3 localNormal = float3(input.packedNormal.x, sqrt(saturate(1.0f - dot(input.packedNormal, input.packedNormal))), input.packedNormal.y);
+#else
+    float3 localNormal = GridPointNormal(gridPoint);
+#endif
+
+    return BuildTerrainVertex(GridPointLocalPosition(gridPoint), localNormal);
+}
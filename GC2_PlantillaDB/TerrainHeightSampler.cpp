@@ -0,0 +1,239 @@
+#include "TerrainHeightSampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define HEIGHT_SAMPLER_USE_SSE2 1
+#endif
+
+using namespace DirectX;
+
+TerrainHeightSampler::TerrainHeightSampler() :
+    m_heights(nullptr),
+    m_width(0),
+    m_height(0),
+    m_heightScale(1.0f),
+    m_transformValid(false),
+    m_translationX(0.0f),
+    m_translationZ(0.0f),
+    m_worldToGrid{ { 0.0f, 0.0f }, { 0.0f, 0.0f } },
+    m_heightRow{ 0.0f, 0.0f, 0.0f, 0.0f },
+    m_normalMatrix{ { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } }
+{
+}
+
+void TerrainHeightSampler::SetHeights(const float* heights, int width, int height, float heightScale)
+{
+    bool usable = heights && width > 1 && height > 1;
+    m_heights = usable ? heights : nullptr;
+    m_width = usable ? width : 0;
+    m_height = usable ? height : 0;
+    m_heightScale = heightScale;
+}
+
+bool TerrainHeightSampler::SetTransform(const XMFLOAT4X4& world)
+{
+    // Mismo sistema que resolvia GetWorldHeightAt: x = i * _11 + j * _31 + _41, z = i * _13 + j * _33 + _43
+    float determinant = world._11 * world._33 - world._31 * world._13;
+    m_transformValid = std::fabs(determinant) >= 0.0001f;
+    if (!m_transformValid) return false;
+
+    float invDeterminant = 1.0f / determinant;
+    m_translationX = world._41;
+    m_translationZ = world._43;
+    m_worldToGrid[0][0] = world._33 * invDeterminant;
+    m_worldToGrid[0][1] = -world._31 * invDeterminant;
+    m_worldToGrid[1][0] = -world._13 * invDeterminant;
+    m_worldToGrid[1][1] = world._11 * invDeterminant;
+
+    m_heightRow[0] = world._12;
+    m_heightRow[1] = world._22;
+    m_heightRow[2] = world._32;
+    m_heightRow[3] = world._42;
+
+    // Inversa traspuesta de la 3x3 = cofactores / determinante (filas: r1 x r2, r2 x r0, r0 x r1)
+    const float rows[3][3] = {
+        { world._11, world._12, world._13 },
+        { world._21, world._22, world._23 },
+        { world._31, world._32, world._33 } };
+    for (int r = 0; r < 3; ++r)
+    {
+        const float* a = rows[(r + 1) % 3];
+        const float* b = rows[(r + 2) % 3];
+        m_normalMatrix[r][0] = a[1] * b[2] - a[2] * b[1];
+        m_normalMatrix[r][1] = a[2] * b[0] - a[0] * b[2];
+        m_normalMatrix[r][2] = a[0] * b[1] - a[1] * b[0];
+    }
+    float determinant3 = rows[0][0] * m_normalMatrix[0][0] + rows[0][1] * m_normalMatrix[0][1] + rows[0][2] * m_normalMatrix[0][2];
+    if (determinant3 < 0.0f)
+    {
+        // Solo importa la orientacion: la normal se normaliza despues
+        for (auto& row : m_normalMatrix) for (float& value : row) value = -value;
+    }
+    return true;
+}
+
+bool TerrainHeightSampler::WorldToGrid(float worldX, float worldZ, float& outGridX, float& outGridZ) const
+{
+    if (!IsReady()) return false;
+
+    float tx = worldX - m_translationX;
+    float tz = worldZ - m_translationZ;
+    outGridX = tx * m_worldToGrid[0][0] + tz * m_worldToGrid[0][1];
+    outGridZ = tx * m_worldToGrid[1][0] + tz * m_worldToGrid[1][1];
+    return outGridX >= 0.0f && outGridX < static_cast<float>(m_width - 1) &&
+        outGridZ >= 0.0f && outGridZ < static_cast<float>(m_height - 1);
+}
+
+float TerrainHeightSampler::GridToWorldHeight(float gridX, float normalizedHeight, float gridZ) const
+{
+    return gridX * m_heightRow[0] + normalizedHeight * m_heightScale * m_heightRow[1] + gridZ * m_heightRow[2] + m_heightRow[3];
+}
+
+bool TerrainHeightSampler::SampleHeight(float worldX, float worldZ, float& outHeight, XMFLOAT3* outNormal) const
+{
+    float gridX, gridZ;
+    if (!WorldToGrid(worldX, worldZ, gridX, gridZ)) return false;
+
+    // Dentro del heightfield x0 + 1 y z0 + 1 siempre son validos
+    const int x0 = static_cast<int>(gridX);
+    const int z0 = static_cast<int>(gridZ);
+    const float fx = gridX - static_cast<float>(x0);
+    const float fz = gridZ - static_cast<float>(z0);
+
+    const float* row0 = m_heights + static_cast<size_t>(z0) * m_width + x0;
+    const float* row1 = row0 + m_width;
+    const float h00 = row0[0], h10 = row0[1], h01 = row1[0], h11 = row1[1];
+
+    const float bottom = h00 + fx * (h10 - h00);
+    const float top = h01 + fx * (h11 - h01);
+    outHeight = GridToWorldHeight(gridX, bottom + fz * (top - bottom), gridZ);
+
+    if (outNormal)
+    {
+        // Gradiente de la superficie bilineal en el punto
+        float dhdx = ((h10 - h00) + fz * ((h11 - h01) - (h10 - h00))) * m_heightScale;
+        float dhdz = (top - bottom) * m_heightScale;
+        float nx = -dhdx * m_normalMatrix[0][0] + m_normalMatrix[1][0] - dhdz * m_normalMatrix[2][0];
+        float ny = -dhdx * m_normalMatrix[0][1] + m_normalMatrix[1][1] - dhdz * m_normalMatrix[2][1];
+        float nz = -dhdx * m_normalMatrix[0][2] + m_normalMatrix[1][2] - dhdz * m_normalMatrix[2][2];
+        float invLength = 1.0f / std::sqrt(nx * nx + ny * ny + nz * nz);
+        *outNormal = XMFLOAT3(nx * invLength, ny * invLength, nz * invLength);
+    }
+    return true;
+}
+
+size_t TerrainHeightSampler::SampleHeights(const XMFLOAT2* positions, size_t count, float* outHeights, uint8_t* outValid,
+    XMFLOAT3* outNormals) const
+{
+    if (!IsReady())
+    {
+        memset(outValid, 0, count);
+        return 0;
+    }
+
+    size_t validCount = 0;
+    size_t i = 0;
+
+#ifdef HEIGHT_SAMPLER_USE_SSE2
+    const __m128 translationX = _mm_set1_ps(m_translationX);
+    const __m128 translationZ = _mm_set1_ps(m_translationZ);
+    const __m128 m00 = _mm_set1_ps(m_worldToGrid[0][0]), m01 = _mm_set1_ps(m_worldToGrid[0][1]);
+    const __m128 m10 = _mm_set1_ps(m_worldToGrid[1][0]), m11 = _mm_set1_ps(m_worldToGrid[1][1]);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 maxX = _mm_set1_ps(static_cast<float>(m_width - 1));
+    const __m128 maxZ = _mm_set1_ps(static_cast<float>(m_height - 1));
+    const __m128 heightScale = _mm_set1_ps(m_heightScale);
+    const __m128 row0 = _mm_set1_ps(m_heightRow[0]), row1 = _mm_set1_ps(m_heightRow[1]);
+    const __m128 row2 = _mm_set1_ps(m_heightRow[2]), row3 = _mm_set1_ps(m_heightRow[3]);
+
+    alignas(16) int cellX[4], cellZ[4];
+    alignas(16) float heights[4], nx[4], ny[4], nz[4];
+
+    for (; i + 4 <= count; i += 4)
+    {
+        // (x0 z0 x1 z1) (x2 z2 x3 z3) -> x0..x3 y z0..z3
+        __m128 a = _mm_loadu_ps(&positions[i].x);
+        __m128 b = _mm_loadu_ps(&positions[i + 2].x);
+        __m128 tx = _mm_sub_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)), translationX);
+        __m128 tz = _mm_sub_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)), translationZ);
+        __m128 gridX = _mm_add_ps(_mm_mul_ps(tx, m00), _mm_mul_ps(tz, m01));
+        __m128 gridZ = _mm_add_ps(_mm_mul_ps(tx, m10), _mm_mul_ps(tz, m11));
+
+        __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(gridX, zero), _mm_cmplt_ps(gridX, maxX)),
+            _mm_and_ps(_mm_cmpge_ps(gridZ, zero), _mm_cmplt_ps(gridZ, maxZ)));
+        const int insideMask = _mm_movemask_ps(inside);
+        for (int lane = 0; lane < 4; ++lane) outValid[i + lane] = static_cast<uint8_t>((insideMask >> lane) & 1);
+        if (insideMask == 0) continue;
+
+        // Los carriles de fuera leen la celda (0, 0) y luego se descartan
+        __m128 safeX = _mm_and_ps(inside, gridX);
+        __m128 safeZ = _mm_and_ps(inside, gridZ);
+        __m128i x0 = _mm_cvttps_epi32(safeX);
+        __m128i z0 = _mm_cvttps_epi32(safeZ);
+        __m128 fx = _mm_sub_ps(safeX, _mm_cvtepi32_ps(x0));
+        __m128 fz = _mm_sub_ps(safeZ, _mm_cvtepi32_ps(z0));
+        _mm_store_si128(reinterpret_cast<__m128i*>(cellX), x0);
+        _mm_store_si128(reinterpret_cast<__m128i*>(cellZ), z0);
+
+        alignas(16) float c00[4], c10[4], c01[4], c11[4];
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            const float* corner = m_heights + static_cast<size_t>(cellZ[lane]) * m_width + cellX[lane];
+            c00[lane] = corner[0];
+            c10[lane] = corner[1];
+            c01[lane] = corner[m_width];
+            c11[lane] = corner[m_width + 1];
+        }
+        __m128 h00 = _mm_load_ps(c00), h10 = _mm_load_ps(c10), h01 = _mm_load_ps(c01), h11 = _mm_load_ps(c11);
+
+        __m128 bottomDelta = _mm_sub_ps(h10, h00);
+        __m128 topDelta = _mm_sub_ps(h11, h01);
+        __m128 bottom = _mm_add_ps(h00, _mm_mul_ps(fx, bottomDelta));
+        __m128 top = _mm_add_ps(h01, _mm_mul_ps(fx, topDelta));
+        __m128 verticalDelta = _mm_sub_ps(top, bottom);
+        __m128 normalized = _mm_add_ps(bottom, _mm_mul_ps(fz, verticalDelta));
+
+        // Mismo orden de operaciones que GridToWorldHeight
+        __m128 worldY = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(gridX, row0),
+            _mm_mul_ps(_mm_mul_ps(normalized, heightScale), row1)), _mm_mul_ps(gridZ, row2)), row3);
+        _mm_store_ps(heights, worldY);
+
+        if (outNormals)
+        {
+            __m128 dhdx = _mm_mul_ps(_mm_add_ps(bottomDelta, _mm_mul_ps(fz, _mm_sub_ps(topDelta, bottomDelta))), heightScale);
+            __m128 dhdz = _mm_mul_ps(verticalDelta, heightScale);
+            __m128 normal[3];
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                normal[axis] = _mm_sub_ps(_mm_add_ps(_mm_sub_ps(zero, _mm_mul_ps(dhdx, _mm_set1_ps(m_normalMatrix[0][axis]))),
+                    _mm_set1_ps(m_normalMatrix[1][axis])), _mm_mul_ps(dhdz, _mm_set1_ps(m_normalMatrix[2][axis])));
+            }
+            __m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(normal[0], normal[0]), _mm_mul_ps(normal[1], normal[1])),
+                _mm_mul_ps(normal[2], normal[2]));
+            __m128 invLength = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(lengthSq));
+            _mm_store_ps(nx, _mm_mul_ps(normal[0], invLength));
+            _mm_store_ps(ny, _mm_mul_ps(normal[1], invLength));
+            _mm_store_ps(nz, _mm_mul_ps(normal[2], invLength));
+        }
+
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            if (!(insideMask & (1 << lane))) continue;
+            outHeights[i + lane] = heights[lane];
+            if (outNormals) outNormals[i + lane] = XMFLOAT3(nx[lane], ny[lane], nz[lane]);
+            validCount++;
+        }
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        outValid[i] = SampleHeight(positions[i].x, positions[i].y, outHeights[i], outNormals ? &outNormals[i] : nullptr) ? 1 : 0;
+        validCount += outValid[i];
+    }
+    return validCount;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+
+// Consultas de altura sobre el heightfield del terreno en coordenadas de mundo.
+// La inversa del plano XZ de la matriz del terreno se calcula una vez en SetTransform;
+// SampleHeights resuelve los puntos de 4 en 4 con SSE2 (o uno a uno sin SSE2) y da
+// exactamente los mismos resultados que SampleHeight.
+// No copia las alturas: el puntero de SetHeights tiene que seguir vivo.
+class TerrainHeightSampler
+{
+public:
+    TerrainHeightSampler();
+
+    // heights: width * height alturas normalizadas; la altura local es altura * heightScale.
+    void SetHeights(const float* heights, int width, int height, float heightScale);
+
+    // Matriz de mundo del terreno (fila-mayor, como SimpleMath). false si el plano XZ no es invertible.
+    bool SetTransform(const DirectX::XMFLOAT4X4& world);
+
+    bool IsReady() const { return m_heights != nullptr && m_transformValid; }
+
+    // Punto de la rejilla (i, j) bajo (worldX, worldZ); false si cae fuera del heightfield.
+    bool WorldToGrid(float worldX, float worldZ, float& outGridX, float& outGridZ) const;
+
+    // Y de mundo de un punto de la rejilla con la altura normalizada dada.
+    float GridToWorldHeight(float gridX, float normalizedHeight, float gridZ) const;
+
+    // Altura de mundo (bilineal) y, opcionalmente, la normal de mundo de la superficie bilineal.
+    bool SampleHeight(float worldX, float worldZ, float& outHeight, DirectX::XMFLOAT3* outNormal = nullptr) const;
+
+    // positions: (x, z) de mundo. outValid[i] = 1 si el punto cae dentro del terreno (si no,
+    // outHeights[i] y outNormals[i] no se tocan). outNormals es opcional. Devuelve cuantos son validos.
+    size_t SampleHeights(const DirectX::XMFLOAT2* positions, size_t count, float* outHeights, uint8_t* outValid,
+        DirectX::XMFLOAT3* outNormals = nullptr) const;
+
+private:
+    const float* m_heights;
+    int m_width;
+    int m_height;
+    float m_heightScale;
+
+    bool m_transformValid;
+    float m_translationX;
+    float m_translationZ;
+    float m_worldToGrid[2][2];   // (x, z) de mundo menos la traslacion -> (i, j)
+    float m_heightRow[4];        // _12, _22, _32, _42: Y de mundo a partir de (i, altura local, j)
+    float m_normalMatrix[3][3];  // Inversa traspuesta de la 3x3 (normales locales -> mundo)
+};
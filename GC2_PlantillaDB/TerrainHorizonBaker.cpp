@@ -0,0 +1,121 @@
+#include "TerrainHorizonBaker.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+    const float PI = 3.14159265358979f;
+    const float HALF_PI = 1.57079632679490f;
+
+    // Crecimiento del paso del horizonte con la distancia (el error angular se mantiene acotado)
+    const float STEP_GROWTH = 0.05f;
+
+    // Altura bilineal (normalizada) en coordenadas de rejilla; false fuera del heightfield
+    bool SampleGrid(const TerrainHorizonGrid& grid, float gridX, float gridZ, float& outHeight)
+    {
+        if (gridX < 0.0f || gridZ < 0.0f || gridX > static_cast<float>(grid.width - 1) || gridZ > static_cast<float>(grid.height - 1))
+        {
+            return false;
+        }
+        int x0 = std::min(static_cast<int>(gridX), grid.width - 2);
+        int z0 = std::min(static_cast<int>(gridZ), grid.height - 2);
+        float fx = gridX - static_cast<float>(x0);
+        float fz = gridZ - static_cast<float>(z0);
+        const float* row0 = grid.heights + static_cast<size_t>(z0) * grid.width + x0;
+        const float* row1 = row0 + grid.width;
+        float top = row0[0] + (row0[1] - row0[0]) * fx;
+        float bottom = row1[0] + (row1[1] - row1[0]) * fx;
+        outHeight = top + (bottom - top) * fz;
+        return true;
+    }
+
+    float MaxHeight(const TerrainHorizonGrid& grid)
+    {
+        const size_t count = static_cast<size_t>(grid.width) * grid.height;
+        return *std::max_element(grid.heights, grid.heights + count) * grid.heightScale;
+    }
+
+}
+
+float TerrainHorizonBaker::HorizonAngle(const TerrainHorizonGrid& grid, int i, int j, float azimuth, float maxDistance, float maxHeight)
+{
+    const float originHeight = grid.heights[static_cast<size_t>(j) * grid.width + i] * grid.heightScale;
+    const float stepX = std::cos(azimuth) / grid.cellSizeX; // Celdas por unidad de mundo
+    const float stepZ = std::sin(azimuth) / grid.cellSizeZ;
+    const float minStep = 0.5f * std::min(grid.cellSizeX, grid.cellSizeZ);
+
+    float maxTangent = 0.0f;
+    float distance = minStep;
+    while (distance <= maxDistance)
+    {
+        // Ni el punto mas alto del mapa podria subir ya el horizonte
+        if (maxHeight - originHeight <= maxTangent * distance) break;
+
+        float sampleHeight;
+        if (!SampleGrid(grid, i + stepX * distance, j + stepZ * distance, sampleHeight)) break;
+        maxTangent = std::max(maxTangent, (sampleHeight * grid.heightScale - originHeight) / distance);
+
+        distance += std::max(minStep, distance * STEP_GROWTH);
+    }
+    return std::atan(maxTangent);
+}
+
+void TerrainHorizonBaker::Bake(const TerrainHorizonGrid& grid, int azimuthCount, float maxDistance, uint8_t* outHorizons, ThreadPool* pool)
+{
+    if (!grid.heights || !outHorizons || grid.width < 2 || grid.height < 2 || azimuthCount < 1) return;
+
+    const float maxHeight = MaxHeight(grid);
+    const size_t sliceSize = static_cast<size_t>(grid.width) * grid.height;
+
+    const int bands = (grid.height + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+    auto bakeBand = [&](int band)
+    {
+        int firstRow = band * ROWS_PER_TASK;
+        int lastRow = std::min(firstRow + ROWS_PER_TASK, grid.height);
+        for (int azimuthIndex = 0; azimuthIndex < azimuthCount; ++azimuthIndex)
+        {
+            const float azimuth = 2.0f * PI * azimuthIndex / azimuthCount;
+            uint8_t* slice = outHorizons + sliceSize * azimuthIndex;
+            for (int j = firstRow; j < lastRow; ++j)
+            {
+                for (int i = 0; i < grid.width; ++i)
+                {
+                    float angle = HorizonAngle(grid, i, j, azimuth, maxDistance, maxHeight);
+                    slice[static_cast<size_t>(j) * grid.width + i] = static_cast<uint8_t>(std::min(angle / HALF_PI, 1.0f) * 255.0f + 0.5f);
+                }
+            }
+        }
+    };
+
+    if (pool && bands > 1) pool->ParallelFor(bands, bakeBand);
+    else for (int band = 0; band < bands; ++band) bakeBand(band);
+}
+
+float TerrainHorizonBaker::SunVisibility(const uint8_t* horizons, int width, int height, int azimuthCount, int i, int j,
+    const XMFLOAT3& towardsSun, float softness)
+{
+    // Mismo calculo que TerrainPS: interpolacion lineal entre los dos azimuts vecinos
+    float azimuth = std::atan2(towardsSun.z, towardsSun.x);
+    if (azimuth < 0.0f) azimuth += 2.0f * PI;
+    float slice = azimuth / (2.0f * PI) * azimuthCount;
+    int slice0 = static_cast<int>(std::floor(slice)) % azimuthCount;
+    int slice1 = (slice0 + 1) % azimuthCount;
+    float blend = slice - std::floor(slice);
+
+    const size_t sliceSize = static_cast<size_t>(width) * height;
+    const size_t texel = static_cast<size_t>(j) * width + i;
+    float horizon0 = horizons[sliceSize * slice0 + texel] / 255.0f;
+    float horizon1 = horizons[sliceSize * slice1 + texel] / 255.0f;
+    float horizon = horizon0 + (horizon1 - horizon0) * blend;
+
+    float length = std::sqrt(towardsSun.x * towardsSun.x + towardsSun.y * towardsSun.y + towardsSun.z * towardsSun.z);
+    float elevation = std::asin(std::min(std::max(towardsSun.y / length, -1.0f), 1.0f)) / HALF_PI;
+    if (softness <= 0.0f) return elevation > horizon ? 1.0f : 0.0f;
+
+    float t = std::min(std::max((elevation - (horizon - softness)) / (2.0f * softness), 0.0f), 1.0f);
+    return t * t * (3.0f - 2.0f * t);
+}
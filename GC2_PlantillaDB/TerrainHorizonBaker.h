@@ -0,0 +1,40 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+
+class ThreadPool;
+
+// Dimensiones de mundo del heightfield: el terreno solo se escala y traslada (sin rotacion).
+struct TerrainHorizonGrid
+{
+    const float* heights = nullptr; // width * height alturas normalizadas
+    int width = 0;
+    int height = 0;
+    float cellSizeX = 1.0f;   // Unidades de mundo entre dos columnas
+    float cellSizeZ = 1.0f;   // Unidades de mundo entre dos filas
+    float heightScale = 1.0f; // Unidades de mundo por unidad de altura normalizada
+};
+
+// Mapas de horizonte para la autosombra del terreno. Para cada punto de la rejilla y cada uno de
+// azimuthCount azimuts de mundo (angulo 2*pi*k/azimuthCount desde +X hacia +Z) guarda la elevacion
+// maxima del terreno visto desde ese punto, como angulo / (pi/2) en 8 bits. Un sol con elevacion
+// mayor que el horizonte en su azimut ilumina el punto; TerrainPS lo evalua para cualquier direccion
+// interpolando los dos azimuts vecinos, asi que el terreno no necesita dibujarse en el shadow map.
+class TerrainHorizonBaker
+{
+public:
+    static const int DEFAULT_AZIMUTHS = 16;
+    static constexpr int ROWS_PER_TASK = 8;
+
+    // outHorizons: azimuthCount cortes de width * height (corte k = azimut k). maxDistance en unidades de mundo.
+    static void Bake(const TerrainHorizonGrid& grid, int azimuthCount, float maxDistance, uint8_t* outHorizons, ThreadPool* pool = nullptr);
+
+    // Elevacion del horizonte (radianes, >= 0) del punto (i, j) en un azimut de mundo.
+    static float HorizonAngle(const TerrainHorizonGrid& grid, int i, int j, float azimuth, float maxDistance, float maxHeight);
+
+    // Como TerrainPS: 1 si el sol (direccion hacia la luz, en mundo) queda por encima del horizonte horneado.
+    static float SunVisibility(const uint8_t* horizons, int width, int height, int azimuthCount, int i, int j,
+        const DirectX::XMFLOAT3& towardsSun, float softness);
+};
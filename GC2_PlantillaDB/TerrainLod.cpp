@@ -0,0 +1,343 @@
+#include "TerrainLod.h"
+#include "TerrainChunks.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+using namespace DirectX;
+
+TerrainLodTree::TerrainLodTree() :
+    m_width(0),
+    m_height(0),
+    m_leafCells(0),
+    m_levelCount(0),
+    m_rootNode(-1),
+    m_worldHeightScale(1.0f)
+{
+}
+
+bool TerrainLodTree::Build(const float* heights, int width, int height, float heightScale, int leafCells)
+{
+    m_nodes.clear();
+    m_indices.clear();
+    m_levelCount = 0;
+    m_rootNode = -1;
+    if (!heights || width < 2 || height < 2 || leafCells < 2 || (leafCells % 2) != 0) return false;
+
+    m_width = width;
+    m_height = height;
+    m_leafCells = leafCells;
+
+    // Niveles necesarios para que un solo nodo raiz cubra todo el mapa
+    const int cells = std::max(width - 1, height - 1);
+    int rootLevel = 0;
+    while ((leafCells << rootLevel) < cells) rootLevel++;
+    m_levelCount = rootLevel + 1;
+
+    m_rootNode = BuildNode(heights, heightScale, 0, 0, rootLevel);
+    ComputeLevelErrors(heights, heightScale);
+
+    // Rangos por defecto: nivel 0 hasta 8 nodos hoja, morph en el ultimo 30% de cada banda
+    SetLodRanges(static_cast<float>(leafCells * 8), 0.7f);
+    return true;
+}
+
+int TerrainLodTree::BuildNode(const float* heights, float heightScale, int cellX, int cellZ, int level)
+{
+    TerrainLodNode node;
+    node.cellX = cellX;
+    node.cellZ = cellZ;
+    node.cellSize = m_leafCells << level;
+    node.level = level;
+
+    for (int quadrant = 0; quadrant < 4; ++quadrant)
+    {
+        AppendQuadrantIndices(node, quadrant);
+    }
+
+    // Altura minima y maxima de los vertices del nodo (recortado al mapa)
+    const int lastX = std::min(cellX + node.cellSize, m_width - 1);
+    const int lastZ = std::min(cellZ + node.cellSize, m_height - 1);
+    float minHeight = heights[cellZ * m_width + cellX];
+    float maxHeight = minHeight;
+    for (int j = cellZ; j <= lastZ; ++j)
+    {
+        for (int i = cellX; i <= lastX; ++i)
+        {
+            float h = heights[j * m_width + i];
+            minHeight = std::min(minHeight, h);
+            maxHeight = std::max(maxHeight, h);
+        }
+    }
+    node.localMin = XMFLOAT3(static_cast<float>(cellX), minHeight * heightScale, static_cast<float>(cellZ));
+    node.localMax = XMFLOAT3(static_cast<float>(lastX), maxHeight * heightScale, static_cast<float>(lastZ));
+    if (heightScale < 0.0f) std::swap(node.localMin.y, node.localMax.y);
+    node.worldMin = node.localMin;
+    node.worldMax = node.localMax;
+
+    const int nodeIndex = static_cast<int>(m_nodes.size());
+    m_nodes.push_back(node);
+
+    if (level > 0)
+    {
+        const int half = node.cellSize / 2;
+        for (int quadrant = 0; quadrant < 4; ++quadrant)
+        {
+            int childX = cellX + (quadrant & 1) * half;
+            int childZ = cellZ + (quadrant >> 1) * half;
+            if (childX >= m_width - 1 || childZ >= m_height - 1) continue; // Fuera del mapa
+
+            int child = BuildNode(heights, heightScale, childX, childZ, level - 1);
+            m_nodes[nodeIndex].children[quadrant] = child;
+        }
+    }
+    return nodeIndex;
+}
+
+void TerrainLodTree::AppendQuadrantIndices(TerrainLodNode& node, int quadrant)
+{
+    const int step = 1 << node.level;
+    const int halfQuads = m_leafCells / 2;
+    const int firstA = (quadrant & 1) * halfQuads;
+    const int firstB = (quadrant >> 1) * halfQuads;
+    const int cellsX = m_width - 1;
+    const int cellsZ = m_height - 1;
+
+    node.quadrantStart[quadrant] = static_cast<uint32_t>(m_indices.size());
+
+    for (int b = firstB; b < firstB + halfQuads; ++b)
+    {
+        int z0 = node.cellZ + b * step;
+        if (z0 >= cellsZ) break;
+        int z1 = std::min(z0 + step, cellsZ);
+
+        for (int a = firstA; a < firstA + halfQuads; ++a)
+        {
+            int x0 = node.cellX + a * step;
+            if (x0 >= cellsX) break;
+            int x1 = std::min(x0 + step, cellsX);
+
+            // Misma triangulacion que la malla completa del terreno
+            uint32_t topLeft = static_cast<uint32_t>(z0 * m_width + x0);
+            uint32_t topRight = static_cast<uint32_t>(z0 * m_width + x1);
+            uint32_t bottomLeft = static_cast<uint32_t>(z1 * m_width + x0);
+            uint32_t bottomRight = static_cast<uint32_t>(z1 * m_width + x1);
+
+            m_indices.push_back(topLeft);
+            m_indices.push_back(topRight);
+            m_indices.push_back(bottomLeft);
+
+            m_indices.push_back(bottomLeft);
+            m_indices.push_back(topRight);
+            m_indices.push_back(bottomRight);
+        }
+    }
+
+    node.quadrantCount[quadrant] = static_cast<uint32_t>(m_indices.size()) - node.quadrantStart[quadrant];
+}
+
+void TerrainLodTree::ComputeLevelErrors(const float* heights, float heightScale)
+{
+    // Cada vertice contra el quad del nivel que lo contiene, con la misma diagonal que AppendQuadrantIndices
+    // (los quads empiezan en multiplos del paso y el ultimo de cada fila o columna puede ser mas corto)
+    m_levelErrors.assign(m_levelCount, 0.0f);
+    const int cellsX = m_width - 1;
+    const int cellsZ = m_height - 1;
+    for (int level = 1; level < m_levelCount; ++level)
+    {
+        const int step = 1 << level;
+        float maxError = 0.0f;
+        for (int j = 0; j < m_height; ++j)
+        {
+            const int z0 = std::min(j / step * step, (cellsZ - 1) / step * step);
+            const int z1 = std::min(z0 + step, cellsZ);
+            const float v = static_cast<float>(j - z0) / static_cast<float>(z1 - z0);
+            for (int i = 0; i < m_width; ++i)
+            {
+                const int x0 = std::min(i / step * step, (cellsX - 1) / step * step);
+                const int x1 = std::min(x0 + step, cellsX);
+                const float u = static_cast<float>(i - x0) / static_cast<float>(x1 - x0);
+
+                const float topLeft = heights[z0 * m_width + x0];
+                const float topRight = heights[z0 * m_width + x1];
+                const float bottomLeft = heights[z1 * m_width + x0];
+                const float bottomRight = heights[z1 * m_width + x1];
+                const float interpolated = u + v <= 1.0f
+                    ? topLeft + u * (topRight - topLeft) + v * (bottomLeft - topLeft)
+                    : bottomRight + (1.0f - u) * (bottomLeft - bottomRight) + (1.0f - v) * (topRight - bottomRight);
+                maxError = std::max(maxError, std::fabs(heights[j * m_width + i] - interpolated));
+            }
+        }
+        m_levelErrors[level] = maxError * std::fabs(heightScale);
+    }
+}
+
+void TerrainLodTree::UpdateWorldBounds(const XMFLOAT4X4& world)
+{
+    m_worldHeightScale = std::sqrt(world._21 * world._21 + world._22 * world._22 + world._23 * world._23);
+    for (TerrainLodNode& node : m_nodes)
+    {
+        const float localMin[3] = { node.localMin.x, node.localMin.y, node.localMin.z };
+        const float localMax[3] = { node.localMax.x, node.localMax.y, node.localMax.z };
+        float worldMin[3] = { world._41, world._42, world._43 };
+        float worldMax[3] = { world._41, world._42, world._43 };
+
+        for (int row = 0; row < 3; ++row)
+        {
+            for (int column = 0; column < 3; ++column)
+            {
+                float a = world.m[row][column] * localMin[row];
+                float b = world.m[row][column] * localMax[row];
+                worldMin[column] += std::min(a, b);
+                worldMax[column] += std::max(a, b);
+            }
+        }
+
+        node.worldMin = XMFLOAT3(worldMin[0], worldMin[1], worldMin[2]);
+        node.worldMax = XMFLOAT3(worldMax[0], worldMax[1], worldMax[2]);
+    }
+}
+
+void TerrainLodTree::SetLodRanges(float level0Range, float morphStartRatio)
+{
+    m_levelRanges.assign(m_levelCount, FLT_MAX);
+    m_morphStart.assign(m_levelCount, FLT_MAX);
+    m_morphInvRange.assign(m_levelCount, 0.0f);
+
+    float range = level0Range;
+    for (int level = 0; level + 1 < m_levelCount; ++level)
+    {
+        m_levelRanges[level] = range;
+
+        float previousRange = level > 0 ? m_levelRanges[level - 1] : 0.0f;
+        float morphStart = previousRange + (range - previousRange) * morphStartRatio;
+        // El morph termina un poco antes del rango para que en el borde el factor sea 1 exacto
+        float morphEnd = range - (range - morphStart) * 0.01f;
+
+        m_morphStart[level] = morphStart;
+        m_morphInvRange[level] = 1.0f / std::max(morphEnd - morphStart, 0.0001f);
+        range *= 2.0f;
+    }
+    // El nivel de la raiz no tiene limite ni morph (no hay un nivel mas grueso)
+}
+
+float TerrainLodTree::ComputeLevel0Range(float maxPixelError, float viewportHeight, float fieldOfViewY, float morphStartRatio) const
+{
+    // Un error vertical e a distancia d ocupa e * pixelsPerUnit / d pixeles
+    const float pixelsPerUnit = viewportHeight / (2.0f * std::tan(0.5f * fieldOfViewY));
+    float level0Range = 0.0f;
+    for (int level = 1; level < m_levelCount; ++level)
+    {
+        // Inicio del morph del nivel anterior en unidades del rango del nivel 0 (ver SetLodRanges)
+        const float morphStart = level == 1 ? morphStartRatio : static_cast<float>(1 << (level - 2)) * (1.0f + morphStartRatio);
+        level0Range = std::max(level0Range, GetLevelError(level) * pixelsPerUnit / (maxPixelError * morphStart));
+    }
+
+    // Costuras: el morph del nivel L + 1 empieza en rango(L) * (1 + morphStartRatio), con un 1% de holgura por redondeo
+    for (const TerrainLodNode& node : m_nodes)
+    {
+        if (node.level + 2 >= m_levelCount) continue;
+        const float dx = node.worldMax.x - node.worldMin.x;
+        const float dy = node.worldMax.y - node.worldMin.y;
+        const float dz = node.worldMax.z - node.worldMin.z;
+        const float diagonal = std::sqrt(dx * dx + dy * dy + dz * dz);
+        level0Range = std::max(level0Range, 1.01f * diagonal / (morphStartRatio * static_cast<float>(1 << node.level)));
+    }
+    return level0Range;
+}
+
+void TerrainLodTree::GetMorphParameters(int level, float& outMorphStart, float& outMorphInvRange) const
+{
+    outMorphStart = m_morphStart[level];
+    outMorphInvRange = m_morphInvRange[level];
+}
+
+float TerrainLodTree::ComputeMorphFactor(float distance, float morphStart, float morphInvRange)
+{
+    float factor = (distance - morphStart) * morphInvRange;
+    return std::min(std::max(factor, 0.0f), 1.0f);
+}
+
+XMFLOAT2 TerrainLodTree::MorphGridPosition(const XMFLOAT2& gridPosition, float step, float morphFactor, const XMFLOAT2& gridMax)
+{
+    // Los vertices impares (en pasos de 'step') se deslizan hacia el vertice par anterior
+    float x = gridPosition.x;
+    float z = gridPosition.y;
+    if (x < gridMax.x) x -= std::fmod(x, 2.0f * step) * morphFactor;
+    if (z < gridMax.y) z -= std::fmod(z, 2.0f * step) * morphFactor;
+    return XMFLOAT2(x, z);
+}
+
+bool TerrainLodTree::BoxIntersectsSphere(const XMFLOAT3& boxMin, const XMFLOAT3& boxMax, const XMFLOAT3& center, float radius)
+{
+    if (radius >= FLT_MAX) return true;
+
+    float dx = std::max(std::max(boxMin.x - center.x, 0.0f), center.x - boxMax.x);
+    float dy = std::max(std::max(boxMin.y - center.y, 0.0f), center.y - boxMax.y);
+    float dz = std::max(std::max(boxMin.z - center.z, 0.0f), center.z - boxMax.z);
+    return dx * dx + dy * dy + dz * dz <= radius * radius;
+}
+
+void TerrainLodTree::Select(const XMFLOAT3& cameraPosition, const XMFLOAT4X4& viewProjection,
+    std::vector<TerrainLodSelection>& outSelection) const
+{
+    outSelection.clear();
+    if (m_rootNode < 0) return;
+
+    XMFLOAT4 planes[6];
+    TerrainChunkGrid::ExtractFrustumPlanes(viewProjection, planes);
+    SelectNode(m_rootNode, cameraPosition, planes, outSelection);
+}
+
+bool TerrainLodTree::SelectNode(int nodeIndex, const XMFLOAT3& cameraPosition, const XMFLOAT4 planes[6],
+    std::vector<TerrainLodSelection>& outSelection) const
+{
+    const TerrainLodNode& node = m_nodes[nodeIndex];
+
+    // Fuera del rango de su nivel: lo cubre el padre con menos detalle
+    if (!BoxIntersectsSphere(node.worldMin, node.worldMax, cameraPosition, m_levelRanges[node.level])) return false;
+
+    // Fuera del frustum: resuelto sin dibujar nada
+    if (!TerrainChunkGrid::AabbIntersectsFrustum(planes, node.worldMin, node.worldMax)) return true;
+
+    TerrainLodSelection selection;
+    selection.node = nodeIndex;
+    selection.level = node.level;
+
+    if (node.level == 0 ||
+        !BoxIntersectsSphere(node.worldMin, node.worldMax, cameraPosition, m_levelRanges[node.level - 1]))
+    {
+        selection.quadrantMask = 0xF;
+        outSelection.push_back(selection);
+        return true;
+    }
+
+    // Los hijos que entran en el rango inferior se dibujan solos; el resto de cuadrantes, aqui
+    for (int quadrant = 0; quadrant < 4; ++quadrant)
+    {
+        int child = node.children[quadrant];
+        if (child < 0) continue;
+        if (!SelectNode(child, cameraPosition, planes, outSelection))
+        {
+            selection.quadrantMask |= static_cast<uint8_t>(1 << quadrant);
+        }
+    }
+    if (selection.quadrantMask != 0) outSelection.push_back(selection);
+    return true;
+}
+
+size_t TerrainLodTree::CountSelectedIndices(const std::vector<TerrainLodSelection>& selection,
+    const std::vector<TerrainLodNode>& nodes)
+{
+    size_t count = 0;
+    for (const TerrainLodSelection& s : selection)
+    {
+        const TerrainLodNode& node = nodes[s.node];
+        for (int quadrant = 0; quadrant < 4; ++quadrant)
+        {
+            if (s.quadrantMask & (1 << quadrant)) count += node.quadrantCount[quadrant];
+        }
+    }
+    return count;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Nodo del quadtree de LOD. Un nodo de nivel L cubre leafCells * 2^L celdas por lado
+// y se dibuja con una rejilla de leafCells x leafCells quads separados 2^L vertices.
+struct TerrainLodNode
+{
+    int cellX = 0;
+    int cellZ = 0;
+    int cellSize = 0; // Celdas por lado (puede pasarse del borde; los quads de fuera no existen)
+    int level = 0;    // 0 = el mas detallado
+
+    // Indices de cada cuadrante (0: -x-z, 1: +x-z, 2: -x+z, 3: +x+z), seguidos en el index buffer
+    uint32_t quadrantStart[4] = { 0, 0, 0, 0 };
+    uint32_t quadrantCount[4] = { 0, 0, 0, 0 };
+    int children[4] = { -1, -1, -1, -1 };
+
+    DirectX::XMFLOAT3 localMin = { 0.0f, 0.0f, 0.0f };
+    DirectX::XMFLOAT3 localMax = { 0.0f, 0.0f, 0.0f };
+    DirectX::XMFLOAT3 worldMin = { 0.0f, 0.0f, 0.0f };
+    DirectX::XMFLOAT3 worldMax = { 0.0f, 0.0f, 0.0f };
+};
+
+// Nodo elegido para dibujar: quadrantMask indica que cuadrantes van a su nivel
+// (los demas los cubren sus hijos con mas detalle).
+struct TerrainLodSelection
+{
+    int node = -1;
+    int level = 0;
+    uint8_t quadrantMask = 0;
+};
+
+// LOD continuo del terreno (CDLOD).
+// El nivel de cada zona sale de la distancia a la camara: un nodo se subdivide si sus
+// hijos entran en el rango del nivel inferior. Dentro de cada rango los vertices impares
+// se deslizan hacia la rejilla del nivel siguiente (morph), asi que en el borde entre dos
+// niveles los dos lados tienen los mismos vertices y no hay grietas.
+// Los indices apuntan al vertex buffer completo del terreno ((i, altura, j), indice j * width + i);
+// la ultima fila/columna nunca se mueve para que la rejilla del borde coincida en todos los niveles.
+// No depende de D3D: TerrainVS.hlsl repite ComputeMorphFactor/MorphGridPosition.
+class TerrainLodTree
+{
+public:
+    TerrainLodTree();
+
+    // leafCells: quads por lado de cada nodo (par). levelCount se calcula para cubrir el mapa.
+    bool Build(const float* heights, int width, int height, float heightScale, int leafCells);
+
+    void UpdateWorldBounds(const DirectX::XMFLOAT4X4& world);
+
+    // Mayor error vertical (en mundo) de dibujar el mapa con la rejilla del nivel en vez de la completa:
+    // distancia de la altura de cada vertice al triangulo del nivel que lo cubre. 0 en el nivel 0.
+    float GetLevelError(int level) const { return m_levelErrors[level] * m_worldHeightScale; }
+
+    // Rango del nivel 0 para que ningun nivel se vea con mas de maxPixelError pixeles de error en una
+    // pantalla de viewportHeight pixeles con campo de vision vertical fieldOfViewY. La forma del nivel L
+    // aparece donde empieza el morph del L-1, asi que su error se mide a esa distancia. Nunca es menor
+    // que lo que piden las costuras: el morph del nivel grueso tiene que empezar mas alla del rango del
+    // fino mas la diagonal de un nodo fino. Usa las cajas de mundo (llamar antes a UpdateWorldBounds).
+    float ComputeLevel0Range(float maxPixelError, float viewportHeight, float fieldOfViewY, float morphStartRatio) const;
+
+    // Rango (distancia en mundo) del nivel 0; cada nivel dobla el anterior y el ultimo no tiene limite.
+    // morphStartRatio: parte de cada banda a partir de la cual empieza el morph hacia el nivel siguiente.
+    void SetLodRanges(float level0Range, float morphStartRatio);
+
+    // Elige los nodos a dibujar para una camara (posicion en mundo) y su frustum.
+    void Select(const DirectX::XMFLOAT3& cameraPosition, const DirectX::XMFLOAT4X4& viewProjection,
+        std::vector<TerrainLodSelection>& outSelection) const;
+
+    // Inicio del morph y 1 / longitud de la zona de morph del nivel (0 = sin morph).
+    void GetMorphParameters(int level, float& outMorphStart, float& outMorphInvRange) const;
+
+    // 0 = vertice en su sitio, 1 = vertice sobre la rejilla del nivel siguiente.
+    static float ComputeMorphFactor(float distance, float morphStart, float morphInvRange);
+
+    // Posicion en la rejilla (i, j) tras el morph. gridMax = ancho - 1 (y alto - 1).
+    static DirectX::XMFLOAT2 MorphGridPosition(const DirectX::XMFLOAT2& gridPosition, float step,
+        float morphFactor, const DirectX::XMFLOAT2& gridMax);
+
+    static size_t CountSelectedIndices(const std::vector<TerrainLodSelection>& selection,
+        const std::vector<TerrainLodNode>& nodes);
+
+    const std::vector<uint32_t>& GetIndices() const { return m_indices; }
+    const std::vector<TerrainLodNode>& GetNodes() const { return m_nodes; }
+    int GetLevelCount() const { return m_levelCount; }
+    float GetLevelRange(int level) const { return m_levelRanges[level]; }
+
+private:
+    int BuildNode(const float* heights, float heightScale, int cellX, int cellZ, int level);
+    void AppendQuadrantIndices(TerrainLodNode& node, int quadrant);
+    void ComputeLevelErrors(const float* heights, float heightScale);
+    bool SelectNode(int nodeIndex, const DirectX::XMFLOAT3& cameraPosition, const DirectX::XMFLOAT4 planes[6],
+        std::vector<TerrainLodSelection>& outSelection) const;
+
+    static bool BoxIntersectsSphere(const DirectX::XMFLOAT3& boxMin, const DirectX::XMFLOAT3& boxMax,
+        const DirectX::XMFLOAT3& center, float radius);
+
+    int m_width;
+    int m_height;
+    int m_leafCells;
+    int m_levelCount;
+    int m_rootNode;
+
+    std::vector<TerrainLodNode> m_nodes;
+    std::vector<uint32_t> m_indices;
+
+    std::vector<float> m_levelErrors;  // En unidades locales (altura ya escalada)
+    float m_worldHeightScale;          // Escala de la matriz de mundo en Y
+    std::vector<float> m_levelRanges;
+    std::vector<float> m_morphStart;
+    std::vector<float> m_morphInvRange;
+};
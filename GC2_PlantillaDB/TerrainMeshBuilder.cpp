@@ -0,0 +1,197 @@
+#include "TerrainMeshBuilder.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#define TERRAIN_MESH_USE_SSE2 1
+#endif
+
+using namespace DirectX;
+
+static_assert(sizeof(TerrainMeshVertex) == 8 * sizeof(float), "TerrainMeshVertex must be 8 tightly packed floats");
+
+namespace
+{
+    void WriteVertex(TerrainMeshVertex& vertex, float x, float y, float z, float dhdx, float dhdz, float u, float v)
+    {
+        float invLength = 1.0f / std::sqrt(dhdx * dhdx + 1.0f + dhdz * dhdz);
+        vertex.position = XMFLOAT3(x, y, z);
+        vertex.normal = XMFLOAT3(-dhdx * invLength, invLength, -dhdz * invLength);
+        vertex.textureCoordinate = XMFLOAT2(u, v);
+    }
+
+    // Vertice (i, j) con la normal por diferencias centrales (hacia un lado en los bordes).
+    // La usan la construccion escalar y la reconstruccion compacta para dar los mismos bits.
+    template <typename HeightAt>
+    void WriteGridVertex(TerrainMeshVertex& vertex, int i, int j, int width, int height, float heightScale,
+        float uScale, float vScale, const HeightAt& heightAt)
+    {
+        const int left = std::max(i - 1, 0);
+        const int right = std::min(i + 1, width - 1);
+        const int up = std::max(j - 1, 0);
+        const int down = std::min(j + 1, height - 1);
+        float dhdx = (heightAt(right, j) - heightAt(left, j)) * heightScale / static_cast<float>(right - left);
+        float dhdz = (heightAt(i, down) - heightAt(i, up)) * (heightScale / static_cast<float>(down - up));
+        WriteVertex(vertex, static_cast<float>(i), heightAt(i, j) * heightScale, static_cast<float>(j), dhdx, dhdz, i * uScale, j * vScale);
+    }
+
+    // Reparte [firstRow, lastRow) en bandas de ROWS_PER_TASK filas
+    void BuildRowsParallel(const float* heights, int width, int height, float heightScale, float textureTiling,
+        int firstRow, int lastRow, TerrainMeshVertex* outVertices, ThreadPool* pool)
+    {
+        const int rows = lastRow - firstRow;
+        const int bands = (rows + TerrainMeshBuilder::ROWS_PER_TASK - 1) / TerrainMeshBuilder::ROWS_PER_TASK;
+        auto buildBand = [&](int band)
+        {
+            int bandFirst = firstRow + band * TerrainMeshBuilder::ROWS_PER_TASK;
+            int bandLast = std::min(bandFirst + TerrainMeshBuilder::ROWS_PER_TASK, lastRow);
+            TerrainMeshBuilder::BuildVertexRows(heights, width, height, heightScale, textureTiling,
+                bandFirst, bandLast, outVertices + static_cast<size_t>(bandFirst - firstRow) * width);
+        };
+
+        if (pool && bands > 1) pool->ParallelFor(bands, buildBand);
+        else for (int band = 0; band < bands; ++band) buildBand(band);
+    }
+}
+
+void TerrainMeshBuilder::BuildVertexRows(const float* heights, int width, int height, float heightScale, float textureTiling,
+    int firstRow, int lastRow, TerrainMeshVertex* outVertices, bool useSimd)
+{
+    const float uScale = textureTiling / static_cast<float>(width - 1);
+    const float vScale = textureTiling / static_cast<float>(height - 1);
+
+    for (int j = firstRow; j < lastRow; ++j)
+    {
+        TerrainMeshVertex* outRow = outVertices + static_cast<size_t>(j - firstRow) * width;
+
+        auto heightAt = [heights, width](int x, int zRow) { return heights[static_cast<size_t>(zRow) * width + x]; };
+        auto writeScalar = [&](int i)
+        {
+            WriteGridVertex(outRow[i], i, j, width, height, heightScale, uScale, vScale, heightAt);
+        };
+
+        // Bordes izquierdo y derecho en escalar; el interior de 4 en 4
+        writeScalar(0);
+        int i = 1;
+
+#ifdef TERRAIN_MESH_USE_SSE2
+        if (useSimd)
+        {
+            // Filas vecinas (en los bordes, diferencia hacia un solo lado)
+            const int rowUp = std::max(j - 1, 0);
+            const int rowDown = std::min(j + 1, height - 1);
+            const float dzScale = heightScale / static_cast<float>(rowDown - rowUp);
+
+            const float* row = heights + static_cast<size_t>(j) * width;
+            const float* up = heights + static_cast<size_t>(rowUp) * width;
+            const float* down = heights + static_cast<size_t>(rowDown) * width;
+
+            const __m128 laneOffsets = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+            const __m128 halfScale = _mm_set1_ps(heightScale * 0.5f);
+            const __m128 scaleY = _mm_set1_ps(heightScale);
+            const __m128 scaleZ = _mm_set1_ps(dzScale);
+            const __m128 one = _mm_set1_ps(1.0f);
+            const __m128 signMask = _mm_set1_ps(-0.0f);
+            const __m128 uScale4 = _mm_set1_ps(uScale);
+            const __m128 z4 = _mm_set1_ps(static_cast<float>(j));
+            const __m128 v4 = _mm_set1_ps(j * vScale);
+
+            for (; i + 4 <= width - 1; i += 4)
+            {
+                __m128 center = _mm_loadu_ps(row + i);
+                __m128 dhdx = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(row + i + 1), _mm_loadu_ps(row + i - 1)), halfScale);
+                __m128 dhdz = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(down + i), _mm_loadu_ps(up + i)), scaleZ);
+
+                __m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dhdx, dhdx), one), _mm_mul_ps(dhdz, dhdz));
+                __m128 invLength = _mm_div_ps(one, _mm_sqrt_ps(lengthSq));
+                __m128 x = _mm_add_ps(_mm_set1_ps(static_cast<float>(i)), laneOffsets);
+
+                // Cada vertice son 8 floats: (px, py, pz, nx) y (ny, nz, u, v). Se transponen
+                // las dos mitades para escribir los 4 vertices directamente
+                __m128 first0 = x;
+                __m128 first1 = _mm_mul_ps(center, scaleY);
+                __m128 first2 = z4;
+                __m128 first3 = _mm_xor_ps(_mm_mul_ps(dhdx, invLength), signMask);
+                __m128 second0 = invLength;
+                __m128 second1 = _mm_xor_ps(_mm_mul_ps(dhdz, invLength), signMask);
+                __m128 second2 = _mm_mul_ps(x, uScale4);
+                __m128 second3 = v4;
+                _MM_TRANSPOSE4_PS(first0, first1, first2, first3);
+                _MM_TRANSPOSE4_PS(second0, second1, second2, second3);
+
+                float* out = reinterpret_cast<float*>(outRow + i);
+                _mm_storeu_ps(out + 0, first0);
+                _mm_storeu_ps(out + 4, second0);
+                _mm_storeu_ps(out + 8, first1);
+                _mm_storeu_ps(out + 12, second1);
+                _mm_storeu_ps(out + 16, first2);
+                _mm_storeu_ps(out + 20, second2);
+                _mm_storeu_ps(out + 24, first3);
+                _mm_storeu_ps(out + 28, second3);
+            }
+        }
+#endif
+
+        for (; i < width; ++i) writeScalar(i);
+    }
+}
+
+void TerrainMeshBuilder::BuildVertices(const float* heights, int width, int height, float heightScale, float textureTiling,
+    TerrainMeshVertex* outVertices, ThreadPool* pool)
+{
+    if (!heights || !outVertices || width < 2 || height < 2) return;
+    BuildRowsParallel(heights, width, height, heightScale, textureTiling, 0, height, outVertices, pool);
+}
+
+void TerrainMeshBuilder::QuantizeHeights(const float* heights, size_t count, uint16_t* outHeights)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        float clamped = std::min(std::max(heights[i], 0.0f), 1.0f);
+        outHeights[i] = static_cast<uint16_t>(std::lround(clamped * 65535.0f));
+    }
+}
+
+void TerrainMeshBuilder::PackNormals(const TerrainMeshVertex* vertices, size_t count, TerrainPackedNormal* outNormals)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        outNormals[i].x = static_cast<int8_t>(std::lround(std::min(std::max(vertices[i].normal.x, -1.0f), 1.0f) * 127.0f));
+        outNormals[i].z = static_cast<int8_t>(std::lround(std::min(std::max(vertices[i].normal.z, -1.0f), 1.0f) * 127.0f));
+    }
+}
+
+TerrainMeshVertex TerrainMeshBuilder::ReconstructCompactVertex(const uint16_t* heights, int width, int height,
+    float heightScale, float textureTiling, uint32_t vertexId)
+{
+    // Igual que GridPointFromVertexId / GridPointNormal en TerrainVSCommon.hlsli
+    const int i = static_cast<int>(vertexId % static_cast<uint32_t>(width));
+    const int j = static_cast<int>(vertexId / static_cast<uint32_t>(width));
+    auto heightAt = [heights, width](int x, int zRow)
+    {
+        return static_cast<float>(heights[static_cast<size_t>(zRow) * width + x]) / 65535.0f;
+    };
+
+    TerrainMeshVertex vertex;
+    WriteGridVertex(vertex, i, j, width, height, heightScale,
+        textureTiling / static_cast<float>(width - 1), textureTiling / static_cast<float>(height - 1), heightAt);
+    return vertex;
+}
+
+size_t TerrainMeshBuilder::CountCompactMismatches(const uint16_t* heights, int width, int height,
+    float heightScale, float textureTiling, const TerrainMeshVertex* reference)
+{
+    size_t mismatches = 0;
+    const uint32_t vertexCount = static_cast<uint32_t>(width) * static_cast<uint32_t>(height);
+    for (uint32_t vertexId = 0; vertexId < vertexCount; ++vertexId)
+    {
+        TerrainMeshVertex vertex = ReconstructCompactVertex(heights, width, height, heightScale, textureTiling, vertexId);
+        if (memcmp(&vertex, &reference[vertexId], sizeof(TerrainMeshVertex)) != 0) mismatches++;
+    }
+    return mismatches;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+// Mismo layout que DirectX::VertexPositionNormalTexture (TerrainVertex), sin depender de DirectXTK.
+struct TerrainMeshVertex
+{
+    DirectX::XMFLOAT3 position;
+    DirectX::XMFLOAT3 normal;
+    DirectX::XMFLOAT2 textureCoordinate;
+};
+
+// Normal del modo compacto del terreno (R8G8_SNORM): x y z por 127; y se reconstruye (siempre >= 0).
+struct TerrainPackedNormal
+{
+    int8_t x;
+    int8_t z;
+};
+
+// Construye los vertices del terreno a partir del heightfield.
+// Cada normal se obtiene con diferencias centrales de las alturas vecinas (gather), sin
+// recorrer triangulos, asi que cada fila es independiente: se procesan de 4 en 4 vertices
+// con SSE2 y las filas se reparten por bandas entre los hilos del pool.
+// El vertice (i, j) queda en (i, altura * heightScale, j), como en la malla del terreno.
+class TerrainMeshBuilder
+{
+public:
+    static constexpr int ROWS_PER_TASK = 32;
+
+    // pool = nullptr construye en el hilo que llama.
+    static void BuildVertices(const float* heights, int width, int height, float heightScale, float textureTiling,
+        TerrainMeshVertex* outVertices, ThreadPool* pool);
+
+    // Filas [firstRow, lastRow) de la malla.
+    static void BuildVertexRows(const float* heights, int width, int height, float heightScale, float textureTiling,
+        int firstRow, int lastRow, TerrainMeshVertex* outVertices, bool useSimd = true);
+
+    // Modo compacto: alturas en [0, 1] a 16 bits (R16_UNORM) y normales empaquetadas.
+    static void QuantizeHeights(const float* heights, size_t count, uint16_t* outHeights);
+    static void PackNormals(const TerrainMeshVertex* vertices, size_t count, TerrainPackedNormal* outNormals);
+
+    // Referencia en CPU de TerrainCompactVS sin morph: el vertice vertexId (j * width + i)
+    // reconstruido solo a partir de las alturas de 16 bits.
+    static TerrainMeshVertex ReconstructCompactVertex(const uint16_t* heights, int width, int height,
+        float heightScale, float textureTiling, uint32_t vertexId);
+
+    // Vertices de reference (salida de BuildVertices) que no coinciden bit a bit con su reconstruccion.
+    // Es 0 cuando las alturas originales caben en 16 bits (heightmaps de 8 o 16 bits).
+    static size_t CountCompactMismatches(const uint16_t* heights, int width, int height,
+        float heightScale, float textureTiling, const TerrainMeshVertex* reference);
+};
@@ -6,9 +6,13 @@ Texture2D grassTexture : register(t1); // Renombrada para claridad
 Texture2D snowTexture : register(t2); // Renombrada para claridad
 Texture2D rockTexture : register(t3);
 Texture2D shadowMap : register(t4);
+Texture2D splatMap : register(t5); // Pesos (tierra, hierba, nieve, roca) horneados en CPU por TerrainSplatBaker
+Texture2DArray horizonMap : register(t6); // Elevacion del horizonte / (pi/2), un corte por azimut (TerrainHorizonBaker)
 SamplerState textureSampler : register(s0);
 SamplerComparisonState shadowSampler : register(s1);
 
+#include "ShadowCascades.hlsli"
+
 // --- CONSTANT BUFFERS ---
 cbuffer LightProperties : register(b1)
 {
@@ -20,15 +24,6 @@ cbuffer LightProperties : register(b1)
     float4 ambientLightColor;
 };
 
-// NUEVO Constant Buffer para los parmetros del material
-cbuffer TerrainMaterialProperties : register(b2)
-{
-    float dirtMaxHeight; // Altura (0-1) donde termina la transicin tierra -> hierba
-    float grassMaxHeight; // Altura (0-1) donde empieza la transicin hierba -> nieve
-    float blendRange; // Suavidad/ancho de la transicin entre capas
-    float rockSlopeThreshold; // Umbral de pendiente (0-1) para que aparezca la roca
-};
-
 // --- ESTRUCTURA DE ENTRADA ---
 struct PixelInputType
 {
@@ -39,64 +34,51 @@ struct PixelInputType
     float scaledLocalY : TEXCOORD1;
     float maxHeight : TEXCOORD2;
     float4 positionInLightSpace : TEXCOORD3;
+    float2 splatCoord : TEXCOORD4;
 };
 
-// --- FUNCIONES DE AYUDA (PCF para sombras) ---
-float CalculatePCFShadowFactor(Texture2D shadowTex, SamplerComparisonState shadowSamp, float4 lightSpacePos, float bias)
+// --- AUTOSOMBRA DEL TERRENO (mapas de horizonte) ---
+static const float PI = 3.14159265f;
+static const float HORIZON_SOFTNESS = 0.02f; // Media anchura de la penumbra (~1.8 grados)
+
+// Igual que TerrainHorizonBaker::SunVisibility: el azimut k es 2*pi*k/n desde +X hacia +Z (mundo)
+float CalculateHorizonVisibility(float2 horizonCoord, float3 towardsLight)
 {
-    lightSpacePos.xyz /= lightSpacePos.w;
-    float2 shadowTexCoord = float2(lightSpacePos.x * 0.5f + 0.5f, -lightSpacePos.y * 0.5f + 0.5f);
+    uint width, height, azimuthCount;
+    horizonMap.GetDimensions(width, height, azimuthCount);
+    if (azimuthCount == 0) return 1.0f; // Sin mapa: el terreno esta en el shadow map
 
-    float shadowFactor = 0.0f;
-    float2 texelSize;
-    uint width, height;
-    shadowTex.GetDimensions(width, height);
-    texelSize = float2(1.0f / width, 1.0f / height);
+    float azimuth = atan2(towardsLight.z, towardsLight.x);
+    if (azimuth < 0.0f) azimuth += 2.0f * PI;
+    float slice = azimuth / (2.0f * PI) * azimuthCount;
+    float slice0 = fmod(floor(slice), (float)azimuthCount);
+    float slice1 = fmod(slice0 + 1.0f, (float)azimuthCount);
+    float blend = frac(slice);
 
-    for (int y = -2; y <= 2; y++)
-    {
-        for (int x = -2; x <= 2; x++)
-        {
-            shadowFactor += shadowTex.SampleCmpLevelZero(
-                shadowSamp,
-                shadowTexCoord + float2(x, y) * texelSize,
-                lightSpacePos.z - bias
-            );
-        }
-    }
-    return shadowFactor / 25.0f;
+    float horizon0 = horizonMap.SampleLevel(textureSampler, float3(horizonCoord, slice0), 0).r;
+    float horizon1 = horizonMap.SampleLevel(textureSampler, float3(horizonCoord, slice1), 0).r;
+    float horizon = lerp(horizon0, horizon1, blend);
+
+    float elevation = asin(clamp(towardsLight.y, -1.0f, 1.0f)) / (0.5f * PI);
+    return smoothstep(horizon - HORIZON_SOFTNESS, horizon + HORIZON_SOFTNESS, elevation);
 }
 
 // --- SHADER PRINCIPAL ---
 float4 main(PixelInputType input) : SV_TARGET
 {
-    // 1. Muestrear todas las texturas una vez
-    float4 colorDirt = dirtTexture.Sample(textureSampler, input.texCoord);
-    float4 colorGrass = grassTexture.Sample(textureSampler, input.texCoord);
-    float4 colorSnow = snowTexture.Sample(textureSampler, input.texCoord);
-    float4 colorRock = rockTexture.Sample(textureSampler, input.texCoord);
-    
-    // 2. Lgica de mezcla por ALTURA (La parte nueva y mejorada!)
-    // Normalizamos la altura actual del pxel a un rango de 0.0 a 1.0
-    float normalizedHeight = saturate(input.scaledLocalY / input.maxHeight);
-    
-    // Usamos smoothstep para crear transiciones suaves y controlables
-    // Factor para mezclar de tierra a hierba
-    float grassFactor = smoothstep(dirtMaxHeight - blendRange, dirtMaxHeight + blendRange, normalizedHeight);
-    // Factor para mezclar el resultado anterior con la nieve
-    float snowFactor = smoothstep(grassMaxHeight - blendRange, grassMaxHeight + blendRange, normalizedHeight);
-
-    // Mezclamos primero tierra y hierba, y luego el resultado con nieve
-    float4 heightBlendedColor = lerp(colorDirt, colorGrass, grassFactor);
-    heightBlendedColor = lerp(heightBlendedColor, colorSnow, snowFactor);
-
-    // 3. Lgica de mezcla por PENDIENTE (Roca)
-    float3 worldUp = float3(0, 1, 0);
-    float slope = 1.0 - saturate(dot(input.worldNormal, worldUp));
-    float rockFactor = smoothstep(rockSlopeThreshold, rockSlopeThreshold + 0.15, slope); // +0.15 para suavizar la transicin de la roca
+    // 1. Pesos de las capas: la misma mezcla por altura y pendiente que antes se calculaba aqui
+    //    (smoothsteps con CBTerrainPSMaterialData), ya resuelta por vertice en el splat map
+    float4 splat = splatMap.Sample(textureSampler, input.splatCoord);
 
-    // 4. Combinacin final: Mezclamos el color de altura con el de la roca
-    float4 blendedAlbedo = lerp(heightBlendedColor, colorRock, rockFactor);
+    // 2. Solo se muestrean las capas con peso. Los gradientes se calculan fuera de las ramas
+    //    porque dentro de un if dinamico no estan definidos.
+    float2 uvDdx = ddx(input.texCoord);
+    float2 uvDdy = ddy(input.texCoord);
+    float4 blendedAlbedo = float4(0, 0, 0, 0);
+    [branch] if (splat.r > 0.0f) blendedAlbedo += splat.r * dirtTexture.SampleGrad(textureSampler, input.texCoord, uvDdx, uvDdy);
+    [branch] if (splat.g > 0.0f) blendedAlbedo += splat.g * grassTexture.SampleGrad(textureSampler, input.texCoord, uvDdx, uvDdy);
+    [branch] if (splat.b > 0.0f) blendedAlbedo += splat.b * snowTexture.SampleGrad(textureSampler, input.texCoord, uvDdx, uvDdy);
+    [branch] if (splat.a > 0.0f) blendedAlbedo += splat.a * rockTexture.SampleGrad(textureSampler, input.texCoord, uvDdx, uvDdy);
     
     // --- ILUMINACIN Y SOMBRAS (sin cambios) ---
     float3 N = normalize(input.worldNormal);
@@ -116,14 +98,9 @@ float4 main(PixelInputType input) : SV_TARGET
     }
 
     // Clculo de sombras
-    float4 lightSpacePos = input.positionInLightSpace;
-    lightSpacePos.xyz /= lightSpacePos.w;
-    float2 shadowTexCoord = float2(lightSpacePos.x * 0.5f + 0.5f, -lightSpacePos.y * 0.5f + 0.5f);
-    float2 fromCenter = abs(shadowTexCoord - 0.5f) * 2.0f;
-    float dist = max(fromCenter.x, fromCenter.y);
-    float lightVisibility = 1.0 - smoothstep(0.85f, 0.98f, dist);
-    float shadowFactor = CalculatePCFShadowFactor(shadowMap, shadowSampler, input.positionInLightSpace, 0.0005f);
-    float finalLightFactor = lightVisibility * shadowFactor;
+    float shadowFactor = CalculateCascadedShadow(shadowMap, shadowSampler, input.worldPosition, 0.0005f);
+    float horizonFactor = CalculateHorizonVisibility(input.splatCoord, L); // Mismo texel por vertice que el splat map
+    float finalLightFactor = shadowFactor * horizonFactor;
     
     float4 finalColor = ambient + (diffuse + specular) * finalLightFactor;
     finalColor.a = blendedAlbedo.a;
@@ -0,0 +1,325 @@
+#include "TerrainRaycaster.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace DirectX;
+
+namespace
+{
+    // Holgura de las cajas de los nodos para no perder rayos que rozan un borde
+    const float NODE_PADDING = 1.0e-3f;
+
+    XMFLOAT3 Subtract(const XMFLOAT3& a, const XMFLOAT3& b) { return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z); }
+    XMFLOAT3 Cross(const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+    }
+    float Dot(const XMFLOAT3& a, const XMFLOAT3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+    // Moller-Trumbore a doble cara; t en (0, maxT]
+    bool IntersectTriangle(const TerrainRay& ray, const XMFLOAT3& p0, const XMFLOAT3& p1, const XMFLOAT3& p2,
+        float maxT, float& outT)
+    {
+        XMFLOAT3 edge1 = Subtract(p1, p0);
+        XMFLOAT3 edge2 = Subtract(p2, p0);
+        XMFLOAT3 pvec = Cross(ray.direction, edge2);
+        float determinant = Dot(edge1, pvec);
+        if (std::fabs(determinant) < 1.0e-12f) return false;
+
+        float invDeterminant = 1.0f / determinant;
+        XMFLOAT3 tvec = Subtract(ray.origin, p0);
+        float u = Dot(tvec, pvec) * invDeterminant;
+        if (u < 0.0f || u > 1.0f) return false;
+
+        XMFLOAT3 qvec = Cross(tvec, edge1);
+        float v = Dot(ray.direction, qvec) * invDeterminant;
+        if (v < 0.0f || u + v > 1.0f) return false;
+
+        float t = Dot(edge2, qvec) * invDeterminant;
+        if (t <= 0.0f || t > maxT) return false;
+        outT = t;
+        return true;
+    }
+}
+
+TerrainRaycaster::TerrainRaycaster() :
+    m_width(0),
+    m_height(0)
+{
+}
+
+bool TerrainRaycaster::Build(const float* heights, int width, int height, float heightScale)
+{
+    m_levels.clear();
+    m_heights.clear();
+    m_width = 0;
+    m_height = 0;
+    if (!heights || width < 2 || height < 2) return false;
+
+    m_width = width;
+    m_height = height;
+    m_heights.resize(static_cast<size_t>(width) * height);
+    for (size_t i = 0; i < m_heights.size(); ++i) m_heights[i] = heights[i] * heightScale;
+
+    // Nivel 0: minimo y maximo de las cuatro esquinas de cada celda
+    Level cells;
+    cells.width = width - 1;
+    cells.height = height - 1;
+    cells.minHeights.resize(static_cast<size_t>(cells.width) * cells.height);
+    cells.maxHeights.resize(cells.minHeights.size());
+    for (int z = 0; z < cells.height; ++z)
+    {
+        for (int x = 0; x < cells.width; ++x)
+        {
+            const float* row0 = &m_heights[static_cast<size_t>(z) * width + x];
+            const float* row1 = row0 + width;
+            size_t index = static_cast<size_t>(z) * cells.width + x;
+            cells.minHeights[index] = std::min(std::min(row0[0], row0[1]), std::min(row1[0], row1[1]));
+            cells.maxHeights[index] = std::max(std::max(row0[0], row0[1]), std::max(row1[0], row1[1]));
+        }
+    }
+    m_levels.push_back(std::move(cells));
+
+    // Cada nivel junta 2x2 nodos del anterior hasta llegar a un solo nodo
+    while (m_levels.back().width > 1 || m_levels.back().height > 1)
+    {
+        const Level& child = m_levels.back();
+        Level parent;
+        parent.width = (child.width + 1) / 2;
+        parent.height = (child.height + 1) / 2;
+        parent.minHeights.assign(static_cast<size_t>(parent.width) * parent.height, std::numeric_limits<float>::max());
+        parent.maxHeights.assign(parent.minHeights.size(), -std::numeric_limits<float>::max());
+        for (int z = 0; z < child.height; ++z)
+        {
+            for (int x = 0; x < child.width; ++x)
+            {
+                size_t childIndex = static_cast<size_t>(z) * child.width + x;
+                size_t parentIndex = static_cast<size_t>(z / 2) * parent.width + x / 2;
+                parent.minHeights[parentIndex] = std::min(parent.minHeights[parentIndex], child.minHeights[childIndex]);
+                parent.maxHeights[parentIndex] = std::max(parent.maxHeights[parentIndex], child.maxHeights[childIndex]);
+            }
+        }
+        m_levels.push_back(std::move(parent));
+    }
+    return true;
+}
+
+XMFLOAT3 TerrainRaycaster::GetVertex(int x, int z) const
+{
+    return XMFLOAT3(static_cast<float>(x), m_heights[static_cast<size_t>(z) * m_width + x], static_cast<float>(z));
+}
+
+bool TerrainRaycaster::IntersectCell(const TerrainRay& ray, int cellX, int cellZ, float maxT, TerrainRayHit& outHit) const
+{
+    const XMFLOAT3 topLeft = GetVertex(cellX, cellZ);
+    const XMFLOAT3 topRight = GetVertex(cellX + 1, cellZ);
+    const XMFLOAT3 bottomLeft = GetVertex(cellX, cellZ + 1);
+    const XMFLOAT3 bottomRight = GetVertex(cellX + 1, cellZ + 1);
+
+    const XMFLOAT3 triangles[2][3] = { { topLeft, topRight, bottomLeft }, { bottomLeft, topRight, bottomRight } };
+    bool found = false;
+    for (const auto& triangle : triangles)
+    {
+        float t;
+        if (!IntersectTriangle(ray, triangle[0], triangle[1], triangle[2], maxT, t)) continue;
+
+        maxT = t;
+        found = true;
+        outHit.hit = true;
+        outHit.t = t;
+        outHit.cellX = cellX;
+        outHit.cellZ = cellZ;
+
+        // Misma orientacion que las normales de la malla (hacia +Y)
+        XMFLOAT3 normal = Cross(Subtract(triangle[2], triangle[0]), Subtract(triangle[1], triangle[0]));
+        float invLength = 1.0f / std::sqrt(Dot(normal, normal));
+        outHit.normal = XMFLOAT3(normal.x * invLength, normal.y * invLength, normal.z * invLength);
+    }
+    return found;
+}
+
+bool TerrainRaycaster::IntersectNode(const TerrainRay& ray, const XMFLOAT3& inverseDirection, int level, int nodeX, int nodeZ,
+    float maxT, float& outEnterT) const
+{
+    const Level& nodes = m_levels[level];
+    const size_t index = static_cast<size_t>(nodeZ) * nodes.width + nodeX;
+    const int cellsPerNode = 1 << level;
+    const int cellsX = m_levels[0].width;
+    const int cellsZ = m_levels[0].height;
+
+    const float boxMin[3] = {
+        static_cast<float>(nodeX * cellsPerNode) - NODE_PADDING,
+        nodes.minHeights[index] - NODE_PADDING,
+        static_cast<float>(nodeZ * cellsPerNode) - NODE_PADDING };
+    const float boxMax[3] = {
+        static_cast<float>(std::min((nodeX + 1) * cellsPerNode, cellsX)) + NODE_PADDING,
+        nodes.maxHeights[index] + NODE_PADDING,
+        static_cast<float>(std::min((nodeZ + 1) * cellsPerNode, cellsZ)) + NODE_PADDING };
+    const float origin[3] = { ray.origin.x, ray.origin.y, ray.origin.z };
+    const float direction[3] = { ray.direction.x, ray.direction.y, ray.direction.z };
+    const float inverse[3] = { inverseDirection.x, inverseDirection.y, inverseDirection.z };
+
+    float tEnter = 0.0f;
+    float tExit = maxT;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        if (direction[axis] == 0.0f)
+        {
+            if (origin[axis] < boxMin[axis] || origin[axis] > boxMax[axis]) return false;
+            continue;
+        }
+        float t0 = (boxMin[axis] - origin[axis]) * inverse[axis];
+        float t1 = (boxMax[axis] - origin[axis]) * inverse[axis];
+        if (t0 > t1) std::swap(t0, t1);
+        tEnter = std::max(tEnter, t0);
+        tExit = std::min(tExit, t1);
+        if (tEnter > tExit) return false;
+    }
+    outEnterT = tEnter;
+    return true;
+}
+
+bool TerrainRaycaster::IntersectLeaf(const TerrainRay& ray, const XMFLOAT3& inverseDirection, int level, int nodeX, int nodeZ,
+    float enterT, float maxT, TerrainRayHit& outHit) const
+{
+    const Level& cells = m_levels[0];
+    const int firstX = nodeX << level;
+    const int firstZ = nodeZ << level;
+    const int endX = std::min((nodeX + 1) << level, cells.width);
+    const int endZ = std::min((nodeZ + 1) << level, cells.height);
+
+    // Celda donde el rayo entra en la hoja (la caja tiene holgura: se ajusta al rango de la hoja)
+    int cellX = std::min(std::max(static_cast<int>(std::floor(ray.origin.x + ray.direction.x * enterT)), firstX), endX - 1);
+    int cellZ = std::min(std::max(static_cast<int>(std::floor(ray.origin.z + ray.direction.z * enterT)), firstZ), endZ - 1);
+
+    // DDA en XZ (Amanatides-Woo). El siguiente borde se calcula desde el origen en cada paso: sumar
+    // el incremento acumula error y el rayo que pasa cerca de una esquina se salta la celda que roza.
+    const float infinity = std::numeric_limits<float>::infinity();
+    const int stepX = ray.direction.x > 0.0f ? 1 : -1;
+    const int stepZ = ray.direction.z > 0.0f ? 1 : -1;
+    auto boundaryT = [](int cell, int step, float origin, float inverse)
+    {
+        return (static_cast<float>(cell + (step > 0 ? 1 : 0)) - origin) * inverse;
+    };
+    float nextX = ray.direction.x != 0.0f ? boundaryT(cellX, stepX, ray.origin.x, inverseDirection.x) : infinity;
+    float nextZ = ray.direction.z != 0.0f ? boundaryT(cellZ, stepZ, ray.origin.z, inverseDirection.z) : infinity;
+
+    bool found = false;
+    float cellEnterT = enterT;
+    while (cellX >= firstX && cellX < endX && cellZ >= firstZ && cellZ < endZ && cellEnterT <= maxT)
+    {
+        // Tramo del rayo sobre la celda frente a su altura minima y maxima
+        const float cellExitT = std::min(std::min(nextX, nextZ), maxT);
+        const float y0 = ray.origin.y + ray.direction.y * cellEnterT;
+        const float y1 = ray.origin.y + ray.direction.y * cellExitT;
+        const size_t index = static_cast<size_t>(cellZ) * cells.width + cellX;
+        if (std::min(y0, y1) <= cells.maxHeights[index] + NODE_PADDING && std::max(y0, y1) >= cells.minHeights[index] - NODE_PADDING &&
+            IntersectCell(ray, cellX, cellZ, maxT, outHit))
+        {
+            maxT = outHit.t;
+            found = true;
+        }
+
+        if (nextX < nextZ)
+        {
+            cellEnterT = nextX;
+            cellX += stepX;
+            nextX = boundaryT(cellX, stepX, ray.origin.x, inverseDirection.x);
+        }
+        else
+        {
+            cellEnterT = nextZ;
+            cellZ += stepZ;
+            nextZ = boundaryT(cellZ, stepZ, ray.origin.z, inverseDirection.z);
+        }
+    }
+    return found;
+}
+
+bool TerrainRaycaster::Raycast(const TerrainRay& ray, TerrainRayHit& outHit) const
+{
+    outHit = TerrainRayHit();
+    if (m_levels.empty()) return false;
+
+    const XMFLOAT3 inverseDirection(
+        ray.direction.x != 0.0f ? 1.0f / ray.direction.x : 0.0f,
+        ray.direction.y != 0.0f ? 1.0f / ray.direction.y : 0.0f,
+        ray.direction.z != 0.0f ? 1.0f / ray.direction.z : 0.0f);
+
+    struct StackEntry
+    {
+        int level;
+        int x;
+        int z;
+        float enterT;
+    };
+    StackEntry stack[128]; // Cada nivel apila como mucho 4 hijos
+    int stackSize = 0;
+
+    const int rootLevel = static_cast<int>(m_levels.size()) - 1;
+    const int leafLevel = std::min(LEAF_LEVEL, rootLevel);
+    float enterT;
+    if (!IntersectNode(ray, inverseDirection, rootLevel, 0, 0, ray.maxT, enterT)) return false;
+    stack[stackSize++] = { rootLevel, 0, 0, enterT };
+
+    float bestT = ray.maxT;
+    while (stackSize > 0)
+    {
+        const StackEntry entry = stack[--stackSize];
+        if (entry.enterT > bestT) continue; // Empieza detras del mejor impacto
+
+        if (entry.level == leafLevel)
+        {
+            if (IntersectLeaf(ray, inverseDirection, entry.level, entry.x, entry.z, entry.enterT, bestT, outHit)) bestT = outHit.t;
+            continue;
+        }
+
+        // Hijos que toca el rayo, apilados del mas lejano al mas cercano
+        const Level& children = m_levels[entry.level - 1];
+        StackEntry hits[4];
+        int hitCount = 0;
+        for (int child = 0; child < 4; ++child)
+        {
+            int childX = entry.x * 2 + (child & 1);
+            int childZ = entry.z * 2 + (child >> 1);
+            if (childX >= children.width || childZ >= children.height) continue;
+            if (IntersectNode(ray, inverseDirection, entry.level - 1, childX, childZ, bestT, enterT))
+            {
+                hits[hitCount++] = { entry.level - 1, childX, childZ, enterT };
+            }
+        }
+        for (int i = 1; i < hitCount; ++i)
+        {
+            for (int k = i; k > 0 && hits[k - 1].enterT < hits[k].enterT; --k) std::swap(hits[k - 1], hits[k]);
+        }
+        for (int i = 0; i < hitCount; ++i) stack[stackSize++] = hits[i];
+    }
+
+    if (outHit.hit)
+    {
+        outHit.position = XMFLOAT3(ray.origin.x + ray.direction.x * outHit.t, ray.origin.y + ray.direction.y * outHit.t,
+            ray.origin.z + ray.direction.z * outHit.t);
+    }
+    return outHit.hit;
+}
+
+size_t TerrainRaycaster::RaycastBatch(const TerrainRay* rays, size_t count, TerrainRayHit* outHits, ThreadPool* pool) const
+{
+    const int tasks = static_cast<int>((count + RAYS_PER_TASK - 1) / RAYS_PER_TASK);
+    auto castBlock = [&](int task)
+    {
+        size_t first = static_cast<size_t>(task) * RAYS_PER_TASK;
+        size_t last = std::min(first + RAYS_PER_TASK, count);
+        for (size_t i = first; i < last; ++i) Raycast(rays[i], outHits[i]);
+    };
+
+    if (pool && tasks > 1) pool->ParallelFor(tasks, castBlock);
+    else for (int task = 0; task < tasks; ++task) castBlock(task);
+
+    size_t hitCount = 0;
+    for (size_t i = 0; i < count; ++i) hitCount += outHits[i].hit ? 1 : 0;
+    return hitCount;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <vector>
+
+class ThreadPool;
+
+// Rayo en el espacio de la malla del terreno: el vertice (i, j) esta en (i, altura * escala, j).
+// La direccion no tiene que estar normalizada; t se mide en unidades de la direccion.
+struct TerrainRay
+{
+    DirectX::XMFLOAT3 origin = { 0.0f, 0.0f, 0.0f };
+    DirectX::XMFLOAT3 direction = { 0.0f, -1.0f, 0.0f };
+    float maxT = 1.0e30f;
+};
+
+struct TerrainRayHit
+{
+    bool hit = false;
+    float t = 0.0f;
+    DirectX::XMFLOAT3 position = { 0.0f, 0.0f, 0.0f };
+    DirectX::XMFLOAT3 normal = { 0.0f, 1.0f, 0.0f }; // Normal del triangulo (hacia arriba)
+    int cellX = -1; // Celda de la rejilla donde esta el impacto
+    int cellZ = -1;
+};
+
+// Lanzamiento de rayos contra el heightfield del terreno con una piramide min-max:
+// el nivel 0 guarda la altura minima y maxima de cada celda y cada nivel superior la de
+// 2x2 nodos del anterior. El recorrido baja por el quadtree probando primero los hijos
+// mas cercanos y descarta los que empiezan detras del mejor impacto. No baja de LEAF_LEVEL:
+// dentro de una hoja (32x32 celdas) recorre las celdas en orden con un DDA, que es mas barato
+// que cuatro pruebas de caja por nivel, y solo prueba los triangulos de las celdas cuya
+// altura minima y maxima cruza el rayo. Un terreno de una sola hoja es un DDA de todas sus celdas.
+// Los triangulos son los de la malla (topLeft, topRight, bottomLeft) y (bottomLeft, topRight, bottomRight).
+// Solo usa C++ estandar y DirectXMath para los tipos.
+class TerrainRaycaster
+{
+public:
+    TerrainRaycaster();
+
+    // heights: width * height alturas normalizadas; se copian multiplicadas por heightScale.
+    bool Build(const float* heights, int width, int height, float heightScale);
+
+    bool Raycast(const TerrainRay& ray, TerrainRayHit& outHit) const;
+
+    // Lote de rayos; con pool se reparten por bloques entre los hilos.
+    size_t RaycastBatch(const TerrainRay* rays, size_t count, TerrainRayHit* outHits, ThreadPool* pool = nullptr) const;
+
+    int GetLevelCount() const { return static_cast<int>(m_levels.size()); }
+    bool IsBuilt() const { return !m_levels.empty(); }
+
+    static constexpr int RAYS_PER_TASK = 256;
+    static constexpr int LEAF_LEVEL = 5; // Hojas de 2^5 x 2^5 celdas
+
+private:
+    struct Level
+    {
+        int width = 0;  // Nodos por lado
+        int height = 0;
+        std::vector<float> minHeights;
+        std::vector<float> maxHeights;
+    };
+
+    bool IntersectCell(const TerrainRay& ray, int cellX, int cellZ, float maxT, TerrainRayHit& outHit) const;
+    bool IntersectLeaf(const TerrainRay& ray, const DirectX::XMFLOAT3& inverseDirection, int level, int nodeX, int nodeZ,
+        float enterT, float maxT, TerrainRayHit& outHit) const;
+    bool IntersectNode(const TerrainRay& ray, const DirectX::XMFLOAT3& inverseDirection, int level, int nodeX, int nodeZ,
+        float maxT, float& outEnterT) const;
+    DirectX::XMFLOAT3 GetVertex(int x, int z) const;
+
+    std::vector<float> m_heights; // Ya escaladas
+    int m_width;
+    int m_height;
+    std::vector<Level> m_levels; // m_levels[0] = celdas
+};
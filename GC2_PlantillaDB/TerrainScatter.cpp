@@ -0,0 +1,301 @@
+#include "TerrainScatter.h"
+#include "TerrainHeightSampler.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+    const float TWO_PI = 6.28318530717959f;
+
+    // SplitMix64: mismo resultado en cualquier plataforma y barato de sembrar por tesela
+    class ScatterRandom
+    {
+    public:
+        explicit ScatterRandom(uint64_t seed) : m_state(seed) {}
+
+        uint64_t Next()
+        {
+            uint64_t z = (m_state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        // [0, 1) con 24 bits
+        float NextFloat() { return static_cast<float>(Next() >> 40) * (1.0f / 16777216.0f); }
+
+    private:
+        uint64_t m_state;
+    };
+
+    // Semilla de una tesela para una etapa (colocacion o reglas)
+    uint64_t TileSeed(uint32_t seed, int tileX, int tileZ, uint32_t stage)
+    {
+        ScatterRandom mix((static_cast<uint64_t>(seed) << 32) ^ (static_cast<uint64_t>(stage) << 24) ^
+            (static_cast<uint64_t>(static_cast<uint32_t>(tileZ)) << 12) ^ static_cast<uint32_t>(tileX));
+        return mix.Next();
+    }
+
+    float Saturate(float v) { return std::min(std::max(v, 0.0f), 1.0f); }
+
+    // Celda vacia: lejos de cualquier punto, asi la comprobacion de distancia no necesita saltos
+    const float EMPTY_CELL = 1.0e30f;
+
+    // Rejilla de aceleracion del disco de Poisson: como mucho un punto por celda
+    struct PoissonGrid
+    {
+        float originX = 0.0f;
+        float originZ = 0.0f;
+        float cellSize = 1.0f;
+        int cellsX = 0;
+        int cellsZ = 0;
+        int tilesX = 0;
+        int tilesZ = 0;
+        std::vector<XMFLOAT2> points; // (x, z) o EMPTY_CELL
+
+        size_t Index(int cellX, int cellZ) const { return static_cast<size_t>(cellZ) * cellsX + cellX; }
+    };
+
+    bool IsExcluded(float x, float z, const TerrainScatterExclusion* exclusions, size_t exclusionCount)
+    {
+        for (size_t i = 0; i < exclusionCount; ++i)
+        {
+            float dx = x - exclusions[i].x;
+            float dz = z - exclusions[i].z;
+            if (dx * dx + dz * dz < exclusions[i].radius * exclusions[i].radius) return true;
+        }
+        return false;
+    }
+
+    bool IsTooClose(const PoissonGrid& grid, float x, float z, int cellX, int cellZ, float minDistanceSquared)
+    {
+        // Con celdas de minDistance / sqrt(2), basta mirar dos celdas alrededor
+        int firstX = std::max(cellX - 2, 0);
+        int lastX = std::min(cellX + 2, grid.cellsX - 1);
+        int firstZ = std::max(cellZ - 2, 0);
+        int lastZ = std::min(cellZ + 2, grid.cellsZ - 1);
+        bool tooClose = false;
+        for (int z2 = firstZ; z2 <= lastZ; ++z2)
+        {
+            const XMFLOAT2* row = grid.points.data() + grid.Index(0, z2);
+            for (int x2 = firstX; x2 <= lastX; ++x2)
+            {
+                float dx = row[x2].x - x;
+                float dz = row[x2].y - z;
+                tooClose |= dx * dx + dz * dz < minDistanceSquared;
+            }
+            if (tooClose) return true;
+        }
+        return false;
+    }
+
+    void FillTile(PoissonGrid& grid, const TerrainScatterSettings& settings, int tileX, int tileZ,
+        const TerrainScatterExclusion* exclusions, size_t exclusionCount)
+    {
+        ScatterRandom random(TileSeed(settings.seed, tileX, tileZ, 0));
+        const float minDistanceSquared = settings.minDistance * settings.minDistance;
+        const int firstX = tileX * TerrainScatter::CELLS_PER_TILE;
+        const int firstZ = tileZ * TerrainScatter::CELLS_PER_TILE;
+        const int lastX = std::min(firstX + TerrainScatter::CELLS_PER_TILE, grid.cellsX);
+        const int lastZ = std::min(firstZ + TerrainScatter::CELLS_PER_TILE, grid.cellsZ);
+
+        // Solo las exclusiones que tocan la tesela
+        const float tileMinX = grid.originX + firstX * grid.cellSize;
+        const float tileMinZ = grid.originZ + firstZ * grid.cellSize;
+        const float tileMaxX = grid.originX + lastX * grid.cellSize;
+        const float tileMaxZ = grid.originZ + lastZ * grid.cellSize;
+        std::vector<TerrainScatterExclusion> tileExclusions;
+        for (size_t i = 0; i < exclusionCount; ++i)
+        {
+            const TerrainScatterExclusion& zone = exclusions[i];
+            float dx = std::max(std::max(tileMinX - zone.x, zone.x - tileMaxX), 0.0f);
+            float dz = std::max(std::max(tileMinZ - zone.z, zone.z - tileMaxZ), 0.0f);
+            if (dx * dx + dz * dz < zone.radius * zone.radius) tileExclusions.push_back(zone);
+        }
+
+        for (int cellZ = firstZ; cellZ < lastZ; ++cellZ)
+        {
+            for (int cellX = firstX; cellX < lastX; ++cellX)
+            {
+                for (int attempt = 0; attempt < settings.attemptsPerCell; ++attempt)
+                {
+                    float x = grid.originX + (cellX + random.NextFloat()) * grid.cellSize;
+                    float z = grid.originZ + (cellZ + random.NextFloat()) * grid.cellSize;
+                    if (x > settings.maxX || z > settings.maxZ) continue; // Ultima fila/columna de celdas
+                    if (IsExcluded(x, z, tileExclusions.data(), tileExclusions.size())) continue;
+                    if (IsTooClose(grid, x, z, cellX, cellZ, minDistanceSquared)) continue;
+
+                    grid.points[grid.Index(cellX, cellZ)] = XMFLOAT2(x, z);
+                    break;
+                }
+            }
+        }
+    }
+
+    // Reglas sobre los puntos de una tesela, en el orden de sus celdas
+    void EvaluateTile(const PoissonGrid& grid, const TerrainHeightSampler& sampler, const TerrainScatterSettings& settings,
+        const TerrainScatterRule* rules, size_t ruleCount, int tileX, int tileZ,
+        std::vector<TerrainScatterInstance>& outInstances, size_t& outCandidates)
+    {
+        const int firstX = tileX * TerrainScatter::CELLS_PER_TILE;
+        const int firstZ = tileZ * TerrainScatter::CELLS_PER_TILE;
+        const int lastX = std::min(firstX + TerrainScatter::CELLS_PER_TILE, grid.cellsX);
+        const int lastZ = std::min(firstZ + TerrainScatter::CELLS_PER_TILE, grid.cellsZ);
+
+        const int maxPoints = TerrainScatter::CELLS_PER_TILE * TerrainScatter::CELLS_PER_TILE;
+        XMFLOAT2 positions[maxPoints];
+        float heights[maxPoints];
+        uint8_t valid[maxPoints];
+        XMFLOAT3 normals[maxPoints];
+        int count = 0;
+        for (int cellZ = firstZ; cellZ < lastZ; ++cellZ)
+        {
+            for (int cellX = firstX; cellX < lastX; ++cellX)
+            {
+                const XMFLOAT2& point = grid.points[grid.Index(cellX, cellZ)];
+                if (point.x != EMPTY_CELL) positions[count++] = point;
+            }
+        }
+        outCandidates = static_cast<size_t>(count);
+        if (count == 0) return;
+
+        // Alturas y normales de 4 en 4 (SIMD)
+        sampler.SampleHeights(positions, static_cast<size_t>(count), heights, valid, normals);
+
+        ScatterRandom random(TileSeed(settings.seed, tileX, tileZ, 1));
+        float weights[TerrainScatter::MAX_RULES];
+        const size_t evaluatedRules = std::min(ruleCount, TerrainScatter::MAX_RULES);
+        for (int i = 0; i < count; ++i)
+        {
+            // Siempre los mismos numeros por punto, se coloque o no
+            float keep = random.NextFloat();
+            float pick = random.NextFloat();
+            float yaw = random.NextFloat() * TWO_PI;
+            float scale = random.NextFloat();
+            if (!valid[i]) continue;
+
+            float total = 0.0f;
+            for (size_t r = 0; r < evaluatedRules; ++r)
+            {
+                weights[r] = TerrainScatter::RuleWeight(rules[r], heights[i], normals[i].y);
+                total += weights[r];
+            }
+            if (total <= 0.0f || keep >= std::min(total, 1.0f)) continue;
+
+            // Regla proporcional a su peso en este punto
+            float target = pick * total;
+            size_t chosen = 0;
+            for (size_t r = 0; r < evaluatedRules; ++r)
+            {
+                if (weights[r] <= 0.0f) continue;
+                chosen = r; // Con redondeo, se queda la ultima regla valida
+                if (target < weights[r]) break;
+                target -= weights[r];
+            }
+
+            TerrainScatterInstance instance;
+            instance.x = positions[i].x;
+            instance.y = heights[i];
+            instance.z = positions[i].y;
+            instance.yaw = yaw;
+            instance.scale = rules[chosen].minScale + (rules[chosen].maxScale - rules[chosen].minScale) * scale;
+            instance.rule = static_cast<uint32_t>(chosen);
+            outInstances.push_back(instance);
+        }
+    }
+}
+
+float TerrainScatter::RuleWeight(const TerrainScatterRule& rule, float height, float normalY)
+{
+    if (height < rule.minHeight || height > rule.maxHeight || normalY < rule.minNormalY) return 0.0f;
+
+    float weight = rule.density;
+    if (rule.heightFade > 0.0f)
+    {
+        weight *= Saturate((height - rule.minHeight) / rule.heightFade) * Saturate((rule.maxHeight - height) / rule.heightFade);
+    }
+    if (rule.normalFade > 0.0f)
+    {
+        weight *= Saturate((normalY - rule.minNormalY) / rule.normalFade);
+    }
+    return weight;
+}
+
+bool TerrainScatter::Scatter(const TerrainHeightSampler& sampler, const TerrainScatterSettings& settings,
+    const TerrainScatterRule* rules, size_t ruleCount,
+    const TerrainScatterExclusion* exclusions, size_t exclusionCount,
+    std::vector<TerrainScatterInstance>& outInstances, ThreadPool* pool, TerrainScatterStats* outStats)
+{
+    outInstances.clear();
+    if (outStats) *outStats = TerrainScatterStats();
+    if (!sampler.IsReady() || !rules || ruleCount == 0 || settings.minDistance <= 0.0f ||
+        settings.maxX <= settings.minX || settings.maxZ <= settings.minZ || settings.attemptsPerCell < 1)
+    {
+        return false;
+    }
+
+    PoissonGrid grid;
+    grid.originX = settings.minX;
+    grid.originZ = settings.minZ;
+    grid.cellSize = settings.minDistance / std::sqrt(2.0f);
+    double cellsX = std::ceil((settings.maxX - settings.minX) / grid.cellSize);
+    double cellsZ = std::ceil((settings.maxZ - settings.minZ) / grid.cellSize);
+    if (outStats) outStats->cellCount = cellsX * cellsZ;
+    if (cellsX * cellsZ > static_cast<double>(MAX_CELLS))
+    {
+        if (outStats) outStats->regionTooLarge = true;
+        return false;
+    }
+    grid.cellsX = static_cast<int>(cellsX);
+    grid.cellsZ = static_cast<int>(cellsZ);
+    grid.tilesX = (grid.cellsX + CELLS_PER_TILE - 1) / CELLS_PER_TILE;
+    grid.tilesZ = (grid.cellsZ + CELLS_PER_TILE - 1) / CELLS_PER_TILE;
+    const size_t cellCount = static_cast<size_t>(grid.cellsX) * grid.cellsZ;
+    grid.points.assign(cellCount, XMFLOAT2(EMPTY_CELL, EMPTY_CELL));
+
+    // 1. Disco de Poisson en cuatro fases; las teselas de una fase no se tocan entre si
+    for (int phase = 0; phase < 4; ++phase)
+    {
+        const int parityX = phase & 1;
+        const int parityZ = phase >> 1;
+        const int phaseTilesX = (grid.tilesX - parityX + 1) / 2;
+        const int phaseTilesZ = (grid.tilesZ - parityZ + 1) / 2;
+        const int phaseTiles = phaseTilesX * phaseTilesZ;
+        auto fillTile = [&](int task)
+        {
+            FillTile(grid, settings, parityX + 2 * (task % phaseTilesX), parityZ + 2 * (task / phaseTilesX), exclusions, exclusionCount);
+        };
+
+        if (pool && phaseTiles > 1) pool->ParallelFor(phaseTiles, fillTile);
+        else for (int task = 0; task < phaseTiles; ++task) fillTile(task);
+    }
+
+    // 2. Reglas por tesela y concatenacion en orden de teselas
+    const int tileCount = grid.tilesX * grid.tilesZ;
+    std::vector<std::vector<TerrainScatterInstance>> tileInstances(tileCount);
+    std::vector<size_t> tileCandidates(tileCount, 0);
+    auto evaluateTile = [&](int tile)
+    {
+        EvaluateTile(grid, sampler, settings, rules, ruleCount, tile % grid.tilesX, tile / grid.tilesX,
+            tileInstances[tile], tileCandidates[tile]);
+    };
+
+    if (pool && tileCount > 1) pool->ParallelFor(tileCount, evaluateTile);
+    else for (int tile = 0; tile < tileCount; ++tile) evaluateTile(tile);
+
+    size_t total = 0;
+    size_t candidates = 0;
+    for (int tile = 0; tile < tileCount; ++tile)
+    {
+        total += tileInstances[tile].size();
+        candidates += tileCandidates[tile];
+    }
+    outInstances.reserve(total);
+    for (const auto& instances : tileInstances) outInstances.insert(outInstances.end(), instances.begin(), instances.end());
+    if (outStats) outStats->candidateCount = candidates;
+    return true;
+}
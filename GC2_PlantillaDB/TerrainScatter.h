@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+class TerrainHeightSampler;
+
+// Una especie (modelo) que puede aparecer en un punto. La probabilidad de la regla en un punto es
+// density por las transiciones de altura y pendiente; entre las reglas validas se elige en proporcion.
+struct TerrainScatterRule
+{
+    float density = 1.0f;          // Probabilidad maxima (0..1) de ocupar un punto de Poisson
+    float minHeight = -1.0e30f;    // Y de mundo
+    float maxHeight = 1.0e30f;
+    float heightFade = 0.0f;       // Ancho (unidades de mundo) de la transicion en los limites de altura
+    float minNormalY = 0.0f;       // Pendiente maxima: normal.y minima de la superficie
+    float normalFade = 0.0f;       // Ancho de la transicion de pendiente (en normal.y)
+    float minScale = 1.0f;
+    float maxScale = 1.0f;
+};
+
+// Circulo (x, z de mundo) sin vegetacion, p.ej. alrededor de un edificio.
+struct TerrainScatterExclusion
+{
+    float x = 0.0f;
+    float z = 0.0f;
+    float radius = 0.0f;
+};
+
+struct TerrainScatterSettings
+{
+    uint32_t seed = 1;
+    float minX = 0.0f;        // Region de mundo a cubrir
+    float minZ = 0.0f;
+    float maxX = 0.0f;
+    float maxZ = 0.0f;
+    float minDistance = 1.0f; // Separacion minima entre dos instancias (disco de Poisson)
+    int attemptsPerCell = 4;  // Dardos por celda de la rejilla de aceleracion
+};
+
+struct TerrainScatterInstance
+{
+    float x = 0.0f;
+    float y = 0.0f;     // Altura del terreno en (x, z)
+    float z = 0.0f;
+    float yaw = 0.0f;   // Radianes
+    float scale = 1.0f;
+    uint32_t rule = 0;  // Indice en el array de reglas
+};
+
+// Cifras de una llamada a Scatter, para que quien llama las registre.
+struct TerrainScatterStats
+{
+    bool regionTooLarge = false;  // La rejilla de aceleracion pasaria de MAX_CELLS (Scatter devuelve false)
+    double cellCount = 0.0;       // Celdas de la rejilla que pide la region, aunque pase del limite
+    size_t candidateCount = 0;    // Puntos de Poisson antes de aplicar las reglas
+};
+
+// Vegetacion procedural sobre el terreno: muestreo de disco de Poisson en la region (dardos sobre
+// una rejilla de celdas de minDistance / sqrt(2), una muestra por celda) y reglas de altura y
+// pendiente evaluadas con TerrainHeightSampler. La region se reparte en teselas que se procesan en
+// cuatro fases (tesela par/impar en X y en Z): dos teselas de la misma fase nunca estan a menos de
+// minDistance, asi que se rellenan en paralelo, y cada una usa su propia semilla. El resultado solo
+// depende de la semilla y la entrada, no del numero de hilos.
+class TerrainScatter
+{
+public:
+    static constexpr int CELLS_PER_TILE = 8;
+    static constexpr size_t MAX_RULES = 16; // Las reglas de mas se ignoran
+    static constexpr size_t MAX_CELLS = size_t(1) << 26; // Limite de la rejilla de aceleracion
+
+    // Sustituye outInstances. Devuelve false si la entrada no es valida o la rejilla seria demasiado
+    // grande (outStats->regionTooLarge).
+    static bool Scatter(const TerrainHeightSampler& sampler, const TerrainScatterSettings& settings,
+        const TerrainScatterRule* rules, size_t ruleCount,
+        const TerrainScatterExclusion* exclusions, size_t exclusionCount,
+        std::vector<TerrainScatterInstance>& outInstances, ThreadPool* pool = nullptr,
+        TerrainScatterStats* outStats = nullptr);
+
+    // Probabilidad de la regla en un punto con la altura y normal.y dadas.
+    static float RuleWeight(const TerrainScatterRule& rule, float height, float normalY);
+};
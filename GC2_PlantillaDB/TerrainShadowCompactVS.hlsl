@@ -0,0 +1,10 @@
+// Pasada de sombras del terreno en modo compacto: solo la posicion, reconstruida desde SV_VertexID.
+// ViewProjection lleva la view-projection de la luz.
+#include "TerrainVSCommon.hlsli"
+
+float4 main(uint vertexId : SV_VertexID) : SV_POSITION
+{
+    float3 localPosition = GridPointLocalPosition(GridPointFromVertexId(vertexId));
+    float4 worldPos = mul(float4(localPosition, 1.0f), transpose(World));
+    return mul(worldPos, transpose(ViewProjection));
+}
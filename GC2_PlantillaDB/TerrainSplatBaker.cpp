@@ -0,0 +1,106 @@
+#include "pch.h"
+#include "TerrainSplatBaker.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+    // Igual que smoothstep de HLSL
+    float SmoothStep(float edge0, float edge1, float x)
+    {
+        float t = std::min(std::max((x - edge0) / (edge1 - edge0), 0.0f), 1.0f);
+        return t * t * (3.0f - 2.0f * t);
+    }
+
+    float Saturate(float x) { return std::min(std::max(x, 0.0f), 1.0f); }
+}
+
+void TerrainSplatBaker::ComputeWeights(float normalizedHeight, float worldNormalY, const TerrainSplatMaterial& material, float outWeights[4])
+{
+    float height = Saturate(normalizedHeight);
+    float grass = SmoothStep(material.dirtMaxHeight - material.blendRange, material.dirtMaxHeight + material.blendRange, height);
+    float snow = SmoothStep(material.grassMaxHeight - material.blendRange, material.grassMaxHeight + material.blendRange, height);
+    float slope = 1.0f - Saturate(worldNormalY);
+    float rock = SmoothStep(material.rockSlopeThreshold, material.rockSlopeThreshold + material.rockBlendRange, slope);
+
+    outWeights[0] = (1.0f - grass) * (1.0f - snow) * (1.0f - rock);
+    outWeights[1] = grass * (1.0f - snow) * (1.0f - rock);
+    outWeights[2] = snow * (1.0f - rock);
+    outWeights[3] = rock;
+}
+
+uint32_t TerrainSplatBaker::PackWeights(const float weights[4])
+{
+    int quantized[4];
+    int sum = 0;
+    int largest = 0;
+    for (int k = 0; k < 4; ++k)
+    {
+        quantized[k] = static_cast<int>(Saturate(weights[k]) * 255.0f + 0.5f);
+        sum += quantized[k];
+        if (weights[k] > weights[largest]) largest = k;
+    }
+
+    // El redondeo puede dejar la suma en 253..257; la diferencia va a la capa dominante
+    quantized[largest] = std::min(std::max(quantized[largest] + 255 - sum, 0), 255);
+
+    return static_cast<uint32_t>(quantized[0]) | (static_cast<uint32_t>(quantized[1]) << 8) |
+        (static_cast<uint32_t>(quantized[2]) << 16) | (static_cast<uint32_t>(quantized[3]) << 24);
+}
+
+void TerrainSplatBaker::Bake(const float* heights, int width, int height, float heightScale, const XMFLOAT4X4& world,
+    const TerrainSplatMaterial& material, uint32_t* outTexels, ThreadPool* pool)
+{
+    if (!heights || !outTexels || width < 2 || height < 2) return;
+
+    // Normales a mundo con la matriz de cofactores de la 3x3 (det * inversa traspuesta): solo importa
+    // la direccion, asi que basta con corregir el signo del determinante.
+    const float cofactor[3][3] = {
+        { world._22 * world._33 - world._23 * world._32, -(world._21 * world._33 - world._23 * world._31), world._21 * world._32 - world._22 * world._31 },
+        { -(world._12 * world._33 - world._13 * world._32), world._11 * world._33 - world._13 * world._31, -(world._11 * world._32 - world._12 * world._31) },
+        { world._12 * world._23 - world._13 * world._22, -(world._11 * world._23 - world._13 * world._21), world._11 * world._22 - world._12 * world._21 } };
+    const float determinant = world._11 * cofactor[0][0] + world._12 * cofactor[0][1] + world._13 * cofactor[0][2];
+    const float sign = determinant < 0.0f ? -1.0f : 1.0f;
+
+    auto heightAt = [&](int i, int j) { return heights[static_cast<size_t>(j) * width + i]; };
+
+    const int bands = (height + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+    auto bakeBand = [&](int band)
+    {
+        int firstRow = band * ROWS_PER_TASK;
+        int lastRow = std::min(firstRow + ROWS_PER_TASK, height);
+        for (int j = firstRow; j < lastRow; ++j)
+        {
+            const int up = std::max(j - 1, 0);
+            const int down = std::min(j + 1, height - 1);
+            for (int i = 0; i < width; ++i)
+            {
+                // Misma normal local que TerrainMeshBuilder / GridPointNormal
+                const int left = std::max(i - 1, 0);
+                const int right = std::min(i + 1, width - 1);
+                float dhdx = (heightAt(right, j) - heightAt(left, j)) * heightScale / static_cast<float>(right - left);
+                float dhdz = (heightAt(i, down) - heightAt(i, up)) * (heightScale / static_cast<float>(down - up));
+                const float local[3] = { -dhdx, 1.0f, -dhdz };
+
+                float normal[3];
+                for (int c = 0; c < 3; ++c)
+                {
+                    normal[c] = sign * (local[0] * cofactor[0][c] + local[1] * cofactor[1][c] + local[2] * cofactor[2][c]);
+                }
+                float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+                float worldNormalY = length > 0.0f ? normal[1] / length : 1.0f;
+
+                float weights[4];
+                ComputeWeights(heightAt(i, j), worldNormalY, material, weights);
+                outTexels[static_cast<size_t>(j) * width + i] = PackWeights(weights);
+            }
+        }
+    };
+
+    if (pool && bands > 1) pool->ParallelFor(bands, bakeBand);
+    else for (int band = 0; band < bands; ++band) bakeBand(band);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+
+class ThreadPool;
+
+// Parametros de mezcla de capas (los mismos que CBTerrainPSMaterialData).
+struct TerrainSplatMaterial
+{
+    float dirtMaxHeight = 0.05f;      // Altura (0-1) donde termina la transicion tierra -> hierba
+    float grassMaxHeight = 0.40f;     // Altura (0-1) donde empieza la transicion hierba -> nieve
+    float blendRange = 0.05f;         // Ancho de las transiciones por altura
+    float rockSlopeThreshold = 0.45f; // Pendiente (1 - normal.y) donde empieza la roca
+    float rockBlendRange = 0.15f;     // Ancho de la transicion de la roca
+};
+
+// Hornea en CPU los pesos de las cuatro capas del terreno (tierra, hierba, nieve, roca) en una
+// textura RGBA8 con un texel por vertice de la rejilla. Los pesos son los de la mezcla que hacia
+// TerrainPS por pixel: lerp(lerp(lerp(tierra, hierba, g), nieve, s), roca, r) desarrollado en
+// (1-g)(1-s)(1-r), g(1-s)(1-r), s(1-r) y r, con la altura normalizada y la normal de mundo.
+// Cada texel suma exactamente 255 para que el filtrado bilineal mantenga la suma en 1.
+class TerrainSplatBaker
+{
+public:
+    static constexpr int ROWS_PER_TASK = 64;
+
+    // Pesos (tierra, hierba, nieve, roca) de un punto; suman 1.
+    static void ComputeWeights(float normalizedHeight, float worldNormalY, const TerrainSplatMaterial& material, float outWeights[4]);
+
+    // Pesos cuantizados a 8 bits (R = tierra ... A = roca) con suma 255.
+    static uint32_t PackWeights(const float weights[4]);
+
+    // heights: width * height alturas normalizadas. world: matriz de mundo del terreno (fila-mayor);
+    // la pendiente se mide con la normal de mundo, como en el shader. outTexels: width * height texeles.
+    static void Bake(const float* heights, int width, int height, float heightScale, const DirectX::XMFLOAT4X4& world,
+        const TerrainSplatMaterial& material, uint32_t* outTexels, ThreadPool* pool = nullptr);
+};
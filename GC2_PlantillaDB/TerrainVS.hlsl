@@ -1,11 +1,4 @@
-cbuffer CBTerrainVSData : register(b0)
-{
-    matrix World;
-    matrix ViewProjection;
-    matrix LightViewProjection;
-    matrix WorldInverseTranspose;
-    float MaxTerrainHeightLocal; 
-};
+#include "TerrainVSCommon.hlsli"
 
 struct VertexInputType
 {
@@ -14,31 +7,7 @@ struct VertexInputType
     float2 texCoord : TEXCOORD0;
 };
 
-struct PixelInputType
-{
-    float4 clipSpacePosition : SV_POSITION;
-    float2 texCoord : TEXCOORD0; // Coordenadas de textura para muestreo
-    float3 worldNormal : NORMAL; // Normal en espacio del mundo para iluminacin
-    float3 worldPosition : WORLDPOS; // Posicin en espacio del mundo para iluminacin
-    float scaledLocalY : TEXCOORD1; // Y local escalada (altura real local)
-    float maxHeight : TEXCOORD2; // MaxTerrainHeightLocal para el clculo de mezcla
-    float4 positionInLightSpace : TEXCOORD3;
-};
-
 PixelInputType main(VertexInputType input)
 {
-    PixelInputType output;
-
-    float4 worldPos = mul(float4(input.localPosition, 1.0f), transpose(World));
-    output.worldPosition = worldPos.xyz;
-    output.clipSpacePosition = mul(worldPos, transpose(ViewProjection));
-
-    output.worldNormal = normalize(mul(input.localNormal, (float3x3) WorldInverseTranspose));
-    output.texCoord = input.texCoord; // Pasa las UVs multiplicadas por m_textureTilingFactor
-
-    output.scaledLocalY = input.localPosition.y; // Esta es la altura ya escalada por m_heightScale
-    output.maxHeight = MaxTerrainHeightLocal; // m_heightScale (ya que los datos del heightmap van de 0-1)
-    output.positionInLightSpace = mul(worldPos, transpose(LightViewProjection));
-
-    return output;
-}
\ No newline at end of file
+    return BuildTerrainVertex(input.localPosition, input.localNormal);
+}
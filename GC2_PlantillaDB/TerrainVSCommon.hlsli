@@ -0,0 +1,106 @@
+// Constantes, alturas y morph compartidos por los vertex shaders del terreno
+// (TerrainVS con el vertex buffer completo y TerrainCompactVS / TerrainShadowCompactVS sin posiciones).
+
+cbuffer CBTerrainVSData : register(b0)
+{
+    matrix World;
+    matrix ViewProjection;
+    matrix LightViewProjection;
+    matrix WorldInverseTranspose;
+    float MaxTerrainHeightLocal;
+    float MorphStart;     // LOD continuo: distancia donde empieza el morph del nivel que se dibuja
+    float MorphInvRange;  // 1 / longitud de la zona de morph (0 = sin morph)
+    float LodStep;        // Separacion de la rejilla del nivel (1, 2, 4...)
+    float3 CameraPositionWorld;
+    float GridMaxX;       // Ancho del heightmap - 1
+    float GridMaxZ;       // Alto del heightmap - 1
+    float HeightmapWidth;
+    float TextureTiling;
+    float _padLod;
+};
+
+// Alturas normalizadas del heightmap (ancho * alto). R32_FLOAT con el vertex buffer completo,
+// R16_UNORM en el modo compacto (donde es la unica copia de las alturas en la GPU).
+Buffer<float> HeightData : register(t0);
+
+struct PixelInputType
+{
+    float4 clipSpacePosition : SV_POSITION;
+    float2 texCoord : TEXCOORD0; // Coordenadas de textura para muestreo
+    float3 worldNormal : NORMAL; // Normal en espacio del mundo para iluminacion
+    float3 worldPosition : WORLDPOS; // Posicion en espacio del mundo para iluminacion
+    float scaledLocalY : TEXCOORD1; // Y local escalada (altura real local)
+    float maxHeight : TEXCOORD2; // MaxTerrainHeightLocal para el calculo de mezcla
+    float4 positionInLightSpace : TEXCOORD3;
+    float2 splatCoord : TEXCOORD4; // Centro del texel del splat map (un texel por vertice)
+};
+
+float LoadHeight(int2 gridPoint)
+{
+    gridPoint = clamp(gridPoint, int2(0, 0), int2(GridMaxX, GridMaxZ));
+    return HeightData.Load(gridPoint.y * (int)HeightmapWidth + gridPoint.x);
+}
+
+float SampleHeight(float2 gridPosition)
+{
+    float2 cell = floor(gridPosition);
+    float2 f = gridPosition - cell;
+    int2 p = (int2)cell;
+    float h0 = lerp(LoadHeight(p), LoadHeight(p + int2(1, 0)), f.x);
+    float h1 = lerp(LoadHeight(p + int2(0, 1)), LoadHeight(p + int2(1, 1)), f.x);
+    return lerp(h0, h1, f.y);
+}
+
+// El index buffer guarda j * ancho + i, asi que SV_VertexID ya es el punto de la rejilla
+int2 GridPointFromVertexId(uint vertexId)
+{
+    uint width = (uint)HeightmapWidth;
+    return int2(vertexId % width, vertexId / width);
+}
+
+// Misma normal que TerrainMeshBuilder: diferencias centrales, hacia un lado en los bordes
+float3 GridPointNormal(int2 p)
+{
+    int2 lower = max(p - 1, int2(0, 0));
+    int2 upper = min(p + 1, int2(GridMaxX, GridMaxZ));
+    float dhdx = (LoadHeight(int2(upper.x, p.y)) - LoadHeight(int2(lower.x, p.y))) * MaxTerrainHeightLocal / (float)(upper.x - lower.x);
+    float dhdz = (LoadHeight(int2(p.x, upper.y)) - LoadHeight(int2(p.x, lower.y))) * MaxTerrainHeightLocal / (float)(upper.y - lower.y);
+    return normalize(float3(-dhdx, 1.0f, -dhdz));
+}
+
+// Vertice de la rejilla en espacio local: (i, altura * escala, j)
+float3 GridPointLocalPosition(int2 p)
+{
+    return float3((float)p.x, LoadHeight(p) * MaxTerrainHeightLocal, (float)p.y);
+}
+
+PixelInputType BuildTerrainVertex(float3 unmorphedLocalPosition, float3 localNormal)
+{
+    PixelInputType output;
+
+    // Morph CDLOD (igual que TerrainLodTree::ComputeMorphFactor/MorphGridPosition):
+    // los vertices impares del nivel se deslizan hacia la rejilla del nivel siguiente segun la distancia.
+    float4 unmorphedWorldPos = mul(float4(unmorphedLocalPosition, 1.0f), transpose(World));
+    float morphFactor = saturate((distance(unmorphedWorldPos.xyz, CameraPositionWorld) - MorphStart) * MorphInvRange);
+
+    float2 gridPosition = unmorphedLocalPosition.xz;
+    float2 gridMax = float2(GridMaxX, GridMaxZ);
+    float2 canMorph = step(gridPosition, gridMax - 0.5f); // El borde del mapa no se mueve
+    gridPosition -= fmod(gridPosition, 2.0f * LodStep) * morphFactor * canMorph;
+
+    float3 localPosition = float3(gridPosition.x, SampleHeight(gridPosition) * MaxTerrainHeightLocal, gridPosition.y);
+
+    float4 worldPos = mul(float4(localPosition, 1.0f), transpose(World));
+    output.worldPosition = worldPos.xyz;
+    output.clipSpacePosition = mul(worldPos, transpose(ViewProjection));
+
+    output.worldNormal = normalize(mul(localNormal, (float3x3) WorldInverseTranspose));
+    output.texCoord = gridPosition / gridMax * TextureTiling; // Mismas UVs que el vertex buffer, tras el morph
+    output.splatCoord = (gridPosition + 0.5f) / (gridMax + 1.0f);
+
+    output.scaledLocalY = localPosition.y; // Esta es la altura ya escalada por m_heightScale
+    output.maxHeight = MaxTerrainHeightLocal; // m_heightScale (ya que los datos del heightmap van de 0-1)
+    output.positionInLightSpace = mul(worldPos, transpose(LightViewProjection));
+
+    return output;
+}
@@ -0,0 +1,280 @@
+// Camera con posiciones y giros aleatorios: la vista, la inversa y la vista-proyeccion perezosas
+// frente a invertir (rotacion * traslacion) construidas aqui a mano, despues de cambios con los
+// getters ya llamados (como en Game::Update, varias llamadas por frame y cambios de tamano de
+// ventana). Ademas, el frustum cacheado frente a la prueba en espacio de recorte, la proyeccion
+// con Z invertida frente a la normal y el cuaternion de GetRotation frente a los ejes. Imprime el
+// paso de profundidad de un float32 en el plano lejano con las dos proyecciones.
+//
+//   CameraTest          20000 posiciones
+//   CameraTest --quick  2000 (lo que ejecuta ctest)
+
+#include "Camera.h"
+#include "Check.h"
+#include "Measure.h"
+#include "TestMatrices.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+    struct CameraValidationResult
+    {
+        size_t samples = 0;
+        float maxViewError = 0.0f;          // Vista analitica frente a (rotacion * traslacion) invertida
+        float maxInverseError = 0.0f;       // Vista * inversa frente a la identidad
+        float maxViewProjectionError = 0.0f;
+        float maxRotationError = 0.0f;      // Ejes girados con GetRotation frente a GetForward y GetRight
+        size_t frustumMismatches = 0;       // Puntos dentro/fuera del frustum distinto que en espacio de recorte
+        size_t reversedZMismatches = 0;     // Profundidad invertida no monotona, fuera de [0, 1] o xy distinto
+        float standardDepthStep = 0.0f;     // Paso de profundidad en float32 en el plano lejano con Z normal...
+        float reversedDepthStep = 0.0f;     // ...y con Z invertida (unidades de mundo)
+    };
+
+    // Como Matrix::CreateRotationX / CreateRotationY / CreateTranslation
+    XMFLOAT4X4 RotationX(float angle)
+    {
+        XMFLOAT4X4 m = TestMatrices::Identity();
+        m._22 = std::cos(angle);
+        m._23 = std::sin(angle);
+        m._32 = -std::sin(angle);
+        m._33 = std::cos(angle);
+        return m;
+    }
+
+    XMFLOAT4X4 RotationY(float angle)
+    {
+        XMFLOAT4X4 m = TestMatrices::Identity();
+        m._11 = std::cos(angle);
+        m._13 = -std::sin(angle);
+        m._31 = std::sin(angle);
+        m._33 = std::cos(angle);
+        return m;
+    }
+
+    XMFLOAT4X4 Translation(const XMFLOAT3& p)
+    {
+        XMFLOAT4X4 m = TestMatrices::Identity();
+        m._41 = p.x;
+        m._42 = p.y;
+        m._43 = p.z;
+        return m;
+    }
+
+    // Gauss-Jordan con pivote parcial (el camino anterior de la camara era Matrix::Invert)
+    XMFLOAT4X4 Invert(const XMFLOAT4X4& m)
+    {
+        double a[4][8];
+        for (int r = 0; r < 4; ++r)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                a[r][c] = m.m[r][c];
+                a[r][c + 4] = r == c ? 1.0 : 0.0;
+            }
+        }
+        for (int c = 0; c < 4; ++c)
+        {
+            int pivot = c;
+            for (int r = c + 1; r < 4; ++r)
+            {
+                if (std::fabs(a[r][c]) > std::fabs(a[pivot][c])) pivot = r;
+            }
+            std::swap(a[c], a[pivot]);
+            const double scale = 1.0 / a[c][c];
+            for (int k = 0; k < 8; ++k) a[c][k] *= scale;
+            for (int r = 0; r < 4; ++r)
+            {
+                if (r == c) continue;
+                const double factor = a[r][c];
+                for (int k = 0; k < 8; ++k) a[r][k] -= factor * a[c][k];
+            }
+        }
+        XMFLOAT4X4 inverse;
+        for (int r = 0; r < 4; ++r)
+        {
+            for (int c = 0; c < 4; ++c) inverse.m[r][c] = static_cast<float>(a[r][c + 4]);
+        }
+        return inverse;
+    }
+
+    float MaxDifference(const XMFLOAT4X4& a, const XMFLOAT4X4& b)
+    {
+        float difference = 0.0f;
+        for (int r = 0; r < 4; ++r)
+        {
+            for (int c = 0; c < 4; ++c) difference = std::max(difference, std::fabs(a.m[r][c] - b.m[r][c]));
+        }
+        return difference;
+    }
+
+    float MaxDifference(const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        return std::max({ std::fabs(a.x - b.x), std::fabs(a.y - b.y), std::fabs(a.z - b.z) });
+    }
+
+    XMFLOAT3 Cross(const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+    }
+
+    XMFLOAT3 MultiplyAdd(const XMFLOAT3& a, const XMFLOAT3& b, float s)
+    {
+        return XMFLOAT3(a.x + b.x * s, a.y + b.y * s, a.z + b.z * s);
+    }
+
+    // v' = q v q^-1 (como XMVector3Rotate)
+    XMFLOAT3 Rotate(const XMFLOAT3& v, const XMFLOAT4& q)
+    {
+        const XMFLOAT3 axis(q.x, q.y, q.z);
+        const XMFLOAT3 t = Cross(axis, v);
+        const XMFLOAT3 twiceT(2.0f * t.x, 2.0f * t.y, 2.0f * t.z);
+        return MultiplyAdd(MultiplyAdd(v, twiceT, q.w), Cross(axis, twiceT), 1.0f);
+    }
+
+    // Mundo de la camara como lo construia el camino anterior: CreateFromYawPitchRoll * traslacion
+    XMFLOAT4X4 DirectView(const Camera& camera)
+    {
+        const XMFLOAT4X4 rotation = TestMatrices::Multiply(RotationX(camera.GetPitch()), RotationY(camera.GetYaw()));
+        return Invert(TestMatrices::Multiply(rotation, Translation(camera.GetPosition())));
+    }
+
+    XMFLOAT4X4 CullProjection(const Camera& camera)
+    {
+        return TestMatrices::Perspective(camera.GetFieldOfView(), camera.GetAspectRatio(), camera.GetNearPlane(), camera.GetFarPlane());
+    }
+
+    CameraValidationResult Validate(size_t samples)
+    {
+        CameraValidationResult result;
+        result.samples = samples;
+
+        Camera camera(1600, 900);
+        Camera reversed(1600, 900);
+        reversed.SetReversedZ(true);
+        Camera walker(1600, 900); // Solo Rotate y MoveRelative, como el control del jugador
+
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<float> angle(-XM_PI, XM_PI);
+        std::uniform_real_distribution<float> pitch(-XM_PIDIV2 + 0.01f, XM_PIDIV2 - 0.01f);
+        std::uniform_real_distribution<float> coordinate(-1000.0f, 1000.0f);
+        std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> distance(0.5f, 6000.0f);
+
+        auto checkMatrices = [&](const Camera& c)
+        {
+            const XMFLOAT4X4 directView = DirectView(c);
+            result.maxViewError = std::max(result.maxViewError, MaxDifference(c.GetViewMatrix(), directView));
+            result.maxInverseError = std::max(result.maxInverseError,
+                MaxDifference(TestMatrices::Multiply(c.GetViewMatrix(), c.GetInverseViewMatrix()), TestMatrices::Identity()));
+            result.maxViewProjectionError = std::max(result.maxViewProjectionError,
+                MaxDifference(c.GetViewProjectionMatrix(), TestMatrices::Multiply(directView, CullProjection(c))));
+
+            const XMFLOAT4 rotation = c.GetRotation();
+            result.maxRotationError = std::max({ result.maxRotationError,
+                MaxDifference(Rotate(XMFLOAT3(0.0f, 0.0f, 1.0f), rotation), c.GetForward()),
+                MaxDifference(Rotate(XMFLOAT3(1.0f, 0.0f, 0.0f), rotation), c.GetRight()) });
+        };
+
+        for (size_t i = 0; i < samples; ++i)
+        {
+            // Cambio de ventana de vez en cuando con la vista-proyeccion ya calculada
+            if (i % 7 == 3)
+            {
+                const int width = i % 2 ? 1280 : 1600;
+                const int height = i % 2 ? 1024 : 900;
+                camera.UpdateProjectionMatrix(width, height);
+                reversed.UpdateProjectionMatrix(width, height);
+                checkMatrices(camera);
+            }
+
+            float yaw = angle(rng);
+            float cameraPitch = pitch(rng);
+            XMFLOAT3 position(coordinate(rng), coordinate(rng) * 0.2f, coordinate(rng));
+
+            // Varias llamadas como en Game::Update; solo la ultima cuenta
+            camera.SetRotation(yaw, cameraPitch);
+            camera.SetPosition(XMFLOAT3(position.x + 1.0f, position.y, position.z));
+            camera.Move(XMFLOAT3(-1.0f, 0.0f, 0.0f));
+            reversed.SetRotation(yaw, cameraPitch);
+            reversed.SetPosition(camera.GetPosition());
+
+            // 1. Camino anterior: inversa completa del mundo de la camara
+            checkMatrices(camera);
+
+            // El jugador: giros acumulados (con el pitch recortado) y movimiento en sus propios ejes
+            const XMFLOAT3 before = walker.GetPosition();
+            const XMFLOAT3 step(offset(rng), offset(rng), offset(rng));
+            walker.Rotate(0.3f * offset(rng), 0.3f * offset(rng));
+            walker.MoveRelative(step);
+            XMFLOAT3 expected = MultiplyAdd(before, walker.GetRight(), step.x);
+            expected = MultiplyAdd(expected, walker.GetUp(), step.y);
+            expected = MultiplyAdd(expected, walker.GetForward(), step.z);
+            result.maxViewError = std::max(result.maxViewError, MaxDifference(walker.GetPosition(), expected));
+            checkMatrices(walker);
+
+            // 2. Frustum frente a la prueba en espacio de recorte (se ignoran puntos casi en un plano)
+            const XMFLOAT3 forward = camera.GetForward();
+            const XMFLOAT3 look(-forward.x, -forward.y, -forward.z);
+            XMFLOAT3 point = MultiplyAdd(camera.GetPosition(), look, distance(rng));
+            point = MultiplyAdd(point, camera.GetRight(), offset(rng) * 4000.0f);
+            point = MultiplyAdd(point, camera.GetUp(), offset(rng) * 2500.0f);
+            const XMFLOAT4 clip = TestMatrices::TransformPoint(point, TestMatrices::Multiply(DirectView(camera), CullProjection(camera)));
+            float margin = 1.0e-3f * std::fabs(clip.w);
+            float slack = std::min({ clip.w - std::fabs(clip.x), clip.w - std::fabs(clip.y), clip.z, clip.w - clip.z });
+            if (std::fabs(slack) > margin)
+            {
+                bool inside = slack > 0.0f;
+                if (camera.IsVisible(point, XMFLOAT3(0.0f, 0.0f, 0.0f)) != inside) result.frustumMismatches++;
+            }
+
+            // 3. Z invertida: mismo xy, profundidad en (0, 1], 1 en el plano cercano y decreciente
+            float previousDepth = 2.0f;
+            for (float d : { 1.0f, 10.0f, 100.0f, 1000.0f, 5000.0f, 100000.0f })
+            {
+                XMFLOAT3 p = MultiplyAdd(camera.GetPosition(), look, d);
+                p = MultiplyAdd(p, camera.GetRight(), 0.3f * d);
+                p = MultiplyAdd(p, camera.GetUp(), 0.1f * d);
+                const XMFLOAT4 a = TestMatrices::TransformPoint(p, camera.GetViewProjectionMatrix());
+                const XMFLOAT4 b = TestMatrices::TransformPoint(p, reversed.GetViewProjectionMatrix());
+                float depth = b.z / b.w;
+                bool sameXY = std::fabs(a.x / a.w - b.x / b.w) < 1.0e-4f && std::fabs(a.y / a.w - b.y / b.w) < 1.0e-4f;
+                // Con la camara a ~1000 unidades del origen, w en el plano cercano lleva ~1e-4 de redondeo
+                bool nearOk = d != 1.0f || std::fabs(depth - 1.0f) < 1.0e-3f;
+                if (!sameXY || !nearOk || depth <= 0.0f || depth > 1.0f + 1.0e-3f || depth >= previousDepth) result.reversedZMismatches++;
+                previousDepth = depth;
+            }
+        }
+
+        // Resolucion de un float32 de profundidad en el plano lejano, pasada a unidades de mundo
+        const float n = camera.GetNearPlane(), f = camera.GetFarPlane();
+        float standardDepth = f / (f - n) * (1.0f - n / f);
+        float standardSlope = f * n / ((f - n) * f * f);
+        result.standardDepthStep = (std::nextafter(standardDepth, 2.0f) - standardDepth) / standardSlope;
+        float reversedDepth = n / f;
+        float reversedSlope = n / (f * f);
+        result.reversedDepthStep = (std::nextafter(reversedDepth, 2.0f) - reversedDepth) / reversedSlope;
+        return result;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick = false;
+    if (!ParseQuickOption(argc, argv, quick)) return 2;
+
+    CameraValidationResult result = Validate(quick ? 2000 : 20000);
+    std::printf("Camera x%zu: view error %.2e, inverse error %.2e, view-proj error %.2e, rotation error %.2e, frustum mismatches %zu, reversed-Z mismatches %zu, depth step at far %.3f (reversed %.5f)\n",
+        result.samples, result.maxViewError, result.maxInverseError, result.maxViewProjectionError, result.maxRotationError,
+        result.frustumMismatches, result.reversedZMismatches, result.standardDepthStep, result.reversedDepthStep);
+    Check(result.maxViewError < 1e-3f && result.maxInverseError < 1e-3f && result.maxViewProjectionError < 1e-3f, "lazy camera matrices differ");
+    Check(result.maxRotationError < 1e-4f, "camera quaternion differs from its axes");
+    Check(result.frustumMismatches == 0, "cached frustum differs from clip space");
+    Check(result.reversedZMismatches == 0, "reversed-Z projection is not monotonic");
+
+    return FinishChecks();
+}
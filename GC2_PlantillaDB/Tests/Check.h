@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdio>
+
+// Comprobaciones de los ejecutables de Tests: cada fallo se imprime al momento y main termina
+// con FinishChecks(), que devuelve 1 si alguno fallo (ctest lo cuenta como prueba fallida).
+inline int& CheckFailures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+inline void Check(bool passed, const char* what)
+{
+    if (!passed)
+    {
+        CheckFailures()++;
+        std::printf("    FAILED: %s\n", what);
+    }
+}
+
+inline int FinishChecks()
+{
+    if (CheckFailures() > 0)
+    {
+        std::printf("%d check(s) failed\n", CheckFailures());
+        return 1;
+    }
+    std::printf("All checks passed\n");
+    return 0;
+}
@@ -0,0 +1,240 @@
+// CollisionGrid con instancias repartidas como la vegetacion de Game (esfera local del modelo y
+// matriz de mundo con escala, giro y posicion sobre un terreno de 5000 x 5000, unas pocas muy
+// grandes) y consultas con la caja de la camara de Game::Update: la rejilla tiene que devolver lo
+// mismo que el bucle anterior sobre todas las instancias, tambien despues de mover un 1% de ellas.
+//
+//   CollisionGridTest          10000, 30000 y 100000 objetos
+//   CollisionGridTest --quick  10000 objetos (lo que ejecuta ctest)
+
+#include "CollisionGrid.h"
+#include "Check.h"
+#include "Measure.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    struct CollisionGridBenchmarkResult
+    {
+        size_t objectCount = 0;
+        size_t queryCount = 0;
+        double buildMs = 0.0;
+        double bruteForceNsPerQuery = 0.0; // Bucle anterior: transformar la esfera local de cada instancia y probarla
+        double gridNsPerQuery = 0.0;
+        double moveNsPerObject = 0.0;      // Set() de un objeto que se ha movido un poco
+        double averageCandidates = 0.0;    // Objetos probados por consulta en la rejilla
+        size_t hits = 0;
+        size_t mismatches = 0;             // Consultas en las que la rejilla y el bucle completo no devuelven lo mismo
+    };
+
+    // Mismo criterio que BoundingBox::Intersects(BoundingSphere): distancia al punto mas cercano de la caja
+    bool SphereIntersectsBox(const XMFLOAT3& center, float radius, const XMFLOAT3& boxCenter, const XMFLOAT3& boxExtents)
+    {
+        float dx = std::max(std::fabs(center.x - boxCenter.x) - boxExtents.x, 0.0f);
+        float dy = std::max(std::fabs(center.y - boxCenter.y) - boxExtents.y, 0.0f);
+        float dz = std::max(std::fabs(center.z - boxCenter.z) - boxExtents.z, 0.0f);
+        return dx * dx + dy * dy + dz * dz <= radius * radius;
+    }
+
+    // Como BoundingSphere::Transform: centro como punto, radio por la mayor escala de las filas
+    void TransformSphere(const XMFLOAT3& center, float radius, const XMFLOAT4X4& m, XMFLOAT3& outCenter, float& outRadius)
+    {
+        outCenter = XMFLOAT3(
+            center.x * m._11 + center.y * m._21 + center.z * m._31 + m._41,
+            center.x * m._12 + center.y * m._22 + center.z * m._32 + m._42,
+            center.x * m._13 + center.y * m._23 + center.z * m._33 + m._43);
+        float scale = std::max({
+            m._11 * m._11 + m._12 * m._12 + m._13 * m._13,
+            m._21 * m._21 + m._22 * m._22 + m._23 * m._23,
+            m._31 * m._31 + m._32 * m._32 + m._33 * m._33 });
+        outRadius = radius * std::sqrt(scale);
+    }
+
+    double NanosecondsPerItem(std::chrono::steady_clock::time_point start, size_t count)
+    {
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        return count > 0 ? ns / static_cast<double>(count) : 0.0;
+    }
+
+    // Objetos que la rejilla prueba por consulta, con el mismo reparto que CollisionGrid: cada esfera
+    // en las celdas de su rango XZ, o en la lista que se prueba siempre si pasa de MAX_CELL_SPAN.
+    double AverageCandidates(float cellSize, const std::vector<XMFLOAT3>& centers, const std::vector<float>& radii,
+        const std::vector<XMFLOAT3>& boxCenters, const XMFLOAT3& boxExtents)
+    {
+        auto cellCoord = [cellSize](float value) { return static_cast<int>(std::floor(value * (1.0f / cellSize))); };
+        auto cellKey = [](int x, int z) { return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(z); };
+
+        std::unordered_map<uint64_t, size_t> cellCounts;
+        size_t oversized = 0;
+        for (size_t i = 0; i < centers.size(); ++i)
+        {
+            const int minX = cellCoord(centers[i].x - radii[i]);
+            const int maxX = cellCoord(centers[i].x + radii[i]);
+            const int minZ = cellCoord(centers[i].z - radii[i]);
+            const int maxZ = cellCoord(centers[i].z + radii[i]);
+            if (maxX - minX >= CollisionGrid::MAX_CELL_SPAN || maxZ - minZ >= CollisionGrid::MAX_CELL_SPAN)
+            {
+                oversized++;
+                continue;
+            }
+            for (int z = minZ; z <= maxZ; ++z)
+            {
+                for (int x = minX; x <= maxX; ++x) cellCounts[cellKey(x, z)]++;
+            }
+        }
+
+        size_t candidates = 0;
+        for (const XMFLOAT3& c : boxCenters)
+        {
+            for (int z = cellCoord(c.z - boxExtents.z); z <= cellCoord(c.z + boxExtents.z); ++z)
+            {
+                for (int x = cellCoord(c.x - boxExtents.x); x <= cellCoord(c.x + boxExtents.x); ++x)
+                {
+                    auto cell = cellCounts.find(cellKey(x, z));
+                    if (cell != cellCounts.end()) candidates += cell->second;
+                }
+            }
+            candidates += oversized;
+        }
+        return boxCenters.empty() ? 0.0 : static_cast<double>(candidates) / boxCenters.size();
+    }
+
+    CollisionGridBenchmarkResult Benchmark(size_t objectCount, size_t queryCount)
+    {
+        CollisionGridBenchmarkResult result;
+        result.objectCount = objectCount;
+        result.queryCount = queryCount;
+
+        // Instancias como las de Game: esfera local del modelo y matriz de mundo con escala, giro y posicion
+        // sobre un terreno de 5000 x 5000; unas pocas muy grandes (casas, molino)
+        std::mt19937 random(4242);
+        std::uniform_real_distribution<float> coordinate(-2500.0f, 2500.0f);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::vector<XMFLOAT3> localCenters(objectCount);
+        std::vector<float> localRadii(objectCount);
+        std::vector<XMFLOAT4X4> worlds(objectCount);
+        for (size_t i = 0; i < objectCount; ++i)
+        {
+            localCenters[i] = XMFLOAT3(0.0f, 2.0f * unit(random), 0.0f);
+            localRadii[i] = (i % 500 == 0) ? 200.0f + 400.0f * unit(random) : 1.0f + 3.0f * unit(random);
+            float scale = 1.0f + 5.0f * unit(random);
+            float angle = XM_2PI * unit(random);
+            float c = std::cos(angle) * scale, s = std::sin(angle) * scale;
+            XMFLOAT4X4& m = worlds[i];
+            m = {};
+            m._11 = c;  m._13 = -s;
+            m._22 = scale;
+            m._31 = s;  m._33 = c;
+            m._41 = coordinate(random);
+            m._42 = 20.0f * unit(random);
+            m._43 = coordinate(random);
+            m._44 = 1.0f;
+        }
+
+        // Caja de la camara de Game::Update; la mitad de las consultas junto a una instancia
+        const XMFLOAT3 boxExtents(0.4f, 0.9f, 0.4f);
+        std::vector<XMFLOAT3> boxCenters(queryCount);
+        for (size_t k = 0; k < queryCount; ++k)
+        {
+            if (k % 2 == 0 && objectCount > 0)
+            {
+                const XMFLOAT4X4& m = worlds[random() % objectCount];
+                boxCenters[k] = XMFLOAT3(m._41 + 20.0f * (unit(random) - 0.5f), m._42 + 5.0f * unit(random), m._43 + 20.0f * (unit(random) - 0.5f));
+            }
+            else
+            {
+                boxCenters[k] = XMFLOAT3(coordinate(random), 20.0f * unit(random), coordinate(random));
+            }
+        }
+
+        const float cellSize = 64.0f;
+        CollisionGrid grid(cellSize);
+        std::vector<XMFLOAT3> worldCenters(objectCount);
+        std::vector<float> worldRadii(objectCount);
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < objectCount; ++i)
+        {
+            TransformSphere(localCenters[i], localRadii[i], worlds[i], worldCenters[i], worldRadii[i]);
+            grid.Set(static_cast<uint32_t>(i), worldCenters[i], worldRadii[i]);
+        }
+        result.buildMs = MillisecondsSince(start);
+
+        // Bucle anterior: todas las instancias, transformando la esfera local en cada consulta
+        std::vector<std::vector<uint32_t>> bruteHits(queryCount);
+        start = std::chrono::steady_clock::now();
+        for (size_t k = 0; k < queryCount; ++k)
+        {
+            for (size_t i = 0; i < objectCount; ++i)
+            {
+                XMFLOAT3 center;
+                float radius;
+                TransformSphere(localCenters[i], localRadii[i], worlds[i], center, radius);
+                if (SphereIntersectsBox(center, radius, boxCenters[k], boxExtents)) bruteHits[k].push_back(static_cast<uint32_t>(i));
+            }
+        }
+        result.bruteForceNsPerQuery = NanosecondsPerItem(start, queryCount);
+
+        std::vector<uint32_t> ids;
+        start = std::chrono::steady_clock::now();
+        for (size_t k = 0; k < queryCount; ++k)
+        {
+            grid.Query(boxCenters[k], boxExtents, ids);
+            result.hits += ids.size();
+            if (ids != bruteHits[k]) result.mismatches++;
+        }
+        result.gridNsPerQuery = NanosecondsPerItem(start, queryCount);
+
+        // Candidatos probados: se cuenta aparte para no medirlo dentro del tiempo de consulta
+        result.averageCandidates = AverageCandidates(cellSize, worldCenters, worldRadii, boxCenters, boxExtents);
+
+        // Un 1% de las instancias se desplaza un poco: la mayoria no cambia de celdas
+        const size_t movers = std::max<size_t>(objectCount / 100, 1);
+        start = std::chrono::steady_clock::now();
+        for (size_t n = 0; n < movers && objectCount > 0; ++n)
+        {
+            size_t i = (n * 97) % objectCount;
+            worldCenters[i].x += 3.0f * (unit(random) - 0.5f);
+            worldCenters[i].z += 3.0f * (unit(random) - 0.5f);
+            grid.Set(static_cast<uint32_t>(i), worldCenters[i], worldRadii[i]);
+        }
+        result.moveNsPerObject = NanosecondsPerItem(start, movers);
+
+        // Tras mover, la rejilla debe seguir dando lo mismo que el recorrido completo de las esferas de mundo
+        for (size_t k = 0; k < queryCount; k += 7)
+        {
+            std::vector<uint32_t> expected;
+            for (size_t i = 0; i < objectCount; ++i)
+            {
+                if (SphereIntersectsBox(worldCenters[i], worldRadii[i], boxCenters[k], boxExtents)) expected.push_back(static_cast<uint32_t>(i));
+            }
+            grid.Query(boxCenters[k], boxExtents, ids);
+            if (ids != expected) result.mismatches++;
+        }
+        return result;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick = false;
+    if (!ParseQuickOption(argc, argv, quick)) return 2;
+
+    for (size_t objectCount : Sizes(quick, { size_t(10000), size_t(30000), size_t(100000) }))
+    {
+        CollisionGridBenchmarkResult result = Benchmark(objectCount, 2000);
+        std::printf("Collision grid %zu objects, %zu queries: build %.1f ms, brute force %.0f ns, grid %.0f ns per query (%.1f candidates), move %.0f ns, %zu hits, %zu mismatches\n",
+            result.objectCount, result.queryCount, result.buildMs, result.bruteForceNsPerQuery, result.gridNsPerQuery,
+            result.averageCandidates, result.moveNsPerObject, result.hits, result.mismatches);
+        Check(result.mismatches == 0, "grid query differs from the brute force loop");
+    }
+
+    return FinishChecks();
+}
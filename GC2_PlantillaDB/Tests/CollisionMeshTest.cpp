@@ -0,0 +1,478 @@
+// CollisionMesh sobre una malla sintetica (casa de 40 x 30 x 40 con puerta y sopa de triangulos
+// alrededor) con instancias giradas y escaladas, tambien con escala no uniforme: caja, capsula y
+// rayo por el BVH frente a los mismos tests sobre todos los triangulos de la malla original, en
+// el orden de los indices, y casos dirigidos de la puerta (la caja de la camara de Game cruza el
+// umbral sin tocar y choca con la pared de al lado).
+//
+//   CollisionMeshTest          2000, 10000 y 100000 triangulos
+//   CollisionMeshTest --quick  2000 triangulos (lo que ejecuta ctest)
+
+#include "CollisionMesh.h"
+#include "Check.h"
+#include "Measure.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    struct CollisionMeshBenchmarkResult
+    {
+        size_t triangleCount = 0;
+        size_t nodeCount = 0;
+        size_t queryCount = 0;
+        double buildMs = 0.0;
+        double boxNsPerQuery = 0.0;
+        double capsuleNsPerQuery = 0.0;
+        double rayNsPerQuery = 0.0;
+        double bruteBoxNsPerQuery = 0.0;     // Los mismos tests contra todos los triangulos
+        double bruteCapsuleNsPerQuery = 0.0;
+        double bruteRayNsPerQuery = 0.0;
+        size_t boxHits = 0;
+        size_t capsuleHits = 0;
+        size_t rayHits = 0;
+        size_t mismatches = 0;               // Consultas en las que el BVH no da lo mismo que la fuerza bruta
+        size_t doorwayFailures = 0;          // Casos dirigidos: pasar por la puerta de la casa sin chocar y chocar con la pared
+    };
+
+    struct Vec3
+    {
+        float x, y, z;
+    };
+
+    Vec3 operator+(const Vec3& a, const Vec3& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+    Vec3 operator-(const Vec3& a, const Vec3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+    Vec3 operator*(const Vec3& a, float s) { return { a.x * s, a.y * s, a.z * s }; }
+    float Dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    Vec3 Cross(const Vec3& a, const Vec3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+    float Component(const Vec3& v, int axis) { return axis == 0 ? v.x : (axis == 1 ? v.y : v.z); }
+    float Clamp01(float v) { return std::min(std::max(v, 0.0f), 1.0f); }
+    Vec3 ToVec3(const XMFLOAT3& v) { return { v.x, v.y, v.z }; }
+    XMFLOAT3 ToFloat3(const Vec3& v) { return XMFLOAT3(v.x, v.y, v.z); }
+
+    Vec3 TransformPoint(const Vec3& v, const XMFLOAT4X4& m)
+    {
+        return { v.x * m._11 + v.y * m._21 + v.z * m._31 + m._41,
+                 v.x * m._12 + v.y * m._22 + v.z * m._32 + m._42,
+                 v.x * m._13 + v.y * m._23 + v.z * m._33 + m._43 };
+    }
+
+    Vec3 TransformVector(const Vec3& v, const XMFLOAT4X4& m)
+    {
+        return { v.x * m._11 + v.y * m._21 + v.z * m._31,
+                 v.x * m._12 + v.y * m._22 + v.z * m._32,
+                 v.x * m._13 + v.y * m._23 + v.z * m._33 };
+    }
+
+    // Inversa de una matriz afin (la 3x3 por adjuntos y la traslacion deshecha)
+    XMFLOAT4X4 InverseAffine(const XMFLOAT4X4& m)
+    {
+        const float c00 = m._22 * m._33 - m._23 * m._32;
+        const float c01 = m._23 * m._31 - m._21 * m._33;
+        const float c02 = m._21 * m._32 - m._22 * m._31;
+        const float determinant = m._11 * c00 + m._12 * c01 + m._13 * c02;
+        const float inverse = std::fabs(determinant) > 1.0e-20f ? 1.0f / determinant : 0.0f;
+
+        XMFLOAT4X4 r = {};
+        r._11 = c00 * inverse;
+        r._12 = (m._13 * m._32 - m._12 * m._33) * inverse;
+        r._13 = (m._12 * m._23 - m._13 * m._22) * inverse;
+        r._21 = c01 * inverse;
+        r._22 = (m._11 * m._33 - m._13 * m._31) * inverse;
+        r._23 = (m._13 * m._21 - m._11 * m._23) * inverse;
+        r._31 = c02 * inverse;
+        r._32 = (m._12 * m._31 - m._11 * m._32) * inverse;
+        r._33 = (m._11 * m._22 - m._12 * m._21) * inverse;
+        Vec3 t = TransformVector({ m._41, m._42, m._43 }, r);
+        r._41 = -t.x;
+        r._42 = -t.y;
+        r._43 = -t.z;
+        r._44 = 1.0f;
+        return r;
+    }
+
+    double NanosecondsPerQuery(std::chrono::steady_clock::time_point start, size_t count)
+    {
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        return count > 0 ? ns / static_cast<double>(count) : 0.0;
+    }
+
+    // Tests exactos de referencia, los mismos criterios que las hojas de CollisionMesh
+
+    // Triangulo contra AABB por ejes separadores (Akenine-Moller)
+    bool TriangleIntersectsBox(const Vec3& a, const Vec3& b, const Vec3& c, const Vec3& center, const Vec3& extents)
+    {
+        const Vec3 v0 = a - center, v1 = b - center, v2 = c - center;
+        const Vec3 edges[3] = { v1 - v0, v2 - v1, v0 - v2 };
+        const Vec3 axes[3] = { { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } };
+
+        for (const Vec3& edge : edges)
+        {
+            for (const Vec3& boxAxis : axes)
+            {
+                Vec3 axis = Cross(boxAxis, edge);
+                float p0 = Dot(v0, axis), p1 = Dot(v1, axis), p2 = Dot(v2, axis);
+                float r = extents.x * std::fabs(axis.x) + extents.y * std::fabs(axis.y) + extents.z * std::fabs(axis.z);
+                if (std::min({ p0, p1, p2 }) > r || std::max({ p0, p1, p2 }) < -r) return false;
+            }
+        }
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float e = Component(extents, axis);
+            float p0 = Component(v0, axis), p1 = Component(v1, axis), p2 = Component(v2, axis);
+            if (std::min({ p0, p1, p2 }) > e || std::max({ p0, p1, p2 }) < -e) return false;
+        }
+
+        Vec3 normal = Cross(edges[0], edges[1]);
+        float distance = Dot(normal, v0);
+        float r = extents.x * std::fabs(normal.x) + extents.y * std::fabs(normal.y) + extents.z * std::fabs(normal.z);
+        return std::fabs(distance) <= r;
+    }
+
+    // Punto del triangulo abc mas cercano a p (Ericson, Real-Time Collision Detection 5.1.5)
+    Vec3 ClosestPointOnTriangle(const Vec3& p, const Vec3& a, const Vec3& b, const Vec3& c)
+    {
+        Vec3 ab = b - a;
+        Vec3 ac = c - a;
+        Vec3 ap = p - a;
+        float d1 = Dot(ab, ap);
+        float d2 = Dot(ac, ap);
+        if (d1 <= 0.0f && d2 <= 0.0f) return a;
+
+        Vec3 bp = p - b;
+        float d3 = Dot(ab, bp);
+        float d4 = Dot(ac, bp);
+        if (d3 >= 0.0f && d4 <= d3) return b;
+
+        float vc = d1 * d4 - d3 * d2;
+        if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) return a + ab * (d1 / (d1 - d3));
+
+        Vec3 cp = p - c;
+        float d5 = Dot(ab, cp);
+        float d6 = Dot(ac, cp);
+        if (d6 >= 0.0f && d5 <= d6) return c;
+
+        float vb = d5 * d2 - d1 * d6;
+        if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) return a + ac * (d2 / (d2 - d6));
+
+        float va = d3 * d6 - d5 * d4;
+        if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+        float denominator = 1.0f / (va + vb + vc);
+        return a + ab * (vb * denominator) + ac * (vc * denominator);
+    }
+
+    // Distancia al cuadrado entre los segmentos p1q1 y p2q2 (Ericson 5.1.9)
+    float SegmentSegmentDistanceSquared(const Vec3& p1, const Vec3& q1, const Vec3& p2, const Vec3& q2)
+    {
+        const float epsilon = 1.0e-12f;
+        Vec3 d1 = q1 - p1;
+        Vec3 d2 = q2 - p2;
+        Vec3 r = p1 - p2;
+        float a = Dot(d1, d1);
+        float e = Dot(d2, d2);
+        float f = Dot(d2, r);
+        float s = 0.0f;
+        float t = 0.0f;
+
+        if (a <= epsilon && e <= epsilon)
+        {
+            s = t = 0.0f;
+        }
+        else if (a <= epsilon)
+        {
+            t = Clamp01(f / e);
+        }
+        else
+        {
+            float c = Dot(d1, r);
+            if (e <= epsilon)
+            {
+                s = Clamp01(-c / a);
+            }
+            else
+            {
+                float b = Dot(d1, d2);
+                float denominator = a * e - b * b;
+                s = denominator != 0.0f ? Clamp01((b * f - c * e) / denominator) : 0.0f;
+                t = (b * s + f) / e;
+                if (t < 0.0f) { t = 0.0f; s = Clamp01(-c / a); }
+                else if (t > 1.0f) { t = 1.0f; s = Clamp01((b - c) / a); }
+            }
+        }
+        Vec3 difference = (p1 + d1 * s) - (p2 + d2 * t);
+        return Dot(difference, difference);
+    }
+
+    bool SegmentCrossesTriangle(const Vec3& p, const Vec3& q, const Vec3& a, const Vec3& b, const Vec3& c)
+    {
+        Vec3 normal = Cross(b - a, c - a);
+        float dp = Dot(p - a, normal), dq = Dot(q - a, normal);
+        if ((dp > 0.0f && dq > 0.0f) || (dp < 0.0f && dq < 0.0f) || dp == dq) return false;
+        Vec3 x = p + (q - p) * (dp / (dp - dq));
+        return Dot(Cross(b - a, x - a), normal) >= 0.0f && Dot(Cross(c - b, x - b), normal) >= 0.0f &&
+            Dot(Cross(a - c, x - c), normal) >= 0.0f;
+    }
+
+    bool TriangleIntersectsCapsule(const Vec3& a, const Vec3& b, const Vec3& c, const Vec3& p, const Vec3& q, float radius)
+    {
+        if (SegmentCrossesTriangle(p, q, a, b, c)) return true;
+        const float radiusSquared = radius * radius;
+        Vec3 onTriangle = ClosestPointOnTriangle(p, a, b, c);
+        if (Dot(p - onTriangle, p - onTriangle) <= radiusSquared) return true;
+        onTriangle = ClosestPointOnTriangle(q, a, b, c);
+        if (Dot(q - onTriangle, q - onTriangle) <= radiusSquared) return true;
+        return SegmentSegmentDistanceSquared(p, q, a, b) <= radiusSquared ||
+            SegmentSegmentDistanceSquared(p, q, b, c) <= radiusSquared ||
+            SegmentSegmentDistanceSquared(p, q, c, a) <= radiusSquared;
+    }
+
+    // Moller-Trumbore por las dos caras; t en unidades de direction
+    bool RayTriangle(const Vec3& origin, const Vec3& direction, const Vec3& a, const Vec3& b, const Vec3& c, float& outT)
+    {
+        Vec3 ab = b - a, ac = c - a;
+        Vec3 p = Cross(direction, ac);
+        float determinant = Dot(ab, p);
+        if (std::fabs(determinant) < 1.0e-12f) return false;
+        float inverse = 1.0f / determinant;
+        Vec3 s = origin - a;
+        float u = Dot(s, p) * inverse;
+        if (u < 0.0f || u > 1.0f) return false;
+        Vec3 qv = Cross(s, ab);
+        float v = Dot(direction, qv) * inverse;
+        if (v < 0.0f || u + v > 1.0f) return false;
+        outT = Dot(ac, qv) * inverse;
+        return true;
+    }
+
+    CollisionMeshBenchmarkResult Benchmark(size_t triangleCount, size_t queryCount)
+    {
+        CollisionMeshBenchmarkResult result;
+        result.queryCount = queryCount;
+
+        // 1. Casa de 40 x 30 x 40 con paredes teseladas en cuadros de 2 x 2 y una puerta de 8 x 14 en
+        //    la pared z = -20 (centrada en x = 0); el resto, sopa de triangulos pequenos alrededor
+        std::vector<XMFLOAT3> positions;
+        std::vector<uint32_t> indices;
+        auto addQuad = [&](const Vec3& origin, const Vec3& u, const Vec3& v)
+        {
+            uint32_t base = static_cast<uint32_t>(positions.size());
+            positions.push_back(ToFloat3(origin));
+            positions.push_back(ToFloat3(origin + u));
+            positions.push_back(ToFloat3(origin + v));
+            positions.push_back(ToFloat3(origin + u + v));
+            for (uint32_t index : { 0u, 1u, 2u, 2u, 1u, 3u }) indices.push_back(base + index);
+        };
+        const float step = 2.0f;
+        for (float y = 0.0f; y < 30.0f; y += step)
+        {
+            for (float s = -20.0f; s < 20.0f; s += step)
+            {
+                bool door = s >= -4.0f && s + step <= 4.0f && y + step <= 14.0f;
+                if (!door) addQuad({ s, y, -20.0f }, { step, 0.0f, 0.0f }, { 0.0f, step, 0.0f });
+                addQuad({ s, y, 20.0f }, { step, 0.0f, 0.0f }, { 0.0f, step, 0.0f });
+                addQuad({ -20.0f, y, s }, { 0.0f, 0.0f, step }, { 0.0f, step, 0.0f });
+                addQuad({ 20.0f, y, s }, { 0.0f, 0.0f, step }, { 0.0f, step, 0.0f });
+            }
+        }
+
+        std::mt19937 random(2024);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        auto inRange = [&](float low, float high) { return low + (high - low) * unit(random); };
+        while (indices.size() / 3 < triangleCount)
+        {
+            Vec3 center = { inRange(-100.0f, 100.0f), inRange(0.0f, 60.0f), inRange(-100.0f, 100.0f) };
+            if (std::fabs(center.x) < 30.0f && std::fabs(center.z) < 45.0f) center.y += 40.0f; // Casa y entrada despejadas
+            uint32_t base = static_cast<uint32_t>(positions.size());
+            for (int k = 0; k < 3; ++k)
+            {
+                positions.push_back(ToFloat3(center + Vec3{ inRange(-1.5f, 1.5f), inRange(-1.5f, 1.5f), inRange(-1.5f, 1.5f) }));
+                indices.push_back(base + k);
+            }
+        }
+
+        CollisionMesh mesh;
+        auto start = std::chrono::steady_clock::now();
+        mesh.Build(positions.data(), positions.size(), indices.data(), indices.size());
+        result.buildMs = MillisecondsSince(start);
+        result.triangleCount = mesh.GetTriangleCount();
+        result.nodeCount = mesh.GetNodeCount();
+
+        // 2. Instancias con giro, escala (tambien no uniforme) y traslacion; una por consulta
+        auto makeWorld = [&](bool uniform)
+        {
+            float yaw = inRange(-XM_PI, XM_PI), tilt = inRange(-0.3f, 0.3f);
+            float sx = inRange(0.5f, 3.0f);
+            float sy = uniform ? sx : inRange(0.5f, 3.0f), sz = uniform ? sx : inRange(0.5f, 3.0f);
+            float cy = std::cos(yaw), sny = std::sin(yaw), ct = std::cos(tilt), st = std::sin(tilt);
+            // Escala, giro sobre X (tilt) y sobre Y (yaw), en ese orden (vector fila)
+            XMFLOAT4X4 m = {};
+            m._11 = sx * cy;             m._12 = 0.0f;     m._13 = -sx * sny;
+            m._21 = sy * st * sny;       m._22 = sy * ct;  m._23 = sy * st * cy;
+            m._31 = sz * ct * sny;       m._32 = -sz * st; m._33 = sz * ct * cy;
+            m._41 = inRange(-500.0f, 500.0f); m._42 = inRange(-20.0f, 20.0f); m._43 = inRange(-500.0f, 500.0f);
+            m._44 = 1.0f;
+            return m;
+        };
+
+        struct Query
+        {
+            XMFLOAT4X4 world;
+            Vec3 boxCenter, boxExtents;
+            Vec3 capsuleA, capsuleB;
+            float radius;
+            Vec3 rayOrigin, rayDirection;
+        };
+        std::vector<Query> queries(queryCount);
+        for (size_t k = 0; k < queryCount; ++k)
+        {
+            Query& q = queries[k];
+            q.world = makeWorld(k % 4 != 0);
+            Vec3 target = TransformPoint({ inRange(-60.0f, 60.0f), inRange(0.0f, 70.0f), inRange(-60.0f, 60.0f) }, q.world);
+            q.boxCenter = target;
+            q.boxExtents = { 0.4f, 0.9f, 0.4f };
+            q.capsuleA = target;
+            q.capsuleB = target + Vec3{ inRange(-3.0f, 3.0f), inRange(5.0f, 10.0f), inRange(-3.0f, 3.0f) };
+            q.radius = inRange(0.5f, 3.0f);
+            q.rayOrigin = TransformPoint({ inRange(-150.0f, 150.0f), inRange(0.0f, 80.0f), inRange(-150.0f, 150.0f) }, q.world);
+            q.rayDirection = target - q.rayOrigin;
+        }
+
+        // 3. BVH frente a todos los triangulos de la malla original: la caja y la capsula con los
+        //    triangulos llevados al mundo de cada instancia
+        std::vector<uint8_t> boxResults(queryCount), capsuleResults(queryCount), rayResults(queryCount);
+        std::vector<float> rayT(queryCount, 0.0f);
+        start = std::chrono::steady_clock::now();
+        for (size_t k = 0; k < queryCount; ++k)
+            boxResults[k] = mesh.IntersectsBox(ToFloat3(queries[k].boxCenter), ToFloat3(queries[k].boxExtents), queries[k].world);
+        result.boxNsPerQuery = NanosecondsPerQuery(start, queryCount);
+
+        start = std::chrono::steady_clock::now();
+        for (size_t k = 0; k < queryCount; ++k)
+            capsuleResults[k] = mesh.IntersectsCapsule(ToFloat3(queries[k].capsuleA), ToFloat3(queries[k].capsuleB), queries[k].radius, queries[k].world);
+        result.capsuleNsPerQuery = NanosecondsPerQuery(start, queryCount);
+
+        start = std::chrono::steady_clock::now();
+        for (size_t k = 0; k < queryCount; ++k)
+        {
+            CollisionRayHit hit;
+            rayResults[k] = mesh.Raycast(ToFloat3(queries[k].rayOrigin), ToFloat3(queries[k].rayDirection), 1.5f, queries[k].world, hit);
+            rayT[k] = hit.t;
+        }
+        result.rayNsPerQuery = NanosecondsPerQuery(start, queryCount);
+
+        auto worldTriangle = [&](size_t t, const XMFLOAT4X4& world, Vec3& a, Vec3& b, Vec3& c)
+        {
+            a = TransformPoint(ToVec3(positions[indices[3 * t]]), world);
+            b = TransformPoint(ToVec3(positions[indices[3 * t + 1]]), world);
+            c = TransformPoint(ToVec3(positions[indices[3 * t + 2]]), world);
+        };
+        const size_t allTriangles = indices.size() / 3;
+
+        start = std::chrono::steady_clock::now();
+        for (size_t k = 0; k < queryCount; ++k)
+        {
+            const Query& q = queries[k];
+            bool hit = false;
+            for (size_t t = 0; t < allTriangles && !hit; ++t)
+            {
+                Vec3 a, b, c;
+                worldTriangle(t, q.world, a, b, c);
+                hit = TriangleIntersectsBox(a, b, c, q.boxCenter, q.boxExtents);
+            }
+            result.boxHits += hit ? 1 : 0;
+            if (hit != (boxResults[k] != 0)) result.mismatches++;
+        }
+        result.bruteBoxNsPerQuery = NanosecondsPerQuery(start, queryCount);
+
+        start = std::chrono::steady_clock::now();
+        for (size_t k = 0; k < queryCount; ++k)
+        {
+            const Query& q = queries[k];
+            bool hit = false;
+            for (size_t t = 0; t < allTriangles && !hit; ++t)
+            {
+                Vec3 a, b, c;
+                worldTriangle(t, q.world, a, b, c);
+                hit = TriangleIntersectsCapsule(a, b, c, q.capsuleA, q.capsuleB, q.radius);
+            }
+            result.capsuleHits += hit ? 1 : 0;
+            if (hit != (capsuleResults[k] != 0)) result.mismatches++;
+        }
+        result.bruteCapsuleNsPerQuery = NanosecondsPerQuery(start, queryCount);
+
+        start = std::chrono::steady_clock::now();
+        for (size_t k = 0; k < queryCount; ++k)
+        {
+            // Como Raycast, el rayo se lleva al modelo (el t no cambia con una matriz afin)
+            const Query& q = queries[k];
+            const XMFLOAT4X4 inverse = InverseAffine(q.world);
+            const Vec3 origin = TransformPoint(q.rayOrigin, inverse);
+            const Vec3 direction = TransformVector(q.rayDirection, inverse);
+            float bestT = 1.5f;
+            bool hit = false;
+            for (size_t t = 0; t < allTriangles; ++t)
+            {
+                float hitT;
+                if (RayTriangle(origin, direction, ToVec3(positions[indices[3 * t]]), ToVec3(positions[indices[3 * t + 1]]),
+                        ToVec3(positions[indices[3 * t + 2]]), hitT) && hitT >= 0.0f && hitT <= bestT)
+                {
+                    bestT = hitT;
+                    hit = true;
+                }
+            }
+            result.rayHits += hit ? 1 : 0;
+            if (hit != (rayResults[k] != 0) || (hit && std::fabs(bestT - rayT[k]) > 1.0e-5f * std::max(1.0f, bestT))) result.mismatches++;
+        }
+        result.bruteRayNsPerQuery = NanosecondsPerQuery(start, queryCount);
+
+        // 4. Puerta: la caja de la camara de Game cruza el umbral sin tocar; desplazada 6 en x, choca
+        const XMFLOAT4X4 house = makeWorld(true);
+        const float houseScale = std::sqrt(house._11 * house._11 + house._12 * house._12 + house._13 * house._13);
+        for (float z : { -24.0f, -20.0f, -16.0f })
+        {
+            Vec3 doorway = TransformPoint({ 0.0f, 7.0f, z }, house);
+            Vec3 wall = TransformPoint({ 6.0f, 7.0f, z }, house);
+            Vec3 extents = { 0.4f * houseScale, 0.9f * houseScale, 0.4f * houseScale };
+            if (mesh.IntersectsBox(ToFloat3(doorway), ToFloat3(extents), house)) result.doorwayFailures++;
+            if (z == -20.0f && !mesh.IntersectsBox(ToFloat3(wall), ToFloat3(extents), house)) result.doorwayFailures++;
+
+            Vec3 up = TransformVector({ 0.0f, 4.0f, 0.0f }, house);
+            if (mesh.IntersectsCapsule(ToFloat3(doorway), ToFloat3(doorway + up), 2.0f * houseScale, house)) result.doorwayFailures++;
+        }
+        CollisionRayHit doorHit;
+        Vec3 outside = TransformPoint({ 0.0f, 7.0f, -40.0f }, house);
+        if (mesh.Raycast(ToFloat3(outside), ToFloat3(TransformVector({ 0.0f, 0.0f, 1.0f }, house)), 39.0f, house, doorHit))
+            result.doorwayFailures++; // Por la puerta hasta justo antes de la pared del fondo
+        if (!mesh.Raycast(ToFloat3(outside), ToFloat3(TransformVector({ 0.0f, 0.0f, 1.0f }, house)), 100.0f, house, doorHit) ||
+            std::fabs(doorHit.t - 60.0f) > 1.0e-2f)
+            result.doorwayFailures++; // La pared del fondo esta en z = 20
+        return result;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick = false;
+    if (!ParseQuickOption(argc, argv, quick)) return 2;
+
+    for (size_t triangleCount : Sizes(quick, { size_t(2000), size_t(10000), size_t(100000) }))
+    {
+        CollisionMeshBenchmarkResult result = Benchmark(triangleCount, 5000);
+        std::printf("Collision mesh %zu tris (%zu nodes, %.1f ms): box %.0f ns (brute %.0f), capsule %.0f ns (brute %.0f), ray %.0f ns (brute %.0f), mismatches %zu, doorway failures %zu\n",
+            result.triangleCount, result.nodeCount, result.buildMs, result.boxNsPerQuery, result.bruteBoxNsPerQuery,
+            result.capsuleNsPerQuery, result.bruteCapsuleNsPerQuery, result.rayNsPerQuery, result.bruteRayNsPerQuery,
+            result.mismatches, result.doorwayFailures);
+        Check(result.mismatches == 0, "BVH query differs from the brute force loop");
+        Check(result.doorwayFailures == 0, "doorway cases failed");
+    }
+
+    return FinishChecks();
+}
@@ -0,0 +1,215 @@
+// Orden y estado de las pasadas de la escena opaca (ScenePassPlan) en cada combinacion que puede
+// pedir Game::Render, y el plan ejecutado sobre fragmentos aleatorios (profundidad, modo y alfa)
+// con un buffer de profundidad en CPU: con la pre-pasada la imagen es la misma que sin ella y la
+// pasada principal sombrea como mucho un fragmento por pixel. Ademas, ClassifyAlphaTexels.
+//
+//   DepthPrepassTest          200000 pixeles
+//   DepthPrepassTest --quick  20000 (lo que ejecuta ctest)
+
+#include "DepthPrepass.h"
+#include "Check.h"
+#include "Measure.h"
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+    struct ScenePassValidationResult
+    {
+        size_t planCount = 0;             // Planes comprobados (con y sin pre-pasada, cada mezcla de modos)
+        size_t orderErrors = 0;           // Pre-pasada despues del terreno, terreno despues de los modelos...
+        size_t stateErrors = 0;           // Pasada con otro pixel shader, prueba de profundidad o culling
+        size_t pixelCount = 0;
+        size_t fragmentCount = 0;
+        size_t shadedWithoutPrepass = 0;  // Invocaciones de EvolvingPS/TerrainPS sin la pre-pasada...
+        size_t shadedWithPrepass = 0;     // ...y con ella
+        size_t overshadedPixels = 0;      // Pixeles donde la pasada principal sombrea mas de un fragmento
+        size_t imageMismatches = 0;       // Pixeles con distinto fragmento visible que sin la pre-pasada
+    };
+
+    struct Fragment
+    {
+        bool terrain;
+        MaterialAlphaMode mode;
+        bool alphaPasses; // alfa >= umbral en ese pixel
+        float depth;
+    };
+
+    struct PixelOutcome
+    {
+        int visible = -1;      // Fragmento que queda en el color (-1: fondo)
+        size_t shaded = 0;     // Invocaciones de los pixel shaders caros
+        size_t modelShaded = 0;
+    };
+
+    // Un pixel con el comportamiento de D3D: con clip() en el shader la prueba de profundidad va
+    // despues del shader (sin early-Z) y sin clip() el fragmento que no pasa no llega a sombrearse.
+    PixelOutcome RunPixel(const ScenePassPlan& plan, const std::vector<Fragment>& fragments)
+    {
+        PixelOutcome outcome;
+        float depth = 1.0f;
+        for (const ScenePass& pass : plan.passes)
+        {
+            const bool clips = pass.pixelShader == ScenePixelShader::DepthAlphaClip || pass.pixelShader == ScenePixelShader::Evolving;
+            const bool shades = pass.pixelShader == ScenePixelShader::Terrain || pass.pixelShader == ScenePixelShader::Evolving ||
+                pass.pixelShader == ScenePixelShader::EvolvingNoClip;
+            for (size_t i = 0; i < fragments.size(); ++i)
+            {
+                const Fragment& fragment = fragments[i];
+                if (fragment.terrain != (pass.kind == ScenePassKind::Terrain)) continue;
+                if (!fragment.terrain && (pass.alphaModes & MaterialAlphaBit(fragment.mode)) == 0) continue;
+
+                const bool depthPasses = pass.depthTest == SceneDepthTest::LessWrite ? fragment.depth < depth : fragment.depth == depth;
+                if (!clips && !depthPasses) continue;
+                if (shades)
+                {
+                    outcome.shaded++;
+                    if (pass.kind == ScenePassKind::Models) outcome.modelShaded++;
+                }
+                if (clips && !fragment.alphaPasses) continue;
+                if (!depthPasses) continue;
+
+                if (pass.depthTest == SceneDepthTest::LessWrite) depth = fragment.depth;
+                if (shades) outcome.visible = static_cast<int>(i);
+            }
+        }
+        return outcome;
+    }
+
+    int PassRank(ScenePassKind kind)
+    {
+        switch (kind)
+        {
+        case ScenePassKind::DepthPrepass: return 0;
+        case ScenePassKind::Terrain: return 1;
+        default: return 2;
+        }
+    }
+
+    ScenePassValidationResult Validate(size_t pixelCount, uint32_t seed)
+    {
+        ScenePassValidationResult result;
+        result.pixelCount = pixelCount;
+
+        // Orden y estado de cada combinacion que puede pedir Game::Render
+        for (int prepass = 0; prepass < 2; ++prepass)
+        {
+            for (uint8_t visibleModes = 0; visibleModes < 4; ++visibleModes)
+            {
+                ScenePassPlan plan;
+                plan.Build(prepass != 0, visibleModes);
+                result.planCount++;
+
+                int previousRank = 0;
+                size_t terrainPasses = 0, modelPasses = 0;
+                uint8_t prepassModes = 0;
+                for (const ScenePass& pass : plan.passes)
+                {
+                    int rank = PassRank(pass.kind);
+                    if (rank < previousRank) result.orderErrors++;
+                    previousRank = rank;
+
+                    switch (pass.kind)
+                    {
+                    case ScenePassKind::DepthPrepass:
+                    {
+                        const bool masked = pass.alphaModes == MaterialAlphaBit(MaterialAlphaMode::Masked);
+                        const bool opaque = pass.alphaModes == MaterialAlphaBit(MaterialAlphaMode::Opaque);
+                        if (!prepass || (!masked && !opaque) || (prepassModes & pass.alphaModes) != 0) result.stateErrors++;
+                        if (pass.depthTest != SceneDepthTest::LessWrite || !pass.cullNone ||
+                            pass.pixelShader != (masked ? ScenePixelShader::DepthAlphaClip : ScenePixelShader::None)) result.stateErrors++;
+                        // Opacas primero: tapan mas y no necesitan pixel shader
+                        if (opaque && prepassModes != 0) result.orderErrors++;
+                        prepassModes |= pass.alphaModes;
+                        break;
+                    }
+                    case ScenePassKind::Terrain:
+                        terrainPasses++;
+                        if (pass.depthTest != SceneDepthTest::LessWrite || pass.cullNone || pass.alphaModes != 0 ||
+                            pass.pixelShader != ScenePixelShader::Terrain) result.stateErrors++;
+                        break;
+                    case ScenePassKind::Models:
+                        modelPasses++;
+                        if (pass.alphaModes != visibleModes || !pass.cullNone) result.stateErrors++;
+                        if (prepass && (pass.depthTest != SceneDepthTest::EqualNoWrite || pass.pixelShader != ScenePixelShader::EvolvingNoClip))
+                            result.stateErrors++;
+                        if (!prepass && (pass.depthTest != SceneDepthTest::LessWrite || pass.pixelShader != ScenePixelShader::Evolving))
+                            result.stateErrors++;
+                        break;
+                    }
+                }
+                if (terrainPasses != 1 || modelPasses != (visibleModes != 0 ? 1u : 0u)) result.orderErrors++;
+                if (prepassModes != (prepass ? visibleModes : 0)) result.stateErrors++;
+            }
+        }
+
+        // Fragmentos de un bosque: terreno casi siempre, varias capas de modelos por pixel, de las que
+        // un tercio son hojas con huecos. Profundidades distintas dentro del pixel (sin z-fighting).
+        ScenePassPlan withPrepass, withoutPrepass;
+        const uint8_t allModes = MaterialAlphaBit(MaterialAlphaMode::Opaque) | MaterialAlphaBit(MaterialAlphaMode::Masked);
+        withPrepass.Build(true, allModes);
+        withoutPrepass.Build(false, allModes);
+
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> depthDistribution(0.01f, 0.99f);
+        std::vector<Fragment> fragments;
+        for (size_t pixel = 0; pixel < pixelCount; ++pixel)
+        {
+            fragments.clear();
+            if (rng() % 10 < 8) fragments.push_back({ true, MaterialAlphaMode::Opaque, true, 0.0f });
+            const uint32_t layers = rng() % 7;
+            for (uint32_t layer = 0; layer < layers; ++layer)
+            {
+                const bool masked = rng() % 3 == 0;
+                fragments.push_back({ false, masked ? MaterialAlphaMode::Masked : MaterialAlphaMode::Opaque, !masked || rng() % 5 < 3, 0.0f });
+            }
+            for (size_t i = 0; i < fragments.size(); ++i)
+            {
+                bool unique;
+                do
+                {
+                    fragments[i].depth = depthDistribution(rng);
+                    unique = true;
+                    for (size_t j = 0; j < i; ++j) unique = unique && fragments[j].depth != fragments[i].depth;
+                } while (!unique);
+            }
+            result.fragmentCount += fragments.size();
+
+            PixelOutcome reference = RunPixel(withoutPrepass, fragments);
+            PixelOutcome prepassed = RunPixel(withPrepass, fragments);
+            result.shadedWithoutPrepass += reference.shaded;
+            result.shadedWithPrepass += prepassed.shaded;
+            if (prepassed.modelShaded > 1) result.overshadedPixels++;
+            if (prepassed.visible != reference.visible) result.imageMismatches++;
+        }
+        return result;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick = false;
+    if (!ParseQuickOption(argc, argv, quick)) return 2;
+
+    {
+        ScenePassValidationResult result = Validate(quick ? 20000 : 200000, 5);
+        std::printf("Scene passes, %zu plans, %zu pixels (%zu fragments): order errors %zu, state errors %zu, shaded %zu without pre-pass, %zu with, %zu overshaded, %zu image mismatches\n",
+            result.planCount, result.pixelCount, result.fragmentCount, result.orderErrors, result.stateErrors,
+            result.shadedWithoutPrepass, result.shadedWithPrepass, result.overshadedPixels, result.imageMismatches);
+        Check(result.orderErrors == 0, "pass order is not pre-pass -> terrain -> models");
+        Check(result.stateErrors == 0, "a scene pass uses the wrong shader or depth state");
+        Check(result.overshadedPixels == 0, "main pass shades more than one model fragment per pixel");
+        Check(result.imageMismatches == 0, "depth pre-pass changes the visible fragment");
+    }
+
+    // 2x2 RGBA con un texel por debajo del umbral de clip(), y el mismo con alfa 128
+    uint8_t texels[16] = { 10, 20, 30, 255, 10, 20, 30, 200, 10, 20, 30, 255, 10, 20, 30, 127 };
+    Check(ClassifyAlphaTexels(texels, 2, 2, 8, 4, 3) == MaterialAlphaMode::Masked, "alpha 127 texel not classified as masked");
+    texels[15] = 128;
+    Check(ClassifyAlphaTexels(texels, 2, 2, 8, 4, 3) == MaterialAlphaMode::Opaque, "alpha >= 128 texture classified as masked");
+    Check(ClassifyAlphaTexels(texels, 2, 2, 8, 4, 0) == MaterialAlphaMode::Masked, "grey opacity channel not read");
+
+    return FinishChecks();
+}
@@ -0,0 +1,349 @@
+// FireflyParticles en el volumen de Game a 60 Hz: la SoA frente a la simulacion escalar del bucle
+// anterior con std::sin y las mismas semillas (posicion, brillo y reapariciones), el mismo
+// resultado bit a bit con y sin pool, y el empaquetado de instancias (orden, color y capacidad).
+// Despues mide el camino anterior (AoS, std::sin por particula y rand() al reaparecer) frente a
+// la SoA en un hilo y en el pool.
+//
+//   FireflyParticlesTest          100000 particulas; medidas con 300, 10000 y 1000000
+//   FireflyParticlesTest --quick  10000 particulas; medidas con 300 (lo que ejecuta ctest)
+
+#include "FireflyParticles.h"
+#include "ThreadPool.h"
+#include "Check.h"
+#include "Measure.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    struct FireflyValidationResult
+    {
+        size_t particleCount = 0;
+        size_t frameCount = 0;
+        float maxPositionError = 0.0f;   // Frente a la simulacion escalar con std::sin (mismas semillas)
+        float maxBrightnessError = 0.0f;
+        size_t respawnMismatches = 0;    // Reapariciones en otro frame o en otro sitio que la referencia
+        bool deterministic = false;      // Mismo resultado, bit a bit, con y sin pool
+        size_t packedCount = 0;
+        size_t packValueMismatches = 0;  // Instancias distintas de baseColor * brillo de su particula
+        size_t packOrderErrors = 0;      // Fuera del orden de las particulas o repetidas
+        size_t packCapacityErrors = 0;   // Escrituras por encima de la capacidad pedida
+    };
+
+    struct FireflyBenchmarkResult
+    {
+        size_t particleCount = 0;
+        size_t frameCount = 0;
+        unsigned int threads = 1;
+        double aosMs = 0.0;              // Camino anterior: AoS, std::sin por particula y rand() al reaparecer (por frame)
+        double soaMs = 0.0;              // SoA en un hilo (por frame)
+        double parallelMs = 0.0;         // SoA repartida en el pool (por frame)
+        double aosParticlesPerMsPerCore = 0.0;
+        double soaParticlesPerMsPerCore = 0.0;
+        double parallelParticlesPerMsPerCore = 0.0;
+    };
+
+    const float BLINK_SPEED = 3.0f;       // Radianes de parpadeo por segundo
+    const float WOBBLE_AMPLITUDE = 0.2f;  // Velocidad vertical del vaiven: sin(2 * blink) * 0.2
+
+    // Volumen de las luciernagas en Game
+    const XMFLOAT3 VOLUME_CENTER(50.0f, -5.0f, -150.0f);
+    const XMFLOAT3 VOLUME_EXTENTS(150.0f, 20.0f, 200.0f);
+
+    // Los valores de cada reaparicion, como los documenta FireflyParticles: SplitMix64 sobre
+    // (semilla, indice, numero de reaparicion), 8 valores en [0, 1) con 24 bits
+    uint64_t Mix64(uint64_t z)
+    {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    float UnitFloat(uint32_t bits)
+    {
+        return static_cast<float>(bits >> 8) * (1.0f / 16777216.0f);
+    }
+
+    void SpawnValues(uint32_t seed, size_t index, uint32_t spawn, float out[8])
+    {
+        const uint64_t golden = 0x9E3779B97F4A7C15ull;
+        uint64_t state = Mix64(((static_cast<uint64_t>(index) << 32) | spawn) ^ (static_cast<uint64_t>(seed) * golden));
+        for (int k = 0; k < 4; ++k)
+        {
+            uint64_t bits = Mix64(state += golden);
+            out[2 * k] = UnitFloat(static_cast<uint32_t>(bits));
+            out[2 * k + 1] = UnitFloat(static_cast<uint32_t>(bits >> 32));
+        }
+    }
+
+    // Particula de la simulacion escalar de referencia (misma semilla que la SoA)
+    struct ReferenceParticle
+    {
+        float position[3];
+        float velocity[3];
+        float lifetime;
+        float blinkTimer;
+        float brightness;
+        uint32_t spawnCount;
+        bool diverged;       // Ya contada como reaparicion distinta: no se compara mas
+    };
+
+    void SpawnReference(ReferenceParticle& particle, size_t index, uint32_t seed)
+    {
+        float u[8];
+        SpawnValues(seed, index, particle.spawnCount++, u);
+        particle.position[0] = VOLUME_CENTER.x + (u[0] * 2.0f - 1.0f) * VOLUME_EXTENTS.x;
+        particle.position[1] = VOLUME_CENTER.y + (u[1] * 2.0f - 1.0f) * VOLUME_EXTENTS.y;
+        particle.position[2] = VOLUME_CENTER.z + (u[2] * 2.0f - 1.0f) * VOLUME_EXTENTS.z;
+        particle.velocity[0] = (u[3] * 2.0f - 1.0f) * 0.5f;
+        particle.velocity[1] = (u[4] * 2.0f - 1.0f) * 0.3f;
+        particle.velocity[2] = (u[5] * 2.0f - 1.0f) * 0.5f;
+        particle.lifetime = 4.0f + u[6] * 5.0f;
+        particle.blinkTimer = u[7] * XM_2PI;
+        particle.brightness = FireflyBrightness(particle.blinkTimer);
+    }
+
+    // Particula del camino anterior: AoS con campos que no se leen y rand() al reaparecer
+    struct LegacyParticle
+    {
+        XMFLOAT3 position;
+        XMFLOAT3 velocity;
+        float lifetime;
+        float maxLifetime;
+        float blinkTimer;
+        float rotation;
+        float brightness;
+    };
+
+    void SpawnLegacy(LegacyParticle& particle, const XMFLOAT3& center, const XMFLOAT3& extents)
+    {
+        particle.position.x = center.x + (((float)rand() / RAND_MAX) * 2.f - 1.f) * extents.x;
+        particle.position.y = center.y + (((float)rand() / RAND_MAX) * 2.f - 1.f) * extents.y;
+        particle.position.z = center.z + (((float)rand() / RAND_MAX) * 2.f - 1.f) * extents.z;
+        particle.velocity.x = (((float)rand() / RAND_MAX) * 2.f - 1.f) * 0.5f;
+        particle.velocity.y = (((float)rand() / RAND_MAX) * 2.f - 1.f) * 0.3f;
+        particle.velocity.z = (((float)rand() / RAND_MAX) * 2.f - 1.f) * 0.5f;
+        particle.maxLifetime = 4.0f + ((float)rand() / RAND_MAX) * 5.f;
+        particle.lifetime = particle.maxLifetime;
+        particle.blinkTimer = ((float)rand() / RAND_MAX) * 2.0f * XM_PI;
+        particle.rotation = ((float)rand() / RAND_MAX) * XM_2PI;
+    }
+
+    bool SameBits(float a, float b) { return std::memcmp(&a, &b, sizeof(float)) == 0; }
+
+    // Frames a 60 Hz frente a la simulacion escalar, con y sin pool, y el empaquetado de instancias.
+    FireflyValidationResult Validate(size_t particleCount, size_t frameCount, ThreadPool* pool)
+    {
+        FireflyValidationResult result;
+        result.particleCount = particleCount;
+        result.frameCount = frameCount;
+
+        // Con vidas de 4 a 9 s, 600 frames renuevan casi todas
+        const uint32_t seed = 7;
+        const float elapsedTime = 1.0f / 60.0f;
+
+        FireflyParticles serial;
+        FireflyParticles parallel;
+        serial.Reset(particleCount, VOLUME_CENTER, VOLUME_EXTENTS, seed);
+        parallel.Reset(particleCount, VOLUME_CENTER, VOLUME_EXTENTS, seed);
+
+        std::vector<ReferenceParticle> reference(particleCount);
+        for (size_t i = 0; i < reference.size(); ++i)
+        {
+            reference[i].spawnCount = 0;
+            reference[i].diverged = false;
+            SpawnReference(reference[i], i, seed);
+        }
+
+        // Una reaparicion en otro frame o con otros valores deja la particula lejos de la referencia;
+        // el error normal de la SoA es de 1e-5
+        const float respawnDistance = 0.1f;
+        for (size_t frame = 0; frame < frameCount; ++frame)
+        {
+            serial.Update(elapsedTime, nullptr);
+            parallel.Update(elapsedTime, pool);
+
+            for (size_t i = 0; i < reference.size(); ++i)
+            {
+                // Simulacion escalar: la del bucle anterior, con std::sin para el vaiven y el parpadeo
+                ReferenceParticle& particle = reference[i];
+                particle.lifetime -= elapsedTime;
+                if (particle.lifetime <= 0.0f) SpawnReference(particle, i, seed);
+                for (int k = 0; k < 3; ++k) particle.position[k] += particle.velocity[k] * elapsedTime;
+                particle.position[1] += std::sin(particle.blinkTimer * 2.0f) * WOBBLE_AMPLITUDE * elapsedTime;
+                particle.blinkTimer += elapsedTime * BLINK_SPEED;
+                if (particle.blinkTimer >= XM_2PI) particle.blinkTimer -= XM_2PI;
+                particle.brightness = FireflyBrightness(particle.blinkTimer);
+
+                if (particle.diverged) continue;
+                const XMFLOAT3 position = serial.GetPosition(i);
+                float error = std::max({ std::fabs(particle.position[0] - position.x),
+                    std::fabs(particle.position[1] - position.y), std::fabs(particle.position[2] - position.z) });
+                if (error > respawnDistance)
+                {
+                    result.respawnMismatches++;
+                    particle.diverged = true; // Contar cada divergencia una vez
+                    continue;
+                }
+                result.maxPositionError = std::max(result.maxPositionError, error);
+                result.maxBrightnessError = std::max(result.maxBrightnessError, std::fabs(particle.brightness - serial.GetBrightness(i)));
+            }
+        }
+
+        result.deterministic = serial.GetCount() == parallel.GetCount();
+        for (size_t i = 0; i < particleCount && result.deterministic; ++i)
+        {
+            const XMFLOAT3 a = serial.GetPosition(i);
+            const XMFLOAT3 b = parallel.GetPosition(i);
+            result.deterministic = SameBits(a.x, b.x) && SameBits(a.y, b.y) && SameBits(a.z, b.z) &&
+                SameBits(serial.GetBrightness(i), parallel.GetBrightness(i));
+        }
+
+        // Empaquetado: capacidad justa, con un centinela detras para detectar escrituras de mas
+        const XMFLOAT4 baseColor(1.5f, 2.0f, 1.0f, 1.0f);
+        const float size = 0.5f;
+        const size_t capacity = particleCount / 2;
+        std::vector<FireflyInstance> instances(capacity + 1);
+        instances[capacity].size = -1.0f;
+        result.packedCount = serial.Pack(size, baseColor, instances.data(), capacity);
+        if (result.packedCount > capacity || instances[capacity].size != -1.0f) result.packCapacityErrors++;
+
+        // Cada instancia es la siguiente particula visible, con el color que tenia el constant buffer.
+        // Tras Update ninguna tiene la vida agotada (la referencia lleva la misma cuenta)
+        auto visible = [&](size_t i) { return reference[i].lifetime > 0.0f && serial.GetBrightness(i) >= FIREFLY_MIN_BRIGHTNESS; };
+        size_t next = 0;
+        for (size_t k = 0; k < result.packedCount && k < capacity; ++k)
+        {
+            while (next < particleCount && !visible(next)) ++next;
+            if (next >= particleCount)
+            {
+                result.packOrderErrors++;
+                break;
+            }
+            const XMFLOAT3 position = serial.GetPosition(next);
+            const float brightness = serial.GetBrightness(next++);
+            const FireflyInstance& instance = instances[k];
+            if (instance.position.x != position.x || instance.position.y != position.y || instance.position.z != position.z)
+            {
+                result.packOrderErrors++;
+            }
+            if (instance.size != size || std::fabs(instance.color.x - 1.5f * brightness) > 1.0e-5f ||
+                std::fabs(instance.color.y - 2.0f * brightness) > 1.0e-5f || std::fabs(instance.color.z - 1.0f * brightness) > 1.0e-5f ||
+                std::fabs(instance.color.w - brightness) > 1.0e-5f)
+            {
+                result.packValueMismatches++;
+            }
+        }
+
+        // Con capacidad de sobra entran todas las visibles, y las del relleno nunca
+        std::vector<FireflyInstance> all(particleCount + 4);
+        size_t visibleCount = 0;
+        for (size_t i = 0; i < particleCount; ++i)
+        {
+            if (visible(i)) visibleCount++;
+        }
+        if (serial.Pack(size, baseColor, all.data(), all.size()) != visibleCount) result.packCapacityErrors++;
+        return result;
+    }
+
+    // Camino anterior frente a la SoA en un hilo y en el pool.
+    FireflyBenchmarkResult Benchmark(size_t particleCount, size_t frameCount, ThreadPool* pool)
+    {
+        FireflyBenchmarkResult result;
+        result.particleCount = particleCount;
+        result.frameCount = frameCount;
+        result.threads = pool ? pool->GetThreadCount() : 1;
+        if (particleCount == 0 || frameCount == 0) return result;
+
+        const float elapsedTime = 1.0f / 60.0f;
+        float checksum = 0.0f;
+
+        // Camino anterior: actualizacion de Game::UpdateFireflies y el parpadeo que calculaba el dibujado
+        {
+            std::vector<LegacyParticle> particles(particleCount);
+            for (LegacyParticle& particle : particles) SpawnLegacy(particle, VOLUME_CENTER, VOLUME_EXTENTS);
+
+            auto start = std::chrono::steady_clock::now();
+            for (size_t frame = 0; frame < frameCount; ++frame)
+            {
+                for (LegacyParticle& particle : particles)
+                {
+                    particle.lifetime -= elapsedTime;
+                    if (particle.lifetime <= 0.f) SpawnLegacy(particle, VOLUME_CENTER, VOLUME_EXTENTS);
+                    particle.position.x += particle.velocity.x * elapsedTime;
+                    particle.position.y += particle.velocity.y * elapsedTime;
+                    particle.position.z += particle.velocity.z * elapsedTime;
+                    particle.position.y += sin(particle.blinkTimer * 2.0f) * 0.2f * elapsedTime;
+                    particle.blinkTimer += elapsedTime * 3.0f;
+                    float blink = (sin(particle.blinkTimer) + 1.0f) / 2.0f;
+                    particle.brightness = pow(blink, 3.0f);
+                }
+            }
+            result.aosMs = MillisecondsSince(start) / frameCount;
+            for (const LegacyParticle& particle : particles) checksum += particle.position.y + particle.brightness;
+        }
+
+        FireflyParticles particles;
+        particles.Reset(particleCount, VOLUME_CENTER, VOLUME_EXTENTS, 1);
+        auto start = std::chrono::steady_clock::now();
+        for (size_t frame = 0; frame < frameCount; ++frame) particles.Update(elapsedTime, nullptr);
+        result.soaMs = MillisecondsSince(start) / frameCount;
+        checksum += particles.GetPosition(0).y + particles.GetBrightness(0);
+
+        particles.Reset(particleCount, VOLUME_CENTER, VOLUME_EXTENTS, 1);
+        start = std::chrono::steady_clock::now();
+        for (size_t frame = 0; frame < frameCount; ++frame) particles.Update(elapsedTime, pool);
+        result.parallelMs = MillisecondsSince(start) / frameCount;
+        checksum += particles.GetPosition(0).y + particles.GetBrightness(0);
+
+        // Que el compilador no descarte las simulaciones
+        if (checksum == -1.0f) result.frameCount++;
+
+        // Update solo reparte en el pool si hay mas de un bloque
+        const double count = static_cast<double>(particleCount);
+        const size_t chunks = (particleCount + FireflyParticles::CHUNK_SIZE - 1) / FireflyParticles::CHUNK_SIZE;
+        const unsigned int parallelThreads = (pool && chunks > 1) ? result.threads : 1;
+        if (result.aosMs > 0.0) result.aosParticlesPerMsPerCore = count / result.aosMs;
+        if (result.soaMs > 0.0) result.soaParticlesPerMsPerCore = count / result.soaMs;
+        if (result.parallelMs > 0.0) result.parallelParticlesPerMsPerCore = count / result.parallelMs / parallelThreads;
+        return result;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick = false;
+    if (!ParseQuickOption(argc, argv, quick)) return 2;
+
+    ThreadPool threadPool;
+    ThreadPool* pool = &threadPool;
+
+    {
+        FireflyValidationResult result = Validate(quick ? 10000 : 100000, 600, pool);
+        std::printf("Fireflies %zu x%zu frames: position error %.2e, brightness error %.2e, respawn mismatches %zu, deterministic %d, packed %zu, pack errors %zu/%zu/%zu\n",
+            result.particleCount, result.frameCount, result.maxPositionError, result.maxBrightnessError, result.respawnMismatches,
+            result.deterministic ? 1 : 0, result.packedCount, result.packValueMismatches, result.packOrderErrors, result.packCapacityErrors);
+        Check(result.maxPositionError < 1e-3f && result.maxBrightnessError < 1e-3f, "SoA simulation drifts from the scalar reference");
+        Check(result.respawnMismatches == 0, "fireflies respawn differently from the reference");
+        Check(result.deterministic, "firefly simulation differs with and without the pool");
+        Check(result.packValueMismatches == 0 && result.packOrderErrors == 0 && result.packCapacityErrors == 0, "firefly instance packing errors");
+    }
+
+    for (size_t particleCount : Sizes(quick, { size_t(300), size_t(10000), size_t(1000000) }))
+    {
+        FireflyBenchmarkResult result = Benchmark(particleCount, particleCount >= 1000000 ? 30 : 300, pool);
+        std::printf("Firefly update %zu particles: AoS %.3f ms, SoA %.3f ms, %u threads %.3f ms per frame; particles/ms/core %.0f, %.0f, %.0f\n",
+            result.particleCount, result.aosMs, result.soaMs, result.threads, result.parallelMs,
+            result.aosParticlesPerMsPerCore, result.soaParticlesPerMsPerCore, result.parallelParticlesPerMsPerCore);
+    }
+
+    return FinishChecks();
+}
@@ -0,0 +1,120 @@
+// HeightmapDecoder con los heightmaps del juego (GameAssets/textures): tamano, algunas alturas
+// sueltas, la suma de todas y el maximo. Los valores esperados son los bytes del canal rojo
+// sacados aparte con el zlib de Python (PNG) y leyendo el BMP a mano, sin pasar por este
+// decodificador (HeightmapReference.py). heightmap.png y heightmap.bmp son la misma imagen.
+
+#include "HeightmapDecoder.h"
+#include "Check.h"
+
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace
+{
+    struct SamplePoint
+    {
+        int x;
+        int y; // Fila desde arriba
+    };
+
+    const SamplePoint SAMPLE_POINTS[8] = { { 0, 0 }, { 255, 0 }, { 0, 255 }, { 255, 255 }, { 128, 128 }, { 37, 201 }, { 200, 13 }, { 91, 64 } };
+
+    struct ExpectedHeightmap
+    {
+        const char* file;
+        int width;
+        int height;
+        uint64_t redSum;    // Suma de los 256 * 256 bytes del canal rojo
+        int redMax;
+        int samples[8];     // Canal rojo en SAMPLE_POINTS
+    };
+
+    const ExpectedHeightmap EXPECTED[] = {
+        { "heightmap.png", 256, 256, 3522407, 233, { 0, 0, 31, 0, 212, 18, 1, 123 } },  // RGBA
+        { "heightmap1.png", 256, 256, 3611309, 239, { 189, 194, 190, 215, 16, 114, 80, 16 } }, // RGB
+        { "heightmap.bmp", 256, 256, 3522407, 233, { 0, 0, 31, 0, 212, 18, 1, 123 } } }; // 24 bits, de abajo a arriba
+
+    std::vector<uint8_t> ReadBytes(const std::filesystem::path& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        return std::vector<uint8_t>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    }
+
+    // Altura normalizada de vuelta al byte (todas las muestras son k / 255)
+    int ToByte(float height)
+    {
+        return static_cast<int>(std::lround(height * 255.0f));
+    }
+}
+
+int main()
+{
+    const std::filesystem::path textures = std::filesystem::path(GAME_ASSETS_DIR) / "textures";
+
+    std::vector<float> pngHeights, bmpHeights;
+    for (const ExpectedHeightmap& expected : EXPECTED)
+    {
+        const std::filesystem::path path = textures / expected.file;
+        int width = 0, height = 0;
+        std::vector<float> heights;
+        const bool loaded = CanDecodeHeightmapFile(path) && LoadHeightmapFile(path, width, height, heights);
+        Check(loaded, "game heightmap does not decode");
+        if (!loaded) continue;
+
+        Check(width == expected.width && height == expected.height && heights.size() == static_cast<size_t>(width) * height,
+            "wrong heightmap size");
+        if (heights.size() != static_cast<size_t>(expected.width) * expected.height) continue;
+
+        bool samples = true;
+        for (int k = 0; k < 8; ++k)
+        {
+            const float h = heights[static_cast<size_t>(SAMPLE_POINTS[k].y) * width + SAMPLE_POINTS[k].x];
+            samples = samples && std::fabs(h - expected.samples[k] / 255.0f) < 1e-6f;
+        }
+        Check(samples, "heightmap sample differs from the reference");
+
+        uint64_t sum = 0;
+        int maxByte = 0;
+        bool exactBytes = true;
+        for (float h : heights)
+        {
+            const int byte = ToByte(h);
+            exactBytes = exactBytes && std::fabs(h - byte / 255.0f) < 1e-6f;
+            sum += static_cast<uint64_t>(byte);
+            maxByte = byte > maxByte ? byte : maxByte;
+        }
+        Check(exactBytes, "heightmap values are not 8-bit levels");
+        Check(sum == expected.redSum && maxByte == expected.redMax, "heightmap sum or maximum differs from the reference");
+        std::printf("%s: %dx%d, sum %llu, max %d\n", expected.file, width, height, static_cast<unsigned long long>(sum), maxByte);
+
+        if (std::filesystem::path(expected.file).extension() == ".bmp") bmpHeights = heights;
+        else if (pngHeights.empty()) pngHeights = heights;
+    }
+    Check(!pngHeights.empty() && pngHeights == bmpHeights, "heightmap.png and heightmap.bmp decode differently");
+
+    // Archivos cortados: cualquier PNG o BMP incompleto se rechaza en vez de leer fuera del buffer
+    // (en el PNG basta con que falte algo de los IDAT; sin el IEND final la imagen sigue completa)
+    const std::vector<uint8_t> png = ReadBytes(textures / "heightmap1.png");
+    const std::vector<uint8_t> bmp = ReadBytes(textures / "heightmap.bmp");
+    bool truncatedRejected = !png.empty() && !bmp.empty();
+    for (size_t size = 0; truncatedRejected && size + 12 < png.size(); size += 97)
+    {
+        int width, height;
+        std::vector<float> heights;
+        truncatedRejected = !DecodePngHeightmap(png.data(), size, width, height, heights);
+    }
+    for (size_t size = 0; truncatedRejected && size < bmp.size(); size += 997)
+    {
+        int width, height;
+        std::vector<float> heights;
+        truncatedRejected = !DecodeBmpHeightmap(bmp.data(), size, width, height, heights);
+    }
+    Check(truncatedRejected, "truncated heightmap decodes");
+
+    Check(CanDecodeHeightmapFile("a/B.PNG") && CanDecodeHeightmapFile("c.r16") && !CanDecodeHeightmapFile("heightmap.psd"),
+        "wrong decoder chosen by extension");
+    return FinishChecks();
+}
@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+# Valores esperados de HeightmapDecoderTest.cpp, sacados sin el decodificador del juego: el PNG con
+# el zlib de Python y los filtros de la especificacion, el BMP leyendo las filas a mano.
+#   python3 GC2_PlantillaDB/Tests/HeightmapReference.py
+import os
+import struct
+import zlib
+
+TEXTURES = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'GameAssets', 'textures')
+SAMPLE_POINTS = [(0, 0), (255, 0), (0, 255), (255, 255), (128, 128), (37, 201), (200, 13), (91, 64)]
+
+
+def png_red(path):
+    data = open(path, 'rb').read()
+    assert data[:8] == b'\x89PNG\r\n\x1a\n'
+    position, idat = 8, b''
+    while position < len(data):
+        length, = struct.unpack('>I', data[position:position + 4])
+        kind, chunk = data[position + 4:position + 8], data[position + 8:position + 8 + length]
+        if kind == b'IHDR':
+            width, height, depth, color, _, _, interlace = struct.unpack('>IIBBBBB', chunk)
+        elif kind == b'IDAT':
+            idat += chunk
+        position += 12 + length
+    assert depth == 8 and interlace == 0
+    channels = {0: 1, 2: 3, 4: 2, 6: 4}[color]
+    raw = zlib.decompress(idat)
+    stride = width * channels
+    rows, previous = [], bytearray(stride)
+    for y in range(height):
+        start = y * (stride + 1)
+        kind, row = raw[start], bytearray(raw[start + 1:start + 1 + stride])
+        for k in range(stride):
+            a = row[k - channels] if k >= channels else 0
+            b = previous[k]
+            c = previous[k - channels] if k >= channels else 0
+            if kind == 1:
+                row[k] = (row[k] + a) & 255
+            elif kind == 2:
+                row[k] = (row[k] + b) & 255
+            elif kind == 3:
+                row[k] = (row[k] + ((a + b) >> 1)) & 255
+            elif kind == 4:
+                p = a + b - c
+                pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+                row[k] = (row[k] + (a if pa <= pb and pa <= pc else (b if pb <= pc else c))) & 255
+        rows.append([row[x * channels] for x in range(width)])
+        previous = row
+    return width, height, rows
+
+
+def bmp_red(path):
+    data = open(path, 'rb').read()
+    offset, = struct.unpack('<I', data[10:14])
+    width, height = struct.unpack('<ii', data[18:26])
+    bits, = struct.unpack('<H', data[28:30])
+    assert bits == 24 and height > 0
+    stride = (width * 3 + 3) // 4 * 4
+    # De abajo a arriba, BGR
+    rows = [[data[offset + stride * (height - 1 - y) + x * 3 + 2] for x in range(width)] for y in range(height)]
+    return width, height, rows
+
+
+for name in ['heightmap.png', 'heightmap1.png', 'heightmap.bmp']:
+    width, height, rows = (bmp_red if name.endswith('.bmp') else png_red)(os.path.join(TEXTURES, name))
+    values = [v for row in rows for v in row]
+    samples = ', '.join(str(rows[y][x]) for x, y in SAMPLE_POINTS)
+    print('{ "%s", %d, %d, %d, %d, { %s } },' % (name, width, height, sum(values), max(values), samples))
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <vector>
+
+// Opciones y tiempos de los ejecutables de Tests que ademas miden:
+//   XTest          tamanos completos (los de las medidas de cada modulo)
+//   XTest --quick  el tamano menor de cada lista (lo que ejecuta ctest)
+// Devuelve false (con el uso ya impreso) si los argumentos no se entienden.
+inline bool ParseQuickOption(int argc, char** argv, bool& quick)
+{
+    quick = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--quick") != 0)
+        {
+            std::fprintf(stderr, "usage: %s [--quick]\n", argv[0]);
+            return false;
+        }
+        quick = true;
+    }
+    return true;
+}
+
+// En modo rapido solo el primer tamano (el menor) de cada lista.
+template <typename T>
+std::vector<T> Sizes(bool quick, std::initializer_list<T> sizes)
+{
+    std::vector<T> result(sizes);
+    if (quick) result.resize(1);
+    return result;
+}
+
+inline double MillisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
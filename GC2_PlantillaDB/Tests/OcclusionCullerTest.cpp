@@ -0,0 +1,515 @@
+// OcclusionCuller frente a un rasterizador de referencia que guarda la profundidad exacta de cada
+// pixel: un valle con colinas (malla gruesa del terreno), cascos de casas y cajas, con la camara
+// dando vueltas por el pueblo. Ninguna caja visible en la referencia puede quedar oculta y el
+// buffer del culler nunca puede estar mas cerca que la referencia. Despues, el coste por frame a
+// 256x128, 512x256 y 1024x512 en un hilo y en el pool.
+//
+//   OcclusionCullerTest          120 frames y las tres resoluciones
+//   OcclusionCullerTest --quick  30 frames y 256x128 (lo que ejecuta ctest)
+
+#include "OcclusionCuller.h"
+#include "ThreadPool.h"
+#include "Check.h"
+#include "Measure.h"
+#include "TestMatrices.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <utility>
+#include <vector>
+
+using DirectX::XMFLOAT3;
+using DirectX::XMFLOAT4;
+using DirectX::XMFLOAT4X4;
+using TestMatrices::Identity;
+using TestMatrices::Multiply;
+using TestMatrices::TransformPoint;
+
+namespace
+{
+    // Resultado de Validate: el culler frente a un rasterizador de referencia que
+    // guarda la profundidad exacta de cada pixel, con la misma escena y las mismas camaras.
+    struct OcclusionValidationResult
+    {
+        size_t frames = 0;
+        size_t instanceCount = 0;       // Cajas probadas en cada frame
+        size_t occluderTriangles = 0;   // Terreno grueso + cascos de las casas (por frame)
+        size_t referenceHidden = 0;     // Suma de todos los frames: cajas ocultas segun la referencia...
+        size_t cullerHidden = 0;        // ...y segun el culler (nunca mas que la referencia)
+        size_t misculled = 0;           // Ocultas por el culler y visibles en la referencia: debe ser 0
+        size_t depthViolations = 0;     // Pixeles donde el culler guarda algo mas cerca que la referencia: debe ser 0
+        double cullerMsPerFrame = 0.0;  // Oclusores + rasterizar + probar todas las cajas
+        double referenceMsPerFrame = 0.0;
+    };
+
+    struct OcclusionBenchmarkResult
+    {
+        int width = 0;
+        int height = 0;
+        size_t frames = 0;
+        size_t instanceCount = 0;
+        size_t occluderTriangles = 0;
+        unsigned int threads = 1;
+        double rasterizeMs = 0.0;         // Por frame, en un hilo (oclusores incluidos)
+        double parallelRasterizeMs = 0.0; // Por frame, franjas repartidas en el pool
+        double testNsPerBox = 0.0;
+        double culledFraction = 0.0;      // Cajas ocultas / probadas
+    };
+
+    // Las mismas cuentas que OcclusionCuller.cpp: un vertice con w o z negativos esta detras del
+    // plano cercano, y en pantalla x va hacia la derecha, y hacia abajo y la profundidad es z/w.
+    bool BehindNearPlane(const XMFLOAT4& c)
+    {
+        return c.w <= 1e-5f || c.z < 0.0f;
+    }
+
+    void ToScreen(const XMFLOAT4& clip, float halfWidth, float halfHeight, float& x, float& y, float& depth)
+    {
+        const float invW = 1.0f / clip.w;
+        x = (clip.x * invW + 1.0f) * halfWidth;
+        y = (1.0f - clip.y * invW) * halfHeight;
+        depth = clip.z * invW;
+    }
+
+    // Escena de las comprobaciones y las medidas: un valle rodeado de colinas (la malla gruesa del terreno,
+    // como Terrain::BuildOccluderMesh), cascos de casas en el centro y cajas sobre el suelo.
+    struct OcclusionScene
+    {
+        std::vector<XMFLOAT3> terrainPositions; // Ya en mundo
+        std::vector<uint32_t> terrainIndices;
+        std::vector<XMFLOAT3> housePositions;   // Casco cerrado de 16 x 10 x 20 (paredes y tejado)
+        std::vector<uint32_t> houseIndices;
+        std::vector<XMFLOAT4X4> houseWorlds;
+        std::vector<XMFLOAT3> boxMin;
+        std::vector<XMFLOAT3> boxMax;
+        std::vector<XMFLOAT4X4> viewProjections; // Una camara por frame
+    };
+
+    OcclusionScene BuildScene(size_t frameCount, size_t instanceCount, float aspectRatio)
+    {
+        OcclusionScene scene;
+
+        // 1. Heightfield de 257 x 257 a 4 unidades por celda: llano en el centro, colinas al borde
+        const int size = 257;
+        const float cellSize = 4.0f;
+        const float heightScale = 150.0f;
+        const float halfExtent = 0.5f * cellSize * (size - 1);
+        std::vector<float> heights(static_cast<size_t>(size) * size);
+        for (int j = 0; j < size; ++j)
+        {
+            for (int i = 0; i < size; ++i)
+            {
+                float u = 2.0f * i / (size - 1) - 1.0f;
+                float v = 2.0f * j / (size - 1) - 1.0f;
+                float rim = std::min(std::max((std::sqrt(u * u + v * v) - 0.45f) / 0.45f, 0.0f), 1.0f);
+                rim = rim * rim * (3.0f - 2.0f * rim);
+                float h = 0.05f + 0.55f * rim + 0.06f * std::sin(i * 0.11f) * std::cos(j * 0.093f) + 0.03f * std::sin(i * 0.37f + j * 0.29f);
+                heights[static_cast<size_t>(j) * size + i] = std::max(h, 0.0f);
+            }
+        }
+        auto groundHeight = [&](float x, float z)
+        {
+            float fx = std::min(std::max((x + halfExtent) / cellSize, 0.0f), float(size - 1) - 1e-3f);
+            float fz = std::min(std::max((z + halfExtent) / cellSize, 0.0f), float(size - 1) - 1e-3f);
+            int i = static_cast<int>(fx), j = static_cast<int>(fz);
+            float tx = fx - i, tz = fz - j;
+            const float* row0 = &heights[static_cast<size_t>(j) * size + i];
+            const float* row1 = row0 + size;
+            float h = (row0[0] * (1.0f - tx) + row0[1] * tx) * (1.0f - tz) + (row1[0] * (1.0f - tx) + row1[1] * tx) * tz;
+            return h * heightScale;
+        };
+
+        // Malla gruesa cada 4 muestras con el minimo de la ventana: siempre por debajo de la real
+        const int step = 4;
+        const int coarse = (size - 1) / step + 1;
+        for (int r = 0; r < coarse; ++r)
+        {
+            for (int c = 0; c < coarse; ++c)
+            {
+                int gi = c * step, gj = r * step;
+                float minHeight = 1.0f;
+                for (int j = std::max(0, gj - step); j <= std::min(size - 1, gj + step); ++j)
+                    for (int i = std::max(0, gi - step); i <= std::min(size - 1, gi + step); ++i)
+                        minHeight = std::min(minHeight, heights[static_cast<size_t>(j) * size + i]);
+                scene.terrainPositions.emplace_back(gi * cellSize - halfExtent, minHeight * heightScale, gj * cellSize - halfExtent);
+            }
+        }
+        for (int r = 0; r + 1 < coarse; ++r)
+        {
+            for (int c = 0; c + 1 < coarse; ++c)
+            {
+                uint32_t topLeft = static_cast<uint32_t>(r * coarse + c);
+                uint32_t topRight = topLeft + 1;
+                uint32_t bottomLeft = topLeft + coarse;
+                uint32_t bottomRight = bottomLeft + 1;
+                for (uint32_t index : { topLeft, bottomLeft, topRight, topRight, bottomLeft, bottomRight }) scene.terrainIndices.push_back(index);
+            }
+        }
+
+        // 2. Casco de casa: caja cerrada de 16 x 10 x 20 con la base en y = 0
+        for (int c = 0; c < 8; ++c)
+        {
+            scene.housePositions.emplace_back((c & 1) ? 8.0f : -8.0f, (c & 2) ? 10.0f : 0.0f, (c & 4) ? 10.0f : -10.0f);
+        }
+        const uint32_t faces[6][4] = { { 0, 1, 3, 2 }, { 4, 6, 7, 5 }, { 0, 2, 6, 4 }, { 1, 5, 7, 3 }, { 0, 4, 5, 1 }, { 2, 3, 7, 6 } };
+        for (const auto& face : faces)
+        {
+            for (uint32_t index : { face[0], face[1], face[2], face[0], face[2], face[3] }) scene.houseIndices.push_back(index);
+        }
+
+        std::mt19937 random(2718);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        auto inRange = [&](float low, float high) { return low + (high - low) * unit(random); };
+
+        std::vector<XMFLOAT3> houseCenters;
+        for (int h = 0; h < 24; ++h)
+        {
+            float angle = inRange(-DirectX::XM_PI, DirectX::XM_PI);
+            float radius = inRange(45.0f, 180.0f);
+            float yaw = inRange(-DirectX::XM_PI, DirectX::XM_PI);
+            XMFLOAT3 center(radius * std::cos(angle), 0.0f, radius * std::sin(angle));
+            center.y = groundHeight(center.x, center.z) - 0.5f;
+            houseCenters.push_back(center);
+
+            XMFLOAT4X4 world = Identity();
+            world._11 = std::cos(yaw);  world._13 = -std::sin(yaw);
+            world._31 = std::sin(yaw);  world._33 = std::cos(yaw);
+            world._41 = center.x; world._42 = center.y; world._43 = center.z;
+            scene.houseWorlds.push_back(world);
+        }
+
+        // 3. Cajas de las instancias: sueltas por el valle y las laderas, y un tercio justo detras
+        //    de una casa (vista desde el centro)
+        for (size_t k = 0; k < instanceCount; ++k)
+        {
+            XMFLOAT3 center;
+            if (k % 3 == 0)
+            {
+                const XMFLOAT3& house = houseCenters[k / 3 % houseCenters.size()];
+                float length = std::sqrt(house.x * house.x + house.z * house.z);
+                float distance = length + inRange(14.0f, 40.0f);
+                float side = inRange(-8.0f, 8.0f);
+                center = XMFLOAT3(house.x / length * distance - house.z / length * side, 0.0f,
+                    house.z / length * distance + house.x / length * side);
+            }
+            else
+            {
+                float angle = inRange(-DirectX::XM_PI, DirectX::XM_PI);
+                float radius = 450.0f * std::sqrt(unit(random));
+                center = XMFLOAT3(radius * std::cos(angle), 0.0f, radius * std::sin(angle));
+            }
+            XMFLOAT3 extents(inRange(0.5f, 4.0f), inRange(0.5f, 4.0f), inRange(0.5f, 4.0f));
+            float ground = groundHeight(center.x, center.z);
+            scene.boxMin.emplace_back(center.x - extents.x, ground - 0.5f, center.z - extents.z);
+            scene.boxMax.emplace_back(center.x + extents.x, ground + 2.0f * extents.y, center.z + extents.z);
+        }
+
+        // 4. Camara a la altura de los ojos dando vueltas por el pueblo y girando; proyeccion RH de
+        //    45 grados con cerca = 1 y lejos = 5000, como la camara del juego
+        const float nearPlane = 1.0f, farPlane = 5000.0f;
+        const float yScale = 1.0f / std::tan(0.5f * DirectX::XM_PIDIV4);
+        XMFLOAT4X4 projection = {};
+        projection._11 = yScale / aspectRatio;
+        projection._22 = yScale;
+        projection._33 = farPlane / (nearPlane - farPlane);
+        projection._34 = -1.0f;
+        projection._43 = nearPlane * farPlane / (nearPlane - farPlane);
+
+        for (size_t frame = 0; frame < frameCount; ++frame)
+        {
+            float a = DirectX::XM_2PI * static_cast<float>(frame) / static_cast<float>(std::max<size_t>(frameCount, 1));
+            float radius = 20.0f + 25.0f * (0.5f + 0.5f * std::sin(3.0f * a));
+            XMFLOAT3 eye(radius * std::cos(a), 0.0f, radius * std::sin(a));
+            eye.y = groundHeight(eye.x, eye.z) + 1.8f;
+            float yaw = 2.0f * a + 0.3f * std::sin(5.0f * a);
+            float pitch = -0.05f + 0.1f * std::sin(7.0f * a);
+
+            // Vista RH (como CreateLookAt): el eje z de la camara apunta hacia atras
+            XMFLOAT3 back(-std::cos(pitch) * std::sin(yaw), -std::sin(pitch), -std::cos(pitch) * std::cos(yaw));
+            XMFLOAT3 right(back.z, 0.0f, -back.x); // (0, 1, 0) x back
+            float rightLength = std::sqrt(right.x * right.x + right.z * right.z);
+            right.x /= rightLength; right.z /= rightLength;
+            XMFLOAT3 up(back.y * right.z - back.z * right.y, back.z * right.x - back.x * right.z, back.x * right.y - back.y * right.x);
+
+            XMFLOAT4X4 view = Identity();
+            view._11 = right.x; view._12 = up.x; view._13 = back.x;
+            view._21 = right.y; view._22 = up.y; view._23 = back.y;
+            view._31 = right.z; view._32 = up.z; view._33 = back.z;
+            view._41 = -(right.x * eye.x + right.y * eye.y + right.z * eye.z);
+            view._42 = -(up.x * eye.x + up.y * eye.y + up.z * eye.z);
+            view._43 = -(back.x * eye.x + back.y * eye.y + back.z * eye.z);
+            scene.viewProjections.push_back(Multiply(view, projection));
+        }
+        return scene;
+    }
+
+    // Rasterizador de referencia: profundidad exacta (interpolada) en el centro de cada pixel, sin
+    // mascaras ni capas. Descarta los mismos triangulos que cruzan el plano cercano que el culler.
+    class ReferenceRasterizer
+    {
+    public:
+        ReferenceRasterizer(int width, int height) :
+            m_width(width), m_height(height), m_depth(static_cast<size_t>(width) * height, 1.0f), m_viewProjection(Identity())
+        {
+        }
+
+        void BeginFrame(const XMFLOAT4X4& viewProjection)
+        {
+            m_viewProjection = viewProjection;
+            std::fill(m_depth.begin(), m_depth.end(), 1.0f);
+        }
+
+        void AddOccluder(const XMFLOAT3* positions, const uint32_t* indices, size_t indexCount, const XMFLOAT4X4& world)
+        {
+            const XMFLOAT4X4 worldViewProj = Multiply(world, m_viewProjection);
+            for (size_t t = 0; t + 2 < indexCount; t += 3)
+            {
+                XMFLOAT4 clip[3];
+                for (int v = 0; v < 3; ++v) clip[v] = TransformPoint(positions[indices[t + v]], worldViewProj);
+                Rasterize(clip, [&](size_t pixel, float depth) { m_depth[pixel] = std::min(m_depth[pixel], depth); });
+            }
+        }
+
+        // Visible si algun centro de pixel de alguna cara queda por delante (o igual) que la referencia
+        bool IsVisible(const XMFLOAT3& boxMin, const XMFLOAT3& boxMax)
+        {
+            XMFLOAT4 corners[8];
+            for (int c = 0; c < 8; ++c)
+            {
+                XMFLOAT3 corner((c & 1) ? boxMax.x : boxMin.x, (c & 2) ? boxMax.y : boxMin.y, (c & 4) ? boxMax.z : boxMin.z);
+                corners[c] = TransformPoint(corner, m_viewProjection);
+                if (BehindNearPlane(corners[c])) return true; // Como el culler
+            }
+
+            static const int faces[6][4] = { { 0, 1, 3, 2 }, { 4, 6, 7, 5 }, { 0, 2, 6, 4 }, { 1, 5, 7, 3 }, { 0, 4, 5, 1 }, { 2, 3, 7, 6 } };
+            bool visible = false;
+            for (const auto& face : faces)
+            {
+                for (int half = 0; half < 2 && !visible; ++half)
+                {
+                    XMFLOAT4 clip[3] = { corners[face[0]], corners[face[1 + half]], corners[face[2 + half]] };
+                    Rasterize(clip, [&](size_t pixel, float depth)
+                    {
+                        if (depth <= 1.0f && depth <= m_depth[pixel]) visible = true;
+                    });
+                }
+            }
+            return visible;
+        }
+
+        float GetDepth(int x, int y) const { return m_depth[static_cast<size_t>(y) * m_width + x]; }
+
+    private:
+        // pixel(indice, profundidad) en cada centro de pixel cubierto
+        template <typename PixelFunction>
+        void Rasterize(const XMFLOAT4 clip[3], PixelFunction&& pixel) const
+        {
+            if (BehindNearPlane(clip[0]) || BehindNearPlane(clip[1]) || BehindNearPlane(clip[2])) return;
+
+            const float halfW = 0.5f * static_cast<float>(m_width);
+            const float halfH = 0.5f * static_cast<float>(m_height);
+            float x[3], y[3], z[3];
+            for (int v = 0; v < 3; ++v) ToScreen(clip[v], halfW, halfH, x[v], y[v], z[v]);
+
+            float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+            if (std::fabs(area) < 1e-6f) return;
+            if (area < 0.0f)
+            {
+                std::swap(x[1], x[2]);
+                std::swap(y[1], y[2]);
+                std::swap(z[1], z[2]);
+            }
+            const float minDepth = std::min(z[0], std::min(z[1], z[2]));
+            const float maxDepth = std::max(z[0], std::max(z[1], z[2]));
+
+            // Rectangulo de pixeles con un pixel de margen; dentro, todos los centros uno a uno
+            const int x0 = std::max(0, static_cast<int>(std::floor(std::min(x[0], std::min(x[1], x[2])))) - 1);
+            const int x1 = std::min(m_width - 1, static_cast<int>(std::floor(std::max(x[0], std::max(x[1], x[2])))) + 1);
+            const int y0 = std::max(0, static_cast<int>(std::floor(std::min(y[0], std::min(y[1], y[2])))) - 1);
+            const int y1 = std::min(m_height - 1, static_cast<int>(std::floor(std::max(y[0], std::max(y[1], y[2])))) + 1);
+            for (int py = y0; py <= y1; ++py)
+            {
+                const float cy = static_cast<float>(py) + 0.5f;
+                for (int px = x0; px <= x1; ++px)
+                {
+                    const float cx = static_cast<float>(px) + 0.5f;
+                    float edge[3];
+                    for (int e = 0; e < 3; ++e)
+                    {
+                        const int n = (e + 1) % 3;
+                        const float a = -(y[n] - y[e]);
+                        const float b = x[n] - x[e];
+                        const float c = -(a * x[e] + b * y[e]);
+                        edge[e] = a * cx + (b * cy + c);
+                    }
+                    if (edge[0] < 0.0f || edge[1] < 0.0f || edge[2] < 0.0f) continue;
+
+                    // La arista e es la opuesta al vertice (e + 2) % 3
+                    const float sum = edge[0] + edge[1] + edge[2];
+                    float depth = sum > 0.0f ? (edge[1] * z[0] + edge[2] * z[1] + edge[0] * z[2]) / sum : maxDepth;
+                    depth = std::min(std::max(depth, minDepth), maxDepth);
+                    pixel(static_cast<size_t>(py) * m_width + px, depth);
+                }
+            }
+        }
+
+        int m_width;
+        int m_height;
+        std::vector<float> m_depth;
+        XMFLOAT4X4 m_viewProjection;
+    };
+
+    void AddSceneOccluders(OcclusionCuller& culler, const OcclusionScene& scene, const XMFLOAT4X4& identity)
+    {
+        culler.AddOccluder(scene.terrainPositions.data(), scene.terrainPositions.size(),
+            scene.terrainIndices.data(), scene.terrainIndices.size(), identity);
+        for (const XMFLOAT4X4& world : scene.houseWorlds)
+        {
+            culler.AddOccluder(scene.housePositions.data(), scene.housePositions.size(),
+                scene.houseIndices.data(), scene.houseIndices.size(), world);
+        }
+    }
+
+    OcclusionValidationResult Validate(size_t frameCount, size_t instanceCount, ThreadPool* pool)
+    {
+        OcclusionValidationResult result;
+        result.frames = frameCount;
+        result.instanceCount = instanceCount;
+
+        OcclusionCuller culler(256, 128);
+        culler.SetThreadPool(pool);
+        ReferenceRasterizer reference(culler.GetWidth(), culler.GetHeight());
+        const OcclusionScene scene = BuildScene(frameCount, instanceCount, 16.0f / 9.0f);
+        const XMFLOAT4X4 identity = Identity();
+
+        std::vector<char> cullerVisible(instanceCount), referenceVisible(instanceCount);
+        double cullerMs = 0.0, referenceMs = 0.0;
+        for (size_t frame = 0; frame < frameCount; ++frame)
+        {
+            auto start = std::chrono::steady_clock::now();
+            culler.BeginFrame(scene.viewProjections[frame]);
+            AddSceneOccluders(culler, scene, identity);
+            culler.RasterizeOccluders();
+            for (size_t i = 0; i < instanceCount; ++i) cullerVisible[i] = culler.IsVisible(scene.boxMin[i], scene.boxMax[i]) ? 1 : 0;
+            cullerMs += MillisecondsSince(start);
+            result.occluderTriangles = static_cast<size_t>(culler.GetStats().occluderTriangles);
+
+            start = std::chrono::steady_clock::now();
+            reference.BeginFrame(scene.viewProjections[frame]);
+            reference.AddOccluder(scene.terrainPositions.data(), scene.terrainIndices.data(), scene.terrainIndices.size(), identity);
+            for (const XMFLOAT4X4& world : scene.houseWorlds)
+            {
+                reference.AddOccluder(scene.housePositions.data(), scene.houseIndices.data(), scene.houseIndices.size(), world);
+            }
+            for (size_t i = 0; i < instanceCount; ++i) referenceVisible[i] = reference.IsVisible(scene.boxMin[i], scene.boxMax[i]) ? 1 : 0;
+            referenceMs += MillisecondsSince(start);
+
+            for (size_t i = 0; i < instanceCount; ++i)
+            {
+                if (!referenceVisible[i]) result.referenceHidden++;
+                if (!cullerVisible[i]) result.cullerHidden++;
+                if (!cullerVisible[i] && referenceVisible[i]) result.misculled++;
+            }
+            for (int y = 0; y < culler.GetHeight(); ++y)
+            {
+                for (int x = 0; x < culler.GetWidth(); ++x)
+                {
+                    if (culler.GetDepth(x, y) < reference.GetDepth(x, y)) result.depthViolations++;
+                }
+            }
+        }
+
+        if (frameCount > 0)
+        {
+            result.cullerMsPerFrame = cullerMs / frameCount;
+            result.referenceMsPerFrame = referenceMs / frameCount;
+        }
+        return result;
+    }
+
+    OcclusionBenchmarkResult Benchmark(int width, int height, size_t instanceCount, size_t frameCount, ThreadPool* pool)
+    {
+        OcclusionBenchmarkResult result;
+        result.frames = frameCount;
+        result.instanceCount = instanceCount;
+        result.threads = pool ? pool->GetThreadCount() : 1;
+
+        OcclusionCuller serial(width, height);
+        OcclusionCuller parallel(width, height);
+        parallel.SetThreadPool(pool);
+        result.width = serial.GetWidth();
+        result.height = serial.GetHeight();
+
+        const OcclusionScene scene = BuildScene(frameCount, instanceCount, static_cast<float>(width) / static_cast<float>(height));
+        const XMFLOAT4X4 identity = Identity();
+
+        double serialMs = 0.0, parallelMs = 0.0, testMs = 0.0;
+        size_t tested = 0, culled = 0;
+        for (size_t frame = 0; frame < frameCount; ++frame)
+        {
+            auto start = std::chrono::steady_clock::now();
+            serial.BeginFrame(scene.viewProjections[frame]);
+            AddSceneOccluders(serial, scene, identity);
+            serial.RasterizeOccluders();
+            serialMs += MillisecondsSince(start);
+
+            start = std::chrono::steady_clock::now();
+            parallel.BeginFrame(scene.viewProjections[frame]);
+            AddSceneOccluders(parallel, scene, identity);
+            parallel.RasterizeOccluders();
+            parallelMs += MillisecondsSince(start);
+
+            start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < instanceCount; ++i)
+            {
+                if (!serial.IsVisible(scene.boxMin[i], scene.boxMax[i])) culled++;
+            }
+            testMs += MillisecondsSince(start);
+            tested += instanceCount;
+            result.occluderTriangles = static_cast<size_t>(serial.GetStats().occluderTriangles);
+        }
+
+        if (frameCount > 0)
+        {
+            result.rasterizeMs = serialMs / frameCount;
+            result.parallelRasterizeMs = parallelMs / frameCount;
+        }
+        if (tested > 0)
+        {
+            result.testNsPerBox = testMs * 1.0e6 / static_cast<double>(tested);
+            result.culledFraction = static_cast<double>(culled) / static_cast<double>(tested);
+        }
+        return result;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick = false;
+    if (!ParseQuickOption(argc, argv, quick)) return 2;
+
+    ThreadPool threadPool;
+    ThreadPool* pool = &threadPool;
+
+    {
+        OcclusionValidationResult result = Validate(quick ? 30 : 120, 2000, pool);
+        std::printf("Occlusion culler %zu frames x%zu boxes (%zu occluder tris): hidden %zu of %zu (reference), misculled %zu, depth violations %zu, %.2f ms per frame (reference %.1f ms)\n",
+            result.frames, result.instanceCount, result.occluderTriangles, result.cullerHidden, result.referenceHidden,
+            result.misculled, result.depthViolations, result.cullerMsPerFrame, result.referenceMsPerFrame);
+        Check(result.referenceHidden > 0, "the scene hides no box in the reference");
+        Check(result.misculled == 0, "occlusion culler hides a visible box");
+        Check(result.depthViolations == 0, "occlusion buffer is nearer than the reference");
+    }
+
+    for (int scale : Sizes(quick, { 1, 2, 4 }))
+    {
+        OcclusionBenchmarkResult result = Benchmark(256 * scale, 128 * scale, 2000, 120, pool);
+        std::printf("Occlusion culler %dx%d, %zu tris: rasterize %.2f ms, %u threads %.2f ms per frame, test %.0f ns per box, %.1f%% culled\n",
+            result.width, result.height, result.occluderTriangles, result.rasterizeMs, result.threads, result.parallelRasterizeMs,
+            result.testNsPerBox, 100.0 * result.culledFraction);
+    }
+
+    return FinishChecks();
+}
@@ -0,0 +1,187 @@
+// ShaderPack: escribir y volver a leer paquetes, busquedas que aciertan y que fallan, hashes
+// repetidos y archivos danados (cortados, otra firma, offsets fuera del archivo).
+
+#include "ShaderPack.h"
+#include "Check.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    std::vector<uint8_t> Bytes(const char* text)
+    {
+        return std::vector<uint8_t>(text, text + strlen(text));
+    }
+
+    bool FindsBytes(const ShaderPack& pack, const std::string& name, const std::vector<uint8_t>& expected)
+    {
+        const void* data = nullptr;
+        size_t size = 0;
+        if (!pack.Find(name, data, size) || size != expected.size()) return false;
+        return size == 0 || memcmp(data, expected.data(), size) == 0;
+    }
+
+    // Entrada i de la tabla de un paquete en memoria
+    void SetEntry(std::vector<uint8_t>& data, size_t index, uint64_t nameHash, uint32_t offset, uint32_t size)
+    {
+        ShaderPack::Entry entry = { nameHash, offset, size };
+        memcpy(data.data() + sizeof(ShaderPack::Header) + index * sizeof(ShaderPack::Entry), &entry, sizeof(entry));
+    }
+
+    ShaderPack::Entry GetEntry(const std::vector<uint8_t>& data, size_t index)
+    {
+        ShaderPack::Entry entry;
+        memcpy(&entry, data.data() + sizeof(ShaderPack::Header) + index * sizeof(ShaderPack::Entry), sizeof(entry));
+        return entry;
+    }
+
+    bool Loads(std::vector<uint8_t> data)
+    {
+        ShaderPack pack;
+        return pack.LoadFromMemory(std::move(data));
+    }
+}
+
+int main()
+{
+    const std::vector<ShaderPack::SourceBlob> blobs = {
+        { "EvolvingVS", Bytes("evolving vertex shader bytecode") },
+        { "EvolvingPS", Bytes("evolving pixel shader") },
+        { "ShadowPS_AlphaClip", Bytes("alpha clip") },
+        { "TerrainPS", Bytes("terrain pixel shader, somewhat longer than the others") },
+        { "Empty", {} } };
+
+    // Escribir y leer en memoria: cada nombre encuentra sus bytes, sin importar mayusculas
+    std::vector<uint8_t> packData;
+    std::string error;
+    Check(ShaderPack::Build(blobs, packData, &error), "valid blobs rejected by the writer");
+    ShaderPack pack;
+    Check(pack.LoadFromMemory(packData) && pack.IsLoaded() && pack.GetEntryCount() == blobs.size(), "written pack does not load");
+    for (const ShaderPack::SourceBlob& blob : blobs)
+    {
+        Check(FindsBytes(pack, blob.name, blob.data), "lookup does not return the written blob");
+    }
+    Check(FindsBytes(pack, "evolvingvs", blobs[0].data) && FindsBytes(pack, "TERRAINPS", blobs[3].data), "lookup is case sensitive");
+    {
+        const void* data = nullptr;
+        size_t size = 0;
+        Check(pack.Find(std::wstring(L"EvolvingPS"), data, size) && size == blobs[1].data.size(), "wide-name lookup misses");
+        Check(!pack.Find("MissingPS", data, size) && !pack.Find(std::wstring(L"EvolvingVS_"), data, size) && !pack.Find("", data, size),
+            "lookup of an absent name hits");
+    }
+
+    // Tabla ordenada por hash y blobs contiguos detras de ella
+    {
+        bool sorted = true;
+        uint32_t expectedOffset = static_cast<uint32_t>(sizeof(ShaderPack::Header) + blobs.size() * sizeof(ShaderPack::Entry));
+        for (size_t i = 0; i < blobs.size(); ++i)
+        {
+            ShaderPack::Entry entry = GetEntry(packData, i);
+            if (i > 0 && GetEntry(packData, i - 1).nameHash >= entry.nameHash) sorted = false;
+            if (entry.offset != expectedOffset) sorted = false;
+            expectedOffset += entry.size;
+        }
+        Check(sorted && expectedOffset == packData.size(), "table is not sorted or blobs are not contiguous");
+    }
+
+    // Ida y vuelta por disco, tambien recogiendo los .cso de un directorio como el paso de compilacion
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "GC2_ShaderPackTest";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    for (const ShaderPack::SourceBlob& blob : blobs)
+    {
+        std::ofstream file(directory / (blob.name + ".cso"), std::ios::binary);
+        file.write(reinterpret_cast<const char*>(blob.data.data()), static_cast<std::streamsize>(blob.data.size()));
+    }
+    std::ofstream(directory / "notes.txt") << "not a shader";
+    {
+        std::vector<ShaderPack::SourceBlob> collected;
+        std::vector<uint8_t> collectedData;
+        Check(ShaderPack::CollectDirectory(directory, collected) && collected.size() == blobs.size(), "directory scan misses .cso files");
+        Check(ShaderPack::Build(collected, collectedData) && collectedData == packData, "pack depends on the input order");
+
+        std::filesystem::path packPath = directory / "Shaders.pack";
+        ShaderPack fromFile;
+        Check(ShaderPack::WriteToFile(collected, packPath) && fromFile.LoadFromFile(packPath), "pack file does not round trip");
+        Check(FindsBytes(fromFile, "ShadowPS_AlphaClip", blobs[2].data) && FindsBytes(fromFile, "Empty", {}), "file lookup differs");
+        Check(!fromFile.LoadFromFile(directory / "Missing.pack") && !fromFile.IsLoaded(), "missing file keeps the old pack");
+    }
+    std::filesystem::remove_all(directory);
+
+    // Hashes repetidos: el escritor los rechaza (el nombre se hashea en minusculas) y el lector
+    // tampoco acepta una tabla con el mismo hash dos veces o desordenada
+    {
+        std::vector<ShaderPack::SourceBlob> colliding = blobs;
+        colliding.push_back({ "evolvingvs", Bytes("another shader") });
+        std::vector<uint8_t> data;
+        error.clear();
+        Check(!ShaderPack::Build(colliding, data, &error) && !error.empty(), "writer accepts two names with the same hash");
+        std::printf("Colliding names: %s\n", error.c_str());
+
+        std::vector<uint8_t> duplicated = packData;
+        ShaderPack::Entry second = GetEntry(packData, 1);
+        SetEntry(duplicated, 1, GetEntry(packData, 0).nameHash, second.offset, second.size);
+        Check(!Loads(duplicated), "reader accepts a repeated hash");
+
+        std::vector<uint8_t> unsorted = packData;
+        ShaderPack::Entry first = GetEntry(packData, 0);
+        SetEntry(unsorted, 0, second.nameHash, first.offset, first.size);
+        SetEntry(unsorted, 1, first.nameHash, second.offset, second.size);
+        Check(!Loads(unsorted), "reader accepts an unsorted table");
+    }
+
+    // Archivos cortados por cualquier byte, otra firma u otra version
+    {
+        size_t truncatedLoads = 0;
+        for (size_t size = 0; size < packData.size(); ++size)
+        {
+            if (Loads(std::vector<uint8_t>(packData.begin(), packData.begin() + size))) truncatedLoads++;
+        }
+        Check(truncatedLoads == 0, "truncated pack loads");
+
+        std::vector<uint8_t> badMagic = packData;
+        badMagic[0] ^= 0x20;
+        Check(!Loads(badMagic), "pack with a bad magic loads");
+        std::vector<uint8_t> badVersion = packData;
+        badVersion[4] = static_cast<uint8_t>(ShaderPack::VERSION + 1);
+        Check(!Loads(badVersion), "pack with another version loads");
+
+        std::vector<uint8_t> hugeCount = packData;
+        memset(hugeCount.data() + 8, 0xFF, 4);
+        Check(!Loads(hugeCount), "entry count past the end of the file loads");
+    }
+
+    // Offsets fuera del archivo, dentro de la tabla, o que desbordan 32 bits al sumar el tamano
+    {
+        const ShaderPack::Entry last = GetEntry(packData, blobs.size() - 1);
+        const uint32_t tableEnd = static_cast<uint32_t>(sizeof(ShaderPack::Header) + blobs.size() * sizeof(ShaderPack::Entry));
+        const struct { uint32_t offset; uint32_t size; const char* what; } cases[] = {
+            { static_cast<uint32_t>(packData.size()), 1, "blob past the end of the file" },
+            { last.offset, last.size + 1, "blob one byte too long" },
+            { tableEnd - 4, 4, "blob inside the entry table" },
+            { 0xFFFFFFF0u, 0x20u, "offset + size overflowing 32 bits" } };
+        for (const auto& c : cases)
+        {
+            std::vector<uint8_t> data = packData;
+            SetEntry(data, blobs.size() - 1, last.nameHash, c.offset, c.size);
+            Check(!Loads(data), c.what);
+        }
+
+        // Un paquete valido despues de uno danado vuelve a cargar y uno danado descarta el anterior
+        std::vector<uint8_t> data = packData;
+        SetEntry(data, 0, GetEntry(packData, 0).nameHash, static_cast<uint32_t>(packData.size()), 8);
+        ShaderPack reused;
+        Check(reused.LoadFromMemory(packData) && !reused.LoadFromMemory(data) && !reused.IsLoaded(), "failed load keeps stale entries");
+        const void* blob = nullptr;
+        size_t size = 0;
+        Check(!reused.Find("EvolvingVS", blob, size), "lookup hits after a failed load");
+    }
+
+    std::printf("Shader pack: %zu blobs, %zu bytes\n", blobs.size(), packData.size());
+    return FinishChecks();
+}
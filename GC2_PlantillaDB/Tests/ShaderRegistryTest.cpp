@@ -0,0 +1,208 @@
+// BasicShaderRegistry con un dispositivo que solo cuenta lo que se le pide crear: un VS y un PS
+// por blob distinto, un input layout por layout distinto y los programas repetidos reutilizados.
+// Los .cso y el paquete son bytes inventados en un directorio temporal (el dispositivo no los
+// interpreta).
+
+#include "BasicShaderRegistry.h"
+#include "Check.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+
+namespace
+{
+    // Referencia minima con la interfaz que usa el registro (Get y copia)
+    template <typename T>
+    struct StubRef
+    {
+        std::shared_ptr<T> object;
+        T* Get() const { return object.get(); }
+    };
+
+    struct StubShader
+    {
+        std::string bytecode;
+    };
+
+    struct StubLayout
+    {
+        uint32_t elementCount = 0;
+    };
+
+    struct StubBuffer
+    {
+        uint32_t byteWidth = 0;
+    };
+
+    struct StubInputElement
+    {
+        const char* SemanticName;
+        uint32_t SemanticIndex;
+        uint32_t Format;
+        uint32_t InputSlot;
+        uint32_t AlignedByteOffset;
+        uint32_t InputSlotClass;
+        uint32_t InstanceDataStepRate;
+    };
+
+    struct CountingDevice
+    {
+        template <typename T> using Ref = StubRef<T>;
+        using VertexShader = StubShader;
+        using PixelShader = StubShader;
+        using InputLayout = StubLayout;
+        using Buffer = StubBuffer;
+        using InputElement = StubInputElement;
+
+        int vertexShaders = 0;
+        int pixelShaders = 0;
+        int inputLayouts = 0;
+        int constantBuffers = 0;
+        int errors = 0;
+
+        bool CreateVertexShader(const void* bytecode, size_t size, Ref<VertexShader>& out)
+        {
+            vertexShaders++;
+            out.object = std::make_shared<StubShader>(StubShader{ std::string(static_cast<const char*>(bytecode), size) });
+            return true;
+        }
+
+        bool CreatePixelShader(const void* bytecode, size_t size, Ref<PixelShader>& out)
+        {
+            pixelShaders++;
+            out.object = std::make_shared<StubShader>(StubShader{ std::string(static_cast<const char*>(bytecode), size) });
+            return true;
+        }
+
+        bool CreateInputLayout(const InputElement*, uint32_t elementCount, const void*, size_t, Ref<InputLayout>& out)
+        {
+            inputLayouts++;
+            out.object = std::make_shared<StubLayout>(StubLayout{ elementCount });
+            return true;
+        }
+
+        bool CreateConstantBuffer(uint32_t byteWidth, Ref<Buffer>& out)
+        {
+            constantBuffers++;
+            out.object = std::make_shared<StubBuffer>(StubBuffer{ byteWidth });
+            return true;
+        }
+
+        void ReportError(const std::wstring&) { errors++; }
+    };
+
+    void WriteFile(const std::filesystem::path& path, const std::string& contents)
+    {
+        std::ofstream file(path, std::ios::binary);
+        file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+    }
+}
+
+int main()
+{
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "GC2_ShaderRegistryTest";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    WriteFile(directory / "EvolvingVS.cso", "vertex shader A");
+    WriteFile(directory / "EvolvingVS_Copy.cso", "vertex shader A"); // Mismo bytecode con otro nombre
+    WriteFile(directory / "ShadowVS.cso", "vertex shader B");
+    WriteFile(directory / "EvolvingPS.cso", "pixel shader A");
+    WriteFile(directory / "EvolvingPS_NoClip.cso", "pixel shader B");
+
+    // El nombre de la semantica se compara por contenido: otra copia del texto es el mismo layout
+    char positionName[] = "POSITION";
+    const StubInputElement modelLayout[] = {
+        { "POSITION", 0, 6, 0, 0, 0, 0 },
+        { "TEXCOORD", 0, 16, 0, 12, 0, 0 },
+        { "NORMAL", 0, 6, 0, 20, 0, 0 } };
+    const StubInputElement modelLayoutCopy[] = {
+        { positionName, 0, 6, 0, 0, 0, 0 },
+        { "TEXCOORD", 0, 16, 0, 12, 0, 0 },
+        { "NORMAL", 0, 6, 0, 20, 0, 0 } };
+    const StubInputElement packedLayout[] = {
+        { "POSITION", 0, 6, 0, 0, 0, 0 },
+        { "TEXCOORD", 0, 16, 0, 12, 0, 0 },
+        { "NORMAL", 0, 28, 0, 20, 0, 0 } }; // Normal empaquetada: otro formato
+
+    BasicShaderRegistry<CountingDevice> registry(CountingDevice(), directory);
+    const CountingDevice& device = registry.GetDevice();
+
+    ShaderProgramHandle first = registry.LoadProgram(L"EvolvingVS", L"EvolvingPS", modelLayout, 3);
+    ShaderProgramHandle again = registry.LoadProgram(L"EvolvingVS", L"EvolvingPS", modelLayoutCopy, 3);
+    Check(first != INVALID_SHADER_PROGRAM && first == again, "same program request returns another handle");
+    Check(device.vertexShaders == 1 && device.pixelShaders == 1 && device.inputLayouts == 1,
+        "repeated program creates device objects again");
+
+    // Mismo par VS/PS con otro layout: otro programa y otro layout, pero los mismos shaders
+    ShaderProgramHandle packed = registry.LoadProgram(L"EvolvingVS", L"EvolvingPS", packedLayout, 3);
+    Check(packed != INVALID_SHADER_PROGRAM && packed != first, "different layout shares the program");
+    Check(device.vertexShaders == 1 && device.pixelShaders == 1 && device.inputLayouts == 2,
+        "new layout recreates the shaders or reuses the layout");
+    Check(registry.GetProgram(packed)->vertexShader.Get() == registry.GetProgram(first)->vertexShader.Get(),
+        "programs do not share the vertex shader");
+
+    // Otro nombre con el mismo bytecode: el mismo objeto
+    Check(registry.GetVertexShader(L"EvolvingVS_Copy") == registry.GetProgram(first)->vertexShader.Get(),
+        "identical blob under another name creates another vertex shader");
+    Check(device.vertexShaders == 1, "one vertex shader per unique blob");
+
+    // Solo profundidad: sin pixel shader, el layout del modelo ya existe aunque el VS sea otro
+    ShaderProgramHandle depthOnly = registry.LoadProgram(L"ShadowVS", L"", modelLayout, 3);
+    Check(depthOnly != INVALID_SHADER_PROGRAM && registry.GetProgram(depthOnly)->pixelShader.Get() == nullptr,
+        "depth-only program has a pixel shader");
+    Check(device.vertexShaders == 2 && device.inputLayouts == 2, "depth-only program duplicates the layout");
+    Check(registry.GetPixelShader(L"EvolvingPS_NoClip") != registry.GetPixelShader(L"EvolvingPS") && device.pixelShaders == 2,
+        "different pixel shader blobs share an object");
+    Check(registry.GetInputLayout(modelLayoutCopy, 3, L"ShadowVS") == registry.GetProgram(first)->inputLayout.Get(),
+        "GetInputLayout misses the cached layout");
+
+    // Constant buffers por nombre; el mismo nombre con otro tamano es un error
+    StubBuffer* perObject = registry.GetConstantBuffer("PerObject", 256);
+    Check(perObject && registry.GetConstantBuffer("PerObject", 256) == perObject && device.constantBuffers == 1,
+        "constant buffer is created twice");
+    Check(registry.GetConstantBuffer("PerObject", 128) == nullptr && device.errors == 1, "constant buffer size mismatch accepted");
+
+    // Lo que falta no crea nada
+    Check(registry.LoadProgram(L"MissingVS", L"EvolvingPS", modelLayout, 3) == INVALID_SHADER_PROGRAM && device.errors == 2,
+        "missing shader yields a program");
+
+    const ShaderRegistryStats& stats = registry.GetStats();
+    std::printf("Shader registry: %d blob reads, %d VS, %d PS, %d layouts, %d programs for %d requests, %d errors\n",
+        stats.blobReads, stats.vertexShadersCreated, stats.pixelShadersCreated, stats.inputLayoutsCreated,
+        stats.programsCreated, stats.programRequests, device.errors);
+    Check(stats.blobReads == 5, "a blob was read more than once");
+    Check(stats.vertexShadersCreated == device.vertexShaders && stats.pixelShadersCreated == device.pixelShaders &&
+        stats.inputLayoutsCreated == device.inputLayouts && stats.constantBuffersCreated == device.constantBuffers,
+        "registry stats disagree with the device");
+    Check(stats.programsCreated == 3 && stats.programRequests == 5, "program counts");
+
+    // Tras Clear (dispositivo perdido) todo se vuelve a crear una vez
+    registry.Clear();
+    Check(registry.LoadProgram(L"EvolvingVS", L"EvolvingPS", modelLayout, 3) == 0 && device.vertexShaders == 3 &&
+        device.pixelShaders == 3 && device.inputLayouts == 3, "Clear keeps stale objects");
+
+    // Con paquete los blobs salen de el y solo lo que no esta empaquetado se lee suelto
+    {
+        std::vector<ShaderPack::SourceBlob> packed = {
+            { "EvolvingVS", { 'p', 'a', 'c', 'k', 'e', 'd', ' ', 'V', 'S' } },
+            { "EvolvingPS", { 'p', 'a', 'c', 'k', 'e', 'd', ' ', 'P', 'S' } } };
+        Check(ShaderPack::WriteToFile(packed, directory / "Shaders.pack"), "test pack not written");
+
+        BasicShaderRegistry<CountingDevice> packRegistry(CountingDevice(), directory);
+        Check(packRegistry.LoadShaderPack(directory / "Shaders.pack"), "registry rejects a valid pack");
+        ShaderProgramHandle program = packRegistry.LoadProgram(L"EvolvingVS", L"EvolvingPS", modelLayout, 3);
+        Check(program != INVALID_SHADER_PROGRAM && packRegistry.GetProgram(program)->vertexShader.Get()->bytecode == "packed VS",
+            "vertex shader not served from the pack");
+        Check(packRegistry.GetPixelShader(L"EvolvingPS_NoClip") != nullptr, "loose fallback missing with a pack loaded");
+        const ShaderRegistryStats& packStats = packRegistry.GetStats();
+        Check(packStats.packLookups == 2 && packStats.blobReads == 1, "pack lookups and loose reads miscounted");
+        Check(!packRegistry.LoadShaderPack(directory / "Missing.pack") && packRegistry.GetDevice().errors == 1,
+            "missing pack not reported");
+    }
+
+    std::filesystem::remove_all(directory);
+    return FinishChecks();
+}
@@ -0,0 +1,223 @@
+// ShadowCachePolicy sobre 4 cascadas de 2048 texels con paso de ajuste de 128: casos dirigidos
+// (luz y camara quietas, giros por debajo y por encima del umbral, cambio de tesela, giro brusco
+// de camara, Invalidate) y un paseo con el ciclo de dia de Game que cuenta re-renderizaciones y
+// comprueba que cada trozo del frustum (con el margen de casters) queda dentro de su cascada
+// cacheada.
+//
+//   ShadowCacheTest          1 y 2 cascadas por frame
+//   ShadowCacheTest --quick  1 cascada por frame (lo que ejecuta ctest)
+
+#include "ShadowCache.h"
+#include "Check.h"
+#include "Measure.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+using namespace DirectX;
+
+namespace
+{
+    struct ShadowCacheValidationResult
+    {
+        size_t frames = 0;
+        size_t renders = 0;            // Cascadas re-renderizadas en la simulacion
+        size_t uncachedRenders = 0;    // Las que se renderizarian sin cache (todas, cada frame)
+        float maxLightErrorDegrees = 0.0f; // Mayor angulo entre la luz actual y la de una cascada cacheada
+        size_t coverageFailures = 0;   // Esquinas de un trozo del frustum fuera de su cascada cacheada (con el margen de casters)
+        size_t forcedRenders = 0;      // Re-renderizaciones fuera del reparto porque el trozo salio de su cascada
+        size_t ruleFailures = 0;       // Casos dirigidos de la politica que no dieron lo esperado
+    };
+
+    float Dot(const XMFLOAT3& a, const XMFLOAT3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+    XMFLOAT3 Normalize(const XMFLOAT3& v)
+    {
+        float length = std::sqrt(Dot(v, v));
+        return length > 0.0f ? XMFLOAT3(v.x / length, v.y / length, v.z / length) : v;
+    }
+
+    // Ejes de la vista de la luz con la que se ajusto la cascada (columnas de view)
+    XMFLOAT3 LightAxis(const ShadowCascade& cascade, int axis)
+    {
+        const XMFLOAT4X4& v = cascade.view;
+        if (axis == 0) return XMFLOAT3(v._11, v._21, v._31);
+        if (axis == 1) return XMFLOAT3(v._12, v._22, v._32);
+        return XMFLOAT3(v._13, v._23, v._33);
+    }
+
+    // Misma trayectoria del sol que Game::UpdateDayNightCycle
+    XMFLOAT3 SunDirection(float timeOfDay)
+    {
+        const float cycleAngle = timeOfDay * XM_2PI - XM_PIDIV2;
+        return Normalize(XMFLOAT3(std::sin(cycleAngle) * 0.4f, std::sin(cycleAngle), std::cos(cycleAngle)));
+    }
+
+    XMFLOAT3 RotateAroundY(const XMFLOAT3& v, float angle)
+    {
+        const float c = std::cos(angle), s = std::sin(angle);
+        return XMFLOAT3(c * v.x + s * v.z, v.y, -s * v.x + c * v.z);
+    }
+
+    // La esfera del trozo actual se sale de la caja cacheada (en z, sin el margen de casters): la
+    // politica tiene que re-renderizar esa cascada sin esperar al reparto
+    bool SliceLeftCachedBox(const ShadowCascade& cached, const ShadowCascade& current)
+    {
+        const float mins[3] = { cached.minX, cached.minY, cached.minZ };
+        const float maxs[3] = { cached.maxX, cached.maxY, cached.maxZ - cached.casterMargin };
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float projected = Dot(current.sphereCenter, LightAxis(cached, axis));
+            if (projected - current.sphereRadius < mins[axis] || projected + current.sphereRadius > maxs[axis]) return true;
+        }
+        return false;
+    }
+
+    ShadowCacheValidationResult Validate(size_t frames, int cascadesPerFrame)
+    {
+        ShadowCacheValidationResult result;
+
+        const float threshold = 0.25f * XM_PI / 180.0f;
+        ShadowCascades cascades;
+        cascades.SetCascadeCount(ShadowCascades::MAX_CASCADES);
+        cascades.SetResolution(2048);
+        cascades.SetSnapTexels(128);
+        const int count = cascades.GetCascadeCount();
+
+        ShadowCachePolicy policy;
+        policy.SetLightAngleThreshold(threshold);
+        policy.SetCascadesPerFrame(cascadesPerFrame);
+
+        ShadowCameraDesc camera;
+        camera.position = XMFLOAT3(12.3f, 40.0f, -7.1f);
+        camera.viewDirection = Normalize(XMFLOAT3(0.6f, -0.15f, -0.78f));
+        camera.fieldOfViewY = XM_PIDIV4;
+        camera.aspectRatio = 16.0f / 9.0f;
+        camera.nearPlane = 1.0f;
+        camera.farPlane = 5000.0f;
+        XMFLOAT3 light = Normalize(XMFLOAT3(0.4f, 0.8f, 0.3f));
+
+        // Los trozos que salen de su caja se cuentan contra lo cacheado antes de llamar a Update
+        // (despues del primer frame, cuando todas las cascadas tienen algo cacheado)
+        int rendered[ShadowCascades::MAX_CASCADES];
+        size_t forced = 0;
+        bool cached = false;
+        auto step = [&]()
+        {
+            cascades.Update(camera, light);
+            for (int i = 0; cached && i < count; ++i)
+            {
+                if (SliceLeftCachedBox(policy.GetCachedCascade(i), cascades.GetCascade(i))) forced++;
+            }
+            cached = true;
+            return policy.Update(cascades, rendered);
+        };
+        auto expect = [&](bool condition) { if (!condition) result.ruleFailures++; };
+
+        // 1. Primer frame: todas; despues, sin cambios, ninguna
+        expect(step() == count);
+        expect(step() == 0);
+
+        // 2. Giro por debajo del umbral: se sigue usando lo cacheado
+        light = Normalize(RotateAroundY(light, 0.5f * threshold / std::sqrt(1.0f - light.y * light.y)));
+        expect(step() == 0);
+
+        // 3. Por encima: se re-renderizan todas, repartidas en frames
+        light = Normalize(RotateAroundY(light, 1.5f * threshold / std::sqrt(1.0f - light.y * light.y)));
+        int total = 0;
+        const int slices = (count + cascadesPerFrame - 1) / cascadesPerFrame;
+        for (int frame = 0; frame < slices; ++frame)
+        {
+            int n = step();
+            expect(n <= cascadesPerFrame);
+            total += n;
+        }
+        expect(total == count);
+        expect(step() == 0);
+
+        // 4. La camara cruza una tesela de la cascada 0: es la primera en re-renderizarse
+        const ShadowCascade& nearest = policy.GetCachedCascade(0);
+        XMFLOAT3 axisX = LightAxis(nearest, 0);
+        float distance = 1.01f * nearest.snapSize;
+        camera.position = XMFLOAT3(camera.position.x + axisX.x * distance, camera.position.y + axisX.y * distance,
+            camera.position.z + axisX.z * distance);
+        int n = step();
+        expect(n >= 1 && rendered[0] == 0);
+
+        // 5. Giro brusco de la camara: ningun trozo sigue dentro de su cascada y no esperan al reparto
+        const XMFLOAT3 direction = camera.viewDirection;
+        camera.viewDirection = Normalize(XMFLOAT3(-direction.z, direction.y, direction.x));
+        forced = 0;
+        expect(step() == count && forced == static_cast<size_t>(count));
+
+        // 6. Invalidate: todas en el mismo frame
+        policy.Invalidate();
+        expect(step() == count);
+
+        // 7. Paseo a la velocidad normal de Game con el ciclo de dia: cuantas re-renderizaciones
+        //    hacen falta, cuanto se retrasa la luz y si algun trozo (o el margen de casters sobre el)
+        //    se sale de su cascada. El primer frame gira la camara respecto al anterior
+        const float dt = 1.0f / 60.0f;
+        float timeOfDay = 0.3f;
+        light = SunDirection(timeOfDay);
+        policy.Invalidate();
+        step();
+        forced = 0;
+        for (size_t frame = 0; frame < frames; ++frame)
+        {
+            timeOfDay += dt * 0.003f;
+            light = SunDirection(timeOfDay);
+            float yaw = 0.2f * frame * dt;
+            camera.viewDirection = Normalize(XMFLOAT3(std::cos(yaw), -0.15f, std::sin(yaw)));
+            camera.position = XMFLOAT3(camera.position.x + camera.viewDirection.x * 20.0f * dt, camera.position.y,
+                camera.position.z + camera.viewDirection.z * 20.0f * dt);
+
+            result.renders += step();
+            result.uncachedRenders += count;
+            result.frames++;
+
+            for (int i = 0; i < count; ++i)
+            {
+                const ShadowCascade& cached = policy.GetCachedCascade(i);
+                float cosError = std::min(std::max(Dot(cached.towardsLight, light), -1.0f), 1.0f);
+                result.maxLightErrorDegrees = std::max(result.maxLightErrorDegrees, std::acos(cosError) * 180.0f / XM_PI);
+
+                XMFLOAT3 corners[8];
+                ShadowCascades::GetSliceCorners(camera, cached.splitNear, cached.splitFar, corners);
+                const float epsilon = 1.0e-3f * cached.sphereRadius;
+                for (const XMFLOAT3& corner : corners)
+                {
+                    float x = Dot(corner, LightAxis(cached, 0));
+                    float y = Dot(corner, LightAxis(cached, 1));
+                    float z = Dot(corner, LightAxis(cached, 2));
+                    if (x < cached.minX - epsilon || x > cached.maxX + epsilon || y < cached.minY - epsilon ||
+                        y > cached.maxY + epsilon || z < cached.minZ - epsilon || z > cached.maxZ - cached.casterMargin + epsilon)
+                    {
+                        result.coverageFailures++;
+                    }
+                }
+            }
+        }
+        result.forcedRenders = forced;
+        return result;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick = false;
+    if (!ParseQuickOption(argc, argv, quick)) return 2;
+
+    for (int cascadesPerFrame : Sizes(quick, { 1, 2 }))
+    {
+        ShadowCacheValidationResult result = Validate(3600, cascadesPerFrame);
+        std::printf("Shadow cache, %d cascades/frame, %zu frames: %zu renders (uncached %zu), light lag %.2f deg, coverage failures %zu, rule failures %zu, forced %zu\n",
+            cascadesPerFrame, result.frames, result.renders, result.uncachedRenders, result.maxLightErrorDegrees, result.coverageFailures, result.ruleFailures,
+            result.forcedRenders);
+        Check(result.coverageFailures == 0, "frustum slice outside its cached cascade");
+        Check(result.ruleFailures == 0, "shadow cache policy rule failed");
+    }
+
+    return FinishChecks();
+}
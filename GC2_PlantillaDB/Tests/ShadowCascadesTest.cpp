@@ -0,0 +1,152 @@
+// ShadowCascades con el shadow map del juego (2048 texels por cascada): la camara se mueve en
+// pasos pequenos sin girar y un punto fijo tiene que caer siempre en la misma fraccion de texel
+// (las cascadas solo se desplazan texels enteros) con el radio de cada cascada sin cambiar;
+// despues gira y el radio sigue igual. En todos los frames las esquinas de cada trozo del frustum
+// tienen que quedar dentro de su cascada.
+//
+//   ShadowCascadesTest          3 y 4 cascadas
+//   ShadowCascadesTest --quick  3 cascadas (lo que ejecuta ctest)
+
+#include "ShadowCascades.h"
+#include "Check.h"
+#include "Measure.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+using namespace DirectX;
+
+namespace
+{
+    struct ShadowCascadeValidationResult
+    {
+        int cascadeCount = 0;
+        size_t frames = 0;
+        float maxTexelDrift = 0.0f;   // Deriva sub-texel de un punto fijo al trasladar la camara (0 = estable)
+        size_t radiusChanges = 0;     // Frames en que el radio de alguna cascada cambio
+        size_t coverageFailures = 0;  // Esquinas de un trozo del frustum fuera de su cascada
+    };
+
+    const int SHADOW_MAP_SIZE = 2048; // Game::SHADOW_MAP_SIZE
+
+    float Dot(const XMFLOAT3& a, const XMFLOAT3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+    XMFLOAT3 Normalize(const XMFLOAT3& v)
+    {
+        float length = std::sqrt(Dot(v, v));
+        return length > 0.0f ? XMFLOAT3(v.x / length, v.y / length, v.z / length) : v;
+    }
+
+    // Ejes x, y, z de la luz en mundo: las columnas de la vista de la cascada
+    XMFLOAT3 LightAxis(const ShadowCascade& c, int axis)
+    {
+        const float* m = &c.view._11;
+        return XMFLOAT3(m[axis], m[4 + axis], m[8 + axis]);
+    }
+
+    ShadowCascadeValidationResult Validate(int cascadeCount, int resolution, size_t frames)
+    {
+        ShadowCascadeValidationResult result;
+
+        ShadowCascades cascades;
+        cascades.SetCascadeCount(cascadeCount);
+        cascades.SetResolution(resolution);
+        result.cascadeCount = cascades.GetCascadeCount();
+
+        ShadowCameraDesc camera;
+        camera.position = XMFLOAT3(12.3f, 40.0f, -7.1f);
+        camera.viewDirection = Normalize(XMFLOAT3(0.6f, -0.15f, -0.78f));
+        camera.fieldOfViewY = XM_PIDIV4;
+        camera.aspectRatio = 16.0f / 9.0f;
+        camera.nearPlane = 1.0f;
+        camera.farPlane = 5000.0f;
+        const XMFLOAT3 towardsLight = Normalize(XMFLOAT3(0.4f, 0.8f, 0.3f));
+        const XMFLOAT3 fixedPoint(57.0f, 12.0f, 31.0f);
+
+        auto checkCoverage = [&]()
+        {
+            for (int i = 0; i < cascades.GetCascadeCount(); ++i)
+            {
+                const ShadowCascade& c = cascades.GetCascade(i);
+                const XMFLOAT3 lightX = LightAxis(c, 0);
+                const XMFLOAT3 lightY = LightAxis(c, 1);
+                const XMFLOAT3 lightZ = LightAxis(c, 2);
+                XMFLOAT3 corners[8];
+                ShadowCascades::GetSliceCorners(camera, c.splitNear, c.splitFar, corners);
+                const float epsilon = 1.0e-3f * c.sphereRadius;
+                for (const XMFLOAT3& corner : corners)
+                {
+                    float x = Dot(corner, lightX);
+                    float y = Dot(corner, lightY);
+                    float z = Dot(corner, lightZ);
+                    if (x < c.minX - epsilon || x > c.maxX + epsilon || y < c.minY - epsilon || y > c.maxY + epsilon ||
+                        z < c.minZ - epsilon || z > c.maxZ + epsilon)
+                    {
+                        result.coverageFailures++;
+                    }
+                }
+            }
+        };
+
+        // 1. Traslaciones sub-texel: el punto fijo debe caer siempre en la misma fraccion de texel
+        float firstFraction[ShadowCascades::MAX_CASCADES] = {};
+        float firstRadius[ShadowCascades::MAX_CASCADES] = {};
+        for (size_t frame = 0; frame < frames; ++frame)
+        {
+            cascades.Update(camera, towardsLight);
+            checkCoverage();
+            for (int i = 0; i < cascades.GetCascadeCount(); ++i)
+            {
+                const ShadowCascade& c = cascades.GetCascade(i);
+                double texel = (static_cast<double>(Dot(fixedPoint, LightAxis(c, 0))) - c.minX) / c.texelSize;
+                float fraction = static_cast<float>(texel - std::floor(texel));
+                if (frame == 0)
+                {
+                    firstFraction[i] = fraction;
+                    firstRadius[i] = c.sphereRadius;
+                    continue;
+                }
+                float drift = std::fabs(fraction - firstFraction[i]);
+                result.maxTexelDrift = std::max(result.maxTexelDrift, std::min(drift, 1.0f - drift));
+                if (c.sphereRadius != firstRadius[i]) result.radiusChanges++;
+            }
+            camera.position = XMFLOAT3(camera.position.x + 0.173f, camera.position.y + 0.011f, camera.position.z - 0.291f);
+            result.frames++;
+        }
+
+        // 2. Giros: el radio no cambia y el trozo sigue cubierto
+        for (size_t frame = 0; frame < frames; ++frame)
+        {
+            float yaw = 0.05f * frame;
+            camera.viewDirection = Normalize(XMFLOAT3(std::cos(yaw), -0.2f + 0.3f * std::sin(0.3f * yaw), std::sin(yaw)));
+            cascades.Update(camera, towardsLight);
+            checkCoverage();
+            for (int i = 0; i < cascades.GetCascadeCount(); ++i)
+            {
+                if (cascades.GetCascade(i).sphereRadius != firstRadius[i]) result.radiusChanges++;
+            }
+            result.frames++;
+        }
+        return result;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick = false;
+    if (!ParseQuickOption(argc, argv, quick)) return 2;
+
+    for (int cascadeCount : Sizes(quick, { 3, 4 }))
+    {
+        ShadowCascadeValidationResult result = Validate(cascadeCount, SHADOW_MAP_SIZE, 800);
+        std::printf("Shadow cascades x%d, %zu frames: max texel drift %.5f, radius changes %zu, coverage failures %zu\n",
+            result.cascadeCount, result.frames, result.maxTexelDrift, result.radiusChanges, result.coverageFailures);
+        // La deriva que queda es redondeo de float (del orden de 1e-3 texels)
+        Check(result.maxTexelDrift < 0.01f, "cascade origin drifts inside a texel");
+        Check(result.radiusChanges == 0, "cascade radius changed");
+        Check(result.coverageFailures == 0, "frustum slice outside its cascade");
+    }
+
+    return FinishChecks();
+}
@@ -0,0 +1,150 @@
+// ShadowCasterBatches::Draw, el mismo recorrido de lotes que usa Game::RenderShadowPass, con un
+// dispositivo que solo registra lo que se le pide. Mascaras aleatorias (opacos, con hojas, mixtos
+// y sin sombra) y cuatro cascadas: todo visible, una parte, solo las que tienen hojas y nada. En
+// cada una tiene que haber un cambio de estado por lote con alguna instancia visible y ninguno
+// mas, y un dibujo por (instancia visible, modo de sus partes), hecho con el estado de ese modo.
+
+#include "ShadowCasterBatches.h"
+#include "Check.h"
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+    struct RecordedCall
+    {
+        bool bind;               // BindShadowCasterState o DrawShadowCaster
+        uint32_t instance;
+        ShadowCasterMode mode;
+    };
+
+    struct RecordingDevice
+    {
+        const std::vector<uint8_t>* visibleInstances; // 1 si la AABB toca la cascada
+        std::vector<RecordedCall> calls;
+
+        bool IsShadowCasterVisible(uint32_t instance) const { return (*visibleInstances)[instance] != 0; }
+        void BindShadowCasterState(ShadowCasterMode mode) { calls.push_back({ true, 0, mode }); }
+        void DrawShadowCaster(uint32_t instance, ShadowCasterMode mode) { calls.push_back({ false, instance, mode }); }
+    };
+
+    struct ShadowCasterDrawResult
+    {
+        size_t visibleCasters = 0;
+        size_t stateBinds = 0;
+        size_t expectedBinds = 0;        // Lotes con alguna instancia visible
+        size_t draws = 0;
+        size_t expectedDraws = 0;        // Partes (instancia visible, modo) que proyectan sombra
+        size_t stateBindsPerInstance = 0; // Los del bucle por instancia (pixel shader y rasterizador cada vez)
+        size_t drawErrors = 0;           // Dibujos sin estado, con el de otro modo, repetidos o que faltan
+    };
+
+    ShadowCasterDrawResult DrawAndCheck(const ShadowCasterBatches& batches, const std::vector<uint8_t>& masks,
+        const std::vector<uint8_t>& visible)
+    {
+        ShadowCasterDrawResult result;
+        RecordingDevice device;
+        device.visibleInstances = &visible;
+        std::vector<uint32_t> scratch;
+        batches.Draw(device, scratch);
+
+        const uint8_t modes[2] = { ShadowCasterBit(ShadowCasterMode::Opaque), ShadowCasterBit(ShadowCasterMode::AlphaTested) };
+        for (uint8_t bit : modes)
+        {
+            bool anyVisible = false;
+            for (size_t i = 0; i < masks.size(); ++i)
+            {
+                if ((masks[i] & bit) == 0 || !visible[i]) continue;
+                anyVisible = true;
+                result.expectedDraws++;
+            }
+            if (anyVisible) result.expectedBinds++;
+        }
+        for (size_t i = 0; i < masks.size(); ++i)
+        {
+            if (masks[i] == 0 || !visible[i]) continue;
+            result.visibleCasters++;
+            result.stateBindsPerInstance += 2;
+        }
+
+        std::vector<uint8_t> drawnModes(masks.size(), 0);
+        bool bound = false;
+        ShadowCasterMode boundMode = ShadowCasterMode::None;
+        size_t drawsSinceBind = 0;
+        for (const RecordedCall& call : device.calls)
+        {
+            if (call.bind)
+            {
+                // Un estado que no va seguido de ningun dibujo sobra
+                if (bound && drawsSinceBind == 0) result.drawErrors++;
+                result.stateBinds++;
+                bound = true;
+                boundMode = call.mode;
+                drawsSinceBind = 0;
+                continue;
+            }
+
+            result.draws++;
+            drawsSinceBind++;
+            const uint8_t bit = ShadowCasterBit(call.mode);
+            if (!bound || call.mode != boundMode || call.instance >= masks.size() || (masks[call.instance] & bit) == 0 ||
+                !visible[call.instance] || (drawnModes[call.instance] & bit) != 0)
+            {
+                result.drawErrors++;
+                continue;
+            }
+            drawnModes[call.instance] |= bit;
+        }
+        if (bound && drawsSinceBind == 0) result.drawErrors++;
+        for (size_t i = 0; i < masks.size(); ++i)
+        {
+            if (drawnModes[i] != (visible[i] ? masks[i] : 0)) result.drawErrors++;
+        }
+        return result;
+    }
+}
+
+int main()
+{
+    // Mezcla de escena: la mitad opacos, un tercio con hojas, algunos mixtos y algunos sin sombra
+    const size_t instanceCount = 5000;
+    std::mt19937 rng(11);
+    std::vector<uint8_t> masks(instanceCount);
+    for (uint8_t& mask : masks)
+    {
+        uint32_t kind = rng() % 12;
+        if (kind < 6) mask = ShadowCasterBit(ShadowCasterMode::Opaque);
+        else if (kind < 10) mask = ShadowCasterBit(ShadowCasterMode::AlphaTested);
+        else if (kind < 11) mask = ShadowCasterBit(ShadowCasterMode::Opaque) | ShadowCasterBit(ShadowCasterMode::AlphaTested);
+        else mask = 0;
+    }
+
+    ShadowCasterBatches batches;
+    batches.Build(masks.data(), masks.size());
+    std::printf("Shadow caster batches, %zu instances: %zu opaque, %zu alpha-tested\n",
+        instanceCount, batches.opaque.size(), batches.alphaTested.size());
+
+    std::vector<uint8_t> allVisible(instanceCount, 1);
+    std::vector<uint8_t> someVisible(instanceCount);
+    for (uint8_t& visible : someVisible) visible = rng() % 3 == 0 ? 1 : 0;
+    std::vector<uint8_t> leavesVisible(instanceCount); // Solo instancias con hojas: el lote opaco queda vacio
+    for (size_t i = 0; i < instanceCount; ++i) leavesVisible[i] = masks[i] == ShadowCasterBit(ShadowCasterMode::AlphaTested) ? 1 : 0;
+    std::vector<uint8_t> noneVisible(instanceCount, 0);
+    const struct { const char* name; const std::vector<uint8_t>* visible; } cascades[] = {
+        { "all visible", &allVisible }, { "some visible", &someVisible }, { "leaves visible", &leavesVisible },
+        { "none visible", &noneVisible } };
+
+    for (const auto& cascade : cascades)
+    {
+        ShadowCasterDrawResult result = DrawAndCheck(batches, masks, *cascade.visible);
+        std::printf("  %s: %zu casters, state binds %zu (per instance %zu), draws %zu, draw errors %zu\n",
+            cascade.name, result.visibleCasters, result.stateBinds, result.stateBindsPerInstance, result.draws, result.drawErrors);
+        Check(result.stateBinds == result.expectedBinds, "not one state bind per non-empty batch");
+        Check(result.draws == result.expectedDraws, "not one draw per caster and mode");
+        Check(result.drawErrors == 0, "caster drawn with the wrong state, twice or not at all");
+    }
+
+    return FinishChecks();
+}
@@ -0,0 +1,342 @@
+// TerrainCapsuleSweep sobre un heightfield sintetico de 513 x 513 con las proporciones del terreno
+// del juego: el barrido exacto frente a una referencia que muestrea la distancia capsula-triangulo
+// en 256 pasos a lo largo del desplazamiento, con todas las celdas bajo la caja del barrido. El t
+// muestreado es el primer paso en contacto, asi que tiene que quedar a menos de un paso del exacto.
+// Ademas, el coste por consulta de barridos cortos, largos y de Move.
+//
+//   TerrainCapsuleSweepTest          20000 consultas
+//   TerrainCapsuleSweepTest --quick  2000 (lo que ejecuta ctest)
+
+#include "TerrainCapsuleSweep.h"
+#include "Check.h"
+#include "Measure.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    struct TerrainSweepBenchmarkResult
+    {
+        size_t queryCount = 0;
+        double sweepNsPerQuery = 0.0;     // Barridos cortos (un frame a velocidad de carrera)
+        double longSweepNsPerQuery = 0.0; // Barridos largos (decenas de celdas)
+        double moveNsPerQuery = 0.0;      // Move con deslizamiento
+        size_t hits = 0;
+        size_t mismatches = 0; // Frente a muestrear el barrido en pasos finos
+    };
+
+    struct Vec3
+    {
+        float x, y, z;
+    };
+
+    Vec3 operator+(const Vec3& a, const Vec3& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+    Vec3 operator-(const Vec3& a, const Vec3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+    Vec3 operator*(const Vec3& a, float s) { return { a.x * s, a.y * s, a.z * s }; }
+    float Dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    Vec3 Cross(const Vec3& a, const Vec3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+    float Clamp01(float v) { return std::min(std::max(v, 0.0f), 1.0f); }
+    Vec3 ToVec3(const XMFLOAT3& v) { return { v.x, v.y, v.z }; }
+
+    // Punto del triangulo abc mas cercano a p (Ericson, Real-Time Collision Detection 5.1.5)
+    Vec3 ClosestPointOnTriangle(const Vec3& p, const Vec3& a, const Vec3& b, const Vec3& c)
+    {
+        Vec3 ab = b - a;
+        Vec3 ac = c - a;
+        Vec3 ap = p - a;
+        float d1 = Dot(ab, ap);
+        float d2 = Dot(ac, ap);
+        if (d1 <= 0.0f && d2 <= 0.0f) return a;
+
+        Vec3 bp = p - b;
+        float d3 = Dot(ab, bp);
+        float d4 = Dot(ac, bp);
+        if (d3 >= 0.0f && d4 <= d3) return b;
+
+        float vc = d1 * d4 - d3 * d2;
+        if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) return a + ab * (d1 / (d1 - d3));
+
+        Vec3 cp = p - c;
+        float d5 = Dot(ab, cp);
+        float d6 = Dot(ac, cp);
+        if (d6 >= 0.0f && d5 <= d6) return c;
+
+        float vb = d5 * d2 - d1 * d6;
+        if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) return a + ac * (d2 / (d2 - d6));
+
+        float va = d3 * d6 - d5 * d4;
+        if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+        float denominator = 1.0f / (va + vb + vc);
+        return a + ab * (vb * denominator) + ac * (vc * denominator);
+    }
+
+    // Puntos mas cercanos entre los segmentos p1q1 y p2q2 (Ericson 5.1.9)
+    void ClosestPointsSegmentSegment(const Vec3& p1, const Vec3& q1, const Vec3& p2, const Vec3& q2, Vec3& outOn1, Vec3& outOn2)
+    {
+        const float epsilon = 1.0e-12f;
+        Vec3 d1 = q1 - p1;
+        Vec3 d2 = q2 - p2;
+        Vec3 r = p1 - p2;
+        float a = Dot(d1, d1);
+        float e = Dot(d2, d2);
+        float f = Dot(d2, r);
+        float s;
+        float t;
+
+        if (a <= epsilon && e <= epsilon)
+        {
+            s = t = 0.0f;
+        }
+        else if (a <= epsilon)
+        {
+            s = 0.0f;
+            t = Clamp01(f / e);
+        }
+        else
+        {
+            float c = Dot(d1, r);
+            if (e <= epsilon)
+            {
+                t = 0.0f;
+                s = Clamp01(-c / a);
+            }
+            else
+            {
+                float b = Dot(d1, d2);
+                float denominator = a * e - b * b;
+                s = denominator > epsilon ? Clamp01((b * f - c * e) / denominator) : 0.0f;
+                t = (b * s + f) / e;
+                if (t < 0.0f)
+                {
+                    t = 0.0f;
+                    s = Clamp01(-c / a);
+                }
+                else if (t > 1.0f)
+                {
+                    t = 1.0f;
+                    s = Clamp01((b - c) / a);
+                }
+            }
+        }
+        outOn1 = p1 + d1 * s;
+        outOn2 = p2 + d2 * t;
+    }
+
+    struct ClosestPair
+    {
+        float distanceSquared;
+        Vec3 onSegment;
+        Vec3 onTriangle;
+    };
+
+    // Distancia entre el segmento pq y el triangulo abc
+    ClosestPair SegmentTriangle(const Vec3& p, const Vec3& q, const Vec3& a, const Vec3& b, const Vec3& c)
+    {
+        // El segmento atraviesa el triangulo: distancia 0
+        Vec3 direction = q - p;
+        Vec3 edge1 = b - a;
+        Vec3 edge2 = c - a;
+        Vec3 pvec = Cross(direction, edge2);
+        float determinant = Dot(edge1, pvec);
+        if (std::fabs(determinant) > 1.0e-12f)
+        {
+            float invDeterminant = 1.0f / determinant;
+            Vec3 tvec = p - a;
+            float u = Dot(tvec, pvec) * invDeterminant;
+            Vec3 qvec = Cross(tvec, edge1);
+            float v = Dot(direction, qvec) * invDeterminant;
+            float t = Dot(edge2, qvec) * invDeterminant;
+            if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t >= 0.0f && t <= 1.0f)
+            {
+                Vec3 point = p + direction * t;
+                return { 0.0f, point, point };
+            }
+        }
+
+        // Si no, el minimo esta en un extremo del segmento o entre el segmento y una arista
+        ClosestPair best;
+        auto consider = [&best](const Vec3& onSegment, const Vec3& onTriangle)
+        {
+            Vec3 delta = onSegment - onTriangle;
+            float distanceSquared = Dot(delta, delta);
+            if (distanceSquared < best.distanceSquared) best = { distanceSquared, onSegment, onTriangle };
+        };
+        best.distanceSquared = 3.4e38f;
+        consider(p, ClosestPointOnTriangle(p, a, b, c));
+        consider(q, ClosestPointOnTriangle(q, a, b, c));
+
+        const Vec3 edges[3][2] = { { a, b }, { b, c }, { c, a } };
+        for (const auto& edge : edges)
+        {
+            Vec3 onSegment;
+            Vec3 onEdge;
+            ClosestPointsSegmentSegment(p, q, edge[0], edge[1], onSegment, onEdge);
+            consider(onSegment, onEdge);
+        }
+        return best;
+    }
+
+    Vec3 GridVertex(const TerrainCollisionGrid& grid, int i, int j)
+    {
+        return { grid.originX + i * grid.cellSizeX, grid.originY + grid.heights[static_cast<size_t>(j) * grid.width + i] * grid.heightScale,
+            grid.originZ + j * grid.cellSizeZ };
+    }
+
+    // Referencia lenta: en cada uno de los steps pasos del barrido, la distancia del segmento de la
+    // capsula a los triangulos de todas las celdas bajo la caja del barrido. Devuelve el primer t en
+    // contacto.
+    bool SweepSampled(const TerrainCollisionGrid& grid, const TerrainCapsule& capsule, const XMFLOAT3& displacement, int steps,
+        float& outT)
+    {
+        const float minX = std::min(capsule.base.x, capsule.base.x + displacement.x) - capsule.radius;
+        const float maxX = std::max(capsule.base.x, capsule.base.x + displacement.x) + capsule.radius;
+        const float minZ = std::min(capsule.base.z, capsule.base.z + displacement.z) - capsule.radius;
+        const float maxZ = std::max(capsule.base.z, capsule.base.z + displacement.z) + capsule.radius;
+        const int firstX = std::max(static_cast<int>(std::floor((minX - grid.originX) / grid.cellSizeX)), 0);
+        const int lastX = std::min(static_cast<int>(std::floor((maxX - grid.originX) / grid.cellSizeX)), grid.width - 2);
+        const int firstZ = std::max(static_cast<int>(std::floor((minZ - grid.originZ) / grid.cellSizeZ)), 0);
+        const int lastZ = std::min(static_cast<int>(std::floor((maxZ - grid.originZ) / grid.cellSizeZ)), grid.height - 2);
+
+        const Vec3 base = ToVec3(capsule.base);
+        const Vec3 move = ToVec3(displacement);
+        for (int step = 0; step <= steps; ++step)
+        {
+            float t = static_cast<float>(step) / steps;
+            Vec3 p = base + move * t;
+            Vec3 q = { p.x, p.y + capsule.height, p.z };
+            for (int cellZ = firstZ; cellZ <= lastZ; ++cellZ)
+            {
+                for (int cellX = firstX; cellX <= lastX; ++cellX)
+                {
+                    const Vec3 topLeft = GridVertex(grid, cellX, cellZ);
+                    const Vec3 topRight = GridVertex(grid, cellX + 1, cellZ);
+                    const Vec3 bottomLeft = GridVertex(grid, cellX, cellZ + 1);
+                    const Vec3 bottomRight = GridVertex(grid, cellX + 1, cellZ + 1);
+                    const Vec3 triangles[2][3] = { { topLeft, topRight, bottomLeft }, { bottomLeft, topRight, bottomRight } };
+                    for (const auto& triangle : triangles)
+                    {
+                        ClosestPair closest = SegmentTriangle(p, q, triangle[0], triangle[1], triangle[2]);
+                        if (std::sqrt(closest.distanceSquared) <= capsule.radius + TerrainCapsuleSweep::CONTACT_TOLERANCE)
+                        {
+                            outT = t;
+                            return true;
+                        }
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    double NanosecondsPerQuery(std::chrono::steady_clock::time_point start, size_t count)
+    {
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        return count > 0 ? ns / static_cast<double>(count) : 0.0;
+    }
+
+    TerrainSweepBenchmarkResult Benchmark(size_t queryCount)
+    {
+        TerrainSweepBenchmarkResult result;
+        result.queryCount = queryCount;
+
+        // Proporciones del terreno del juego: 5 unidades por celda y 300 de altura
+        const int size = 513;
+        std::vector<float> heights(static_cast<size_t>(size) * size);
+        for (int j = 0; j < size; ++j)
+        {
+            for (int i = 0; i < size; ++i)
+            {
+                heights[static_cast<size_t>(j) * size + i] = 0.4f + 0.25f * std::sin(i * 0.045f) * std::cos(j * 0.038f) +
+                    0.08f * std::sin(i * 0.17f + j * 0.11f) + 0.02f * std::cos(i * 0.9f - j * 0.7f);
+            }
+        }
+
+        TerrainCollisionGrid grid;
+        grid.heights = heights.data();
+        grid.width = size;
+        grid.height = size;
+        grid.originX = -0.5f * 5.0f * (size - 1);
+        grid.originY = -20.0f;
+        grid.originZ = -0.5f * 5.0f * (size - 1);
+        grid.cellSizeX = 5.0f;
+        grid.cellSizeZ = 5.0f;
+        grid.heightScale = 300.0f;
+
+        TerrainCapsuleSweep sweep;
+        sweep.SetGrid(grid);
+
+        // Capsulas de jugador apoyadas cerca del suelo, con semilla fija
+        std::mt19937 random(77);
+        std::uniform_real_distribution<float> cell(1.0f, static_cast<float>(size - 2));
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::vector<TerrainCapsule> capsules(queryCount);
+        std::vector<XMFLOAT3> shortMoves(queryCount), longMoves(queryCount);
+        for (size_t k = 0; k < queryCount; ++k)
+        {
+            int i = static_cast<int>(cell(random));
+            int j = static_cast<int>(cell(random));
+            float groundHeight = grid.originY + heights[static_cast<size_t>(j) * size + i] * grid.heightScale;
+            capsules[k].base = XMFLOAT3(grid.originX + i * grid.cellSizeX + unit(random), groundHeight + 3.0f + 2.0f * (unit(random) + 1.0f),
+                grid.originZ + j * grid.cellSizeZ + unit(random));
+            capsules[k].height = 12.0f;
+            capsules[k].radius = 2.0f;
+
+            float angle = 3.14159265f * unit(random);
+            shortMoves[k] = XMFLOAT3(std::cos(angle) * 0.75f, -1.0f, std::sin(angle) * 0.75f);
+            longMoves[k] = XMFLOAT3(std::cos(angle) * 50.0f, -10.0f + 10.0f * unit(random), std::sin(angle) * 50.0f);
+        }
+
+        TerrainSweepHit hit;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t k = 0; k < queryCount; ++k) result.hits += sweep.Sweep(capsules[k], shortMoves[k], hit) ? 1 : 0;
+        result.sweepNsPerQuery = NanosecondsPerQuery(start, queryCount);
+
+        start = std::chrono::steady_clock::now();
+        for (size_t k = 0; k < queryCount; ++k) sweep.Sweep(capsules[k], longMoves[k], hit);
+        result.longSweepNsPerQuery = NanosecondsPerQuery(start, queryCount);
+
+        start = std::chrono::steady_clock::now();
+        for (size_t k = 0; k < queryCount; ++k)
+        {
+            XMFLOAT3 walk(shortMoves[k].x, 0.0f, shortMoves[k].z);
+            sweep.Move(capsules[k], walk, 0.64f); // Hasta ~50 grados de pendiente
+        }
+        result.moveNsPerQuery = NanosecondsPerQuery(start, queryCount);
+
+        // Referencia muestreada (lenta): el t muestreado es el primer paso en contacto, asi que
+        // debe quedar a menos de un paso del t exacto
+        const int steps = 256;
+        const size_t checked = std::min<size_t>(queryCount, 500);
+        for (size_t k = 0; k < checked; ++k)
+        {
+            TerrainSweepHit exact;
+            float sampled = 0.0f;
+            bool exactHit = sweep.Sweep(capsules[k], longMoves[k], exact);
+            bool sampledHit = SweepSampled(grid, capsules[k], longMoves[k], steps, sampled);
+            if (exactHit != sampledHit) result.mismatches++;
+            else if (exactHit && std::fabs(sampled - exact.t) > 1.0f / steps) result.mismatches++;
+        }
+        return result;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick = false;
+    if (!ParseQuickOption(argc, argv, quick)) return 2;
+
+    TerrainSweepBenchmarkResult result = Benchmark(quick ? 2000 : 20000);
+    std::printf("Terrain capsule sweep x%zu: short %.0f ns, long %.0f ns, move %.0f ns per query, %zu hits, %zu mismatches\n",
+        result.queryCount, result.sweepNsPerQuery, result.longSweepNsPerQuery, result.moveNsPerQuery, result.hits, result.mismatches);
+    Check(result.hits > 0, "no short sweep touches the terrain");
+    Check(result.mismatches == 0, "sweep differs from the sampled reference");
+
+    return FinishChecks();
+}
@@ -0,0 +1,317 @@
+// TerrainChunkGrid: que los trozos cubren cada celda una vez con AABBs ajustadas (tambien los
+// trozos menores del borde), las AABB en mundo tras una matriz con giro, los planos del frustum
+// contra la prueba en clip space y la fusion de rangos contra los trozos visibles uno a uno.
+
+#include "TerrainChunks.h"
+#include "ThreadPool.h"
+#include "Check.h"
+#include "TestMatrices.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    std::vector<float> MakeHeights(int width, int height, uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> noise(0.0f, 1.0f);
+        std::vector<float> heights(static_cast<size_t>(width) * height);
+        for (int j = 0; j < height; ++j)
+        {
+            for (int i = 0; i < width; ++i)
+            {
+                heights[static_cast<size_t>(j) * width + i] = 0.5f + 0.3f * std::sin(i * 0.11f) * std::cos(j * 0.07f) + 0.2f * noise(rng);
+            }
+        }
+        return heights;
+    }
+
+    // Dentro del frustum segun el clip space de D3D: -w <= x, y <= w y 0 <= z <= w.
+    // margin: distancia minima a cualquier borde (en unidades de clip) para contar el punto.
+    bool InsideClip(const XMFLOAT4& clip, float margin)
+    {
+        return clip.w > 0.0f &&
+            clip.x >= -clip.w + margin && clip.x <= clip.w - margin &&
+            clip.y >= -clip.w + margin && clip.y <= clip.w - margin &&
+            clip.z >= margin && clip.z <= clip.w - margin;
+    }
+
+    bool InsidePlanes(const XMFLOAT4 planes[6], const XMFLOAT3& p)
+    {
+        for (int i = 0; i < 6; ++i)
+        {
+            if (planes[i].x * p.x + planes[i].y * p.y + planes[i].z * p.z + planes[i].w < 0.0f) return false;
+        }
+        return true;
+    }
+
+    void CheckGrid(const std::vector<float>& heights, int width, int height, float heightScale, int chunkCells)
+    {
+        TerrainChunkGrid grid;
+        Check(grid.Build(heights.data(), width, height, heightScale, chunkCells), "build fails");
+
+        const int cellsX = width - 1;
+        const int cellsZ = height - 1;
+        Check(grid.GetChunksX() == (cellsX + chunkCells - 1) / chunkCells &&
+            grid.GetChunksZ() == (cellsZ + chunkCells - 1) / chunkCells, "wrong chunk count");
+        Check(grid.GetIndices().size() == static_cast<size_t>(cellsX) * cellsZ * 6, "index count is not 6 per cell");
+
+        // Cada celda sale una vez, dentro del rectangulo de su trozo y con la triangulacion de la malla
+        std::vector<int> cellUses(static_cast<size_t>(cellsX) * cellsZ, 0);
+        const std::vector<uint32_t>& indices = grid.GetIndices();
+        uint32_t expectedStart = 0;
+        bool contiguous = true, inside = true, triangulation = true, tight = true;
+        for (const TerrainChunk& chunk : grid.GetChunks())
+        {
+            contiguous = contiguous && chunk.indexStart == expectedStart && chunk.indexCount % 6 == 0;
+            expectedStart = chunk.indexStart + chunk.indexCount;
+
+            for (uint32_t k = chunk.indexStart; k < chunk.indexStart + chunk.indexCount; k += 6)
+            {
+                const uint32_t topLeft = indices[k];
+                const int i = static_cast<int>(topLeft % width);
+                const int j = static_cast<int>(topLeft / width);
+                const uint32_t bottomLeft = topLeft + static_cast<uint32_t>(width);
+                triangulation = triangulation && i < cellsX && j < cellsZ &&
+                    indices[k + 1] == topLeft + 1 && indices[k + 2] == bottomLeft &&
+                    indices[k + 3] == bottomLeft && indices[k + 4] == topLeft + 1 && indices[k + 5] == bottomLeft + 1;
+                if (i >= cellsX || j >= cellsZ) continue;
+                inside = inside && i >= chunk.cellX && i < chunk.cellX + chunk.cellCountX &&
+                    j >= chunk.cellZ && j < chunk.cellZ + chunk.cellCountZ;
+                cellUses[static_cast<size_t>(j) * cellsX + i]++;
+            }
+
+            // AABB local: los extremos exactos de los vertices del trozo, borde compartido incluido
+            float minY = heights[static_cast<size_t>(chunk.cellZ) * width + chunk.cellX] * heightScale;
+            float maxY = minY;
+            for (int j = chunk.cellZ; j <= chunk.cellZ + chunk.cellCountZ; ++j)
+            {
+                for (int i = chunk.cellX; i <= chunk.cellX + chunk.cellCountX; ++i)
+                {
+                    float y = heights[static_cast<size_t>(j) * width + i] * heightScale;
+                    minY = std::min(minY, y);
+                    maxY = std::max(maxY, y);
+                }
+            }
+            tight = tight && chunk.localMin.x == static_cast<float>(chunk.cellX) && chunk.localMin.z == static_cast<float>(chunk.cellZ) &&
+                chunk.localMax.x == static_cast<float>(chunk.cellX + chunk.cellCountX) &&
+                chunk.localMax.z == static_cast<float>(chunk.cellZ + chunk.cellCountZ) &&
+                chunk.localMin.y == minY && chunk.localMax.y == maxY;
+        }
+        Check(contiguous && expectedStart == indices.size(), "chunks are not contiguous in the index buffer");
+        Check(triangulation, "chunk triangles differ from the full mesh triangulation");
+        Check(inside, "chunk emits a cell outside its rectangle");
+        Check(std::all_of(cellUses.begin(), cellUses.end(), [](int uses) { return uses == 1; }), "cell not covered exactly once");
+        Check(tight, "local AABB is not the exact extent of the chunk vertices");
+
+        // El ultimo trozo de cada fila y columna recoge el resto de celdas
+        const TerrainChunk& last = grid.GetChunks().back();
+        Check(last.cellX + last.cellCountX == cellsX && last.cellZ + last.cellCountZ == cellsZ, "last chunk does not reach the map border");
+
+        // Con hilos, el mismo resultado
+        ThreadPool pool(4);
+        TerrainChunkGrid threaded;
+        threaded.Build(heights.data(), width, height, heightScale, chunkCells, &pool);
+        bool same = threaded.GetIndices() == grid.GetIndices() && threaded.GetChunks().size() == grid.GetChunks().size();
+        for (size_t c = 0; same && c < grid.GetChunks().size(); ++c)
+        {
+            const TerrainChunk& a = grid.GetChunks()[c];
+            const TerrainChunk& b = threaded.GetChunks()[c];
+            same = a.indexStart == b.indexStart && a.indexCount == b.indexCount &&
+                a.localMin.y == b.localMin.y && a.localMax.y == b.localMax.y;
+        }
+        Check(same, "threaded build differs from the serial one");
+    }
+
+    void CheckWorldBounds(const std::vector<float>& heights, int width, int height)
+    {
+        TerrainChunkGrid grid;
+        grid.Build(heights.data(), width, height, 40.0f, 16);
+
+        // Escala no uniforme, giro en Y de 30 grados (con un poco de X) y traslacion
+        const float yaw = 0.5235988f, pitch = 0.2f;
+        XMFLOAT4X4 scale = TestMatrices::Identity();
+        scale._11 = 2.0f; scale._22 = 0.5f; scale._33 = -1.5f;
+        XMFLOAT4X4 rotationY = TestMatrices::Identity();
+        rotationY._11 = std::cos(yaw); rotationY._13 = -std::sin(yaw);
+        rotationY._31 = std::sin(yaw); rotationY._33 = std::cos(yaw);
+        XMFLOAT4X4 rotationX = TestMatrices::Identity();
+        rotationX._22 = std::cos(pitch); rotationX._23 = std::sin(pitch);
+        rotationX._32 = -std::sin(pitch); rotationX._33 = std::cos(pitch);
+        XMFLOAT4X4 world = TestMatrices::Multiply(TestMatrices::Multiply(scale, rotationY), rotationX);
+        world._41 = -300.0f; world._42 = 12.0f; world._43 = 75.0f;
+        grid.UpdateWorldBounds(world);
+
+        // Debe ser la caja de las 8 esquinas transformadas
+        float worstError = 0.0f;
+        for (const TerrainChunk& chunk : grid.GetChunks())
+        {
+            XMFLOAT3 expectedMin(1e30f, 1e30f, 1e30f), expectedMax(-1e30f, -1e30f, -1e30f);
+            for (int corner = 0; corner < 8; ++corner)
+            {
+                XMFLOAT3 p((corner & 1) ? chunk.localMax.x : chunk.localMin.x, (corner & 2) ? chunk.localMax.y : chunk.localMin.y,
+                    (corner & 4) ? chunk.localMax.z : chunk.localMin.z);
+                XMFLOAT4 w = TestMatrices::TransformPoint(p, world);
+                expectedMin = XMFLOAT3(std::min(expectedMin.x, w.x), std::min(expectedMin.y, w.y), std::min(expectedMin.z, w.z));
+                expectedMax = XMFLOAT3(std::max(expectedMax.x, w.x), std::max(expectedMax.y, w.y), std::max(expectedMax.z, w.z));
+            }
+            worstError = std::max({ worstError,
+                std::fabs(chunk.worldMin.x - expectedMin.x), std::fabs(chunk.worldMin.y - expectedMin.y), std::fabs(chunk.worldMin.z - expectedMin.z),
+                std::fabs(chunk.worldMax.x - expectedMax.x), std::fabs(chunk.worldMax.y - expectedMax.y), std::fabs(chunk.worldMax.z - expectedMax.z) });
+        }
+        Check(worstError < 1e-3f, "world AABB is not the box of the transformed corners");
+    }
+
+    void CheckFrustumPlanes()
+    {
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> coordinate(-400.0f, 400.0f);
+        const XMFLOAT3 up(0.0f, 1.0f, 0.0f);
+
+        std::vector<XMFLOAT4X4> viewProjections;
+        for (int camera = 0; camera < 16; ++camera)
+        {
+            XMFLOAT3 eye(coordinate(rng) * 0.5f, 20.0f + std::fabs(coordinate(rng)) * 0.1f, coordinate(rng) * 0.5f);
+            XMFLOAT3 target(coordinate(rng), coordinate(rng) * 0.05f, coordinate(rng));
+            XMFLOAT4X4 view = TestMatrices::LookAt(eye, target, up);
+            XMFLOAT4X4 projection = (camera % 4 == 3) ? TestMatrices::Orthographic(300.0f, 200.0f, 1.0f, 600.0f)
+                : TestMatrices::Perspective(0.6f + camera * 0.05f, 16.0f / 9.0f, 0.5f, 300.0f + camera * 20.0f);
+            viewProjections.push_back(TestMatrices::Multiply(view, projection));
+        }
+
+        size_t insidePoints = 0, planeMismatches = 0, boxFalseNegatives = 0, boxesCulled = 0;
+        for (const XMFLOAT4X4& viewProjection : viewProjections)
+        {
+            XMFLOAT4 planes[6];
+            TerrainChunkGrid::ExtractFrustumPlanes(viewProjection, planes);
+
+            // Un punto lejos de los bordes (mas de 1e-3 de w) se clasifica igual que en clip space
+            for (int sample = 0; sample < 4000; ++sample)
+            {
+                XMFLOAT3 p(coordinate(rng), coordinate(rng) * 0.25f, coordinate(rng));
+                XMFLOAT4 clip = TestMatrices::TransformPoint(p, viewProjection);
+                const float margin = 1e-3f * std::fabs(clip.w) + 1e-4f;
+                const bool clearlyInside = InsideClip(clip, margin);
+                const bool clearlyOutside = clip.w <= 0.0f || !InsideClip(clip, -margin);
+                if (clearlyInside) insidePoints++;
+                if ((clearlyInside && !InsidePlanes(planes, p)) || (clearlyOutside && InsidePlanes(planes, p))) planeMismatches++;
+            }
+
+            // Una caja con algun punto dentro del frustum nunca se descarta
+            for (int box = 0; box < 500; ++box)
+            {
+                XMFLOAT3 boxMin(coordinate(rng), coordinate(rng) * 0.25f, coordinate(rng));
+                XMFLOAT3 boxMax(boxMin.x + 5.0f + std::fabs(coordinate(rng)) * 0.1f, boxMin.y + 30.0f, boxMin.z + 5.0f + std::fabs(coordinate(rng)) * 0.1f);
+                bool anyInside = false;
+                for (int k = 0; k < 64 && !anyInside; ++k)
+                {
+                    XMFLOAT3 p(boxMin.x + (boxMax.x - boxMin.x) * (k & 3) / 3.0f, boxMin.y + (boxMax.y - boxMin.y) * ((k >> 2) & 3) / 3.0f,
+                        boxMin.z + (boxMax.z - boxMin.z) * (k >> 4) / 3.0f);
+                    anyInside = InsideClip(TestMatrices::TransformPoint(p, viewProjection), 0.0f);
+                }
+                const bool intersects = TerrainChunkGrid::AabbIntersectsFrustum(planes, boxMin, boxMax);
+                if (anyInside && !intersects) boxFalseNegatives++;
+                if (!intersects) boxesCulled++;
+            }
+        }
+        std::printf("Frustum planes: %zu points clearly inside, %zu mismatches; %zu boxes culled, %zu false negatives\n",
+            insidePoints, planeMismatches, boxesCulled, boxFalseNegatives);
+        Check(insidePoints > 0 && boxesCulled > 0, "frustum samples do not cover both sides");
+        Check(planeMismatches == 0, "frustum planes disagree with the clip space test");
+        Check(boxFalseNegatives == 0, "AABB with a point inside the frustum is culled");
+    }
+
+    void CheckRanges(const std::vector<float>& heights, int width, int height)
+    {
+        TerrainChunkGrid grid;
+        grid.Build(heights.data(), width, height, 40.0f, 16);
+        const XMFLOAT3 up(0.0f, 1.0f, 0.0f);
+        const float centerX = (width - 1) * 0.5f, centerZ = (height - 1) * 0.5f;
+
+        std::mt19937 rng(11);
+        std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+        std::vector<TerrainDrawRange> ranges;
+        size_t merged = 0, mismatches = 0, notMerged = 0;
+        for (int camera = 0; camera < 200; ++camera)
+        {
+            const float a = angle(rng);
+            XMFLOAT3 eye(centerX + std::cos(a) * width * 0.3f, 60.0f, centerZ + std::sin(a) * height * 0.3f);
+            XMFLOAT3 target(eye.x + std::cos(angle(rng)) * 100.0f, 20.0f, eye.z + std::sin(angle(rng)) * 100.0f);
+            XMFLOAT4X4 viewProjection = TestMatrices::Multiply(TestMatrices::LookAt(eye, target, up),
+                TestMatrices::Perspective(0.8f, 16.0f / 9.0f, 0.5f, 80.0f + camera * 2.0f));
+
+            const size_t visible = grid.CullAndBuildRanges(viewProjection, ranges);
+
+            // Referencia: un flag por indice con los trozos visibles uno a uno
+            XMFLOAT4 planes[6];
+            TerrainChunkGrid::ExtractFrustumPlanes(viewProjection, planes);
+            std::vector<char> expected(grid.GetIndices().size(), 0), drawn(grid.GetIndices().size(), 0);
+            size_t expectedVisible = 0;
+            for (const TerrainChunk& chunk : grid.GetChunks())
+            {
+                if (!TerrainChunkGrid::AabbIntersectsFrustum(planes, chunk.worldMin, chunk.worldMax)) continue;
+                expectedVisible++;
+                std::fill(expected.begin() + chunk.indexStart, expected.begin() + chunk.indexStart + chunk.indexCount, 1);
+            }
+
+            // Rangos ordenados, sin solaparse ni tocarse (dos rangos seguidos se habrian unido)
+            bool ordered = true;
+            for (size_t r = 0; r < ranges.size(); ++r)
+            {
+                if (r > 0) ordered = ordered && ranges[r].indexStart > ranges[r - 1].indexStart + ranges[r - 1].indexCount;
+                for (uint32_t k = ranges[r].indexStart; k < ranges[r].indexStart + ranges[r].indexCount && k < drawn.size(); ++k) drawn[k]++;
+            }
+            if (visible != expectedVisible || drawn != expected) mismatches++;
+            if (!ordered) notMerged++;
+            merged += visible - ranges.size();
+        }
+        std::printf("Chunk ranges: 200 cameras, %zu draw calls saved by merging\n", merged);
+        Check(mismatches == 0, "merged ranges differ from the visible chunks");
+        Check(notMerged == 0, "ranges are unsorted, overlap or could have been merged");
+        Check(merged > 0, "no camera merged two chunks");
+
+        // Todo visible: un solo rango con todo el index buffer. Nada visible: ninguno
+        XMFLOAT3 above(centerX, 500.0f, centerZ);
+        XMFLOAT4X4 allView = TestMatrices::Multiply(TestMatrices::LookAt(above, XMFLOAT3(centerX, 0.0f, centerZ), XMFLOAT3(0.0f, 0.0f, -1.0f)),
+            TestMatrices::Orthographic(width * 2.0f, height * 2.0f, 1.0f, 1000.0f));
+        size_t visible = grid.CullAndBuildRanges(allView, ranges);
+        Check(visible == grid.GetChunks().size() && ranges.size() == 1 && ranges[0].indexStart == 0 &&
+            ranges[0].indexCount == grid.GetIndices().size(), "fully visible grid is not a single range");
+
+        XMFLOAT4X4 skyView = TestMatrices::Multiply(TestMatrices::LookAt(above, XMFLOAT3(centerX, 1000.0f, centerZ), XMFLOAT3(0.0f, 0.0f, -1.0f)),
+            TestMatrices::Perspective(0.8f, 1.0f, 0.5f, 400.0f));
+        visible = grid.CullAndBuildRanges(skyView, ranges);
+        Check(visible == 0 && ranges.empty(), "camera looking at the sky draws chunks");
+    }
+}
+
+int main()
+{
+    // Mapas que no son multiplo del trozo (trozos menores en el borde), uno exacto y uno de una celda
+    const struct { int width, height, chunkCells; float heightScale; } grids[] = {
+        { 65, 49, 16, 40.0f },
+        { 129, 129, 32, 100.0f },
+        { 100, 37, 7, -25.0f },
+        { 2, 2, 16, 10.0f } };
+    for (const auto& g : grids)
+    {
+        CheckGrid(MakeHeights(g.width, g.height, static_cast<uint32_t>(g.width * 31 + g.height)), g.width, g.height, g.heightScale, g.chunkCells);
+    }
+
+    TerrainChunkGrid invalid;
+    const float oneHeight = 0.0f;
+    Check(!invalid.Build(nullptr, 65, 65, 1.0f, 16) && !invalid.Build(&oneHeight, 1, 1, 1.0f, 16) &&
+        !invalid.Build(&oneHeight, 2, 2, 1.0f, 0), "build accepts invalid input");
+
+    const std::vector<float> heights = MakeHeights(257, 193, 3);
+    CheckWorldBounds(heights, 257, 193);
+    CheckFrustumPlanes();
+    CheckRanges(heights, 257, 193);
+    return FinishChecks();
+}
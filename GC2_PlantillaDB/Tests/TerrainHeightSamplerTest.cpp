@@ -0,0 +1,165 @@
+// TerrainHeightSampler sobre un heightfield sintetico de 1025 x 1025 colocado como el terreno de la
+// escena: SampleHeights (SIMD, 4 puntos a la vez) da los mismos bits que SampleHeight punto a punto,
+// alturas y normales, y los mismos puntos dentro y fuera; las alturas coinciden con las del
+// GetWorldHeightAt anterior. Despues, el coste de los tres caminos con 1000, 100000 y 1000000 puntos.
+//
+//   TerrainHeightSamplerTest          los tres tamanos
+//   TerrainHeightSamplerTest --quick  1000 puntos (lo que ejecuta ctest)
+
+#include "TerrainHeightSampler.h"
+#include "Check.h"
+#include "Measure.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    // Milisegundos para todas las consultas
+    struct TerrainHeightBenchmarkResult
+    {
+        size_t queryCount = 0;
+        double legacyMs = 0.0;        // Como el GetWorldHeightAt anterior: inversa 2x2 en cada llamada
+        double scalarMs = 0.0;        // SampleHeight punto a punto con la inversa precalculada
+        double batchMs = 0.0;         // SampleHeights (SIMD, 4 puntos a la vez)
+        double batchNormalsMs = 0.0;  // SampleHeights con normales
+        size_t mismatches = 0;        // Alturas o normales del lote distintas (bit a bit) de las de SampleHeight
+        size_t validMismatches = 0;   // Puntos dentro para uno y fuera para el otro
+        float maxLegacyError = 0.0f;  // Frente a la altura del metodo anterior
+    };
+
+    // El GetWorldHeightAt anterior, como referencia de las medidas
+    bool LegacyHeightAt(const float* heights, int width, int height, float heightScale, const XMFLOAT4X4& world,
+        float worldX, float worldZ, float& outHeight)
+    {
+        float tx = worldX - world._41;
+        float tz = worldZ - world._43;
+        float determinant = world._11 * world._33 - world._31 * world._13;
+        if (std::fabs(determinant) < 0.0001f) return false;
+
+        float invDeterminant = 1.0f / determinant;
+        float gridI = (tx * world._33 - tz * world._31) * invDeterminant;
+        float gridJ = (world._11 * tz - world._13 * tx) * invDeterminant;
+        if (gridI < 0 || gridI >= width - 1 || gridJ < 0 || gridJ >= height - 1) return false;
+
+        int x0 = static_cast<int>(std::floor(gridI));
+        int z0 = static_cast<int>(std::floor(gridJ));
+        int x1 = std::min(x0 + 1, width - 1);
+        int z1 = std::min(z0 + 1, height - 1);
+        float fracI = gridI - x0;
+        float fracJ = gridJ - z0;
+
+        float bottom = heights[z0 * width + x0] + fracI * (heights[z0 * width + x1] - heights[z0 * width + x0]);
+        float top = heights[z1 * width + x0] + fracI * (heights[z1 * width + x1] - heights[z1 * width + x0]);
+        float localY = (bottom + fracJ * (top - bottom)) * heightScale;
+        outHeight = gridI * world._12 + localY * world._22 + gridJ * world._32 + world._42;
+        return true;
+    }
+
+    TerrainHeightBenchmarkResult Benchmark(size_t queryCount)
+    {
+        TerrainHeightBenchmarkResult result;
+        result.queryCount = queryCount;
+
+        // Mismo tamano de celda y colocacion que el terreno de la escena
+        const int size = 1025;
+        std::vector<float> heights(static_cast<size_t>(size) * size);
+        for (int j = 0; j < size; ++j)
+        {
+            for (int i = 0; i < size; ++i)
+            {
+                heights[static_cast<size_t>(j) * size + i] = 0.5f + 0.25f * std::sin(i * 0.021f) * std::cos(j * 0.013f);
+            }
+        }
+
+        const float cellSize = 5.0f;
+        const float halfExtent = (size - 1) * cellSize * 0.5f;
+        XMFLOAT4X4 world = {};
+        world._11 = cellSize;
+        world._22 = 1.0f;
+        world._33 = cellSize;
+        world._41 = -halfExtent;
+        world._42 = -20.0f;
+        world._43 = -halfExtent;
+        world._44 = 1.0f;
+
+        TerrainHeightSampler sampler;
+        sampler.SetHeights(heights.data(), size, size, 300.0f);
+        sampler.SetTransform(world);
+
+        std::mt19937 random(1234);
+        std::uniform_real_distribution<float> coordinate(-halfExtent * 1.05f, halfExtent * 1.05f);
+        std::vector<XMFLOAT2> positions(queryCount);
+        for (XMFLOAT2& position : positions) position = XMFLOAT2(coordinate(random), coordinate(random));
+
+        std::vector<float> legacyHeights(queryCount, 0.0f), scalarHeights(queryCount, 0.0f), batchHeights(queryCount, 0.0f);
+        std::vector<uint8_t> legacyValid(queryCount), scalarValid(queryCount), valid(queryCount);
+        std::vector<XMFLOAT3> normals(queryCount);
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < queryCount; ++i)
+        {
+            legacyValid[i] = LegacyHeightAt(heights.data(), size, size, 300.0f, world, positions[i].x, positions[i].y, legacyHeights[i]) ? 1 : 0;
+        }
+        result.legacyMs = MillisecondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < queryCount; ++i)
+        {
+            scalarValid[i] = sampler.SampleHeight(positions[i].x, positions[i].y, scalarHeights[i]) ? 1 : 0;
+        }
+        result.scalarMs = MillisecondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        sampler.SampleHeights(positions.data(), queryCount, batchHeights.data(), valid.data());
+        result.batchMs = MillisecondsSince(start);
+
+        for (size_t i = 0; i < queryCount; ++i)
+        {
+            if (valid[i] != scalarValid[i] || legacyValid[i] != scalarValid[i]) result.validMismatches++;
+            if (!valid[i] || !scalarValid[i]) continue;
+            if (std::memcmp(&scalarHeights[i], &batchHeights[i], sizeof(float)) != 0) result.mismatches++;
+            if (legacyValid[i]) result.maxLegacyError = std::max(result.maxLegacyError, std::fabs(legacyHeights[i] - scalarHeights[i]));
+        }
+
+        start = std::chrono::steady_clock::now();
+        sampler.SampleHeights(positions.data(), queryCount, batchHeights.data(), valid.data(), normals.data());
+        result.batchNormalsMs = MillisecondsSince(start);
+
+        for (size_t i = 0; i < queryCount; ++i)
+        {
+            if (!valid[i]) continue;
+            float height;
+            XMFLOAT3 normal;
+            sampler.SampleHeight(positions[i].x, positions[i].y, height, &normal);
+            if (std::memcmp(&height, &batchHeights[i], sizeof(float)) != 0 || std::memcmp(&normal, &normals[i], sizeof(XMFLOAT3)) != 0)
+                result.mismatches++;
+        }
+        return result;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick = false;
+    if (!ParseQuickOption(argc, argv, quick)) return 2;
+
+    // Consultas de altura: inversa por llamada (anterior) frente a inversa precalculada y lote SIMD
+    for (size_t queryCount : Sizes(quick, { size_t(1000), size_t(100000), size_t(1000000) }))
+    {
+        TerrainHeightBenchmarkResult result = Benchmark(queryCount);
+        std::printf("Terrain height benchmark %zu queries: legacy %.2f ms, scalar %.2f ms, batch %.2f ms, batch+normals %.2f ms, mismatches %zu, legacy error %.2e\n",
+            result.queryCount, result.legacyMs, result.scalarMs, result.batchMs, result.batchNormalsMs, result.mismatches, result.maxLegacyError);
+        Check(result.mismatches == 0, "batch heights or normals differ from SampleHeight");
+        Check(result.validMismatches == 0, "batch, scalar and legacy disagree on which points are inside");
+        Check(result.maxLegacyError < 1e-3f, "heights differ from the legacy GetWorldHeightAt");
+    }
+
+    return FinishChecks();
+}
@@ -0,0 +1,162 @@
+// TerrainHorizonBaker sobre un heightfield sintetico de 257 x 257 con las proporciones del terreno
+// del juego (5 unidades por celda, 300 de altura): para soles aleatorios, la visibilidad que lee
+// TerrainPS de los mapas de horizonte frente a un rayo marchado hacia el sol en pasos finos. Con
+// pocos azimuts el horneado interpola entre direcciones lejanas y discrepa en algun sol fuera de la
+// penumbra: se acepta hasta un 2% con 8 azimuts y un 0.5% desde 16.
+//
+//   TerrainHorizonBakerTest          8, 16 y 32 azimuts
+//   TerrainHorizonBakerTest --quick  8 azimuts (lo que ejecuta ctest)
+
+#include "TerrainHorizonBaker.h"
+#include "ThreadPool.h"
+#include "Check.h"
+#include "Measure.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    struct TerrainHorizonValidationResult
+    {
+        int size = 0;
+        int azimuthCount = 0;
+        double bakeMs = 0.0;
+        size_t samples = 0;    // Pares (punto, sol) comparados
+        size_t mismatches = 0; // Luz/sombra distinta de la referencia fuera de la zona de transicion
+        size_t penumbra = 0;   // Soles a menos de la tolerancia del horizonte horneado (no se cuentan)
+    };
+
+    // Altura bilineal (normalizada) en coordenadas de rejilla; false fuera del heightfield
+    bool SampleGrid(const TerrainHorizonGrid& grid, float gridX, float gridZ, float& outHeight)
+    {
+        if (gridX < 0.0f || gridZ < 0.0f || gridX > static_cast<float>(grid.width - 1) || gridZ > static_cast<float>(grid.height - 1))
+        {
+            return false;
+        }
+        int x0 = std::min(static_cast<int>(gridX), grid.width - 2);
+        int z0 = std::min(static_cast<int>(gridZ), grid.height - 2);
+        float fx = gridX - static_cast<float>(x0);
+        float fz = gridZ - static_cast<float>(z0);
+        const float* row0 = grid.heights + static_cast<size_t>(z0) * grid.width + x0;
+        const float* row1 = row0 + grid.width;
+        float top = row0[0] + (row0[1] - row0[0]) * fx;
+        float bottom = row1[0] + (row1[1] - row1[0]) * fx;
+        outHeight = top + (bottom - top) * fz;
+        return true;
+    }
+
+    // Referencia: avanza por el rayo hacia el sol en pasos finos y comprueba si el terreno lo corta.
+    bool IsLitReference(const TerrainHorizonGrid& grid, int i, int j, const XMFLOAT3& towardsSun, float maxDistance)
+    {
+        const float horizontal = std::sqrt(towardsSun.x * towardsSun.x + towardsSun.z * towardsSun.z);
+        if (towardsSun.y <= 0.0f) return false;
+        if (horizontal <= 0.0f) return true;
+
+        const size_t count = static_cast<size_t>(grid.width) * grid.height;
+        const float maxHeight = *std::max_element(grid.heights, grid.heights + count) * grid.heightScale;
+        const float originHeight = grid.heights[static_cast<size_t>(j) * grid.width + i] * grid.heightScale;
+        const float rise = towardsSun.y / horizontal; // Subida del rayo por unidad horizontal
+        const float stepX = towardsSun.x / horizontal / grid.cellSizeX;
+        const float stepZ = towardsSun.z / horizontal / grid.cellSizeZ;
+        const float step = 0.05f * std::min(grid.cellSizeX, grid.cellSizeZ);
+
+        for (float distance = step; distance <= maxDistance; distance += step)
+        {
+            float rayHeight = originHeight + rise * distance;
+            if (rayHeight > maxHeight) return true;
+
+            float sampleHeight;
+            if (!SampleGrid(grid, i + stepX * distance, j + stepZ * distance, sampleHeight)) return true;
+            if (sampleHeight * grid.heightScale > rayHeight) return false;
+        }
+        return true;
+    }
+
+    TerrainHorizonValidationResult Validate(int size, int azimuthCount, size_t samples, ThreadPool* pool)
+    {
+        TerrainHorizonValidationResult result;
+        result.size = size;
+        result.azimuthCount = azimuthCount;
+
+        // Colinas y crestas con las proporciones del terreno del juego (5 unidades por celda, 300 de altura)
+        std::vector<float> heights(static_cast<size_t>(size) * size);
+        for (int j = 0; j < size; ++j)
+        {
+            for (int i = 0; i < size; ++i)
+            {
+                heights[static_cast<size_t>(j) * size + i] = 0.4f + 0.25f * std::sin(i * 0.045f) * std::cos(j * 0.038f) +
+                    0.08f * std::sin(i * 0.17f + j * 0.11f) + 0.03f * std::cos(i * 0.41f - j * 0.29f);
+            }
+        }
+
+        TerrainHorizonGrid grid;
+        grid.heights = heights.data();
+        grid.width = size;
+        grid.height = size;
+        grid.cellSizeX = 5.0f;
+        grid.cellSizeZ = 5.0f;
+        grid.heightScale = 300.0f;
+        const float maxDistance = 5.0f * size * 1.5f;
+
+        std::vector<uint8_t> horizons(static_cast<size_t>(size) * size * azimuthCount);
+        auto start = std::chrono::steady_clock::now();
+        TerrainHorizonBaker::Bake(grid, azimuthCount, maxDistance, horizons.data(), pool);
+        result.bakeMs = MillisecondsSince(start);
+
+        // Tolerancia: un paso de 8 bits mas el error de interpolar entre azimuts (unos 3 grados)
+        const float tolerance = 3.0f / 90.0f;
+
+        std::mt19937 random(2024);
+        std::uniform_int_distribution<int> coordinate(0, size - 1);
+        std::uniform_real_distribution<float> angle(0.0f, XM_2PI);
+        std::uniform_real_distribution<float> elevationAngle(0.01f, 1.0f); // Hasta ~57 grados
+        for (size_t sample = 0; sample < samples; ++sample)
+        {
+            int i = coordinate(random);
+            int j = coordinate(random);
+            float azimuth = angle(random);
+            float elevation = elevationAngle(random);
+            XMFLOAT3 towardsSun(std::cos(azimuth) * std::cos(elevation), std::sin(elevation), std::sin(azimuth) * std::cos(elevation));
+
+            float baked = TerrainHorizonBaker::SunVisibility(horizons.data(), size, size, azimuthCount, i, j, towardsSun, 0.0f);
+            bool reference = IsLitReference(grid, i, j, towardsSun, maxDistance);
+            result.samples++;
+
+            // Soles casi rasantes con el horizonte horneado: cualquier respuesta es aceptable
+            float softBaked = TerrainHorizonBaker::SunVisibility(horizons.data(), size, size, azimuthCount, i, j, towardsSun, tolerance);
+            if (softBaked > 0.0f && softBaked < 1.0f)
+            {
+                result.penumbra++;
+                continue;
+            }
+            if ((baked > 0.5f) != reference) result.mismatches++;
+        }
+        return result;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick = false;
+    if (!ParseQuickOption(argc, argv, quick)) return 2;
+
+    ThreadPool threadPool;
+    ThreadPool* pool = &threadPool;
+
+    for (int azimuthCount : Sizes(quick, { 8, 16, 32 }))
+    {
+        TerrainHorizonValidationResult result = Validate(257, azimuthCount, 20000, pool);
+        std::printf("Terrain horizon map %dx%d, %d azimuths: bake %.1f ms, %zu suns, mismatches %zu, penumbra %zu\n",
+            result.size, result.size, result.azimuthCount, result.bakeMs, result.samples, result.mismatches, result.penumbra);
+        double tolerance = azimuthCount < 16 ? 0.02 : 0.005;
+        Check(result.samples > 0 && double(result.mismatches) <= tolerance * double(result.samples), "horizon map disagrees with the ray march");
+    }
+
+    return FinishChecks();
+}
@@ -0,0 +1,404 @@
+// TerrainLodTree: con un frustum que lo abarca todo, la seleccion cubre cada celda una sola vez,
+// dos celdas vecinas no se separan mas de un nivel y en cada costura entre niveles el morph
+// (con la misma distancia que TerrainVSCommon.hlsli) deja los vertices del lado fino sobre la
+// rejilla del grueso sin mover los de este. El rango calculado por error en pantalla cumple el
+// limite de pixeles en cada nivel y el margen de las costuras. Al final, el tiempo de Select y los
+// triangulos frente a TerrainChunkGrid segun la distancia de vision (como Terrain::LogLodReport).
+
+#include "TerrainLod.h"
+#include "TerrainChunks.h"
+#include "Check.h"
+#include "TestMatrices.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    struct LodSetup
+    {
+        int width;
+        int height;
+        float heightScale;
+        int leafCells;
+        float level0Range;
+        float morphStartRatio;
+        float cellSize; // Escala X/Z de la matriz del terreno
+    };
+
+    std::vector<float> MakeHeights(int width, int height, uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> noise(0.0f, 1.0f);
+        std::vector<float> heights(static_cast<size_t>(width) * height);
+        for (int j = 0; j < height; ++j)
+        {
+            for (int i = 0; i < width; ++i)
+            {
+                heights[static_cast<size_t>(j) * width + i] =
+                    0.45f + 0.35f * std::sin(i * 0.045f) * std::cos(j * 0.031f) + 0.1f * std::sin(i * 0.3f + j * 0.2f) + 0.1f * noise(rng);
+            }
+        }
+        return heights;
+    }
+
+    // Sin ruido ni detalle fino (como un heightfield de 16 bits de colinas suaves): los niveles gruesos
+    // apenas se equivocan y el rango por error en pantalla queda en el minimo de las costuras
+    std::vector<float> MakeSmoothHeights(int width, int height)
+    {
+        std::vector<float> heights(static_cast<size_t>(width) * height);
+        const float frequency = 256.0f / static_cast<float>(std::max(width, height));
+        for (int j = 0; j < height; ++j)
+        {
+            for (int i = 0; i < width; ++i)
+            {
+                heights[static_cast<size_t>(j) * width + i] = 0.45f + 0.35f * std::sin(i * 0.045f * frequency) * std::cos(j * 0.031f * frequency) +
+                    0.05f * std::sin(i * 0.011f + j * 0.017f);
+            }
+        }
+        return heights;
+    }
+
+    // Como Game::CreateDeviceDependentResources: centrado en el origen y escalado en X/Z
+    XMFLOAT4X4 TerrainWorld(const LodSetup& setup)
+    {
+        XMFLOAT4X4 world = TestMatrices::Identity();
+        world._11 = setup.cellSize;
+        world._33 = setup.cellSize;
+        world._41 = -(setup.width - 1) * 0.5f * setup.cellSize;
+        world._42 = -20.0f;
+        world._43 = -(setup.height - 1) * 0.5f * setup.cellSize;
+        return world;
+    }
+
+    struct SelectionReport
+    {
+        size_t cameras = 0;
+        size_t coverageErrors = 0;   // Celdas sin dibujar o dibujadas dos veces
+        size_t levelJumps = 0;       // Celdas vecinas con mas de un nivel de diferencia
+        size_t seams = 0;            // Aristas entre celdas de distinto nivel
+        size_t seamVertices = 0;     // Vertices impares del lado fino que tienen que ir a la rejilla gruesa
+        size_t unmorphedSeams = 0;   // ...con factor de morph menor que 1
+        size_t coarseMoved = 0;      // Vertices del lado grueso que se mueven (el fino ya no coincide)
+        int maxLevelSeen = 0;
+    };
+
+    void CheckCamera(const TerrainLodTree& tree, const LodSetup& setup, const std::vector<float>& heights, const XMFLOAT4X4& world,
+        const XMFLOAT3& camera, const XMFLOAT4X4& allVisible, std::vector<TerrainLodSelection>& selection, SelectionReport& report)
+    {
+        tree.Select(camera, allVisible, selection);
+        report.cameras++;
+
+        // Nivel de cada celda segun los quads seleccionados (-1: sin dibujar, -2: dibujada dos veces)
+        const int cellsX = setup.width - 1;
+        const int cellsZ = setup.height - 1;
+        std::vector<int> cellLevel(static_cast<size_t>(cellsX) * cellsZ, -1);
+        const std::vector<uint32_t>& indices = tree.GetIndices();
+        for (const TerrainLodSelection& s : selection)
+        {
+            const TerrainLodNode& node = tree.GetNodes()[s.node];
+            report.maxLevelSeen = std::max(report.maxLevelSeen, s.level);
+            for (int quadrant = 0; quadrant < 4; ++quadrant)
+            {
+                if (!(s.quadrantMask & (1 << quadrant))) continue;
+                for (uint32_t k = node.quadrantStart[quadrant]; k < node.quadrantStart[quadrant] + node.quadrantCount[quadrant]; k += 6)
+                {
+                    const int x0 = static_cast<int>(indices[k] % setup.width), z0 = static_cast<int>(indices[k] / setup.width);
+                    const int x1 = static_cast<int>(indices[k + 5] % setup.width), z1 = static_cast<int>(indices[k + 5] / setup.width);
+                    for (int j = z0; j < z1; ++j)
+                    {
+                        for (int i = x0; i < x1; ++i)
+                        {
+                            int& level = cellLevel[static_cast<size_t>(j) * cellsX + i];
+                            level = level == -1 ? s.level : -2;
+                        }
+                    }
+                }
+            }
+        }
+        for (int level : cellLevel)
+        {
+            if (level < 0) report.coverageErrors++;
+        }
+
+        auto vertexDistance = [&](float i, float j)
+        {
+            const int ii = static_cast<int>(i), jj = static_cast<int>(j);
+            XMFLOAT3 local(i, heights[static_cast<size_t>(jj) * setup.width + ii] * setup.heightScale, j);
+            XMFLOAT4 w = TestMatrices::TransformPoint(local, world);
+            const float dx = w.x - camera.x, dy = w.y - camera.y, dz = w.z - camera.z;
+            return std::sqrt(dx * dx + dy * dy + dz * dz);
+        };
+        auto morph = [&](float i, float j, int level)
+        {
+            float morphStart, morphInvRange;
+            tree.GetMorphParameters(level, morphStart, morphInvRange);
+            const float factor = TerrainLodTree::ComputeMorphFactor(vertexDistance(i, j), morphStart, morphInvRange);
+            return std::make_pair(factor, TerrainLodTree::MorphGridPosition(XMFLOAT2(i, j), static_cast<float>(1 << level), factor,
+                XMFLOAT2(static_cast<float>(cellsX), static_cast<float>(cellsZ))));
+        };
+
+        // Costuras: la arista compartida entre una celda y su vecina de +x o de +z
+        for (int j = 0; j < cellsZ; ++j)
+        {
+            for (int i = 0; i < cellsX; ++i)
+            {
+                const int level = cellLevel[static_cast<size_t>(j) * cellsX + i];
+                for (int direction = 0; direction < 2; ++direction)
+                {
+                    const int ni = i + (direction == 0 ? 1 : 0), nj = j + (direction == 1 ? 1 : 0);
+                    if (ni >= cellsX || nj >= cellsZ || level < 0) continue;
+                    const int neighbourLevel = cellLevel[static_cast<size_t>(nj) * cellsX + ni];
+                    if (neighbourLevel < 0 || neighbourLevel == level) continue;
+                    if (std::abs(neighbourLevel - level) > 1)
+                    {
+                        report.levelJumps++;
+                        continue;
+                    }
+                    report.seams++;
+
+                    const int fine = std::min(level, neighbourLevel);
+                    const int fineStep = 1 << fine;
+                    // Los dos extremos de la arista compartida
+                    for (int end = 0; end < 2; ++end)
+                    {
+                        const int vi = direction == 0 ? ni : i + end;
+                        const int vj = direction == 0 ? j + end : nj;
+                        const int along = direction == 0 ? vj : vi;
+                        const int alongMax = direction == 0 ? cellsZ : cellsX;
+                        if (along % fineStep != 0) continue; // Dentro de un quad del nivel fino: no es vertice
+                        const bool odd = along % (2 * fineStep) != 0 && along < alongMax;
+
+                        auto fineSide = morph(static_cast<float>(vi), static_cast<float>(vj), fine);
+                        if (odd)
+                        {
+                            report.seamVertices++;
+                            if (fineSide.first < 1.0f) report.unmorphedSeams++;
+                        }
+
+                        // Donde acaba el vertice fino tiene que haber un vertice grueso que no se mueve
+                        const XMFLOAT2 landed = fineSide.second;
+                        auto coarseSide = morph(landed.x, landed.y, fine + 1);
+                        if (coarseSide.second.x != landed.x || coarseSide.second.y != landed.y) report.coarseMoved++;
+                    }
+                }
+            }
+        }
+    }
+
+    // El lado grueso de una costura solo queda quieto si su morph empieza mas lejos que el rango
+    // del nivel fino mas la diagonal de un nodo fino (altura incluida): un vertice de la costura
+    // esta en el borde de un nodo que toca ese rango. Margen = morph grueso - (rango + diagonal).
+    float WorstSeamMargin(const TerrainLodTree& tree)
+    {
+        float worstMargin = FLT_MAX;
+        for (int level = 0; level + 2 < tree.GetLevelCount(); ++level)
+        {
+            float coarseStart, coarseInvRange;
+            tree.GetMorphParameters(level + 1, coarseStart, coarseInvRange);
+            for (const TerrainLodNode& node : tree.GetNodes())
+            {
+                if (node.level != level) continue;
+                const float dx = node.worldMax.x - node.worldMin.x, dy = node.worldMax.y - node.worldMin.y, dz = node.worldMax.z - node.worldMin.z;
+                worstMargin = std::min(worstMargin, coarseStart - tree.GetLevelRange(level) - std::sqrt(dx * dx + dy * dy + dz * dz));
+            }
+        }
+        return worstMargin;
+    }
+
+    void CheckSetup(const LodSetup& setup, uint32_t seed, int cameraCount)
+    {
+        const std::vector<float> heights = MakeHeights(setup.width, setup.height, seed);
+        TerrainLodTree tree;
+        Check(tree.Build(heights.data(), setup.width, setup.height, setup.heightScale, setup.leafCells), "LOD build fails");
+        tree.SetLodRanges(setup.level0Range, setup.morphStartRatio);
+        const XMFLOAT4X4 world = TerrainWorld(setup);
+        tree.UpdateWorldBounds(world);
+
+        // Cada nivel dobla el rango del anterior; el ultimo no tiene limite ni morph
+        bool ranges = true;
+        for (int level = 0; level + 1 < tree.GetLevelCount(); ++level)
+        {
+            ranges = ranges && tree.GetLevelRange(level) == setup.level0Range * static_cast<float>(1 << level);
+        }
+        float lastStart, lastInvRange;
+        tree.GetMorphParameters(tree.GetLevelCount() - 1, lastStart, lastInvRange);
+        Check(ranges && lastInvRange == 0.0f, "LOD ranges do not double per level");
+
+        const float worstMargin = WorstSeamMargin(tree);
+        std::printf("LOD %dx%d: worst seam margin before the coarse morph %.1f\n", setup.width, setup.height, worstMargin);
+        Check(worstMargin >= 0.0f, "LOD ranges are too short for the node size and heights");
+
+        // Ortografica desde muy arriba: todo el mapa dentro del frustum, solo decide la distancia
+        const float extentX = (setup.width - 1) * setup.cellSize, extentZ = (setup.height - 1) * setup.cellSize;
+        const XMFLOAT4X4 allVisible = TestMatrices::Multiply(
+            TestMatrices::LookAt(XMFLOAT3(0.0f, 5000.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, -1.0f)),
+            TestMatrices::Orthographic(extentX * 1.5f, extentZ * 1.5f, 1.0f, 10000.0f));
+
+        std::mt19937 rng(seed + 1);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        SelectionReport report;
+        std::vector<TerrainLodSelection> selection;
+        for (int camera = 0; camera < cameraCount; ++camera)
+        {
+            // Sobre el terreno a la altura del jugador, a veces en lo alto o fuera del mapa
+            const float u = unit(rng) * 1.2f - 0.1f, v = unit(rng) * 1.2f - 0.1f;
+            const int gi = std::clamp(static_cast<int>(u * (setup.width - 1)), 0, setup.width - 1);
+            const int gj = std::clamp(static_cast<int>(v * (setup.height - 1)), 0, setup.height - 1);
+            const float ground = heights[static_cast<size_t>(gj) * setup.width + gi] * setup.heightScale + world._42;
+            const float above = camera % 5 == 0 ? 200.0f + unit(rng) * 1500.0f : 2.0f + unit(rng) * 20.0f;
+            const XMFLOAT3 eye((u - 0.5f) * extentX, ground + above, (v - 0.5f) * extentZ);
+            CheckCamera(tree, setup, heights, world, eye, allVisible, selection, report);
+        }
+
+        std::printf("LOD %dx%d, leaf %d, range %.0f: %zu cameras, levels up to %d of %d, %zu seams, %zu odd seam vertices\n",
+            setup.width, setup.height, setup.leafCells, setup.level0Range, report.cameras, report.maxLevelSeen, tree.GetLevelCount() - 1,
+            report.seams, report.seamVertices);
+        if (report.coverageErrors || report.levelJumps || report.unmorphedSeams || report.coarseMoved)
+        {
+            std::printf("    coverage errors %zu, level jumps %zu, unmorphed seam vertices %zu, coarse vertices moved %zu\n",
+                report.coverageErrors, report.levelJumps, report.unmorphedSeams, report.coarseMoved);
+        }
+        Check(report.maxLevelSeen > 1 && report.seamVertices > 0, "cameras do not produce seams between levels");
+        Check(report.coverageErrors == 0, "selected quads do not cover every cell exactly once");
+        Check(report.levelJumps == 0, "neighbouring cells differ by more than one level");
+        Check(report.unmorphedSeams == 0, "odd seam vertex on the fine side has a morph factor below 1");
+        Check(report.coarseMoved == 0, "seam vertex lands on a coarse vertex that is morphing");
+    }
+
+    // Error por nivel: un plano no pierde nada al quitar vertices; un pico en un vertice impar es
+    // todo error del nivel 1, escalado por la Y de la matriz de mundo
+    void CheckLevelErrors()
+    {
+        const int width = 65, height = 65;
+        std::vector<float> heights(static_cast<size_t>(width) * height);
+        for (int j = 0; j < height; ++j)
+        {
+            for (int i = 0; i < width; ++i) heights[static_cast<size_t>(j) * width + i] = 0.25f + 0.004f * i - 0.002f * j;
+        }
+        TerrainLodTree tree;
+        tree.Build(heights.data(), width, height, 100.0f, 8);
+        float planeError = 0.0f;
+        for (int level = 0; level < tree.GetLevelCount(); ++level) planeError = std::max(planeError, tree.GetLevelError(level));
+        Check(planeError < 1e-3f, "LOD level error of a plane is not zero");
+
+        std::fill(heights.begin(), heights.end(), 0.5f);
+        heights[static_cast<size_t>(21) * width + 33] = 0.75f;
+        tree.Build(heights.data(), width, height, 100.0f, 8);
+        XMFLOAT4X4 world = TestMatrices::Identity();
+        world._22 = 2.0f;
+        tree.UpdateWorldBounds(world);
+        std::printf("LOD spike of 25 (world Y x2): level errors %.2f %.2f %.2f\n", tree.GetLevelError(1), tree.GetLevelError(2), tree.GetLevelError(3));
+        Check(tree.GetLevelError(0) == 0.0f && std::fabs(tree.GetLevelError(1) - 50.0f) < 1e-3f, "LOD level error misses a spike on an odd vertex");
+    }
+
+    // Con el rango calculado, el error de cada nivel visto desde donde empieza a aparecer (el morph del
+    // nivel anterior) no pasa del limite, y las costuras conservan su margen aunque el limite sea holgado.
+    // Devuelve el rango calculado.
+    float CheckScreenErrorRange(const LodSetup& setup, const std::vector<float>& heights, const char* name)
+    {
+        const float maxPixelError = 2.0f, viewportHeight = 1080.0f;
+        const float pixelsPerUnit = viewportHeight / (2.0f * std::tan(0.5f * XM_PIDIV4));
+        TerrainLodTree tree;
+        tree.Build(heights.data(), setup.width, setup.height, setup.heightScale, setup.leafCells);
+        tree.UpdateWorldBounds(TerrainWorld(setup));
+
+        const float level0Range = tree.ComputeLevel0Range(maxPixelError, viewportHeight, XM_PIDIV4, setup.morphStartRatio);
+        tree.SetLodRanges(level0Range, setup.morphStartRatio);
+        float worstPixels = 0.0f;
+        for (int level = 1; level < tree.GetLevelCount(); ++level)
+        {
+            float morphStart, morphInvRange;
+            tree.GetMorphParameters(level - 1, morphStart, morphInvRange);
+            worstPixels = std::max(worstPixels, tree.GetLevelError(level) * pixelsPerUnit / morphStart);
+        }
+        const float margin = WorstSeamMargin(tree);
+
+        const float seamRange = tree.ComputeLevel0Range(FLT_MAX, viewportHeight, XM_PIDIV4, setup.morphStartRatio);
+        tree.SetLodRanges(seamRange, setup.morphStartRatio);
+        const float seamMargin = WorstSeamMargin(tree);
+        std::printf("LOD %s %dx%d: level 0 range %.0f for %.0f px (worst %.2f px, seam margin %.1f), seam minimum %.0f (margin %.1f)\n",
+            name, setup.width, setup.height, level0Range, maxPixelError, worstPixels, margin, seamRange, seamMargin);
+        Check(worstPixels <= maxPixelError * 1.001f, "LOD range lets a level exceed the screen error");
+        Check(margin >= 0.0f && seamMargin >= 0.0f, "LOD range from the screen error breaks the seam margin");
+        return level0Range;
+    }
+
+    // Tiempo de Select y triangulos frente a la rejilla de trozos, camara en el centro mirando en horizontal
+    void Benchmark(const LodSetup& setup, const std::vector<float>& heights, const char* name, int iterations)
+    {
+        TerrainLodTree tree;
+        tree.Build(heights.data(), setup.width, setup.height, setup.heightScale, setup.leafCells);
+        tree.SetLodRanges(setup.level0Range, setup.morphStartRatio);
+        TerrainChunkGrid grid;
+        grid.Build(heights.data(), setup.width, setup.height, setup.heightScale, setup.leafCells);
+        const XMFLOAT4X4 world = TerrainWorld(setup);
+        tree.UpdateWorldBounds(world);
+        grid.UpdateWorldBounds(world);
+
+        const float ground = heights[static_cast<size_t>(setup.height / 2) * setup.width + setup.width / 2] * setup.heightScale + world._42;
+        const XMFLOAT3 eye(0.0f, ground + 50.0f, 0.0f);
+        const XMFLOAT4X4 view = TestMatrices::LookAt(eye, XMFLOAT3(eye.x + 1.0f, eye.y, eye.z), XMFLOAT3(0.0f, 1.0f, 0.0f));
+
+        std::vector<TerrainLodSelection> selection;
+        std::vector<TerrainDrawRange> ranges;
+        std::printf("LOD benchmark %s %dx%d, range %.0f: view distance | LOD triangles | chunk triangles | select (us)\n",
+            name, setup.width, setup.height, setup.level0Range);
+        const float viewDistances[] = { 250.0f, 500.0f, 1000.0f, 2000.0f, 5000.0f };
+        for (float viewDistance : viewDistances)
+        {
+            const XMFLOAT4X4 viewProjection = TestMatrices::Multiply(view, TestMatrices::Perspective(XM_PIDIV4, 16.0f / 9.0f, 0.1f, viewDistance));
+
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; ++i) tree.Select(eye, viewProjection, selection);
+            const double selectUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / iterations;
+
+            const size_t lodTriangles = TerrainLodTree::CountSelectedIndices(selection, tree.GetNodes()) / 3;
+            grid.CullAndBuildRanges(viewProjection, ranges);
+            size_t chunkTriangles = 0;
+            for (const TerrainDrawRange& range : ranges) chunkTriangles += range.indexCount / 3;
+            std::printf("  %6.0f | %7zu | %7zu | %.2f\n", viewDistance, lodTriangles, chunkTriangles, selectUs);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const bool quick = argc > 1 && std::string(argv[1]) == "--quick";
+
+    // El tamano del juego (CHUNK_CELLS, escala 5 en X/Z) con el rango en el minimo de las costuras
+    // (el error en pantalla lo llevaria mas alla del mapa con estas alturas: ver CheckScreenErrorRange)
+    // y un mapa que no es potencia de dos, con nodos hoja mas pequenos y rangos cortos para ver mas
+    // niveles (alturas bajas: con rango 40 y nodos de 16 celdas, mas de ~15 de desnivel por nodo ya
+    // no deja margen y el lado grueso empieza a moverse en la costura)
+    const LodSetup game = { 257, 257, 300.0f, 32, 512.0f, 0.7f, 5.0f };
+    const LodSetup small = { 201, 150, 25.0f, 16, 40.0f, 0.7f, 1.0f };
+    CheckSetup(game, 1, quick ? 60 : 300);
+    CheckSetup(small, 2, quick ? 60 : 300);
+
+    // Rango por error en pantalla (Terrain::LOD_MAX_PIXEL_ERROR a 1080 lineas y 45 grados): con ruido
+    // hay que llegar casi al detalle completo; con colinas suaves basta el minimo de las costuras
+    LodSetup noisy = game;
+    LodSetup smooth = { 1025, 1025, 300.0f, 32, 0.0f, 0.7f, 5.0f };
+    const std::vector<float> noisyHeights = MakeHeights(noisy.width, noisy.height, 5);
+    const std::vector<float> smoothHeights = MakeSmoothHeights(smooth.width, smooth.height);
+    CheckLevelErrors();
+    noisy.level0Range = CheckScreenErrorRange(noisy, noisyHeights, "noisy");
+    smooth.level0Range = CheckScreenErrorRange(smooth, smoothHeights, "smooth");
+
+    TerrainLodTree invalid;
+    const float oneHeight = 0.0f;
+    Check(!invalid.Build(&oneHeight, 2, 2, 1.0f, 3) && !invalid.Build(nullptr, 65, 65, 1.0f, 16), "LOD build accepts invalid input");
+
+    Benchmark(noisy, noisyHeights, "noisy", quick ? 200 : 2000);
+    Benchmark(smooth, smoothHeights, "smooth", quick ? 20 : 200);
+    return FinishChecks();
+}
@@ -0,0 +1,211 @@
+// TerrainMeshBuilder: las filas SSE2 frente a las escalares, la construccion repartida en el pool
+// frente a la de un hilo y el modo compacto (alturas de 16 bits reconstruidas como en
+// TerrainCompactVS) frente a los vertices completos. Despues, el coste de construir los vertices
+// de 256, 2048 y 8192 de lado con el metodo anterior (normales de cara sumadas), con el gather en
+// un hilo y con gather + SIMD + pool.
+//
+//   TerrainMeshBuilderTest          los tres tamanos
+//   TerrainMeshBuilderTest --quick  256 (lo que ejecuta ctest)
+
+#include "TerrainMeshBuilder.h"
+#include "ThreadPool.h"
+#include "Check.h"
+#include "Measure.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    struct TerrainMeshBenchmarkResult
+    {
+        int size = 0;                  // Lado del heightfield
+        double scatterNormalsMs = 0.0; // Metodo anterior: un hilo, normales sumando caras
+        double serialMs = 0.0;         // Gather + diferencias centrales, un hilo y sin SIMD
+        double parallelMs = 0.0;       // Gather + SIMD + filas repartidas en el pool
+    };
+
+    // Heightfield sintetico con alturas de 8 bits (k / 255), como los heightmaps del juego
+    std::vector<float> SyntheticHeights(int width, int height)
+    {
+        std::vector<float> heights(static_cast<size_t>(width) * height);
+        for (int j = 0; j < height; ++j)
+        {
+            for (int i = 0; i < width; ++i)
+            {
+                float h = 0.5f + 0.25f * std::sin(i * 0.013f) * std::cos(j * 0.017f) + 0.2f * std::sin(i * 0.31f + j * 0.23f);
+                heights[static_cast<size_t>(j) * width + i] = std::lround(h * 255.0f) / 255.0f;
+            }
+        }
+        return heights;
+    }
+
+    float MaxDifference(const std::vector<TerrainMeshVertex>& a, const std::vector<TerrainMeshVertex>& b)
+    {
+        float difference = 0.0f;
+        for (size_t v = 0; v < a.size(); ++v)
+        {
+            const float* x = reinterpret_cast<const float*>(&a[v]);
+            const float* y = reinterpret_cast<const float*>(&b[v]);
+            for (int k = 0; k < 8; ++k) difference = std::max(difference, std::fabs(x[k] - y[k]));
+        }
+        return difference;
+    }
+
+    // Metodo anterior (referencia de las medidas): normales de cara sumadas en los vertices
+    void BuildRowsScatter(const float* heights, int width, int height, float heightScale, float textureTiling,
+        int firstRow, int lastRow, TerrainMeshVertex* outVertices)
+    {
+        const float uScale = textureTiling / static_cast<float>(width - 1);
+        const float vScale = textureTiling / static_cast<float>(height - 1);
+        for (int j = firstRow; j < lastRow; ++j)
+        {
+            for (int i = 0; i < width; ++i)
+            {
+                TerrainMeshVertex& vertex = outVertices[static_cast<size_t>(j - firstRow) * width + i];
+                vertex.position = XMFLOAT3(static_cast<float>(i), heights[static_cast<size_t>(j) * width + i] * heightScale, static_cast<float>(j));
+                vertex.normal = XMFLOAT3(0.0f, 0.0f, 0.0f);
+                vertex.textureCoordinate = XMFLOAT2(i * uScale, j * vScale);
+            }
+        }
+
+        for (int j = firstRow; j < lastRow - 1; ++j)
+        {
+            for (int i = 0; i < width - 1; ++i)
+            {
+                const size_t corners[4] = {
+                    static_cast<size_t>(j - firstRow) * width + i, static_cast<size_t>(j - firstRow) * width + i + 1,
+                    static_cast<size_t>(j + 1 - firstRow) * width + i, static_cast<size_t>(j + 1 - firstRow) * width + i + 1 };
+                const size_t triangles[2][3] = { { corners[0], corners[1], corners[2] }, { corners[2], corners[1], corners[3] } };
+                for (const auto& triangle : triangles)
+                {
+                    XMVECTOR p0 = XMLoadFloat3(&outVertices[triangle[0]].position);
+                    XMVECTOR p1 = XMLoadFloat3(&outVertices[triangle[1]].position);
+                    XMVECTOR p2 = XMLoadFloat3(&outVertices[triangle[2]].position);
+                    XMVECTOR faceNormal = XMVector3Cross(XMVectorSubtract(p2, p0), XMVectorSubtract(p1, p0));
+                    for (size_t corner : triangle)
+                    {
+                        XMStoreFloat3(&outVertices[corner].normal, XMVectorAdd(XMLoadFloat3(&outVertices[corner].normal), faceNormal));
+                    }
+                }
+            }
+        }
+
+        for (int j = firstRow; j < lastRow; ++j)
+        {
+            for (int i = 0; i < width; ++i)
+            {
+                XMFLOAT3& normal = outVertices[static_cast<size_t>(j - firstRow) * width + i].normal;
+                XMStoreFloat3(&normal, XMVector3Normalize(XMLoadFloat3(&normal)));
+            }
+        }
+    }
+
+    // Filas [firstRow, lastRow) en bandas de ROWS_PER_TASK repartidas en el pool, como BuildVertices
+    void BuildRowsParallel(const float* heights, int width, int height, float heightScale, float textureTiling,
+        int firstRow, int lastRow, TerrainMeshVertex* outVertices, ThreadPool* pool)
+    {
+        const int bands = (lastRow - firstRow + TerrainMeshBuilder::ROWS_PER_TASK - 1) / TerrainMeshBuilder::ROWS_PER_TASK;
+        pool->ParallelFor(bands, [&](int band)
+        {
+            int bandFirst = firstRow + band * TerrainMeshBuilder::ROWS_PER_TASK;
+            int bandLast = std::min(bandFirst + TerrainMeshBuilder::ROWS_PER_TASK, lastRow);
+            TerrainMeshBuilder::BuildVertexRows(heights, width, height, heightScale, textureTiling,
+                bandFirst, bandLast, outVertices + static_cast<size_t>(bandFirst - firstRow) * width);
+        });
+    }
+
+    // Con heightfields grandes los vertices se construyen por bandas sobre un buffer reutilizado
+    TerrainMeshBenchmarkResult Benchmark(int size, ThreadPool* pool)
+    {
+        TerrainMeshBenchmarkResult result;
+        result.size = size;
+
+        const std::vector<float> heights = SyntheticHeights(size, size);
+
+        // Bandas de como mucho ~4M vertices para que 8k x 8k no necesite 2 GB de vertices
+        const int bandRows = std::max(TerrainMeshBuilder::ROWS_PER_TASK, std::min(size, (4 * 1024 * 1024) / size));
+        std::vector<TerrainMeshVertex> vertices(static_cast<size_t>(bandRows) * size);
+        const float heightScale = 300.0f;
+        const float tiling = 8.0f;
+
+        auto start = std::chrono::steady_clock::now();
+        for (int first = 0; first < size; first += bandRows)
+        {
+            BuildRowsScatter(heights.data(), size, size, heightScale, tiling, first, std::min(first + bandRows, size), vertices.data());
+        }
+        result.scatterNormalsMs = MillisecondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        for (int first = 0; first < size; first += bandRows)
+        {
+            TerrainMeshBuilder::BuildVertexRows(heights.data(), size, size, heightScale, tiling, first, std::min(first + bandRows, size), vertices.data(), false);
+        }
+        result.serialMs = MillisecondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        for (int first = 0; first < size; first += bandRows)
+        {
+            BuildRowsParallel(heights.data(), size, size, heightScale, tiling, first, std::min(first + bandRows, size), vertices.data(), pool);
+        }
+        result.parallelMs = MillisecondsSince(start);
+
+        return result;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick = false;
+    if (!ParseQuickOption(argc, argv, quick)) return 2;
+
+    ThreadPool threadPool;
+    ThreadPool* pool = &threadPool;
+
+    // Ancho que no es multiplo de 4 (el interior va de 4 en 4 y el resto en escalar)
+    const int width = 203, height = 131;
+    const float heightScale = 300.0f, tiling = 8.0f;
+    const std::vector<float> heights = SyntheticHeights(width, height);
+    const size_t vertexCount = static_cast<size_t>(width) * height;
+
+    std::vector<TerrainMeshVertex> scalar(vertexCount), simd(vertexCount), pooled(vertexCount);
+    TerrainMeshBuilder::BuildVertexRows(heights.data(), width, height, heightScale, tiling, 0, height, scalar.data(), false);
+    TerrainMeshBuilder::BuildVertices(heights.data(), width, height, heightScale, tiling, simd.data(), nullptr);
+    TerrainMeshBuilder::BuildVertices(heights.data(), width, height, heightScale, tiling, pooled.data(), pool);
+    const float simdDifference = MaxDifference(scalar, simd);
+    Check(simdDifference < 1e-5f, "SIMD rows differ from the scalar rows");
+    Check(std::memcmp(simd.data(), pooled.data(), vertexCount * sizeof(TerrainMeshVertex)) == 0, "pool changes the vertices");
+
+    // Alturas de 8 bits: caben en 16 y la reconstruccion compacta da los mismos bits
+    std::vector<uint16_t> quantized(vertexCount);
+    TerrainMeshBuilder::QuantizeHeights(heights.data(), vertexCount, quantized.data());
+    const size_t compactMismatches = TerrainMeshBuilder::CountCompactMismatches(quantized.data(), width, height, heightScale, tiling, simd.data());
+    Check(compactMismatches == 0, "compact vertices differ from the full vertex buffer");
+
+    std::vector<TerrainPackedNormal> packed(vertexCount);
+    TerrainMeshBuilder::PackNormals(simd.data(), vertexCount, packed.data());
+    float packError = 0.0f;
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        packError = std::max(packError, std::fabs(packed[v].x / 127.0f - simd[v].normal.x));
+        packError = std::max(packError, std::fabs(packed[v].z / 127.0f - simd[v].normal.z));
+    }
+    Check(packError <= 0.5f / 127.0f + 1e-6f, "packed normals off by more than half a step");
+    std::printf("Terrain mesh %dx%d: SIMD difference %.2e, compact mismatches %zu, packed normal error %.4f\n",
+        width, height, simdDifference, compactMismatches, packError);
+
+    // Construccion de la malla: metodo anterior frente a gather serie y gather + SIMD + pool
+    for (int size : Sizes(quick, { 256, 2048, 8192 }))
+    {
+        TerrainMeshBenchmarkResult result = Benchmark(size, pool);
+        std::printf("Terrain mesh benchmark %dx%d: scatter %.1f ms, gather %.1f ms, gather SIMD x%u hilos %.1f ms\n",
+            result.size, result.size, result.scatterNormalsMs, result.serialMs, pool->GetThreadCount(), result.parallelMs);
+    }
+
+    return FinishChecks();
+}
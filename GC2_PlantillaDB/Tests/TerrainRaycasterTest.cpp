@@ -0,0 +1,266 @@
+// TerrainRaycaster frente a una referencia sin aceleracion que recorre con un DDA todas las celdas
+// que cruza el rayo, sobre heightfields sinteticos de 257, 1025 y 4097 de lado: mitad rayos de
+// seleccion (desde arriba hacia el suelo) y mitad casi horizontales (linea de vision). Los impactos
+// tienen que coincidir, el lote repartido en el pool tiene que dar lo mismo que rayo a rayo y, en
+// todos los tamanos, Raycast tiene que ser mas rapido que la referencia.
+//
+//   TerrainRaycasterTest          los tres tamanos
+//   TerrainRaycasterTest --quick  257 (lo que ejecuta ctest)
+
+#include "TerrainRaycaster.h"
+#include "ThreadPool.h"
+#include "Check.h"
+#include "Measure.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    struct TerrainRaycastBenchmarkResult
+    {
+        int size = 0;
+        size_t rayCount = 0;
+        size_t hits = 0;
+        double bruteForceMs = 0.0; // Referencia: recorrido celda a celda (DDA) probando todos los triangulos
+        double quadtreeMs = 0.0;   // Quadtree min-max, un hilo
+        double batchMs = 0.0;      // Quadtree min-max, lote repartido en el pool
+        size_t mismatches = 0;     // Rayos donde la referencia y el quadtree no dan el mismo impacto
+        size_t batchMismatches = 0; // Rayos donde el lote no da lo mismo que Raycast
+    };
+
+    XMFLOAT3 Subtract(const XMFLOAT3& a, const XMFLOAT3& b) { return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z); }
+    XMFLOAT3 Cross(const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+    }
+    float Dot(const XMFLOAT3& a, const XMFLOAT3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+    // Moller-Trumbore a doble cara; t en (0, maxT]
+    bool IntersectTriangle(const TerrainRay& ray, const XMFLOAT3& p0, const XMFLOAT3& p1, const XMFLOAT3& p2,
+        float maxT, float& outT)
+    {
+        XMFLOAT3 edge1 = Subtract(p1, p0);
+        XMFLOAT3 edge2 = Subtract(p2, p0);
+        XMFLOAT3 pvec = Cross(ray.direction, edge2);
+        float determinant = Dot(edge1, pvec);
+        if (std::fabs(determinant) < 1.0e-12f) return false;
+
+        float invDeterminant = 1.0f / determinant;
+        XMFLOAT3 tvec = Subtract(ray.origin, p0);
+        float u = Dot(tvec, pvec) * invDeterminant;
+        if (u < 0.0f || u > 1.0f) return false;
+
+        XMFLOAT3 qvec = Cross(tvec, edge1);
+        float v = Dot(ray.direction, qvec) * invDeterminant;
+        if (v < 0.0f || u + v > 1.0f) return false;
+
+        float t = Dot(edge2, qvec) * invDeterminant;
+        if (t <= 0.0f || t > maxT) return false;
+        outT = t;
+        return true;
+    }
+
+    // Referencia sin aceleracion: las celdas que cruza el rayo dentro de la caja del terreno, en
+    // orden, con los mismos dos triangulos por celda que la malla.
+    class ReferenceRaycaster
+    {
+    public:
+        ReferenceRaycaster(const std::vector<float>& heights, int width, int height, float heightScale) :
+            m_heights(heights.size()), m_width(width), m_height(height)
+        {
+            for (size_t i = 0; i < heights.size(); ++i) m_heights[i] = heights[i] * heightScale;
+            m_minHeight = *std::min_element(m_heights.begin(), m_heights.end());
+            m_maxHeight = *std::max_element(m_heights.begin(), m_heights.end());
+        }
+
+        bool Raycast(const TerrainRay& ray, TerrainRayHit& outHit) const
+        {
+            outHit = TerrainRayHit();
+            const int cellsX = m_width - 1;
+            const int cellsZ = m_height - 1;
+
+            // Tramo del rayo dentro de la caja de todo el terreno (con holgura en los bordes)
+            const float padding = 1.0e-3f;
+            const float boxMin[3] = { -padding, m_minHeight - padding, -padding };
+            const float boxMax[3] = { cellsX + padding, m_maxHeight + padding, cellsZ + padding };
+            const float origin[3] = { ray.origin.x, ray.origin.y, ray.origin.z };
+            const float direction[3] = { ray.direction.x, ray.direction.y, ray.direction.z };
+            float enterT = 0.0f, exitT = ray.maxT;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                if (direction[axis] == 0.0f)
+                {
+                    if (origin[axis] < boxMin[axis] || origin[axis] > boxMax[axis]) return false;
+                    continue;
+                }
+                float t0 = (boxMin[axis] - origin[axis]) / direction[axis];
+                float t1 = (boxMax[axis] - origin[axis]) / direction[axis];
+                if (t0 > t1) std::swap(t0, t1);
+                enterT = std::max(enterT, t0);
+                exitT = std::min(exitT, t1);
+                if (enterT > exitT) return false;
+            }
+
+            int cellX = std::min(std::max(static_cast<int>(std::floor(ray.origin.x + ray.direction.x * enterT)), 0), cellsX - 1);
+            int cellZ = std::min(std::max(static_cast<int>(std::floor(ray.origin.z + ray.direction.z * enterT)), 0), cellsZ - 1);
+
+            // DDA en XZ (Amanatides-Woo); el siguiente borde se calcula siempre desde el origen
+            const float infinity = std::numeric_limits<float>::infinity();
+            const int stepX = ray.direction.x > 0.0f ? 1 : -1;
+            const int stepZ = ray.direction.z > 0.0f ? 1 : -1;
+            auto boundaryT = [](int cell, int step, float rayOrigin, float rayDirection)
+            {
+                return (static_cast<float>(cell + (step > 0 ? 1 : 0)) - rayOrigin) / rayDirection;
+            };
+            float nextX = ray.direction.x != 0.0f ? boundaryT(cellX, stepX, ray.origin.x, ray.direction.x) : infinity;
+            float nextZ = ray.direction.z != 0.0f ? boundaryT(cellZ, stepZ, ray.origin.z, ray.direction.z) : infinity;
+
+            float bestT = ray.maxT;
+            float cellEnterT = enterT;
+            while (cellX >= 0 && cellX < cellsX && cellZ >= 0 && cellZ < cellsZ && cellEnterT <= bestT)
+            {
+                const XMFLOAT3 topLeft = Vertex(cellX, cellZ);
+                const XMFLOAT3 topRight = Vertex(cellX + 1, cellZ);
+                const XMFLOAT3 bottomLeft = Vertex(cellX, cellZ + 1);
+                const XMFLOAT3 bottomRight = Vertex(cellX + 1, cellZ + 1);
+                float t;
+                if (IntersectTriangle(ray, topLeft, topRight, bottomLeft, bestT, t)) bestT = t;
+                if (IntersectTriangle(ray, bottomLeft, topRight, bottomRight, bestT, t)) bestT = t;
+
+                if (nextX < nextZ)
+                {
+                    cellEnterT = nextX;
+                    cellX += stepX;
+                    nextX = boundaryT(cellX, stepX, ray.origin.x, ray.direction.x);
+                }
+                else
+                {
+                    cellEnterT = nextZ;
+                    cellZ += stepZ;
+                    nextZ = boundaryT(cellZ, stepZ, ray.origin.z, ray.direction.z);
+                }
+                if (cellEnterT > ray.maxT) break;
+            }
+
+            if (bestT < ray.maxT)
+            {
+                outHit.hit = true;
+                outHit.t = bestT;
+            }
+            return outHit.hit;
+        }
+
+    private:
+        XMFLOAT3 Vertex(int x, int z) const
+        {
+            return XMFLOAT3(static_cast<float>(x), m_heights[static_cast<size_t>(z) * m_width + x], static_cast<float>(z));
+        }
+
+        std::vector<float> m_heights; // Ya escaladas
+        int m_width;
+        int m_height;
+        float m_minHeight;
+        float m_maxHeight;
+    };
+
+    TerrainRaycastBenchmarkResult Benchmark(int size, size_t rayCount, ThreadPool* pool)
+    {
+        TerrainRaycastBenchmarkResult result;
+        result.size = size;
+        result.rayCount = rayCount;
+
+        std::vector<float> heights(static_cast<size_t>(size) * size);
+        for (int j = 0; j < size; ++j)
+        {
+            for (int i = 0; i < size; ++i)
+            {
+                heights[static_cast<size_t>(j) * size + i] = 0.5f + 0.2f * std::sin(i * 0.031f) * std::cos(j * 0.027f) +
+                    0.05f * std::sin(i * 0.21f + j * 0.17f);
+            }
+        }
+
+        TerrainRaycaster raycaster;
+        raycaster.Build(heights.data(), size, size, 300.0f);
+        const ReferenceRaycaster reference(heights, size, size, 300.0f);
+
+        // Mitad rayos de seleccion (desde arriba hacia el suelo) y mitad casi horizontales (linea de vision)
+        std::mt19937 random(4321);
+        std::uniform_real_distribution<float> coordinate(0.0f, static_cast<float>(size - 1));
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::vector<TerrainRay> rays(rayCount);
+        for (size_t i = 0; i < rayCount; ++i)
+        {
+            TerrainRay& ray = rays[i];
+            ray.origin = XMFLOAT3(coordinate(random), 260.0f + 40.0f * unit(random), coordinate(random));
+            if (i % 2 == 0)
+            {
+                XMFLOAT3 target(coordinate(random), 0.0f, coordinate(random));
+                ray.direction = XMFLOAT3(target.x - ray.origin.x, target.y - ray.origin.y, target.z - ray.origin.z);
+            }
+            else
+            {
+                ray.direction = XMFLOAT3(unit(random), -0.05f + 0.04f * unit(random), unit(random));
+            }
+        }
+
+        std::vector<TerrainRayHit> bruteHits(rayCount), treeHits(rayCount), batchHits(rayCount);
+
+        // El mejor de tres: la comparacion de tiempos es una comprobacion y no debe fallar por ruido
+        result.bruteForceMs = result.quadtreeMs = result.batchMs = 1.0e30;
+        for (int run = 0; run < 3; ++run)
+        {
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < rayCount; ++i) reference.Raycast(rays[i], bruteHits[i]);
+            result.bruteForceMs = std::min(result.bruteForceMs, MillisecondsSince(start));
+
+            start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < rayCount; ++i) raycaster.Raycast(rays[i], treeHits[i]);
+            result.quadtreeMs = std::min(result.quadtreeMs, MillisecondsSince(start));
+
+            start = std::chrono::steady_clock::now();
+            result.hits = raycaster.RaycastBatch(rays.data(), rayCount, batchHits.data(), pool);
+            result.batchMs = std::min(result.batchMs, MillisecondsSince(start));
+        }
+
+        for (size_t i = 0; i < rayCount; ++i)
+        {
+            const TerrainRayHit& a = bruteHits[i];
+            const TerrainRayHit& b = treeHits[i];
+            if (a.hit != b.hit || (a.hit && std::fabs(a.t - b.t) > 1.0e-4f * std::max(1.0f, a.t))) result.mismatches++;
+            if (batchHits[i].hit != b.hit || batchHits[i].t != b.t || batchHits[i].cellX != b.cellX || batchHits[i].cellZ != b.cellZ)
+                result.batchMismatches++;
+        }
+        return result;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick = false;
+    if (!ParseQuickOption(argc, argv, quick)) return 2;
+
+    ThreadPool threadPool;
+    ThreadPool* pool = &threadPool;
+
+    // Rayos contra el heightfield: recorrido celda a celda frente al quadtree min-max
+    for (int size : Sizes(quick, { 257, 1025, 4097 }))
+    {
+        TerrainRaycastBenchmarkResult result = Benchmark(size, 100000, pool);
+        std::printf("Terrain raycast benchmark %dx%d, %zu rays (%zu hits): brute force %.1f ms, quadtree %.1f ms, batch x%u hilos %.1f ms, mismatches %zu\n",
+            result.size, result.size, result.rayCount, result.hits, result.bruteForceMs, result.quadtreeMs, pool->GetThreadCount(),
+            result.batchMs, result.mismatches);
+        Check(result.hits > 0, "no ray hits the terrain");
+        Check(result.mismatches == 0, "quadtree hits differ from the DDA reference");
+        Check(result.batchMismatches == 0, "RaycastBatch differs from Raycast");
+        Check(result.quadtreeMs < result.bruteForceMs, "quadtree is not faster than the cell-by-cell reference");
+    }
+
+    return FinishChecks();
+}
@@ -0,0 +1,208 @@
+// TerrainScatter sobre colinas sinteticas de 1025 x 1025 con las proporciones del terreno del
+// juego (300 unidades de altura, base en -20), tres reglas y 64 exclusiones: el resultado tiene
+// que ser el mismo con y sin pool y al repetir, y ninguna instancia puede quedar a menos de
+// minDistance de otra, dentro de una exclusion o donde su regla no deja poner nada.
+//
+//   TerrainScatterTest          region de 5000 x 5000
+//   TerrainScatterTest --quick  1000 x 1000 (lo que ejecuta ctest)
+
+#include "TerrainScatter.h"
+#include "TerrainHeightSampler.h"
+#include "ThreadPool.h"
+#include "Check.h"
+#include "Measure.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    struct TerrainScatterBenchmarkResult
+    {
+        size_t instanceCount = 0;
+        size_t candidateCount = 0;   // Puntos de Poisson antes de aplicar las reglas
+        double cellCount = 0.0;      // Celdas de la rejilla de aceleracion
+        bool regionTooLarge = false; // La region no cabia en MAX_CELLS y no se genero nada
+        double serialMs = 0.0;       // Sin pool
+        double parallelMs = 0.0;     // Con el pool
+        unsigned int threads = 1;
+        bool deterministic = false;  // Mismo resultado con y sin pool, y al repetir
+        size_t spacingViolations = 0;
+        size_t exclusionViolations = 0;
+        size_t ruleViolations = 0;   // Instancias fuera de la altura o pendiente de su regla
+    };
+
+    bool SameInstances(const std::vector<TerrainScatterInstance>& a, const std::vector<TerrainScatterInstance>& b)
+    {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            if (a[i].x != b[i].x || a[i].y != b[i].y || a[i].z != b[i].z || a[i].yaw != b[i].yaw ||
+                a[i].scale != b[i].scale || a[i].rule != b[i].rule)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool InsideExclusion(float x, float z, const std::vector<TerrainScatterExclusion>& exclusions)
+    {
+        for (const TerrainScatterExclusion& zone : exclusions)
+        {
+            float dx = x - zone.x;
+            float dz = z - zone.z;
+            if (dx * dx + dz * dz < zone.radius * zone.radius) return true;
+        }
+        return false;
+    }
+
+    // Region de areaSize x areaSize unidades: tiempos con y sin pool y comprobaciones de
+    // determinismo, separacion, exclusiones y reglas.
+    TerrainScatterBenchmarkResult Benchmark(float areaSize, float minDistance, ThreadPool* pool)
+    {
+        TerrainScatterBenchmarkResult result;
+        result.threads = pool ? pool->GetThreadCount() : 1;
+
+        const int size = 1025;
+        std::vector<float> heights(static_cast<size_t>(size) * size);
+        for (int j = 0; j < size; ++j)
+        {
+            for (int i = 0; i < size; ++i)
+            {
+                heights[static_cast<size_t>(j) * size + i] = 0.35f + 0.25f * std::sin(i * 0.011f) * std::cos(j * 0.009f) +
+                    0.08f * std::sin(i * 0.043f + j * 0.031f) + 0.02f * std::cos(i * 0.21f - j * 0.17f);
+            }
+        }
+
+        const float cellSize = areaSize / (size - 1);
+        XMFLOAT4X4 world = {};
+        world._11 = cellSize;
+        world._22 = 1.0f;
+        world._33 = cellSize;
+        world._41 = -0.5f * areaSize;
+        world._42 = -20.0f;
+        world._43 = -0.5f * areaSize;
+        world._44 = 1.0f;
+        TerrainHeightSampler sampler;
+        sampler.SetHeights(heights.data(), size, size, 300.0f);
+        sampler.SetTransform(world);
+
+        TerrainScatterRule rules[3];
+        rules[0].density = 0.6f; // Pinos en laderas medias
+        rules[0].minHeight = 40.0f;
+        rules[0].maxHeight = 200.0f;
+        rules[0].heightFade = 20.0f;
+        rules[0].minNormalY = 0.75f;
+        rules[0].normalFade = 0.1f;
+        rules[0].minScale = 0.8f;
+        rules[0].maxScale = 1.2f;
+        rules[1].density = 0.8f; // Arboles en los valles
+        rules[1].maxHeight = 60.0f;
+        rules[1].heightFade = 15.0f;
+        rules[1].minNormalY = 0.9f;
+        rules[2].density = 0.3f; // Arbustos en cualquier sitio no muy empinado
+        rules[2].minNormalY = 0.6f;
+
+        std::vector<TerrainScatterExclusion> exclusions;
+        std::mt19937 random(99);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        for (int i = 0; i < 64; ++i)
+        {
+            TerrainScatterExclusion zone;
+            zone.x = (unit(random) - 0.5f) * areaSize;
+            zone.z = (unit(random) - 0.5f) * areaSize;
+            zone.radius = 20.0f + 40.0f * unit(random);
+            exclusions.push_back(zone);
+        }
+
+        TerrainScatterSettings settings;
+        settings.seed = 1234;
+        settings.minX = -0.5f * areaSize;
+        settings.minZ = -0.5f * areaSize;
+        settings.maxX = 0.5f * areaSize;
+        settings.maxZ = 0.5f * areaSize;
+        settings.minDistance = minDistance;
+
+        std::vector<TerrainScatterInstance> serial;
+        std::vector<TerrainScatterInstance> parallel;
+        std::vector<TerrainScatterInstance> repeated;
+        auto start = std::chrono::steady_clock::now();
+        TerrainScatterStats stats;
+        TerrainScatter::Scatter(sampler, settings, rules, 3, exclusions.data(), exclusions.size(), serial, nullptr, &stats);
+        result.serialMs = MillisecondsSince(start);
+        result.candidateCount = stats.candidateCount;
+        result.cellCount = stats.cellCount;
+        result.regionTooLarge = stats.regionTooLarge;
+
+        start = std::chrono::steady_clock::now();
+        TerrainScatter::Scatter(sampler, settings, rules, 3, exclusions.data(), exclusions.size(), parallel, pool);
+        result.parallelMs = MillisecondsSince(start);
+        TerrainScatter::Scatter(sampler, settings, rules, 3, exclusions.data(), exclusions.size(), repeated, pool);
+
+        result.instanceCount = parallel.size();
+        result.deterministic = SameInstances(serial, parallel) && SameInstances(parallel, repeated);
+
+        // Separacion minima: rejilla de celdas de minDistance y vecinas
+        const int bins = std::max(1, static_cast<int>(areaSize / minDistance));
+        std::vector<std::vector<uint32_t>> binned(static_cast<size_t>(bins) * bins);
+        auto binOf = [&](float v) { return std::min(std::max(static_cast<int>((v + 0.5f * areaSize) / areaSize * bins), 0), bins - 1); };
+        for (size_t i = 0; i < parallel.size(); ++i)
+        {
+            binned[static_cast<size_t>(binOf(parallel[i].z)) * bins + binOf(parallel[i].x)].push_back(static_cast<uint32_t>(i));
+        }
+        for (size_t i = 0; i < parallel.size(); ++i)
+        {
+            const TerrainScatterInstance& a = parallel[i];
+            int binX = binOf(a.x);
+            int binZ = binOf(a.z);
+            for (int z = std::max(binZ - 1, 0); z <= std::min(binZ + 1, bins - 1); ++z)
+            {
+                for (int x = std::max(binX - 1, 0); x <= std::min(binX + 1, bins - 1); ++x)
+                {
+                    for (uint32_t other : binned[static_cast<size_t>(z) * bins + x])
+                    {
+                        if (other <= i) continue;
+                        float dx = parallel[other].x - a.x;
+                        float dz = parallel[other].z - a.z;
+                        if (dx * dx + dz * dz < minDistance * minDistance) result.spacingViolations++;
+                    }
+                }
+            }
+
+            if (InsideExclusion(a.x, a.z, exclusions)) result.exclusionViolations++;
+
+            float height;
+            XMFLOAT3 normal;
+            if (!sampler.SampleHeight(a.x, a.z, height, &normal) || TerrainScatter::RuleWeight(rules[a.rule], height, normal.y) <= 0.0f)
+            {
+                result.ruleViolations++;
+            }
+        }
+        return result;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick = false;
+    if (!ParseQuickOption(argc, argv, quick)) return 2;
+
+    ThreadPool threadPool;
+    ThreadPool* pool = &threadPool;
+
+    TerrainScatterBenchmarkResult result = Benchmark(quick ? 1000.0f : 5000.0f, 10.0f, pool);
+    std::printf("Terrain scatter: %zu instances (%zu candidates, %.0f cells), serial %.1f ms, %u threads %.1f ms, deterministic %d, violations %zu/%zu/%zu\n",
+        result.instanceCount, result.candidateCount, result.cellCount, result.serialMs, result.threads, result.parallelMs,
+        result.deterministic ? 1 : 0, result.spacingViolations, result.exclusionViolations, result.ruleViolations);
+    Check(!result.regionTooLarge, "scatter region too large");
+    Check(result.deterministic, "scatter differs with and without the pool");
+    Check(result.spacingViolations == 0 && result.exclusionViolations == 0 && result.ruleViolations == 0, "scatter rule violations");
+
+    return FinishChecks();
+}
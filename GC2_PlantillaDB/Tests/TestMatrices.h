@@ -0,0 +1,92 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cmath>
+
+// Matrices de camara para las pruebas, escritas a mano en la convencion de SimpleMath (fila-mayor,
+// v * M, mano derecha, z de D3D en [0, 1]) para no depender de las funciones de DirectXMath.
+namespace TestMatrices
+{
+    inline DirectX::XMFLOAT4X4 Identity()
+    {
+        DirectX::XMFLOAT4X4 m = {};
+        m._11 = m._22 = m._33 = m._44 = 1.0f;
+        return m;
+    }
+
+    inline DirectX::XMFLOAT4X4 Multiply(const DirectX::XMFLOAT4X4& a, const DirectX::XMFLOAT4X4& b)
+    {
+        DirectX::XMFLOAT4X4 r = {};
+        for (int row = 0; row < 4; ++row)
+        {
+            for (int column = 0; column < 4; ++column)
+            {
+                float sum = 0.0f;
+                for (int k = 0; k < 4; ++k) sum += a.m[row][k] * b.m[k][column];
+                r.m[row][column] = sum;
+            }
+        }
+        return r;
+    }
+
+    // Punto (w = 1) por la matriz: (x, y, z, w) de clip con una viewProjection
+    inline DirectX::XMFLOAT4 TransformPoint(const DirectX::XMFLOAT3& p, const DirectX::XMFLOAT4X4& m)
+    {
+        return DirectX::XMFLOAT4(
+            p.x * m._11 + p.y * m._21 + p.z * m._31 + m._41,
+            p.x * m._12 + p.y * m._22 + p.z * m._32 + m._42,
+            p.x * m._13 + p.y * m._23 + p.z * m._33 + m._43,
+            p.x * m._14 + p.y * m._24 + p.z * m._34 + m._44);
+    }
+
+    // Como Matrix::CreateLookAt
+    inline DirectX::XMFLOAT4X4 LookAt(const DirectX::XMFLOAT3& eye, const DirectX::XMFLOAT3& target, const DirectX::XMFLOAT3& up)
+    {
+        auto normalize = [](float x, float y, float z)
+        {
+            float length = std::sqrt(x * x + y * y + z * z);
+            return DirectX::XMFLOAT3(x / length, y / length, z / length);
+        };
+        auto cross = [](const DirectX::XMFLOAT3& a, const DirectX::XMFLOAT3& b)
+        {
+            return DirectX::XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+        };
+        auto dot = [](const DirectX::XMFLOAT3& a, const DirectX::XMFLOAT3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; };
+
+        DirectX::XMFLOAT3 zAxis = normalize(eye.x - target.x, eye.y - target.y, eye.z - target.z);
+        DirectX::XMFLOAT3 xCross = cross(up, zAxis);
+        DirectX::XMFLOAT3 xAxis = normalize(xCross.x, xCross.y, xCross.z);
+        DirectX::XMFLOAT3 yAxis = cross(zAxis, xAxis);
+
+        DirectX::XMFLOAT4X4 m = Identity();
+        m._11 = xAxis.x; m._12 = yAxis.x; m._13 = zAxis.x;
+        m._21 = xAxis.y; m._22 = yAxis.y; m._23 = zAxis.y;
+        m._31 = xAxis.z; m._32 = yAxis.z; m._33 = zAxis.z;
+        m._41 = -dot(xAxis, eye); m._42 = -dot(yAxis, eye); m._43 = -dot(zAxis, eye);
+        return m;
+    }
+
+    // Como Matrix::CreatePerspectiveFieldOfView
+    inline DirectX::XMFLOAT4X4 Perspective(float fovY, float aspect, float nearPlane, float farPlane)
+    {
+        const float yScale = 1.0f / std::tan(fovY * 0.5f);
+        DirectX::XMFLOAT4X4 m = {};
+        m._11 = yScale / aspect;
+        m._22 = yScale;
+        m._33 = farPlane / (nearPlane - farPlane);
+        m._34 = -1.0f;
+        m._43 = nearPlane * farPlane / (nearPlane - farPlane);
+        return m;
+    }
+
+    // Como Matrix::CreateOrthographic
+    inline DirectX::XMFLOAT4X4 Orthographic(float width, float height, float nearPlane, float farPlane)
+    {
+        DirectX::XMFLOAT4X4 m = Identity();
+        m._11 = 2.0f / width;
+        m._22 = 2.0f / height;
+        m._33 = 1.0f / (nearPlane - farPlane);
+        m._43 = nearPlane / (nearPlane - farPlane);
+        return m;
+    }
+}
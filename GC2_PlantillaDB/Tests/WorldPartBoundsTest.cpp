@@ -0,0 +1,248 @@
+// WorldPartBounds con instancias giradas y escaladas de 1 a 24 partes (casas, molino, arboles) y
+// la caja de la camara junto a la instancia que devuelve la broadphase: coste del camino anterior
+// (componer matrices y transformar las 8 esquinas de cada caja en cada consulta) frente a la SoA,
+// y todo lo que se corta de verdad (SAT completo) tiene que pasar el filtro de la SoA.
+//
+//   WorldPartBoundsTest          100, 1000 y 10000 instancias, 200000 consultas
+//   WorldPartBoundsTest --quick  100 instancias, 20000 consultas (lo que ejecuta ctest)
+
+#include "WorldPartBounds.h"
+#include "Check.h"
+#include "Measure.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    struct WorldPartBoundsBenchmarkResult
+    {
+        size_t instanceCount = 0;
+        size_t partCount = 0;
+        size_t queryCount = 0;
+        double buildMs = 0.0;
+        double transformNsPerQuery = 0.0; // Camino anterior: componer matrices y transformar cada caja en cada consulta
+        double soaNsPerQuery = 0.0;
+        size_t transformHits = 0;
+        size_t soaHits = 0;
+        size_t missedOverlaps = 0;        // Caja y parte que se cortan (SAT completo) y la SoA descarta: debe ser 0
+    };
+
+    struct Vec3
+    {
+        float x, y, z;
+    };
+
+    Vec3 operator-(const Vec3& a, const Vec3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+    Vec3 operator*(const Vec3& a, float s) { return { a.x * s, a.y * s, a.z * s }; }
+    float Dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    Vec3 Cross(const Vec3& a, const Vec3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+    Vec3 Abs(const Vec3& v) { return { std::fabs(v.x), std::fabs(v.y), std::fabs(v.z) }; }
+
+    // Producto fila * matriz como en SimpleMath (vectores fila, v * M).
+    XMFLOAT4X4 MultiplyRowMajor(const XMFLOAT4X4& a, const XMFLOAT4X4& b)
+    {
+        XMFLOAT4X4 r;
+        for (int i = 0; i < 4; ++i)
+        {
+            for (int j = 0; j < 4; ++j)
+            {
+                r.m[i][j] = a.m[i][0] * b.m[0][j] + a.m[i][1] * b.m[1][j] +
+                    a.m[i][2] * b.m[2][j] + a.m[i][3] * b.m[3][j];
+            }
+        }
+        return r;
+    }
+
+    Vec3 TransformPoint(const Vec3& v, const XMFLOAT4X4& m)
+    {
+        return { v.x * m._11 + v.y * m._21 + v.z * m._31 + m._41,
+                 v.x * m._12 + v.y * m._22 + v.z * m._32 + m._42,
+                 v.x * m._13 + v.y * m._23 + v.z * m._33 + m._43 };
+    }
+
+    // Caja transformada: centro y semiaristas (filas de la matriz por el semieje)
+    void TransformBox(const XMFLOAT3& center, const XMFLOAT3& extents, const XMFLOAT4X4& m, Vec3& outCenter, Vec3 outEdges[3])
+    {
+        outCenter = TransformPoint({ center.x, center.y, center.z }, m);
+        outEdges[0] = Vec3{ m._11, m._12, m._13 } * extents.x;
+        outEdges[1] = Vec3{ m._21, m._22, m._23 } * extents.y;
+        outEdges[2] = Vec3{ m._31, m._32, m._33 } * extents.z;
+    }
+
+    bool Separated(const Vec3& axis, const Vec3& d, const Vec3 edges[3], const Vec3& boxExtents)
+    {
+        float parallelepiped = std::fabs(Dot(edges[0], axis)) + std::fabs(Dot(edges[1], axis)) + std::fabs(Dot(edges[2], axis));
+        float box = Dot(boxExtents, Abs(axis));
+        return std::fabs(Dot(d, axis)) > parallelepiped + box;
+    }
+
+    // SAT completo entre la AABB de la consulta y el paralelepipedo: 3 + 3 caras y 9 aristas
+    bool ExactOverlap(const Vec3& center, const Vec3 edges[3], const Vec3& boxCenter, const Vec3& boxExtents)
+    {
+        const Vec3 d = center - boxCenter;
+        const Vec3 boxAxes[3] = { { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } };
+        for (const Vec3& axis : boxAxes)
+        {
+            if (Separated(axis, d, edges, boxExtents)) return false;
+        }
+        for (int k = 0; k < 3; ++k)
+        {
+            if (Separated(Cross(edges[(k + 1) % 3], edges[(k + 2) % 3]), d, edges, boxExtents)) return false;
+        }
+        for (const Vec3& boxAxis : boxAxes)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                if (Separated(Cross(boxAxis, edges[k]), d, edges, boxExtents)) return false;
+            }
+        }
+        return true;
+    }
+
+    double NanosecondsPerQuery(std::chrono::steady_clock::time_point start, size_t count)
+    {
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        return count > 0 ? ns / static_cast<double>(count) : 0.0;
+    }
+
+    WorldPartBoundsBenchmarkResult Benchmark(size_t instanceCount, size_t queryCount)
+    {
+        WorldPartBoundsBenchmarkResult result;
+        result.instanceCount = instanceCount;
+        result.queryCount = queryCount;
+
+        // Modelos de 1 a 24 partes (casas, molino, arboles) con transformaciones de nodo giradas
+        std::mt19937 random(99);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        auto inRange = [&](float low, float high) { return low + (high - low) * unit(random); };
+        auto rotationY = [](float angle, float scaleX, float scaleY, float scaleZ, const Vec3& translation)
+        {
+            float c = std::cos(angle), s = std::sin(angle);
+            XMFLOAT4X4 m = {};
+            m._11 = c * scaleX; m._13 = -s * scaleX;
+            m._22 = scaleY;
+            m._31 = s * scaleZ; m._33 = c * scaleZ;
+            m._41 = translation.x; m._42 = translation.y; m._43 = translation.z;
+            m._44 = 1.0f;
+            return m;
+        };
+
+        std::vector<std::vector<PartBox>> instanceParts(instanceCount);
+        std::vector<XMFLOAT4X4> worlds(instanceCount);
+        for (size_t n = 0; n < instanceCount; ++n)
+        {
+            size_t partCount = 1 + random() % 24;
+            for (size_t p = 0; p < partCount; ++p)
+            {
+                PartBox part;
+                part.center = XMFLOAT3(inRange(-2.0f, 2.0f), inRange(0.0f, 4.0f), inRange(-2.0f, 2.0f));
+                part.extents = XMFLOAT3(inRange(0.2f, 6.0f), inRange(0.2f, 6.0f), inRange(0.0f, 6.0f));
+                part.nodeTransform = rotationY(inRange(-XM_PI, XM_PI), 1.0f, 1.0f, 1.0f, { inRange(-15.0f, 15.0f), inRange(0.0f, 20.0f), inRange(-15.0f, 15.0f) });
+                instanceParts[n].push_back(part);
+            }
+            float scale = inRange(0.5f, 4.0f);
+            worlds[n] = rotationY(inRange(-XM_PI, XM_PI), scale, scale * inRange(0.8f, 1.2f), scale, { inRange(-2500.0f, 2500.0f), inRange(-50.0f, 50.0f), inRange(-2500.0f, 2500.0f) });
+            result.partCount += partCount;
+        }
+
+        WorldPartBounds bounds;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t n = 0; n < instanceCount; ++n) bounds.AddInstance(instanceParts[n].data(), instanceParts[n].size(), worlds[n]);
+        result.buildMs = MillisecondsSince(start);
+
+        // Caja de la camara junto a la instancia que devuelve la broadphase
+        struct Query { uint32_t instance; Vec3 center; };
+        const Vec3 extents = { 0.4f, 0.9f, 0.4f };
+        std::vector<Query> queries(queryCount);
+        for (Query& query : queries)
+        {
+            query.instance = instanceCount > 0 ? static_cast<uint32_t>(random() % instanceCount) : 0;
+            query.center = TransformPoint({ inRange(-25.0f, 25.0f), inRange(-5.0f, 30.0f), inRange(-25.0f, 25.0f) }, worlds[query.instance]);
+        }
+        if (instanceCount == 0) return result;
+
+        // 1. Camino anterior: localNodeTransform * instancia y las 8 esquinas de cada caja, en cada consulta
+        const float inf = std::numeric_limits<float>::infinity();
+        std::vector<uint8_t> transformResults(queryCount);
+        start = std::chrono::steady_clock::now();
+        for (size_t q = 0; q < queryCount; ++q)
+        {
+            const Query& query = queries[q];
+            bool hit = false;
+            for (const PartBox& part : instanceParts[query.instance])
+            {
+                XMFLOAT4X4 m = MultiplyRowMajor(part.nodeTransform, worlds[query.instance]);
+                Vec3 mn = { inf, inf, inf }, mx = { -inf, -inf, -inf };
+                for (int corner = 0; corner < 8; ++corner)
+                {
+                    Vec3 local = { part.center.x + ((corner & 1) ? part.extents.x : -part.extents.x),
+                                   part.center.y + ((corner & 2) ? part.extents.y : -part.extents.y),
+                                   part.center.z + ((corner & 4) ? part.extents.z : -part.extents.z) };
+                    Vec3 p = TransformPoint(local, m);
+                    mn = { std::min(mn.x, p.x), std::min(mn.y, p.y), std::min(mn.z, p.z) };
+                    mx = { std::max(mx.x, p.x), std::max(mx.y, p.y), std::max(mx.z, p.z) };
+                }
+                if (mn.x <= query.center.x + extents.x && mx.x >= query.center.x - extents.x &&
+                    mn.y <= query.center.y + extents.y && mx.y >= query.center.y - extents.y &&
+                    mn.z <= query.center.z + extents.z && mx.z >= query.center.z - extents.z)
+                {
+                    hit = true;
+                    break;
+                }
+            }
+            transformResults[q] = hit ? 1 : 0;
+            result.transformHits += hit ? 1 : 0;
+        }
+        result.transformNsPerQuery = NanosecondsPerQuery(start, queryCount);
+
+        // 2. SoA precalculada
+        std::vector<uint8_t> soaResults(queryCount);
+        start = std::chrono::steady_clock::now();
+        for (size_t q = 0; q < queryCount; ++q)
+        {
+            const XMFLOAT3 center(queries[q].center.x, queries[q].center.y, queries[q].center.z);
+            soaResults[q] = bounds.Overlaps(queries[q].instance, center, XMFLOAT3(extents.x, extents.y, extents.z)) ? 1 : 0;
+        }
+        result.soaNsPerQuery = NanosecondsPerQuery(start, queryCount);
+
+        // 3. Todo lo que se corta de verdad tiene que pasar el filtro
+        for (size_t q = 0; q < queryCount; ++q)
+        {
+            result.soaHits += soaResults[q];
+            bool exact = false;
+            for (const PartBox& part : instanceParts[queries[q].instance])
+            {
+                Vec3 center, edges[3];
+                TransformBox(part.center, part.extents, MultiplyRowMajor(part.nodeTransform, worlds[queries[q].instance]), center, edges);
+                if (ExactOverlap(center, edges, queries[q].center, extents)) exact = true;
+            }
+            if (exact && !soaResults[q]) result.missedOverlaps++;
+        }
+        return result;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick = false;
+    if (!ParseQuickOption(argc, argv, quick)) return 2;
+
+    for (size_t instanceCount : Sizes(quick, { size_t(100), size_t(1000), size_t(10000) }))
+    {
+        WorldPartBoundsBenchmarkResult result = Benchmark(instanceCount, quick ? 20000 : 200000);
+        std::printf("World part bounds %zu instances (%zu parts, %.1f ms): transform %.1f ns, SoA %.1f ns per query, hits %zu/%zu, missed overlaps %zu\n",
+            result.instanceCount, result.partCount, result.buildMs, result.transformNsPerQuery, result.soaNsPerQuery,
+            result.transformHits, result.soaHits, result.missedOverlaps);
+        Check(result.missedOverlaps == 0, "SoA bounds reject an overlapping part");
+    }
+
+    return FinishChecks();
+}
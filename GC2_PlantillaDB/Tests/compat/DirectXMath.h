@@ -0,0 +1,79 @@
+#pragma once
+
+// Subconjunto de DirectXMath para compilar los modulos sin dispositivo fuera de Windows (CMake lo
+// anade a la ruta de includes solo si no encuentra el DirectXMath.h real). Tipos de almacenamiento,
+// constantes y las pocas funciones vectoriales que usa TerrainMeshBuilder, en escalar.
+
+#include <cmath>
+
+namespace DirectX
+{
+    constexpr float XM_PI = 3.141592654f;
+    constexpr float XM_2PI = 6.283185307f;
+    constexpr float XM_PIDIV2 = 1.570796327f;
+    constexpr float XM_PIDIV4 = 0.785398163f;
+
+    struct XMFLOAT2
+    {
+        float x, y;
+        XMFLOAT2() = default;
+        constexpr XMFLOAT2(float _x, float _y) : x(_x), y(_y) {}
+    };
+
+    struct XMFLOAT3
+    {
+        float x, y, z;
+        XMFLOAT3() = default;
+        constexpr XMFLOAT3(float _x, float _y, float _z) : x(_x), y(_y), z(_z) {}
+    };
+
+    struct XMFLOAT4
+    {
+        float x, y, z, w;
+        XMFLOAT4() = default;
+        constexpr XMFLOAT4(float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w) {}
+    };
+
+    struct XMFLOAT4X4
+    {
+        union
+        {
+            struct
+            {
+                float _11, _12, _13, _14;
+                float _21, _22, _23, _24;
+                float _31, _32, _33, _34;
+                float _41, _42, _43, _44;
+            };
+            float m[4][4];
+        };
+
+        XMFLOAT4X4() = default;
+        constexpr XMFLOAT4X4(float m00, float m01, float m02, float m03, float m10, float m11, float m12, float m13,
+            float m20, float m21, float m22, float m23, float m30, float m31, float m32, float m33) :
+            _11(m00), _12(m01), _13(m02), _14(m03), _21(m10), _22(m11), _23(m12), _24(m13),
+            _31(m20), _32(m21), _33(m22), _34(m23), _41(m30), _42(m31), _43(m32), _44(m33) {}
+    };
+
+    struct XMVECTOR { float x, y, z, w; };
+
+    inline XMVECTOR XMLoadFloat3(const XMFLOAT3* source) { return { source->x, source->y, source->z, 0.0f }; }
+    inline void XMStoreFloat3(XMFLOAT3* destination, XMVECTOR v) { destination->x = v.x; destination->y = v.y; destination->z = v.z; }
+    inline XMVECTOR XMVectorAdd(XMVECTOR a, XMVECTOR b) { return { a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w }; }
+    inline XMVECTOR XMVectorSubtract(XMVECTOR a, XMVECTOR b) { return { a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w }; }
+    inline XMVECTOR XMVector3Cross(XMVECTOR a, XMVECTOR b)
+    {
+        return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x, 0.0f };
+    }
+    inline XMVECTOR XMVector3Normalize(XMVECTOR v)
+    {
+        float length = std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+        if (length > 0.0f)
+        {
+            v.x /= length;
+            v.y /= length;
+            v.z /= length;
+        }
+        return v;
+    }
+}
@@ -0,0 +1,101 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned int workerCount) :
+    m_task(nullptr),
+    m_taskCount(0),
+    m_nextIndex(0),
+    m_activeWorkers(0),
+    m_generation(0),
+    m_stop(false)
+{
+    if (workerCount == 0)
+    {
+        unsigned int cores = std::thread::hardware_concurrency();
+        workerCount = (cores > 1) ? cores - 1 : 0;
+    }
+
+    m_workers.reserve(workerCount);
+    for (unsigned int i = 0; i < workerCount; ++i)
+    {
+        m_workers.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wakeCondition.notify_all();
+
+    for (auto& worker : m_workers)
+    {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+void ThreadPool::RunTasks()
+{
+    const std::function<void(int)>& task = *m_task;
+    for (;;)
+    {
+        int index = m_nextIndex.fetch_add(1, std::memory_order_relaxed);
+        if (index >= m_taskCount) break;
+        task(index);
+    }
+}
+
+void ThreadPool::ParallelFor(int count, const std::function<void(int)>& task)
+{
+    if (count <= 0) return;
+
+    // Sin hilos auxiliares o con un solo indice no vale la pena despertar a nadie
+    if (m_workers.empty() || count == 1)
+    {
+        for (int i = 0; i < count; ++i) task(i);
+        return;
+    }
+
+    std::lock_guard<std::mutex> submitLock(m_submitMutex);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_task = &task;
+        m_taskCount = count;
+        m_nextIndex.store(0, std::memory_order_relaxed);
+        m_activeWorkers = static_cast<unsigned int>(m_workers.size());
+        ++m_generation;
+    }
+    m_wakeCondition.notify_all();
+
+    RunTasks();
+
+    // Esperar a que todos los hilos auxiliares hayan salido de esta generacion
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_doneCondition.wait(lock, [this] { return m_activeWorkers == 0; });
+    m_task = nullptr;
+}
+
+void ThreadPool::WorkerLoop()
+{
+    uint64_t lastGeneration = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wakeCondition.wait(lock, [&] { return m_stop || m_generation != lastGeneration; });
+            if (m_stop) return;
+            lastGeneration = m_generation;
+        }
+
+        RunTasks();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_activeWorkers == 0)
+            {
+                m_doneCondition.notify_one();
+            }
+        }
+    }
+}
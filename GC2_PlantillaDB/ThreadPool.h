@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Pool de hilos persistente para repartir trabajo por indices (parallel-for).
+// Los hilos se crean una sola vez; cada ParallelFor reparte los indices con un
+// contador atomico y el hilo que llama tambien trabaja hasta que no quedan indices.
+// No se debe llamar a ParallelFor desde dentro de una tarea del mismo pool.
+class ThreadPool
+{
+public:
+    // workerCount = 0 usa (nucleos - 1) hilos auxiliares.
+    explicit ThreadPool(unsigned int workerCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Ejecuta task(i) para i en [0, count). Bloquea hasta que terminan todos.
+    void ParallelFor(int count, const std::function<void(int)>& task);
+
+    // Hilos auxiliares + el hilo que llama.
+    unsigned int GetThreadCount() const { return static_cast<unsigned int>(m_workers.size()) + 1; }
+
+private:
+    void WorkerLoop();
+    void RunTasks();
+
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_submitMutex; // Serializa llamadas concurrentes a ParallelFor
+    std::mutex m_mutex;
+    std::condition_variable m_wakeCondition;
+    std::condition_variable m_doneCondition;
+
+    const std::function<void(int)>* m_task;
+    int m_taskCount;
+    std::atomic<int> m_nextIndex;
+    unsigned int m_activeWorkers;
+    uint64_t m_generation;
+    bool m_stop;
+};
@@ -0,0 +1,180 @@
+#include "WorldPartBounds.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <xmmintrin.h>
+#define PART_BOUNDS_USE_SSE2 1
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+    struct Vec3
+    {
+        float x, y, z;
+    };
+
+    Vec3 operator+(const Vec3& a, const Vec3& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+    Vec3 operator*(const Vec3& a, float s) { return { a.x * s, a.y * s, a.z * s }; }
+    float Dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    Vec3 Cross(const Vec3& a, const Vec3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+    Vec3 Abs(const Vec3& v) { return { std::fabs(v.x), std::fabs(v.y), std::fabs(v.z) }; }
+
+    // Producto fila * matriz como en SimpleMath (vectores fila, v * M).
+    XMFLOAT4X4 MultiplyRowMajor(const XMFLOAT4X4& a, const XMFLOAT4X4& b)
+    {
+        XMFLOAT4X4 r;
+        for (int i = 0; i < 4; ++i)
+        {
+            for (int j = 0; j < 4; ++j)
+            {
+                r.m[i][j] = a.m[i][0] * b.m[0][j] + a.m[i][1] * b.m[1][j] +
+                    a.m[i][2] * b.m[2][j] + a.m[i][3] * b.m[3][j];
+            }
+        }
+        return r;
+    }
+
+    Vec3 TransformPoint(const Vec3& v, const XMFLOAT4X4& m)
+    {
+        return { v.x * m._11 + v.y * m._21 + v.z * m._31 + m._41,
+                 v.x * m._12 + v.y * m._22 + v.z * m._32 + m._42,
+                 v.x * m._13 + v.y * m._23 + v.z * m._33 + m._43 };
+    }
+
+    // Caja transformada: centro y semiaristas (filas de la matriz por el semieje)
+    void TransformBox(const XMFLOAT3& center, const XMFLOAT3& extents, const XMFLOAT4X4& m, Vec3& outCenter, Vec3 outEdges[3])
+    {
+        outCenter = TransformPoint({ center.x, center.y, center.z }, m);
+        outEdges[0] = Vec3{ m._11, m._12, m._13 } * extents.x;
+        outEdges[1] = Vec3{ m._21, m._22, m._23 } * extents.y;
+        outEdges[2] = Vec3{ m._31, m._32, m._33 } * extents.z;
+    }
+}
+
+void WorldPartBounds::Clear()
+{
+    m_ranges.clear();
+    Resize(0);
+}
+
+void WorldPartBounds::Resize(size_t size)
+{
+    // El relleno no corta nada: AABB vacia (min > max) y ejes nulos
+    const float inf = std::numeric_limits<float>::infinity();
+    for (std::vector<float>* component : { &m_minX, &m_minY, &m_minZ }) component->resize(size, inf);
+    for (std::vector<float>* component : { &m_maxX, &m_maxY, &m_maxZ }) component->resize(size, -inf);
+    for (std::vector<float>* component : { &m_centerX, &m_centerY, &m_centerZ }) component->resize(size, 0.0f);
+    for (int k = 0; k < 3; ++k)
+    {
+        m_normalX[k].resize(size, 0.0f);
+        m_normalY[k].resize(size, 0.0f);
+        m_normalZ[k].resize(size, 0.0f);
+        m_halfWidth[k].resize(size, 0.0f);
+    }
+}
+
+uint32_t WorldPartBounds::AddInstance(const PartBox* parts, size_t partCount, const XMFLOAT4X4& world)
+{
+    Range range;
+    range.first = static_cast<uint32_t>(m_minX.size());
+    range.count = static_cast<uint32_t>(partCount);
+    Resize(range.first + ((partCount + 3) & ~size_t(3)));
+
+    for (size_t p = 0; p < partCount; ++p)
+    {
+        Vec3 center, edges[3];
+        TransformBox(parts[p].center, parts[p].extents, MultiplyRowMajor(parts[p].nodeTransform, world), center, edges);
+        const size_t i = range.first + p;
+
+        Vec3 reach = Abs(edges[0]) + Abs(edges[1]) + Abs(edges[2]);
+        m_minX[i] = center.x - reach.x; m_maxX[i] = center.x + reach.x;
+        m_minY[i] = center.y - reach.y; m_maxY[i] = center.y + reach.y;
+        m_minZ[i] = center.z - reach.z; m_maxZ[i] = center.z + reach.z;
+        m_centerX[i] = center.x; m_centerY[i] = center.y; m_centerZ[i] = center.z;
+        for (int k = 0; k < 3; ++k)
+        {
+            // Las otras dos aristas son perpendiculares a esta normal: solo la arista k aporta al semiancho
+            Vec3 normal = Cross(edges[(k + 1) % 3], edges[(k + 2) % 3]);
+            m_normalX[k][i] = normal.x; m_normalY[k][i] = normal.y; m_normalZ[k][i] = normal.z;
+            m_halfWidth[k][i] = std::fabs(Dot(edges[k], normal));
+        }
+    }
+
+    m_ranges.push_back(range);
+    return static_cast<uint32_t>(m_ranges.size() - 1);
+}
+
+void WorldPartBounds::GetPartBox(uint32_t slot, size_t part, XMFLOAT3& outCenter, XMFLOAT3& outExtents) const
+{
+    const size_t i = m_ranges[slot].first + part;
+    outCenter = XMFLOAT3(0.5f * (m_minX[i] + m_maxX[i]), 0.5f * (m_minY[i] + m_maxY[i]), 0.5f * (m_minZ[i] + m_maxZ[i]));
+    outExtents = XMFLOAT3(0.5f * (m_maxX[i] - m_minX[i]), 0.5f * (m_maxY[i] - m_minY[i]), 0.5f * (m_maxZ[i] - m_minZ[i]));
+}
+
+bool WorldPartBounds::Overlaps(uint32_t slot, const XMFLOAT3& boxCenter, const XMFLOAT3& boxExtents) const
+{
+    const Range& range = m_ranges[slot];
+    const size_t end = range.first + ((range.count + 3) & ~uint32_t(3));
+
+#ifdef PART_BOUNDS_USE_SSE2
+    const __m128 queryMinX = _mm_set1_ps(boxCenter.x - boxExtents.x), queryMaxX = _mm_set1_ps(boxCenter.x + boxExtents.x);
+    const __m128 queryMinY = _mm_set1_ps(boxCenter.y - boxExtents.y), queryMaxY = _mm_set1_ps(boxCenter.y + boxExtents.y);
+    const __m128 queryMinZ = _mm_set1_ps(boxCenter.z - boxExtents.z), queryMaxZ = _mm_set1_ps(boxCenter.z + boxExtents.z);
+    const __m128 queryX = _mm_set1_ps(boxCenter.x), queryY = _mm_set1_ps(boxCenter.y), queryZ = _mm_set1_ps(boxCenter.z);
+    const __m128 extentX = _mm_set1_ps(boxExtents.x), extentY = _mm_set1_ps(boxExtents.y), extentZ = _mm_set1_ps(boxExtents.z);
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+
+    for (size_t i = range.first; i < end; i += 4)
+    {
+        // 1. AABB de mundo (el relleno falla aqui)
+        __m128 overlap = _mm_and_ps(
+            _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(&m_minX[i]), queryMaxX), _mm_cmpge_ps(_mm_loadu_ps(&m_maxX[i]), queryMinX)),
+            _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(&m_minY[i]), queryMaxY), _mm_cmpge_ps(_mm_loadu_ps(&m_maxY[i]), queryMinY)));
+        overlap = _mm_and_ps(overlap,
+            _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(&m_minZ[i]), queryMaxZ), _mm_cmpge_ps(_mm_loadu_ps(&m_maxZ[i]), queryMinZ)));
+        if (_mm_movemask_ps(overlap) == 0) continue;
+
+        // 2. Caras del paralelepipedo: |d . n| <= semiancho + proyeccion de la caja de la consulta
+        const __m128 dx = _mm_sub_ps(_mm_loadu_ps(&m_centerX[i]), queryX);
+        const __m128 dy = _mm_sub_ps(_mm_loadu_ps(&m_centerY[i]), queryY);
+        const __m128 dz = _mm_sub_ps(_mm_loadu_ps(&m_centerZ[i]), queryZ);
+        for (int k = 0; k < 3; ++k)
+        {
+            const __m128 nx = _mm_loadu_ps(&m_normalX[k][i]), ny = _mm_loadu_ps(&m_normalY[k][i]), nz = _mm_loadu_ps(&m_normalZ[k][i]);
+            __m128 distance = _mm_andnot_ps(signMask, _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, nx), _mm_mul_ps(dy, ny)), _mm_mul_ps(dz, nz)));
+            __m128 radius = _mm_add_ps(_mm_loadu_ps(&m_halfWidth[k][i]), _mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(extentX, _mm_andnot_ps(signMask, nx)),
+                _mm_mul_ps(extentY, _mm_andnot_ps(signMask, ny))),
+                _mm_mul_ps(extentZ, _mm_andnot_ps(signMask, nz))));
+            overlap = _mm_and_ps(overlap, _mm_cmple_ps(distance, radius));
+        }
+        if (_mm_movemask_ps(overlap) != 0) return true;
+    }
+    return false;
+#else
+    for (size_t i = range.first; i < end; ++i)
+    {
+        if (m_minX[i] > boxCenter.x + boxExtents.x || m_maxX[i] < boxCenter.x - boxExtents.x ||
+            m_minY[i] > boxCenter.y + boxExtents.y || m_maxY[i] < boxCenter.y - boxExtents.y ||
+            m_minZ[i] > boxCenter.z + boxExtents.z || m_maxZ[i] < boxCenter.z - boxExtents.z)
+        {
+            continue;
+        }
+
+        const Vec3 d = { m_centerX[i] - boxCenter.x, m_centerY[i] - boxCenter.y, m_centerZ[i] - boxCenter.z };
+        bool separated = false;
+        for (int k = 0; k < 3 && !separated; ++k)
+        {
+            const Vec3 normal = { m_normalX[k][i], m_normalY[k][i], m_normalZ[k][i] };
+            separated = std::fabs(Dot(d, normal)) > m_halfWidth[k][i] + Dot({ boxExtents.x, boxExtents.y, boxExtents.z }, Abs(normal));
+        }
+        if (!separated) return true;
+    }
+    return false;
+#endif
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Caja de una parte de un modelo: AABB en el espacio de su nodo y la transformacion del nodo al modelo.
+struct PartBox
+{
+    DirectX::XMFLOAT3 center;
+    DirectX::XMFLOAT3 extents;
+    DirectX::XMFLOAT4X4 nodeTransform;
+};
+
+// Cajas de las partes de las instancias estaticas ya en el mundo, calculadas una vez al colocarlas.
+// Se guardan en arrays separados por componente (SoA) y el rango de cada instancia empieza en un
+// multiplo de 4 y se rellena con cajas vacias, asi que una consulta prueba 4 partes por instruccion.
+// De cada parte se guardan la AABB de mundo y las tres caras del paralelepipedo en que se convierte
+// la caja al transformarla (normal sin normalizar y semiancho sobre ella): la prueba usa esos 6 ejes,
+// mas ajustada que la AABB pero conservadora (sin los 9 ejes de aristas); la malla de colision decide.
+class WorldPartBounds
+{
+public:
+    void Clear();
+
+    // Guarda las partes de una instancia con su matriz de mundo; devuelve el slot de la instancia.
+    uint32_t AddInstance(const PartBox* parts, size_t partCount, const DirectX::XMFLOAT4X4& world);
+
+    // Alguna parte del slot corta la AABB de mundo (centro, semiejes).
+    bool Overlaps(uint32_t slot, const DirectX::XMFLOAT3& boxCenter, const DirectX::XMFLOAT3& boxExtents) const;
+
+    size_t GetInstanceCount() const { return m_ranges.size(); }
+    size_t GetPartCount(uint32_t slot) const { return m_ranges[slot].count; }
+    // AABB de mundo de una parte (para el dibujado de depuracion).
+    void GetPartBox(uint32_t slot, size_t part, DirectX::XMFLOAT3& outCenter, DirectX::XMFLOAT3& outExtents) const;
+
+private:
+    struct Range
+    {
+        uint32_t first = 0;
+        uint32_t count = 0;
+    };
+
+    void Resize(size_t size);
+
+    std::vector<Range> m_ranges;
+    std::vector<float> m_minX, m_minY, m_minZ, m_maxX, m_maxY, m_maxZ;
+    std::vector<float> m_centerX, m_centerY, m_centerZ;
+    std::vector<float> m_normalX[3], m_normalY[3], m_normalZ[3]; // Cara k: producto de las otras dos aristas
+    std::vector<float> m_halfWidth[3];                          // Semiancho del paralelepipedo sobre la cara k
+};